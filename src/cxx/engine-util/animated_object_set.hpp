@@ -0,0 +1,50 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	/// \brief The objects of an `ObjectStorage` that are being animated,
+	///        reference counted by the animations that hold them.
+	///
+	/// The storage needs to rebuild its draw batches only when the set
+	/// changes, which `acquire` and `release` report; in between, the
+	/// animated objects only need their instances to be rewritten.
+	///
+	template <typename Id>
+	class AnimatedObjectSet {
+	public:
+		/// \returns Whether the object was not animated yet.
+		///
+		bool acquire(Id id) { return 0 == (aos_refCounts[id] ++); }
+
+		/// \returns Whether the object is no longer animated.
+		///
+		bool release(Id id) noexcept {
+			auto found = aos_refCounts.find(id);
+			if(found == aos_refCounts.end()) return false;
+			assert(found->second > 0);
+			if(-- found->second > 0) return false;
+			aos_refCounts.erase(found);
+			return true;
+		}
+
+		/// \brief Forgets the object, no matter how many animations hold it.
+		///
+		bool erase(Id id) noexcept { return aos_refCounts.erase(id) > 0; }
+
+		bool contains(Id id) const noexcept { return aos_refCounts.contains(id); }
+		bool empty() const noexcept { return aos_refCounts.empty(); }
+		auto size() const noexcept { return aos_refCounts.size(); }
+
+	private:
+		std::unordered_map<Id, uint_fast32_t> aos_refCounts;
+	};
+
+}
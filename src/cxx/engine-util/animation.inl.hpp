@@ -2,6 +2,7 @@
 
 #include <skengine_fwd.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <set>
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "animation.inl.hpp"
+
+#include <skengine_fwd.hpp>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <idgen.hpp>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	/// \brief The easing of an animation: a cubic Bézier curve from (0, 0) to (1, 1),
+	///        whose inner control points are evenly spaced in time and have the
+	///        heights `p1` and `p2`.
+	///
+	/// Every preset is such a curve, so that a track evaluates all of its
+	/// animations with the same code, whatever their easing.
+	///
+	struct AnimCurve {
+		float p1;
+		float p2;
+
+		static constexpr AnimCurve linear () noexcept { return { 1.0f / 3.0f, 2.0f / 3.0f }; }
+		static constexpr AnimCurve ease   () noexcept { return { 0.0f,        1.0f        }; } // 3x² - 2x³
+		static constexpr AnimCurve easeIn () noexcept { return { 0.0f,        1.0f / 3.0f }; } // x²
+		static constexpr AnimCurve easeOut() noexcept { return { 2.0f / 3.0f, 1.0f        }; } // 2x - x²
+		static constexpr AnimCurve cubic(float p1, float p2) noexcept { return { p1, p2 }; }
+
+		constexpr float operator()(float x) const noexcept {
+			float u = 1.0f - x;
+			return (3.0f * u * x * ((u * p1) + (x * p2))) + (x * x * x);
+		}
+	};
+
+
+	/// \brief How a type is split into the float components of an animation track.
+	///
+	/// Quaternions are blended component-wise and normalized (nlerp), which is
+	/// accurate enough for the short arcs animations usually cover.
+	///
+	template <typename T> struct AnimTrackTraits;
+
+	template <> struct AnimTrackTraits<float> {
+		static constexpr unsigned components = 1;
+		static constexpr bool     normalize  = false;
+		static void  split(const float& v, float* dst) noexcept { dst[0] = v; }
+		static float join(const float* c) noexcept { return c[0]; }
+	};
+
+	template <> struct AnimTrackTraits<glm::vec3> {
+		static constexpr unsigned components = 3;
+		static constexpr bool     normalize  = false;
+		static void      split(const glm::vec3& v, float* dst) noexcept { dst[0] = v.x; dst[1] = v.y; dst[2] = v.z; }
+		static glm::vec3 join(const float* c) noexcept { return glm::vec3(c[0], c[1], c[2]); }
+	};
+
+	template <> struct AnimTrackTraits<glm::vec4> {
+		static constexpr unsigned components = 4;
+		static constexpr bool     normalize  = false;
+		static void      split(const glm::vec4& v, float* dst) noexcept { dst[0] = v.x; dst[1] = v.y; dst[2] = v.z; dst[3] = v.w; }
+		static glm::vec4 join(const float* c) noexcept { return glm::vec4(c[0], c[1], c[2], c[3]); }
+	};
+
+	template <> struct AnimTrackTraits<glm::quat> {
+		static constexpr unsigned components = 4;
+		static constexpr bool     normalize  = true;
+		static void      split(const glm::quat& v, float* dst) noexcept { dst[0] = v.x; dst[1] = v.y; dst[2] = v.z; dst[3] = v.w; }
+		static glm::quat join(const float* c) noexcept { return glm::quat(c[3], c[0], c[1], c[2]); }
+	};
+
+
+	template <typename T>
+	concept AnimTrackValue = requires (const T& v, float* c) {
+		{ AnimTrackTraits<T>::components } -> std::convertible_to<unsigned>;
+		AnimTrackTraits<T>::split(v, c);
+		{ AnimTrackTraits<T>::join(c) } -> std::convertible_to<T>;
+	};
+
+
+	namespace anim_impl {
+
+		/// \brief Animations are evaluated in blocks of this many lanes, with loops
+		///        which the compiler is free to turn into vector code.
+		///
+		constexpr size_t laneCount = 8;
+
+
+		/// \brief The per-animation state of a track, one array per field.
+		///
+		/// The arrays are as long as the capacity, which is a multiple of
+		/// `laneCount`; lanes past the animation count have a rate of 0,
+		/// so evaluating them is harmless.
+		///
+		template <unsigned components>
+		struct TrackLanes {
+			std::vector<float> x;    // Progress, from 0 to 1
+			std::vector<float> rate; // Progress per unit of time, 0 while paused
+			std::vector<float> p1;
+			std::vector<float> p2;
+			std::vector<float> curve; // Scratch space for the eased progress of every lane
+			std::array<std::vector<float>, components> from;
+			std::array<std::vector<float>, components> delta;
+			std::array<std::vector<float>, components> value;
+
+			size_t capacity() const noexcept { return x.size(); }
+
+			void resize(size_t n) {
+				assert(n % laneCount == 0);
+				x.resize(n, 0.0f); rate.resize(n, 0.0f); p1.resize(n, 0.0f); p2.resize(n, 0.0f); curve.resize(n, 0.0f);
+				for(auto& c : from)  c.resize(n, 0.0f);
+				for(auto& c : delta) c.resize(n, 0.0f);
+				for(auto& c : value) c.resize(n, 0.0f);
+			}
+
+			void move(size_t dst, size_t src) noexcept {
+				x[dst] = x[src]; rate[dst] = rate[src]; p1[dst] = p1[src]; p2[dst] = p2[src];
+				for(unsigned c = 0; c < components; ++c) {
+					from [c][dst] = from [c][src];
+					delta[c][dst] = delta[c][src];
+					value[c][dst] = value[c][src]; }
+			}
+
+			void clear(size_t i) noexcept {
+				x[i] = 0.0f; rate[i] = 0.0f; p1[i] = 0.0f; p2[i] = 0.0f;
+				for(unsigned c = 0; c < components; ++c) {
+					from[c][i] = 0.0f; delta[c][i] = 0.0f; value[c][i] = 0.0f; }
+			}
+
+			/// \brief Advances every animation of the first `count` lanes, clamping
+			///        the progress between 0 and 1, and computes their values.
+			/// \returns The number of animations that reached the end of their curve.
+			///
+			/// The progress is compared by its bit pattern, which orders non-negative
+			/// floats as they are and maps negative ones below 0: unlike float
+			/// comparisons, which may trap, integer ones can be vectorized without
+			/// `-fno-trapping-math`.
+			///
+			template <bool normalize>
+			uint32_t evaluate(float dt, size_t count) noexcept {
+				constexpr int32_t one = std::bit_cast<int32_t>(1.0f);
+				size_t n = count + ((laneCount - (count % laneCount)) % laneCount);
+				uint32_t finished = 0;
+				{
+					float*       __restrict xs  = x.data();
+					float*       __restrict es  = curve.data();
+					const float* __restrict rs  = rate.data();
+					const float* __restrict p1s = p1.data();
+					const float* __restrict p2s = p2.data();
+					for(size_t i = 0; i < n; ++i) {
+						float   xr = xs[i] + (rs[i] * dt);
+						int32_t xb = std::bit_cast<int32_t>(xr);
+						finished += uint32_t(std::bit_cast<int32_t>(rs[i]) > 0) & uint32_t(xb >= one);
+						float xc = std::bit_cast<float>(std::clamp(xb, 0, one));
+						float u  = 1.0f - xc;
+						xs[i] = xr;
+						es[i] = (3.0f * u * xc * ((u * p1s[i]) + (xc * p2s[i]))) + (xc * xc * xc);
+					}
+				}
+				for(unsigned c = 0; c < components; ++c) {
+					const float* __restrict f  = from [c].data();
+					const float* __restrict d  = delta[c].data();
+					const float* __restrict es = curve.data();
+					float*       __restrict v  = value[c].data();
+					for(size_t i = 0; i < n; ++i) v[i] = f[i] + (d[i] * es[i]);
+				}
+				if constexpr (normalize) {
+					float* __restrict len2 = curve.data(); // No longer needed
+					for(size_t i = 0; i < n; ++i) len2[i] = 0.0f;
+					for(unsigned c = 0; c < components; ++c) {
+						const float* __restrict v = value[c].data();
+						for(size_t i = 0; i < n; ++i) len2[i] += v[i] * v[i];
+					}
+					for(unsigned c = 0; c < components; ++c) {
+						float* __restrict v = value[c].data();
+						for(size_t i = 0; i < n; ++i) v[i] /= std::sqrt(len2[i] + std::numeric_limits<float>::min()); // Zero stays zero
+					}
+				}
+				return finished;
+			}
+		};
+
+	}
+
+
+	/// \brief A set of animations of values of the same type, stored
+	///        and evaluated as arrays rather than as objects.
+	///
+	/// Unlike AnimationSet, a track owns the animated values instead of sharing
+	/// them through AnimationValue: each animation may instead write its value
+	/// to a target pointer, which must outlive the animation (or be unset by
+	/// stopping it), and the latest value of any active or paused animation
+	/// can be read with `getValue`.
+	///
+	/// An animation that lasts `duration` units of progress is advanced by
+	/// `fwd(xDelta)` by `xDelta / duration`, so that a duration of 1 behaves
+	/// as AnimationSet does.
+	/// Values never overshoot the end of their curve, so the clamping end
+	/// actions only differ from the others when an animation is stopped.
+	///
+	template <AnimTrackValue T>
+	class AnimTrack {
+	public:
+		using ValueType = T;
+		using Traits    = AnimTrackTraits<T>;
+		static constexpr unsigned components = Traits::components;
+
+		AnimId start(
+			AnimEndAction endAction,
+			const T& from, const T& to,
+			anim_x_t  duration = anim_x_t(1),
+			AnimCurve curve    = AnimCurve::linear(),
+			T*        target   = nullptr
+		) {
+			assert(duration > anim_x_t(0));
+			auto id = track_idGenerator.generate();
+			size_t i = track_count;
+			try {
+				if(i == track_lanes.capacity()) reserve(track_count + 1);
+				auto slotIdx = anim_id_e(id);
+				if(slotIdx >= track_slotOf.size()) track_slotOf.resize(slotIdx + 1, noSlot);
+				track_ids.push_back(id);
+				track_targets.push_back(target);
+				track_endActions.push_back(endAction);
+				track_rates.push_back(anim_x_t(1) / duration);
+			} catch(...) {
+				track_ids.resize(i); track_targets.resize(i); track_endActions.resize(i); track_rates.resize(i);
+				track_idGenerator.recycle(id);
+				std::rethrow_exception(std::current_exception());
+			}
+			track_slotOf[anim_id_e(id)] = uint32_t(i);
+
+			float f[components];
+			float t[components];
+			Traits::split(from, f);
+			Traits::split(to,   t);
+			if constexpr (Traits::normalize) { // Take the shortest arc
+				float dot = 0.0f;
+				for(unsigned c = 0; c < components; ++c) dot += f[c] * t[c];
+				if(dot < 0.0f) for(unsigned c = 0; c < components; ++c) t[c] = -t[c];
+			}
+			auto& lanes = track_lanes;
+			lanes.x   [i] = 0.0f;
+			lanes.rate[i] = track_rates[i];
+			lanes.p1  [i] = curve.p1;
+			lanes.p2  [i] = curve.p2;
+			for(unsigned c = 0; c < components; ++c) {
+				lanes.from [c][i] = f[c];
+				lanes.delta[c][i] = t[c] - f[c];
+				lanes.value[c][i] = f[c];
+			}
+			++ track_count;
+			return id;
+		}
+
+		/// \brief Removes an animation, first setting its final value if its
+		///        end action is a clamping one.
+		///
+		void stop(AnimId id) {
+			using enum AnimEndAction;
+			auto i = slotOf(id);
+			if(i == noSlot) return;
+			auto action = track_endActions[i];
+			if((action == eClampThenTerminate || action == eClampThenPause) && track_targets[i] != nullptr) {
+				*track_targets[i] = valueAt(i, anim_x_t(1));
+			}
+			removeSlot(i);
+		}
+
+		/// \brief Removes an animation, leaving its target as it is.
+		///
+		void interrupt(AnimId id) {
+			auto i = slotOf(id);
+			if(i != noSlot) [[likely]] removeSlot(i);
+		}
+
+		void pause(AnimId id) {
+			auto i = slotOf(id);
+			if(i != noSlot) track_lanes.rate[i] = 0.0f;
+		}
+
+		void resume(AnimId id) {
+			auto i = slotOf(id);
+			if(i != noSlot && track_lanes.x[i] < 1.0f) track_lanes.rate[i] = track_rates[i];
+		}
+
+		/// \brief Advances every active animation, writes their values to their
+		///        targets, then applies the end actions of the ones that ended.
+		///
+		void fwd(anim_x_t xDelta) {
+			using enum AnimEndAction;
+			auto& lanes = track_lanes;
+			size_t finished = lanes.template evaluate<Traits::normalize>(xDelta, track_count);
+
+			for(size_t i = 0; i < track_count; ++i) {
+				auto* target = track_targets[i];
+				if(target != nullptr && lanes.rate[i] > 0.0f) *target = getValueAt(i);
+			}
+
+			if(finished == 0) [[likely]] return;
+			for(size_t i = track_count; i > 0; -- i) { // Backwards, so that removals only move visited slots
+				size_t slot = i - 1;
+				if(! (lanes.rate[slot] > 0.0f && lanes.x[slot] >= 1.0f)) continue;
+				switch(track_endActions[slot]) {
+					default: [[fallthrough]];
+					case eTerminate: [[fallthrough]];
+					case eClampThenTerminate:
+						removeSlot(slot);
+						break;
+					case ePause: [[fallthrough]];
+					case eClampThenPause:
+						lanes.x   [slot] = 1.0f;
+						lanes.rate[slot] = 0.0f;
+						break;
+					case eRepeat:
+						lanes.x[slot] -= std::floor(lanes.x[slot]);
+						break;
+				}
+			}
+		}
+
+		AnimState getAnimationState(AnimId id) const noexcept {
+			using enum AnimState;
+			auto i = slotOf(id);
+			if(i == noSlot) return eNotSet;
+			return track_lanes.rate[i] > 0.0f? eActive : ePaused;
+		}
+
+		/// \brief The value of an active or paused animation, as of the last
+		///        call to `fwd` (or `from`, if there was none).
+		///
+		T getValue(AnimId id) const noexcept {
+			auto i = slotOf(id);
+			assert(i != noSlot);
+			return getValueAt(i);
+		}
+
+		size_t size() const noexcept { return track_count; }
+
+		void reserve(size_t capacity) {
+			constexpr auto lc = anim_impl::laneCount;
+			capacity = (capacity + lc - 1) / lc * lc;
+			if(capacity <= track_lanes.capacity()) return;
+			capacity = std::max(capacity, track_lanes.capacity() * 2);
+			track_lanes.resize(capacity);
+			track_ids.reserve(capacity); track_targets.reserve(capacity); track_endActions.reserve(capacity); track_rates.reserve(capacity);
+		}
+
+	private:
+		static constexpr uint32_t noSlot = UINT32_MAX;
+
+		anim_impl::TrackLanes<components> track_lanes;
+		std::vector<AnimId>        track_ids;
+		std::vector<T*>            track_targets;
+		std::vector<AnimEndAction> track_endActions;
+		std::vector<anim_x_t>      track_rates; // The rates of paused animations, for when they resume
+		std::vector<uint32_t>      track_slotOf; // Indexed by animation ID
+		size_t track_count = 0;
+		idgen::IdGenerator<AnimId> track_idGenerator;
+
+		uint32_t slotOf(AnimId id) const noexcept {
+			auto idx = anim_id_e(id);
+			return idx < track_slotOf.size()? track_slotOf[idx] : noSlot;
+		}
+
+		T getValueAt(size_t i) const noexcept {
+			float c[components];
+			for(unsigned j = 0; j < components; ++j) c[j] = track_lanes.value[j][i];
+			return Traits::join(c);
+		}
+
+		T valueAt(size_t i, anim_x_t x) const noexcept {
+			auto& lanes = track_lanes;
+			float e = AnimCurve { lanes.p1[i], lanes.p2[i] } (x);
+			float c[components];
+			float len2 = 0.0f;
+			for(unsigned j = 0; j < components; ++j) {
+				c[j] = lanes.from[j][i] + (lanes.delta[j][i] * e);
+				len2 += c[j] * c[j];
+			}
+			if constexpr (Traits::normalize) if(len2 > 0.0f) {
+				float inv = 1.0f / std::sqrt(len2);
+				for(unsigned j = 0; j < components; ++j) c[j] *= inv;
+			}
+			return Traits::join(c);
+		}
+
+		void removeSlot(size_t i) noexcept {
+			size_t last = track_count - 1;
+			auto id = track_ids[i];
+			if(i != last) {
+				track_lanes.move(i, last);
+				track_ids       [i] = track_ids       [last];
+				track_targets   [i] = track_targets   [last];
+				track_endActions[i] = track_endActions[last];
+				track_rates     [i] = track_rates     [last];
+				track_slotOf[anim_id_e(track_ids[i])] = uint32_t(i);
+			}
+			track_lanes.clear(last);
+			track_ids.pop_back(); track_targets.pop_back(); track_endActions.pop_back(); track_rates.pop_back();
+			track_slotOf[anim_id_e(id)] = noSlot;
+			track_idGenerator.recycle(id);
+			track_count = last;
+		}
+	};
+
+
+	/// \brief One animation track for each of the commonly animated types.
+	///
+	struct AnimationTracks {
+		AnimTrack<float>     floats;
+		AnimTrack<glm::vec3> vec3s;
+		AnimTrack<glm::quat> quats;
+		AnimTrack<glm::vec4> colors;
+
+		void fwd(anim_x_t xDelta) {
+			floats.fwd(xDelta);
+			vec3s .fwd(xDelta);
+			quats .fwd(xDelta);
+			colors.fwd(xDelta);
+		}
+	};
+
+}
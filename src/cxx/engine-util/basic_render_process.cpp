@@ -76,6 +76,7 @@ namespace SKENGINE_NAME_NS {
 				copyLogger(e.logger(), "ObjStorage"),
 				brp_worldRendererSs,
 				e.getVmaAllocator(),
+				e.getCleanupQueue(),
 				brp_assetSupplier );
 		}
 
@@ -116,7 +117,7 @@ namespace SKENGINE_NAME_NS {
 		using ClrValues = util::TransientArray<VkClearValue>;
 
 		auto& e = ca.engine();
-		auto& renderExt = e.getRenderExtent();
+		auto& renderExt = e.getMaxRenderExtent(); // Dynamic resolution renders to a sub-rectangle of this
 		auto& presentExt = e.getPresentExtent();
 		auto  surfaceFmt = e.surfaceFormat().format;
 		auto  depthFmt = e.depthFormat();
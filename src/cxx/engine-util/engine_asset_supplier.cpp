@@ -9,6 +9,8 @@
 
 #include <vulkan/vulkan_format_traits.hpp>
 
+#include <limits>
+
 
 
 namespace SKENGINE_NAME_NS {
@@ -22,6 +24,7 @@ namespace SKENGINE_NAME_NS {
 	AssetSupplier::AssetSupplier(Logger logger, std::shared_ptr<AssetCacheInterface> aci, float max_inactive_ratio):
 			as_logger(std::move(logger)),
 			as_cacheInterface(std::move(aci)),
+			as_geometryArena(as_logger),
 			as_maxInactiveRatio(max_inactive_ratio),
 			as_initialized(true),
 			as_fallbackMaterialExists(false)
@@ -38,6 +41,7 @@ namespace SKENGINE_NAME_NS {
 			MV_(as_inactiveMaterials),
 			MV_(as_fallbackMaterial),
 			MV_(as_missingMaterials),
+			MV_(as_geometryArena),
 			MV_(as_maxInactiveRatio),
 			MV_(as_initialized),
 			MV_(as_fallbackMaterialExists)
@@ -54,13 +58,9 @@ namespace SKENGINE_NAME_NS {
 		releaseAllModels(transfCtx);
 		releaseAllMaterials(transfCtx);
 
-		auto destroy_model = [&](Models::value_type& model) {
-			vkutil::BufferDuplex::destroy(vma, model.second.indices);
-			vkutil::BufferDuplex::destroy(vma, model.second.vertices);
-		};
-
-		for(auto& model : as_inactiveModels) destroy_model(model);
+		// Released ranges are simply forgotten along with the arena
 		as_inactiveModels.clear();
+		GeometryArena::destroy(vma, as_geometryArena);
 
 		for(auto& mat : as_inactiveMaterials) destroy_material(dev, vma, mat.second);
 		as_inactiveMaterials.clear();
@@ -87,16 +87,39 @@ namespace SKENGINE_NAME_NS {
 		}
 		else {
 			DevModel r;
-			auto vma = transfCtx.vma;
 			auto cache = as_cacheInterface->aci_requestModelData(id);
 			auto materials = cache.fmaHeader.materials();
 			auto meshes    = cache.fmaHeader.meshes();
 			auto bones     = cache.fmaHeader.bones();
 			auto faces     = cache.fmaHeader.faces();
 			auto indices   = cache.fmaHeader.indices();
-			auto vertices  = cache.fmaHeader.vertices();
-
-			TransferCmdBarrier transfCmdBars[2];
+			auto vertices  = std::span<const std::byte>(
+				reinterpret_cast<const std::byte*>(cache.fmaHeader.vertexPtr()),
+				cache.fmaHeader.vertexCount() * cache.fmaHeader.vertexStride() );
+			bool compact   = cache.fmaHeader.hasCompactVertices();
+			auto lods      = cache.fmaHeader.hasLodChains()? cache.fmaHeader.lods() : std::span<const fmamdl::Lod>();
+
+			// Meshlet triangles are appended to the index buffer, one restart-terminated triangle at a time
+			std::vector<std::vector<MeshCluster>> meshClusters;
+			std::vector<uint32_t> clusterIndices;
+			if(cache.fmaHeader.hasMeshlets()) {
+				auto meshletVertices  = cache.fmaHeader.meshletVertices();
+				auto meshletTriangles = cache.fmaHeader.meshletTriangles();
+				meshClusters.resize(meshes.size());
+				for(auto& meshlet : cache.fmaHeader.meshlets()) {
+					if(meshlet.meshIndex >= meshes.size()) continue;
+					meshClusters[meshlet.meshIndex].push_back(MeshCluster {
+						.cull_sphere_xyzr = { meshlet.center[0], meshlet.center[1], meshlet.center[2], meshlet.radius },
+						.cone_axis_cutoff = { meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2], meshlet.coneCutoff },
+						.index_count      = uint32_t(meshlet.triangleCount) * 4,
+						.first_index      = uint32_t(indices.size() + clusterIndices.size()) });
+					for(uint32_t i = 0; i < uint32_t(meshlet.triangleCount) * 3; ++i) {
+						auto local = meshletTriangles[(meshlet.firstTriangle * 3) + i];
+						clusterIndices.push_back(meshletVertices[meshlet.firstVertex + local]);
+						if(i % 3 == 2) clusterIndices.push_back(uint32_t(fmamdl::Index::ePrimitiveRestart));
+					}
+				}
+			}
 
 			if(meshes.empty()) {
 				as_logger.critical(
@@ -105,21 +128,15 @@ namespace SKENGINE_NAME_NS {
 				abort();
 			}
 
-			{ // Create the vertex input buffers
-				vkutil::BufferCreateInfo bc_info = { };
-				bc_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-				bc_info.size  = indices.size_bytes();
-				r.indices = vkutil::BufferDuplex::createIndexInputBuffer(vma, bc_info);
-				bc_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-				bc_info.size  = vertices.size_bytes();
-				r.vertices = vkutil::BufferDuplex::createVertexInputBuffer(vma, bc_info);
-				r.index_count   = indices.size();
-				r.vertex_count  = vertices.size();
-
-				memcpy(r.indices.mappedPtr<void>(),  indices.data(),  indices.size_bytes());
-				memcpy(r.vertices.mappedPtr<void>(), vertices.data(), vertices.size_bytes());
-				transfCmdBars[0] = Engine::pushBufferAsync(transfCtx, r.indices);
-				transfCmdBars[1] = Engine::pushBufferAsync(transfCtx, r.vertices);
+			{ // Suballocate the vertex inputs from the geometry arena
+				using Pool = GeometryArena::Pool;
+				r.indices = as_geometryArena.upload(transfCtx, Pool::eIndices, {
+					std::as_bytes(indices),
+					std::as_bytes(std::span<const uint32_t>(clusterIndices)) });
+				r.vertices = as_geometryArena.upload(transfCtx, compact? Pool::eCompactVertices : Pool::eVertices, { vertices });
+				r.index_count   = indices.size() + clusterIndices.size();
+				r.vertex_count  = cache.fmaHeader.vertexCount();
+				r.compact_vertices = compact;
 			}
 
 			std::vector<Bone> insBones;
@@ -128,15 +145,36 @@ namespace SKENGINE_NAME_NS {
 				auto& first_face    = faces[mesh.firstFace];
 				auto  material_name = cache.fmaHeader.getStringView(materials[mesh.materialIndex].name);
 				auto  material_id   = idgen::invalidId<MaterialId>();
+				auto  dequant_offset = glm::vec3(0.0f, 0.0f, 0.0f);
+				auto  dequant_scale  = glm::vec3(1.0f, 1.0f, 1.0f);
+				if(compact) {
+					auto& bounds = cache.fmaHeader.vertexBounds()[bone.meshIndex];
+					dequant_offset = { bounds.min   [0], bounds.min   [1], bounds.min   [2] };
+					dequant_scale  = { bounds.extent[0], bounds.extent[1], bounds.extent[2] };
+				}
 				try {
 					material_id = as_cacheInterface->aci_materialIdFromName(material_name); }
 				catch(...) {
 					as_logger.error("Failed to associate the name \"{}\" to a material ref", material_name); }
+				uint32_t mesh_lod_count = 0;
+				std::array<MeshLod, MAX_MESH_LODS - 1> mesh_lods = { };
+				for(auto& lod : lods) { // LODs are grouped by mesh, and sorted by increasing error
+					if(lod.meshIndex != bone.meshIndex || mesh_lod_count >= mesh_lods.size()) continue;
+					mesh_lods[mesh_lod_count ++] = MeshLod {
+						.index_count = lod.indexCount,
+						.first_index = lod.firstIndex,
+						.error       = (mesh.radius > 0.0f)? lod.error / mesh.radius : std::numeric_limits<float>::max() };
+				}
 				auto ins = Bone {
 					.mesh = Mesh {
 						.index_count = uint32_t(mesh.indexCount),
 						.first_index = uint32_t(first_face.firstIndex),
-						.cull_sphere_xyzr = { mesh.center[0], mesh.center[1], mesh.center[2], mesh.radius } },
+						.cull_sphere_xyzr = { mesh.center[0], mesh.center[1], mesh.center[2], mesh.radius },
+						.vtx_dequant_offset = dequant_offset,
+						.vtx_dequant_scale  = dequant_scale,
+						.lod_count = mesh_lod_count,
+						.lods      = mesh_lods,
+						.clusters  = meshClusters.empty()? std::vector<MeshCluster>() : meshClusters[bone.meshIndex] },
 					.material_id = material_id,
 					.position_xyz  = { bone.relPosition[0], bone.relPosition[1], bone.relPosition[2] },
 					.direction_ypr = { bone.relRotation[0], bone.relRotation[1], bone.relRotation[2] },
@@ -147,7 +185,7 @@ namespace SKENGINE_NAME_NS {
 			r.bones.insert(r.bones.end(), insBones.begin(), insBones.end());
 
 			as_activeModels.insert(Models::value_type(id, r));
-			double size_kib = indices.size_bytes() + vertices.size_bytes();
+			double size_kib = indices.size_bytes() + (clusterIndices.size() * sizeof(uint32_t)) + vertices.size_bytes();
 			as_logger.trace("Loaded model {} ({:.3f} KiB)", model_id_e(id), size_kib / 1000.0);
 
 			as_cacheInterface->aci_releaseModelData(id);
@@ -157,17 +195,16 @@ namespace SKENGINE_NAME_NS {
 
 
 	void AssetSupplier::releaseModel(ModelId id, TransferContext transfCtx) noexcept {
-		auto vma = transfCtx.vma;
-
 		auto existing = as_activeModels.find(id);
 		if(existing != as_activeModels.end()) {
 			// Move to the inactive map
 			as_inactiveModels.insert(*existing);
 			as_activeModels.erase(existing);
 			if(as_maxInactiveRatio < float(as_inactiveModels.size()) / float(as_activeModels.size())) {
+				// The victim may have been used by a gframe that is still in flight
 				auto victim = as_inactiveModels.begin();
-				vkutil::BufferDuplex::destroy(vma, victim->second.indices);
-				vkutil::BufferDuplex::destroy(vma, victim->second.vertices);
+				as_geometryArena.release(transfCtx, victim->second.indices);
+				as_geometryArena.release(transfCtx, victim->second.vertices);
 				as_inactiveModels.erase(victim);
 			}
 			as_logger.trace("Released model {}", model_id_e(id));
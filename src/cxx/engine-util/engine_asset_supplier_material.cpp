@@ -204,8 +204,9 @@ namespace SKENGINE_NAME_NS {
 			as_inactiveMaterials.insert(*existing);
 			as_activeMaterials.erase(existing);
 			if(as_maxInactiveRatio < float(as_inactiveMaterials.size()) / float(as_activeMaterials.size())) {
+				// The victim's textures may be in use by a gframe that is still in flight
 				auto victim = as_inactiveMaterials.begin();
-				destroy_material(dev, vma, victim->second);
+				transfCtx.cleanupQueue->enqueue([dev, vma, mat = victim->second]() mutable { destroy_material(dev, vma, mat); });
 				as_inactiveMaterials.erase(victim);
 			}
 			as_logger.trace("Released material {}", material_id_e(id));
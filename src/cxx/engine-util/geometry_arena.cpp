@@ -0,0 +1,251 @@
+#include "geometry_arena.hpp"
+
+#include <engine/engine.hpp>
+#include <engine/debug.inl.hpp>
+
+#include <fmamdl/fmamdl.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	namespace {
+
+		constexpr size_t POOL_INITIAL_CAPACITY_KB = 1024;
+
+		constexpr size_t pool_element_sizes[GeometryArena::POOL_COUNT] = {
+			sizeof(uint32_t),
+			sizeof(fmamdl::Vertex),
+			sizeof(fmamdl::CompactVertex) };
+
+		constexpr const char* pool_names[GeometryArena::POOL_COUNT] = {
+			"geometry arena (indices)",
+			"geometry arena (vertices)",
+			"geometry arena (compact vertices)" };
+
+
+		vkutil::Buffer create_pool_buffer(VmaAllocator vma, GeometryArena::Pool pool, uint32_t capacity) {
+			vkutil::BufferCreateInfo bc_info = { };
+			bc_info.size  = size_t(capacity) * pool_element_sizes[unsigned(pool)];
+			bc_info.usage =
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT  | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			vkutil::AllocationCreateInfo ac_info = { };
+			ac_info.requiredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			ac_info.vmaUsage         = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
+			auto r = vkutil::Buffer::create(vma, bc_info, ac_info);
+			debug::createdBuffer(r, pool_names[unsigned(pool)]);
+			return r;
+		}
+
+	}
+
+
+
+	GeometryArena::GeometryArena(Logger logger):
+			mState(std::make_shared<State>())
+	{
+		mState->logger     = std::move(logger);
+		mState->pools      = { };
+		mState->lastId     = 0;
+		mState->generation = 0;
+	}
+
+
+	void GeometryArena::destroy(VmaAllocator vma, GeometryArena& arena) noexcept {
+		assert(arena.mState);
+		auto lock = std::unique_lock(arena.mState->mutex);
+		for(unsigned i = 0; i < POOL_COUNT; ++i) {
+			auto& pool = arena.mState->pools[i];
+			if(pool.buffer.value == nullptr) continue;
+			debug::destroyedBuffer(pool.buffer, pool_names[i]);
+			vkutil::Buffer::destroy(vma, pool.buffer);
+		}
+		lock.unlock();
+		arena.mState = { }; // Pending releases will find nothing to release
+	}
+
+
+	GeometryRangeId GeometryArena::upload(
+			const TransferContext& transfCtx,
+			Pool pool_idx,
+			std::initializer_list<std::span<const std::byte>> data
+	) {
+		assert(mState);
+		auto& state = *mState;
+		auto  lock  = std::unique_lock(state.mutex);
+		auto& pool  = state.pools[unsigned(pool_idx)];
+		auto  elem_size = pool_element_sizes[unsigned(pool_idx)];
+
+		size_t bytes = 0;
+		for(auto& part : data) bytes += part.size_bytes();
+		assert(bytes % elem_size == 0);
+		auto count = uint32_t(bytes / elem_size);
+
+		uint32_t first = 0;
+		if(count > 0) {
+			if(pool.alloc.shouldDefragment()) { // Reallocate the pool if its free space is too scattered to be used
+				state.logger.debug("Defragmenting the {}: {:.1f}% of the free space is fragmented", pool_names[unsigned(pool_idx)], pool.alloc.getFragmentation() * 100.0f);
+				reallocatePool(transfCtx, state, pool_idx, count);
+			}
+			if(! pool.alloc.tryAlloc(count, &first)) {
+				reallocatePool(transfCtx, state, pool_idx, count);
+				[[maybe_unused]] bool allocd = pool.alloc.tryAlloc(count, &first);
+				assert(allocd);
+			}
+
+			vkutil::BufferCreateInfo bc_info = { };
+			bc_info.size  = bytes;
+			bc_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			auto staging = vkutil::ManagedBuffer::createStagingBuffer(transfCtx.vma, bc_info);
+			auto* dst = staging.map<std::byte>(transfCtx.vma);
+			for(auto& part : data) {
+				memcpy(dst, part.data(), part.size_bytes());
+				dst += part.size_bytes();
+			}
+			vkutil::MemoryRange flush_range = { .offset = 0, .size = bytes };
+			staging.flush(transfCtx.vma, std::span<const vkutil::MemoryRange>(&flush_range, 1));
+			staging.unmap(transfCtx.vma);
+			VkBufferCopy cp = { .srcOffset = 0, .dstOffset = first * elem_size, .size = bytes };
+			Engine::copyBuffer(transfCtx, staging, pool.buffer, std::span<const VkBufferCopy>(&cp, 1));
+			vkutil::ManagedBuffer::destroy(transfCtx.vma, staging);
+		}
+
+		auto id = GeometryRangeId(++ state.lastId);
+		state.entries.insert({ id, Entry {
+			.pool     = pool_idx,
+			.first    = first,
+			.count    = count,
+			.released = false,
+			.placed   = true } });
+		return id;
+	}
+
+
+	void GeometryArena::release(const TransferContext& transfCtx, GeometryRangeId id) noexcept {
+		assert(mState);
+		auto lock  = std::unique_lock(mState->mutex);
+		auto entry = mState->entries.find(id);
+		if(entry == mState->entries.end() || entry->second.released) {
+			mState->logger.warn("Tried to release geometry range {}, but it's not allocated", geometry_range_id_e(id));
+			return;
+		}
+		entry->second.released = true;
+
+		// The range may be used by a gframe that is still in flight
+		transfCtx.cleanupQueue->enqueue([state_wk = std::weak_ptr<State>(mState), id]() {
+			auto state = state_wk.lock();
+			if(! state) return;
+			auto lock  = std::unique_lock(state->mutex);
+			auto entry = state->entries.find(id);
+			assert(entry != state->entries.end());
+			if(entry->second.placed) {
+				auto& pool = state->pools[unsigned(entry->second.pool)];
+				pool.alloc.dealloc(entry->second.first, entry->second.count);
+			}
+			state->entries.erase(entry);
+		});
+	}
+
+
+	void GeometryArena::defragment(const TransferContext& transfCtx, Pool pool_idx) {
+		assert(mState);
+		auto lock = std::unique_lock(mState->mutex);
+		reallocatePool(transfCtx, *mState, pool_idx, 0);
+	}
+
+
+	GeometryArena::Range GeometryArena::getRange(GeometryRangeId id) const noexcept {
+		assert(mState);
+		auto lock  = std::unique_lock(mState->mutex);
+		auto entry = mState->entries.find(id);
+		assert(entry != mState->entries.end());
+		assert(entry->second.placed);
+		return { entry->second.first, entry->second.count };
+	}
+
+
+	VkBuffer GeometryArena::getBuffer(Pool pool_idx) const noexcept {
+		assert(mState);
+		auto lock = std::unique_lock(mState->mutex);
+		return mState->pools[unsigned(pool_idx)].buffer.value;
+	}
+
+
+	GeometryArena::Buffers GeometryArena::getBuffers() const noexcept {
+		assert(mState);
+		auto lock = std::unique_lock(mState->mutex);
+		Buffers r;
+		for(unsigned i = 0; i < POOL_COUNT; ++i) r.pools[i] = mState->pools[i].buffer.value;
+		r.generation = mState->generation;
+		return r;
+	}
+
+
+	uint64_t GeometryArena::getGeneration() const noexcept {
+		assert(mState);
+		auto lock = std::unique_lock(mState->mutex);
+		return mState->generation;
+	}
+
+
+	float GeometryArena::getFragmentation(Pool pool_idx) const noexcept {
+		assert(mState);
+		auto lock = std::unique_lock(mState->mutex);
+		return mState->pools[unsigned(pool_idx)].alloc.getFragmentation();
+	}
+
+
+	void GeometryArena::reallocatePool(const TransferContext& transfCtx, State& state, Pool pool_idx, uint32_t reserve_count) {
+		auto& pool         = state.pools[unsigned(pool_idx)];
+		auto  elem_size    = pool_element_sizes[unsigned(pool_idx)];
+		auto  old_capacity = pool.alloc.getCapacity();
+
+		// Released ranges are left behind, along with the old buffer
+		std::vector<GeometryArenaAllocator::LiveRange> live;
+		for(auto& entry : state.entries) {
+			if(entry.second.pool != pool_idx || ! entry.second.placed || entry.second.count == 0) continue;
+			if(entry.second.released) entry.second.placed = false;
+			else live.push_back({ &entry.second.first, entry.second.count });
+		}
+
+		// Pack the live ranges in their original order, merging the copies of adjacent ones
+		auto initial_capacity = uint32_t(1024 * POOL_INITIAL_CAPACITY_KB / elem_size);
+		auto moves      = pool.alloc.compact(live, initial_capacity, reserve_count);
+		auto new_buffer = create_pool_buffer(transfCtx.vma, pool_idx, pool.alloc.getCapacity());
+
+		if(pool.buffer.value != nullptr) {
+			std::vector<VkBufferCopy> copies;
+			copies.reserve(moves.size());
+			for(auto& mv : moves) copies.push_back({
+				.srcOffset = VkDeviceSize(mv.src)   * elem_size,
+				.dstOffset = VkDeviceSize(mv.dst)   * elem_size,
+				.size      = VkDeviceSize(mv.count) * elem_size });
+			Engine::copyBuffer(transfCtx, pool.buffer, new_buffer, copies);
+			retirePoolBuffer(transfCtx, pool_idx, pool.buffer);
+		}
+
+		state.logger.trace(
+			"Reallocated the {}: {} -> {} elements, {} in use",
+			pool_names[unsigned(pool_idx)], old_capacity, pool.alloc.getCapacity(), pool.alloc.getUsed() );
+		pool.buffer = new_buffer;
+		++ state.generation;
+	}
+
+
+	void GeometryArena::retirePoolBuffer(const TransferContext& transfCtx, Pool pool_idx, vkutil::Buffer buffer) {
+		// Frames that are being recorded or are in flight may still be drawing from the
+		// buffer: the cleanup queue destroys it once the current gframe is complete
+		assert(transfCtx.cleanupQueue != nullptr);
+		transfCtx.cleanupQueue->enqueue([vma = transfCtx.vma, buffer, name = pool_names[unsigned(pool_idx)]]() mutable {
+			debug::destroyedBuffer(buffer, name);
+			vkutil::Buffer::destroy(vma, buffer);
+		});
+	}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "geometry_arena_allocator.hpp"
+
+#include <engine/types.hpp>
+
+#include <vk-util/memory.hpp>
+
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+#include <vma/vk_mem_alloc.h>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	using geometry_range_id_e = uint32_t;
+	enum class GeometryRangeId : geometry_range_id_e { };
+
+
+	/// \brief A few large device-local buffers, from which the
+	///        vertices and indices of every model are suballocated.
+	///
+	/// There is one pool for indices and one for each vertex layout;
+	/// ranges are measured in elements of their pool, so that their
+	/// offsets can be used as the `firstIndex` and `vertexOffset` of
+	/// draw commands, and all the models that share a vertex layout can be
+	/// drawn with a single vertex buffer binding.
+	///
+	/// A pool is reallocated when it runs out of space, or when its free
+	/// space is too fragmented: the live ranges are copied (on the device) to
+	/// the front of the new buffer, while the old one is retired through the
+	/// cleanup queue.
+	/// Each reallocation increments the arena's generation: users must
+	/// query the offsets of their ranges, and the buffers, again when it changes.
+	/// Offsets and buffers of the same generation can be used together for
+	/// as long as the frame they are recorded for is in flight, since the
+	/// old buffer is only destroyed once that frame is complete.
+	///
+	class GeometryArena {
+	public:
+		enum class Pool : unsigned { eIndices = 0, eVertices = 1, eCompactVertices = 2 };
+		static constexpr unsigned POOL_COUNT = 3;
+
+		struct Range {
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct Buffers {
+			std::array<VkBuffer, POOL_COUNT> pools;
+			uint64_t generation;
+			VkBuffer operator[](Pool pool) const noexcept { return pools[unsigned(pool)]; }
+		};
+
+		GeometryArena() = default;
+		GeometryArena(Logger);
+
+		static void destroy(VmaAllocator, GeometryArena&) noexcept;
+
+		/// \brief Allocates a range and copies the given data into it, in order.
+		///
+		/// The size of the data must be a multiple of the size of the pool's elements.
+		/// This function waits for the copy to be completed.
+		///
+		[[nodiscard]] GeometryRangeId upload(const TransferContext&, Pool, std::initializer_list<std::span<const std::byte>> data);
+
+		/// \brief Frees a range, once the frames in flight are done with it.
+		///
+		void release(const TransferContext&, GeometryRangeId) noexcept;
+
+		/// \brief Moves every live range of a pool to the front of a new buffer.
+		///
+		void defragment(const TransferContext&, Pool);
+
+		Range    getRange       (GeometryRangeId) const noexcept;
+		VkBuffer getBuffer      (Pool) const noexcept;
+		Buffers  getBuffers     () const noexcept;
+		uint64_t getGeneration  () const noexcept;
+
+		/// \returns The fraction of the free space of a pool that is not
+		///          part of its largest free block.
+		///
+		float getFragmentation(Pool) const noexcept;
+
+		bool isInitialized() const noexcept { return bool(mState); }
+
+	private:
+		struct Entry {
+			Pool     pool;
+			uint32_t first;
+			uint32_t count;
+			bool     released; // Pending deallocation, its data may only be used by frames in flight
+			bool     placed;   // `false` if the pool has been reallocated after the release
+		};
+
+		struct PoolState {
+			vkutil::Buffer buffer;
+			GeometryArenaAllocator alloc;
+		};
+
+		struct State {
+			mutable std::mutex mutex;
+			Logger logger;
+			std::array<PoolState, POOL_COUNT> pools;
+			std::unordered_map<GeometryRangeId, Entry> entries;
+			geometry_range_id_e lastId;
+			uint64_t generation;
+		};
+
+		std::shared_ptr<State> mState;
+
+		static void reallocatePool(const TransferContext&, State&, Pool, uint32_t required_capacity);
+		static void retirePoolBuffer(const TransferContext&, Pool, vkutil::Buffer);
+	};
+
+}
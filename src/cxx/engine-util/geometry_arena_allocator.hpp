@@ -0,0 +1,145 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <span>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	/// \brief The bookkeeping of a `GeometryArena` pool, which knows
+	///        nothing of the buffer it describes.
+	///
+	/// Offsets and sizes are measured in elements of the pool.
+	///
+	class GeometryArenaAllocator {
+	public:
+		static constexpr float DEFRAG_FRAGMENTATION_THRESHOLD = 0.5f;  // See `getFragmentation`
+		static constexpr float DEFRAG_MIN_HOLE_FRACTION       = 0.25f; // Fragmented space worth a reallocation, relative to the capacity
+
+		/// \brief A range of elements to be moved by a reallocation.
+		///
+		struct Copy {
+			uint32_t src;
+			uint32_t dst;
+			uint32_t count;
+		};
+
+		/// \brief A live range, whose offset is updated by `compact`.
+		///
+		struct LiveRange {
+			uint32_t* first;
+			uint32_t  count;
+		};
+
+		GeometryArenaAllocator() = default;
+
+		/// \brief Best fit, taken from the front of the block.
+		///
+		bool tryAlloc(uint32_t count, uint32_t* dst) {
+			auto best = gaa_freeBlocks.end();
+			for(auto iter = gaa_freeBlocks.begin(); iter != gaa_freeBlocks.end(); ++ iter) {
+				if(iter->second < count) continue;
+				if(best == gaa_freeBlocks.end() || iter->second < best->second) best = iter;
+				if(best->second == count) break;
+			}
+			if(best == gaa_freeBlocks.end()) return false;
+			*dst = best->first;
+			auto remaining = best->second - count;
+			gaa_freeBlocks.erase(best);
+			if(remaining > 0) gaa_freeBlocks.insert({ *dst + count, remaining });
+			gaa_used += count;
+			return true;
+		}
+
+		void dealloc(uint32_t first, uint32_t count) {
+			if(count == 0) return;
+			assert(first + count <= gaa_capacity);
+			assert(gaa_used >= count);
+			gaa_used -= count;
+			auto next = gaa_freeBlocks.lower_bound(first);
+			assert(next == gaa_freeBlocks.end() || next->first >= first + count);
+			if(next != gaa_freeBlocks.end() && next->first == first + count) { // Merge with the next block
+				count += next->second;
+				next = gaa_freeBlocks.erase(next);
+			}
+			if(next != gaa_freeBlocks.begin()) {
+				auto prev = std::prev(next);
+				assert(prev->first + prev->second <= first);
+				if(prev->first + prev->second == first) { // Merge with the previous block
+					prev->second += count;
+					return;
+				}
+			}
+			gaa_freeBlocks.insert(next, { first, count });
+		}
+
+		/// \returns The fraction of the free space that is not part of the largest free block.
+		///
+		float getFragmentation() const noexcept {
+			uint32_t free = gaa_capacity - gaa_used;
+			if(free == 0) return 0.0f;
+			uint32_t largest = 0;
+			for(auto& block : gaa_freeBlocks) largest = std::max(largest, block.second);
+			return 1.0f - (float(largest) / float(free));
+		}
+
+		/// \brief Whether the free space is too scattered to be used, and
+		///        there is enough of it to be worth a reallocation.
+		///
+		bool shouldDefragment() const noexcept {
+			if(gaa_capacity == 0) return false;
+			float frag  = getFragmentation();
+			float holes = frag * float(gaa_capacity - gaa_used);
+			return (frag > DEFRAG_FRAGMENTATION_THRESHOLD) && (holes > DEFRAG_MIN_HOLE_FRACTION * float(gaa_capacity));
+		}
+
+		/// \brief Packs the given ranges at the front of a pool of (at least)
+		///        `minCapacity` elements, with room for `reserveCount` more.
+		///
+		/// The ranges keep their relative order, and their offsets are
+		/// updated; ranges that are not given are forgotten.
+		///
+		/// \returns The copies that move the data of the ranges from the old
+		///          pool to the new one, in ascending order, with adjacent
+		///          ranges merged.
+		///
+		std::vector<Copy> compact(std::span<LiveRange> live, uint32_t minCapacity, uint32_t reserveCount) {
+			std::sort(live.begin(), live.end(), [](const LiveRange& l, const LiveRange& r) { return *l.first < *r.first; });
+			std::vector<Copy> copies;
+			uint32_t cursor = 0;
+			for(auto& range : live) {
+				if(! copies.empty() && copies.back().src + copies.back().count == *range.first && copies.back().dst + copies.back().count == cursor) {
+					copies.back().count += range.count;
+				} else {
+					copies.push_back({ *range.first, cursor, range.count });
+				}
+				*range.first = cursor;
+				cursor += range.count;
+			}
+			gaa_capacity = std::max({ gaa_capacity, minCapacity, std::bit_ceil(cursor + reserveCount) });
+			gaa_used     = cursor;
+			gaa_freeBlocks.clear();
+			if(gaa_capacity > cursor) gaa_freeBlocks.insert({ cursor, gaa_capacity - cursor });
+			return copies;
+		}
+
+		uint32_t getCapacity () const noexcept { return gaa_capacity; }
+		uint32_t getUsed     () const noexcept { return gaa_used; }
+		const auto& getFreeBlocks() const noexcept { return gaa_freeBlocks; }
+
+	private:
+		std::map<uint32_t, uint32_t> gaa_freeBlocks; // Offset -> size, never adjacent to each other
+		uint32_t gaa_capacity = 0;
+		uint32_t gaa_used     = 0; // Including released ranges that are still placed
+	};
+
+}
@@ -39,24 +39,30 @@ namespace SKENGINE_NAME_NS::gui {
 
 
 
+	void DrawJobSet::insert(const DrawJob& job) {
+		// Elements are drawn in the order they insert their jobs, which the
+		// stable sort preserves among jobs of the same state: the depth
+		// field can be left to 0, and its digits cost nothing to sort.
+		auto key = DrawSortKey::pack(
+			djs_pipelines.indexOf(job.pipeline),
+			djs_viewportScissors.indexOf(job.viewportScissor),
+			djs_imageDsets.indexOf(job.imageDset),
+			0 );
+		djs_queue.push(key, job);
+	}
+
+
+	void DrawJobSet::clear() noexcept {
+		djs_pipelines.clear();
+		djs_viewportScissors.clear();
+		djs_imageDsets.clear();
+		djs_queue.clear();
+	}
+
+
 	void DrawContext::insertDrawJob(const DrawJob& job) {
-		// VkPipeline pl,
-		// VkDescriptorSet imageDset,
-		// const ViewportScissor& vs,
-		// DrawableShapeSet* ds,
-		// glm::vec3 offset, glm::vec3 scale
-		// ---
-		// .push_back(DrawJob {
-		// 	.pipeline = pl,
-		// 	.viewportScissor = vs,
-		// 	.imageDset = imageDset,
-		// 	.shapeSet = ds,
-		// 	.transform = { { offset.x, offset.y, offset.z }, { scale.x, scale.y, scale.z } } });
-		drawJobs
-		[job.pipeline]
-		[job.viewportScissor]
-		[job.imageDset]
-		.push_back(job);
+		assert(drawJobs != nullptr && "Draw jobs can only be inserted during the draw stage");
+		drawJobs->push_back(job);
 	}
 
 
@@ -69,7 +75,7 @@ namespace SKENGINE_NAME_NS::gui {
 
 	void DrawablePolygon::ui_elem_draw(LotId, Lot& lot, ui::DrawContext& uiCtx) {
 		auto& guiCtx  = getGuiDrawContext(uiCtx);
-		auto  cbounds = ui_elem_getBounds(lot);
+		auto  cbounds = getBounds(lot);
 
 		auto& extent = guiCtx.engine->getPresentExtent();
 		float xfExtent = float(extent.width);
@@ -112,16 +118,18 @@ namespace SKENGINE_NAME_NS::gui {
 
 
 	void BasicPolygon::setShapes(ShapeSet newShapes) {
+		// Updating keeps the buffers, and only rewrites the instances that changed if the shapes are the same
 		auto& oldShapes = shapes();
-		if(oldShapes) DrawableShapeSet::destroy(basic_elem_vma, oldShapes);
-		oldShapes = DrawableShapeSet::create(basic_elem_vma, std::move(newShapes));
+		if(oldShapes) oldShapes.update(basic_elem_vma, std::move(newShapes));
+		else          oldShapes = DrawableShapeSet::create(basic_elem_vma, std::move(newShapes));
+		setModified();
 	}
 
 
 	TextLine::TextLine(VmaAllocator vma, float depth, const TextInfo& ti, std::u32string str):
 		txt_vma(vma),
 		txt_str(std::move(str)),
-		txt_lastCacheUpdate(0),
+		txt_lastCacheRemap(0),
 		txt_depth(depth),
 		txt_info(ti),
 		txt_upToDate(false)
@@ -148,36 +156,13 @@ namespace SKENGINE_NAME_NS::gui {
 		auto& guiCtx   = getGuiDrawContext(uiCtx);
 		auto& txtCache = guiCtx.uiRenderer->getTextCache(txt_info.fontSize);
 
-		struct Pen {
-			float x;
-		};
-
-		auto pushCharVertices = [&](ShapeSet& dst, Pen& pen, const TextCache::CharMap& chars, codepoint_t c) {
+		auto pushGlyph = [&](ShapeSet& dst, const TextCache::CharMap& chars, const PositionedGlyph& glyph) {
 			static constexpr auto mat1 = glm::mat4(1.0f);
-			auto& charBounds = chars.find(c)->second;
-			float baselineToBottom = charBounds.size[1] - charBounds.baseline[1];
-			float off[2] = {
-				pen.x * 2.0f,
-				baselineToBottom };
-			float u[2] = { charBounds.topLeftUv[0], charBounds.bottomRightUv[0] };
-			float v[2] = { charBounds.topLeftUv[1], charBounds.bottomRightUv[1] };
-			float x[2] = {
-				0.0f,
-				0.0f + (charBounds.size[0] * 2.0f) };
-			float height = charBounds.size[1] * 2.0f;
-			float y[2] = {
-				off[1] +2.0f - height,
-				off[1] +2.0f };
-			auto shape = std::make_shared<Shape>(std::vector<TextVertex> {
-				{{ x[0], y[0], 0.0f }, { u[0], v[0] }},
-				{{ x[0], y[1], 0.0f }, { u[0], v[1] }},
-				{{ x[1], y[1], 0.0f }, { u[1], v[1] }},
-				{{ x[1], y[0], 0.0f }, { u[1], v[0] }} });
 			constexpr auto color = glm::vec4 { 1.0f, 1.0f, 1.0f, 1.0f };
-			glm::mat4 mat = glm::translate(mat1, { off[0], off[1], 0.0f });
-			auto shapeRef = ShapeReference(std::move(shape), color, mat);
-			dst.push_back(std::move(shapeRef));
-			pen.x += charBounds.advance[0];
+			auto& charBounds = chars.find(glyph.codepoint)->second;
+			float baselineToBottom = charBounds.size[1] - charBounds.baseline[1];
+			glm::mat4 mat = glm::translate(mat1, { glyph.penX * 2.0f, baselineToBottom, 0.0f });
+			dst.push_back(ShapeReference(guiCtx.uiRenderer->getGlyphShape(txtCache, glyph.codepoint), color, mat));
 		};
 
 		auto fetch = [&]() {
@@ -189,21 +174,22 @@ namespace SKENGINE_NAME_NS::gui {
 		};
 
 		auto commit = [&]() {
-			if(txt_lastCacheUpdate != txtCache.getUpdateCounter()) txt_upToDate = false;
-			if(! txt_upToDate) { // Update the shape set
+			// New characters do not affect this line, only remapped ones do
+			if(txt_lastCacheRemap != txtCache.getRemapCounter()) txt_upToDate = false;
+			if(! txt_upToDate) { // Rewrite the shape set, whose buffers are reused if large enough
 				auto& chars = txtCache.getChars();
 				auto face = txtCache.fontFace()->ftFace();
 				float faceUnits = face->units_per_EM;
-				ShapeSet refs; refs.reserve(txt_str.size());
-				Pen pen = { };
-				if(txt_shapeSet) DrawableShapeSet::destroy(txt_vma, txt_shapeSet);
-				for(auto c : txt_str) pushCharVertices(refs, pen, chars, c);
-				txt_width  = pen.x;
+				txt_layout = guiCtx.uiRenderer->getTextLayout(txtCache, txt_str);
+				ShapeSet refs; refs.reserve(txt_layout->glyphs.size());
+				for(auto& glyph : txt_layout->glyphs) pushGlyph(refs, chars, glyph);
+				txt_width  = txt_layout->width;
 				txt_height = (face->bbox.yMax - face->bbox.yMin) / faceUnits;
 				txt_descender = float(-face->descender) / faceUnits;
-				txt_shapeSet = DrawableShapeSet::create(txt_vma, std::move(refs));
+				if(txt_shapeSet) txt_shapeSet.update(txt_vma, std::move(refs));
+				else             txt_shapeSet = DrawableShapeSet::create(txt_vma, std::move(refs));
 				txt_upToDate = true;
-				txt_lastCacheUpdate = txtCache.getUpdateCounter();
+				txt_lastCacheRemap = txtCache.getRemapCounter();
 			}
 
 			txt_shapeSet.commitVkBuffers(guiCtx.engine->getVmaAllocator());
@@ -222,7 +208,7 @@ namespace SKENGINE_NAME_NS::gui {
 		if(txt_str.empty()) return;
 
 		auto& guiCtx  = getGuiDrawContext(uiCtx);
-		auto  cBounds = ui_elem_getBounds(lot);
+		auto  cBounds = getBounds(lot);
 
 		auto& extent   = guiCtx.engine->getPresentExtent();
 		auto& txtCache = guiCtx.uiRenderer->getTextCache(txt_info.fontSize);
@@ -269,8 +255,9 @@ namespace SKENGINE_NAME_NS::gui {
 				off.y = +1.0f - ((1.0f / baselineMul) * scale.y * 2.0f); break;
 		}
 
+		auto& pipelines = guiCtx.uiRenderer->getPipelineSet();
 		DrawJob job = {
-			.pipeline = guiCtx.uiRenderer->getPipelineSet().text,
+			.pipeline = txtCache.usesSdf()? pipelines.textSdf : pipelines.text,
 			.viewportScissor = vs,
 			.imageDset = txtCache.dset(),
 			.shapeSet = &txt_shapeSet,
@@ -292,6 +279,7 @@ namespace SKENGINE_NAME_NS::gui {
 		eq = (txt_info.textSize  == ti.textSize )? eq : false;
 		txt_upToDate = txt_upToDate && eq;
 		txt_info = ti;
+		if(! eq) setModified();
 	}
 
 
@@ -310,12 +298,14 @@ namespace SKENGINE_NAME_NS::gui {
 		if(eq) return;
 		txt_str = std::u32string(str.begin(), str.end());
 		txt_upToDate = false;
+		setModified();
 	}
 
 	void TextLine::setText(std::u32string str) noexcept {
 		if(str == txt_str) return;
 		txt_str = std::move(str);
 		txt_upToDate = false;
+		setModified();
 	}
 
 
@@ -350,7 +340,7 @@ namespace SKENGINE_NAME_NS::gui {
 
 	void PlaceholderTextCacheView::ui_elem_draw(LotId, Lot& lot, ui::DrawContext& uiCtx) {
 		auto& guiCtx  = getGuiDrawContext(uiCtx);
-		auto  cbounds = ui_elem_getBounds(lot);
+		auto  cbounds = getBounds(lot);
 
 		auto& extent = guiCtx.engine->getPresentExtent();
 		float xfExtent = float(extent.width);
@@ -359,8 +349,9 @@ namespace SKENGINE_NAME_NS::gui {
 		ViewportScissor vs;
 		setViewportScissor(vs, xfExtent, yfExtent, cbounds);
 
+		auto& pipelines = guiCtx.uiRenderer->getPipelineSet();
 		DrawJob job = {
-			.pipeline = guiCtx.uiRenderer->getPipelineSet().text,
+			.pipeline = tcv_cache->usesSdf()? pipelines.textSdf : pipelines.text,
 			.viewportScissor = vs,
 			.imageDset = tcv_cache->dset(),
 			.shapeSet = &tcv_shapeSet,
@@ -5,15 +5,15 @@
 #include <glm/vec3.hpp>
 
 #include <engine/draw-geometry/core.hpp>
+#include <engine/draw-geometry/draw_queue.hpp>
 #include <engine/ui-structure/ui.hpp>
 
 #include <vk-util/memory.hpp>
 
 #include <memory>
-#include <map>
 #include <bit>
-#include <deque>
 #include <string>
+#include <vector>
 #include <cstring>
 
 
@@ -69,9 +69,27 @@ namespace SKENGINE_NAME_NS {
 			}
 		};
 
-		using DrawJobDsetSet = std::map<VkDescriptorSet, std::deque<DrawJob>>;
-		using DrawJobVsSet   = std::map<ViewportScissor, DrawJobDsetSet, ViewportScissor::HashCmp>;
-		using DrawJobSet     = std::map<VkPipeline,      DrawJobVsSet>;
+		/// \brief The draw jobs of a frame, sorted so that the ones sharing a state are adjacent.
+		///
+		/// States are numbered in the order they are first seen, and their
+		/// numbers are packed into a DrawSortKey; the storage is reused
+		/// from frame to frame.
+		///
+		class DrawJobSet {
+		public:
+			void insert(const DrawJob&);
+			void sort() { djs_queue.sort(); }
+			void clear() noexcept;
+
+			const DrawJob& operator[](size_t i) const noexcept { return djs_queue[i]; }
+			size_t size() const noexcept { return djs_queue.size(); }
+
+		private:
+			geom::FlatIndexMap<VkPipeline>                                djs_pipelines;
+			geom::FlatIndexMap<ViewportScissor, ViewportScissor::HashCmp> djs_viewportScissors;
+			geom::FlatIndexMap<VkDescriptorSet>                           djs_imageDsets;
+			geom::SortedDrawQueue<DrawJob>                                djs_queue;
+		};
 
 
 		enum class TextAlignment : unsigned short {
@@ -96,7 +114,7 @@ namespace SKENGINE_NAME_NS {
 			UiRenderer* uiRenderer;
 			VkCommandBuffer prepareCmdBuffer;
 			VkCommandBuffer drawCmdBuffer;
-			DrawJobSet drawJobs;
+			std::vector<DrawJob>* drawJobs; // The jobs of the lot being drawn, only set during the draw stage
 
 			void insertDrawJob(const DrawJob& job);
 		};
@@ -158,7 +176,7 @@ namespace SKENGINE_NAME_NS {
 			void setTextSize(float s) noexcept          { TextInfo ti = txt_info; ti.textSize = s;  textInfo(ti); }
 
 			float depth() const noexcept { return txt_depth; }
-			void depth(float newValue) noexcept { txt_upToDate = (newValue == txt_depth); txt_depth = newValue; }
+			void depth(float newValue) noexcept { if(newValue != txt_depth) { txt_depth = newValue; setModified(); } }
 
 			void setText(std::string_view) noexcept;
 			void setText(std::u32string) noexcept;
@@ -167,7 +185,8 @@ namespace SKENGINE_NAME_NS {
 			VmaAllocator txt_vma;
 			geom::DrawableShapeSet txt_shapeSet;
 			std::u32string txt_str;
-			TextCache::update_counter_t txt_lastCacheUpdate;
+			TextLayoutCache::LayoutPtr txt_layout;
+			TextCache::update_counter_t txt_lastCacheRemap;
 			float txt_depth;
 			float txt_width;
 			float txt_height;
@@ -6,6 +6,9 @@
 #include "world_renderer.hpp"
 
 #include <random>
+#include <cstring>
+#include <algorithm>
+#include <tuple>
 
 #include <vk-util/error.hpp>
 
@@ -15,6 +18,8 @@
 
 #include <sys-resources.hpp>
 
+#include <zone-profiler/zone_profiler.hpp>
+
 
 
 #ifdef NDEBUG
@@ -34,6 +39,7 @@ namespace SKENGINE_NAME_NS {
 		constexpr size_t OBJECT_MAP_INITIAL_CAPACITY_KB = 32;
 		constexpr float  OBJECT_MAP_MAX_LOAD_FACTOR     = 2;
 		constexpr size_t BATCH_MAP_INITIAL_CAPACITY_KB  = 16;
+		constexpr size_t CLUSTER_BUFFER_INITIAL_CAPACITY_KB = 16;
 		constexpr float  BATCH_MAP_MAX_LOAD_FACTOR      = 0.8;
 		constexpr size_t UNBOUND_BATCH_LEVEL_1_INIT_CAP = 16;
 		constexpr float  UNBOUND_BATCH_LEVEL_1_LOAD_FAC = 0.8;
@@ -45,6 +51,7 @@ namespace SKENGINE_NAME_NS {
 		[[nodiscard]]
 		size_t reserve_mat_dpool(
 				VkDevice dev,
+				CleanupQueue&     cleanup_queue,
 				VkDescriptorPool* dst,
 				size_t            req_cap,
 				size_t            cur_cap
@@ -55,8 +62,9 @@ namespace SKENGINE_NAME_NS {
 
 			if(req_cap != cur_cap) {
 				if(cur_cap > 0) {
+					// In-flight frames may still be using the old dsets
 					assert(*dst != nullptr);
-					vkDestroyDescriptorPool(dev, *dst, nullptr);
+					cleanup_queue.enqueue([dev, dpool = *dst]() { vkDestroyDescriptorPool(dev, dpool, nullptr); });
 				}
 				VkDescriptorPoolSize sizes[] = {
 					{
@@ -137,6 +145,7 @@ namespace SKENGINE_NAME_NS {
 				wr[UBO].descriptorCount = 1;
 				wr[UBO].dstBinding      = UBO;
 				wr[UBO].pBufferInfo     = db_info;
+				SKENGINE_ZONE("material vkUpdateDescriptorSets");
 				vkUpdateDescriptorSets(dev, std::size(wr), wr, 0, nullptr);
 			}
 		}
@@ -144,6 +153,7 @@ namespace SKENGINE_NAME_NS {
 
 		void create_mat_dset(
 				VkDevice dev,
+				CleanupQueue&          cleanup_queue,
 				VkDescriptorPool*      dpool,
 				VkDescriptorSetLayout  layout,
 				size_t* size,
@@ -152,7 +162,7 @@ namespace SKENGINE_NAME_NS {
 				ObjectStorage::MaterialData* dst
 		) {
 			++ *size;
-			size_t new_cap  = reserve_mat_dpool(dev, dpool, *size, *capacity);
+			size_t new_cap  = reserve_mat_dpool(dev, cleanup_queue, dpool, *size, *capacity);
 			if(new_cap != *capacity) { // All existing dsets need to be recreated
 				*capacity = new_cap;
 				for(auto& mat : materials) update_mat_dset(dev, *dpool, layout, true, &mat.second);
@@ -191,8 +201,31 @@ namespace SKENGINE_NAME_NS {
 		}
 
 
+		std::pair<vkutil::Buffer, size_t> create_cluster_draw_buffer(VmaAllocator vma, size_t count) {
+			vkutil::BufferCreateInfo bc_info = { };
+			bc_info.size  = std::bit_ceil(count) * sizeof(dev::ClusterDraw);
+			bc_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			vkutil::AllocationCreateInfo ac_info = { };
+			ac_info.requiredMemFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			ac_info.vmaUsage         = vkutil::VmaAutoMemoryUsage::eAutoPreferHost;
+			ac_info.vmaFlags         = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+			auto r = vkutil::Buffer::create(vma, bc_info, ac_info);
+			debug::createdBuffer(r, "cluster draws");
+			return { std::move(r), bc_info.size };
+		}
+
+
+		void retire_buffer(CleanupQueue& cleanup_queue, VmaAllocator vma, vkutil::Buffer buffer, const char* name) {
+			cleanup_queue.enqueue([vma, buffer, name]() mutable {
+				debug::destroyedBuffer(buffer, name);
+				vkutil::Buffer::destroy(vma, buffer);
+			});
+		}
+
+
 		void commit_draw_batches(
 				VmaAllocator vma,
+				CleanupQueue& cleanup_queue,
 				const ObjectStorage::BatchList& batches,
 				std::pair<vkutil::Buffer, size_t>& buffer
 		) {
@@ -201,8 +234,7 @@ namespace SKENGINE_NAME_NS {
 			if(batches.empty()) return;
 
 			if(batches.size() > buffer.second) {
-				Buffer::destroy(vma, buffer.first);
-				debug::destroyedBuffer(buffer.first, "indirect draw commands");
+				retire_buffer(cleanup_queue, vma, buffer.first, "indirect draw commands");
 				buffer = create_draw_cmd_template_buffer(vma, batches.size());
 			}
 
@@ -223,6 +255,7 @@ namespace SKENGINE_NAME_NS {
 		bool erase_objects_with_model(
 				ObjectStorage::Objects& objects,
 				ObjectStorage::ObjectUpdates& object_updates,
+				ObjectStorage::AnimatedObjects& animated_objects,
 				Logger& log,
 				ModelId id
 		) {
@@ -240,6 +273,7 @@ namespace SKENGINE_NAME_NS {
 			for(auto obj : rm_objects) {
 				objects.erase(obj);
 				object_updates.erase(obj);
+				animated_objects.erase(obj);
 			}
 			return ! rm_objects.empty();
 		}
@@ -306,10 +340,12 @@ namespace SKENGINE_NAME_NS {
 			Logger logger,
 			std::shared_ptr<WorldRendererSharedState> wrSharedState,
 			VmaAllocator vma,
+			CleanupQueue& cleanup_queue,
 			AssetSupplier& asset_supplier
 	) {
 		ObjectStorage r;
 		r.mVma    = vma;
+		r.mCleanupQueue = &cleanup_queue;
 		r.mLogger = std::move(logger);
 		r.mWrSharedState = std::move(wrSharedState);
 		r.mAssetSupplier = &asset_supplier;
@@ -321,12 +357,16 @@ namespace SKENGINE_NAME_NS {
 		r.mMatDpoolCapacity = 0;
 		r.mMatDpoolSize     = 0;
 		r.mDrawCount        = 0;
+		r.mInstanceSlotCount = 0;
+		r.mClusterDrawCount  = 0;
+		r.mGeometryBuffers    = asset_supplier.getGeometryArena().getBuffers();
 		r.mMatrixAssemblerRunning = false;
 		r.mBatchesNeedUpdate      = true;
 		r.mObjectsNeedRebuild     = true;
 		r.mObjectsNeedFlush       = true;
 		r.mObjectBuffer = create_object_buffer           (r.mVma, 1024 * OBJECT_MAP_INITIAL_CAPACITY_KB / sizeof(dev::Object));
 		r.mBatchBuffer  = create_draw_cmd_template_buffer(r.mVma, 1024 * BATCH_MAP_INITIAL_CAPACITY_KB  / sizeof(VkDrawIndexedIndirectCommand));
+		r.mClusterBuffer = create_cluster_draw_buffer   (r.mVma, 1024 * CLUSTER_BUFFER_INITIAL_CAPACITY_KB / sizeof(dev::ClusterDraw));
 
 		{ // Initialize the matrix assembler
 			r.mMatrixAssembler = std::make_shared<MatrixAssembler>();
@@ -345,9 +385,11 @@ namespace SKENGINE_NAME_NS {
 		r.clearObjects(transfCtx);
 		debug::destroyedBuffer(r.mBatchBuffer.first,  "indirect draw commands"); vkutil::Buffer::destroy(r.mVma, r.mBatchBuffer.first);
 		debug::destroyedBuffer(r.mObjectBuffer.first, "object instances");       vkutil::Buffer::destroy(r.mVma, r.mObjectBuffer.first);
+		debug::destroyedBuffer(r.mClusterBuffer.first, "cluster draws");         vkutil::Buffer::destroy(r.mVma, r.mClusterBuffer.first);
 
 		if(r.mMatDpool != nullptr) {
-			vkDestroyDescriptorPool(dev, r.mMatDpool, nullptr);
+			// Material dsets are freed through the cleanup queue, the pool must outlive them
+			r.mCleanupQueue->enqueue([dev, dpool = r.mMatDpool]() { vkDestroyDescriptorPool(dev, dpool, nullptr); });
 			r.mMatDpool = nullptr;
 		}
 
@@ -440,6 +482,7 @@ namespace SKENGINE_NAME_NS {
 		-- model_dep_counter_iter->second;
 		mObjects.erase(obj_iter);
 		mObjectUpdates.erase(id);
+		mAnimatedObjects.erase(id);
 
 		if(model_dep_counter_iter->second == 0) {
 			mModelDepCounters.erase(model_dep_counter_iter);
@@ -515,6 +558,29 @@ namespace SKENGINE_NAME_NS {
 	}
 
 
+	std::optional<ObjectStorage::ModifiableObject> ObjectStorage::animateObject(ObjectId id) noexcept {
+		auto found = mObjects.find(id);
+		if(found == mObjects.end()) return std::nullopt;
+		if(mAnimatedObjects.acquire(id)) mBatchesNeedUpdate = true;
+		mObjectsNeedFlush = true;
+		return ModifiableObject {
+			.bones = std::span<BoneInstance>(found->second.second),
+			.position_xyz  = found->second.first.position_xyz,
+			.direction_ypr = found->second.first.direction_ypr,
+			.scale_xyz     = found->second.first.scale_xyz,
+			.hidden        = found->second.first.hidden };
+	}
+
+
+	void ObjectStorage::stopAnimatingObject(ObjectId id) noexcept {
+		if(! mAnimatedObjects.release(id)) return;
+		// The last values written by the animation still need to be committed
+		mObjectUpdates.insert(id);
+		mBatchesNeedUpdate = true;
+		mObjectsNeedFlush  = true;
+	}
+
+
 	const ObjectStorage::ModelData* ObjectStorage::getModel(ModelId id) const noexcept {
 		auto found = mModels.find(id);
 		if(found == mModels.end()) return nullptr;
@@ -544,7 +610,7 @@ namespace SKENGINE_NAME_NS {
 
 	void ObjectStorage::eraseModel(TransferContext transfCtx, ModelId id) noexcept {
 		auto& model_data = assert_not_end_(mModels, id)->second;
-		if(erase_objects_with_model(mObjects, mObjectUpdates, mLogger, id)) {
+		if(erase_objects_with_model(mObjects, mObjectUpdates, mAnimatedObjects, mLogger, id)) {
 			mBatchesNeedUpdate = true;
 		}
 		eraseModelNoObjectCheck(transfCtx, id, model_data);
@@ -600,7 +666,7 @@ namespace SKENGINE_NAME_NS {
 		material_ins = mMaterials.insert(MaterialMap::value_type(id, { material, id, { } })).first;
 
 		create_mat_dset(
-			vmaGetAllocatorDevice(mVma),
+			vmaGetAllocatorDevice(mVma), *mCleanupQueue,
 			&mMatDpool, mWrSharedState->materialDsetLayout, &mMatDpoolSize, &mMatDpoolCapacity,
 			mMaterials, &material_ins->second );
 
@@ -619,7 +685,8 @@ namespace SKENGINE_NAME_NS {
 		}
 		#endif
 
-		VK_CHECK(vkFreeDescriptorSets, vmaGetAllocatorDevice(mVma), mMatDpool, 1, &mat_data.dset);
+		mCleanupQueue->enqueue([dev = vmaGetAllocatorDevice(mVma), dpool = mMatDpool, dset = mat_data.dset]() {
+			VK_CHECK(vkFreeDescriptorSets, dev, dpool, 1, &dset); });
 
 		mAssetSupplier->releaseMaterial(mat_data.id, transfCtx);
 		mMaterials.erase(id);
@@ -627,6 +694,15 @@ namespace SKENGINE_NAME_NS {
 
 
 	bool ObjectStorage::commitObjects(VkCommandBuffer cmd) {
+		SKENGINE_ZONE("ObjectStorage::commitObjects");
+
+		{ // Draw batches refer to ranges of the geometry arena, which may have been relocated
+			if(getGeometryArena().getGeneration() != mGeometryBuffers.generation) mBatchesNeedUpdate = true;
+		}
+
+		// Animated objects may have changed since the last commit, but the batches are the same
+		if(! mAnimatedObjects.empty()) mObjectsNeedFlush = true;
+
 		if(! (mBatchesNeedUpdate || mObjectsNeedRebuild || mObjectsNeedFlush )) {
 			return false; }
 
@@ -652,8 +728,7 @@ namespace SKENGINE_NAME_NS {
 				auto new_instance_count_ceil = std::bit_ceil(new_instance_count);
 				mObjectsNeedRebuild = true;
 				mObjectsNeedFlush   = true;
-				debug::destroyedBuffer(mObjectBuffer.first, "object instances");
-				vkutil::Buffer::destroy(mVma, mObjectBuffer.first);
+				retire_buffer(*mCleanupQueue, mVma, mObjectBuffer.first, "object instances");
 				mObjectBuffer = create_object_buffer(mVma, new_instance_count_ceil);
 			}
 		}
@@ -674,7 +749,7 @@ namespace SKENGINE_NAME_NS {
 			obj.visible = ! src_obj.first.hidden;
 			if(! obj.visible) return false;
 
-			if(! mObjectUpdates.contains(obj_id)) {
+			if(! (mObjectUpdates.contains(obj_id) || mAnimatedObjects.contains(obj_id))) {
 				if(! mObjectsNeedRebuild) return true;
 			}
 
@@ -684,6 +759,8 @@ namespace SKENGINE_NAME_NS {
 
 			obj.rnd       = dist(rng);
 			obj.color_mul = bone_instance.color_rgba;
+			obj.vtx_dequant_offset = glm::vec4(bone.mesh.vtx_dequant_offset, 0.0f);
+			obj.vtx_dequant_scale  = glm::vec4(bone.mesh.vtx_dequant_scale,  0.0f);
 
 			{ // Enqueue a matrix assembly job
 				MatrixAssembler::Job job;
@@ -722,30 +799,96 @@ namespace SKENGINE_NAME_NS {
 		};
 
 		if(mBatchesNeedUpdate || mObjectsNeedFlush) {
+			std::vector<dev::ClusterDraw> cluster_draws;
 			mDrawCount = 0;
-			for(uint32_t first_object = 0; auto& model_batches : mUnboundDrawBatches) {
+			mInstanceSlotCount = 0;
+
+			// Batches are sorted by vertex layout and material, so that the renderer
+			// can draw runs of them with as few state changes and draw calls as possible
+			struct BatchRef {
+				ModelId           model_id;
+				const ModelData*  model;
+				bone_id_e         bone_idx;
+				MaterialId        material_id;
+				UnboundDrawBatch* ubatch;
+			};
+			std::vector<BatchRef> batch_refs;
+			for(auto& model_batches : mUnboundDrawBatches) {
 				auto& model = assert_not_end_(mModels, model_batches.first)->second;
-				for(auto& bone_batches : model_batches.second) {
-					auto& bone = model.bones[bone_batches.first];
-					for(auto& ubatch : bone_batches.second) { // Create the (bound) draw batch
-						auto object_set_count = set_objects(ubatch.second, bone, first_object);
-						auto batch_idx = mDrawBatchList.size();
-						mDrawBatchList.push_back(DrawBatch {
-							.model_id       = model_batches.first,
-							.material_id    = ubatch.first,
-							.vertex_offset  = 0,
-							.index_count    = bone.mesh.index_count,
-							.first_index    = bone.mesh.first_index,
-							.instance_count = object_set_count.insert_count,
-							.first_instance = first_object });
-						auto& back = mDrawBatchList.back();
-						for(uint32_t i = 0; i < back.instance_count; ++i) {
-							objects[back.first_instance + i].draw_batch_idx = batch_idx;
-						}
-						first_object += object_set_count.insert_count;
-						mDrawCount   += object_set_count.insert_count;
-					}
+				for(auto& bone_batches : model_batches.second)
+				for(auto& ubatch       : bone_batches.second) {
+					batch_refs.push_back({ model_batches.first, &model, bone_batches.first, ubatch.first, &ubatch.second });
+				}
+			}
+			std::sort(batch_refs.begin(), batch_refs.end(), [](const BatchRef& l, const BatchRef& r) {
+				auto key = [](const BatchRef& b) { return std::tuple(b.model->compact_vertices, material_id_e(b.material_id), model_id_e(b.model_id), b.bone_idx); };
+				return key(l) < key(r);
+			});
+
+			// The offsets must belong to the same generation as the buffers that are drawn from,
+			// which may change (rarely) if a model is being loaded concurrently
+			auto& geometry = getGeometryArena();
+			std::vector<std::pair<uint32_t, uint32_t>> geometry_bases(batch_refs.size()); // Index base, vertex base
+			do {
+				mGeometryBuffers = geometry.getBuffers();
+				for(size_t i = 0; i < batch_refs.size(); ++i) geometry_bases[i] = {
+					geometry.getRange(batch_refs[i].model->indices).first,
+					geometry.getRange(batch_refs[i].model->vertices).first };
+			} while(geometry.getGeneration() != mGeometryBuffers.generation);
+
+			for(uint32_t first_object = 0, first_slot = 0, batch_ref_idx = 0; auto& batch_ref : batch_refs) {
+				auto& model = *batch_ref.model;
+				auto& bone  = model.bones[batch_ref.bone_idx];
+				auto [ index_base, vertex_base ] = geometry_bases[batch_ref_idx ++];
+				auto object_set_count = set_objects(*batch_ref.ubatch, bone, first_object);
+				auto batch_idx = mDrawBatchList.size();
+				auto lod_count = 1 + bone.mesh.lod_count;
+				auto lod_errors = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+				auto first_cluster_draw = uint32_t(cluster_draws.size());
+				auto cluster_draw_count = uint32_t(bone.mesh.clusters.size() * object_set_count.insert_count);
+				for(uint32_t lod = 0; lod < lod_count; ++lod) { // Create the (bound) draw batches, one per LOD
+					// Every LOD has room for all the instances, since the cull pass may pick any of them
+					auto range = (lod == 0)?
+						MeshLod { bone.mesh.index_count, bone.mesh.first_index, 0.0f } :
+						bone.mesh.lods[lod - 1];
+					if(lod > 0) lod_errors[lod - 1] = range.error;
+					mDrawBatchList.push_back(DrawBatch {
+						.model_id       = batch_ref.model_id,
+						.material_id    = batch_ref.material_id,
+						.vertex_offset  = vertex_base,
+						.index_count    = range.index_count,
+						.first_index    = index_base + range.first_index,
+						.instance_count = object_set_count.insert_count,
+						.first_instance = first_slot + (lod * object_set_count.insert_count),
+						.lod            = lod,
+						.lod_count      = lod_count,
+						.first_cluster_draw = first_cluster_draw,
+						.cluster_draw_count = cluster_draw_count,
+						.compact_vertices   = model.compact_vertices });
+				}
+				// Clustered objects get one more slot after the LODs', which the cull pass
+				// fills only when LOD 0 is picked, and all of their cluster draws refer to
+				auto first_cluster_slot = first_slot + (object_set_count.insert_count * lod_count);
+				bool clustered          = ! bone.mesh.clusters.empty();
+				for(uint32_t i = 0; i < object_set_count.insert_count; ++i) {
+					auto& obj = objects[first_object + i];
+					obj.draw_batch_idx = batch_idx;
+					obj.lod_count      = lod_count;
+					obj.lod_errors     = lod_errors;
+					obj.cluster_slot   = clustered? first_cluster_slot + i : dev::NO_CLUSTER_SLOT;
+					for(auto& cluster : bone.mesh.clusters) cluster_draws.push_back(dev::ClusterDraw {
+						.cull_sphere_xyzr = cluster.cull_sphere_xyzr,
+						.cone_axis_cutoff = cluster.cone_axis_cutoff,
+						.first_index      = index_base + cluster.first_index,
+						.index_count      = cluster.index_count,
+						.object_idx       = first_object + i,
+						.vertex_offset    = int32_t(vertex_base) });
 				}
+				auto slot_count = object_set_count.insert_count * (lod_count + (clustered? 1 : 0));
+				first_object += object_set_count.insert_count;
+				first_slot   += slot_count;
+				mDrawCount   += object_set_count.insert_count;
+				mInstanceSlotCount += slot_count;
 			}
 
 			{ // Wait for the matrix assembler
@@ -758,7 +901,19 @@ namespace SKENGINE_NAME_NS {
 			}
 
 			mObjectsNeedRebuild = false;
-			commit_draw_batches(mVma, mDrawBatchList, mBatchBuffer);
+			commit_draw_batches(mVma, *mCleanupQueue, mDrawBatchList, mBatchBuffer);
+
+			mClusterDrawCount = cluster_draws.size();
+			if(! cluster_draws.empty()) { // Upload the cluster draws, which only change along with the batches
+				size_t cluster_bytes = cluster_draws.size() * sizeof(dev::ClusterDraw);
+				if(cluster_bytes > mClusterBuffer.second) {
+					retire_buffer(*mCleanupQueue, mVma, mClusterBuffer.first, "cluster draws");
+					mClusterBuffer = create_cluster_draw_buffer(mVma, cluster_draws.size());
+				}
+				auto* dst = mClusterBuffer.first.map<dev::ClusterDraw>(mVma);
+				memcpy(dst, cluster_draws.data(), cluster_bytes);
+				mClusterBuffer.first.unmap(mVma);
+			}
 
 			{ // Barrier the buffer for outgoing transfer
 				VkBufferMemoryBarrier2 bar = { };
@@ -785,6 +940,7 @@ namespace SKENGINE_NAME_NS {
 
 
 	void ObjectStorage::waitUntilReady() {
+		SKENGINE_ZONE("ObjectStorage::waitUntilReady");
 		if(! mMatrixAssemblerRunning) return;
 		auto lock = std::unique_lock(mMatrixAssembler->mutex);
 		if(! mMatrixAssembler->queue.empty() /* `consume_cond` may have already been notified */) {
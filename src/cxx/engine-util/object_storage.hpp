@@ -2,11 +2,15 @@
 
 #include <engine/types.hpp>
 
+#include "animated_object_set.hpp"
+#include "geometry_arena.hpp"
+
 #include <vk-util/memory.hpp>
 
 #include <fmamdl/fmamdl.hpp>
 #include <fmamdl/material.hpp>
 
+#include <array>
 #include <unordered_set>
 #include <memory>
 #include <span>
@@ -50,7 +54,24 @@ namespace SKENGINE_NAME_NS {
 			ALIGNF32(1) std::float32_t rnd;
 			ALIGNI32(1) uint32_t draw_batch_idx;
 			ALIGNI32(1) bool     visible;
-			ALIGNI32(1) uint32_t padding[1];
+			ALIGNI32(1) uint32_t lod_count;
+			ALIGNF32(1) glm::vec4 vtx_dequant_offset;
+			ALIGNF32(1) glm::vec4 vtx_dequant_scale;
+			ALIGNF32(1) glm::vec4 lod_errors; // Error of LOD N+1, relative to the cull sphere radius
+			ALIGNI32(1) uint32_t  cluster_slot; // Instance slot of the object's cluster draws, or `NO_CLUSTER_SLOT`
+			ALIGNI32(1) uint32_t  padding[3];
+		};
+
+		constexpr uint32_t NO_CLUSTER_SLOT = ~ uint32_t(0);
+
+
+		struct ClusterDraw {
+			ALIGNF32(1) glm::vec4 cull_sphere_xyzr; // Object space
+			ALIGNF32(1) glm::vec4 cone_axis_cutoff; // Object space, see `fmamdl::Meshlet`
+			ALIGNI32(1) uint32_t  first_index;
+			ALIGNI32(1) uint32_t  index_count;
+			ALIGNI32(1) uint32_t  object_idx;
+			ALIGNI32(1) int32_t   vertex_offset; // Of the model's vertices in the geometry arena
 		};
 
 
@@ -141,10 +162,38 @@ namespace SKENGINE_NAME_NS {
 	};
 
 
+	/// Maximum number of levels of detail per mesh, including the full detail one.
+	///
+	constexpr uint32_t MAX_MESH_LODS = 4;
+
+
+	struct MeshLod {
+		uint32_t index_count;
+		uint32_t first_index;
+		float    error; // Relative to the radius of the cull sphere
+	};
+
+
+	/// A meshlet of the full detail level of a mesh, whose triangles
+	/// are stored in the index buffer as restart-terminated triplets.
+	///
+	struct MeshCluster {
+		glm::vec4 cull_sphere_xyzr;
+		glm::vec4 cone_axis_cutoff;
+		uint32_t  index_count;
+		uint32_t  first_index;
+	};
+
+
 	struct Mesh {
 		uint32_t index_count;
 		uint32_t first_index;
 		glm::vec4 cull_sphere_xyzr;
+		glm::vec3 vtx_dequant_offset; // Only used for compact vertices, see `fmamdl::VertexBounds`
+		glm::vec3 vtx_dequant_scale;
+		uint32_t  lod_count; // Number of simplified levels in `lods`, not including the mesh itself
+		std::array<MeshLod, MAX_MESH_LODS - 1> lods;
+		std::vector<MeshCluster> clusters; // If not empty, LOD 0 is drawn one culled cluster at a time
 	};
 
 
@@ -175,6 +224,11 @@ namespace SKENGINE_NAME_NS {
 		uint32_t   first_index;
 		uint32_t   instance_count;
 		uint32_t   first_instance;
+		uint32_t   lod;       // The batches of every LOD of a mesh are adjacent, starting from LOD 0
+		uint32_t   lod_count;
+		uint32_t   first_cluster_draw; // Cluster draws that replace LOD 0, for every instance
+		uint32_t   cluster_draw_count;
+		bool       compact_vertices;
 	};
 
 
@@ -196,12 +250,17 @@ namespace SKENGINE_NAME_NS {
 	struct BadObjectModelRefError { ModelId modelId; };
 
 
+	/// Mesh index ranges are relative to the model's index range, and
+	/// vertex indices to its vertex range, both allocated from the
+	/// AssetSupplier's geometry arena.
+	///
 	struct DevModel {
-		vkutil::BufferDuplex indices;
-		vkutil::BufferDuplex vertices;
-		std::vector<Bone>    bones;
+		GeometryRangeId   indices;
+		GeometryRangeId   vertices;
+		std::vector<Bone> bones;
 		uint32_t index_count;
 		uint32_t vertex_count;
+		bool     compact_vertices;
 	};
 
 
@@ -274,6 +333,8 @@ namespace SKENGINE_NAME_NS {
 
 		bool isInitialized() const noexcept { return as_initialized; }
 
+		const GeometryArena& getGeometryArena() const noexcept { return as_geometryArena; }
+
 	private:
 		Logger as_logger;
 		std::shared_ptr<AssetCacheInterface> as_cacheInterface;
@@ -283,6 +344,7 @@ namespace SKENGINE_NAME_NS {
 		Materials as_inactiveMaterials;
 		Material  as_fallbackMaterial;
 		MissingMaterials as_missingMaterials;
+		GeometryArena as_geometryArena;
 		float as_maxInactiveRatio;
 		bool as_initialized;
 		bool as_fallbackMaterialExists;
@@ -363,6 +425,7 @@ namespace SKENGINE_NAME_NS {
 		using MaterialMap       = Umap<MaterialId,       MaterialData>;
 		using Objects           = Umap<ObjectId,         std::pair<Object, std::vector<BoneInstance>>>;
 		using ObjectUpdates     = Uset<ObjectId>;
+		using AnimatedObjects   = AnimatedObjectSet<ObjectId>;
 		using UnboundBatchMap   = Umap<ModelId,          Umap<bone_id_e, Umap<MaterialId, UnboundDrawBatch>>>;
 		using ModelDepCounters  = Umap<ModelId,          object_id_e>;
 		using BatchList         = std::vector<DrawBatch>;
@@ -376,6 +439,7 @@ namespace SKENGINE_NAME_NS {
 			Logger,
 			std::shared_ptr<WorldRendererSharedState>,
 			VmaAllocator,
+			CleanupQueue&,
 			AssetSupplier& );
 
 		static void destroy(TransferContext, ObjectStorage&);
@@ -386,6 +450,17 @@ namespace SKENGINE_NAME_NS {
 		std::optional<ModifiableObject> modifyObject (ObjectId) noexcept;
 		std::optional<const Object*>    getObject    (ObjectId) const noexcept;
 
+		/// \brief Like `modifyObject`, but the object is considered modified on
+		///        every commit until `stopAnimatingObject` is called as many times.
+		///
+		/// The returned references remain valid until the object is removed,
+		/// so that an AnimTrack may write to them directly.
+		/// Draw batches are only rebuilt when an object starts or stops
+		/// being animated, not on every commit.
+		///
+		std::optional<ModifiableObject> animateObject       (ObjectId) noexcept;
+		void                            stopAnimatingObject (ObjectId) noexcept;
+
 		const ModelData* getModel  (ModelId) const noexcept;
 		void             eraseModel(TransferContext, ModelId) noexcept;
 
@@ -395,10 +470,15 @@ namespace SKENGINE_NAME_NS {
 
 		auto  getObjectCount       () const noexcept { return mObjects.size(); }
 		auto  getDrawCount         () const noexcept { return mDrawCount; }
+		auto  getInstanceSlotCount () const noexcept { return mInstanceSlotCount; } // Draw count times the LOD count of each draw, plus one slot per clustered draw
+		auto  getClusterDrawCount  () const noexcept { return mClusterDrawCount; }
 		auto  getDrawBatchCount    () const noexcept { return mDrawBatchList.size(); }
 		auto  getDrawBatches       () const noexcept { return std::span<const DrawBatch>(mDrawBatchList); };
 		auto& getObjectBuffer      () const noexcept { return mObjectBuffer.first; }
 		auto& getDrawCommandBuffer () const noexcept { return mBatchBuffer.first; }
+		auto& getClusterDrawBuffer () const noexcept { return mClusterBuffer.first; }
+		auto& getGeometryArena     () const noexcept { return mAssetSupplier->getGeometryArena(); }
+		auto& getGeometryBuffers   () const noexcept { return mGeometryBuffers; } // The ones the draw batches' offsets refer to
 
 		/// \brief Starts committing the objects to central memory, then to Vulkan buffers.
 		/// \returns `true` only if any command was recorded into the command buffer parameter.
@@ -414,6 +494,7 @@ namespace SKENGINE_NAME_NS {
 
 	private:
 		VmaAllocator mVma = nullptr;
+		CleanupQueue* mCleanupQueue;
 		Logger mLogger;
 		std::shared_ptr<WorldRendererSharedState> mWrSharedState;
 		AssetSupplier* mAssetSupplier;
@@ -422,6 +503,7 @@ namespace SKENGINE_NAME_NS {
 		MaterialMap      mMaterials;
 		Objects          mObjects;
 		ObjectUpdates    mObjectUpdates;
+		AnimatedObjects  mAnimatedObjects;
 		UnboundBatchMap  mUnboundDrawBatches;
 		BatchList        mDrawBatchList;
 		ModelDepCounters mModelDepCounters;
@@ -429,8 +511,12 @@ namespace SKENGINE_NAME_NS {
 		size_t           mMatDpoolSize;
 		size_t           mMatDpoolCapacity;
 		size_t           mDrawCount;
+		size_t           mInstanceSlotCount;
+		size_t           mClusterDrawCount;
+		GeometryArena::Buffers mGeometryBuffers; // Of the geometry arena, when the batches were last updated
 		std::pair<vkutil::Buffer, size_t> mObjectBuffer;
 		std::pair<vkutil::Buffer, size_t> mBatchBuffer;
+		std::pair<vkutil::Buffer, size_t> mClusterBuffer;
 
 		std::shared_ptr<MatrixAssembler> mMatrixAssembler;
 
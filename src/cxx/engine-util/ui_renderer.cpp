@@ -7,6 +7,8 @@
 
 #include <vk-util/error.hpp>
 
+#include <algorithm>
+#include <deque>
 #include <set>
 
 
@@ -31,26 +33,10 @@ namespace SKENGINE_NAME_NS {
 		#undef PI_
 
 
-		template <typename visit_fn_tp>
-		void visitUi(
-			ui::Canvas& canvas,
-			visit_fn_tp visitFn
-		) {
-			using DfsList = std::deque<std::pair<LotId, Lot*>>;
-			DfsList dfsQueue;
-
-			for(auto& lot : canvas.lots()) dfsQueue.emplace_back(lot.first, lot.second.get());
-
-			while(! dfsQueue.empty()) {
-				auto extracted = std::move(dfsQueue.back());
-				visitFn(extracted.first, *extracted.second);
-				dfsQueue.pop_back();
-				if(extracted.second->hasChildGrid()) {
-					auto child = extracted.second->childGrid();
-					for(auto& lot : child->lots()) dfsQueue.emplace_back(lot.first, lot.second.get());
-				}
-			}
-		}
+		// The draw jobs of a lot's own elements, kept until the lot is modified
+		struct LotDrawJobs : ui::LotRenderData {
+			std::vector<gui::DrawJob> jobs;
+		};
 
 
 		VkDescriptorSetLayout createDsetLayout(VkDevice dev) {
@@ -81,7 +67,9 @@ namespace SKENGINE_NAME_NS {
 
 	const UiRenderer::RdrParams UiRenderer::RdrParams::defaultParams = UiRenderer::RdrParams {
 		.fontLocation = "font.otf",
-		.fontMaxCacheSize = 512
+		.fontMaxCacheSize = 512,
+		.fontSdfBaseSize = 0,
+		.fontSdfSpread = 6
 	};
 
 
@@ -113,7 +101,9 @@ namespace SKENGINE_NAME_NS {
 		r.mState.rdrParams = std::move(rdrParams);
 		r.mState.pipelines = { };
 		r.mState.srcRtarget = idgen::invalidId<RenderTargetId>();
+		r.mState.uiExtent = { };
 		r.mState.initialized = true;
+		r.mState.invalidateUi = true;
 		auto dev = vmaGetAllocatorDevice(r.mState.vma);
 
 		{ // Init freetype
@@ -146,6 +136,8 @@ namespace SKENGINE_NAME_NS {
 			canvas->setColumnSizes ({ chBlank+wComp, wSize, chBlank+wComp });
 		}
 
+		r.mState.drawJobs = std::make_unique<gui::DrawJobSet>();
+
 		return r;
 	}
 
@@ -165,8 +157,11 @@ namespace SKENGINE_NAME_NS {
 
 		destroyDsetLayout(dev, r.mState.dsetLayout);
 
+		r.mState.textLayouts.clear();
+		r.mState.glyphShapes.clear();
 		r.mState.textCaches.clear();
 		r.mState.canvas = { };
+		r.mState.drawJobs = { };
 		FT_Done_FreeType(r.mState.freetype);
 
 		r.mState.initialized = false;
@@ -177,6 +172,7 @@ namespace SKENGINE_NAME_NS {
 		assert(mState.pipelines.polyLine == nullptr);
 		assert(mState.pipelines.polyFill == nullptr);
 		assert(mState.pipelines.text == nullptr);
+		assert(mState.pipelines.textSdf == nullptr);
 		auto dev = vmaGetAllocatorDevice(mState.vma);
 		PipelineSetCreateInfo pscInfo = {
 			.renderPass = ssInfo.rpass,
@@ -186,6 +182,7 @@ namespace SKENGINE_NAME_NS {
 			.polyDsetLayout = nullptr,
 			.textDsetLayout = mState.dsetLayout };
 		mState.pipelines = geom::PipelineSet::create(dev, pscInfo);
+		mState.invalidateUi = true; // Every draw job references the old pipelines
 	}
 
 
@@ -230,7 +227,7 @@ namespace SKENGINE_NAME_NS {
 			.uiRenderer = this,
 			.prepareCmdBuffer = cmd,
 			.drawCmdBuffer = nullptr,
-			.drawJobs = { } };
+			.drawJobs = nullptr };
 		ui::DrawContext uiCtx = { &guiCtx };
 
 		std::deque<std::tuple<LotId, Lot*, Element*>> repeatList;
@@ -297,37 +294,88 @@ namespace SKENGINE_NAME_NS {
 			vkCmdPipelineBarrier2(cmd, &imbDep);
 		}
 
-		ui::visitUi(*mState.canvas, [&](LotId lotId, Lot& lot) {
+		auto& canvas = *mState.canvas;
+		auto& presentExt = e.getPresentExtent();
+		if(presentExt.width != mState.uiExtent.width || presentExt.height != mState.uiExtent.height) {
+			mState.uiExtent = presentExt;
+			mState.invalidateUi = true;
+		}
+		if(mState.invalidateUi) {
+			canvas.invalidateLayout();
+			mState.invalidateUi = false;
+		}
+
+		auto prepareLot = [&](LotId lotId, Lot& lot) {
 			for(auto& elem : lot.elements()) {
 				auto ps = elem.second->ui_elem_prepareForDraw(lotId, lot, 0, uiCtx);
 				if(ps == ui::Element::PrepareState::eDefer) repeatList.push_back({ lotId, &lot, elem.second.get() });
 			}
-		});
+		};
 
-		while(! repeatList.empty()) {
-			for(auto& row : repeatList) {
-				auto ps = std::get<2>(row)->ui_elem_prepareForDraw(std::get<0>(row), *std::get<1>(row), repeatCount, uiCtx);
-				if(ps == ui::Element::PrepareState::eDefer) repeatListSwap.push_back(row);
+		auto repeatDeferred = [&]() {
+			repeatCount = 1;
+			while(! repeatList.empty()) {
+				for(auto& row : repeatList) {
+					auto ps = std::get<2>(row)->ui_elem_prepareForDraw(std::get<0>(row), *std::get<1>(row), repeatCount, uiCtx);
+					if(ps == ui::Element::PrepareState::eDefer) repeatListSwap.push_back(row);
+				}
+				repeatList = std::move(repeatListSwap);
+				++ repeatCount;
 			}
-			repeatList = std::move(repeatListSwap);
-			++ repeatCount;
+		};
+
+		auto sumRemapCounters = [&]() {
+			TextCache::update_counter_t r = 0;
+			for(auto& cache : mState.textCaches) r += cache.second.getRemapCounter();
+			return r;
+		};
+
+		// Only modified lots are prepared; if that remaps a text cache,
+		// the glyphs of the other lots move too, and everything is prepared again
+		auto remaps = sumRemapCounters();
+		ui::visitModifiedLots(canvas, prepareLot);
+		repeatDeferred();
+		if(sumRemapCounters() != remaps) {
+			canvas.invalidateLayout();
+			ui::visitLots(canvas, prepareLot);
+			repeatDeferred();
 		}
 	}
 
 
 	void UiRenderer::duringDrawStage(ConcurrentAccess& ca, const DrawInfo& drawInfo, VkCommandBuffer cmd) {
-		gui::DrawContext guiCtx = gui::DrawContext {
-			.magicNumber = gui::DrawContext::magicNumberValue,
-			.engine = &ca.engine(),
-			.uiRenderer = this,
-			.prepareCmdBuffer = nullptr,
-			.drawCmdBuffer = cmd,
-			.drawJobs = { } };
-		ui::DrawContext uiCtx = { &guiCtx };
-
-		ui::visitUi(*mState.canvas, [&](LotId lotId, Lot& lot) {
-			for(auto& elem : lot.elements()) elem.second->ui_elem_draw(lotId, lot, uiCtx);
-		});
+		auto& canvas   = *mState.canvas;
+		auto& drawJobs = *mState.drawJobs;
+
+		// An unmodified UI is drawn with the same, already sorted jobs as the last frame
+		if(canvas.isModified()) {
+			gui::DrawContext guiCtx = gui::DrawContext {
+				.magicNumber = gui::DrawContext::magicNumberValue,
+				.engine = &ca.engine(),
+				.uiRenderer = this,
+				.prepareCmdBuffer = nullptr,
+				.drawCmdBuffer = cmd,
+				.drawJobs = nullptr };
+			ui::DrawContext uiCtx = { &guiCtx };
+
+			drawJobs.clear();
+			ui::visitLots(canvas, [&](LotId lotId, Lot& lot) {
+				auto* lotJobs = static_cast<LotDrawJobs*>(lot.renderData());
+				if(lotJobs == nullptr) {
+					lot.renderData(std::make_unique<LotDrawJobs>());
+					lotJobs = static_cast<LotDrawJobs*>(lot.renderData());
+					assert(lot.isModified());
+				}
+				if(lot.isModified()) {
+					lotJobs->jobs.clear();
+					guiCtx.drawJobs = &lotJobs->jobs;
+					for(auto& elem : lot.elements()) elem.second->ui_elem_draw(lotId, lot, uiCtx);
+				}
+				for(auto& job : lotJobs->jobs) drawJobs.insert(job);
+			});
+			drawJobs.sort();
+			canvas.resetModified();
+		}
 
 		// The caches will need for this draw op to finish before preparing for the next one
 		// (unless they're up to date, in which case they won't do anything)
@@ -338,57 +386,40 @@ namespace SKENGINE_NAME_NS {
 		VkDescriptorSet        lastImageDset = nullptr;
 		VkPipelineLayout       geomPipelineLayout = mState.pipelineLayout;
 
-		// This lambda ladder turns what follows into something less indented:
-		//
-		//    for(auto&          jobPl : guiCtx.drawJobs) {
-		//       for(auto&       jobVs : jobPl.second) {
-		//          for(auto&    jobDs : jobVs.second) {
-		//             for(auto& job   : jobDs.second) { }
-		//          }
-		//       }
-		//    }
-		//
-		// Note that the JobPl->JobVs->JobDs order appears to be reversed, but it isn't.
-		using JobPl = gui::DrawJobSet::value_type;
-		using JobVs = gui::DrawJobVsSet::value_type;
-		using JobDs = gui::DrawJobDsetSet::value_type;
-		auto forEachJob = [&](gui::DrawJob& job) {
-			auto& shapeSet = *job.shapeSet;
-			VkBuffer vtx_buffers[] = { shapeSet.vertexBuffer(), shapeSet.vertexBuffer() };
-			VkDeviceSize offsets[] = { shapeSet.instanceCount() * sizeof(geom::Instance), 0 };
-			vkCmdPushConstants(cmd, geomPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(geom::PushConstant), &job.transform);
-			vkCmdBindVertexBuffers(cmd, 0, 2, vtx_buffers, offsets);
-			vkCmdDrawIndirect(cmd, shapeSet.drawIndirectBuffer(), 0, shapeSet.drawCmdCount(), sizeof(VkDrawIndirectCommand));
-		};
+		// Jobs that share a state are adjacent, so that the state only
+		// changes between runs; the states themselves are compared rather
+		// than the sort keys, whose fields may saturate
+		for(size_t i = 0; i < drawJobs.size(); ++i) {
+			auto& job = drawJobs[i];
 
-		auto forEachDs = [&](JobDs& jobDs) {
-			if(lastImageDset != jobDs.first) {
-				lastImageDset = jobDs.first;
-				if(lastImageDset != nullptr) {
-					vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, geomPipelineLayout, 0, 1, &lastImageDset, 0, nullptr);
-				}
+			if(lastPl != job.pipeline) {
+				lastPl = job.pipeline;
+				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, lastPl);
 			}
-			for(auto& job : jobDs.second) forEachJob(job);
-		};
 
-		auto forEachVs = [&](JobVs& jobVs) {
-			if(lastVs != &jobVs.first) {
-				lastVs = &jobVs.first;
+			if(lastVs == nullptr || ! (*lastVs == job.viewportScissor)) {
+				lastVs = &job.viewportScissor;
 				vkCmdSetViewport(cmd, 0, 1, &lastVs->viewport);
 				vkCmdSetScissor(cmd, 0, 1, &lastVs->scissor);
 			}
-			for(auto& jobDs : jobVs.second) forEachDs(jobDs);
-		};
 
-		auto forEachPl = [&](JobPl& jobPl) {
-			if(lastPl != jobPl.first) {
-				lastPl = jobPl.first;
-				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, lastPl);
+			if(lastImageDset != job.imageDset) {
+				lastImageDset = job.imageDset;
+				if(lastImageDset != nullptr) {
+					vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, geomPipelineLayout, 0, 1, &lastImageDset, 0, nullptr);
+				}
 			}
-			for(auto& jobVs : jobPl.second) forEachVs(jobVs);
-		};
 
-		for(auto& jobPl : guiCtx.drawJobs) forEachPl(jobPl);
+			// Shape instances may be modified without modifying their lot, whose
+			// elements are then not prepared: the commit is a no-op if nothing changed
+			auto& shapeSet = *job.shapeSet;
+			shapeSet.commitVkBuffers(mState.vma);
+			VkBuffer vtx_buffers[] = { shapeSet.vertexBuffer(), shapeSet.vertexBuffer() };
+			VkDeviceSize offsets[] = { shapeSet.instanceCount() * sizeof(geom::Instance), 0 };
+			vkCmdPushConstants(cmd, geomPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(geom::PushConstant), &job.transform);
+			vkCmdBindVertexBuffers(cmd, 0, 2, vtx_buffers, offsets);
+			vkCmdDrawIndirect(cmd, shapeSet.drawIndirectBuffer(), 0, shapeSet.drawCmdCount(), sizeof(VkDrawIndirectCommand));
+		}
 	}
 
 
@@ -416,6 +447,7 @@ namespace SKENGINE_NAME_NS {
 
 	void UiRenderer::afterPostRender(ConcurrentAccess&, const DrawInfo&) {
 		trimTextCaches(mState.rdrParams.fontMaxCacheSize);
+		mState.textLayouts.trim();
 	}
 
 
@@ -428,20 +460,77 @@ namespace SKENGINE_NAME_NS {
 		using Caches = decltype(mState.textCaches);
 		auto& caches = mState.textCaches;
 		auto dev = vmaGetAllocatorDevice(mState.vma);
+		unsigned short sdfSpread = 0;
+		if(mState.rdrParams.fontSdfBaseSize > 0) {
+			// Distance fields scale freely, the one cache is rasterized at the base size
+			size = mState.rdrParams.fontSdfBaseSize;
+			sdfSpread = std::max<unsigned short>(1, mState.rdrParams.fontSdfSpread);
+		}
 		auto found = caches.find(size);
 		if(found == caches.end()) {
 			found = caches.insert(Caches::value_type(size, TextCache(
 				dev, mState.vma,
 				mState.dsetLayout,
 				std::make_shared<FontFace>(createFontFace()),
-				size ))).first;
+				size, sdfSpread ))).first;
 		}
 		return found->second;
 	}
 
 
+	TextLayoutCache::LayoutPtr UiRenderer::getTextLayout(TextCache& cache, std::u32string_view str) {
+		FT_Face face = cache.fontFace()->ftFace();
+		TextLayoutCache::Kerning kerning;
+		if(FT_HAS_KERNING(face)) {
+			kerning = [face](codepoint_t l, codepoint_t r) {
+				FT_Vector k;
+				auto error = FT_Get_Kerning(face, FT_Get_Char_Index(face, l), FT_Get_Char_Index(face, r), FT_KERNING_UNSCALED, &k);
+				if(error) return 0.0f;
+				return float(k.x) / float(face->units_per_EM); // Character descriptors are relative to the EM size too
+			};
+		}
+		return mState.textLayouts.get(cache.fontFace().get(), cache.pixelHeight(), str, cache.getChars(), kerning);
+	}
+
+
+	Shape::Sptr UiRenderer::getGlyphShape(TextCache& cache, codepoint_t c) {
+		auto& glyphs = mState.glyphShapes[&cache];
+		if(glyphs.remapCounter != cache.getRemapCounter()) {
+			// The UVs of the cached characters changed
+			glyphs.shapes.clear();
+			glyphs.remapCounter = cache.getRemapCounter();
+		}
+
+		auto found = glyphs.shapes.find(c);
+		if(found != glyphs.shapes.end()) return found->second;
+
+		auto& charBounds = cache.getChars().find(c)->second;
+		float baselineToBottom = charBounds.size[1] - charBounds.baseline[1];
+		float u[2] = { charBounds.topLeftUv[0], charBounds.bottomRightUv[0] };
+		float v[2] = { charBounds.topLeftUv[1], charBounds.bottomRightUv[1] };
+		float x[2] = {
+			0.0f,
+			0.0f + (charBounds.size[0] * 2.0f) };
+		float height = charBounds.size[1] * 2.0f;
+		float y[2] = {
+			baselineToBottom +2.0f - height,
+			baselineToBottom +2.0f };
+		auto shape = std::make_shared<Shape>(std::vector<TextVertex> {
+			{{ x[0], y[0], 0.0f }, { u[0], v[0] }},
+			{{ x[0], y[1], 0.0f }, { u[0], v[1] }},
+			{{ x[1], y[1], 0.0f }, { u[1], v[1] }},
+			{{ x[1], y[0], 0.0f }, { u[1], v[0] }} });
+		glyphs.shapes.insert({ c, shape });
+		return shape;
+	}
+
+
 	void UiRenderer::trimTextCaches(codepoint_t maxCharCount) {
-		for(auto& ln : mState.textCaches) ln.second.trimChars(maxCharCount);
+		for(auto& ln : mState.textCaches) {
+			// Trimmed characters may belong to unmodified lines, which must fetch them again
+			if(maxCharCount < 1 || ln.second.getChars().size() > maxCharCount) mState.invalidateUi = true;
+			ln.second.trimChars(maxCharCount);
+		}
 	}
 
 
@@ -13,6 +13,8 @@ namespace SKENGINE_NAME_NS {
 
 	class GuiManager;
 
+	inline namespace gui { class DrawJobSet; }
+
 
 	struct FontRequirement {
 		unsigned short size;
@@ -38,6 +40,13 @@ namespace SKENGINE_NAME_NS {
 			static const RdrParams defaultParams;
 			std::string fontLocation;
 			uint32_t fontMaxCacheSize;
+			unsigned short fontSdfBaseSize; // If not zero, a single signed distance field cache rasterized at this size serves every font size
+			unsigned short fontSdfSpread;
+		};
+
+		struct GlyphShapes {
+			TextCache::update_counter_t remapCounter;
+			std::unordered_map<codepoint_t, Shape::Sptr> shapes;
 		};
 
 		struct GframeData {
@@ -63,6 +72,16 @@ namespace SKENGINE_NAME_NS {
 		FontFace createFontFace();
 		TextCache& getTextCache(unsigned short size);
 
+		/// \brief Returns the layout of a line of text, shared with all identical lines.
+		///
+		/// The characters of `str` must have been fetched by `cache`.
+		///
+		TextLayoutCache::LayoutPtr getTextLayout(TextCache& cache, std::u32string_view str);
+
+		/// \brief Returns the quad of a cached character, shared by all the lines that use it.
+		///
+		Shape::Sptr getGlyphShape(TextCache& cache, codepoint_t);
+
 		void trimTextCaches(codepoint_t maxCharCount);
 		void forgetTextCacheFences() noexcept;
 
@@ -80,14 +99,19 @@ namespace SKENGINE_NAME_NS {
 			std::shared_ptr<ShaderCacheInterface> shaderCache;
 			std::vector<GframeData> gframes;
 			std::unique_ptr<ui::Canvas> canvas;
+			std::unique_ptr<gui::DrawJobSet> drawJobs; // Reused from frame to frame, and as-is while the UI is unmodified
 			std::unordered_map<unsigned short, TextCache> textCaches;
+			std::unordered_map<const TextCache*, GlyphShapes> glyphShapes;
+			TextLayoutCache textLayouts;
 			VmaAllocator vma;
 			VkDescriptorSetLayout dsetLayout;
 			VkPipelineLayout pipelineLayout;
 			RenderTargetId srcRtarget;
 			geom::PipelineSet pipelines;
 			FT_Library freetype;
+			VkExtent2D uiExtent;
 			bool initialized : 1;
+			bool invalidateUi : 1; // Set when something that every element depends on changes, such as the pipelines
 		} mState;
 	};
 
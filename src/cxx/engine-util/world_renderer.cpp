@@ -8,6 +8,7 @@
 #include <atomic>
 #include <tuple>
 #include <concepts>
+#include <cmath>
 
 #include "atomic_id_gen.inl.hpp"
 
@@ -40,7 +41,8 @@ namespace SKENGINE_NAME_NS {
 			VkRenderPass,
 			VkPipelineCache,
 			VkPipelineLayout,
-			uint32_t subpass );
+			uint32_t subpass,
+			bool compact_vertices );
 
 		VkPipeline createCullPipeline(
 			VkDevice dev,
@@ -48,6 +50,12 @@ namespace SKENGINE_NAME_NS {
 			VkPipelineLayout plLayout,
 			const VkPhysicalDeviceProperties& phDevProps );
 
+		VkPipeline createClusterCullPipeline(
+			VkDevice dev,
+			VkPipelineCache plCache,
+			VkPipelineLayout plLayout,
+			const VkPhysicalDeviceProperties& phDevProps );
+
 	}
 
 
@@ -143,6 +151,17 @@ namespace SKENGINE_NAME_NS {
 			return { std::move(r), count };
 		}
 
+		std::pair<vkutil::Buffer, size_t> create_cluster_buffer(VmaAllocator vma, size_t count) {
+			vkutil::BufferCreateInfo bc_info = { };
+			bc_info.size  = std::bit_ceil(count) * sizeof(dev::ClusterDraw);
+			bc_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			vkutil::AllocationCreateInfo ac_info = { };
+			ac_info.requiredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			ac_info.vmaUsage         = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
+			auto r = vkutil::Buffer::create(vma, bc_info, ac_info);
+			return { std::move(r), count };
+		}
+
 		void resize_obj_buffer(VmaAllocator vma, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount) {
 			if(dst->second < requiredCmdCount) {
 				if(dst->first.value != nullptr) vkutil::Buffer::destroy(vma, dst->first);
@@ -164,6 +183,13 @@ namespace SKENGINE_NAME_NS {
 			}
 		}
 
+		void resize_cluster_buffer(VmaAllocator vma, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount) {
+			if(dst->second < requiredCmdCount) {
+				if(dst->first.value != nullptr) vkutil::Buffer::destroy(vma, dst->first);
+				*dst = create_cluster_buffer(vma, requiredCmdCount);
+			}
+		}
+
 	}
 
 
@@ -194,7 +220,7 @@ namespace SKENGINE_NAME_NS {
 					(gframeCount * 1 * objStgCount) },
 				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 					(gframeCount * 1) +
-					(gframeCount * 3 * objStgCount) } };
+					(gframeCount * 5 * objStgCount) } };
 
 			VkDescriptorPoolCreateInfo dpc_info = { };
 			dpc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -216,6 +242,7 @@ namespace SKENGINE_NAME_NS {
 
 			#define UL_ [[unlikely]]
 			if(params.shadeStepSmoothness < 0.0f) UL_ params.shadeStepSmoothness = -1.0f - (-1.0f / -(-1.0f + params.shadeStepSmoothness)); // Negative values (interval (-1, 0)) behave strangely
+			if(! std::isfinite(params.lodBias)) UL_ params.lodBias = 0.0f;
 			#undef UL_
 		}
 
@@ -238,6 +265,8 @@ namespace SKENGINE_NAME_NS {
 				vkutil::Buffer::destroy(vma, b.objBfCopy.first);
 				vkutil::Buffer::destroy(vma, b.objIdBfCopy.first);
 				vkutil::Buffer::destroy(vma, b.drawCmdBfCopy.first);
+				if(b.clusterBfCopy.first.value != nullptr) vkutil::Buffer::destroy(vma, b.clusterBfCopy.first);
+				if(b.clusterCmdBf.first.value  != nullptr) vkutil::Buffer::destroy(vma, b.clusterCmdBf.first);
 			}
 			vkutil::BufferDuplex::destroy(vma, gframeData.frameUbo);
 
@@ -260,6 +289,7 @@ namespace SKENGINE_NAME_NS {
 		.shadeStepSmoothness         = 0.0f,
 		.shadeStepExponent           = 1.0f,
 		.ditheringSteps              = 256.0f,
+		.lodBias                     = 0.0f,
 		.cullingEnabled              = true
 	};
 
@@ -342,12 +372,15 @@ namespace SKENGINE_NAME_NS {
 		for(auto pl : r.mState.rdrPipelines) {
 			if(pl != nullptr) vkDestroyPipeline(dev, pl, nullptr);
 		}
+		for(auto pl : r.mState.rdrCompactPipelines) {
+			if(pl != nullptr) vkDestroyPipeline(dev, pl, nullptr);
+		}
 		r.mState.initialized = false;
 	}
 
 
 	void WorldRenderer::initSharedState(VkDevice dev, WorldRendererSharedState& wrss) {
-		VkDescriptorSetLayoutBinding dslb[5];
+		VkDescriptorSetLayoutBinding dslb[6];
 		VkDescriptorSetLayoutCreateInfo dslc_info = { };
 		wrss = { }; // Zero-initialization is important in case of failure
 
@@ -368,10 +401,14 @@ namespace SKENGINE_NAME_NS {
 			dslb[3] = dslb[1];
 			dslb[3].binding = CULL_UBO_BINDING;
 			dslb[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			dslb[4] = dslb[1];
+			dslb[4].binding = CULL_CLUSTER_BINDING;
+			dslb[5] = dslb[1];
+			dslb[5].binding = CULL_CLUSTER_CMD_BINDING;
 			static_assert(CULL_OBJ_STG_BINDING    == RDR_OBJ_STG_BINDING);    // The same layout is reused between the two stages
 			static_assert(CULL_OBJ_ID_STG_BINDING == RDR_OBJ_ID_STG_BINDING); // ^^^
 
-			dslc_info.bindingCount = 4; assert(dslc_info.bindingCount <= std::size(dslb));
+			dslc_info.bindingCount = 6; assert(dslc_info.bindingCount <= std::size(dslb));
 			VK_CHECK(vkCreateDescriptorSetLayout, dev, &dslc_info, nullptr, &wrss.objDsetLayout);
 
 			dslb[0] = { };
@@ -438,15 +475,26 @@ namespace SKENGINE_NAME_NS {
 
 	void WorldRenderer::prepareSubpasses(const SubpassSetupInfo& ssInfo, VkPipelineCache plCache, ShaderCacheInterface* shCache) {
 		assert(mState.rdrPipelines.empty());
+		assert(mState.rdrCompactPipelines.empty());
 		mState.rdrPipelines.reserve(mState.pipelineParams.size() + 1);
+		mState.rdrCompactPipelines.reserve(mState.pipelineParams.size() + 1);
 		mState.cullPassPipeline = world::createCullPipeline(
 			vmaGetAllocatorDevice(vma()),
 			plCache, mState.sharedState->cullPassPipelineLayout, *ssInfo.phDevProps );
+		mState.clusterCullPassPipeline = world::createClusterCullPipeline(
+			vmaGetAllocatorDevice(vma()),
+			plCache, mState.sharedState->cullPassPipelineLayout, *ssInfo.phDevProps );
 		for(uint32_t subpassIdx = 0; auto& params : mState.pipelineParams) {
+			// Each subpass needs one pipeline per vertex layout, since models with either may be drawn in it
 			mState.rdrPipelines.push_back(world::create3dPipeline(
 				vmaGetAllocatorDevice(vma()),
 				*shCache, params,
-				ssInfo.rpass, plCache, mState.sharedState->rdrPipelineLayout, subpassIdx ++ ));
+				ssInfo.rpass, plCache, mState.sharedState->rdrPipelineLayout, subpassIdx, false ));
+			mState.rdrCompactPipelines.push_back(world::create3dPipeline(
+				vmaGetAllocatorDevice(vma()),
+				*shCache, params,
+				ssInfo.rpass, plCache, mState.sharedState->rdrPipelineLayout, subpassIdx, true ));
+			++ subpassIdx;
 		}
 	}
 
@@ -454,11 +502,17 @@ namespace SKENGINE_NAME_NS {
 	void WorldRenderer::forgetSubpasses(const SubpassSetupInfo&) {
 		auto dev = vmaGetAllocatorDevice(vma());
 		vkDestroyPipeline(dev, mState.cullPassPipeline, nullptr);
+		vkDestroyPipeline(dev, mState.clusterCullPassPipeline, nullptr);
 		for(auto& pl : mState.rdrPipelines) {
 			vkDestroyPipeline(dev, pl, nullptr);
 			pl = nullptr;
 		}
 		mState.rdrPipelines.clear();
+		for(auto& pl : mState.rdrCompactPipelines) {
+			vkDestroyPipeline(dev, pl, nullptr);
+			pl = nullptr;
+		}
+		mState.rdrCompactPipelines.clear();
 	}
 
 
@@ -496,8 +550,10 @@ namespace SKENGINE_NAME_NS {
 				wgf.osData.push_back({ });
 				auto& data = wgf.osData.back();
 				world::resize_obj_buffer     (vma, &data.objBfCopy,     os.getDrawCount());
-				world::resize_obj_id_buffer  (vma, &data.objIdBfCopy,   os.getDrawCount());
+				world::resize_obj_id_buffer  (vma, &data.objIdBfCopy,   os.getInstanceSlotCount());
 				world::resize_draw_cmd_buffer(vma, &data.drawCmdBfCopy, os.getDrawBatchCount());
+				world::resize_cluster_buffer (vma, &data.clusterBfCopy, os.getClusterDrawCount());
+				world::resize_draw_cmd_buffer(vma, &data.clusterCmdBf,  os.getClusterDrawCount());
 				data.cullPassUbo = world::create_cull_pass_ubo(vma);
 				++ i;
 			}
@@ -571,6 +627,7 @@ namespace SKENGINE_NAME_NS {
 		vkCmdSetScissor(cmd, 0, 1, &scissor);
 
 		VkDescriptorSet dsets[]  = { wgf.frameDset, { } };
+		uint32_t maxDrawIndirectCount = ca.engine().getPhysDeviceProperties().limits.maxDrawIndirectCount;
 		auto draw = [&](uint32_t subpassIdx) {
 			for(size_t osIdx = 0; auto& objStorage: objStorages) {
 				assert(osIdx < wgf.osData.size());
@@ -579,34 +636,82 @@ namespace SKENGINE_NAME_NS {
 
 				if(batches.empty()) continue;
 
-				ModelId    last_mdl = ModelId    (~ model_id_e    (batches.front().model_id));
-				MaterialId last_mat = MaterialId (~ material_id_e (batches.front().material_id));
 				constexpr VkDeviceSize zero[] = { 0 };
-				auto rdrPlLayout = mState.sharedState->rdrPipelineLayout;
+				auto  rdrPlLayout = mState.sharedState->rdrPipelineLayout;
+				auto& geometry    = objStorage.getGeometryBuffers();
+				using GeometryPool = GeometryArena::Pool;
 
 				assert(subpassIdx < mState.rdrPipelines.size());
+				assert(subpassIdx < mState.rdrCompactPipelines.size());
 				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mState.rdrPipelines[subpassIdx]);
 				vkCmdBindVertexBuffers(cmd, 1, 1, &gfOsData.objIdBfCopy.first.value, zero);
 				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, rdrPlLayout, RDR_OBJ_DSET_LOC, 1, &gfOsData.objDset, 0, nullptr);
-				for(VkDeviceSize batchIdx = 0; const auto& batch : batches) {
-					auto* model = objStorage.getModel(batch.model_id);
-					assert(model != nullptr);
-					if(batch.model_id != last_mdl) {
-						vkCmdBindIndexBuffer(cmd, model->indices.value, 0, VK_INDEX_TYPE_UINT32);
-						vkCmdBindVertexBuffers(cmd, 0, 1, &model->vertices.value, zero);
+				vkCmdBindIndexBuffer(cmd, geometry[GeometryPool::eIndices], 0, VK_INDEX_TYPE_UINT32);
+
+				// Every model shares the geometry arena, and batches are sorted by vertex layout and material:
+				// runs of adjacent batches that share both are drawn with one indirect draw (plus one for their clusters)
+				struct Run {
+					uint32_t first_cmd;
+					uint32_t cmd_count;
+					uint32_t first_cluster_draw;
+					uint32_t cluster_draw_count;
+				} run = { };
+				auto draw_indirect = [&](VkBuffer buffer, uint32_t first, uint32_t count) {
+					while(count > 0) {
+						uint32_t chunk = std::min(count, maxDrawIndirectCount);
+						vkCmdDrawIndexedIndirect(
+							cmd, buffer,
+							first * sizeof(VkDrawIndexedIndirectCommand), chunk,
+							sizeof(VkDrawIndexedIndirectCommand) );
+						first += chunk;
+						count -= chunk;
+					}
+				};
+				auto draw_run = [&]() {
+					draw_indirect(gfOsData.drawCmdBfCopy.first, run.first_cmd, run.cmd_count);
+					// Clustered instances that picked LOD 0 are drawn here instead; culled clusters have no instances
+					draw_indirect(gfOsData.clusterCmdBf.first, run.first_cluster_draw, run.cluster_draw_count);
+				};
+
+				bool       compact_bound = false;
+				bool       state_bound   = false;
+				MaterialId last_mat      = { };
+				for(uint32_t batchIdx = 0; const auto& batch : batches) {
+					if(batch.lod > 0) { // Drawn along with LOD 0
+						++ batchIdx;
+						continue;
 					}
-					if(batch.material_id != last_mat) {
-						auto mat = objStorage.getMaterial(batch.material_id);
-						assert(mat != nullptr);
-						dsets[RDR_MATERIAL_DSET_LOC] = mat->dset;
-						vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, rdrPlLayout, 0, std::size(dsets), dsets, 0, nullptr);
+					bool compact_changed  = batch.compact_vertices != compact_bound;
+					bool material_changed = batch.material_id != last_mat;
+					if(! state_bound || compact_changed || material_changed) {
+						draw_run();
+						run = { batchIdx, 0, batch.first_cluster_draw, 0 };
+						if(! state_bound || compact_changed) {
+							if(compact_changed) {
+								// Both pipelines share the layout, so bound descriptor sets stay valid
+								auto& pipelines = batch.compact_vertices? mState.rdrCompactPipelines : mState.rdrPipelines;
+								vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[subpassIdx]);
+							}
+							compact_bound = batch.compact_vertices;
+							VkBuffer vertices = geometry[compact_bound? GeometryPool::eCompactVertices : GeometryPool::eVertices];
+							vkCmdBindVertexBuffers(cmd, 0, 1, &vertices, zero);
+						}
+						if(! state_bound || material_changed) {
+							auto mat = objStorage.getMaterial(batch.material_id);
+							assert(mat != nullptr);
+							dsets[RDR_MATERIAL_DSET_LOC] = mat->dset;
+							vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, rdrPlLayout, 0, std::size(dsets), dsets, 0, nullptr);
+							last_mat = batch.material_id;
+						}
+						state_bound = true;
 					}
-					vkCmdDrawIndexedIndirect(
-						cmd, gfOsData.drawCmdBfCopy.first,
-						batchIdx * sizeof(VkDrawIndexedIndirectCommand), 1,
-						sizeof(VkDrawIndexedIndirectCommand) );
+					assert(run.first_cmd + run.cmd_count == batchIdx);
+					assert(run.first_cluster_draw + run.cluster_draw_count == batch.first_cluster_draw);
+					run.cmd_count          += batch.lod_count;
+					run.cluster_draw_count += batch.cluster_draw_count;
 					++ batchIdx;
 				}
+				draw_run();
 				++ osIdx;
 			}
 		};
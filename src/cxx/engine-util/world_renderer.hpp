@@ -30,7 +30,8 @@ namespace SKENGINE_NAME_NS {
 			ALIGNF32(4) glm::mat4      view_transf;
 			ALIGNF32(4) std::float32_t frustum_lrtb[4];
 			ALIGNF32(2) std::float32_t z_range[2];
-			ALIGNI32(2) uint32_t       padding0[2];
+			ALIGNF32(1) std::float32_t lod_scale; // Converts a view space distance to pixels, and accounts for the LOD bias
+			ALIGNI32(1) uint32_t       padding0[1];
 			ALIGNI32(1) bool           frustum_culling_enabled;
 			ALIGNI32(1) uint32_t       padding1[3];
 		};
@@ -67,6 +68,7 @@ namespace SKENGINE_NAME_NS {
 			std::float32_t shadeStepSmoothness;
 			std::float32_t shadeStepExponent;
 			std::float32_t ditheringSteps;
+			std::float32_t lodBias; // Positive values favor coarser levels of detail, each unit doubles the tolerated error
 			bool cullingEnabled;
 		};
 
@@ -125,6 +127,8 @@ namespace SKENGINE_NAME_NS {
 				std::pair<vkutil::Buffer, size_t> objBfCopy;
 				std::pair<vkutil::Buffer, size_t> objIdBfCopy;
 				std::pair<vkutil::Buffer, size_t> drawCmdBfCopy;
+				std::pair<vkutil::Buffer, size_t> clusterBfCopy;
+				std::pair<vkutil::Buffer, size_t> clusterCmdBf; // Written by the cluster cull pass
 				vkutil::BufferDuplex cullPassUbo;
 				VkDescriptorSet objDset;
 			};
@@ -158,6 +162,8 @@ namespace SKENGINE_NAME_NS {
 		static constexpr uint32_t CULL_OBJ_ID_STG_BINDING = 1;
 		static constexpr uint32_t CULL_CMD_BINDING = 2;
 		static constexpr uint32_t CULL_UBO_BINDING = 3;
+		static constexpr uint32_t CULL_CLUSTER_BINDING = 4;
+		static constexpr uint32_t CULL_CLUSTER_CMD_BINDING = 5;
 
 		template <typename K, typename V> using Umap = std::unordered_map<K, V>;
 		using RayLights   = Umap<ObjectId, RayLight>;
@@ -252,7 +258,9 @@ namespace SKENGINE_NAME_NS {
 			util::TransientArray<PipelineParameters> pipelineParams;
 			std::vector<GframeData> gframes;
 			std::vector<VkPipeline> rdrPipelines;
+			std::vector<VkPipeline> rdrCompactPipelines; // Same as `rdrPipelines`, for models with `fmamdl::CompactVertex`es
 			VkPipeline cullPassPipeline;
+			VkPipeline clusterCullPassPipeline;
 			RayLights    rayLights;
 			PointLights  pointLights;
 			LightStorage lightStorage;
@@ -30,6 +30,10 @@ namespace SKENGINE_NAME_NS::world {
 		// match the source code.
 		#include "world_renderer_pipeline_cull_shader.glsl.cpp"
 
+		// Same as above, for `constexpr const char* clusterCullCompShader`.
+		#include "world_renderer_pipeline_cluster_cull_shader.glsl.cpp"
+
+
 	}
 
 
@@ -49,7 +53,8 @@ namespace SKENGINE_NAME_NS::world {
 		VkRenderPass rpass,
 		VkPipelineCache plCache,
 		VkPipelineLayout plLayout,
-		uint32_t subpass
+		uint32_t subpass,
+		bool compact_vertices
 	) {
 		VkPipeline pipeline;
 		ShaderModuleSet shModules;
@@ -69,16 +74,26 @@ namespace SKENGINE_NAME_NS::world {
 				vtx_attr[I_].format   = F_; \
 				vtx_attr[I_].location = L_; \
 				vtx_attr[I_].offset   = O_; }
-			ATTRIB_(V_POS, 0, VK_FORMAT_R32G32B32_SFLOAT, 0, offsetof(fmamdl::Vertex, position))
-			ATTRIB_(V_TEX, 0, VK_FORMAT_R32G32_SFLOAT,    1, offsetof(fmamdl::Vertex, texture))
-			ATTRIB_(V_NRM, 0, VK_FORMAT_R32G32B32_SFLOAT, 2, offsetof(fmamdl::Vertex, normal))
-			ATTRIB_(V_TNU, 0, VK_FORMAT_R32G32B32_SFLOAT, 3, offsetof(fmamdl::Vertex, tangent))
-			ATTRIB_(V_TNV, 0, VK_FORMAT_R32G32B32_SFLOAT, 4, offsetof(fmamdl::Vertex, bitangent))
-			ATTRIB_(I_OID, 1, VK_FORMAT_R32_UINT,         5, offsetof(dev::ObjectId,  id))
+			if(compact_vertices) {
+				// The shader decodes these; the bi-tangent is derived from the sign in the
+				// position's W component, so location 4 only aliases the position
+				ATTRIB_(V_POS, 0, VK_FORMAT_R16G16B16A16_UNORM, 0, offsetof(fmamdl::CompactVertex, position))
+				ATTRIB_(V_TEX, 0, VK_FORMAT_R16G16_SFLOAT,      1, offsetof(fmamdl::CompactVertex, texture))
+				ATTRIB_(V_NRM, 0, VK_FORMAT_R16G16_SNORM,       2, offsetof(fmamdl::CompactVertex, normal))
+				ATTRIB_(V_TNU, 0, VK_FORMAT_R16G16_SNORM,       3, offsetof(fmamdl::CompactVertex, tangent))
+				ATTRIB_(V_TNV, 0, VK_FORMAT_R16G16B16A16_UNORM, 4, offsetof(fmamdl::CompactVertex, position))
+			} else {
+				ATTRIB_(V_POS, 0, VK_FORMAT_R32G32B32_SFLOAT, 0, offsetof(fmamdl::Vertex, position))
+				ATTRIB_(V_TEX, 0, VK_FORMAT_R32G32_SFLOAT,    1, offsetof(fmamdl::Vertex, texture))
+				ATTRIB_(V_NRM, 0, VK_FORMAT_R32G32B32_SFLOAT, 2, offsetof(fmamdl::Vertex, normal))
+				ATTRIB_(V_TNU, 0, VK_FORMAT_R32G32B32_SFLOAT, 3, offsetof(fmamdl::Vertex, tangent))
+				ATTRIB_(V_TNV, 0, VK_FORMAT_R32G32B32_SFLOAT, 4, offsetof(fmamdl::Vertex, bitangent))
+			}
+			ATTRIB_(I_OID, 1, VK_FORMAT_R32_UINT, 5, offsetof(dev::ObjectId, id))
 			#undef ATTRIB_
 			vtx_bind[0].binding   = 0;
 			vtx_bind[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-			vtx_bind[0].stride    = sizeof(fmamdl::Vertex);
+			vtx_bind[0].stride    = compact_vertices? sizeof(fmamdl::CompactVertex) : sizeof(fmamdl::Vertex);
 			vtx_bind[1].binding   = 1;
 			vtx_bind[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 			vtx_bind[1].stride    = sizeof(dev::ObjectId);
@@ -159,6 +174,15 @@ namespace SKENGINE_NAME_NS::world {
 			d.pDynamicStates    = states;
 		}
 
+		// Vertex shaders that do not declare the constant ignore it, and can only draw float vertices
+		VkBool32 vtx_spec_compact = compact_vertices;
+		VkSpecializationMapEntry vtx_spec_entry = { .constantID = 0, .offset = 0, .size = sizeof(VkBool32) };
+		VkSpecializationInfo vtx_spec = { };
+		vtx_spec.mapEntryCount = 1;
+		vtx_spec.pMapEntries   = &vtx_spec_entry;
+		vtx_spec.dataSize      = sizeof(VkBool32);
+		vtx_spec.pData         = &vtx_spec_compact;
+
 		VkPipelineShaderStageCreateInfo stages[2]; {
 			constexpr size_t VTX = 0;
 			constexpr size_t FRG = 1;
@@ -171,6 +195,7 @@ namespace SKENGINE_NAME_NS::world {
 			stages[FRG] = stages[VTX];
 			stages[FRG].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
 			stages[FRG].module = shModules.fragment;
+			stages[VTX].pSpecializationInfo = &vtx_spec;
 		}
 
 		VkGraphicsPipelineCreateInfo gpc_info = { };
@@ -202,54 +227,80 @@ namespace SKENGINE_NAME_NS::world {
 	}
 
 
+	namespace {
+
+		VkPipeline create_compute_pipeline(
+			VkDevice dev,
+			VkPipelineCache plCache,
+			VkPipelineLayout plLayout,
+			const VkPhysicalDeviceProperties& phDevProps,
+			const char* shaderName,
+			const char* shaderSrc
+		) {
+			VkPipeline pipeline;
+
+			#define SPEC_ENTRY_A_(ID_, MEM_, IDX_) ( \
+				VkSpecializationMapEntry { \
+					.constantID = ID_, \
+					.offset     = offsetof(PipelineConstants, MEM_) + (IDX_ * sizeof(*PipelineConstants::MEM_)), \
+					.size       = sizeof(*PipelineConstants::MEM_) } \
+			)
+			VkSpecializationInfo     sInfo   = { };
+			VkSpecializationMapEntry specMapEntries[] = {
+				SPEC_ENTRY_A_(0, localWorkgroupSizes, 0),
+				SPEC_ENTRY_A_(1, localWorkgroupSizes, 1),
+				SPEC_ENTRY_A_(2, localWorkgroupSizes, 2) };
+			#undef SPEC_ENTRY_A_
+
+			VkComputePipelineCreateInfo cpcInfo = { };
+			cpcInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			cpcInfo.layout = plLayout;
+
+			PipelineConstants plConstants = { };
+			computeCullWorkgroupSizes(plConstants.localWorkgroupSizes, phDevProps);
+
+			auto shModule = ShaderCompiler::glslSourceToModule(dev, shaderName, shaderSrc, shaderc_compute_shader);
+			cpcInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			cpcInfo.stage.pName  = "main";
+			cpcInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+			cpcInfo.stage.module = shModule;
+			cpcInfo.stage.pSpecializationInfo = &sInfo;
+			sInfo.pData         = &plConstants;
+			sInfo.dataSize      = sizeof(PipelineConstants);
+			sInfo.pMapEntries   = specMapEntries;
+			sInfo.mapEntryCount = std::size(specMapEntries);
+
+			try {
+				VK_CHECK(vkCreateComputePipelines, dev, plCache, 1, &cpcInfo, nullptr, &pipeline);
+				vkDestroyShaderModule(dev, shModule, nullptr);
+			} catch(...) {
+				vkDestroyShaderModule(dev, shModule, nullptr);
+				std::rethrow_exception(std::current_exception());
+			}
+
+			return pipeline;
+		}
+
+	}
+
+
 	VkPipeline createCullPipeline(
 		VkDevice dev,
 		VkPipelineCache plCache,
 		VkPipelineLayout plLayout,
 		const VkPhysicalDeviceProperties& phDevProps
 	) {
-		VkPipeline pipeline;
-
-		#define SPEC_ENTRY_A_(ID_, MEM_, IDX_) ( \
-			VkSpecializationMapEntry { \
-				.constantID = ID_, \
-				.offset     = offsetof(PipelineConstants, MEM_) + (IDX_ * sizeof(*PipelineConstants::MEM_)), \
-				.size       = sizeof(*PipelineConstants::MEM_) } \
-		)
-		VkSpecializationInfo     sInfo   = { };
-		VkSpecializationMapEntry specMapEntries[] = {
-			SPEC_ENTRY_A_(0, localWorkgroupSizes, 0),
-			SPEC_ENTRY_A_(1, localWorkgroupSizes, 1),
-			SPEC_ENTRY_A_(2, localWorkgroupSizes, 2) };
-		#undef SPEC_ENTRY_A_
-
-		VkComputePipelineCreateInfo cpcInfo = { };
-		cpcInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		cpcInfo.layout = plLayout;
-
-		PipelineConstants plConstants = { };
-		computeCullWorkgroupSizes(plConstants.localWorkgroupSizes, phDevProps);
-
-		auto shModule = ShaderCompiler::glslSourceToModule(dev, "wrdr:cull", cullCompShader, shaderc_compute_shader);
-		cpcInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		cpcInfo.stage.pName  = "main";
-		cpcInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
-		cpcInfo.stage.module = shModule;
-		cpcInfo.stage.pSpecializationInfo = &sInfo;
-		sInfo.pData         = &plConstants;
-		sInfo.dataSize      = sizeof(PipelineConstants);
-		sInfo.pMapEntries   = specMapEntries;
-		sInfo.mapEntryCount = std::size(specMapEntries);
+		return create_compute_pipeline(dev, plCache, plLayout, phDevProps, "wrdr:cull", cullCompShader);
+	}
 
-		try {
-			VK_CHECK(vkCreateComputePipelines, dev, plCache, 1, &cpcInfo, nullptr, &pipeline);
-			vkDestroyShaderModule(dev, shModule, nullptr);
-		} catch(...) {
-			vkDestroyShaderModule(dev, shModule, nullptr);
-			std::rethrow_exception(std::current_exception());
-		}
 
-		return pipeline;
+	VkPipeline createClusterCullPipeline(
+		VkDevice dev,
+		VkPipelineCache plCache,
+		VkPipelineLayout plLayout,
+		const VkPhysicalDeviceProperties& phDevProps
+	) {
+		return create_compute_pipeline(dev, plCache, plLayout, phDevProps, "wrdr:cluster-cull", clusterCullCompShader);
 	}
 
 }
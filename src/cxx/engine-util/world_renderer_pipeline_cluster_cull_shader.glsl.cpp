@@ -0,0 +1,108 @@
+constexpr const char* clusterCullCompShader = "#version 460\n"
+"\n"
+"layout(constant_id = 0) const uint LOCAL_SIZE_X = 16;\n"
+"layout(constant_id = 1) const uint LOCAL_SIZE_Y = 1;\n"
+"layout(constant_id = 2) const uint LOCAL_SIZE_Z = 1;\n"
+"\n"
+"layout(\n"
+	"local_size_x_id = 0,\n"
+	"local_size_y_id = 1,\n"
+	"local_size_z_id = 2\n"
+") in;\n"
+"\n"
+"layout(push_constant) uniform constants {\n"
+	"uint clusterDrawCount;\n"
+"} pc;\n"
+"\n"
+"struct Object {\n"
+	"mat4  model_transf;\n"
+	"vec4  color_mul;\n"
+	"vec4  cull_sphere_xyzr;\n"
+	"float rnd;\n"
+	"uint  draw_batch_idx;\n"
+	"bool  visible;\n"
+	"uint  lod_count;\n"
+	"vec4  vtx_dequant_offset;\n"
+	"vec4  vtx_dequant_scale;\n"
+	"vec4  lod_errors;\n"
+	"uint  cluster_slot;\n"
+"};\n"
+"\n"
+"struct ClusterDraw {\n"
+	"vec4 cull_sphere_xyzr;\n"
+	"vec4 cone_axis_cutoff;\n"
+	"uint first_index;\n"
+	"uint index_count;\n"
+	"uint object_idx;\n"
+	"int  vertex_offset;\n"
+"};\n"
+"\n"
+"struct DrawCmd {\n"
+	"uint indexCount;\n"
+	"uint instanceCount;\n"
+	"uint firstIndex;\n"
+	"int  vertexOffset;\n"
+	"uint firstInstance;\n"
+"};\n"
+"\n"
+"layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer {\n"
+	"Object p[];\n"
+"} obj_buffer;\n"
+"layout(std430, set = 0, binding = 1) readonly buffer ObjectIdBuffer {\n"
+	"uint p[];\n"
+"} obj_id_buffer;\n"
+"\n"
+"layout(std140, set = 0, binding = 3) uniform CullPassUbo {\n"
+	"mat4 view_transf;\n"
+	"vec4 frustum_lrtb;\n"
+	"vec2  z_near_far;\n"
+	"float lod_scale;\n"
+	"float unused0;\n"
+	"bool frustum_culling_enabled;\n"
+"} cull_pass_ubo;\n"
+"\n"
+"layout(std430, set = 0, binding = 4) readonly buffer ClusterDrawBuffer {\n"
+	"ClusterDraw p[];\n"
+"} cluster_buffer;\n"
+"layout(std430, set = 0, binding = 5) writeonly buffer ClusterCmdBuffer {\n"
+	"DrawCmd p[];\n"
+"} cluster_cmd_buffer;\n"
+"\n"
+"bool isVisible(ClusterDraw cl, mat4 model_transf) {\n"
+	"if(! cull_pass_ubo.frustum_culling_enabled) return true;\n"
+	"float z_near = cull_pass_ubo.z_near_far[0];\n"
+	"float z_far  = cull_pass_ubo.z_near_far[1];\n"
+	"mat4  view_model = cull_pass_ubo.view_transf * model_transf;\n"
+	"\n" // Same frustum test as the object cull pass, with the sphere scaled by the largest axis
+	"float scale = max(length(model_transf[0].xyz), max(length(model_transf[1].xyz), length(model_transf[2].xyz)));\n"
+	"vec4  sph   = vec4((view_model * vec4(cl.cull_sphere_xyzr.xyz, 1.0)).xyz, cl.cull_sphere_xyzr.w * scale);\n"
+	"bool  r =\n"
+		"(((sph.z * cull_pass_ubo.frustum_lrtb[1]) - (abs(sph.x) * cull_pass_ubo.frustum_lrtb[0])) > -sph.w)\n"
+		"&& (((sph.z * cull_pass_ubo.frustum_lrtb[3]) - (abs(sph.y) * cull_pass_ubo.frustum_lrtb[2])) > -sph.w)\n"
+		"&& ((-sph.z + sph.w) > z_near)\n"
+		"&& ((-sph.z - sph.w) < z_far);\n"
+	"\n" // Backface cone test, in object space; affine transforms preserve facing unless they mirror
+	"vec4 cone = cl.cone_axis_cutoff;\n"
+	"if(r && cone.w < 1.0 && determinant(mat3(model_transf)) > 0.0) {\n"
+		"vec3 view_pos = (inverse(view_model) * vec4(0.0, 0.0, 0.0, 1.0)).xyz;\n"
+		"vec3 d = cl.cull_sphere_xyzr.xyz - view_pos;\n"
+		"r = dot(d, cone.xyz) < (cone.w * length(d)) + cl.cull_sphere_xyzr.w;\n"
+	"}\n"
+	"return r;\n"
+"}\n"
+"\n"
+"void main() {\n"
+	"uint invocId = gl_GlobalInvocationID.x;\n"
+	"if(invocId < pc.clusterDrawCount) {\n"
+		"ClusterDraw cl = cluster_buffer.p[invocId];\n"
+		"uint objIdx = cl.object_idx;\n"
+		"uint slot   = obj_buffer.p[objIdx].cluster_slot;\n"
+		"\n" // The object cull pass only fills the slot if the object is visible at LOD 0
+		"bool visible = (obj_id_buffer.p[slot] == objIdx) && isVisible(cl, obj_buffer.p[objIdx].model_transf);\n"
+		"cluster_cmd_buffer.p[invocId].indexCount    = cl.index_count;\n"
+		"cluster_cmd_buffer.p[invocId].instanceCount = visible? 1u : 0u;\n"
+		"cluster_cmd_buffer.p[invocId].firstIndex    = cl.first_index;\n"
+		"cluster_cmd_buffer.p[invocId].vertexOffset  = cl.vertex_offset;\n"
+		"cluster_cmd_buffer.p[invocId].firstInstance = slot;\n"
+	"}\n"
+"}\n";
@@ -21,9 +21,15 @@ constexpr const char* cullCompShader = "#version 460\n" // https://vkguide.dev/d
 	"float rnd;\n"
 	"uint  draw_batch_idx;\n"
 	"bool  visible;\n"
-	"uint  unused1;\n"
+	"uint  lod_count;\n"
+	"vec4  vtx_dequant_offset;\n"
+	"vec4  vtx_dequant_scale;\n"
+	"vec4  lod_errors;\n"
+	"uint  cluster_slot;\n"
 "};\n"
 "\n"
+"const uint NO_CLUSTER_SLOT = 0xffffffffu;\n"
+"\n"
 "struct DrawBatch {\n"
 	"uint indexCount;\n"
 	"uint instanceCount;\n"
@@ -45,7 +51,9 @@ constexpr const char* cullCompShader = "#version 460\n" // https://vkguide.dev/d
 "layout(std140, set = 0, binding = 3) uniform CullPassUbo {\n"
 	"mat4 view_transf;\n"
 	"vec4 frustum_lrtb;\n"
-	"vec4 z_near_far;\n"
+	"vec2  z_near_far;\n"
+	"float lod_scale;\n"
+	"float unused0;\n"
 	"bool frustum_culling_enabled;\n"
 "} cull_pass_ubo;\n"
 "\n"
@@ -65,13 +73,33 @@ constexpr const char* cullCompShader = "#version 460\n" // https://vkguide.dev/d
 	"return r;\n"
 "}\n"
 "\n"
+"uint selectLod(uint idx) {\n"
+	"\n" // The coarsest LOD whose error, projected from the nearest point of the cull sphere, is within one pixel
+	"uint lod_count = obj_buffer.p[idx].lod_count;\n"
+	"if(lod_count <= 1) return 0;\n"
+	"vec4 sph = obj_buffer.p[idx].cull_sphere_xyzr;\n"
+	"float dist = max(-(cull_pass_ubo.view_transf * vec4(sph.xyz, 1.0)).z - sph.w, cull_pass_ubo.z_near_far[0]);\n"
+	"float err_scale = sph.w * cull_pass_ubo.lod_scale / dist;\n"
+	"uint lod = 0;\n"
+	"for(uint i = 1; i < lod_count; ++i) {\n"
+		"if(obj_buffer.p[idx].lod_errors[i-1] * err_scale > 1.0) break;\n"
+		"lod = i;\n"
+	"}\n"
+	"return lod;\n"
+"}\n"
+"\n"
 "void main() {\n"
 	"uint invocId = gl_GlobalInvocationID.x;\n"
 	"if(invocId < pc.objCount) {\n"
 		"uint objIdx = invocId;\n"
 		"bool visible = isVisible(objIdx);\n"
-		"if(visible) {\n"
-			"uint batchIdx = obj_buffer.p[invocId].draw_batch_idx;\n"
+		"uint lod = visible? selectLod(objIdx) : 0u;\n"
+		"\n" // Clustered objects at LOD 0 are drawn by the cluster cull pass, which checks their slot
+		"uint clusterSlot = obj_buffer.p[objIdx].cluster_slot;\n"
+		"bool clustered = visible && (lod == 0) && (clusterSlot != NO_CLUSTER_SLOT);\n"
+		"if(clusterSlot != NO_CLUSTER_SLOT) obj_id_buffer.p[clusterSlot] = clustered? objIdx : NO_CLUSTER_SLOT;\n"
+		"if(visible && ! clustered) {\n"
+			"uint batchIdx = obj_buffer.p[invocId].draw_batch_idx + lod;\n"
 			"uint insertAt = atomicAdd(draw_batch_buffer.p[batchIdx].instanceCount, 1);\n"
 			"uint instIdx = draw_batch_buffer.p[batchIdx].firstInstance + insertAt;\n"
 			"obj_id_buffer.p[instIdx] = objIdx;\n"
@@ -2,7 +2,10 @@
 
 #include <engine/engine.hpp>
 
+#include <zone-profiler/zone_profiler.hpp>
+
 #include <random>
+#include <cmath>
 
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
@@ -25,6 +28,7 @@ namespace SKENGINE_NAME_NS {
 		void resize_obj_buffer(VmaAllocator, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount);
 		void resize_obj_id_buffer(VmaAllocator, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount);
 		void resize_draw_cmd_buffer(VmaAllocator, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount);
+		void resize_cluster_buffer(VmaAllocator, std::pair<vkutil::Buffer, size_t>* dst, size_t requiredCmdCount);
 
 	}
 
@@ -100,6 +104,7 @@ namespace SKENGINE_NAME_NS {
 
 
 		glm::mat4 proj_transf_transp = glm::transpose(ubo.proj_transf);
+		float lodScale = std::abs(ubo.proj_transf[1][1]) * float(renderExtent.height) * 0.5f * std::exp2(-mState.params.lodBias);
 		for(size_t osIdx = 0; auto& os : objStorages) {
 			auto& osData = wgf.osData[osIdx];
 			auto* cullPassUbo = osData.cullPassUbo.mappedPtr<dev::CullPassUbo>();
@@ -113,6 +118,7 @@ namespace SKENGINE_NAME_NS {
 				.view_transf = ubo.view_transf,
 				.frustum_lrtb = { frustumX.x, frustumX.z, frustumY.y, frustumY.z },
 				.z_range = { mState.params.zNear, mState.params.zFar },
+				.lod_scale = lodScale,
 				.padding0 = { },
 				.frustum_culling_enabled = mState.params.cullingEnabled,
 				.padding1 = { } };
@@ -170,12 +176,16 @@ namespace SKENGINE_NAME_NS {
 			for(size_t osIdx = 0; auto& os : objStorages) {
 				auto& gfOsData = wgf.osData[osIdx];
 				size_t objBytes   = os.getDrawCount()      * sizeof(dev::Object);
-				size_t objIdBytes = os.getDrawCount()      * sizeof(dev::ObjectId);
+				size_t objIdBytes = os.getInstanceSlotCount() * sizeof(dev::ObjectId);
 				size_t cmdBytes   = os.getDrawBatchCount() * sizeof(VkDrawIndexedIndirectCommand);
 				world::resize_obj_buffer     (vma, &gfOsData.objBfCopy,     os.getDrawCount());
-				world::resize_obj_id_buffer  (vma, &gfOsData.objIdBfCopy,   os.getDrawCount());
+				world::resize_obj_id_buffer  (vma, &gfOsData.objIdBfCopy,   os.getInstanceSlotCount());
 				world::resize_draw_cmd_buffer(vma, &gfOsData.drawCmdBfCopy, os.getDrawBatchCount());
-				VkBufferMemoryBarrier2 bars[2] = { };
+				world::resize_cluster_buffer (vma, &gfOsData.clusterBfCopy, os.getClusterDrawCount());
+				world::resize_draw_cmd_buffer(vma, &gfOsData.clusterCmdBf,  os.getClusterDrawCount());
+				size_t clusterBytes    = os.getClusterDrawCount() * sizeof(dev::ClusterDraw);
+				size_t clusterCmdBytes = os.getClusterDrawCount() * sizeof(VkDrawIndexedIndirectCommand);
+				VkBufferMemoryBarrier2 bars[3] = { };
 				bars[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
 				bars[0].buffer = gfOsData.objBfCopy.first; bars[0].size = objBytes;
 				bars[0].srcStageMask  = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
@@ -188,9 +198,13 @@ namespace SKENGINE_NAME_NS {
 				bars[1].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT   | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
 				bars[1].dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
 				bars[1].dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+				bars[2] = bars[0];
+				bars[2].buffer = gfOsData.clusterBfCopy.first; bars[2].size = clusterBytes;
+				bars[2].srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+				bars[2].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
 				VkDependencyInfo depInfo = { };
 				depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-				depInfo.bufferMemoryBarrierCount = std::size(bars); depInfo.pBufferMemoryBarriers = bars;
+				depInfo.bufferMemoryBarrierCount = (clusterBytes > 0)? 3 : 2; depInfo.pBufferMemoryBarriers = bars;
 				vkCmdPipelineBarrier2(cmd, &depInfo);
 				auto cpBf = [&](VkBuffer src, std::pair<vkutil::Buffer, size_t>& dst, VkDeviceSize bytes) {
 					VkBufferCopy cp = { 0, 0, bytes };
@@ -199,16 +213,21 @@ namespace SKENGINE_NAME_NS {
 				os.waitUntilReady();
 				cpBf(os.getObjectBuffer().value,      gfOsData.objBfCopy,     objBytes);
 				cpBf(os.getDrawCommandBuffer().value, gfOsData.drawCmdBfCopy, cmdBytes);
+				if(clusterBytes > 0) cpBf(os.getClusterDrawBuffer().value, gfOsData.clusterBfCopy, clusterBytes);
 				bars[0].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;       bars[0].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
 				bars[0].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[0].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
 				bars[1].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;       bars[1].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
 				bars[1].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[1].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+				bars[2].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;       bars[2].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+				bars[2].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[2].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
 				vkCmdPipelineBarrier2(cmd, &depInfo);
-				VkDescriptorBufferInfo dbInfos[4] = {
+				VkDescriptorBufferInfo dbInfos[6] = {
 					{ gfOsData.objBfCopy.first,     0, objBytes },
 					{ gfOsData.objIdBfCopy.first,   0, objIdBytes },
 					{ gfOsData.drawCmdBfCopy.first, 0, cmdBytes },
-					{ gfOsData.cullPassUbo,         0, sizeof(dev::CullPassUbo) } };
+					{ gfOsData.cullPassUbo,         0, sizeof(dev::CullPassUbo) },
+					{ gfOsData.clusterBfCopy.first, 0, clusterBytes },
+					{ gfOsData.clusterCmdBf.first,  0, clusterCmdBytes } };
 				VkWriteDescriptorSet wr[std::size(dbInfos)];
 				wr[0] = { };
 				wr[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -227,7 +246,15 @@ namespace SKENGINE_NAME_NS {
 				wr[3].dstBinding = CULL_UBO_BINDING;
 				wr[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 				wr[3].pBufferInfo = dbInfos + 3;
-				vkUpdateDescriptorSets(dev, std::size(wr), wr, 0, nullptr);
+				wr[4] = wr[0];
+				wr[4].dstBinding = CULL_CLUSTER_BINDING;
+				wr[4].pBufferInfo = dbInfos + 4;
+				wr[5] = wr[0];
+				wr[5].dstBinding = CULL_CLUSTER_CMD_BINDING;
+				wr[5].pBufferInfo = dbInfos + 5;
+				SKENGINE_ZONE("cull pass vkUpdateDescriptorSets");
+				// The cluster bindings are only used (and only valid) when there are cluster draws
+				vkUpdateDescriptorSets(dev, (clusterBytes > 0)? 6 : 4, wr, 0, nullptr);
 				++ osIdx;
 			}
 		}
@@ -261,7 +288,7 @@ namespace SKENGINE_NAME_NS {
 						bars[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
 						bars[0].buffer = gfOsData.objBfCopy.first;   bars[0].size = os.getDrawCount() * sizeof(dev::Object);
 						bars[1] = bars[0];
-						bars[1].buffer = gfOsData.objIdBfCopy.first; bars[1].size = os.getDrawCount() * sizeof(dev::ObjectId);
+						bars[1].buffer = gfOsData.objIdBfCopy.first; bars[1].size = os.getInstanceSlotCount() * sizeof(dev::ObjectId);
 						bars[2] = bars[0];
 						bars[2].buffer = gfOsData.objBfCopy.first;   bars[2].size = os.getDrawBatchCount() * sizeof(VkDrawIndexedIndirectCommand);
 					}
@@ -281,6 +308,39 @@ namespace SKENGINE_NAME_NS {
 					bars[2].dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;  bars[2].dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
 					vkCmdPipelineBarrier2(cmd, &depInfo);
 				}
+
+				uint32_t clusterDrawCount = os.getClusterDrawCount();
+				uint32_t clusterGroupCountX = clusterDrawCount / dispatchXyz[0];
+				if(clusterDrawCount % dispatchXyz[0] > 0) ++ clusterGroupCountX; // ceil behavior
+				if(groupCountX > 0 && clusterGroupCountX > 0) { // Run the cluster cull pass, which depends on the object IDs written above
+					vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mState.clusterCullPassPipeline);
+					vkCmdPushConstants(
+						cmd,
+						mState.sharedState->cullPassPipelineLayout,
+						VK_SHADER_STAGE_COMPUTE_BIT,
+						0, sizeof(uint32_t), &clusterDrawCount );
+					VkBufferMemoryBarrier2 bars[2];
+					VkDependencyInfo depInfo = { };
+					{ // Barrier boilerplate ( {0,1} -> { objidx, clustercmd } )
+						depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+						depInfo.bufferMemoryBarrierCount = std::size(bars); depInfo.pBufferMemoryBarriers = bars;
+						bars[0] = { };
+						bars[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+						bars[0].buffer = gfOsData.objIdBfCopy.first;  bars[0].size = os.getInstanceSlotCount() * sizeof(dev::ObjectId);
+						bars[1] = bars[0];
+						bars[1].buffer = gfOsData.clusterCmdBf.first; bars[1].size = clusterDrawCount * sizeof(VkDrawIndexedIndirectCommand);
+					}
+					bars[0].srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[0].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+					bars[0].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[0].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+					bars[1].srcStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;  bars[1].srcAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+					bars[1].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[1].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+					vkCmdPipelineBarrier2(cmd, &depInfo);
+					vkCmdDispatch(cmd, clusterGroupCountX, 1, 1);
+					depInfo.bufferMemoryBarrierCount = 1; depInfo.pBufferMemoryBarriers = bars + 1;
+					bars[1].srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT; bars[1].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+					bars[1].dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;  bars[1].dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+					vkCmdPipelineBarrier2(cmd, &depInfo);
+				}
 				++ osIdx;
 			}
 		}
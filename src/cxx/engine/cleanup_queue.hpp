@@ -0,0 +1,127 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	/// \brief A queue of destruction callbacks, each of which is deferred
+	///        until the device is done with the resources it destroys.
+	///
+	/// Every entry is tagged with a value on a monotonically increasing
+	/// timeline (for the Engine, the number of the last gframe that may
+	/// have used the resource); entries are retired when the timeline is
+	/// known to be completed up to their value.
+	///
+	/// Entries are retired in ascending timeline order, and entries with the
+	/// same value are retired in the order they were enqueued.
+	/// Callbacks are invoked outside of the queue's lock, so they may
+	/// enqueue new entries; they should not throw.
+	///
+	class CleanupQueue {
+	public:
+		using timeline_t = uint_fast64_t;
+		using Callback   = std::move_only_function<void()>;
+
+		CleanupQueue(): cq_currentValue(0), cq_completedValue(0) { }
+		CleanupQueue(const CleanupQueue&) = delete;
+		CleanupQueue& operator=(const CleanupQueue&) = delete;
+
+		#ifndef NDEBUG
+			~CleanupQueue() { assert(cq_entries.empty() && "Some resources were never destroyed"); }
+		#endif
+
+		/// \brief Enqueues a callback, tagged with the current timeline value.
+		///
+		void enqueue(Callback cb) {
+			auto lock = std::unique_lock(cq_mutex);
+			insert(cq_currentValue, std::move(cb));
+		}
+
+		/// \brief Enqueues a callback, tagged with the given timeline value.
+		///
+		/// If the value has already been completed, the callback is still
+		/// deferred until the next retirement.
+		///
+		void enqueue(timeline_t lastUse, Callback cb) {
+			auto lock = std::unique_lock(cq_mutex);
+			insert(lastUse, std::move(cb));
+		}
+
+		/// \brief Sets the value that `enqueue(Callback)` tags new entries with.
+		///
+		void advance(timeline_t current) noexcept {
+			auto lock = std::unique_lock(cq_mutex);
+			assert(current >= cq_currentValue);
+			cq_currentValue = current;
+		}
+
+		/// \brief Invokes and removes every entry whose value is not greater
+		///        than the given one.
+		/// \returns The number of retired entries.
+		///
+		std::size_t retire(timeline_t completed) {
+			auto lock = std::unique_lock(cq_mutex);
+			cq_completedValue = std::max(cq_completedValue, completed);
+			auto end = std::upper_bound(cq_entries.begin(), cq_entries.end(), completed, [](timeline_t v, const Entry& e) { return v < e.value; });
+			std::vector<Callback> retired;
+			retired.reserve(end - cq_entries.begin());
+			for(auto i = cq_entries.begin(); i != end; ++i) retired.push_back(std::move(i->callback));
+			cq_entries.erase(cq_entries.begin(), end);
+			lock.unlock();
+			for(auto& cb : retired) cb();
+			return retired.size();
+		}
+
+		/// \brief Invokes and removes every entry, regardless of its value.
+		///
+		/// This should only be used after the device has been waited on,
+		/// or when it is about to be destroyed.
+		///
+		std::size_t retireAll() {
+			std::size_t r = 0;
+			std::size_t retired;
+			do { // Callbacks may enqueue more entries
+				retired = retire(~ timeline_t(0));
+				r += retired;
+			} while(retired > 0);
+			return r;
+		}
+
+		timeline_t currentValue   () const noexcept { auto lock = std::unique_lock(cq_mutex); return cq_currentValue; }
+		timeline_t completedValue () const noexcept { auto lock = std::unique_lock(cq_mutex); return cq_completedValue; }
+		std::size_t size          () const noexcept { auto lock = std::unique_lock(cq_mutex); return cq_entries.size(); }
+		bool        empty         () const noexcept { return size() == 0; }
+
+	private:
+		struct Entry {
+			timeline_t value;
+			Callback   callback;
+		};
+
+		mutable std::mutex cq_mutex;
+		std::deque<Entry>  cq_entries;
+		timeline_t cq_currentValue;
+		timeline_t cq_completedValue;
+
+		void insert(timeline_t value, Callback cb) {
+			// Values are usually enqueued in ascending order, the binary search is a fallback
+			if(cq_entries.empty() || cq_entries.back().value <= value) [[likely]] {
+				cq_entries.push_back(Entry { value, std::move(cb) });
+			} else {
+				auto pos = std::upper_bound(cq_entries.begin(), cq_entries.end(), value, [](timeline_t v, const Entry& e) { return v < e.value; });
+				cq_entries.insert(pos, Entry { value, std::move(cb) });
+			}
+		}
+	};
+
+}
@@ -35,7 +35,7 @@ namespace SKENGINE_NAME_NS::debug {
 		(void) b; (void) usage;
 		#ifndef NDEBUG
 			assert(logger.sink());
-			assert(logger.sink()->file());
+			assert(logger.sink()->sink().file());
 			logger.debug("Created VkBuffer {:016x} : {}", size_t(VkBuffer(b)), usage);
 		#endif
 	}
@@ -45,7 +45,7 @@ namespace SKENGINE_NAME_NS::debug {
 		(void) b; (void) usage;
 		#ifndef NDEBUG
 			assert(logger.sink());
-			assert(logger.sink()->file());
+			assert(logger.sink()->sink().file());
 			logger.debug("Destroyed VkBuffer {:016x} : {}", size_t(VkBuffer(b)), usage);
 		#endif
 	}
@@ -4,6 +4,9 @@
 
 #include <skengine_fwd.hpp>
 
+#include "skyline_packer.hpp"
+#include "text_layout.hpp"
+
 #include <vulkan/vulkan.h>
 
 #include <vk-util/memory.hpp>
@@ -27,9 +30,6 @@
 namespace SKENGINE_NAME_NS {
 inline namespace geom {
 
-	using codepoint_t = char32_t;
-
-
 	class FontError : public std::runtime_error {
 	public:
 		template <typename... Args>
@@ -79,6 +79,7 @@ inline namespace geom {
 		VkPipeline polyLine;
 		VkPipeline polyFill;
 		VkPipeline text;
+		VkPipeline textSdf; // For text caches that store signed distance fields
 
 		static PipelineSet create  (VkDevice, const PipelineSetCreateInfo&);
 		static void        destroy (VkDevice, PipelineSet&) noexcept;
@@ -93,14 +94,6 @@ inline namespace geom {
 
 	class TextCache;
 
-	struct CharDescriptor {
-		float topLeftUv[2];
-		float bottomRightUv[2];
-		float size[2]; // Relative to the font height
-		float baseline[2];
-		float advance[2];
-	};
-
 
 	class Shape : private std::vector<Vertex> {
 	public:
@@ -171,9 +164,27 @@ inline namespace geom {
 		static DrawableShapeSet create(VmaAllocator, ShapeSet);
 		static void     destroy(VmaAllocator, DrawableShapeSet&) noexcept;
 
+		/// \brief Replaces the shapes of an initialized set.
+		///
+		/// If the new shapes are the same as the old ones, in the same order,
+		/// only the instances that differ are rewritten.
+		/// Otherwise the buffers are rewritten in place when the new shapes
+		/// fit, and reallocated with some headroom if they don't.
+		/// Either way, the set needs to be committed again.
+		///
+		void update(VmaAllocator, std::vector<DrawableShapeInstance>);
+		void update(VmaAllocator, ShapeSet);
+
 		void forceNextCommit() noexcept;
 		void commitVkBuffers(VmaAllocator vma) { if(0 == (dr_shape_set_state & 0b001)) [[unlikely]] dr_shape_set_commitBuffers(vma); }
 
+		/// \brief Gives access to the color and transform of the `index`-th shape instance,
+		///        in the order the shapes were given.
+		///
+		/// The changes are written to the instance buffer by the next commit,
+		/// which only rewrites the modified instances; the UI renderer commits
+		/// every set it draws, so the element does not need to be modified.
+		///
 		ModifiableShapeInstance modifyShapeInstance(unsigned index) noexcept;
 
 		operator bool()  { return State(dr_shape_set_state) != State::eUnitialized; }
@@ -190,20 +201,27 @@ inline namespace geom {
 			// 100 & shape set is initialized
 			// 010 & do destroy buffers
 			// 001 & do not flush buffers
+			// 1000 & only the modified instances need to be flushed
 			eUnitialized = 0b000,
 			eEmpty       = 0b101,
 			eOutOfDate   = 0b110,
-			eUpToDate    = 0b111
+			eUpToDate    = 0b111,
+			eModifiedInstances = 0b1110
 		};
 
 		DrawableShapeSet(State state): dr_shape_set_state(unsigned(state)) { }
 
 		void dr_shape_set_commitBuffers(VmaAllocator);
+		void dr_shape_set_markModified(unsigned index) noexcept;
 
 		std::vector<DrawableShapeInstance> dr_shape_set_shapes;
+		std::vector<uint32_t> dr_shape_set_instanceSlots;     // The buffer slot of each shape instance, which are grouped by shape
+		std::vector<uint32_t> dr_shape_set_modifiedInstances; // Shape instances to copy to their slots on the next commit
 		vkutil::Buffer dr_shape_set_vtxBuffer;  // [  instances  ][  vertices          ]
 		vkutil::Buffer dr_shape_set_drawBuffer; // [  draw_cmds         ]
 		void*    dr_shape_set_vtxPtr;
+		VkDeviceSize dr_shape_set_vtxCapacity;  // In bytes
+		VkDeviceSize dr_shape_set_drawCapacity; // In bytes
 		unsigned dr_shape_set_instanceCount;
 		unsigned dr_shape_set_vertexCount;
 		unsigned dr_shape_set_drawCount;
@@ -269,6 +287,14 @@ inline namespace geom {
 		std::pair<GlyphBitmap, codepoint_t> getGlyphBitmap(codepoint_t);
 		GlyphBitmap getGlyphBitmapByIndex(codepoint_t index);
 
+		/// \brief Renders a glyph as a grayscale signed distance field (see `coverageToSdf`).
+		///
+		/// The bitmap is `spread` pixels larger than the glyph on every side,
+		/// and its baseline is moved accordingly.
+		///
+		std::pair<GlyphBitmap, codepoint_t> getGlyphSdf(codepoint_t, unsigned spread);
+		GlyphBitmap getGlyphSdfByIndex(codepoint_t index, unsigned spread);
+
 		FT_Face ftFace() const noexcept { return font_face.value; }
 		operator FT_Face() const noexcept { return ftFace(); }
 
@@ -281,6 +307,17 @@ inline namespace geom {
 	/// \brief Groups multiple glyphs into a single texture,
 	///        and updates it when necessary.
 	///
+	/// Glyphs are packed into the texture at their actual size, and
+	/// only the ones that were not cached yet are rasterized and uploaded.
+	/// When the texture is full, it is replaced by a larger one, and the
+	/// previous contents are copied by the device; replaced resources are
+	/// destroyed once the fence passed to `syncWithFence` is signaled.
+	///
+	/// If `sdfSpread` is not zero, glyphs are stored as signed distance
+	/// fields rasterized at the cache's pixel height, and the texture is
+	/// sampled linearly: one cache can then serve every text size, as long
+	/// as it is drawn with the `textSdf` pipeline.
+	///
 	class TextCache {
 	public:
 		using CharMap = std::unordered_map<codepoint_t, CharDescriptor>;
@@ -288,7 +325,7 @@ inline namespace geom {
 
 		TextCache() = default;
 		TextCache(TextCache&&) = default;
-		TextCache(VkDevice, VmaAllocator, VkDescriptorSetLayout, std::shared_ptr<FontFace>, unsigned short pixelHeight = 0);
+		TextCache(VkDevice, VmaAllocator, VkDescriptorSetLayout, std::shared_ptr<FontFace>, unsigned short pixelHeight = 0, unsigned short sdfSpread = 0);
 		~TextCache();
 		TextCache& operator=(TextCache&&) = default;
 		TextCache& operator=(nullptr_t) { this->~TextCache(); return * new (this) TextCache(); }
@@ -306,12 +343,15 @@ inline namespace geom {
 		void pixelHeight(unsigned short v) noexcept { txtcache_pixelHeight = v; txtcache_imageUpToDate = false; }
 		auto pixelHeight() const noexcept { return txtcache_pixelHeight; }
 
+		bool usesSdf() const noexcept { return txtcache_sdfSpread > 0; }
+		auto sdfSpread() const noexcept { return txtcache_sdfSpread; }
+
 		void fetchChar(codepoint_t c) { if(! txtcache_charMap.contains(c)) txtcache_charQueue.insert(c); }
 		template <typename CharSeq> void fetchChars(const CharSeq& s) { using C = CharSeq::value_type; for(const C& c : s) fetchChar(codepoint_t(c)); }
 
-		void syncWithFence(VkFence fence) noexcept; // DOCUMENTATION HINT: a non-null fence may be waited upon on the next call to `updateImage`.
-		void forgetFence(VkFence fence) noexcept { if(txtcache_lock == fence) txtcache_lock = nullptr; }
-		void forgetFence() noexcept { forgetFence(txtcache_lock); }
+		void syncWithFence(VkFence fence) noexcept; // DOCUMENTATION HINT: never waits; pending fences are only waited upon by `updateImage`, if the texture needs to be replaced.
+		void forgetFence(VkFence fence) noexcept; // DOCUMENTATION HINT: the fence must not be pending, resources that were waiting for it are destroyed.
+		void forgetFence() noexcept; // DOCUMENTATION HINT: forgets every fence passed to `syncWithFence`, none of which may be pending.
 		VkFence currentFence() const noexcept { return txtcache_lock; }
 
 		void updateImage(VkCommandBuffer) noexcept; // DOCUMENTATION HINT: when called immediately after `fetchChars(str)`, the referenced map is guaranteed to contain mappings for all characters in `str`; the same goes for all previous similar calls.
@@ -333,23 +373,45 @@ inline namespace geom {
 		///
 		update_counter_t getUpdateCounter() const noexcept { return txtcache_updateCounter; }
 
+		/// \brief Returns the number of times the cached characters were remapped.
+		///
+		/// Unlike the update counter, this one does not change when characters
+		/// are only added to the cache: as long as it stays the same, the
+		/// information retrieved from `getChars()` for any character is still valid.
+		///
+		update_counter_t getRemapCounter() const noexcept { return txtcache_remapCounter; }
+
 	private:
+		struct RetiredResources {
+			VkFence        fence; // Null until the next call to `syncWithFence`
+			vkutil::Buffer stagingBuffer;
+			vkutil::Image  image;
+			VkImageView    imageView;
+		};
+
+		void txtcache_destroyRetired(RetiredResources&) noexcept;
+		void txtcache_collectRetired() noexcept;
+
 		std::shared_ptr<FontFace> txtcache_font;
 		CharMap txtcache_charMap;
+		std::unordered_map<codepoint_t, SkylinePacker::Rect> txtcache_charRects; // In pixels, without padding
 		std::unordered_set<codepoint_t> txtcache_charQueue;
+		std::vector<RetiredResources>   txtcache_retired;
+		std::vector<VkFence>            txtcache_pendingFences; // Draws that may still be sampling the image through the descriptor set
+		SkylinePacker                   txtcache_packer;
 		util::Moveable<VkDevice>       txtcache_dev;
 		VmaAllocator                   txtcache_vma;
 		VkDescriptorPool               txtcache_dpool;
 		VkDescriptorSet                txtcache_dset;
-		util::Moveable<vkutil::Buffer> txtcache_stagingBuffer;
 		util::Moveable<vkutil::Image>  txtcache_image;
 		VkImageView                    txtcache_imageView;
 		VkSampler                      txtcache_sampler;
 		VkFence                        txtcache_lock;
 		VkExtent2D       txtcache_imageExt;
-		size_t           txtcache_stagingBufferSize;
 		update_counter_t txtcache_updateCounter;
+		update_counter_t txtcache_remapCounter;
 		unsigned short   txtcache_pixelHeight;
+		unsigned short   txtcache_sdfSpread;
 		bool txtcache_imageUpToDate;
 	};
 
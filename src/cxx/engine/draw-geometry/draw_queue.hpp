@@ -0,0 +1,192 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace geom {
+
+	/// \brief Packs the state of a draw job into a key, that orders
+	///        jobs so that the ones sharing a state are adjacent.
+	///
+	/// From the most significant bits: pipeline, viewport and scissor,
+	/// descriptor set and depth. Each field is the index of a state rather
+	/// than the state itself (see FlatIndexMap); indices that do not fit
+	/// saturate, which only makes the jobs of different states share
+	/// a position in the ordering.
+	///
+	struct DrawSortKey {
+		static constexpr unsigned depthBits    = 24;
+		static constexpr unsigned dsetBits     = 12;
+		static constexpr unsigned scissorBits  = 20;
+		static constexpr unsigned pipelineBits = 8;
+
+		static constexpr unsigned depthShift    = 0;
+		static constexpr unsigned dsetShift     = depthShift   + depthBits;
+		static constexpr unsigned scissorShift  = dsetShift    + dsetBits;
+		static constexpr unsigned pipelineShift = scissorShift + scissorBits;
+		static_assert(pipelineShift + pipelineBits == 64);
+
+		static constexpr uint64_t pack(uint32_t pipeline, uint32_t scissor, uint32_t dset, uint32_t depth) noexcept {
+			constexpr auto field = [](uint32_t value, unsigned bits, unsigned shift) {
+				return std::min<uint64_t>(value, (uint64_t(1) << bits) - 1) << shift;
+			};
+			return
+				field(pipeline, pipelineBits, pipelineShift) |
+				field(scissor,  scissorBits,  scissorShift)  |
+				field(dset,     dsetBits,     dsetShift)     |
+				field(depth,    depthBits,    depthShift);
+		}
+	};
+
+
+	/// \brief Assigns consecutive indices to distinct values, in the order they are first seen.
+	///
+	/// An open addressing table whose storage survives `clear()`, so that
+	/// it can be refilled every frame without allocating.
+	///
+	template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+	class FlatIndexMap {
+	public:
+		uint32_t indexOf(const T& value) {
+			if((fim_values.size() + 1) * 2 > fim_slots.size()) rehash(std::max<size_t>(minSlotCount, fim_slots.size() * 2));
+			size_t mask = fim_slots.size() - 1;
+			size_t slot = slotOf(Hash()(value));
+			while(true) {
+				uint32_t& index = fim_slots[slot];
+				if(index == emptySlot) {
+					index = uint32_t(fim_values.size());
+					fim_values.push_back(value);
+					return index;
+				}
+				if(Equal()(fim_values[index], value)) return index;
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		const T& operator[](uint32_t index) const noexcept { return fim_values[index]; }
+
+		void clear() noexcept {
+			fim_values.clear();
+			std::fill(fim_slots.begin(), fim_slots.end(), emptySlot);
+		}
+
+		size_t size() const noexcept { return fim_values.size(); }
+
+	private:
+		static constexpr uint32_t emptySlot    = ~ uint32_t(0);
+		static constexpr size_t   minSlotCount = 64;
+
+		// Pointer-like handles hash to themselves, and their low bits are mostly zero:
+		// take the high bits of a Fibonacci product instead
+		size_t slotOf(size_t hash) const noexcept {
+			constexpr uint64_t fib = 0x9e3779b97f4a7c15;
+			return size_t((uint64_t(hash) * fib) >> (64 - fim_slotBits));
+		}
+
+		void rehash(size_t slotCount) {
+			assert(slotCount == (size_t(1) << std::countr_zero(slotCount)));
+			fim_slots.assign(slotCount, emptySlot);
+			fim_slotBits = unsigned(std::countr_zero(slotCount));
+			size_t mask = slotCount - 1;
+			for(uint32_t i = 0; i < fim_values.size(); ++i) {
+				size_t slot = slotOf(Hash()(fim_values[i]));
+				while(fim_slots[slot] != emptySlot) slot = (slot + 1) & mask;
+				fim_slots[slot] = i;
+			}
+		}
+
+		std::vector<T>        fim_values;
+		std::vector<uint32_t> fim_slots;
+		unsigned              fim_slotBits = 0;
+	};
+
+
+	struct KeyedIndex {
+		uint64_t key;
+		uint32_t index;
+	};
+
+
+	/// \brief Stable LSD radix sort of `entries` by key, 8 bits at a time.
+	///
+	/// Digits that are the same for every key are skipped, so that the
+	/// cost only depends on how many bits actually vary.
+	/// `scratch` is resized as needed, and may be reused across calls.
+	///
+	inline void radixSort(std::vector<KeyedIndex>& entries, std::vector<KeyedIndex>& scratch) {
+		constexpr unsigned digitBits  = 8;
+		constexpr unsigned digitCount = 64 / digitBits;
+		constexpr size_t   radix      = size_t(1) << digitBits;
+		constexpr size_t   minEntries = 64; // Below that, filling the histograms costs more than sorting
+		constexpr auto digitOf = [](uint64_t key, unsigned digit) { return size_t(key >> (digit * digitBits)) & (radix - 1); };
+
+		if(entries.size() < minEntries) {
+			std::stable_sort(entries.begin(), entries.end(), [](const KeyedIndex& l, const KeyedIndex& r) { return l.key < r.key; });
+			return;
+		}
+
+		std::array<std::array<uint32_t, radix>, digitCount> counts = { };
+		for(auto& e : entries) {
+			for(unsigned d = 0; d < digitCount; ++d) ++ counts[d][digitOf(e.key, d)];
+		}
+
+		scratch.resize(entries.size());
+		uint64_t firstKey = entries.front().key;
+		for(unsigned d = 0; d < digitCount; ++d) {
+			auto& count = counts[d];
+			if(count[digitOf(firstKey, d)] == entries.size()) continue;
+			uint32_t offset = 0;
+			for(auto& c : count) {
+				uint32_t c0 = c;
+				c = offset;
+				offset += c0;
+			}
+			for(auto& e : entries) scratch[count[digitOf(e.key, d)] ++] = e;
+			entries.swap(scratch);
+		}
+	}
+
+
+	/// \brief A list of draw jobs that can be visited in the order of their keys.
+	///
+	/// Jobs with the same key keep the order they were pushed in.
+	/// The storage survives `clear()`, so that a queue can be refilled
+	/// every frame without allocating.
+	///
+	template <typename Job>
+	class SortedDrawQueue {
+	public:
+		void push(uint64_t key, const Job& job) {
+			sdq_entries.push_back({ key, uint32_t(sdq_jobs.size()) });
+			sdq_jobs.push_back(job);
+		}
+
+		void sort() { radixSort(sdq_entries, sdq_scratch); }
+
+		void clear() noexcept { sdq_jobs.clear(); sdq_entries.clear(); }
+
+		/// \brief Returns the i-th job in the order of the keys, as of the last `sort()` call.
+		///
+		const Job& operator[](size_t i) const noexcept { return sdq_jobs[sdq_entries[i].index]; }
+		uint64_t   keyOf     (size_t i) const noexcept { return sdq_entries[i].key; }
+
+		size_t size()  const noexcept { return sdq_entries.size(); }
+		bool   empty() const noexcept { return sdq_entries.empty(); }
+
+	private:
+		std::vector<Job>        sdq_jobs;
+		std::vector<KeyedIndex> sdq_entries;
+		std::vector<KeyedIndex> sdq_scratch;
+	};
+
+}}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "draw_queue.hpp"
+
+#include <skengine_fwd.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace geom {
+
+	/// \brief Where the instances of a shape set live in its instance buffer.
+	///
+	/// Instances of the same shape are contiguous, so that each shape is
+	/// drawn by a single indirect command; `slots` maps the i-th instance,
+	/// in the order it was given, to its position in the buffer, so that
+	/// a single instance can be rewritten without moving any other one.
+	///
+	/// Shapes are grouped in the order they are first seen.
+	///
+	template <typename ShapeKey>
+	struct InstanceLayout {
+		struct Group {
+			ShapeKey shape;
+			uint32_t firstSlot;
+			uint32_t count;
+		};
+
+		std::vector<Group>    groups;
+		std::vector<uint32_t> slots;
+
+		static InstanceLayout build(std::span<const ShapeKey> shapes) {
+			InstanceLayout r;
+			FlatIndexMap<ShapeKey> groupIndices;
+			std::vector<uint32_t> groupOf;
+			groupOf.reserve(shapes.size());
+			for(auto& shape : shapes) {
+				uint32_t group = groupIndices.indexOf(shape);
+				if(group == r.groups.size()) r.groups.push_back({ shape, 0, 0 });
+				++ r.groups[group].count;
+				groupOf.push_back(group);
+			}
+
+			uint32_t slot = 0;
+			for(auto& group : r.groups) {
+				group.firstSlot = slot;
+				slot += group.count;
+				group.count = 0;
+			}
+
+			r.slots.reserve(shapes.size());
+			for(uint32_t group : groupOf) {
+				auto& g = r.groups[group];
+				r.slots.push_back(g.firstSlot + (g.count ++));
+			}
+			return r;
+		}
+	};
+
+}}
@@ -233,12 +233,14 @@ inline namespace geom {
 		auto polyFrgModule = COMPILE_("geom:poly.frg", polyFrgSrc, fragment);
 		auto textVtxModule = COMPILE_("geom:text.vtx", textVtxSrc, vertex);
 		auto textFrgModule = COMPILE_("geom:text.frg", textFrgSrc, fragment);
+		auto textSdfFrgModule = COMPILE_("geom:text-sdf.frg", textSdfFrgSrc, fragment);
 		#undef COMPILE_
 		auto destroyShaderModules = [&]() {
 			vkDestroyShaderModule(dev, polyVtxModule, nullptr);
 			vkDestroyShaderModule(dev, polyFrgModule, nullptr);
 			vkDestroyShaderModule(dev, textVtxModule, nullptr);
 			vkDestroyShaderModule(dev, textFrgModule, nullptr);
+			vkDestroyShaderModule(dev, textSdfFrgModule, nullptr);
 		};
 
 		std::vector<VkPipeline> pipelines;
@@ -263,6 +265,8 @@ inline namespace geom {
 			pci.vertexShader   = textVtxModule;
 			pci.fragmentShader = textFrgModule;
 			pipelines.push_back(r.text = createPipeline<PipelineType::eText>(dev, pci));
+			pci.fragmentShader = textSdfFrgModule;
+			pipelines.push_back(r.textSdf = createPipeline<PipelineType::eText>(dev, pci));
 		} catch(...) {
 			// Destroy the successfully created pipelines, then resume the downwards spiral
 			destroyShaderModules();
@@ -278,6 +282,7 @@ inline namespace geom {
 		vkDestroyPipeline(dev, ps.polyLine, nullptr);
 		vkDestroyPipeline(dev, ps.polyFill, nullptr);
 		vkDestroyPipeline(dev, ps.text, nullptr);
+		vkDestroyPipeline(dev, ps.textSdf, nullptr);
 	}
 
 }}
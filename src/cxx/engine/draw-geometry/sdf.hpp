@@ -0,0 +1,135 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace geom {
+
+	/// \brief The value of a signed distance field texel that lies on the glyph's outline.
+	///
+	/// Texels inside the glyph are above it, texels outside are below it.
+	///
+	constexpr uint8_t sdfEdgeValue = 128;
+
+
+	namespace sdf_impl {
+
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+
+		// One-dimensional squared Euclidean distance transform (Felzenszwalb & Huttenlocher):
+		// `f` holds the squared distances to the nearest feature along the other axis,
+		// `v` and `z` are scratch buffers of size `n` and `n+1`.
+		inline void edt1d(float* f, size_t n, size_t stride, float* d, unsigned* v, float* z) {
+			auto sq = [](size_t x) { return float(x) * float(x); };
+			size_t k = 0;
+			bool   anyFeature = false;
+			for(size_t q = 0; q < n; ++q) {
+				float fq = f[q * stride];
+				if(fq == infinity) continue;
+				if(! anyFeature) {
+					v[0] = unsigned(q);
+					z[0] = -infinity;
+					z[1] = +infinity;
+					anyFeature = true;
+					continue;
+				}
+				float s;
+				while(true) {
+					s = ((fq + sq(q)) - (f[v[k] * stride] + sq(v[k]))) / (2.0f * float(q - v[k]));
+					if(s > z[k]) break;
+					-- k; // `z[0]` is minus infinity, so this never goes below 0
+				}
+				++ k;
+				v[k]   = unsigned(q);
+				z[k]   = s;
+				z[k+1] = +infinity;
+			}
+			if(! anyFeature) return;
+
+			k = 0;
+			for(size_t q = 0; q < n; ++q) {
+				while(z[k+1] < float(q)) ++ k;
+				d[q] = sq(q > v[k]? q - v[k] : v[k] - q) + f[v[k] * stride];
+			}
+			for(size_t q = 0; q < n; ++q) f[q * stride] = d[q];
+		}
+
+
+		// Transforms a grid of "0 on features, infinity elsewhere" into squared distances, in place
+		inline void edt2d(std::vector<float>& grid, unsigned width, unsigned height) {
+			size_t maxSide = std::max(width, height);
+			std::vector<float>    d(maxSide);
+			std::vector<unsigned> v(maxSide);
+			std::vector<float>    z(maxSide + 1);
+			for(size_t x = 0; x < width; ++x)  edt1d(grid.data() + x,            height, width, d.data(), v.data(), z.data());
+			for(size_t y = 0; y < height; ++y) edt1d(grid.data() + (y * width), width,  1,     d.data(), v.data(), z.data());
+		}
+
+	}
+
+
+	/// \brief Turns an 8-bit coverage bitmap into a signed distance field.
+	///
+	/// The field is `spread` texels larger than the bitmap on every side,
+	/// and saturates `spread` texels away from the outline; distances are
+	/// measured between texel centers, and the texels on the outline are
+	/// refined with their coverage so that antialiased bitmaps keep
+	/// their sub-texel edges.
+	///
+	/// \param pitch The number of bytes between two rows of the bitmap.
+	/// \returns `(width + 2*spread) * (height + 2*spread)` bytes, row by row.
+	///
+	inline std::vector<uint8_t> coverageToSdf(const uint8_t* coverage, unsigned width, unsigned height, unsigned pitch, unsigned spread) {
+		using sdf_impl::infinity;
+		unsigned outWidth  = width  + (2 * spread);
+		unsigned outHeight = height + (2 * spread);
+		size_t   outSize   = size_t(outWidth) * size_t(outHeight);
+		auto isInside = [&](unsigned x, unsigned y) {
+			if(x < spread || y < spread || x >= spread + width || y >= spread + height) return false;
+			return coverage[(size_t(y - spread) * pitch) + (x - spread)] >= sdfEdgeValue;
+		};
+		auto coverageAt = [&](unsigned x, unsigned y) {
+			if(x < spread || y < spread || x >= spread + width || y >= spread + height) return 0.0f;
+			return float(coverage[(size_t(y - spread) * pitch) + (x - spread)]) / 255.0f;
+		};
+
+		// Squared distances to the nearest inside texel, and to the nearest outside texel
+		std::vector<float> toInside(outSize);
+		std::vector<float> toOutside(outSize);
+		for(unsigned y = 0; y < outHeight; ++y)
+		for(unsigned x = 0; x < outWidth;  ++x) {
+			size_t i = (size_t(y) * outWidth) + x;
+			bool inside = isInside(x, y);
+			toInside[i]  = inside? 0.0f : infinity;
+			toOutside[i] = inside? infinity : 0.0f;
+		}
+		sdf_impl::edt2d(toInside,  outWidth, outHeight);
+		sdf_impl::edt2d(toOutside, outWidth, outHeight);
+
+		std::vector<uint8_t> r(outSize);
+		float scale = float(sdfEdgeValue - 1) / float(std::max(spread, 1u));
+		for(unsigned y = 0; y < outHeight; ++y)
+		for(unsigned x = 0; x < outWidth;  ++x) {
+			size_t i = (size_t(y) * outWidth) + x;
+			float dist;
+			if(toInside[i] == 0.0f) dist = + (std::sqrt(toOutside[i]) - 0.5f);
+			else                    dist = - (std::sqrt(toInside[i])  - 0.5f);
+			if(toInside[i] <= 1.0f && toOutside[i] <= 1.0f) {
+				// The outline crosses the texel, whose coverage is a better estimate
+				dist = coverageAt(x, y) - 0.5f;
+			}
+			float value = std::round(float(sdfEdgeValue) + (dist * scale));
+			r[i] = uint8_t(std::clamp(value, 0.0f, 255.0f));
+		}
+		return r;
+	}
+
+}}
@@ -72,4 +72,24 @@ inline namespace geom_shaders {
 		"out_col = frg_col * texture(tex_text, frg_tex);"
 	"}";
 
+
+	// The alpha channel holds a signed distance field, whose outline is at 128/255;
+	// the transition is one pixel wide regardless of how much the glyph is scaled
+	constexpr const std::string_view textSdfFrgSrc =
+	"#version 450\n"
+	""
+	"layout(location = 0) in vec4 frg_col;"
+	"layout(location = 1) in vec2 frg_tex;"
+	"layout(location = 0) out vec4 out_col;"
+	"layout(set = 0, binding = 0) uniform sampler2D tex_text;"
+	""
+	"const float edge = 128.0 / 255.0;"
+	""
+	"void main() {"
+		"vec4  texel = texture(tex_text, frg_tex);"
+		"float halfw = max(0.5 * fwidth(texel.a), 0.0001);"
+		"float alpha = smoothstep(edge - halfw, edge + halfw, texel.a);"
+		"out_col = frg_col * vec4(texel.rgb, alpha);"
+	"}";
+
 }}
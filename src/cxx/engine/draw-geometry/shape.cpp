@@ -1,10 +1,14 @@
 #include "core.hpp"
+#include "instance_layout.hpp"
 
 #include <vk-util/memory.hpp>
 #include <vk-util/error.hpp>
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
-#include <unordered_set>
+#include <cstring>
+#include <span>
 #include <utility>
 
 
@@ -27,51 +31,51 @@ namespace {
 		using DrawCmds  = std::vector<VkDrawIndirectCommand>;
 		using Instances = std::vector<geom::Instance>;
 		using Vertices  = std::vector<geom::Vertex>;
+		using Slots     = std::vector<uint32_t>;
 		DrawCmds  drawCmds;
 		Instances instances;
 		Vertices  vertices;
+		Slots     instanceSlots;
 	};
 
 
 	InputData sortInputData(std::span<const DrawableShapeInstance> shapes) {
-		using ShapeInstMap   = std::unordered_map<const Shape*, std::vector<const geom::Instance*>>;
-		using ShapeOffsetMap = std::unordered_map<const Shape*, unsigned>;
-
 		InputData r;
-		auto uniqueShapes = ShapeInstMap(shapes.size());
-
-		for(auto& shapeInst : shapes) {
-			uniqueShapes[&shapeInst.shape()].push_back(&shapeInst.instance());
-		}
 
-		auto shapeIndices = ShapeOffsetMap(uniqueShapes.size());
-		auto insertShapeGetOffset = [&](const Shape* shape) {
-			auto ins = shapeIndices.insert(ShapeOffsetMap::value_type(shape, r.vertices.size()));
-			if(ins.second) {
-				// The shape's vertices need to be inserted
-				r.vertices.insert(r.vertices.end(), shape->vertices().begin(), shape->vertices().end());
-			} else {
-				// The vertices already exist; NOP
-			}
-			return ins.first->second;
-		};
+		auto shapePtrs = std::vector<const Shape*>();
+		shapePtrs.reserve(shapes.size());
+		for(auto& shapeInst : shapes) shapePtrs.push_back(&shapeInst.shape());
+		auto layout = InstanceLayout<const Shape*>::build(shapePtrs);
 
-		for(auto& shape : uniqueShapes) {
-			unsigned vtxOffset  = insertShapeGetOffset(shape.first);
-			unsigned instOffset = r.instances.size();
-			for(auto& ins : shape.second) r.instances.push_back(*ins);
+		// Every group has a distinct shape, whose vertices are stored once
+		r.drawCmds.reserve(layout.groups.size());
+		for(auto& group : layout.groups) {
 			VkDrawIndirectCommand cmd = { };
-			cmd.firstInstance = instOffset;
-			cmd.instanceCount = shape.second.size();
-			cmd.firstVertex   = vtxOffset;
-			cmd.vertexCount   = shape.first->vertices().size();
+			cmd.firstInstance = group.firstSlot;
+			cmd.instanceCount = group.count;
+			cmd.firstVertex   = r.vertices.size();
+			cmd.vertexCount   = group.shape->vertices().size();
+			r.vertices.insert(r.vertices.end(), group.shape->vertices().begin(), group.shape->vertices().end());
 			r.drawCmds.push_back(cmd);
 		}
 
+		r.instances.resize(shapes.size());
+		for(size_t i = 0; i < shapes.size(); ++i) r.instances[layout.slots[i]] = shapes[i].instance();
+		r.instanceSlots = std::move(layout.slots);
+
 		return r;
 	}
 
 
+	bool sameShapes(std::span<const DrawableShapeInstance> l, std::span<const DrawableShapeInstance> r) noexcept {
+		if(l.size() != r.size()) return false;
+		for(size_t i = 0; i < l.size(); ++i) {
+			if(&l[i].shape() != &r[i].shape()) return false;
+		}
+		return true;
+	}
+
+
 	void updateBuffers(
 			VmaAllocator vma,
 			vkutil::Buffer   drawCmdBuffer,
@@ -90,48 +94,57 @@ namespace {
 	}
 
 
+	std::vector<DrawableShapeInstance> toShapeInstances(ShapeSet shapes) {
+		auto r = std::vector<DrawableShapeInstance>();
+		r.reserve(shapes.size());
+		for(auto& shape : shapes) {
+			r.push_back(DrawableShapeInstance(
+				std::move(shape.shape),
+				geom::Instance {
+					.color     = shape.color,
+					.transform = shape.transform } ));
+		}
+		return r;
+	}
+
+
+	struct BufferSizes {
+		VkDeviceSize vtxBytes;
+		VkDeviceSize drawCmdBytes;
+	};
+
+
+	BufferSizes requiredBufferSizes(const InputData& inputData) {
+		VkDeviceSize instanceBytes = inputData.instances.size() * sizeof(geom::Instance);
+		VkDeviceSize vertexBytes   = inputData.vertices.size() * sizeof(geom::Vertex);
+		VkDeviceSize drawCmdBytes  = inputData.drawCmds.size() * sizeof(VkDrawIndirectCommand);
+		return { instanceBytes + vertexBytes, drawCmdBytes };
+	}
+
+
 	void createBuffers(
 			VmaAllocator vma,
 			vkutil::Buffer* dstVtxBuffer,
 			vkutil::Buffer* dstDrawCmdBuffer,
 			void**    dstVtxPtr,
-			unsigned* dstInstanceCount,
-			unsigned* dstVertexCount,
-			unsigned* dstDrawCmdCount,
-			std::span<const DrawableShapeInstance> shapes
+			BufferSizes sizes
 	) {
-		assert(! shapes.empty());
-
-		auto inputData = sortInputData(shapes);
-		*dstInstanceCount = inputData.instances.size();
-		*dstVertexCount   = inputData.vertices.size();
-		*dstDrawCmdCount  = inputData.drawCmds.size();
-
-		{ // Create and write the buffers
-			VkDeviceSize instanceBytes = (*dstInstanceCount) * sizeof(geom::Instance);
-			VkDeviceSize vertexBytes   = (*dstVertexCount) * sizeof(geom::Vertex);
-			VkDeviceSize drawCmdBytes  = (*dstDrawCmdCount) * sizeof(VkDrawIndirectCommand);
-			VkDeviceSize vtxBufferSize  = instanceBytes + vertexBytes;
-
-			vkutil::BufferCreateInfo bcInfo = { };
-			bcInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-			bcInfo.size  = vtxBufferSize;
-			vkutil::AllocationCreateInfo acInfo = { };
-			acInfo.requiredMemFlags  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-			acInfo.preferredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-			acInfo.vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
-			acInfo.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
-			*dstVtxBuffer = vkutil::ManagedBuffer::create(vma, bcInfo, acInfo);
-
-			bcInfo.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-			bcInfo.size = drawCmdBytes;
-			acInfo.vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
-			*dstDrawCmdBuffer = vkutil::ManagedBuffer::create(vma, bcInfo, acInfo);
-
-			// Copy data
-			VK_CHECK(vmaMapMemory, vma, *dstVtxBuffer, dstVtxPtr);
-			updateBuffers(vma, *dstDrawCmdBuffer, *dstVtxPtr, inputData);
-		}
+		vkutil::BufferCreateInfo bcInfo = { };
+		bcInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		bcInfo.size  = sizes.vtxBytes;
+		vkutil::AllocationCreateInfo acInfo = { };
+		acInfo.requiredMemFlags  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		acInfo.preferredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		acInfo.vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+		acInfo.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
+		*dstVtxBuffer = vkutil::ManagedBuffer::create(vma, bcInfo, acInfo);
+
+		bcInfo.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+		bcInfo.size = sizes.drawCmdBytes;
+		acInfo.vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+		*dstDrawCmdBuffer = vkutil::ManagedBuffer::create(vma, bcInfo, acInfo);
+
+		VK_CHECK(vmaMapMemory, vma, *dstVtxBuffer, dstVtxPtr);
 	}
 
 }}
@@ -163,29 +176,22 @@ inline namespace geom {
 
 		DrawableShapeSet r = State::eOutOfDate;
 		r.dr_shape_set_shapes = std::move(shapes);
-		shape_impl::createBuffers(
-			vma,
-			&r.dr_shape_set_vtxBuffer, &r.dr_shape_set_drawBuffer,
-			&r.dr_shape_set_vtxPtr,
-			&r.dr_shape_set_instanceCount,
-			&r.dr_shape_set_vertexCount,
-			&r.dr_shape_set_drawCount,
-			std::span<DrawableShapeInstance>(r.dr_shape_set_shapes.begin(), r.dr_shape_set_shapes.end()) );
+		auto inputData = shape_impl::sortInputData(r.dr_shape_set_shapes);
+		auto sizes     = shape_impl::requiredBufferSizes(inputData);
+		shape_impl::createBuffers(vma, &r.dr_shape_set_vtxBuffer, &r.dr_shape_set_drawBuffer, &r.dr_shape_set_vtxPtr, sizes);
+		r.dr_shape_set_vtxCapacity  = sizes.vtxBytes;
+		r.dr_shape_set_drawCapacity = sizes.drawCmdBytes;
+		r.dr_shape_set_instanceCount = inputData.instances.size();
+		r.dr_shape_set_vertexCount   = inputData.vertices.size();
+		r.dr_shape_set_drawCount     = inputData.drawCmds.size();
+		shape_impl::updateBuffers(vma, r.dr_shape_set_drawBuffer, r.dr_shape_set_vtxPtr, inputData);
+		r.dr_shape_set_instanceSlots = std::move(inputData.instanceSlots);
 		return r;
 	}
 
 
 	DrawableShapeSet DrawableShapeSet::create(VmaAllocator vma, ShapeSet shapes) {
-		auto shapeInstances = std::vector<DrawableShapeInstance>();
-		shapeInstances.reserve(shapes.size());
-		for(auto& shape : shapes) {
-			shapeInstances.push_back(DrawableShapeInstance(
-				std::move(shape.shape),
-				geom::Instance {
-					.color     = shape.color,
-					.transform = shape.transform } ));
-		}
-		return create(vma, std::move(shapeInstances));
+		return create(vma, shape_impl::toShapeInstances(std::move(shapes)));
 	}
 
 
@@ -196,10 +202,67 @@ inline namespace geom {
 			vkutil::Buffer::destroy(vma, shapes.dr_shape_set_drawBuffer);
 		}
 		shapes.dr_shape_set_shapes.clear();
+		shapes.dr_shape_set_instanceSlots.clear();
+		shapes.dr_shape_set_modifiedInstances.clear();
 		shapes.dr_shape_set_state = unsigned(State::eUnitialized);
 	}
 
 
+	void DrawableShapeSet::update(VmaAllocator vma, std::vector<DrawableShapeInstance> shapes) {
+		assert(dr_shape_set_state & 0b100 /* 0b100 = is initialized */);
+		if(shapes.empty()) {
+			destroy(vma, *this);
+			*this = DrawableShapeSet(State::eEmpty);
+			return;
+		}
+
+		if(shape_impl::sameShapes(dr_shape_set_shapes, shapes)) {
+			// Same shapes in the same order, hence the same layout:
+			// only the instances that changed need to be rewritten
+			for(unsigned i = 0; i < shapes.size(); ++i) {
+				auto& dst = dr_shape_set_shapes[i].instance();
+				auto& src = shapes[i].instance();
+				if(0 == memcmp(&dst, &src, sizeof(geom::Instance))) continue;
+				dst = src;
+				dr_shape_set_markModified(i);
+			}
+			return;
+		}
+
+		auto inputData = shape_impl::sortInputData(shapes);
+		auto sizes     = shape_impl::requiredBufferSizes(inputData);
+		bool hasBuffers = dr_shape_set_state & 0b010 /* 0b010 = needs destruction */;
+		bool fits = hasBuffers && (sizes.vtxBytes <= dr_shape_set_vtxCapacity) && (sizes.drawCmdBytes <= dr_shape_set_drawCapacity);
+		if(! fits) {
+			if(hasBuffers) {
+				vmaUnmapMemory(vma, dr_shape_set_vtxBuffer);
+				vkutil::Buffer::destroy(vma, dr_shape_set_vtxBuffer);
+				vkutil::Buffer::destroy(vma, dr_shape_set_drawBuffer);
+			}
+			// Leave room for the set to grow a little before it needs to be reallocated again
+			sizes.vtxBytes     = std::bit_ceil(sizes.vtxBytes);
+			sizes.drawCmdBytes = std::bit_ceil(sizes.drawCmdBytes);
+			shape_impl::createBuffers(vma, &dr_shape_set_vtxBuffer, &dr_shape_set_drawBuffer, &dr_shape_set_vtxPtr, sizes);
+			dr_shape_set_vtxCapacity  = sizes.vtxBytes;
+			dr_shape_set_drawCapacity = sizes.drawCmdBytes;
+		}
+
+		dr_shape_set_shapes = std::move(shapes);
+		dr_shape_set_instanceCount = inputData.instances.size();
+		dr_shape_set_vertexCount   = inputData.vertices.size();
+		dr_shape_set_drawCount     = inputData.drawCmds.size();
+		shape_impl::updateBuffers(vma, dr_shape_set_drawBuffer, dr_shape_set_vtxPtr, inputData);
+		dr_shape_set_instanceSlots = std::move(inputData.instanceSlots);
+		dr_shape_set_modifiedInstances.clear();
+		dr_shape_set_state = unsigned(State::eOutOfDate);
+	}
+
+
+	void DrawableShapeSet::update(VmaAllocator vma, ShapeSet shapes) {
+		update(vma, shape_impl::toShapeInstances(std::move(shapes)));
+	}
+
+
 	void DrawableShapeSet::forceNextCommit() noexcept {
 		switch(State(dr_shape_set_state)) {
 			#ifndef NDEBUG
@@ -208,31 +271,69 @@ inline namespace geom {
 			case State::eUnitialized: std::unreachable(); break;
 			case State::eOutOfDate:   [[fallthrough]];
 			case State::eEmpty:       /* NOP */ break;
+			case State::eModifiedInstances: [[fallthrough]];
 			case State::eUpToDate:    dr_shape_set_state = unsigned(State::eOutOfDate);
 		}
 	}
 
 
 	ModifiableShapeInstance DrawableShapeSet::modifyShapeInstance(unsigned i) noexcept {
-		assert(dr_shape_set_state & 0b100 /* 0b100 = is initialized */);
-		DrawableShapeSet::forceNextCommit();
-		auto ptr = shape_impl::bufferInstancesPtr(dr_shape_set_vtxPtr) + i;
-		return { ptr->color, ptr->transform };
+		assert(dr_shape_set_state & 0b010 /* 0b010 = has buffers */);
+		assert(i < dr_shape_set_shapes.size());
+		dr_shape_set_markModified(i);
+		auto& inst = dr_shape_set_shapes[i].instance();
+		return { inst.color, inst.transform };
+	}
+
+
+	void DrawableShapeSet::dr_shape_set_markModified(unsigned i) noexcept {
+		if(State(dr_shape_set_state) == State::eUpToDate) dr_shape_set_state = unsigned(State::eModifiedInstances);
+		auto& modified = dr_shape_set_modifiedInstances;
+		if(! modified.empty() && modified.back() == i) return;
+		modified.push_back(i);
+		if(modified.size() > dr_shape_set_instanceCount) {
+			// The same instances are being modified over and over without being committed
+			std::sort(modified.begin(), modified.end());
+			modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+		}
 	}
 
 
 	void DrawableShapeSet::dr_shape_set_commitBuffers(VmaAllocator vma) {
-		VkDeviceSize instanceBytes = dr_shape_set_instanceCount * sizeof(geom::Instance);
-		VkDeviceSize vertexBytes   = dr_shape_set_vertexCount * sizeof(PolyVertex);
-		VkDeviceSize drawCmdBytes  = dr_shape_set_drawCount * sizeof(VkDrawIndirectCommand);
-		VK_CHECK(vmaFlushAllocation, vma, dr_shape_set_vtxBuffer, 0, instanceBytes + vertexBytes);
-		VK_CHECK(vmaFlushAllocation, vma, dr_shape_set_drawBuffer, 0, drawCmdBytes);
+		// Copy the modified instances to their slots, and find the range they span
+		auto* instances = shape_impl::bufferInstancesPtr(dr_shape_set_vtxPtr);
+		uint32_t minSlot = UINT32_MAX;
+		uint32_t maxSlot = 0;
+		for(unsigned i : dr_shape_set_modifiedInstances) {
+			uint32_t slot = dr_shape_set_instanceSlots[i];
+			memcpy(instances + slot, &dr_shape_set_shapes[i].instance(), sizeof(geom::Instance));
+			minSlot = std::min(minSlot, slot);
+			maxSlot = std::max(maxSlot, slot);
+		}
+		dr_shape_set_modifiedInstances.clear();
+
 		switch(State(dr_shape_set_state)) {
 			#ifndef NDEBUG
 				default:
 			#endif
 			case State::eUnitialized: std::unreachable(); break;
-			case State::eOutOfDate:   dr_shape_set_state = unsigned(State::eUpToDate); break;
+			case State::eOutOfDate: {
+				VkDeviceSize instanceBytes = dr_shape_set_instanceCount * sizeof(geom::Instance);
+				VkDeviceSize vertexBytes   = dr_shape_set_vertexCount * sizeof(geom::Vertex);
+				VkDeviceSize drawCmdBytes  = dr_shape_set_drawCount * sizeof(VkDrawIndirectCommand);
+				VK_CHECK(vmaFlushAllocation, vma, dr_shape_set_vtxBuffer, 0, instanceBytes + vertexBytes);
+				VK_CHECK(vmaFlushAllocation, vma, dr_shape_set_drawBuffer, 0, drawCmdBytes);
+				dr_shape_set_state = unsigned(State::eUpToDate);
+			} break;
+			case State::eModifiedInstances: {
+				// Neither the vertices nor the draw commands changed
+				if(minSlot <= maxSlot) {
+					VkDeviceSize offset = minSlot * sizeof(geom::Instance);
+					VkDeviceSize bytes  = (maxSlot + 1 - minSlot) * sizeof(geom::Instance);
+					VK_CHECK(vmaFlushAllocation, vma, dr_shape_set_vtxBuffer, offset, bytes);
+				}
+				dr_shape_set_state = unsigned(State::eUpToDate);
+			} break;
 			case State::eEmpty:       [[fallthrough]];
 			case State::eUpToDate:    /* NOP */ break;
 		}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace geom {
+
+	/// \brief Packs rectangles into a fixed-size area, never moving them.
+	///
+	/// The packer only remembers the "skyline", the upper profile of the
+	/// rectangles that were inserted so far; each rectangle is placed where its
+	/// top edge is the lowest, which keeps the profile flat.
+	/// Placements only depend on the sequence of insertions and resizes.
+	///
+	class SkylinePacker {
+	public:
+		using coord_t = uint32_t;
+
+		struct Rect {
+			coord_t x;
+			coord_t y;
+			coord_t width;
+			coord_t height;
+		};
+
+		struct Segment {
+			coord_t x;
+			coord_t y;
+			coord_t width;
+		};
+
+		SkylinePacker() = default;
+
+		SkylinePacker(coord_t width, coord_t height):
+			skl_segments({ Segment { 0, 0, width } }),
+			skl_usedArea(0),
+			skl_width(width),
+			skl_height(height)
+		{ }
+
+		/// \brief Finds a place for a `width` by `height` rectangle.
+		/// \returns `false` if the rectangle does not fit, in which case `dst` is not modified.
+		///
+		bool insert(coord_t width, coord_t height, Rect& dst) {
+			if(width < 1 || height < 1 || width > skl_width || height > skl_height) return false;
+
+			constexpr size_t noSegment = std::numeric_limits<size_t>::max();
+			size_t  bestSegment = noSegment;
+			coord_t bestTop     = std::numeric_limits<coord_t>::max();
+			coord_t bestWidth   = std::numeric_limits<coord_t>::max();
+			coord_t bestY       = 0;
+
+			for(size_t i = 0; i < skl_segments.size(); ++i) {
+				coord_t y;
+				if(! fitAt(i, width, height, y)) continue;
+				coord_t top = y + height;
+				if(top < bestTop || (top == bestTop && skl_segments[i].width < bestWidth)) {
+					bestSegment = i;
+					bestTop     = top;
+					bestWidth   = skl_segments[i].width;
+					bestY       = y;
+				}
+			}
+
+			if(bestSegment == noSegment) return false;
+			dst = { skl_segments[bestSegment].x, bestY, width, height };
+			raise(bestSegment, dst);
+			skl_usedArea += uint64_t(width) * uint64_t(height);
+			return true;
+		}
+
+		/// \brief Enlarges the area; the rectangles that were already inserted keep their place.
+		///
+		void grow(coord_t newWidth, coord_t newHeight) {
+			if(newWidth > skl_width) {
+				if(skl_segments.back().y == 0) skl_segments.back().width += newWidth - skl_width;
+				else skl_segments.push_back({ skl_width, 0, newWidth - skl_width });
+				skl_width = newWidth;
+			}
+			if(newHeight > skl_height) skl_height = newHeight;
+		}
+
+		void reset(coord_t width, coord_t height) {
+			*this = SkylinePacker(width, height);
+		}
+
+		coord_t width()  const noexcept { return skl_width; }
+		coord_t height() const noexcept { return skl_height; }
+		uint64_t usedArea() const noexcept { return skl_usedArea; }
+		const std::vector<Segment>& skyline() const noexcept { return skl_segments; }
+
+		/// \returns The fraction of the area that is covered by rectangles.
+		///
+		double occupancy() const noexcept {
+			if(skl_width < 1 || skl_height < 1) return 0.0;
+			return double(skl_usedArea) / (double(skl_width) * double(skl_height));
+		}
+
+	private:
+		std::vector<Segment> skl_segments; // Sorted by `x`, they cover the whole width without overlapping
+		uint64_t skl_usedArea;
+		coord_t  skl_width;
+		coord_t  skl_height;
+
+		// Finds the lowest `y` at which a rectangle, whose left edge is the one of the segment, would not overlap the skyline
+		bool fitAt(size_t segmentIdx, coord_t width, coord_t height, coord_t& y) const noexcept {
+			coord_t x = skl_segments[segmentIdx].x;
+			if(x + width > skl_width) return false;
+			y = 0;
+			coord_t remaining = width;
+			for(size_t i = segmentIdx; remaining > 0; ++i) {
+				const auto& segm = skl_segments[i];
+				if(segm.y > y) y = segm.y;
+				if(y + height > skl_height) return false;
+				remaining -= std::min(remaining, segm.width);
+			}
+			return true;
+		}
+
+		// Replaces the segments covered by `rect` with its top edge
+		void raise(size_t segmentIdx, const Rect& rect) {
+			coord_t rectEnd = rect.x + rect.width;
+			skl_segments.insert(skl_segments.begin() + segmentIdx, Segment { rect.x, rect.y + rect.height, rect.width });
+
+			size_t i = segmentIdx + 1;
+			while(i < skl_segments.size() && skl_segments[i].x < rectEnd) {
+				auto& segm = skl_segments[i];
+				coord_t segmEnd = segm.x + segm.width;
+				if(segmEnd <= rectEnd) {
+					skl_segments.erase(skl_segments.begin() + i);
+				} else {
+					segm.width = segmEnd - rectEnd;
+					segm.x     = rectEnd;
+					break;
+				}
+			}
+
+			// Merge neighbors at the same height
+			for(i = (segmentIdx > 0)? segmentIdx - 1 : 0; i + 1 < skl_segments.size() && i <= segmentIdx + 1; ) {
+				if(skl_segments[i].y == skl_segments[i+1].y) {
+					skl_segments[i].width += skl_segments[i+1].width;
+					skl_segments.erase(skl_segments.begin() + i + 1);
+				} else {
+					++ i;
+				}
+			}
+		}
+	};
+
+}}
@@ -1,9 +1,14 @@
 #include "core.hpp"
+#include "sdf.hpp"
 
 #include <vulkan/vulkan.h>
 
 #include <vk-util/error.hpp>
 
+#include <zone-profiler/zone_profiler.hpp>
+
+#include <algorithm>
+#include <bit>
 #include <random>
 
 #include <fmt/format.h>
@@ -64,6 +69,14 @@ inline namespace geom {
 	}
 
 
+	std::pair<GlyphBitmap, codepoint_t> FontFace::getGlyphSdf(codepoint_t c, unsigned spread) {
+		codepoint_t index = FT_Get_Char_Index(font_face.value, c);
+		if(index == 0) [[unlikely]] { index = FT_Get_Char_Index(font_face.value, unknownCharReplacement); }
+		if(index == 0) [[unlikely]] { throw std::runtime_error(fmt::format("failed to map required character '{}'", unknownCharReplacement)); }
+		return std::pair(getGlyphSdfByIndex(index, spread), index);
+	}
+
+
 	GlyphBitmap FontFace::getGlyphBitmapByIndex(codepoint_t index) {
 		auto error = FT_Load_Glyph(font_face.value, index, FT_LOAD_DEFAULT);
 		if(error) throw FontError(fmt::format("failed to load glyph #0x{:x}", uintmax_t(index)), error);
@@ -97,15 +110,52 @@ inline namespace geom {
 	}
 
 
-	TextCache::TextCache(VkDevice dev, VmaAllocator vma, VkDescriptorSetLayout dsl, std::shared_ptr<FontFace> font, unsigned short pixelHeight):
+	GlyphBitmap FontFace::getGlyphSdfByIndex(codepoint_t index, unsigned spread) {
+		// The distance field is computed from an antialiased bitmap, regardless of `font_useGrayscale`
+		auto error = FT_Load_Glyph(font_face.value, index, FT_LOAD_DEFAULT);
+		if(error) throw FontError(fmt::format("failed to load glyph #0x{:x}", uintmax_t(index)), error);
+		error = FT_Render_Glyph(font_face.value->glyph, FT_RENDER_MODE_NORMAL);
+		if(error) throw FontError(fmt::format("failed to render glyph #0x{:x}", uintmax_t(index)), error);
+		assert(font_face.value->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY);
+
+		GlyphBitmap ins;
+		auto* ftGlyph = font_face.value->glyph;
+		assert((ftGlyph->bitmap.pitch >= 0) && "I don't know how to deal with a negative pitch");
+		ins.xBaseline = ftGlyph->bitmap_left - int(spread);
+		ins.yBaseline = ftGlyph->bitmap_top  + int(spread);
+		ins.xAdvance  = ftGlyph->linearHoriAdvance >> 16;
+		ins.yAdvance  = ftGlyph->linearVertAdvance >> 16;
+		ins.isGrayscale = true;
+		if(ftGlyph->bitmap.width < 1 || ftGlyph->bitmap.rows < 1) { // Blank glyphs need no field
+			ins.width = ins.height = ins.pitch = 0;
+			ins.bytes = std::make_unique_for_overwrite<std::byte[]>(0);
+			return ins;
+		}
+		auto field = coverageToSdf(
+			reinterpret_cast<const uint8_t*>(ftGlyph->bitmap.buffer),
+			ftGlyph->bitmap.width, ftGlyph->bitmap.rows, std::abs(ftGlyph->bitmap.pitch),
+			spread );
+		ins.width  = ftGlyph->bitmap.width + (2 * spread);
+		ins.height = ftGlyph->bitmap.rows  + (2 * spread);
+		ins.pitch  = ins.width;
+		ins.bytes  = std::make_unique_for_overwrite<std::byte[]>(ins.byteCount());
+		memcpy(ins.bytes.get(), field.data(), ins.byteCount());
+		return ins;
+	}
+
+
+	TextCache::TextCache(VkDevice dev, VmaAllocator vma, VkDescriptorSetLayout dsl, std::shared_ptr<FontFace> font, unsigned short pixelHeight, unsigned short sdfSpread):
 		txtcache_font(std::move(font)),
 		txtcache_dev(dev),
 		txtcache_vma(vma),
+		txtcache_imageView(nullptr),
+		txtcache_sampler(nullptr),
 		txtcache_lock(nullptr),
 		txtcache_imageExt({ }),
-		txtcache_stagingBufferSize(0),
 		txtcache_updateCounter(0),
+		txtcache_remapCounter(0),
 		txtcache_pixelHeight(pixelHeight),
+		txtcache_sdfSpread(sdfSpread),
 		txtcache_imageUpToDate(false)
 	{
 		{ // Descriptor pool
@@ -126,325 +176,382 @@ inline namespace geom {
 			dsaInfo.pSetLayouts = &dsl;
 			VK_CHECK(vkAllocateDescriptorSets, txtcache_dev.value, &dsaInfo, &txtcache_dset);
 		}
+
+		{ // Sampler
+			VkSamplerCreateInfo scInfo = { };
+			scInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			scInfo.magFilter = scInfo.minFilter = (sdfSpread > 0)? VK_FILTER_LINEAR : VK_FILTER_NEAREST; // Distance fields are meant to be interpolated
+			scInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			scInfo.addressModeU = scInfo.addressModeV = scInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+			scInfo.anisotropyEnable = true;
+			scInfo.maxAnisotropy = 1.0f;
+			scInfo.maxLod = 1.0f;
+			VK_CHECK(vkCreateSampler, txtcache_dev.value, &scInfo, nullptr, &txtcache_sampler);
+		}
 	}
 
 
 	TextCache::~TextCache() {
 		if(txtcache_dev.value != nullptr) {
+			for(auto& retired : txtcache_retired) txtcache_destroyRetired(retired);
+			txtcache_retired.clear();
 			vkDestroyDescriptorPool(txtcache_dev.value, txtcache_dpool, nullptr);
+			vkDestroySampler(txtcache_dev.value, txtcache_sampler, nullptr);
 			if(txtcache_image.value.value != nullptr) {
-				vkDestroySampler(txtcache_dev.value, txtcache_sampler, nullptr);
 				vkDestroyImageView(txtcache_dev.value, txtcache_imageView, nullptr);
 				vkutil::Image::destroy(txtcache_vma, txtcache_image.value);
 			}
-			if(txtcache_stagingBuffer.value.value != nullptr) {
-				vkutil::Buffer::destroy(txtcache_vma, txtcache_stagingBuffer.value);
-			}
 		}
 	}
 
 
 	void TextCache::syncWithFence(VkFence fence) noexcept {
 		assert(fence != nullptr);
-		if(txtcache_lock != nullptr) vkWaitForFences(txtcache_dev.value, 1, &txtcache_lock, VK_TRUE, UINT64_MAX);
+		// Fences are only polled here: draws that are known to be complete stop
+		// holding the image, the others are waited upon only if it is replaced
+		std::erase_if(txtcache_pendingFences, [&](VkFence pending) {
+			return (pending == fence) || (VK_SUCCESS == vkGetFenceStatus(txtcache_dev.value, pending));
+		});
+		txtcache_pendingFences.push_back(fence);
 		txtcache_lock = fence;
+		for(auto& retired : txtcache_retired) if(retired.fence == nullptr) retired.fence = fence;
+	}
+
+
+	void TextCache::forgetFence(VkFence fence) noexcept {
+		if(fence == nullptr) return;
+		if(txtcache_lock == fence) txtcache_lock = nullptr;
+		std::erase(txtcache_pendingFences, fence);
+		std::erase_if(txtcache_retired, [&](RetiredResources& retired) {
+			if(retired.fence != fence) return false;
+			txtcache_destroyRetired(retired);
+			return true;
+		});
+	}
+
+
+	void TextCache::forgetFence() noexcept {
+		auto pending = std::move(txtcache_pendingFences);
+		txtcache_pendingFences.clear();
+		for(VkFence fence : pending) forgetFence(fence);
+		forgetFence(txtcache_lock);
+	}
+
+
+	void TextCache::txtcache_destroyRetired(RetiredResources& retired) noexcept {
+		if(retired.stagingBuffer.value != nullptr) vkutil::Buffer::destroy(txtcache_vma, retired.stagingBuffer);
+		if(retired.image.value != nullptr) {
+			vkDestroyImageView(txtcache_dev.value, retired.imageView, nullptr);
+			vkutil::Image::destroy(txtcache_vma, retired.image);
+		}
+	}
+
+
+	void TextCache::txtcache_collectRetired() noexcept {
+		std::erase_if(txtcache_retired, [&](RetiredResources& retired) {
+			if(retired.fence == nullptr) return false;
+			if(VK_SUCCESS != vkGetFenceStatus(txtcache_dev.value, retired.fence)) return false;
+			txtcache_destroyRetired(retired);
+			return true;
+		});
 	}
 
 
 	void TextCache::updateImage(VkCommandBuffer cmd) noexcept {
-		using InsMap = std::unordered_map<codepoint_t, GlyphBitmap>;
-		using InsPair = InsMap::value_type;
-		using Layout = std::unordered_map<codepoint_t, std::vector<codepoint_t>>;
-		using LayoutPair = Layout::value_type;
-		using UnknownCpSet = std::unordered_set<codepoint_t>;
-		using coord_t = uint32_t;
+		SKENGINE_ZONE("TextCache::updateImage");
+		using NewGlyph = std::pair<codepoint_t, GlyphBitmap>;
+		using Rect = SkylinePacker::Rect;
+		using coord_t = SkylinePacker::coord_t;
+		constexpr coord_t glyphPadding = 1; // Keeps the glyphs from sampling their neighbors (distance fields are also padded by the spread)
+		constexpr VkFormat imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+		if(! txtcache_retired.empty()) txtcache_collectRetired();
 
 		{ // Early return check
-			bool updateRequested     = ! (txtcache_charQueue.empty() && txtcache_imageUpToDate);
-			bool fallbackCharMissing = txtcache_charMap.empty();
-			if(! (updateRequested || fallbackCharMissing)) {
+			bool updateRequested = ! (txtcache_charQueue.empty() && txtcache_imageUpToDate);
+			bool imageMissing    = txtcache_image.value.value == nullptr;
+			if(! (updateRequested || imageMissing)) {
 				// Even if the queue is empty, the fallback character is always inserted; this
 				// ensures that a valid VkImage always exists upon calling this function.
 				// This is why the function should not return immediately when no character
 				// is cached.
-				txtcache_lock = nullptr;
 				return;
 			}
 		}
 
 		auto queue = std::move(txtcache_charQueue);
-		assert(txtcache_charQueue.empty());
+		txtcache_charQueue.clear();
 
-		if(! (queue.empty() && txtcache_imageUpToDate)) {
+		// If the pixel height changed or some characters were trimmed, start over
+		bool rebuild = (! txtcache_imageUpToDate) || (txtcache_image.value.value == nullptr);
+		if(rebuild) {
 			for(auto& mapping : txtcache_charMap) queue.insert(mapping.first);
+			txtcache_charMap.clear();
+			txtcache_charRects.clear();
+			coord_t side = std::bit_ceil(std::max<coord_t>(64, coord_t(txtcache_pixelHeight) * 8));
+			txtcache_packer.reset(side, side);
 		}
+		if(! txtcache_charMap.contains(unknownCharReplacement)) queue.insert(unknownCharReplacement);
 
-		Layout layout;
-		InsMap ins;
-		UnknownCpSet unknownChars;
-		codepoint_t fallbackCp;
-		coord_t maxWidth = 0;
-		coord_t maxHeight = 0;
-		coord_t maxRowWidth = 0;
-		codepoint_t charCountSqrt = std::max<codepoint_t>(1, std::sqrt(double(queue.size())));
-		ins.max_load_factor(1.0f);
-		ins.rehash(std::ceil(float(queue.size()) * 1.3f));
+		txtcache_font->setPixelSize(0, txtcache_pixelHeight);
 
-		++ txtcache_updateCounter;
-		txtcache_charMap.clear();
-		txtcache_charMap.rehash(maxRowWidth * layout.size());
-
-		auto appendToRow = [&](codepoint_t c, const GlyphBitmap& bmp) {
-			codepoint_t plane = c / charCountSqrt;
-			auto row = layout.find(plane);
-			if(row == layout.end()) {
-				row = layout.insert(LayoutPair(plane, { })).first;
-				row->second.reserve(32);
-			}
-			row->second.push_back(c);
-			maxRowWidth = std::max<coord_t>(row->second.size(), maxRowWidth);
-			maxWidth    = std::max<coord_t>(bmp.width,  maxWidth);
-			maxHeight   = std::max<coord_t>(bmp.height, maxHeight);
+		auto rasterize = [&](codepoint_t index) {
+			return usesSdf()? txtcache_font->getGlyphSdfByIndex(index, txtcache_sdfSpread) : txtcache_font->getGlyphBitmapByIndex(index);
 		};
 
-		{ // Fallback character
-			auto bmpRes = txtcache_font->getGlyphBitmap(unknownCharReplacement);
-			fallbackCp = unknownCharReplacement;
-			auto& bmp = ins.insert(InsPair(unknownCharReplacement, std::move(bmpRes.first))).first->second;
-			appendToRow(fallbackCp, bmp);
-			queue.erase(unknownCharReplacement);
-		}
-
-		txtcache_font->setPixelSize(0, txtcache_pixelHeight);
-
+		// Only rasterize the characters that are not cached yet
+		std::vector<NewGlyph> newGlyphs;
+		std::vector<codepoint_t> unknownChars;
+		newGlyphs.reserve(queue.size());
 		for(codepoint_t c : queue) {
-			auto bmpIdx = FT_Get_Char_Index(*txtcache_font, c);
-			if(bmpIdx == 0) {
-				unknownChars.insert(c);
-			} else {
-				auto  bmpRes = txtcache_font->getGlyphBitmapByIndex(bmpIdx);
-				auto& bmp = ins.insert(InsPair(c, bmpRes)).first->second;
-				appendToRow(c, bmp);
+			if(txtcache_charMap.contains(c)) continue;
+			if(c == codepoint_t(unknownCharReplacement)) {
+				newGlyphs.emplace_back(c, usesSdf()? txtcache_font->getGlyphSdf(c, txtcache_sdfSpread).first : txtcache_font->getGlyphBitmap(c).first);
+				continue;
 			}
+			auto bmpIdx = FT_Get_Char_Index(*txtcache_font, c);
+			if(bmpIdx == 0) unknownChars.push_back(c);
+			else newGlyphs.emplace_back(c, rasterize(bmpIdx));
 		}
 
-		if(txtcache_lock != nullptr) {
-			VK_CHECK(vkWaitForFences, txtcache_dev.value, 1, &txtcache_lock, VK_TRUE, UINT64_MAX);
-			txtcache_lock = nullptr;
-		}
-
-		{ // If the image already exists, destroy everything
-			if(txtcache_image.value.value != nullptr) {
-				vkDestroySampler(txtcache_dev.value, txtcache_sampler, nullptr);
-				vkDestroyImageView(txtcache_dev.value, txtcache_imageView, nullptr);
-				vkutil::Image::destroy(txtcache_vma, txtcache_image.value);
+		// Tallest glyphs first, for a flatter skyline; the codepoint makes the order deterministic
+		std::sort(newGlyphs.begin(), newGlyphs.end(), [](const NewGlyph& l, const NewGlyph& r) {
+			if(l.second.height != r.second.height) return l.second.height > r.second.height;
+			if(l.second.width  != r.second.width ) return l.second.width  > r.second.width;
+			return l.first < r.first;
+		});
+
+		bool grown = false;
+		VkExtent2D prevExtent = txtcache_imageExt;
+		std::vector<Rect> newRects;
+		VkDeviceSize stagingSize = 0;
+		newRects.reserve(newGlyphs.size());
+		for(auto& glyph : newGlyphs) {
+			auto& bmp = glyph.second;
+			if(bmp.width < 1 || bmp.height < 1) { newRects.push_back({ 0, 0, 0, 0 }); continue; }
+			Rect padded;
+			while(! txtcache_packer.insert(bmp.width + glyphPadding, bmp.height + glyphPadding, padded)) {
+				// Double the shorter side, existing glyphs keep their place
+				auto w = txtcache_packer.width();
+				auto h = txtcache_packer.height();
+				if(w <= h) txtcache_packer.grow(w * 2, h);
+				else       txtcache_packer.grow(w, h * 2);
+				grown = true;
 			}
+			newRects.push_back({ padded.x, padded.y, bmp.width, bmp.height });
+			stagingSize += VkDeviceSize(bmp.width) * VkDeviceSize(bmp.height) * 4; // The glyph has a 1-byte grayscale texel, the image wants a 4-byte RGBA texel because GLSL said so
 		}
 
-		{ // Create the image
-			auto& charWidth  = maxWidth;
-			auto& charHeight = maxHeight;
-			auto& rowWidth   = maxRowWidth;
-			float fCharWidth  = charWidth;
-			float fCharHeight = charHeight;
+		bool recreateImage = rebuild || grown;
+		txtcache_imageExt = { txtcache_packer.width(), txtcache_packer.height() };
+		float fImgWidth  = txtcache_imageExt.width;
+		float fImgHeight = txtcache_imageExt.height;
+
+		auto setUvs = [&](CharDescriptor& desc, const Rect& rect) {
+			desc.topLeftUv[0]     = float(rect.x) / fImgWidth;
+			desc.topLeftUv[1]     = float(rect.y) / fImgHeight;
+			desc.bottomRightUv[0] = float(rect.x + rect.width ) / fImgWidth;
+			desc.bottomRightUv[1] = float(rect.y + rect.height) / fImgHeight;
+		};
+
+		++ txtcache_updateCounter;
+		if(recreateImage) ++ txtcache_remapCounter; // Every UV changes, even if the glyphs did not move
+
+		if(grown && ! rebuild) { // Existing glyphs did not move, but the image did grow
+			for(auto& mapping : txtcache_charMap) setUvs(mapping.second, txtcache_charRects.find(mapping.first)->second);
+		}
 
+		util::Moveable<vkutil::Image> prevImage = std::move(txtcache_image);
+		VkImageView prevImageView = txtcache_imageView;
+		if(recreateImage) { // Allocate the new image
 			vkutil::ImageCreateInfo icInfo = { };
-			assert(layout.size() < UINT_MAX); // There are less than 1024 Unicode planes, I believe
-			icInfo.extent = { charWidth * rowWidth, charHeight * unsigned(layout.size()), 1 };
-			txtcache_imageExt = { icInfo.extent.width, icInfo.extent.height };
-			VkDeviceSize imageByteSize = icInfo.extent.width * icInfo.extent.height * 4; // The glyph has a 1-byte grayscale texel, the image wants a 4-byte RGBA texel because GLSL said so
-
-			{ // Enlarge the staging buffer, if necessary
-				vkutil::BufferCreateInfo bcInfo = { };
-				bcInfo.size  = imageByteSize;
-				bcInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				bool bufferExists   = ! (txtcache_stagingBuffer.value.value == nullptr);
-				bool bufferTooSmall = txtcache_stagingBufferSize < imageByteSize;
-				// Buffer exists and is big enough => don't destroy it, don't create it
-				// Buffer exists and is too small  => destroy it; then it needs to be recreated
-				// Buffer does not exist           => create it
-				if(bufferExists && bufferTooSmall) {
-					vkutil::Buffer::destroy(txtcache_vma, txtcache_stagingBuffer.value);
-					bufferExists = false;
-				}
-				if(! bufferExists) {
-					txtcache_stagingBuffer = vkutil::ManagedBuffer::createStagingBuffer(txtcache_vma, bcInfo);
-					txtcache_stagingBufferSize = bcInfo.size;
-				}
-			}
+			icInfo.extent = { txtcache_imageExt.width, txtcache_imageExt.height, 1 };
+			icInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			icInfo.format = imageFormat;
+			icInfo.type = VK_IMAGE_TYPE_2D;
+			icInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			icInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			icInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			icInfo.arrayLayers = 1;
+			icInfo.mipLevels = 1;
+			vkutil::AllocationCreateInfo acInfo = { };
+			acInfo.requiredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			acInfo.vmaFlags = { };
+			acInfo.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
+			txtcache_image = vkutil::Image::create(txtcache_vma, icInfo, acInfo);
 
-			float fImgWidth;
-			float fImgHeight;
-			{ // Allocate the image
-				icInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-				icInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-				icInfo.type = VK_IMAGE_TYPE_2D;
-				icInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				icInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-				icInfo.tiling = VK_IMAGE_TILING_LINEAR;
-				icInfo.arrayLayers = 1;
-				icInfo.mipLevels = 1;
-				fImgWidth  = icInfo.extent.width;
-				fImgHeight = icInfo.extent.height;
-				vkutil::AllocationCreateInfo acInfo = { };
-				acInfo.requiredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-				acInfo.vmaFlags = { };
-				acInfo.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
-				txtcache_image = vkutil::Image::create(txtcache_vma, icInfo, acInfo);
-			}
+			VkImageViewCreateInfo ivcInfo = { };
+			ivcInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			ivcInfo.image = txtcache_image.value;
+			ivcInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			ivcInfo.format = imageFormat;
+			ivcInfo.components = { };
+			ivcInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			ivcInfo.subresourceRange.levelCount = 1;
+			ivcInfo.subresourceRange.layerCount = 1;
+			VK_CHECK(vkCreateImageView, txtcache_dev.value, &ivcInfo, nullptr, &txtcache_imageView);
+		} else {
+			txtcache_image = std::move(prevImage);
+		}
 
-			void* devGlyphPtr;
-			VK_CHECK(vmaMapMemory, txtcache_vma, txtcache_stagingBuffer.value, &devGlyphPtr);
-			size_t slotRowStride = icInfo.extent.width;
-			memset(devGlyphPtr, 0, imageByteSize);
-			auto pixelOffset = [&](unsigned xSlot, unsigned ySlot, unsigned xPix, unsigned yPix) {
-				// 0 - - - 0 - - - 0                       0 - - - 0 - - - 0
-				// |       |       |                       |   C...|.......|
-				// |   A...|.......|                       |...D   |       |
-				// |.......|.......|                       |       |       |
-				// 0 - - - 0 - - - 0                       0 - - - 0 - - - 0
-				// |.......|.......|                       |       |       |
-				// |...B   |       |                       |   E...|...F   |
-				// |       |       |                       |       |       |
-				// 0 - - - 0 - - - 0                       0 - - - 0 - - - 0
-				//
-				// ^^^ 1 row = stride * rows per slot * slots;
-				//                        1 row = stride * rows per slot ^^^
-				//                        1 col = cols per slot
-				auto offset =
-					+ (4 * ySlot * slotRowStride * charHeight)
-					+ (4 * yPix * slotRowStride)
-					+ (4 * xSlot * charWidth)
-					+ (4 * xPix);
-				assert(offset < imageByteSize);
-				return offset;
-			};
-			auto pixelAt = [&](unsigned xSlot, unsigned ySlot, unsigned xPix, unsigned yPix) {
-				return reinterpret_cast<uint8_t*>(devGlyphPtr) + pixelOffset(xSlot, ySlot, xPix, yPix);
-			};
-			auto copyChar = [&](unsigned xSlot, unsigned ySlot, codepoint_t c) {
-				#ifndef NDEBUG
-					auto& bmp = ins.find(c)->second;
-				#else
-					auto bmpIter = ins.find(c);
-					assert(bmpIter != ins.end());
-					auto& bmp = bmpIter->second;
-				#endif
-				if(txtcache_font->usesGrayscale()) {
-					for(size_t yPix = 0; yPix < bmp.height; ++yPix)
-					for(size_t xPix = 0; xPix < bmp.width;  ++xPix) {
-						auto v = uint8_t(bmp.bytes[(yPix * bmp.width) + xPix]);
-						auto pixel = pixelAt(xSlot, ySlot, xPix, yPix);
-						pixel[0] = pixel[1] = pixel[2] = 0xff;
-						pixel[3] = v;
-					}
-				} else {
-					for(size_t yPix = 0; yPix < bmp.height; ++yPix)
-					for(size_t xPix = 0; xPix < bmp.width;  ++xPix) {
-						auto i = (yPix * bmp.pitch) + (xPix / 8);
-						auto byte = uint8_t(bmp.bytes[i]);
-						auto pixel = pixelAt(xSlot, ySlot, xPix, yPix);
-						pixel[0] = pixel[1] = pixel[2] = 0xff;
+		vkutil::Buffer stagingBuffer = { };
+		std::vector<VkBufferImageCopy> copies;
+		if(stagingSize > 0) { // Write the new glyphs to a staging buffer, one after the other
+			vkutil::BufferCreateInfo bcInfo = { };
+			bcInfo.size  = stagingSize;
+			bcInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingBuffer = vkutil::ManagedBuffer::createStagingBuffer(txtcache_vma, bcInfo);
+			copies.reserve(newGlyphs.size());
+
+			auto* dst = stagingBuffer.map<uint8_t>(txtcache_vma);
+			VkDeviceSize cursor = 0;
+			for(size_t i = 0; i < newGlyphs.size(); ++i) {
+				auto& bmp  = newGlyphs[i].second;
+				auto& rect = newRects[i];
+				if(rect.width < 1) continue;
+				auto* pixels = dst + cursor;
+				for(size_t yPix = 0; yPix < bmp.height; ++yPix)
+				for(size_t xPix = 0; xPix < bmp.width;  ++xPix) {
+					auto pixel = pixels + (4 * ((yPix * bmp.width) + xPix));
+					pixel[0] = pixel[1] = pixel[2] = 0xff;
+					if(bmp.isGrayscale) {
+						pixel[3] = uint8_t(bmp.bytes[(yPix * bmp.width) + xPix]);
+					} else {
+						auto byte = uint8_t(bmp.bytes[(yPix * bmp.pitch) + (xPix / 8)]);
 						pixel[3] = ((byte >> (7 - (xPix % 8))) & 1) * 0xff;
 					}
 				}
-				float fBmpSize[2] = { float(bmp.width), float(bmp.height) };
-				float topLeft[2] = {
-					(float(xSlot) * fCharWidth ) / fImgWidth,
-					(float(ySlot) * fCharHeight) / fImgHeight };
-				float bottomRight[2] = {
-					((float(xSlot) * fCharWidth ) + fBmpSize[0]) / fImgWidth,
-					((float(ySlot) * fCharHeight) + fBmpSize[1]) / fImgHeight };
-				txtcache_charMap.insert(CharMap::value_type(
-					c,
-					CharDescriptor {
-						.topLeftUv { topLeft[0], topLeft[1] },
-						.bottomRightUv { bottomRight[0], bottomRight[1] },
-						.size { fBmpSize[0] / float(txtcache_pixelHeight), fBmpSize[1] / float(txtcache_pixelHeight) },
-						.baseline {
-							float(bmp.xBaseline) / float(txtcache_pixelHeight),
-							float(bmp.yBaseline) / float(txtcache_pixelHeight) },
-						.advance {
-							float(bmp.xAdvance) / float(txtcache_pixelHeight),
-							float(bmp.yAdvance) / float(txtcache_pixelHeight) } }));
-			};
-			for(unsigned y = 0; auto& row : layout) {
-				for(unsigned x = 0; codepoint_t c : row.second) {
-					copyChar(x, y, c);
-					++ x;
-				}
-				++ y;
+				VkBufferImageCopy cp = { };
+				cp.bufferOffset = cursor;
+				cp.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				cp.imageSubresource.layerCount = 1;
+				cp.imageOffset = { int32_t(rect.x), int32_t(rect.y), 0 };
+				cp.imageExtent = { rect.width, rect.height, 1 };
+				copies.push_back(cp);
+				cursor += VkDeviceSize(rect.width) * VkDeviceSize(rect.height) * 4;
 			}
-			vmaUnmapMemory(txtcache_vma, txtcache_stagingBuffer.value);
+			stagingBuffer.unmap(txtcache_vma);
+		}
 
+		{ // Register the new characters
+			auto* fallbackRect = (const Rect*) nullptr;
+			for(size_t i = 0; i < newGlyphs.size(); ++i) {
+				auto& [c, bmp] = newGlyphs[i];
+				auto& rect = newRects[i];
+				float pxHeight = txtcache_pixelHeight;
+				CharDescriptor desc = {
+					.topLeftUv { },
+					.bottomRightUv { },
+					.size { float(bmp.width) / pxHeight, float(bmp.height) / pxHeight },
+					.baseline { float(bmp.xBaseline) / pxHeight, float(bmp.yBaseline) / pxHeight },
+					.advance { float(bmp.xAdvance) / pxHeight, float(bmp.yAdvance) / pxHeight } };
+				setUvs(desc, rect);
+				txtcache_charMap.insert_or_assign(c, desc);
+				auto& insRect = txtcache_charRects.insert_or_assign(c, rect).first->second;
+				if(c == codepoint_t(unknownCharReplacement)) fallbackRect = &insRect;
+			}
 			if(! unknownChars.empty()) {
-				auto& desc = txtcache_charMap.find(fallbackCp)->second;
+				auto& fallbackDesc = txtcache_charMap.find(unknownCharReplacement)->second;
+				if(fallbackRect == nullptr) fallbackRect = &txtcache_charRects.find(unknownCharReplacement)->second;
+				auto rectCp = *fallbackRect;
 				for(codepoint_t c : unknownChars) {
-					txtcache_charMap.insert(CharMap::value_type(c, desc));
+					txtcache_charMap.insert_or_assign(c, fallbackDesc);
+					txtcache_charRects.insert_or_assign(c, rectCp);
 				}
 			}
+		}
 
-			{ // Buffer copies and barriers
-				VkBufferImageCopy cp = { };
-				cp.bufferRowLength   = icInfo.extent.width;
-				cp.bufferImageHeight = icInfo.extent.height;
-				cp.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				cp.imageSubresource.layerCount = 1;
-				cp.imageExtent = icInfo.extent;
-				VkImageMemoryBarrier2 bar0 = { };
-				VkImageMemoryBarrier2 bar1;
-				bar0.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-				bar0.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-				bar0.srcAccessMask = VK_ACCESS_2_NONE;
-				bar0.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				bar0.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
-				bar0.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
-				bar0.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				bar0.image = txtcache_image.value;
-				bar0.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				bar0.subresourceRange.levelCount = 1;
-				bar0.subresourceRange.layerCount = 1;
-				bar1 = bar0;
-				bar1.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
-				bar1.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
-				bar1.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				bar1.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-				bar1.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
-				bar1.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				VkDependencyInfo depInfo = { };
-				depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		if(recreateImage || ! copies.empty()) { // Copies and barriers
+			auto colorRange = VkImageSubresourceRange { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			VkImageMemoryBarrier2 bars[2] = { };
+			bars[0].sType = bars[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			bars[0].subresourceRange = bars[1].subresourceRange = colorRange;
+			VkDependencyInfo depInfo = { };
+			depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			depInfo.pImageMemoryBarriers = bars;
+
+			bars[0].image = txtcache_image.value;
+			bars[0].dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			bars[0].dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			bars[0].newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			if(recreateImage) {
+				bars[0].srcStageMask  = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
+				bars[0].srcAccessMask = VK_ACCESS_2_NONE;
+				bars[0].oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+			} else {
+				// Only the new glyphs are written, the rest of the image is preserved
+				bars[0].srcStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+				bars[0].srcAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+				bars[0].oldLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			}
+			depInfo.imageMemoryBarrierCount = 1;
+			vkCmdPipelineBarrier2(cmd, &depInfo);
+
+			if(recreateImage) {
+				constexpr VkClearColorValue transparent = { };
+				vkCmdClearColorImage(cmd, txtcache_image.value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &transparent, 1, &colorRange);
+				bars[0].srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+				bars[0].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+				bars[0].oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 				depInfo.imageMemoryBarrierCount = 1;
-				depInfo.pImageMemoryBarriers = &bar0;
-				vkCmdPipelineBarrier2(cmd, &depInfo);
-				vkCmdCopyBufferToImage(cmd, txtcache_stagingBuffer.value, txtcache_image.value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cp);
-				depInfo.pImageMemoryBarriers = &bar1;
-				vkCmdPipelineBarrier2(cmd, &depInfo);
+
+				if(grown && ! rebuild) { // Copy the previous glyphs to the larger image
+					assert(prevImage.value.value != nullptr);
+					bars[1].image = prevImage.value;
+					bars[1].srcStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+					bars[1].srcAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+					bars[1].oldLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					bars[1].dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+					bars[1].dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+					bars[1].newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					depInfo.imageMemoryBarrierCount = 2;
+					vkCmdPipelineBarrier2(cmd, &depInfo);
+					VkImageCopy cp = { };
+					cp.srcSubresource = cp.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+					cp.extent = { prevExtent.width, prevExtent.height, 1 };
+					vkCmdCopyImage(cmd,
+						prevImage.value, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						txtcache_image.value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						1, &cp );
+				} else {
+					vkCmdPipelineBarrier2(cmd, &depInfo);
+				}
 			}
+
+			if(! copies.empty()) {
+				vkCmdCopyBufferToImage(cmd, stagingBuffer.value, txtcache_image.value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copies.size(), copies.data());
+			}
+
+			bars[0].srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			bars[0].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			bars[0].oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			bars[0].dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+			bars[0].dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+			bars[0].newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			depInfo.imageMemoryBarrierCount = 1;
+			vkCmdPipelineBarrier2(cmd, &depInfo);
 		}
 
-		{ // Create the image view and sampler
-			VkImageViewCreateInfo ivcInfo = { };
-			ivcInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			ivcInfo.image = txtcache_image.value;
-			ivcInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			ivcInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-			ivcInfo.components = { };
-			ivcInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			ivcInfo.subresourceRange.levelCount = 1;
-			ivcInfo.subresourceRange.layerCount = 1;
-			VK_CHECK(vkCreateImageView, txtcache_dev.value, &ivcInfo, nullptr, &txtcache_imageView);
-			VkSamplerCreateInfo scInfo = { };
-			scInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			scInfo.magFilter = scInfo.minFilter = VK_FILTER_NEAREST;
-			scInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-			scInfo.addressModeU = scInfo.addressModeV = scInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
-			scInfo.anisotropyEnable = true;
-			scInfo.maxAnisotropy = 1.0f;
-			scInfo.maxLod = 1.0f;
-			VK_CHECK(vkCreateSampler, txtcache_dev.value, &scInfo, nullptr, &txtcache_sampler);
+		// The staging buffer and the previous image are still used by
+		// the commands that were just recorded, and by previous frames
+		if(stagingBuffer.value != nullptr || prevImage.value.value != nullptr) {
+			txtcache_retired.push_back(RetiredResources {
+				.fence = nullptr,
+				.stagingBuffer = stagingBuffer,
+				.image = prevImage.value,
+				.imageView = prevImageView });
+			prevImage.value = { };
 		}
 
-		{ // Update the descriptor set
+		if(recreateImage) { // Update the descriptor set, which may be in use by the draws in flight
+			// This is the only blocking wait: the current gframe's fence is signaled
+			// until it is submitted again, so none of these fences is left unsubmitted
+			if(! txtcache_pendingFences.empty()) {
+				SKENGINE_ZONE("text cache descriptor wait");
+				VK_CHECK(vkWaitForFences, txtcache_dev.value, txtcache_pendingFences.size(), txtcache_pendingFences.data(), VK_TRUE, UINT64_MAX);
+				txtcache_pendingFences.clear();
+				txtcache_lock = nullptr;
+			}
 			VkDescriptorImageInfo diInfo = { };
 			diInfo.sampler = txtcache_sampler;
 			diInfo.imageView = txtcache_imageView;
@@ -456,6 +563,7 @@ inline namespace geom {
 			wDset.descriptorCount = 1;
 			wDset.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 			wDset.pImageInfo = &diInfo;
+			SKENGINE_ZONE("text cache vkUpdateDescriptorSets");
 			vkUpdateDescriptorSets(txtcache_dev.value, 1, &wDset, 0, nullptr);
 		}
 
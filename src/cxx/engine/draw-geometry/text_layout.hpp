@@ -0,0 +1,154 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace geom {
+
+	using codepoint_t = char32_t;
+
+
+	struct CharDescriptor {
+		float topLeftUv[2];
+		float bottomRightUv[2];
+		float size[2]; // Relative to the font height
+		float baseline[2];
+		float advance[2];
+	};
+
+
+	struct PositionedGlyph {
+		codepoint_t codepoint;
+		float       penX; // Relative to the font height, from the start of the line
+	};
+
+
+	/// \brief The glyphs of a line of text, placed along its baseline.
+	///
+	struct TextLayout {
+		std::vector<PositionedGlyph> glyphs;
+		float width;
+	};
+
+
+	/// \brief Shares the layouts of identical lines of text.
+	///
+	/// A layout only depends on the advances and kerning of its glyphs, which
+	/// do not change as long as the font and its size do not: lines with the
+	/// same font, size and text reuse the same layout, across elements and frames.
+	///
+	class TextLayoutCache {
+	public:
+		using CharMap   = std::unordered_map<codepoint_t, CharDescriptor>;
+		using Kerning   = std::function<float (codepoint_t left, codepoint_t right)>; // Relative to the font height
+		using LayoutPtr = std::shared_ptr<const TextLayout>;
+
+		/// \brief Returns the layout of `str`, computing it if it is not cached.
+		///
+		/// `chars` must contain every character of `str`; `font` only identifies
+		/// the font face, and is never dereferenced.
+		///
+		LayoutPtr get(const void* font, unsigned short size, std::u32string_view str, const CharMap& chars, const Kerning& kerning = { }) {
+			auto found = lcache_layouts.find(KeyView { font, size, str });
+			if(found != lcache_layouts.end()) {
+				++ lcache_hits;
+				return found->second;
+			}
+
+			++ lcache_misses;
+			bool complete;
+			auto layout = std::make_shared<const TextLayout>(computeLayout(str, chars, kerning, complete));
+			if(complete) lcache_layouts.emplace(Key { font, size, std::u32string(str) }, layout);
+			return layout;
+		}
+
+		/// \brief Forgets the layouts that are not referenced outside of the cache.
+		///
+		/// The cache is only scanned once it has doubled in size since the
+		/// last scan, so that calling this function every frame is cheap.
+		///
+		void trim() {
+			if(lcache_layouts.size() < lcache_trimThreshold) return;
+			std::erase_if(lcache_layouts, [](const auto& entry) { return entry.second.use_count() <= 1; });
+			lcache_trimThreshold = std::max<size_t>(minTrimThreshold, lcache_layouts.size() * 2);
+		}
+
+		void clear() noexcept { lcache_layouts.clear(); lcache_trimThreshold = minTrimThreshold; }
+
+		size_t size()   const noexcept { return lcache_layouts.size(); }
+		size_t hits()   const noexcept { return lcache_hits; }
+		size_t misses() const noexcept { return lcache_misses; }
+
+		static TextLayout computeLayout(std::u32string_view str, const CharMap& chars, const Kerning& kerning, bool& complete) {
+			TextLayout r = { { }, 0.0f };
+			r.glyphs.reserve(str.size());
+			complete = true;
+			float penX = 0.0f;
+			for(size_t i = 0; i < str.size(); ++i) {
+				codepoint_t c = str[i];
+				if(kerning && i > 0) penX += kerning(str[i-1], c);
+				r.glyphs.push_back({ c, penX });
+				auto found = chars.find(c);
+				assert(found != chars.end() && "The characters of a line must be fetched before laying it out");
+				if(found == chars.end()) [[unlikely]] { complete = false; continue; }
+				penX += found->second.advance[0];
+			}
+			r.width = penX;
+			return r;
+		}
+
+	private:
+		static constexpr size_t minTrimThreshold = 64;
+
+		struct KeyView {
+			const void*         font;
+			unsigned short      size;
+			std::u32string_view str;
+		};
+
+		struct Key {
+			const void*    font;
+			unsigned short size;
+			std::u32string str;
+
+			operator KeyView() const noexcept { return { font, size, str }; }
+		};
+
+		struct KeyHash {
+			using is_transparent = void;
+			size_t operator()(const KeyView& k) const noexcept {
+				size_t h = std::hash<std::u32string_view>()(k.str);
+				h = std::rotl(h, 16) ^ std::hash<const void*>()(k.font);
+				h = std::rotl(h, 16) ^ size_t(k.size);
+				return h;
+			}
+			size_t operator()(const Key& k) const noexcept { return operator()(KeyView(k)); }
+		};
+
+		struct KeyEqual {
+			using is_transparent = void;
+			bool operator()(const KeyView& l, const KeyView& r) const noexcept { return l.font == r.font && l.size == r.size && l.str == r.str; }
+			bool operator()(const Key& l, const KeyView& r) const noexcept { return operator()(KeyView(l), r); }
+			bool operator()(const KeyView& l, const Key& r) const noexcept { return operator()(l, KeyView(r)); }
+			bool operator()(const Key& l, const Key& r) const noexcept { return operator()(KeyView(l), KeyView(r)); }
+		};
+
+		std::unordered_map<Key, LayoutPtr, KeyHash, KeyEqual> lcache_layouts;
+		size_t lcache_trimThreshold = minTrimThreshold;
+		size_t lcache_hits   = 0;
+		size_t lcache_misses = 0;
+	};
+
+}}
@@ -9,6 +9,8 @@
 
 #include <vk-util/error.hpp>
 
+#include <zone-profiler/zone_profiler.hpp>
+
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <deque>
@@ -20,6 +22,10 @@
 namespace SKENGINE_NAME_NS {
 namespace {
 
+	#ifdef SKENGINE_GPU_PROFILING
+		constexpr uint_fast64_t gpu_profile_log_interval = 1024; // In gframes
+	#endif
+
 	constexpr tickreg::delta_t choose_delta(tickreg::delta_t avg, tickreg::delta_t last) {
 		using tickreg::delta_t;
 		constexpr auto tolerance_factor = delta_t(1.0) / delta_t(2.0);
@@ -28,6 +34,11 @@ namespace {
 		return avg;
 	}
 
+
+	constexpr tickreg::delta_t fixed_delta(const EnginePreferences& prefs) {
+		return tickreg::delta_t(1.0) / tickreg::delta_t(prefs.target_tickrate);
+	}
+
 }}
 
 
@@ -128,14 +139,16 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 
 
 	static void draw(Engine& e, LoopInterface& loop) {
+		SKENGINE_ZONE("Engine::draw");
 		#define IF_WORLD_RPASS_(RENDERER_) if(RENDERER_->pipelineInfo().rpass == Renderer::RenderPass::eWorld)
 		#define IF_UI_RPASS_(RENDERER_)    if(RENDERER_->pipelineInfo().rpass == Renderer::RenderPass::eUi)
 		using SeqIdx = RenderProcess::SequenceIndex;
 		using seq_idx_e = RenderProcess::seq_idx_e;
 		GframeData* gframe;
 		uint32_t    sc_img_idx = ~ uint32_t(0);
-		auto        delta_avg  = e.mGraphicsReg.estDelta();
-		auto        delta_last = e.mGraphicsReg.lastDelta();
+		bool        fixed      = e.mPrefs.fixed_timestep;
+		auto        delta_avg  = fixed? fixed_delta(e.mPrefs) : e.mGraphicsReg.estDelta();
+		auto        delta_last = fixed? fixed_delta(e.mPrefs) : e.mGraphicsReg.lastDelta();
 		auto        delta      = choose_delta(delta_avg, delta_last);
 		auto        concurrent_access = ConcurrentAccess(&e, true);
 		auto        waves = e.mRenderProcess.waveRange();
@@ -149,9 +162,15 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 			return Renderer::DrawInfo { e.mRenderProcess.getDrawSyncPrimitives(step.seqIndex, gfIdx), gfIdx };
 		};
 
+		if(e.mHeadlessFrameLimitReached.load(std::memory_order_relaxed)) return;
+
 		e.mGraphicsReg.beginCycle();
 
-		{ // Acquire image
+		if(e.mPrefs.headless) { // Take the next offscreen image, the gframe reuse block waits for its last draw
+			sc_img_idx = e.acquireHeadlessImage();
+			gframe = e.mGframes.data() + sc_img_idx;
+		} else { // Acquire image
+			SKENGINE_ZONE("acquire image");
 			VkFence sc_img_fence;
 			try {
 				sc_img_fence = selectGframeFence(e);
@@ -185,7 +204,22 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 		}
 		auto draw_info = DrawInfo { concurrent_access, gframe, sc_img_idx };
 
-		e.mGframeCounter.fetch_add(1, std::memory_order_relaxed);
+		auto frame_number = uint_fast64_t(e.mGframeCounter.fetch_add(1, std::memory_order_relaxed)) + 1;
+
+		if(gframe->submitted_frame > 0) { // Retire the resources that were last used by this gframe's previous frame, or earlier
+			// Waves are submitted in order to the same queue, so the last draw fence of the
+			// previous frame covers every earlier submission; the presentation engine already
+			// waited on it, so this should not block
+			auto& syncs = e.mRenderProcess.getDrawSyncPrimitives(steps.back().second.seqIndex, sc_img_idx);
+			VK_CHECK(vkWaitForFences, e.mDevice, 1, &syncs.fences.draw, VK_TRUE, UINT64_MAX);
+			e.mCleanupQueue.retire(gframe->submitted_frame);
+			if(gframe->gpu_timestamps_written) updateRenderScale(e, sc_img_idx);
+			#ifdef SKENGINE_GPU_PROFILING
+				e.mRenderProcess.gpuProfiler().collect(sc_img_idx);
+				if(frame_number % gpu_profile_log_interval == 0) e.mRenderProcess.gpuProfiler().logReport(e.mLogger);
+			#endif
+		}
+		e.mCleanupQueue.advance(frame_number);
 
 		VkCommandBufferBeginInfo cbb_info = { };
 		cbb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -209,24 +243,59 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 			auto& syncs = e.mRenderProcess.getDrawSyncPrimitives(seqIdx, sc_img_idx);
 			auto& waveGframe = e.mRenderProcess.getWaveGframeData(seqIdx, sc_img_idx);
 
+			bool first_wave = seq_idx_e(seqIdx) == 0;
+			bool last_wave  = seqIdx == steps.back().second.seqIndex;
+
 			VK_CHECK(vkResetCommandPool, e.mDevice, waveGframe.cmdPool, 0);
 			VK_CHECK(vkBeginCommandBuffer, waveGframe.cmdPrepare, &cbb_info);
 			VK_CHECK(vkBeginCommandBuffer, waveGframe.cmdDraw, &cbb_info);
 
+			if(first_wave && e.mGpuTimestampPool != nullptr) {
+				vkCmdResetQueryPool(waveGframe.cmdPrepare, e.mGpuTimestampPool, 2 * sc_img_idx, 2);
+				vkCmdWriteTimestamp2(waveGframe.cmdPrepare, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, e.mGpuTimestampPool, 2 * sc_img_idx);
+			}
+
+			#ifdef SKENGINE_GPU_PROFILING
+				using ProfStage = GpuProfiler::Stage;
+				auto& profiler = e.mRenderProcess.gpuProfiler();
+				auto  stepIndex = [&](const auto& step) { return unsigned(&step - steps.data()); };
+				if(first_wave) profiler.beginGframe(waveGframe.cmdPrepare, sc_img_idx);
+				profiler.writeWaveBegin(waveGframe.cmdPrepare, sc_img_idx, seq_idx_e(seqIdx));
+			#endif
+
 			for(auto& step : wave) {
 				auto* renderer = e.mRenderProcess.getRenderer(step.second.renderer);
+				#ifdef SKENGINE_GPU_PROFILING
+					profiler.writeStageBegin(waveGframe.cmdPrepare, sc_img_idx, stepIndex(step), ProfStage::ePrepare);
+				#endif
 				if(renderer != nullptr) {
 					auto& rpass = e.mRenderProcess.getRenderPass(step.second.rpass);
 					prepareStep(*renderer, rpass, waveGframe.cmdPrepare, syncs, draw_info);
 				}
+				#ifdef SKENGINE_GPU_PROFILING
+					profiler.writeStageEnd(waveGframe.cmdPrepare, sc_img_idx, stepIndex(step), ProfStage::ePrepare);
+				#endif
 			}
 			VK_CHECK(vkEndCommandBuffer, waveGframe.cmdPrepare);
 			for(auto& step : wave) {
 				auto* renderer = e.mRenderProcess.getRenderer(step.second.renderer);
+				#ifdef SKENGINE_GPU_PROFILING
+					profiler.writeStageBegin(waveGframe.cmdDraw, sc_img_idx, stepIndex(step), ProfStage::eDraw);
+				#endif
 				if(renderer != nullptr) {
 					auto& rpass = e.mRenderProcess.getRenderPass(step.second.rpass);
 					drawStep(step.second, *renderer, rpass, waveGframe.cmdDraw, syncs, draw_info);
 				}
+				#ifdef SKENGINE_GPU_PROFILING
+					profiler.writeStageEnd(waveGframe.cmdDraw, sc_img_idx, stepIndex(step), ProfStage::eDraw);
+				#endif
+			}
+			#ifdef SKENGINE_GPU_PROFILING
+				profiler.writeWaveEnd(waveGframe.cmdDraw, sc_img_idx, seq_idx_e(seqIdx));
+			#endif
+			if(last_wave && e.mGpuTimestampPool != nullptr) {
+				vkCmdWriteTimestamp2(waveGframe.cmdDraw, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, e.mGpuTimestampPool, (2 * sc_img_idx) + 1);
+				gframe->gpu_timestamps_written = true;
 			}
 			VK_CHECK(vkEndCommandBuffer, waveGframe.cmdDraw);
 
@@ -246,6 +315,7 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 				subm.pWaitSemaphores    = waitForLastDraw? &lastSyncs.semaphores.draw : nullptr;
 				subm.signalSemaphoreCount = 1;
 				subm.pSignalSemaphores    = &syncs.semaphores.prepare;
+				SKENGINE_ZONE("vkQueueSubmit");
 				VK_CHECK(vkResetFences, e.mDevice,          1,       &syncs.fences.prepare);
 				VK_CHECK(vkQueueSubmit, e.mQueues.graphics, 1, &subm, syncs.fences.prepare);
 				subm.waitSemaphoreCount = 1;
@@ -262,9 +332,24 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 			seqIdx = SeqIdx(seq_idx_e(seqIdx) + 1);
 		}
 
-		{ // Here's a present!
+		auto submit_time = tickreg::Clock::now();
+
+		if(e.mPrefs.headless) {
+			SKENGINE_ZONE("presentHeadless");
+			e.presentHeadless(sc_img_idx, lastSyncs.semaphores.draw, frame_number);
+			auto limit = e.mPrefs.headless_frame_limit;
+			if((limit > 0) && (frame_number >= limit)) e.mHeadlessFrameLimitReached.store(true, std::memory_order_relaxed);
+		} else { // Here's a present!
+			SKENGINE_ZONE("vkQueuePresentKHR");
 			VkResult res;
+			VkPresentIdKHR p_id = { };
 			VkPresentInfoKHR p_info = { };
+			if(e.mVkWaitForPresent != nullptr) {
+				p_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+				p_id.swapchainCount = 1;
+				p_id.pPresentIds    = &frame_number;
+				p_info.pNext = &p_id;
+			}
 			p_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 			p_info.pResults = &res;
 			p_info.swapchainCount = 1;
@@ -281,6 +366,7 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 		}
 
 		e.mGframeLast = int_fast32_t(sc_img_idx);
+		gframe->submitted_frame = frame_number;
 		e.mWaveFencesWaitCache.clear();
 		e.mWaveFencesWaitCache.reserve(e.mRenderProcess.waveCount());
 		if(e.mPrefs.wait_for_gframe) {
@@ -303,7 +389,7 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 			auto* renderer = e.mRenderProcess.getRenderer(step.second.renderer);
 			ifRenderer(renderer, &Renderer::beforePostRender, concurrent_access, stepRdrDrawInfo(step.second, sc_img_idx));
 		}
-		loop.loop_async_postRender(concurrent_access, delta, e.mGraphicsReg.lastDelta());
+		loop.loop_async_postRender(concurrent_access, delta, fixed? delta : e.mGraphicsReg.lastDelta());
 		for(auto wave : waves) for(auto& step : wave) {
 			auto* renderer = e.mRenderProcess.getRenderer(step.second.renderer);
 			ifRenderer(renderer, &Renderer::afterPostRender, concurrent_access, stepRdrDrawInfo(step.second, sc_img_idx));
@@ -311,15 +397,75 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 
 		e.mGraphicsReg.endCycle();
 
+		if(e.mPrefs.latency_pacing) { // Measured by `measureFrameLatency`, without holding the gframe lock
+			auto cpu_time = std::chrono::duration_cast<std::chrono::duration<tickreg::delta_t>>(submit_time - e.mGraphicsReg.lastBeginCycle()).count();
+			e.mFrameLatencyProbe = {
+				.draw_fence   = lastSyncs.fences.draw,
+				.swapchain    = e.mSwapchain,
+				.frame_number = frame_number,
+				.cpu_time     = cpu_time,
+				.submit_time  = submit_time };
+		}
+
 		#undef IF_WORLD_RPASS_
 		#undef IF_UI_RPASS_
 	}
 
 
+	static void updateRenderScale(Engine& e, uint32_t gframe_idx) {
+		uint64_t ts[2];
+		VkResult res = vkGetQueryPoolResults(e.mDevice, e.mGpuTimestampPool, 2 * gframe_idx, 2, sizeof(ts), ts, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if(res != VK_SUCCESS) [[unlikely]] return;
+
+		double gpu_time = double(ts[1] - ts[0]) * double(e.mDevProps.limits.timestampPeriod) / 1'000'000'000.0;
+		if(e.mResolutionScaler.update(gpu_time)) {
+			e.mRenderExtent = scale_render_extent(e.mMaxRenderExtent, e.mResolutionScaler.scale());
+			e.mLogger.trace("GPU frame time {:.3f}ms, render extent scaled to {}x{}", gpu_time * 1000.0, e.mRenderExtent.width, e.mRenderExtent.height);
+		}
+	}
+
+
+	/// Must be called by the graphics thread after releasing the gframe lock,
+	/// which other threads may need while the frame is being waited upon;
+	/// only the graphics thread may destroy the fence or the swapchain.
+	///
+	static void measureFrameLatency(Engine& e) {
+		using Seconds = std::chrono::duration<tickreg::delta_t>;
+
+		auto probe = e.mFrameLatencyProbe;
+		e.mFrameLatencyProbe.draw_fence = nullptr;
+		if(probe.draw_fence == nullptr) return;
+
+		// Waiting for the frame also keeps the GPU from queueing frames ahead, which would add latency
+		VK_CHECK(vkWaitForFences, e.mDevice, 1, &probe.draw_fence, VK_TRUE, UINT64_MAX);
+		auto complete_time = tickreg::Clock::now();
+		auto present_time  = complete_time;
+
+		if(e.mVkWaitForPresent != nullptr && probe.swapchain != nullptr) {
+			auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(Seconds(4.0 * e.mLatencyPacer.estPresentInterval()));
+			VkResult res = e.mVkWaitForPresent(e.mDevice, probe.swapchain, probe.frame_number, timeout.count());
+			if(res == VK_SUCCESS) [[likely]] {
+				present_time = tickreg::Clock::now();
+			} else {
+				// The swapchain may be out of date, or the present may have been discarded:
+				// the completion time is the best approximation available
+				e.mLogger.trace("vkWaitForPresentKHR returned {}", string_VkResult(res));
+			}
+		}
+
+		e.mLatencyPacer.reportFrame(probe.cpu_time, std::chrono::duration_cast<Seconds>(complete_time - probe.submit_time).count());
+		e.mLatencyPacer.reportPresent(present_time);
+	}
+
+
 	static LoopInterface::LoopState runLogicIteration(Engine& e, LoopInterface& loop) {
+		SKENGINE_ZONE("Engine::runLogicIteration");
+		bool fixed = e.mPrefs.fixed_timestep;
+		if(fixed && ! awaitLockstepTurn(e, false)) return LoopInterface::LoopState::eShouldStop;
+
 		e.mLogicReg.beginCycle();
-		auto delta_last = e.mLogicReg.lastDelta();
-		auto delta = choose_delta(e.mLogicReg.estDelta(), delta_last);
+		auto delta_last = fixed? fixed_delta(e.mPrefs) : e.mLogicReg.lastDelta();
+		auto delta      = fixed? delta_last : choose_delta(e.mLogicReg.estDelta(), delta_last);
 
 		e.mGframePriorityOverride.store(true, std::memory_order_seq_cst);
 		loop.loop_processEvents(delta, delta_last);
@@ -329,12 +475,46 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 		e.mLogicReg.endCycle();
 
 		auto r = loop.loop_pollState();
+		if(e.mHeadlessFrameLimitReached.load(std::memory_order_relaxed)) r = LoopInterface::LoopState::eShouldStop;
 
-		e.mLogicReg.awaitNextTick();
+		if(fixed) endLockstepTurn(e, false);
+		else      e.mLogicReg.awaitNextTick();
 		return r;
 	}
 
 
+	/// Waits until it's the turn of the graphics thread (`is_frame`) or
+	/// the logic thread to run, and returns `false` if the lockstep was
+	/// stopped in the meantime.
+	///
+	static bool awaitLockstepTurn(Engine& e, bool is_frame) {
+		auto lock = std::unique_lock(e.mLockstepMutex);
+		e.mLockstepCond.wait(lock, [&]() {
+			if(e.mLockstepStop) return true;
+			return is_frame? (e.mLockstepTicks > e.mLockstepFrames) : (e.mLockstepFrames >= e.mLockstepTicks); });
+		return ! e.mLockstepStop;
+	}
+
+
+	static void endLockstepTurn(Engine& e, bool is_frame) {
+		{
+			auto lock = std::unique_lock(e.mLockstepMutex);
+			++ (is_frame? e.mLockstepFrames : e.mLockstepTicks);
+		}
+		e.mLockstepCond.notify_all();
+	}
+
+
+	static void setLockstepStopped(Engine& e, bool value) {
+		{
+			auto lock = std::unique_lock(e.mLockstepMutex);
+			e.mLockstepStop = value;
+			if(! value) e.mLockstepTicks = e.mLockstepFrames = 0;
+		}
+		e.mLockstepCond.notify_all();
+	}
+
+
 	static void handleSignals(Engine& e, RenderProcessInterface& rpi) {
 		bool reinitGate = false;
 		auto reinit = [&]() {
@@ -349,6 +529,10 @@ struct SKENGINE_NAME_NS::Engine::Implementation {
 			// Some compositors resize the window as soon as it appears, and this seems to cause problems
 			e.mGraphicsReg.resetEstimates (delta_t(1.0) / delta_t(e.mPrefs.target_framerate));
 			e.mLogicReg.resetEstimates    (delta_t(1.0) / delta_t(e.mPrefs.target_tickrate));
+			e.mLatencyPacer.resetEstimates(delta_t(1.0) / delta_t(e.mPrefs.target_framerate));
+			e.mResolutionScaler.reset(1.0 / double(e.mPrefs.target_framerate));
+
+			e.mFrameLatencyProbe.draw_fence = nullptr; // The fence and the swapchain are about to be replaced
 
 			auto init = reinterpret_cast<Engine::RpassInitializer*>(&e);
 			auto ca = ConcurrentAccess(&e, true);
@@ -413,14 +597,22 @@ namespace SKENGINE_NAME_NS {
 		.init_present_extent            = { 600, 400 },
 		.max_render_extent              = { 0, 0 },
 		.present_mode                   = VK_PRESENT_MODE_FIFO_KHR,
+		.headless_dump_frames           = { },
+		.headless_dump_prefix           = "frame-",
+		.headless_frame_limit           = 0,
 		.max_concurrent_frames          = 2,
 		.framerate_samples              = 16,
 		.upscale_factor                 = 1.0f,
+		.min_resolution_scale           = 0.5f,
 		.target_framerate               = 60.0f,
 		.target_tickrate                = 60.0f,
 		.fullscreen                     = false,
 		.composite_alpha                = false,
-		.wait_for_gframe                = true
+		.wait_for_gframe                = true,
+		.latency_pacing                 = false,
+		.dynamic_resolution             = false,
+		.headless                       = false,
+		.fixed_timestep                 = false
 	};
 
 
@@ -430,6 +622,19 @@ namespace SKENGINE_NAME_NS {
 		.compensationFactor = 0.0,
 		.strategyMask       = tickreg::strategy_flag_t(tickreg::WaitStrategyFlags::eSleepUntil) };
 
+	constexpr auto latency_pacer_params = tickreg::LatencyPacerParams {
+		.safetyMargin     = 0.002,
+		.maxDelayFactor   = 0.9,
+		.estimateInterval = true };
+
+	constexpr auto resolution_scaler_params = ResolutionScalerParams {
+		.targetUtilization = 0.9,
+		.minScale          = 0.5,
+		.kp                = 0.2,
+		.ki                = 0.1,
+		.kd                = 0.0,
+		.tolerance         = 0.03 };
+
 
 
 	void ConcurrentAccess::setPresentExtent(VkExtent2D ext) {
@@ -491,6 +696,18 @@ namespace SKENGINE_NAME_NS {
 			init->init(&di);
 		}
 
+		{ // Without `VK_KHR_present_wait`, presentation times are approximated with completion times
+			auto params = latency_pacer_params;
+			params.estimateInterval = (mVkWaitForPresent != nullptr);
+			mLatencyPacer = tickreg::LatencyPacer(ep.framerate_samples, decltype(ep.target_framerate)(1.0) / ep.target_framerate, params);
+		}
+
+		{
+			auto params = resolution_scaler_params;
+			params.minScale = std::clamp<double>(ep.min_resolution_scale, 0.05, 1.0);
+			mResolutionScaler = ResolutionScaler(params, 1.0 / double(ep.target_framerate));
+		}
+
 		{
 			auto rpass_cfg = RpassConfig::default_cfg;
 			auto init = reinterpret_cast<Engine::RpassInitializer*>(this);
@@ -507,6 +724,11 @@ namespace SKENGINE_NAME_NS {
 			init->destroy(ca);
 		}
 
+		if(! mCleanupQueue.empty()) {
+			vkDeviceWaitIdle(mDevice);
+			mCleanupQueue.retireAll();
+		}
+
 		{
 			auto init = reinterpret_cast<Engine::DeviceInitializer*>(this);
 			init->destroy();
@@ -522,6 +744,7 @@ namespace SKENGINE_NAME_NS {
 			auto lock = std::unique_lock(mGframeMutex, std::try_to_lock);
 			exception = std::current_exception();
 			loop_state = LoopInterface::LoopState::eShouldStop;
+			Implementation::setLockstepStopped(*this, true); // Neither thread may be left waiting for the other
 		};
 
 		{
@@ -530,9 +753,16 @@ namespace SKENGINE_NAME_NS {
 			Implementation::setupRprocess(*this, *rpi);
 		}
 
+		Implementation::setLockstepStopped(*this, false);
+		mHeadlessFrameLimitReached.store(false, std::memory_order_relaxed); // A previous run may have reached it
+		mFrameLatencyProbe = { }; // Neither is the last frame of a previous run measured
+
 		auto gframeLock = std::unique_lock(mGframeMutex);
+		auto run_begin_time   = std::chrono::steady_clock::now();
+		auto run_begin_frames = frameCounter();
 
 		mGraphicsThread = std::thread([&]() {
+			SKENGINE_ZONE_THREAD_NAME("Graphics");
 			#ifdef NDEBUG
 				mIsRunning.store(true, std::memory_order::seq_cst);
 			#else
@@ -541,6 +771,7 @@ namespace SKENGINE_NAME_NS {
 			#endif
 			while(loop_state != LoopInterface::LoopState::eShouldStop) {
 				try {
+					if(mPrefs.fixed_timestep && ! Implementation::awaitLockstepTurn(*this, true)) break;
 					auto gframeLock = std::unique_lock(mGframeMutex, std::defer_lock);
 					if(mGframePriorityOverride.load(std::memory_order_consume)) [[unlikely]] {
 						gframeLock.lock();
@@ -553,7 +784,10 @@ namespace SKENGINE_NAME_NS {
 					Implementation::draw(*this, loop);
 					Implementation::handleSignals(*this, *rpi);
 					gframeLock.unlock();
-					mGraphicsReg.awaitNextTick();
+					if(mPrefs.latency_pacing) Implementation::measureFrameLatency(*this);
+					if     (mPrefs.fixed_timestep) Implementation::endLockstepTurn(*this, true);
+					else if(mPrefs.latency_pacing) mGraphicsReg.awaitUntil(mLatencyPacer.nextBegin(tickreg::Clock::now()));
+					else                           mGraphicsReg.awaitNextTick();
 				} catch(...) {
 					handle_exception();
 				}
@@ -561,6 +795,7 @@ namespace SKENGINE_NAME_NS {
 			mIsRunning.store(false, std::memory_order::seq_cst);
 		});
 
+		SKENGINE_ZONE_THREAD_NAME("Logic");
 		try { loop.loop_begin(); } catch(...) { handle_exception(); }
 		gframeLock.unlock();
 		while((exception == nullptr) && (loop_state != LoopInterface::LoopState::eShouldStop)) {
@@ -570,6 +805,7 @@ namespace SKENGINE_NAME_NS {
 				handle_exception();
 			}
 		}
+		Implementation::setLockstepStopped(*this, true);
 		mGframePriorityOverride.store(true, std::memory_order_seq_cst);
 		gframeLock.lock();
 		loop.loop_end();
@@ -583,6 +819,13 @@ namespace SKENGINE_NAME_NS {
 		mGraphicsThread.join();
 		mGraphicsThread = { };
 
+		if(mPrefs.headless) { // Headless runs are usually benchmarks
+			using Seconds = std::chrono::duration<double>;
+			auto time   = std::chrono::duration_cast<Seconds>(std::chrono::steady_clock::now() - run_begin_time).count();
+			auto frames = frameCounter() - run_begin_frames;
+			mLogger.info("Headless run: {} frames in {:.3f}s, {:.3f}ms per frame", frames, time, (frames > 0)? (time * 1000.0 / double(frames)) : 0.0);
+		}
+
 		{
 			auto ca = ConcurrentAccess(this, true);
 			Implementation::destroyRprocess(*this, *rpi);
@@ -673,6 +916,9 @@ namespace SKENGINE_NAME_NS {
 		}
 		vkDeviceWaitIdle(mDevice);
 
+		// Every submitted frame is complete, nothing that has been enqueued is still in use
+		mCleanupQueue.retire(mCleanupQueue.currentValue());
+
 		return lock;
 	}
 
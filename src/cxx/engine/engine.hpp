@@ -3,6 +3,8 @@
 #include "renderprocess/render_process.hpp"
 #include "renderprocess/interface.hpp"
 #include "shader_cache.hpp"
+#include "cleanup_queue.hpp"
+#include "resolution_scaler.hpp"
 
 #include <vk-util/init.hpp>
 #include <vk-util/memory.hpp>
@@ -15,6 +17,7 @@
 #include <stdfloat>
 #include <condition_variable>
 #include <string>
+#include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <ranges>
@@ -85,14 +88,22 @@ namespace SKENGINE_NAME_NS {
 		VkExtent2D  init_present_extent;
 		VkExtent2D  max_render_extent;
 		VkPresentModeKHR present_mode;
+		std::vector<uint_fast64_t> headless_dump_frames; // Only used with `headless`: the numbers of the frames to write as PNG files
+		std::string                headless_dump_prefix; // Only used with `headless`: dumped frames are written to "<prefix><frame number>.png"
+		uint_fast64_t  headless_frame_limit; // Only used with `headless`: stop running after this many frames, or never if 0
 		uint32_t       max_concurrent_frames;
 		uint32_t       framerate_samples;
 		std::float32_t upscale_factor;
+		std::float32_t min_resolution_scale; // Only used with `dynamic_resolution`
 		std::float32_t target_framerate;
 		std::float32_t target_tickrate;
 		bool           fullscreen      : 1;
 		bool           composite_alpha : 1;
 		bool           wait_for_gframe : 1;
+		bool           latency_pacing  : 1; // Delay gframes so that they start as late as possible while still meeting the next presentation
+		bool           dynamic_resolution : 1; // Scale the render extent down when the GPU cannot meet `target_framerate`
+		bool           headless           : 1; // Render to offscreen images instead of a window, see `Engine::HeadlessState`
+		bool           fixed_timestep     : 1; // Run exactly one logic tick per frame, with a constant delta of `1 / target_tickrate`, for reproducible runs
 	};
 
 
@@ -132,6 +143,8 @@ namespace SKENGINE_NAME_NS {
 		VkImage     swapchain_image;
 		VkImageView swapchain_image_view;
 		tickreg::delta_t frame_delta;
+		uint_fast64_t    submitted_frame; // The number of the last frame submitted with this gframe, or 0
+		bool             gpu_timestamps_written;
 	};
 
 
@@ -201,6 +214,7 @@ namespace SKENGINE_NAME_NS {
 
 		void run(LoopInterface&, std::shared_ptr<RenderProcessInterface>);
 		bool isRunning() const noexcept;
+		bool isHeadless() const noexcept { return mPrefs.headless; }
 		void signal(Signal, bool discardDuplicate = false) noexcept;
 
 		[[nodiscard]]
@@ -227,6 +241,7 @@ namespace SKENGINE_NAME_NS {
 		static void pullBuffer(const TransferContext&, vkutil::BufferDuplex&);
 		static auto pushBufferAsync(const TransferContext&, vkutil::BufferDuplex&) -> TransferCmdBarrier;
 		static auto pullBufferAsync(const TransferContext&, vkutil::BufferDuplex&) -> TransferCmdBarrier;
+		static void copyBuffer(const TransferContext&, VkBuffer src, VkBuffer dst, std::span<const VkBufferCopy>);
 
 		auto getVmaAllocator  () noexcept { return mVma; }
 		auto getDevice        () noexcept { return mDevice; }
@@ -235,11 +250,13 @@ namespace SKENGINE_NAME_NS {
 		auto getPipelineCache () noexcept { return mPipelineCache; }
 
 		auto& getTransferContext () const noexcept { return mTransferContext; }
+		auto& getCleanupQueue    ()       noexcept { return mCleanupQueue; }
 
 		auto& getShaderCache () noexcept { return mShaderCache; }
 		auto& getRenderProcess () noexcept { return mRenderProcess; }
 
 		const auto& getRenderExtent         () const noexcept { return mRenderExtent; }
+		const auto& getMaxRenderExtent      () const noexcept { return mMaxRenderExtent; }
 		const auto& getPresentExtent        () const noexcept { return mPresentExtent; }
 		const auto& getQueueInfo            () const noexcept { return mQueues; }
 		const auto& getPhysDeviceFeatures   () const noexcept { return mDevFeatures; }
@@ -253,6 +270,14 @@ namespace SKENGINE_NAME_NS {
 		auto frameCounter() const noexcept { return mGframeCounter.load(std::memory_order_relaxed); }
 		auto frameDelta() const noexcept { return mGraphicsReg.estDelta(); }
 		auto tickDelta() const noexcept { return mLogicReg.estDelta(); }
+		auto renderScale() const noexcept { return mResolutionScaler.scale(); }
+
+		#ifdef SKENGINE_GPU_PROFILING
+			/// \brief Rolling averages of the GPU time spent by each render process step,
+			///        indexed like `RenderProcess::sortedStepRange`.
+			auto gpuStepProfiles() const noexcept { return mRenderProcess.gpuProfiler().stepProfiles(); }
+			auto gpuWaveProfiles() const noexcept { return mRenderProcess.gpuProfiler().waveProfiles(); }
+		#endif
 
 		MutexAccess<ConcurrentAccess> getConcurrentAccess() noexcept;
 
@@ -261,6 +286,9 @@ namespace SKENGINE_NAME_NS {
 		class DeviceInitializer;
 		class RpassInitializer;
 
+		uint32_t acquireHeadlessImage() noexcept;
+		void presentHeadless(uint32_t image_index, VkSemaphore draw_semaphore, uint_fast64_t frame_number);
+
 		enum class QfamIndex : uint32_t { eInvalid = ~ uint32_t(0) };
 
 		SDL_Window* mSdlWindow = nullptr;
@@ -276,6 +304,7 @@ namespace SKENGINE_NAME_NS {
 		VkPhysicalDeviceFeatures   mDevFeatures;
 
 		TransferContext mTransferContext;
+		CleanupQueue    mCleanupQueue;
 
 		VkSurfaceKHR       mSurface          = nullptr;
 		QfamIndex          mPresentQfamIndex = QfamIndex::eInvalid;
@@ -288,6 +317,49 @@ namespace SKENGINE_NAME_NS {
 		std::shared_ptr<ShaderCacheInterface> mShaderCache;
 		tickreg::Regulator mGraphicsReg;
 		tickreg::Regulator mLogicReg;
+		tickreg::LatencyPacer mLatencyPacer;
+		PFN_vkWaitForPresentKHR mVkWaitForPresent = nullptr; // Only set when `VK_KHR_present_wait` is enabled
+
+		// What the latency pacer needs to measure the last frame, once the gframe lock is released
+		struct FrameLatencyProbe {
+			VkFence            draw_fence; // Null when there is nothing to measure
+			VkSwapchainKHR     swapchain;
+			uint64_t           frame_number;
+			tickreg::delta_t   cpu_time;
+			tickreg::TimePoint submit_time;
+		};
+		FrameLatencyProbe mFrameLatencyProbe = { };
+
+		ResolutionScaler mResolutionScaler;
+		VkQueryPool      mGpuTimestampPool = nullptr; // Two queries per gframe, only created with `dynamic_resolution`
+
+		/// \brief The offscreen image ring that replaces the window and
+		///        its swapchain when `EnginePreferences::headless` is set.
+		///
+		/// Images are handed out round-robin, and "presenting" one only
+		/// consumes the semaphore of its last draw; frames that need to
+		/// be dumped are also copied to `readback` and written to disk
+		/// synchronously.
+		///
+		struct HeadlessState {
+			std::vector<vkutil::Image> images;
+			VkCommandPool   cmdPool;
+			VkCommandBuffer cmd;
+			VkFence         readbackFence;
+			vkutil::Buffer  readback;
+			VkDeviceSize    readbackSize;
+			uint_fast32_t   imageSelector;
+		};
+		HeadlessState    mHeadless = { };
+		std::atomic_bool mHeadlessFrameLimitReached = false;
+
+		// With `EnginePreferences::fixed_timestep`, the logic and graphics threads
+		// take turns: a frame is drawn after every tick, and vice versa
+		std::mutex              mLockstepMutex = std::mutex();
+		std::condition_variable mLockstepCond;
+		uint_fast64_t           mLockstepTicks  = 0;
+		uint_fast64_t           mLockstepFrames = 0;
+		bool                    mLockstepStop   = false;
 
 		std::mutex                mGframeMutex = std::mutex();
 		std::condition_variable   mGframeResumeCond;
@@ -300,7 +372,8 @@ namespace SKENGINE_NAME_NS {
 		std::vector<VkFence>      mWaveFencesWaitCache; // Not needed persistently across scopes, but keeping it here prevents frequent reallocations
 		std::thread               mGraphicsThread;
 
-		VkExtent2D      mRenderExtent;
+		VkExtent2D      mRenderExtent;    // The sub-rectangle of the render targets that is rendered to
+		VkExtent2D      mMaxRenderExtent; // The extent that render targets are allocated with
 		VkExtent2D      mPresentExtent;
 		VkPipelineCache mPipelineCache;
 		RenderProcess   mRenderProcess;
@@ -101,6 +101,22 @@ namespace SKENGINE_NAME_NS {
 	}
 
 
+	void Engine::copyBuffer(const TransferContext& tc, VkBuffer src, VkBuffer dst, std::span<const VkBufferCopy> regions) {
+		if(regions.empty()) return;
+		auto dev = vmaGetAllocatorDevice(tc.vma);
+		auto cmd = create_cmd_buffer(dev, tc.cmdPool);
+		VkCommandBufferBeginInfo cbb_info = { };
+		cbb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cbb_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK(vkBeginCommandBuffer, cmd, &cbb_info);
+		vkCmdCopyBuffer(cmd, src, dst, regions.size(), regions.data());
+		VK_CHECK(vkEndCommandBuffer, cmd);
+		submit_onetime_cmd(dev, tc.cmdFence, tc.cmdQueue, cmd, true);
+		VK_CHECK(vkWaitForFences, dev, 1, &tc.cmdFence, true, UINT64_MAX);
+		vkFreeCommandBuffers(dev, tc.cmdPool, 1, &cmd);
+	}
+
+
 	TransferCmdBarrier Engine::pushBufferAsync(const TransferContext& tc, vkutil::BufferDuplex& b) {
 		if(b.isHostVisible()) {
 			b.flush(nullptr, tc.vma);
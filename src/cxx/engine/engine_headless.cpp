@@ -0,0 +1,205 @@
+#include "engine.hpp"
+
+#include <vk-util/error.hpp>
+
+#include <posixfio_tl.hpp>
+
+#include <cstring>
+#include <algorithm>
+#include <array>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	namespace {
+
+		uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+			static constexpr auto table = []() {
+				std::array<uint32_t, 256> r;
+				for(uint32_t i = 0; i < 256; ++i) {
+					uint32_t c = i;
+					for(unsigned k = 0; k < 8; ++k) c = (c & 1)? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+					r[i] = c;
+				}
+				return r;
+			} ();
+			crc = ~ crc;
+			for(size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+			return ~ crc;
+		}
+
+
+		void push_be32(std::vector<uint8_t>& dst, uint32_t v) {
+			dst.push_back(uint8_t(v >> 24)); dst.push_back(uint8_t(v >> 16));
+			dst.push_back(uint8_t(v >> 8));  dst.push_back(uint8_t(v));
+		}
+
+
+		void push_png_chunk(std::vector<uint8_t>& dst, const char (&type)[5], const std::vector<uint8_t>& data) {
+			push_be32(dst, uint32_t(data.size()));
+			auto crc_begin = dst.size();
+			dst.insert(dst.end(), type, type + 4);
+			dst.insert(dst.end(), data.begin(), data.end());
+			push_be32(dst, crc32(dst.data() + crc_begin, dst.size() - crc_begin));
+		}
+
+
+		/// Encodes 8-bit RGBA (or BGRA) pixels as an RGB PNG.
+		///
+		/// The zlib stream only uses stored blocks: frame dumps are meant
+		/// to be compared and inspected, not archived, and this avoids
+		/// depending on a compression library.
+		///
+		std::vector<uint8_t> encode_png(const uint8_t* pixels, uint32_t width, uint32_t height, bool bgra) {
+			std::vector<uint8_t> raw; // Filter byte + RGB pixels, for each row
+			raw.reserve(size_t(height) * (1 + (size_t(width) * 3)));
+			for(uint32_t y = 0; y < height; ++y) {
+				raw.push_back(0);
+				auto* row = pixels + (size_t(y) * width * 4);
+				for(uint32_t x = 0; x < width; ++x) {
+					auto* px = row + (size_t(x) * 4);
+					raw.push_back(px[bgra? 2 : 0]);
+					raw.push_back(px[1]);
+					raw.push_back(px[bgra? 0 : 2]);
+				}
+			}
+
+			std::vector<uint8_t> zlib;
+			constexpr size_t max_block = 0xffff;
+			zlib.reserve(raw.size() + (5 * ((raw.size() / max_block) + 1)) + 6);
+			zlib.push_back(0x78); zlib.push_back(0x01);
+			uint32_t adler_a = 1;
+			uint32_t adler_b = 0;
+			for(size_t offset = 0; ; offset += max_block) {
+				auto len = uint16_t(std::min(max_block, raw.size() - offset));
+				bool last = offset + len >= raw.size();
+				zlib.push_back(last? 1 : 0);
+				zlib.push_back(uint8_t(len)); zlib.push_back(uint8_t(len >> 8));
+				zlib.push_back(uint8_t(~ len)); zlib.push_back(uint8_t((~ len) >> 8));
+				zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + len);
+				for(size_t i = offset; i < offset + len; ++i) {
+					adler_a = (adler_a + raw[i]) % 65521;
+					adler_b = (adler_b + adler_a) % 65521;
+				}
+				if(last) break;
+			}
+			push_be32(zlib, (adler_b << 16) | adler_a);
+
+			std::vector<uint8_t> r = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			std::vector<uint8_t> ihdr;
+			push_be32(ihdr, width);
+			push_be32(ihdr, height);
+			ihdr.insert(ihdr.end(), { 8 /* Bit depth */, 2 /* RGB */, 0, 0, 0 });
+			push_png_chunk(r, "IHDR", ihdr);
+			push_png_chunk(r, "IDAT", zlib);
+			push_png_chunk(r, "IEND", { });
+			return r;
+		}
+
+
+		void write_file(const std::string& path, const std::vector<uint8_t>& bytes) {
+			constexpr auto openFlags = posixfio::OpenFlags::eCreat | posixfio::OpenFlags::eRdwr;
+			auto output = posixfio::File::open(path.c_str(), openFlags, 0660);
+			output.ftruncate(bytes.size());
+			posixfio::MemMapping map = output.mmap(
+				bytes.size(),
+				posixfio::MemProtFlags::eWrite,
+				posixfio::MemMapFlags::eShared,
+				0 );
+			memcpy(map.get<std::byte>(), bytes.data(), bytes.size());
+		}
+
+	}
+
+
+	uint32_t Engine::acquireHeadlessImage() noexcept {
+		auto& hl = mHeadless;
+		return uint32_t(hl.imageSelector ++ % hl.images.size());
+	}
+
+
+	void Engine::presentHeadless(uint32_t image_index, VkSemaphore draw_semaphore, uint_fast64_t frame_number) {
+		auto& hl = mHeadless;
+		bool dump = mPrefs.headless_dump_frames.end() != std::find(mPrefs.headless_dump_frames.begin(), mPrefs.headless_dump_frames.end(), frame_number);
+
+		constexpr VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo subm = { };
+		subm.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		subm.waitSemaphoreCount = 1;
+		subm.pWaitSemaphores    = &draw_semaphore;
+		subm.pWaitDstStageMask  = &wait_stage;
+
+		if(! dump) {
+			// Nothing reads the image, but the semaphore must be waited upon before it can be signaled again
+			VK_CHECK(vkQueueSubmit, mPresentQueue, 1, &subm, nullptr);
+			return;
+		}
+
+		VkDeviceSize byte_size = VkDeviceSize(mPresentExtent.width) * mPresentExtent.height * 4;
+		if(hl.readbackSize < byte_size) {
+			if(hl.readback.value != nullptr) vkutil::Buffer::destroy(mVma, hl.readback);
+			vkutil::BufferCreateInfo bc_info = { };
+			bc_info.size  = byte_size;
+			bc_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			vkutil::AllocationCreateInfo ac_info = { };
+			ac_info.requiredMemFlags  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			ac_info.preferredMemFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			ac_info.vmaFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+			ac_info.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferHost;
+			hl.readback = vkutil::Buffer::create(mVma, bc_info, ac_info);
+			hl.readbackSize = byte_size;
+		}
+
+		{ // Copy the image to the readback buffer
+			VK_CHECK(vkResetCommandPool, mDevice, hl.cmdPool, 0);
+			VkCommandBufferBeginInfo cbb_info = { };
+			cbb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			cbb_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK(vkBeginCommandBuffer, hl.cmd, &cbb_info);
+			VkImageMemoryBarrier2 imb = { };
+			imb.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			imb.image = mGframes[image_index].swapchain_image;
+			imb.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			imb.subresourceRange.layerCount = 1;
+			imb.subresourceRange.levelCount = 1;
+			imb.oldLayout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // As renderers leave it for presentation
+			imb.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			imb.srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			imb.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+			imb.dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			imb.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+			VkDependencyInfo dep = { };
+			dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dep.imageMemoryBarrierCount = 1;
+			dep.pImageMemoryBarriers    = &imb;
+			vkCmdPipelineBarrier2(hl.cmd, &dep);
+			VkBufferImageCopy cp = { };
+			cp.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			cp.imageSubresource.layerCount = 1;
+			cp.imageExtent = { mPresentExtent.width, mPresentExtent.height, 1 };
+			vkCmdCopyImageToBuffer(hl.cmd, imb.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, hl.readback.value, 1, &cp);
+			VK_CHECK(vkEndCommandBuffer, hl.cmd);
+		}
+
+		// Dumping is meant for inspecting a handful of frames, so it simply stalls until the copy is done
+		subm.commandBufferCount = 1;
+		subm.pCommandBuffers    = &hl.cmd;
+		VK_CHECK(vkResetFences, mDevice, 1, &hl.readbackFence);
+		VK_CHECK(vkQueueSubmit, mPresentQueue, 1, &subm, hl.readbackFence);
+		VK_CHECK(vkWaitForFences, mDevice, 1, &hl.readbackFence, VK_TRUE, UINT64_MAX);
+
+		auto path = mPrefs.headless_dump_prefix + std::to_string(frame_number) + ".png";
+		try {
+			hl.readback.invalidate(mVma);
+			auto* pixels = hl.readback.map<uint8_t>(mVma);
+			auto  png    = encode_png(pixels, mPresentExtent.width, mPresentExtent.height, mSurfaceFormat.format == VK_FORMAT_B8G8R8A8_UNORM);
+			hl.readback.unmap(mVma);
+			write_file(path, png);
+			mLogger.info("Dumped frame {} to \"{}\"", frame_number, path);
+		} catch(posixfio::Errcode& err) {
+			mLogger.error("Failed to write frame {} to \"{}\" (errno {})", frame_number, path, err.errcode);
+		}
+	}
+
+}
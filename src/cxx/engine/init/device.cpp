@@ -20,7 +20,7 @@ namespace SKENGINE_NAME_NS {
 		using namespace std::string_view_literals;
 		assert(dii != nullptr);
 		debug::setLogger(cloneLogger(mLogger, "["sv, "Skengine "sv, ""sv, "]  "sv));
-		initSdl(dii);
+		if(! mPrefs.headless) initSdl(dii);
 		initVkInst(dii);
 		initVkDev();
 		initVma();
@@ -35,13 +35,13 @@ namespace SKENGINE_NAME_NS {
 		destroyVma();
 		destroyVkDev();
 		destroyVkInst();
-		destroySdl();
+		if(! mPrefs.headless) destroySdl();
 		debug::setLogger(Logger());
 	}
 
 
 	void Engine::DeviceInitializer::initVkInst(const DeviceInitInfo* device_init_info) {
-		assert(mSdlWindow != nullptr);
+		assert(mPrefs.headless || (mSdlWindow != nullptr));
 
 		VkApplicationInfo a_info  = { };
 		a_info.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -57,7 +57,7 @@ namespace SKENGINE_NAME_NS {
 
 		std::vector<const char*> extensions;
 
-		{ // Query SDL Vulkan extensions
+		if(! mPrefs.headless) { // Query SDL Vulkan extensions; headless engines need no instance extension
 			uint32_t extCount;
 			if(SDL_TRUE != SDL_Vulkan_GetInstanceExtensions(mSdlWindow, &extCount, nullptr)) throw std::runtime_error("Failed to query SDL Vulkan extensions");
 			extensions.resize(extCount);
@@ -155,7 +155,23 @@ namespace SKENGINE_NAME_NS {
 			features.drawIndirectFirstInstance = true;
 			features.fillModeNonSolid = true;
 
-			std::vector<const char*> extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+			#ifdef SKENGINE_GPU_PROFILING
+				{ // Pipeline statistics are optional, the GPU profiler checks for the same feature
+					VkPhysicalDeviceFeatures avail_ftrs;
+					vkGetPhysicalDeviceFeatures(mPhysDevice, &avail_ftrs);
+					features.pipelineStatisticsQuery = avail_ftrs.pipelineStatisticsQuery;
+				}
+			#endif
+
+			std::vector<const char*> extensions;
+			if(! mPrefs.headless) {
+				extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+			} else if(avail_extensions.contains(VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
+				// Renderers still transition their output to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, which belongs to this extension
+				extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+			} else {
+				mLogger.warn("Headless device does not support " VK_KHR_SWAPCHAIN_EXTENSION_NAME ", present layout transitions are invalid");
+			}
 
 			// Optional extensions
 			#define INS_IF_AVAIL_(NM_) if(avail_extensions.contains(NM_)) extensions.push_back(NM_);
@@ -173,13 +189,41 @@ namespace SKENGINE_NAME_NS {
 			};
 			request_ext("VK_EXT_hdr_metadata");
 
+			// Present wait lets the latency pacer measure actual presentation times, but is otherwise unneeded
+			VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = { };
+			VkPhysicalDevicePresentIdFeaturesKHR   present_id_features   = { };
+			present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+			present_id_features  .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+			present_id_features  .pNext = &present_wait_features;
+			bool use_present_wait = false;
+			if(mPrefs.latency_pacing && (! mPrefs.headless) && avail_extensions.contains(VK_KHR_PRESENT_ID_EXTENSION_NAME) && avail_extensions.contains(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+				VkPhysicalDeviceFeatures2 features2 = { };
+				features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+				features2.pNext = &present_id_features;
+				vkGetPhysicalDeviceFeatures2(mPhysDevice, &features2);
+				use_present_wait = present_id_features.presentId && present_wait_features.presentWait;
+				if(use_present_wait) {
+					extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+					extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+				} else {
+					mLogger.debug("Present wait extensions are available, but their features are not supported");
+				}
+			}
+
 			vkutil::CreateDeviceInfo cd_info = { };
 			cd_info.physDev           = mPhysDevice;
 			cd_info.extensions        = std::move(extensions);
 			cd_info.pPhysDevProps     = &mDevProps;
 			cd_info.pRequiredFeatures = &features;
+			cd_info.pFeatureChain     = use_present_wait? &present_id_features : nullptr;
 
 			vkutil::createDevice(nullptr, dev_dst, cd_info);
+
+			mVkWaitForPresent = nullptr;
+			if(use_present_wait) {
+				mVkWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(mDevice, "vkWaitForPresentKHR"));
+				if(mVkWaitForPresent == nullptr) mLogger.warn("Failed to load vkWaitForPresentKHR, presentation times will be approximated");
+			}
 		}
 	}
 
@@ -202,7 +246,7 @@ namespace SKENGINE_NAME_NS {
 		cpc_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 		cpc_info.queueFamilyIndex = mQueues.families.graphicsIndex;
 		VK_CHECK(vkCreateCommandPool, mDevice, &cpc_info, nullptr, &pool);
-		mTransferContext = { .vma = mVma, .cmdPool = pool, .cmdFence = nullptr, .cmdQueue = mQueues.graphics, .cmdQueueFamily = mQueues.families.graphicsIndex };
+		mTransferContext = { .vma = mVma, .cmdPool = pool, .cmdFence = nullptr, .cmdQueue = mQueues.graphics, .cmdQueueFamily = mQueues.families.graphicsIndex, .cleanupQueue = &mCleanupQueue };
 		try {
 			assert(mTransferContext.cmdFence == nullptr); // See the "destroy" twin of this function
 			VkFenceCreateInfo fc_info = { };
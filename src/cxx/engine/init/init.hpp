@@ -4,10 +4,22 @@
 
 #include <engine/engine.hpp>
 
+#include <cmath>
+
 
 
 namespace SKENGINE_NAME_NS {
 
+	/// \brief Computes the sub-rectangle of the render targets that a
+	///        dynamic resolution scale renders to.
+	///
+	inline VkExtent2D scale_render_extent(VkExtent2D max_extent, double scale) {
+		return VkExtent2D {
+			std::max<uint32_t>(1, uint32_t(std::round(double(max_extent.width)  * scale))),
+			std::max<uint32_t>(1, uint32_t(std::round(double(max_extent.height) * scale))) };
+	}
+
+
 	class Engine::DeviceInitializer : public Engine {
 	public:
 		void init(const DeviceInitInfo*);
@@ -41,6 +53,7 @@ namespace SKENGINE_NAME_NS {
 		void unwind(State&);
 		void initSurface();
 		void initSwapchain(State&);
+		void initHeadlessImages(State&);
 		void initGframes(State&);
 		void initRpasses(State&);
 		void initTop(State&);
@@ -48,6 +61,7 @@ namespace SKENGINE_NAME_NS {
 		void destroyRpasses(State&);
 		void destroyGframes(State&);
 		void destroySwapchain(State&);
+		void destroyHeadlessImages(State&);
 		void destroySurface();
 	};
 
@@ -156,6 +156,32 @@ namespace SKENGINE_NAME_NS {
 	}
 
 
+	constexpr VkImageUsageFlags headless_image_usage =
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+	constexpr VkFormatFeatureFlags headless_format_features =
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT |
+		VK_FORMAT_FEATURE_TRANSFER_DST_BIT |
+		VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+
+
+	VkSurfaceFormatKHR select_headless_format(Logger& logger, VkPhysicalDevice phys_dev) {
+		// Same preference as `vkutil::selectSwapchainFormat`, so that headless frames look like windowed ones
+		constexpr VkFormat candidates[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM };
+		for(auto fmt : candidates) {
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(phys_dev, fmt, &props);
+			if((props.optimalTilingFeatures & headless_format_features) == headless_format_features) {
+				return { fmt, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+			}
+		}
+		logger.error("No 8-bit RGBA format supports offscreen rendering, falling back to R8G8B8A8_UNORM");
+		return { VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+	}
+
+
 	#warning "Document how this works, since it's trippy, workaroundy and *definitely* UB (but it removes A LOT of boilerplate)"
 	void Engine::RpassInitializer::init(ConcurrentAccess& ca, const RpassConfig& rc) {
 		#define SET_STAGE_(B_) state.stages = state.stages | (stages_t(1) << stages_t(B_));
@@ -185,7 +211,7 @@ namespace SKENGINE_NAME_NS {
 
 		auto state = State(ca, true);
 
-		VkExtent2D old_render_xt  = mRenderExtent;
+		VkExtent2D old_render_xt  = mMaxRenderExtent;
 		VkExtent2D old_present_xt = mPresentExtent;
 
 		try {
@@ -196,8 +222,8 @@ namespace SKENGINE_NAME_NS {
 			initGframes(state); SET_STAGE_(2)
 
 			bool render_xt_changed =
-				(old_render_xt.width  != mRenderExtent.width) ||
-				(old_render_xt.height != mRenderExtent.height);
+				(old_render_xt.width  != mMaxRenderExtent.width) ||
+				(old_render_xt.height != mMaxRenderExtent.height);
 			bool present_xt_changed =
 				(old_present_xt.width  != mPresentExtent.width) ||
 				(old_present_xt.height != mPresentExtent.height);
@@ -238,6 +264,14 @@ namespace SKENGINE_NAME_NS {
 
 	void Engine::RpassInitializer::initSurface() {
 		assert(mPhysDevice != nullptr);
+
+		if(mPrefs.headless) { // There is no surface, frames are only submitted to the graphics queue
+			mPresentQfamIndex = QfamIndex(mQueues.families.graphicsIndex);
+			mPresentQueue     = mQueues.graphics;
+			mLogger.debug("Headless mode, using queue family {} for the present queue", uint32_t(mPresentQfamIndex));
+			return;
+		}
+
 		assert(mSdlWindow  != nullptr);
 
 		{ // Create surface from window
@@ -281,6 +315,7 @@ namespace SKENGINE_NAME_NS {
 
 
 	void Engine::RpassInitializer::initSwapchain(State& state) {
+		if(mPrefs.headless) return initHeadlessImages(state);
 		assert(mSurface != nullptr);
 
 		{ // Verify that the surface supports writing to its swapchain images
@@ -295,8 +330,9 @@ namespace SKENGINE_NAME_NS {
 
 		mSurfaceFormat = vkutil::selectSwapchainFormat(nullptr, mPhysDevice, mSurface);
 		select_swapchain_extent(mLogger, &mPresentExtent, mPrefs.init_present_extent, mSurfaceCapabs, ! state.reinit);
-		mRenderExtent = select_render_extent(mPresentExtent, mPrefs.max_render_extent, mPrefs.upscale_factor);
-		if(! state.reinit) mLogger.debug("Chosen render extent {}x{}", mRenderExtent.width, mRenderExtent.height);
+		mMaxRenderExtent = select_render_extent(mPresentExtent, mPrefs.max_render_extent, mPrefs.upscale_factor);
+		mRenderExtent    = mPrefs.dynamic_resolution? scale_render_extent(mMaxRenderExtent, mResolutionScaler.scale()) : mMaxRenderExtent;
+		if(! state.reinit) mLogger.debug("Chosen render extent {}x{}", mMaxRenderExtent.width, mMaxRenderExtent.height);
 
 		uint32_t concurrent_qfams[] = {
 			mQueues.families.graphicsIndex,
@@ -435,6 +471,20 @@ namespace SKENGINE_NAME_NS {
 		for(size_t i = 0; i < frame_n; ++i) {
 			VkFence& gff = mGframeSelectionFences[i];
 			create_frame(gff);
+			mGframes[i].gpu_timestamps_written = false;
+		}
+
+		if(mPrefs.dynamic_resolution) { // Create the timestamp queries that the resolution scale depends on
+			assert(mGpuTimestampPool == nullptr);
+			if(mDevProps.limits.timestampComputeAndGraphics) {
+				VkQueryPoolCreateInfo qpc_info = { };
+				qpc_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				qpc_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+				qpc_info.queryCount = 2 * frame_n;
+				VK_CHECK(vkCreateQueryPool, mDevice, &qpc_info, nullptr, &mGpuTimestampPool);
+			} else {
+				mLogger.warn("The device does not support timestamps on graphics queues, dynamic resolution is disabled");
+			}
 		}
 	}
 
@@ -467,6 +517,7 @@ namespace SKENGINE_NAME_NS {
 
 
 	void Engine::RpassInitializer::destroySwapchain(State& state) {
+		if(mPrefs.headless) return destroyHeadlessImages(state);
 		if(mSwapchain == nullptr) return;
 
 		for(auto& gf : mGframes) vkDestroyImageView(mDevice, gf.swapchain_image_view, nullptr);
@@ -490,6 +541,11 @@ namespace SKENGINE_NAME_NS {
 			VkFence& gff = mGframeSelectionFences[i];
 			destroy_frame(gff);
 		}
+
+		if(mGpuTimestampPool != nullptr) {
+			vkDestroyQueryPool(mDevice, mGpuTimestampPool, nullptr);
+			mGpuTimestampPool = nullptr;
+		}
 	}
 
 
@@ -502,4 +558,97 @@ namespace SKENGINE_NAME_NS {
 		}
 	}
 
+
+	void Engine::RpassInitializer::initHeadlessImages(State& state) {
+		mSurfaceFormat   = select_headless_format(mLogger, mPhysDevice);
+		mPresentExtent   = mPrefs.init_present_extent;
+		mMaxRenderExtent = select_render_extent(mPresentExtent, mPrefs.max_render_extent, mPrefs.upscale_factor);
+		mRenderExtent    = mPrefs.dynamic_resolution? scale_render_extent(mMaxRenderExtent, mResolutionScaler.scale()) : mMaxRenderExtent;
+		if(! state.reinit) mLogger.debug("Headless present extent {}x{}, render extent {}x{}", mPresentExtent.width, mPresentExtent.height, mMaxRenderExtent.width, mMaxRenderExtent.height);
+
+		auto& hl = mHeadless;
+		size_t image_count = mPrefs.max_concurrent_frames + 1;
+
+		{ // Create the readback command buffer
+			VkCommandPoolCreateInfo cpc_info = { };
+			cpc_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cpc_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			cpc_info.queueFamilyIndex = mQueues.families.graphicsIndex;
+			VK_CHECK(vkCreateCommandPool, mDevice, &cpc_info, nullptr, &hl.cmdPool);
+			VkCommandBufferAllocateInfo cba_info = { };
+			cba_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			cba_info.commandPool = hl.cmdPool;
+			cba_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			cba_info.commandBufferCount = 1;
+			VK_CHECK(vkAllocateCommandBuffers, mDevice, &cba_info, &hl.cmd);
+			VkFenceCreateInfo fc_info = { };
+			fc_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VK_CHECK(vkCreateFence, mDevice, &fc_info, nullptr, &hl.readbackFence);
+		}
+
+		vkutil::ImageCreateInfo ic_info = { };
+		ic_info.usage  = headless_image_usage;
+		ic_info.extent = { mPresentExtent.width, mPresentExtent.height, 1 };
+		ic_info.format = mSurfaceFormat.format;
+		ic_info.type   = VK_IMAGE_TYPE_2D;
+		ic_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		ic_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		ic_info.tiling  = VK_IMAGE_TILING_OPTIMAL;
+		ic_info.arrayLayers = 1;
+		ic_info.mipLevels   = 1;
+		vkutil::AllocationCreateInfo ac_info = { };
+		ac_info.preferredMemFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		ac_info.vmaUsage = vkutil::VmaAutoMemoryUsage::eAutoPreferDevice;
+
+		assert(mGframes.empty() || state.reinit);
+		if(mGframes.size() < image_count) state.createGframes  = true;
+		else
+		if(mGframes.size() > image_count) state.destroyGframes = true;
+		mGframes.resize(image_count);
+		hl.images.reserve(image_count);
+		for(size_t i = 0; i < image_count; ++i) {
+			auto& img = hl.images.emplace_back(vkutil::Image::create(mVma, ic_info, ac_info));
+			auto& img_data = mGframes[i];
+			img_data.swapchain_image = img.value;
+			VkImageViewCreateInfo ivc_info = { };
+			ivc_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			ivc_info.image = img.value;
+			ivc_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			ivc_info.format   = mSurfaceFormat.format;
+			ivc_info.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			ivc_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			ivc_info.subresourceRange.layerCount = 1;
+			ivc_info.subresourceRange.levelCount = 1;
+			VK_CHECK(vkCreateImageView, mDevice, &ivc_info, nullptr, &img_data.swapchain_image_view);
+		}
+		mLogger.trace("Created {} headless image{}", image_count, image_count == 1? "":"s");
+
+		hl.imageSelector = 0;
+		mSwapchainOod = false;
+	}
+
+
+	void Engine::RpassInitializer::destroyHeadlessImages(State&) {
+		auto& hl = mHeadless;
+		if(hl.cmdPool == nullptr) return;
+
+		for(size_t i = 0; i < hl.images.size(); ++i) {
+			vkDestroyImageView(mDevice, mGframes[i].swapchain_image_view, nullptr);
+			vkutil::Image::destroy(mVma, hl.images[i]);
+		}
+		hl.images.clear();
+
+		if(hl.readback.value != nullptr) {
+			vkutil::Buffer::destroy(mVma, hl.readback);
+			hl.readback = { };
+			hl.readbackSize = 0;
+		}
+
+		vkDestroyFence(mDevice, hl.readbackFence, nullptr);
+		vkDestroyCommandPool(mDevice, hl.cmdPool, nullptr);
+		hl.readbackFence = nullptr;
+		hl.cmdPool = nullptr;
+		hl.cmd     = nullptr;
+	}
+
 }
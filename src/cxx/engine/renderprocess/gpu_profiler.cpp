@@ -0,0 +1,191 @@
+#include "gpu_profiler.hpp"
+
+#include <vk-util/error.hpp>
+
+#include <cassert>
+#include <algorithm>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	namespace {
+
+		constexpr VkQueryPipelineStatisticFlags statistic_flags =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+		constexpr unsigned statistic_count = 6; // Number of bits in `statistic_flags`, in bit order
+
+		uint32_t wave_query(unsigned wave, bool end) { return (2 * wave) + (end? 1 : 0); }
+
+		uint32_t stage_query(unsigned waveCount, unsigned step, GpuProfiler::Stage stage, bool end) {
+			return (2 * waveCount) + (4 * step) + (2 * unsigned(stage)) + (end? 1 : 0);
+		}
+
+
+		void accumulate(double& avg, double sample, bool first) {
+			avg = first? sample : (avg + ((sample - avg) * GpuProfiler::avgWeight));
+		}
+
+		void accumulate(GpuProfiler::PipelineStatistics& avg, const uint64_t* sample, bool first) {
+			accumulate(avg.iaVertices,         double(sample[0]), first);
+			accumulate(avg.iaPrimitives,       double(sample[1]), first);
+			accumulate(avg.vsInvocations,      double(sample[2]), first);
+			accumulate(avg.clippingPrimitives, double(sample[3]), first);
+			accumulate(avg.fsInvocations,      double(sample[4]), first);
+			accumulate(avg.csInvocations,      double(sample[5]), first);
+		}
+
+	}
+
+
+	void GpuProfiler::setup(VkPhysicalDevice physDev, VkDevice dev, unsigned gframeCount, unsigned waveCount, unsigned stepCount) {
+		assert(gp_gframes.empty());
+		gp_device    = dev;
+		gp_waveCount = waveCount;
+		gp_stepCount = stepCount;
+		gp_sampleCount = 0;
+
+		{
+			VkPhysicalDeviceProperties props;
+			VkPhysicalDeviceFeatures   features;
+			vkGetPhysicalDeviceProperties(physDev, &props);
+			vkGetPhysicalDeviceFeatures(physDev, &features);
+			gp_timestampPeriod     = props.limits.timestampPeriod;
+			gp_timestampsSupported = props.limits.timestampComputeAndGraphics;
+			gp_statsSupported      = gp_timestampsSupported && features.pipelineStatisticsQuery; // The Engine enables the feature whenever it is available
+		}
+
+		gp_steps.assign(stepCount, { });
+		gp_waves.assign(waveCount, { });
+		if(! gp_timestampsSupported) return;
+
+		VkQueryPoolCreateInfo qpc_info = { };
+		qpc_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		gp_gframes.reserve(gframeCount);
+		for(unsigned i = 0; i < gframeCount; ++i) {
+			auto& gf = gp_gframes.emplace_back(GframeQueries { nullptr, nullptr, false });
+			qpc_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+			qpc_info.queryCount = timestampCount();
+			qpc_info.pipelineStatistics = 0;
+			VK_CHECK(vkCreateQueryPool, dev, &qpc_info, nullptr, &gf.timestamps);
+			if(gp_statsSupported) {
+				qpc_info.queryType  = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				qpc_info.queryCount = statisticsCount();
+				qpc_info.pipelineStatistics = statistic_flags;
+				VK_CHECK(vkCreateQueryPool, dev, &qpc_info, nullptr, &gf.statistics);
+			}
+		}
+
+		gp_resultCache.resize(std::max(timestampCount(), statisticsCount() * statistic_count));
+	}
+
+
+	void GpuProfiler::destroy() {
+		for(auto& gf : gp_gframes) {
+			vkDestroyQueryPool(gp_device, gf.timestamps, nullptr);
+			if(gf.statistics != nullptr) vkDestroyQueryPool(gp_device, gf.statistics, nullptr);
+		}
+		gp_gframes.clear();
+		gp_steps.clear();
+		gp_waves.clear();
+	}
+
+
+	void GpuProfiler::beginGframe(VkCommandBuffer cmd, unsigned gframe) {
+		if(! gp_timestampsSupported) return;
+		assert(gframe < gp_gframes.size());
+		auto& gf = gp_gframes[gframe];
+		vkCmdResetQueryPool(cmd, gf.timestamps, 0, timestampCount());
+		if(gf.statistics != nullptr) vkCmdResetQueryPool(cmd, gf.statistics, 0, statisticsCount());
+		gf.written = true;
+	}
+
+
+	void GpuProfiler::writeWaveBegin(VkCommandBuffer cmd, unsigned gframe, unsigned wave) {
+		if(! gp_timestampsSupported) return;
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, gp_gframes[gframe].timestamps, wave_query(wave, false));
+	}
+
+
+	void GpuProfiler::writeWaveEnd(VkCommandBuffer cmd, unsigned gframe, unsigned wave) {
+		if(! gp_timestampsSupported) return;
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, gp_gframes[gframe].timestamps, wave_query(wave, true));
+	}
+
+
+	void GpuProfiler::writeStageBegin(VkCommandBuffer cmd, unsigned gframe, unsigned step, Stage stage) {
+		if(! gp_timestampsSupported) return;
+		auto& gf = gp_gframes[gframe];
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, gf.timestamps, stage_query(gp_waveCount, step, stage, false));
+		if(gf.statistics != nullptr) vkCmdBeginQuery(cmd, gf.statistics, (2 * step) + unsigned(stage), 0);
+	}
+
+
+	void GpuProfiler::writeStageEnd(VkCommandBuffer cmd, unsigned gframe, unsigned step, Stage stage) {
+		if(! gp_timestampsSupported) return;
+		auto& gf = gp_gframes[gframe];
+		if(gf.statistics != nullptr) vkCmdEndQuery(cmd, gf.statistics, (2 * step) + unsigned(stage));
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, gf.timestamps, stage_query(gp_waveCount, step, stage, true));
+	}
+
+
+	bool GpuProfiler::collect(unsigned gframe) {
+		if(! gp_timestampsSupported) return false;
+		assert(gframe < gp_gframes.size());
+		auto& gf = gp_gframes[gframe];
+		if(! gf.written) return false;
+
+		// No VK_QUERY_RESULT_WAIT_BIT: results that are not ready yet are simply skipped
+		auto* ts = gp_resultCache.data();
+		VkResult res = vkGetQueryPoolResults(gp_device, gf.timestamps, 0, timestampCount(), timestampCount() * sizeof(uint64_t), ts, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if(res != VK_SUCCESS) return false;
+		gf.written = false;
+
+		bool first = gp_sampleCount == 0;
+		auto elapsed = [&](uint32_t begin) { return double(ts[begin + 1] - ts[begin]) * gp_timestampPeriod / 1'000'000'000.0; };
+		for(unsigned i = 0; i < gp_waveCount; ++i) accumulate(gp_waves[i].time, elapsed(wave_query(i, false)), first);
+		for(unsigned i = 0; i < gp_stepCount; ++i) {
+			accumulate(gp_steps[i].prepareTime, elapsed(stage_query(gp_waveCount, i, Stage::ePrepare, false)), first);
+			accumulate(gp_steps[i].drawTime,    elapsed(stage_query(gp_waveCount, i, Stage::eDraw,    false)), first);
+		}
+
+		if(gf.statistics != nullptr) {
+			auto* stats = gp_resultCache.data();
+			constexpr auto stride = statistic_count * sizeof(uint64_t);
+			res = vkGetQueryPoolResults(gp_device, gf.statistics, 0, statisticsCount(), statisticsCount() * stride, stats, stride, VK_QUERY_RESULT_64_BIT);
+			if(res == VK_SUCCESS) {
+				for(unsigned i = 0; i < gp_stepCount; ++i) {
+					accumulate(gp_steps[i].prepareStats, stats + ((2 * i) + 0) * statistic_count, first);
+					accumulate(gp_steps[i].drawStats,    stats + ((2 * i) + 1) * statistic_count, first);
+				}
+			}
+		}
+
+		++ gp_sampleCount;
+		return true;
+	}
+
+
+	void GpuProfiler::logReport(Logger& logger) const {
+		if(gp_sampleCount == 0) return;
+		constexpr auto ms = [](double s) { return s * 1000.0; };
+		logger.debug("GPU profile ({} samples):", gp_sampleCount);
+		for(unsigned i = 0; i < gp_waveCount; ++i) logger.debug("  Wave {}: {:.3f}ms", i, ms(gp_waves[i].time));
+		for(unsigned i = 0; i < gp_stepCount; ++i) {
+			auto& step = gp_steps[i];
+			logger.debug("  Step {}: prepare {:.3f}ms, draw {:.3f}ms", i, ms(step.prepareTime), ms(step.drawTime));
+			if(gp_statsSupported) {
+				logger.debug("    {:.0f} vertices, {:.0f} primitives, {:.0f} VS / {:.0f} FS / {:.0f} CS invocations",
+					step.drawStats.iaVertices, step.drawStats.iaPrimitives,
+					step.drawStats.vsInvocations, step.drawStats.fsInvocations,
+					step.prepareStats.csInvocations + step.drawStats.csInvocations );
+			}
+		}
+	}
+
+}
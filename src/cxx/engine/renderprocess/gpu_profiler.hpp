@@ -0,0 +1,102 @@
+#pragma once
+
+#ifdef SKENGINE_GPU_PROFILING
+
+#include "../types.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <span>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	/// \brief Records GPU timestamps (and optionally pipeline statistics)
+	///        around every wave and renderer stage of a RenderProcess.
+	///
+	/// Each gframe owns its query pools, which are reset and written while
+	/// the gframe's commands are recorded, and only read back when the
+	/// gframe is reused: at that point its fences have been waited upon,
+	/// so reading the results never stalls.
+	///
+	/// Only compiled when the `SKENGINE_GPU_PROFILING` CMake option is on.
+	///
+	class GpuProfiler {
+	public:
+		static constexpr double avgWeight = 1.0 / 16.0; ///< The weight of a new sample in the rolling averages.
+
+		enum class Stage : unsigned { ePrepare = 0, eDraw = 1 };
+
+		struct PipelineStatistics {
+			double iaVertices;
+			double iaPrimitives;
+			double vsInvocations;
+			double clippingPrimitives;
+			double fsInvocations;
+			double csInvocations;
+		};
+
+		struct StepProfile {
+			double prepareTime; // Seconds
+			double drawTime;    // Seconds
+			PipelineStatistics prepareStats;
+			PipelineStatistics drawStats;
+		};
+
+		struct WaveProfile {
+			double time; // Seconds
+		};
+
+		GpuProfiler(): gp_device(nullptr), gp_timestampPeriod(0.0), gp_waveCount(0), gp_stepCount(0), gp_sampleCount(0), gp_timestampsSupported(false), gp_statsSupported(false) { }
+
+		void setup(VkPhysicalDevice, VkDevice, unsigned gframeCount, unsigned waveCount, unsigned stepCount);
+		void destroy();
+
+		/// \brief Resets the gframe's queries; must be recorded before any other command of the gframe.
+		void beginGframe(VkCommandBuffer, unsigned gframe);
+
+		void writeWaveBegin (VkCommandBuffer, unsigned gframe, unsigned wave);
+		void writeWaveEnd   (VkCommandBuffer, unsigned gframe, unsigned wave);
+		void writeStageBegin(VkCommandBuffer, unsigned gframe, unsigned step, Stage);
+		void writeStageEnd  (VkCommandBuffer, unsigned gframe, unsigned step, Stage);
+
+		/// \brief Reads back the results of the gframe's last submission, if it is available.
+		/// \returns Whether new samples were collected.
+		bool collect(unsigned gframe);
+
+		void logReport(Logger&) const;
+
+		std::span<const StepProfile> stepProfiles() const noexcept { return gp_steps; }
+		std::span<const WaveProfile> waveProfiles() const noexcept { return gp_waves; }
+		unsigned sampleCount() const noexcept { return gp_sampleCount; }
+		bool enabled() const noexcept { return gp_timestampsSupported; }
+		bool pipelineStatisticsEnabled() const noexcept { return gp_statsSupported; }
+
+	private:
+		struct GframeQueries {
+			VkQueryPool timestamps;
+			VkQueryPool statistics;
+			bool written;
+		};
+
+		VkDevice gp_device;
+		double   gp_timestampPeriod; // Nanoseconds per tick
+		std::vector<GframeQueries> gp_gframes;
+		std::vector<StepProfile>   gp_steps;
+		std::vector<WaveProfile>   gp_waves;
+		std::vector<uint64_t>      gp_resultCache;
+		unsigned gp_waveCount;
+		unsigned gp_stepCount;
+		unsigned gp_sampleCount;
+		bool gp_timestampsSupported;
+		bool gp_statsSupported;
+
+		uint32_t timestampCount() const noexcept { return (2 * gp_waveCount) + (4 * gp_stepCount); }
+		uint32_t statisticsCount() const noexcept { return 2 * gp_stepCount; }
+	};
+
+}
+
+#endif
@@ -332,6 +332,12 @@ namespace SKENGINE_NAME_NS {
 					createSyncSet(dev, rp_drawSyncPrimitives.back());
 				}
 			}
+
+			#ifdef SKENGINE_GPU_PROFILING
+				VmaAllocatorInfo vmaInfo;
+				vmaGetAllocatorInfo(vma, &vmaInfo);
+				rp_gpuProfiler.setup(vmaInfo.physicalDevice, dev, gframeCount, waveCount, rp_steps.size());
+			#endif
 		}
 
 		{ // Create rpasses
@@ -384,6 +390,10 @@ namespace SKENGINE_NAME_NS {
 
 		notifyRenderersOfSwapchainDestruction(*this, ca, "destruction", rp_gframeCount);
 
+		#ifdef SKENGINE_GPU_PROFILING
+			rp_gpuProfiler.destroy();
+		#endif
+
 		setWaveGframeCount(dev, rp_vkState.queueFamIdx, &rp_waveCmds, 0);
 
 		for(size_t i = 0; i < rp_rpasses.size(); ++i) {
@@ -512,6 +522,13 @@ namespace SKENGINE_NAME_NS {
 
 			setWaveGframeCount(dev, rp_vkState.queueFamIdx, &rp_waveCmds, waveGframeCount);
 
+			#ifdef SKENGINE_GPU_PROFILING
+				VmaAllocatorInfo vmaInfo;
+				vmaGetAllocatorInfo(rp_vkState.vma, &vmaInfo);
+				rp_gpuProfiler.destroy();
+				rp_gpuProfiler.setup(vmaInfo.physicalDevice, dev, newGframeCount, size_t(rp_steps.back().second.seqIndex) + size_t(1), rp_steps.size());
+			#endif
+
 			rp_rtargetStorage.setGframeCount(newGframeCount);
 			rp_gframeCount = newGframeCount;
 		}
@@ -2,6 +2,7 @@
 
 #include "../types.hpp"
 #include "../renderer.hpp"
+#include "gpu_profiler.hpp"
 
 #include <idgen.hpp>
 
@@ -278,6 +279,11 @@ namespace SKENGINE_NAME_NS {
 		WaveRange waveRange() &;
 		auto sortedStepRange(this auto& self) { return std::span(self.rp_steps); }
 
+		#ifdef SKENGINE_GPU_PROFILING
+			GpuProfiler&       gpuProfiler()       noexcept { return rp_gpuProfiler; }
+			const GpuProfiler& gpuProfiler() const noexcept { return rp_gpuProfiler; }
+		#endif
+
 	private:
 		Logger rp_logger;
 		VulkanState rp_vkState;
@@ -287,6 +293,9 @@ namespace SKENGINE_NAME_NS {
 		std::vector<DrawSyncPrimitives> rp_drawSyncPrimitives;
 		std::vector<WaveGframeData> rp_waveCmds;
 		RenderTargetStorage rp_rtargetStorage;
+		#ifdef SKENGINE_GPU_PROFILING
+			GpuProfiler rp_gpuProfiler;
+		#endif
 		unsigned rp_gframeCount;
 		unsigned rp_waveIterValidity;
 		bool rp_initialized;
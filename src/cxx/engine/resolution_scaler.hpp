@@ -0,0 +1,90 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+
+
+namespace SKENGINE_NAME_NS {
+
+	struct ResolutionScalerParams {
+		double targetUtilization; ///< The fraction of the frame interval that the GPU should be busy for.
+		double minScale;          ///< The lowest per-axis scale, relative to the allocated render extent.
+		double kp;
+		double ki;
+		double kd;
+		double tolerance;         ///< Relative errors smaller than this are ignored, to avoid resizing every frame.
+	};
+
+
+	/// \brief A PID controller that picks a per-axis render scale from
+	///        measured GPU frame times.
+	///
+	/// The controlled variable is the rendered area (the square of the
+	/// scale), since GPU time roughly scales with the number of pixels;
+	/// the error is the relative difference between the measured GPU time
+	/// and the target one.
+	///
+	/// The scale only changes the sub-rectangle that is rendered to, so
+	/// no render target needs to be recreated when it changes.
+	///
+	class ResolutionScaler {
+	public:
+		ResolutionScaler() = default;
+
+		ResolutionScaler(const ResolutionScalerParams& params, double target_frame_time):
+			rs_params(params),
+			rs_targetTime(target_frame_time * params.targetUtilization),
+			rs_area(1.0),
+			rs_scale(1.0),
+			rs_error1(0.0),
+			rs_error2(0.0),
+			rs_samples(0)
+		{ }
+
+		/// \brief Feeds a GPU frame time to the controller.
+		/// \returns Whether the scale changed.
+		///
+		bool update(double gpu_frame_time) noexcept {
+			// Velocity form: the output is clamped instead of the integral, which cannot wind up
+			double min_area = rs_params.minScale * rs_params.minScale;
+			double error = (gpu_frame_time - rs_targetTime) / rs_targetTime;
+			if(std::abs(error) < rs_params.tolerance) error = 0.0;
+			if(rs_samples < 1) rs_error1 = error;
+			if(rs_samples < 2) rs_error2 = rs_error1;
+			double delta =
+				(rs_params.kp * (error - rs_error1)) +
+				(rs_params.ki * error) +
+				(rs_params.kd * (error - (2.0 * rs_error1) + rs_error2));
+			rs_error2 = rs_error1;
+			rs_error1 = error;
+			rs_samples = std::min(rs_samples + 1, 2u);
+			rs_area = std::clamp(rs_area - delta, min_area, 1.0);
+
+			double scale = std::sqrt(rs_area);
+			bool changed = scale != rs_scale;
+			rs_scale = scale;
+			return changed;
+		}
+
+		void reset(double target_frame_time) noexcept {
+			*this = ResolutionScaler(rs_params, target_frame_time);
+		}
+
+		double scale      () const noexcept { return rs_scale; }
+		double targetTime () const noexcept { return rs_targetTime; }
+		const auto& params() const noexcept { return rs_params; }
+
+	private:
+		ResolutionScalerParams rs_params;
+		double rs_targetTime;
+		double rs_area;
+		double rs_scale;
+		double rs_error1;
+		double rs_error2;
+		unsigned rs_samples;
+	};
+
+}
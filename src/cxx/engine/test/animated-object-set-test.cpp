@@ -0,0 +1,122 @@
+#include <engine-util/animated_object_set.hpp>
+#include <engine-util/animation_tracks.hpp>
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <unordered_map>
+
+
+
+enum class ObjectId : uint_fast64_t { };
+
+using ske::AnimCurve;
+using ske::AnimEndAction;
+using AnimatedObjects = ske::AnimatedObjectSet<ObjectId>;
+
+constexpr float epsilon = 1.0f / 4096.0f;
+
+
+
+bool near(glm::vec3 l, glm::vec3 r) { return std::abs(l.x - r.x) < epsilon && std::abs(l.y - r.y) < epsilon && std::abs(l.z - r.z) < epsilon; }
+
+
+bool testReferenceCounts() {
+	bool fail = false;
+	AnimatedObjects set;
+	auto a = ObjectId(1);
+	auto b = ObjectId(2);
+
+	if(! set.acquire(a)) fail = true; // New
+	if(  set.acquire(a)) fail = true; // Held twice
+	if(! set.acquire(b)) fail = true;
+	if(set.size() != 2) fail = true;
+
+	if(  set.release(a) || ! set.contains(a)) fail = true; // Still held once
+	if(! set.release(a) ||   set.contains(a)) fail = true;
+	if(  set.release(a)) fail = true; // Not animated
+	if(  set.release(ObjectId(3))) fail = true;
+
+	set.acquire(b);
+	if(! set.erase(b) || set.contains(b) || ! set.empty()) fail = true; // Removed objects are forgotten at once
+	if(  set.erase(b)) fail = true;
+
+	fmt::print("Animated object reference counts: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testAnimatedCommits() {
+	// Objects are stored like `ObjectStorage` stores them, and the commit flags follow its rules:
+	// the batches are rebuilt when the set of animated objects changes, not whenever an object is animated
+	std::unordered_map<ObjectId, glm::vec3> objects;
+	AnimatedObjects animated;
+	ske::AnimTrack<glm::vec3> track;
+	bool fail = false;
+	bool batchesNeedUpdate = false;
+	unsigned batchUpdates = 0;
+
+	auto animate = [&](ObjectId id) -> glm::vec3* {
+		auto found = objects.find(id);
+		if(found == objects.end()) return nullptr;
+		if(animated.acquire(id)) batchesNeedUpdate = true;
+		return &found->second;
+	};
+	auto stopAnimating = [&](ObjectId id) { if(animated.release(id)) batchesNeedUpdate = true; };
+	auto commit = [&]() { if(batchesNeedUpdate) ++ batchUpdates; batchesNeedUpdate = false; };
+
+	objects[ObjectId(1)] = { };
+	objects[ObjectId(2)] = { };
+	auto* pos1 = animate(ObjectId(1));
+	auto* pos2 = animate(ObjectId(2));
+	animate(ObjectId(1)); // A second animation on the same object
+	auto anim1 = track.start(AnimEndAction::ePause, { 0.0f, 0.0f, 0.0f }, { 4.0f, 0.0f, 0.0f }, 1.0f, AnimCurve::linear(), pos1);
+	auto anim2 = track.start(AnimEndAction::ePause, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 8.0f }, 2.0f, AnimCurve::linear(), pos2);
+	commit();
+
+	// The pending transforms are written in place, and stay where they are while other objects are created
+	for(unsigned i = 3; i < 1000; ++i) objects[ObjectId(i)] = { };
+	for(unsigned frame = 1; frame <= 8; ++frame) {
+		track.fwd(0.125f);
+		commit();
+		float x = 0.125f * float(frame);
+		if(! near(objects[ObjectId(1)], { 4.0f * x, 0.0f, 0.0f }) || ! near(objects[ObjectId(2)], { 0.0f, 0.0f, 4.0f * x })) {
+			fmt::print(stderr, "Frame {}: animated objects were not written in place\n", frame);
+			fail = true;
+		}
+	}
+	if(batchUpdates != 1) {
+		fmt::print(stderr, "Batches were updated {} times while the same objects were animated\n", batchUpdates);
+		fail = true;
+	}
+
+	track.stop(anim1);
+	stopAnimating(ObjectId(1)); commit(); // Still animated by its other animation
+	if(batchUpdates != 1 || ! animated.contains(ObjectId(1))) fail = true;
+	stopAnimating(ObjectId(1)); commit();
+	if(batchUpdates != 2 || animated.contains(ObjectId(1))) fail = true;
+	track.stop(anim2);
+	stopAnimating(ObjectId(2)); commit();
+	if(batchUpdates != 3 || ! animated.empty()) fail = true;
+	if(animate(ObjectId(5000)) != nullptr || batchUpdates != 3) fail = true; // Nonexistent objects are not animated
+
+	fmt::print("Animated object commits: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testReferenceCounts() ? fail : true;
+		fail = testAnimatedCommits() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
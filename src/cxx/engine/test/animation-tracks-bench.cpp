@@ -0,0 +1,111 @@
+// 100000 repeating vec3 animations, such as object positions, advanced once
+// per frame: compares an AnimationSet of Animation objects (a virtual call
+// and a shared AnimationValue per animation, as sneka3d's are), and an
+// AnimTrack evaluating all of them as arrays and writing their values
+// to a contiguous array of targets.
+
+#include <engine-util/animation_tracks.hpp>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::AnimationSet;
+using SKENGINE_NAME_NS::AnimationValue;
+using SKENGINE_NAME_NS::Animation;
+using SKENGINE_NAME_NS::AnimTrack;
+using SKENGINE_NAME_NS::AnimCurve;
+using SKENGINE_NAME_NS::AnimEndAction;
+using SKENGINE_NAME_NS::anim_x_t;
+
+constexpr size_t animCount  = 100000;
+constexpr size_t frameCount = 200;
+constexpr float  frameStep  = 1.0f / 60.0f;
+
+
+
+class EaseOut : public Animation<glm::vec3> {
+public:
+	glm::vec3 beginning;
+	glm::vec3 dir;
+
+	EaseOut(AnimationValue<glm::vec3>& v, glm::vec3 beginning, glm::vec3 dir):
+		Animation<glm::vec3>(v),
+		beginning(beginning),
+		dir(dir)
+	{ }
+
+	void animation_setProgress(glm::vec3& dst, anim_x_t x) noexcept override {
+		dst = beginning + (dir * ((2.0f * x) - (x * x)));
+	}
+};
+
+
+struct Endpoints {
+	glm::vec3 from;
+	glm::vec3 to;
+};
+
+
+std::vector<Endpoints> makeEndpoints() {
+	auto rng  = std::minstd_rand(1);
+	auto dist = std::uniform_real_distribution<float>(-100.0f, 100.0f);
+	std::vector<Endpoints> r;
+	r.reserve(animCount);
+	for(size_t i = 0; i < animCount; ++i) r.push_back({ { dist(rng), dist(rng), dist(rng) }, { dist(rng), dist(rng), dist(rng) } });
+	return r;
+}
+
+
+template <typename Fn>
+double usPerFrame(Fn&& frame) {
+	using clock = std::chrono::steady_clock;
+	frame(); // Warm up
+	auto beg = clock::now();
+	for(size_t i = 0; i < frameCount; ++i) frame();
+	auto end = clock::now();
+	return std::chrono::duration<double, std::micro>(end - beg).count() / double(frameCount);
+}
+
+
+double runSet(const std::vector<Endpoints>& endpoints, float& checksum) {
+	AnimationSet<glm::vec3> set;
+	std::vector<AnimationValue<glm::vec3>> values(animCount);
+	for(size_t i = 0; i < animCount; ++i) {
+		set.start<EaseOut>(AnimEndAction::eRepeat, values[i], endpoints[i].from, endpoints[i].to - endpoints[i].from);
+	}
+	auto r = usPerFrame([&]() { set.fwd(frameStep); });
+	for(auto& v : values) checksum += v.getValue().x;
+	return r;
+}
+
+
+double runTrack(const std::vector<Endpoints>& endpoints, float& checksum) {
+	AnimTrack<glm::vec3> track;
+	std::vector<glm::vec3> values(animCount);
+	track.reserve(animCount);
+	for(size_t i = 0; i < animCount; ++i) {
+		track.start(AnimEndAction::eRepeat, endpoints[i].from, endpoints[i].to, 1.0f, AnimCurve::easeOut(), &values[i]);
+	}
+	auto r = usPerFrame([&]() { track.fwd(frameStep); });
+	for(auto& v : values) checksum += v.x;
+	return r;
+}
+
+
+int main() {
+	auto endpoints = makeEndpoints();
+	float checksums[2] = { };
+	fmt::print("{} vec3 animations, {} frames\n", animCount, frameCount);
+	fmt::print("{:>14} | {:>10} | {:>10}\n", "path", "us/frame", "ns/value");
+	auto print = [](const char* name, double us) {
+		fmt::print("{:>14} | {:>10.1f} | {:>10.2f}\n", name, us, us * 1000.0 / double(animCount));
+	};
+	print("AnimationSet", runSet  (endpoints, checksums[0]));
+	print("AnimTrack",    runTrack(endpoints, checksums[1]));
+	fmt::print("Checksums: {:.1f}, {:.1f}\n", checksums[0], checksums[1]);
+}
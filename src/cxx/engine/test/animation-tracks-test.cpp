@@ -0,0 +1,169 @@
+#include <engine-util/animation_tracks.hpp>
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+
+
+using ske::AnimCurve;
+using ske::AnimEndAction;
+using ske::AnimState;
+
+constexpr float epsilon = 1.0f / 4096.0f;
+
+
+
+bool near(float l, float r) { return std::abs(l - r) < epsilon; }
+bool near(glm::vec3 l, glm::vec3 r) { return near(l.x, r.x) && near(l.y, r.y) && near(l.z, r.z); }
+
+
+bool testCurves() {
+	bool fail = false;
+	for(int i = 0; i <= 16; ++i) {
+		float x = float(i) / 16.0f;
+		if(! near(AnimCurve::linear() (x), x))                              fail = true;
+		if(! near(AnimCurve::ease   () (x), (3.0f * x * x) - (2.0f * x * x * x))) fail = true;
+		if(! near(AnimCurve::easeIn () (x), x * x))                         fail = true;
+		if(! near(AnimCurve::easeOut() (x), (2.0f * x) - (x * x)))         fail = true;
+	}
+	if(! near(AnimCurve::cubic(0.5f, 2.0f) (0.0f), 0.0f)) fail = true;
+	if(! near(AnimCurve::cubic(0.5f, 2.0f) (1.0f), 1.0f)) fail = true;
+
+	fmt::print("Animation curves: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testValues() {
+	constexpr size_t animCount = 100;
+	constexpr float  step      = 0.05f;
+	constexpr AnimCurve curves[] = { AnimCurve::linear(), AnimCurve::ease(), AnimCurve::easeOut(), AnimCurve::cubic(0.2f, 1.3f) };
+	struct Ref { glm::vec3 from, to; float duration; AnimCurve curve; ske::AnimId id; };
+
+	auto rng  = std::minstd_rand(1);
+	auto dist = std::uniform_real_distribution<float>(-10.0f, 10.0f);
+	ske::AnimTrack<glm::vec3> track;
+	std::vector<Ref> refs;
+	std::vector<glm::vec3> targets(animCount);
+	bool fail = false;
+
+	for(size_t i = 0; i < animCount; ++i) {
+		Ref ref = { { dist(rng), dist(rng), dist(rng) }, { dist(rng), dist(rng), dist(rng) }, 0.5f + float(i % 7) * 0.25f, curves[i % 4], { } };
+		ref.id = track.start(AnimEndAction::ePause, ref.from, ref.to, ref.duration, ref.curve, &targets[i]);
+		refs.push_back(ref);
+	}
+
+	// Remove every third animation, which moves others around
+	std::vector<bool> removed(animCount, false);
+	for(size_t i = 0; i < animCount; i += 3) {
+		track.interrupt(refs[i].id);
+		removed[i] = true;
+	}
+	if(track.size() != animCount - ((animCount + 2) / 3)) fail = true;
+
+	for(int s = 1; s <= 60; ++s) {
+		track.fwd(step);
+		for(size_t i = 0; i < animCount; ++i) {
+			if(removed[i]) continue;
+			auto& ref = refs[i];
+			float x = std::min(1.0f, float(s) * step / ref.duration);
+			auto expect = ref.from + ((ref.to - ref.from) * ref.curve(x));
+			if(! near(targets[i], expect) || ! near(track.getValue(ref.id), expect)) {
+				fmt::print(stderr, "Animation {} at step {}: expected ({}, {}, {}), got ({}, {}, {})\n", i, s, expect.x, expect.y, expect.z, targets[i].x, targets[i].y, targets[i].z);
+				fail = true;
+			}
+			float xu = float(s) * step / ref.duration;
+			auto state = track.getAnimationState(ref.id);
+			if(std::abs(xu - 1.0f) > epsilon && state != (xu > 1.0f? AnimState::ePaused : AnimState::eActive)) fail = true;
+		}
+		if(fail) break;
+	}
+
+	fmt::print("Animation track values: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testEndActions() {
+	using enum AnimEndAction;
+	ske::AnimTrack<float> track;
+	float vTerminate = -1.0f, vClamp = -1.0f, vRepeat = -1.0f, vPause = -1.0f, vStopped = -1.0f;
+	bool fail = false;
+
+	auto idTerminate = track.start(eTerminate,      0.0f, 1.0f, 1.0f, AnimCurve::linear(), &vTerminate);
+	auto idRepeat    = track.start(eRepeat,         0.0f, 1.0f, 1.0f, AnimCurve::linear(), &vRepeat);
+	auto idPause     = track.start(ePause,          0.0f, 1.0f, 1.0f, AnimCurve::linear(), &vPause);
+	auto idStopped   = track.start(eClampThenPause, 0.0f, 4.0f, 1.0f, AnimCurve::ease(),   &vStopped);
+	auto idClamp     = track.start(eClampThenTerminate, 0.0f, 2.0f, 2.0f, AnimCurve::linear(), &vClamp);
+
+	track.fwd(0.5f);
+	track.pause(idPause);
+	if(track.getAnimationState(idPause) != AnimState::ePaused) fail = true;
+	track.stop(idStopped);
+	if(track.getAnimationState(idStopped) != AnimState::eNotSet || ! near(vStopped, 4.0f)) fail = true;
+
+	track.fwd(0.75f);
+	if(track.getAnimationState(idTerminate) != AnimState::eNotSet || ! near(vTerminate, 1.0f)) fail = true;
+	if(track.getAnimationState(idRepeat) != AnimState::eActive || ! near(vRepeat, 1.0f)) fail = true;
+	if(! near(vPause, 0.5f)) fail = true;
+	if(! near(vClamp, 1.25f)) fail = true;
+
+	track.fwd(0.5f);
+	if(! near(vRepeat, 0.75f)) fail = true;
+	track.resume(idPause);
+	track.fwd(0.25f);
+	if(! near(vPause, 0.75f) || ! near(vRepeat, 1.0f)) fail = true;
+	track.fwd(1.0f);
+	if(track.getAnimationState(idPause) != AnimState::ePaused || ! near(vPause, 1.0f)) fail = true;
+	if(track.getAnimationState(idClamp) != AnimState::eNotSet || ! near(vClamp, 2.0f)) fail = true;
+
+	track.interrupt(idRepeat);
+	track.interrupt(idPause);
+	if(track.size() != 0) fail = true;
+
+	fmt::print("Animation end actions: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testQuaternions() {
+	ske::AnimTrack<glm::quat> track;
+	bool fail = false;
+
+	// The same rotation with opposite signs must not be animated the long way around
+	auto from = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	auto to   = glm::quat(-std::cos(0.5f), 0.0f, -std::sin(0.5f), 0.0f);
+	auto id = track.start(AnimEndAction::ePause, from, to);
+	for(int s = 0; s < 10; ++s) {
+		track.fwd(0.1f);
+		auto q = track.getValue(id);
+		float len2 = (q.x * q.x) + (q.y * q.y) + (q.z * q.z) + (q.w * q.w);
+		if(! near(len2, 1.0f) || q.w < 0.0f) fail = true;
+	}
+	auto q = track.getValue(id);
+	if(! near(q.w, std::cos(0.5f)) || ! near(q.y, std::sin(0.5f))) fail = true;
+
+	fmt::print("Animation track quaternions: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testCurves()      ? fail : true;
+		fail = testValues()      ? fail : true;
+		fail = testEndActions()  ? fail : true;
+		fail = testQuaternions() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
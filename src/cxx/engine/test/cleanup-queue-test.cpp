@@ -0,0 +1,163 @@
+#include <engine/cleanup_queue.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+
+
+using timeline_t = SKENGINE_NAME_NS::CleanupQueue::timeline_t;
+
+
+
+// Simulates a device that completes frames some time after they are submitted
+struct FakeGpuClock {
+	std::deque<timeline_t> inFlight;
+	timeline_t submitted = 0;
+	timeline_t completed = 0;
+
+	timeline_t submit() { inFlight.push_back(++ submitted); return submitted; }
+
+	void completeOne() {
+		if(inFlight.empty()) return;
+		completed = inFlight.front();
+		inFlight.pop_front();
+	}
+};
+
+
+struct Resource {
+	unsigned   id;
+	timeline_t lastUse;
+	unsigned   retirement; // Which call to `CleanupQueue::retire` destroyed the resource
+};
+
+
+
+bool testRetirementOrder(unsigned framesInFlight, unsigned frameCount) {
+	auto queue = SKENGINE_NAME_NS::CleanupQueue();
+	auto clock = FakeGpuClock();
+	auto destroyed = std::vector<Resource>();
+	unsigned nextId = 0;
+	unsigned retirement = 0;
+	bool fail = false;
+
+	auto destroy = [&](Resource res) {
+		if(res.lastUse > clock.completed) {
+			fmt::print(stderr, "Resource {} destroyed at completed value {}, but was used by frame {}\n", res.id, clock.completed, res.lastUse);
+			fail = true;
+		}
+		res.retirement = retirement;
+		destroyed.push_back(res);
+	};
+
+	auto retire = [&](timeline_t value) {
+		queue.retire(value);
+		++ retirement;
+	};
+
+	for(unsigned i = 0; i < frameCount; ++i) {
+		// Throttle the simulated CPU like the engine does, by waiting for the oldest frame
+		while(clock.inFlight.size() >= framesInFlight) clock.completeOne();
+		retire(clock.completed);
+
+		auto frame = clock.submit();
+		queue.advance(frame);
+
+		// Replace a variable number of resources in this frame
+		for(unsigned j = 0; j < (i % 3); ++j) {
+			auto res = Resource { nextId ++, frame, 0 };
+			queue.enqueue([&destroy, res]() { destroy(res); });
+		}
+
+		// Some resources are only known to be last used by a previous frame
+		if(i % 5 == 4) {
+			auto res = Resource { nextId ++, frame - 2, 0 };
+			queue.enqueue(res.lastUse, [&destroy, res]() { destroy(res); });
+		}
+
+		// A destruction callback may enqueue another one
+		if(i % 7 == 6) {
+			auto res = Resource { nextId ++, frame, 0 };
+			queue.enqueue([&, res]() {
+				destroy(res);
+				auto dep = Resource { nextId ++, queue.currentValue(), 0 };
+				queue.enqueue([&destroy, dep]() { destroy(dep); });
+			});
+		}
+	}
+
+	while(! clock.inFlight.empty()) clock.completeOne();
+	retire(clock.completed);
+	queue.retireAll();
+
+	if(! queue.empty()) {
+		fmt::print(stderr, "{} entries left in the queue\n", queue.size());
+		fail = true;
+	}
+
+	if(destroyed.size() != nextId) {
+		fmt::print(stderr, "Destroyed {} resources out of {}\n", destroyed.size(), nextId);
+		fail = true;
+	}
+
+	for(size_t i = 1; i < destroyed.size(); ++i) {
+		// Resources enqueued late with an already completed value are retired later, so only the order within a single retirement matters
+		bool sameRetirement = destroyed[i].retirement == destroyed[i-1].retirement;
+		if(sameRetirement && (destroyed[i].lastUse < destroyed[i-1].lastUse)) {
+			fmt::print(stderr,
+				"Resource {} (frame {}) destroyed after resource {} (frame {})\n",
+				destroyed[i].id, destroyed[i].lastUse, destroyed[i-1].id, destroyed[i-1].lastUse );
+			fail = true;
+		}
+	}
+
+	fmt::print("{} frames in flight, {} frames: {} resources, {}\n", framesInFlight, frameCount, destroyed.size(), fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testSameValueFifo() {
+	auto queue = SKENGINE_NAME_NS::CleanupQueue();
+	auto order = std::vector<unsigned>();
+	bool fail = false;
+
+	queue.enqueue(3, [&]() { order.push_back(0); });
+	queue.enqueue(3, [&]() { order.push_back(1); });
+	queue.enqueue(1, [&]() { order.push_back(2); });
+	queue.enqueue(3, [&]() { order.push_back(3); });
+
+	if(queue.retire(0) != 0) { fmt::print(stderr, "Retired an entry before its value\n"); fail = true; }
+	if(queue.retire(2) != 1) { fmt::print(stderr, "Failed to retire a single entry\n"); fail = true; }
+	if(queue.retire(3) != 3) { fmt::print(stderr, "Failed to retire the remaining entries\n"); fail = true; }
+
+	constexpr unsigned expect[] = { 2, 0, 1, 3 };
+	if(! std::equal(order.begin(), order.end(), expect, expect + std::size(expect))) {
+		fmt::print(stderr, "Entries with the same value were not retired in FIFO order\n");
+		fail = true;
+	}
+
+	fmt::print("Same value FIFO: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testSameValueFifo()              ? fail : true;
+		fail = testRetirementOrder(1, 64)       ? fail : true;
+		fail = testRetirementOrder(2, 256)      ? fail : true;
+		fail = testRetirementOrder(3, 1024)     ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+// A 5000-element UI, whose elements insert one draw job each every frame:
+// compares the nested maps that used to hold the draw jobs of a frame with
+// the flat, radix-sorted queue that replaced them. Both are visited the way
+// the UI renderer records its commands, counting the state changes instead.
+
+#include <engine/draw-geometry/draw_queue.hpp>
+
+#include <fmt/core.h>
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::DrawSortKey;
+using SKENGINE_NAME_NS::FlatIndexMap;
+using SKENGINE_NAME_NS::SortedDrawQueue;
+
+constexpr size_t elementCount   = 5000;
+constexpr size_t elementsPerLot = 5;
+constexpr size_t frameCount     = 1000;
+constexpr size_t pipelineCount  = 4; // Lines, fills, text and SDF text
+constexpr size_t dsetCount      = 6; // One per text cache
+
+
+
+// Stand-ins for the Vulkan handles and structures of gui::DrawJob
+using Pipeline = const void*;
+using Dset     = const void*;
+
+struct Viewport { float x, y, width, height, minDepth, maxDepth; };
+struct Rect     { int32_t x, y; uint32_t width, height; };
+
+struct ViewportScissor {
+	struct HashCmp;
+	Viewport viewport;
+	Rect     scissor;
+
+	bool operator==(const ViewportScissor& r) const noexcept { return 0 == memcmp(this, &r, sizeof(ViewportScissor)); }
+};
+
+struct ViewportScissor::HashCmp {
+	size_t operator()(const ViewportScissor& vs) const noexcept {
+		constexpr auto ftoi = [](float f) -> size_t { return f * float(1<<10); };
+		constexpr size_t sh = SIZE_WIDTH / 10;
+		return size_t(0)
+			^ std::rotl(ftoi(vs.viewport.x       ),    0*sh)
+			^ std::rotl(ftoi(vs.viewport.y       ),    1*sh)
+			^ std::rotl(ftoi(vs.viewport.width   ),    2*sh)
+			^ std::rotl(ftoi(vs.viewport.height  ),    3*sh)
+			^ std::rotl(ftoi(vs.viewport.minDepth),    4*sh)
+			^ std::rotl(ftoi(vs.viewport.maxDepth),    5*sh)
+			^ std::rotl(size_t(vs.scissor.width),  6*sh)
+			^ std::rotl(size_t(vs.scissor.height), 7*sh)
+			^ std::rotl(size_t(vs.scissor.x),      8*sh)
+			^ std::rotl(size_t(vs.scissor.y),      9*sh);
+	}
+
+	bool operator()(const ViewportScissor& l, const ViewportScissor& r) const noexcept { return operator()(l) < operator()(r); }
+};
+
+struct DrawJob {
+	Pipeline        pipeline;
+	ViewportScissor viewportScissor;
+	Dset            imageDset;
+	const void*     shapeSet;
+	float           transform[6];
+};
+
+
+std::vector<DrawJob> makeJobs() {
+	static int pipelines[pipelineCount];
+	static int dsets[dsetCount];
+	static int shapeSet;
+	auto rng = std::minstd_rand(1);
+	std::vector<DrawJob> r;
+	r.reserve(elementCount);
+	ViewportScissor vs = { };
+	for(size_t i = 0; i < elementCount; ++i) {
+		if(i % elementsPerLot == 0) {
+			// Every lot has its own bounds
+			float x = float(rng() % 1800);
+			float y = float(rng() % 1000);
+			vs.viewport = { x, y, 120.0f, 40.0f, 0.0f, 1.0f };
+			vs.scissor  = { int32_t(x), int32_t(y), 120, 40 };
+		}
+		bool text = rng() % 2 == 0;
+		r.push_back(DrawJob {
+			.pipeline = &pipelines[text? 2 + (rng() % 2) : rng() % 2],
+			.viewportScissor = vs,
+			.imageDset = text? &dsets[rng() % dsetCount] : nullptr,
+			.shapeSet = &shapeSet,
+			.transform = { } });
+	}
+	return r;
+}
+
+
+struct Commands {
+	size_t pipelineBinds;
+	size_t viewportSets;
+	size_t dsetBinds;
+	size_t draws;
+};
+
+
+class NestedMaps {
+public:
+	using DsetSet = std::map<Dset, std::deque<DrawJob>>;
+	using VsSet   = std::map<ViewportScissor, DsetSet, ViewportScissor::HashCmp>;
+	using JobSet  = std::map<Pipeline, VsSet>;
+
+	void frame(const std::vector<DrawJob>& jobs, Commands& cmds) {
+		JobSet set; // Built anew for every frame, like the DrawContext that held it
+		for(auto& job : jobs) set[job.pipeline][job.viewportScissor][job.imageDset].push_back(job);
+		Pipeline lastPl = nullptr;
+		const ViewportScissor* lastVs = nullptr;
+		Dset lastDset = nullptr;
+		for(auto& jobPl : set) {
+			if(lastPl != jobPl.first) { lastPl = jobPl.first; ++ cmds.pipelineBinds; }
+			for(auto& jobVs : jobPl.second) {
+				if(lastVs != &jobVs.first) { lastVs = &jobVs.first; ++ cmds.viewportSets; }
+				for(auto& jobDs : jobVs.second) {
+					if(lastDset != jobDs.first) { lastDset = jobDs.first; ++ cmds.dsetBinds; }
+					cmds.draws += jobDs.second.size();
+				}
+			}
+		}
+	}
+};
+
+
+class FlatQueue {
+public:
+	void frame(const std::vector<DrawJob>& jobs, Commands& cmds) {
+		fq_pipelines.clear();
+		fq_viewportScissors.clear();
+		fq_dsets.clear();
+		fq_queue.clear();
+		for(auto& job : jobs) {
+			auto key = DrawSortKey::pack(
+				fq_pipelines.indexOf(job.pipeline),
+				fq_viewportScissors.indexOf(job.viewportScissor),
+				fq_dsets.indexOf(job.imageDset),
+				0 );
+			fq_queue.push(key, job);
+		}
+		fq_queue.sort();
+		Pipeline lastPl = nullptr;
+		const ViewportScissor* lastVs = nullptr;
+		Dset lastDset = nullptr;
+		for(size_t i = 0; i < fq_queue.size(); ++i) {
+			auto& job = fq_queue[i];
+			if(lastPl != job.pipeline) { lastPl = job.pipeline; ++ cmds.pipelineBinds; }
+			if(lastVs == nullptr || ! (*lastVs == job.viewportScissor)) { lastVs = &job.viewportScissor; ++ cmds.viewportSets; }
+			if(lastDset != job.imageDset) { lastDset = job.imageDset; ++ cmds.dsetBinds; }
+			++ cmds.draws;
+		}
+	}
+
+private:
+	FlatIndexMap<Pipeline>                                fq_pipelines;
+	FlatIndexMap<ViewportScissor, ViewportScissor::HashCmp> fq_viewportScissors;
+	FlatIndexMap<Dset>                                    fq_dsets;
+	SortedDrawQueue<DrawJob>                              fq_queue;
+};
+
+
+template <typename Impl>
+double run(const std::vector<DrawJob>& jobs, Commands& cmds) {
+	using clock = std::chrono::steady_clock;
+	Impl impl;
+	cmds = { };
+	impl.frame(jobs, cmds); // Warm up
+	cmds = { };
+	auto beg = clock::now();
+	for(size_t i = 0; i < frameCount; ++i) impl.frame(jobs, cmds);
+	auto end = clock::now();
+	return std::chrono::duration<double, std::micro>(end - beg).count() / double(frameCount);
+}
+
+
+int main() {
+	auto jobs = makeJobs();
+
+	fmt::print("{} elements, {} per lot, {} frames\n", elementCount, elementsPerLot, frameCount);
+	fmt::print("{:>12} | {:>10} | {:>14} | {:>14} | {:>14}\n", "draw jobs", "us/frame", "pipeline binds", "viewport sets", "dset binds");
+	auto print = [](const char* name, double us, const Commands& c) {
+		fmt::print("{:>12} | {:>10.2f} | {:>14} | {:>14} | {:>14}\n", name, us,
+			c.pipelineBinds / frameCount, c.viewportSets / frameCount, c.dsetBinds / frameCount);
+	};
+	Commands cmds;
+	double us;
+	us = run<NestedMaps>(jobs, cmds); print("nested maps", us, cmds);
+	us = run<FlatQueue> (jobs, cmds); print("flat queue",  us, cmds);
+}
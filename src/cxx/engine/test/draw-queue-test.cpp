@@ -0,0 +1,121 @@
+#include <engine/draw-geometry/draw_queue.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::DrawSortKey;
+using SKENGINE_NAME_NS::FlatIndexMap;
+using SKENGINE_NAME_NS::KeyedIndex;
+using SKENGINE_NAME_NS::SortedDrawQueue;
+using SKENGINE_NAME_NS::radixSort;
+
+
+
+bool testRadixSort() {
+	constexpr size_t sizes[] = { 0, 1, 2, 63, 64, 65, 1000, 100000 };
+	constexpr uint64_t masks[] = { ~ uint64_t(0), 0xff00000000000000, 0x00000fff00000000, 0x0101010101010101, 0 };
+	auto rng = std::mt19937_64(1);
+	std::vector<KeyedIndex> scratch;
+	bool fail = false;
+
+	for(size_t size : sizes)
+	for(uint64_t mask : masks) {
+		std::vector<KeyedIndex> entries;
+		entries.reserve(size);
+		for(size_t i = 0; i < size; ++i) entries.push_back({ rng() & mask, uint32_t(i) });
+		auto expected = entries;
+		std::stable_sort(expected.begin(), expected.end(), [](const KeyedIndex& l, const KeyedIndex& r) { return l.key < r.key; });
+		radixSort(entries, scratch);
+		bool same = std::equal(entries.begin(), entries.end(), expected.begin(), expected.end(), [](const KeyedIndex& l, const KeyedIndex& r) {
+			return l.key == r.key && l.index == r.index; });
+		if(! same) {
+			fmt::print(stderr, "Radix sort of {} keys masked by {:016x} differs from a stable sort\n", size, mask);
+			fail = true;
+		}
+	}
+
+	fmt::print("Radix sort: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testIndexMap() {
+	FlatIndexMap<const void*> map;
+	std::vector<int> objects(1000);
+	bool fail = false;
+
+	for(unsigned round = 0; round < 2; ++round) {
+		// Insert in a different order every round, with repetitions
+		for(size_t i = 0; i < objects.size(); ++i) {
+			size_t obj = round == 0? i : objects.size() - 1 - i;
+			if(map.indexOf(&objects[obj]) != i) fail = true;
+			if(map.indexOf(&objects[obj]) != i) fail = true;
+		}
+		if(map.size() != objects.size()) fail = true;
+		for(size_t i = 0; i < objects.size(); ++i) {
+			size_t obj = round == 0? i : objects.size() - 1 - i;
+			if(map[uint32_t(i)] != &objects[obj]) fail = true;
+		}
+		map.clear();
+		if(map.size() != 0) fail = true;
+	}
+
+	fmt::print("Index map: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testQueue() {
+	struct Job { unsigned pipeline; unsigned dset; unsigned order; };
+	SortedDrawQueue<Job> queue;
+	bool fail = false;
+
+	for(unsigned frame = 0; frame < 3; ++frame) {
+		queue.clear();
+		for(unsigned i = 0; i < 500; ++i) {
+			Job job = { (i * 7) % 3, (i * 5) % 4, i };
+			queue.push(DrawSortKey::pack(job.pipeline, 0, job.dset, 0), job);
+		}
+		queue.sort();
+		if(queue.size() != 500) fail = true;
+		for(size_t i = 1; i < queue.size(); ++i) {
+			auto& l = queue[i-1];
+			auto& r = queue[i];
+			bool grouped = (l.pipeline < r.pipeline) || (l.pipeline == r.pipeline && l.dset <= r.dset);
+			bool ordered = (l.pipeline != r.pipeline) || (l.dset != r.dset) || (l.order < r.order);
+			if(! grouped || ! ordered) { fail = true; break; }
+		}
+	}
+
+	// Saturated fields order the jobs together, but never past the next field
+	uint64_t big   = DrawSortKey::pack(0, 1u << 30, 0, 0);
+	uint64_t small = DrawSortKey::pack(1, 0,        0, 0);
+	if(big >= small) { fmt::print(stderr, "A saturated field overflows into the next one\n"); fail = true; }
+	if(DrawSortKey::pack(0, 1u << 30, 0, 0) != DrawSortKey::pack(0, 1u << 20, 0, 0)) fail = true;
+
+	fmt::print("Queue: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testRadixSort() ? fail : true;
+		fail = testIndexMap()  ? fail : true;
+		fail = testQueue()     ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include <engine-util/geometry_arena_allocator.hpp>
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::GeometryArenaAllocator;
+
+
+
+// Fills the allocator's whole capacity as one free block, like a freshly reallocated pool
+GeometryArenaAllocator makeAllocator(uint32_t capacity) {
+	GeometryArenaAllocator r;
+	r.compact({ }, capacity, 0);
+	return r;
+}
+
+
+bool freeBlocksAreValid(const GeometryArenaAllocator& alloc) {
+	uint32_t freeCount = 0;
+	uint32_t prevEnd   = 0;
+	bool     first     = true;
+	for(auto& block : alloc.getFreeBlocks()) {
+		if(block.second == 0) return false;
+		if(! first && block.first <= prevEnd) return false; // Overlapping or adjacent (unmerged) blocks
+		if(block.first + block.second > alloc.getCapacity()) return false;
+		prevEnd   = block.first + block.second;
+		freeCount += block.second;
+		first = false;
+	}
+	return freeCount + alloc.getUsed() == alloc.getCapacity();
+}
+
+
+bool testBestFit() {
+	bool fail = false;
+	auto alloc = makeAllocator(100);
+	uint32_t a = 0, b = 0, c = 0, d = 0, e = 0;
+	if(! alloc.tryAlloc(10, &a) || a != 0)  fail = true;
+	if(! alloc.tryAlloc(20, &b) || b != 10) fail = true;
+	if(! alloc.tryAlloc(5,  &c) || c != 30) fail = true;
+	if(! alloc.tryAlloc(30, &d) || d != 35) fail = true;
+	alloc.dealloc(b, 20); // Hole of 20 at 10
+	alloc.dealloc(a, 10); // Merged with the next block: 30 at 0
+
+	// The smallest block that fits is picked, and taken from its front
+	uint32_t f = 0;
+	if(! alloc.tryAlloc(25, &e) || e != 0)  fail = true; // 30 at 0 fits better than the 35 at the end
+	if(alloc.tryAlloc(36, &f)) fail = true;
+	if(! alloc.tryAlloc(35, &f) || f != 65) fail = true;
+	if(alloc.getUsed() != 95 || ! freeBlocksAreValid(alloc)) fail = true;
+
+	// Freeing merges the range with the blocks on both sides
+	alloc.dealloc(c, 5);
+	alloc.dealloc(e, 25);
+	alloc.dealloc(d, 30);
+	if(alloc.getFreeBlocks().size() != 1 || alloc.getFreeBlocks().begin()->second != 65 || ! freeBlocksAreValid(alloc)) fail = true;
+
+	fmt::print("Geometry arena best fit: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testFragmentation() {
+	bool fail = false;
+	auto alloc = makeAllocator(64);
+	uint32_t offsets[16];
+	for(auto& o : offsets) if(! alloc.tryAlloc(4, &o)) fail = true;
+	if(alloc.getFragmentation() != 0.0f || alloc.shouldDefragment()) fail = true;
+
+	// Every other range is freed: half of the pool is free, in 8 equal holes
+	for(unsigned i = 0; i < 16; i += 2) alloc.dealloc(offsets[i], 4);
+	if(std::abs(alloc.getFragmentation() - (7.0f / 8.0f)) > 0.001f) fail = true;
+	if(! alloc.shouldDefragment()) fail = true;
+
+	// A request larger than any hole fails, even though the free space would be enough
+	uint32_t dst = 0;
+	if(alloc.tryAlloc(8, &dst)) fail = true;
+	if(! freeBlocksAreValid(alloc)) fail = true;
+
+	fmt::print("Geometry arena fragmentation: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testCompaction() {
+	struct Range { uint32_t first; uint32_t count; uint32_t tag; };
+	bool fail = false;
+	auto rng   = std::minstd_rand(1);
+	auto alloc = makeAllocator(256);
+	std::vector<uint32_t> pool(alloc.getCapacity(), 0); // Stands in for the device buffer
+	std::vector<Range> ranges;
+	uint32_t nextTag = 1;
+	unsigned reallocations = 0;
+
+	for(unsigned round = 0; round < 200; ++round) {
+		if(ranges.empty() || rng() % 3 != 0) {
+			auto count = uint32_t(1 + (rng() % 24));
+			uint32_t first = 0;
+			if(alloc.shouldDefragment() || ! alloc.tryAlloc(count, &first)) {
+				// Reallocate, like `GeometryArena::reallocatePool`, then retry
+				std::vector<GeometryArenaAllocator::LiveRange> live;
+				for(auto& r : ranges) live.push_back({ &r.first, r.count });
+				auto moves = alloc.compact(live, 256, count);
+				++ reallocations;
+				std::vector<uint32_t> newPool(alloc.getCapacity(), 0);
+				uint32_t prevEnd = 0;
+				for(auto& mv : moves) {
+					if(mv.dst < prevEnd) fail = true; // Copies are in ascending order and never overlap
+					std::copy_n(pool.begin() + mv.src, mv.count, newPool.begin() + mv.dst);
+					prevEnd = mv.dst + mv.count;
+				}
+				if(moves.size() > ranges.size()) fail = true;
+				pool = std::move(newPool);
+				if(! alloc.tryAlloc(count, &first)) { fail = true; break; }
+			}
+			std::fill_n(pool.begin() + first, count, nextTag);
+			ranges.push_back({ first, count, nextTag ++ });
+		} else {
+			auto victim = ranges.begin() + (rng() % ranges.size());
+			alloc.dealloc(victim->first, victim->count);
+			ranges.erase(victim);
+		}
+
+		// Every range still holds its own data, at its (possibly updated) offset
+		uint32_t used = 0;
+		for(auto& r : ranges) {
+			used += r.count;
+			if(! std::all_of(pool.begin() + r.first, pool.begin() + r.first + r.count, [&](uint32_t v) { return v == r.tag; })) {
+				fmt::print(stderr, "Round {}: range {} lost its data\n", round, r.tag);
+				fail = true;
+			}
+		}
+		if(used != alloc.getUsed() || ! freeBlocksAreValid(alloc)) fail = true;
+		if(fail) break;
+	}
+	if(reallocations == 0) fail = true;
+
+	fmt::print("Geometry arena compaction: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testBestFit()       ? fail : true;
+		fail = testFragmentation() ? fail : true;
+		fail = testCompaction()    ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+#include <input/input.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::InputEventBatch;
+using SKENGINE_NAME_NS::InputManager;
+using SKENGINE_NAME_NS::InputMapKey;
+using SKENGINE_NAME_NS::InputState;
+using SKENGINE_NAME_NS::Binding;
+using SKENGINE_NAME_NS::Context;
+using SKENGINE_NAME_NS::CommandId;
+using SKENGINE_NAME_NS::CommandCallback;
+using SKENGINE_NAME_NS::CommandCallbackWrapper;
+using SKENGINE_NAME_NS::inputIdFromSdlKey;
+using SKENGINE_NAME_NS::Input;
+
+
+
+SDL_Event motion(uint32_t which, int32_t x, int32_t y, int32_t xrel, int32_t yrel) {
+	SDL_Event r = { };
+	r.type = SDL_MOUSEMOTION;
+	r.motion.which = which;
+	r.motion.x = x; r.motion.y = y; r.motion.xrel = xrel; r.motion.yrel = yrel;
+	return r;
+}
+
+SDL_Event wheel(int32_t y) {
+	SDL_Event r = { };
+	r.type = SDL_MOUSEWHEEL;
+	r.wheel.y = y;
+	return r;
+}
+
+SDL_Event axis(SDL_JoystickID which, uint8_t axis, int16_t value) {
+	SDL_Event r = { };
+	r.type = SDL_CONTROLLERAXISMOTION;
+	r.caxis.which = which; r.caxis.axis = axis; r.caxis.value = value;
+	return r;
+}
+
+SDL_Event key(SDL_KeyCode sym, bool down) {
+	SDL_Event r = { };
+	r.type = down? SDL_KEYDOWN : SDL_KEYUP;
+	r.key.state = down? SDL_PRESSED : SDL_RELEASED;
+	r.key.keysym.sym = sym;
+	return r;
+}
+
+
+template <typename Fn>
+CommandCallback::Ptr callback(Fn fn) {
+	return std::make_shared<CommandCallbackWrapper<Fn>>(std::move(fn));
+}
+
+
+Binding keyBinding(SDL_KeyCode sym, const char* context) {
+	return Binding { InputMapKey { inputIdFromSdlKey(sym), InputState::eActivated }, Context(context) };
+}
+
+
+bool testCoalescing() {
+	bool fail = false;
+	InputEventBatch batch;
+
+	batch.push(motion(0, 10, 10, 1, 1));
+	batch.push(axis(3, 0, 100));
+	batch.push(motion(0, 12, 13, 2, 3)); // Merged ahead of the axis event, which belongs to another stream
+	batch.push(axis(3, 1, -5));
+	batch.push(axis(3, 0, 200));
+	batch.push(axis(4, 0, 7));
+	batch.push(wheel(1));
+	batch.push(wheel(2));
+	batch.push(key(SDLK_a, true)); // Ends every stream
+	batch.push(motion(0, 15, 13, 3, 0));
+	batch.push(motion(1, 0, 0, 1, 1));
+
+	auto events = batch.events();
+	if(events.size() != 8 || batch.coalescedCount() != 3) {
+		fmt::print(stderr, "Expected 8 events with 3 coalesced, got {} with {}\n", events.size(), batch.coalescedCount());
+		fail = true;
+	} else {
+		auto& m = events[0].motion;
+		if(m.type != SDL_MOUSEMOTION || m.x != 12 || m.y != 13 || m.xrel != 3 || m.yrel != 4) fail = true;
+		if(events[1].caxis.axis != 0 || events[1].caxis.value != 200) fail = true;
+		if(events[2].caxis.axis != 1 || events[2].caxis.value != -5)  fail = true;
+		if(events[3].caxis.which != 4 || events[3].caxis.value != 7)  fail = true;
+		if(events[4].type != SDL_MOUSEWHEEL || events[4].wheel.y != 3) fail = true;
+		if(events[5].type != SDL_KEYDOWN) fail = true;
+		if(events[6].motion.x != 15 || events[6].motion.xrel != 3) fail = true;
+		if(events[7].motion.which != 1) fail = true;
+	}
+
+	batch.clear();
+	if(! batch.events().empty() || batch.coalescedCount() != 0) fail = true;
+
+	fmt::print("Input event coalescing: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testContexts() {
+	bool fail = false;
+	InputManager im;
+	std::vector<int> calls;
+	auto cmdGeneral = im.bindNewCommand(keyBinding(SDLK_a, "general"),      callback([&](const Context&, Input) { calls.push_back(1); }));
+	auto cmdMenu    = im.bindNewCommand(keyBinding(SDLK_a, "general.menu"), callback([&](const Context&, Input) { calls.push_back(2); }));
+	auto cmdB       = im.bindNewCommand(keyBinding(SDLK_b, "general"),      callback([&](const Context&, Input) { calls.push_back(3); }));
+
+	// Subcontexts resolve to the most specific binding
+	im.feedSdlEvent("general.menu.sub", key(SDLK_a, true));
+	im.feedSdlEvent("general.menu.sub", key(SDLK_b, true));
+	im.feedSdlEvent("general", key(SDLK_a, true));
+	im.feedSdlEvent("other", key(SDLK_a, true));
+	if(calls != std::vector<int> { 2, 3, 1 }) fail = true;
+	if(! im.isCommandActive(cmdMenu) || ! im.isCommandActive(cmdGeneral) || ! im.isCommandActive(cmdB)) fail = true;
+	im.feedSdlEvent("general", key(SDLK_a, false));
+	if(im.isCommandActive(cmdGeneral) || ! im.isCommandActive(cmdMenu)) fail = true;
+
+	// Bindings added after the table was built are seen
+	calls.clear();
+	im.bindNewCommand(keyBinding(SDLK_c, "general"), callback([&](const Context&, Input) { calls.push_back(4); }));
+	im.feedSdlEvent("general", key(SDLK_c, true));
+	if(calls != std::vector<int> { 4 }) fail = true;
+
+	fmt::print("Input flat binding contexts: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testBatchedFeed() {
+	constexpr SDL_KeyCode keys[] = { SDLK_a, SDLK_b, SDLK_c, SDLK_d, SDLK_q, SDLK_w };
+	constexpr const char* contexts[] = { "general", "general.menu", "general.menu.sub" };
+	bool fail = false;
+
+	InputManager ims[2];
+	std::vector<std::pair<int, unsigned>> calls[2];
+	std::vector<CommandId> cmds[2];
+	for(int m = 0; m < 2; ++m)
+	for(unsigned k = 0; k < std::size(keys); ++k) {
+		auto& c = calls[m];
+		cmds[m].push_back(ims[m].bindNewCommand(keyBinding(keys[k], contexts[k % 2]), callback([&c, k](const Context& ctx, Input) { c.push_back({ int(ctx.string().size()), k }); })));
+	}
+
+	auto rng = std::minstd_rand(1);
+	InputEventBatch batch;
+	for(unsigned frame = 0; frame < 100; ++frame) {
+		const char* ctx = contexts[(frame / 10) % std::size(contexts)];
+		batch.clear();
+		for(unsigned i = rng() % 20; i > 0; --i) {
+			SDL_Event ev;
+			switch(rng() % 3) {
+				case 0: ev = motion(0, int32_t(rng() % 100), int32_t(rng() % 100), 1, 1); break;
+				case 1: ev = axis(0, uint8_t(rng() % 2), int16_t(rng() % 100)); break;
+				default: ev = key(keys[rng() % std::size(keys)], rng() % 2); break;
+			}
+			ims[0].feedSdlEvent(ctx, ev);
+			batch.push(ev);
+		}
+		ims[1].feedSdlEvents(ctx, batch.events());
+		if(calls[0] != calls[1]) fail = true;
+		for(size_t i = 0; i < cmds[0].size(); ++i) {
+			if(ims[0].isCommandActive(cmds[0][i]) != ims[1].isCommandActive(cmds[1][i])) fail = true;
+		}
+	}
+	if(calls[0].empty()) fail = true;
+
+	fmt::print("Input batched feed: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testCoalescing()  ? fail : true;
+		fail = testContexts()    ? fail : true;
+		fail = testBatchedFeed() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
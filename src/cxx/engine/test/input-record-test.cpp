@@ -0,0 +1,162 @@
+#include <input/input_record.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::InputRecorder;
+using SKENGINE_NAME_NS::InputReplay;
+using SKENGINE_NAME_NS::BadInputRecording;
+
+constexpr const char* recordingPath = "input-record-test.txt";
+
+
+
+SDL_Event key(SDL_KeyCode sym, bool down, bool repeat = false) {
+	SDL_Event r = { };
+	r.type = down? SDL_KEYDOWN : SDL_KEYUP;
+	r.key.state = down? SDL_PRESSED : SDL_RELEASED;
+	r.key.repeat = repeat;
+	r.key.keysym.sym = sym;
+	return r;
+}
+
+SDL_Event button(uint8_t btn, bool down) {
+	SDL_Event r = { };
+	r.type = down? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+	r.button.state = down? SDL_PRESSED : SDL_RELEASED;
+	r.button.button = btn;
+	return r;
+}
+
+SDL_Event focusLost() {
+	SDL_Event r = { };
+	r.type = SDL_WINDOWEVENT;
+	r.window.event = SDL_WINDOWEVENT_FOCUS_LOST;
+	return r;
+}
+
+SDL_Event motion() {
+	SDL_Event r = { };
+	r.type = SDL_MOUSEMOTION;
+	r.motion.xrel = 1;
+	return r;
+}
+
+
+void writeFile(const char* content) {
+	auto out = std::ofstream(recordingPath, std::ios::out | std::ios::trunc);
+	out << content;
+}
+
+
+bool loadFails(BadInputRecording::Reason expect) {
+	try {
+		(void) InputReplay::fromFile(recordingPath);
+	} catch(BadInputRecording& e) {
+		return e.reason == expect;
+	}
+	return false;
+}
+
+
+bool testRoundTrip() {
+	bool fail = false;
+	InputRecorder rec;
+
+	rec.record(0, "general",      key(SDLK_a, true));
+	rec.record(0, "general",      motion()); // Not used by InputManager, so not recorded
+	rec.record(3, "general.menu", key(SDLK_a, true, true));
+	rec.record(3, "general",      button(SDL_BUTTON_LEFT, true));
+	rec.record(7, "general",      focusLost());
+	rec.record(9, "general",      button(SDL_BUTTON_LEFT, false));
+	rec.record(9, "general",      key(SDLK_a, false));
+	for(unsigned tick = 1; tick <= 40; ++tick) rec.recordTicks(tick); // The session goes on, idle, after the last event
+
+	if(rec.events().size() != 6 || rec.tickCount() != 40) fail = true;
+	if(! rec.save(recordingPath)) {
+		fmt::print(stderr, "Failed to write \"{}\"\n", recordingPath);
+		fail = true;
+	} else {
+		auto replay = InputReplay::fromFile(recordingPath);
+		if(replay.tickCount() != 40 || replay.lastTick() != 9) fail = true;
+		if(replay.events().size() != rec.events().size()) {
+			fail = true;
+		} else for(size_t i = 0; i < rec.events().size(); ++i) {
+			auto& l = rec.events()[i];
+			auto& r = replay.events()[i];
+			if(l.tick != r.tick || l.sdlType != r.sdlType || l.code != r.code || l.repeat != r.repeat || l.context != r.context) {
+				fmt::print(stderr, "Event {} differs after loading\n", i);
+				fail = true;
+			}
+		}
+		if(! replay.events().empty()) {
+			auto ev = replay.events()[1].toSdlEvent();
+			if(ev.type != SDL_KEYDOWN || ev.key.keysym.sym != SDLK_a || ! ev.key.repeat) fail = true;
+		}
+	}
+
+	// A session without events still has its length
+	InputRecorder idle;
+	idle.recordTicks(12);
+	if(! idle.save(recordingPath) || InputReplay::fromFile(recordingPath).tickCount() != 12) fail = true;
+
+	fmt::print("Input recording round trip: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testBadRecordings() {
+	using enum BadInputRecording::Reason;
+	bool fail = false;
+
+	// Version 1 recordings end with their last event
+	writeFile("skengine-input 1\n2 768 97 0 general\n5 769 97 0 general\n");
+	try {
+		auto replay = InputReplay::fromFile(recordingPath);
+		if(replay.tickCount() != 6 || replay.events().size() != 2) fail = true;
+	} catch(BadInputRecording&) {
+		fail = true;
+	}
+
+	struct Case { const char* content; BadInputRecording::Reason reason; };
+	constexpr Case cases[] = {
+		{ "skengine-input 3\nticks 1\n",                                         eBadHeader },
+		{ "skengine-input 2\n",                                                  eBadTickCount },
+		{ "skengine-input 2\nticks x\n",                                         eBadTickCount },
+		{ "skengine-input 2\nticks 5\n5 768 97 0 general\n",                     eBadTickCount }, // Ends before its last event
+		{ "skengine-input 2\nticks 9\n5 768 97 0 general\n2 769 97 0 general\n", eTickOrder },
+		{ "skengine-input 2\nticks 9\n5 768 97 2 general\n",                     eBadLine } };
+	for(auto& c : cases) {
+		writeFile(c.content);
+		if(! loadFails(c.reason)) {
+			fmt::print(stderr, "Recording {:?} was not rejected with reason {}\n", c.content, unsigned(c.reason));
+			fail = true;
+		}
+	}
+
+	fmt::print("Input recording validation: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testRoundTrip()     ? fail : true;
+		fail = testBadRecordings() ? fail : true;
+	} catch(...) {
+		std::remove(recordingPath);
+		return EXIT_FAILURE;
+	}
+
+	std::remove(recordingPath);
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+// 10000 rectangles of 3 unit shapes (fill, outline and a small icon), some
+// of which move every frame: compares expanding every rectangle into its own
+// transformed vertices and draw command, rebuilding the instanced shape set
+// as DrawableShapeSet::update used to (grouping the instances by shape anew
+// and rewriting every buffer), and keeping the instance layout to rewrite
+// only the records of the moving rectangles. Mapped buffers are stood in
+// for by host memory, and the bytes written to them are counted.
+
+#include <engine/draw-geometry/instance_layout.hpp>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::InstanceLayout;
+
+constexpr size_t rectCount  = 10000;
+constexpr size_t shapeCount = 3;
+constexpr size_t frameCount = 200;
+
+
+
+// Stand-ins for geom::Vertex, geom::Instance and VkDrawIndirectCommand
+struct Vertex { alignas(16) float position[3]; };
+
+struct Instance {
+	alignas(16) float color[4];
+	alignas(16) float transform[16];
+};
+
+struct DrawCmd { uint32_t vertexCount, instanceCount, firstVertex, firstInstance; };
+
+using Shape = std::vector<Vertex>;
+
+
+struct Scene {
+	std::vector<Shape> shapes;
+	std::vector<const Shape*> rectShapes;
+	std::vector<Instance> rects;
+};
+
+
+Scene makeScene() {
+	Scene r;
+	r.shapes.push_back({ {{0,0,0}}, {{1,0,0}}, {{1,1,0}}, {{1,1,0}}, {{0,1,0}}, {{0,0,0}} });
+	r.shapes.push_back({ {{0,0,0}}, {{1,0,0}}, {{1,1,0}}, {{0,1,0}}, {{0,0,0}} });
+	r.shapes.push_back({ });
+	for(unsigned i = 0; i < 12; ++i) {
+		// A small fan, standing in for an icon
+		float a0 = float(i)     * 3.14159f / 6.0f;
+		float a1 = float(i + 1) * 3.14159f / 6.0f;
+		r.shapes.back().insert(r.shapes.back().end(), { {{0,0,0}}, {{std::cos(a0), std::sin(a0), 0}}, {{std::cos(a1), std::sin(a1), 0}} });
+	}
+	auto rng = std::minstd_rand(1);
+	for(size_t i = 0; i < rectCount; ++i) {
+		r.rectShapes.push_back(&r.shapes[rng() % shapeCount]);
+		Instance inst = { { 1, 1, 1, 1 }, { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 } };
+		inst.transform[12] = float(rng() % 1000) / 1000.0f;
+		inst.transform[13] = float(rng() % 1000) / 1000.0f;
+		r.rects.push_back(inst);
+	}
+	return r;
+}
+
+
+void animate(Scene& scene, size_t frame, size_t movingCount) {
+	for(size_t i = 0; i < movingCount; ++i) {
+		auto& t = scene.rects[(i * (rectCount / movingCount) + frame) % rectCount].transform;
+		t[12] += 0.001f;
+		t[13] -= 0.001f;
+	}
+}
+
+
+struct Stats {
+	size_t bytesWritten;
+	size_t drawCmds;
+};
+
+
+// Every rectangle owns its vertices, transformed on the CPU, and its draw command
+class Expanded {
+public:
+	void frame(const Scene& scene, Stats& stats) {
+		ex_vertices.clear();
+		ex_drawCmds.clear();
+		for(size_t i = 0; i < scene.rects.size(); ++i) {
+			auto& t = scene.rects[i].transform;
+			auto& shape = *scene.rectShapes[i];
+			ex_drawCmds.push_back({ uint32_t(shape.size()), 1, uint32_t(ex_vertices.size()), uint32_t(i) });
+			for(auto& v : shape) {
+				const float* p = v.position;
+				ex_vertices.push_back({ {
+					t[0]*p[0] + t[4]*p[1] + t[8] *p[2] + t[12],
+					t[1]*p[0] + t[5]*p[1] + t[9] *p[2] + t[13],
+					t[2]*p[0] + t[6]*p[1] + t[10]*p[2] + t[14] } });
+			}
+		}
+		write(ex_vtxBuffer, ex_vertices, stats);
+		write(ex_drawBuffer, ex_drawCmds, stats);
+		stats.drawCmds += ex_drawCmds.size();
+	}
+
+private:
+	template <typename T>
+	static void write(std::vector<std::byte>& dst, const std::vector<T>& src, Stats& stats) {
+		dst.resize(src.size() * sizeof(T));
+		memcpy(dst.data(), src.data(), dst.size());
+		stats.bytesWritten += dst.size();
+	}
+
+	std::vector<Vertex>    ex_vertices;
+	std::vector<DrawCmd>   ex_drawCmds;
+	std::vector<std::byte> ex_vtxBuffer;
+	std::vector<std::byte> ex_drawBuffer;
+};
+
+
+// Instanced, but every change groups the instances again and rewrites every buffer
+class Rebuilt {
+public:
+	void frame(const Scene& scene, Stats& stats) {
+		std::unordered_map<const Shape*, std::vector<const Instance*>> groups;
+		for(size_t i = 0; i < scene.rects.size(); ++i) groups[scene.rectShapes[i]].push_back(&scene.rects[i]);
+		std::vector<Instance> instances;
+		std::vector<Vertex>   vertices;
+		std::vector<DrawCmd>  drawCmds;
+		for(auto& group : groups) {
+			drawCmds.push_back({ uint32_t(group.first->size()), uint32_t(group.second.size()), uint32_t(vertices.size()), uint32_t(instances.size()) });
+			vertices.insert(vertices.end(), group.first->begin(), group.first->end());
+			for(auto* inst : group.second) instances.push_back(*inst);
+		}
+		size_t instBytes = instances.size() * sizeof(Instance);
+		size_t vtxBytes  = vertices.size() * sizeof(Vertex);
+		rb_vtxBuffer.resize(instBytes + vtxBytes);
+		memcpy(rb_vtxBuffer.data(), instances.data(), instBytes);
+		memcpy(rb_vtxBuffer.data() + instBytes, vertices.data(), vtxBytes);
+		rb_drawBuffer.resize(drawCmds.size() * sizeof(DrawCmd));
+		memcpy(rb_drawBuffer.data(), drawCmds.data(), rb_drawBuffer.size());
+		stats.bytesWritten += rb_vtxBuffer.size() + rb_drawBuffer.size();
+		stats.drawCmds += drawCmds.size();
+	}
+
+private:
+	std::vector<std::byte> rb_vtxBuffer;
+	std::vector<std::byte> rb_drawBuffer;
+};
+
+
+// The layout is built once, then only the instances that differ are rewritten
+class Instanced {
+public:
+	void frame(const Scene& scene, Stats& stats) {
+		if(in_instances.empty()) {
+			in_layout = InstanceLayout<const Shape*>::build(scene.rectShapes);
+			in_instances = scene.rects;
+			in_buffer.resize(in_instances.size());
+			for(size_t i = 0; i < in_instances.size(); ++i) in_buffer[in_layout.slots[i]] = in_instances[i];
+		}
+		for(size_t i = 0; i < scene.rects.size(); ++i) {
+			if(0 == memcmp(&in_instances[i], &scene.rects[i], sizeof(Instance))) continue;
+			in_instances[i] = scene.rects[i];
+			in_buffer[in_layout.slots[i]] = in_instances[i];
+			stats.bytesWritten += sizeof(Instance);
+		}
+		stats.drawCmds += in_layout.groups.size();
+	}
+
+private:
+	InstanceLayout<const Shape*> in_layout;
+	std::vector<Instance> in_instances;
+	std::vector<Instance> in_buffer;
+};
+
+
+struct Result {
+	double usPerFrame;
+	Stats  stats;
+};
+
+
+template <typename Impl>
+Result run(size_t movingCount) {
+	using clock = std::chrono::steady_clock;
+	auto scene = makeScene();
+	Impl impl;
+	Stats stats = { };
+	impl.frame(scene, stats); // Warm up
+	stats = { };
+	auto beg = clock::now();
+	for(size_t i = 0; i < frameCount; ++i) {
+		animate(scene, i, movingCount);
+		impl.frame(scene, stats);
+	}
+	auto end = clock::now();
+	return { std::chrono::duration<double, std::micro>(end - beg).count() / double(frameCount), stats };
+}
+
+
+int main() {
+	fmt::print("{} rectangles of {} shapes, {} frames\n", rectCount, shapeCount, frameCount);
+	fmt::print("{:>28} | {:>10} | {:>14} | {:>10}\n", "path", "us/frame", "bytes/frame", "draw cmds");
+	auto print = [](const char* name, Result r) {
+		fmt::print("{:>28} | {:>10.2f} | {:>14} | {:>10}\n", name, r.usPerFrame, r.stats.bytesWritten / frameCount, r.stats.drawCmds / frameCount);
+	};
+	print("expanded, all moving",    run<Expanded> (rectCount));
+	print("rebuilt, all moving",     run<Rebuilt>  (rectCount));
+	print("instanced, all moving",   run<Instanced>(rectCount));
+	print("expanded, 100 moving",    run<Expanded> (100));
+	print("rebuilt, 100 moving",     run<Rebuilt>  (100));
+	print("instanced, 100 moving",   run<Instanced>(100));
+}
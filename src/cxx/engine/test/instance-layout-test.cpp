@@ -0,0 +1,97 @@
+#include <engine/draw-geometry/instance_layout.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+
+using Layout = SKENGINE_NAME_NS::InstanceLayout<unsigned>;
+
+
+
+bool checkLayout(const std::vector<unsigned>& shapes, const Layout& layout) {
+	if(layout.slots.size() != shapes.size()) return false;
+
+	// Groups are contiguous, distinct, in the order their shapes are first seen
+	uint32_t nextSlot = 0;
+	std::vector<bool> seen(shapes.size() + 1, false);
+	size_t nextFirst = 0;
+	for(auto& group : layout.groups) {
+		if(group.firstSlot != nextSlot || group.count == 0) return false;
+		if(seen[group.shape]) return false;
+		seen[group.shape] = true;
+		while(nextFirst < shapes.size() && shapes[nextFirst] != group.shape) {
+			if(! seen[shapes[nextFirst]]) return false;
+			++ nextFirst;
+		}
+		nextSlot += group.count;
+	}
+	if(nextSlot != shapes.size()) return false;
+
+	// Every instance has its own slot, in its shape's group, in the order it was given
+	std::vector<bool> taken(shapes.size(), false);
+	std::vector<uint32_t> lastSlot(layout.groups.size(), 0);
+	std::vector<bool> anySlot(layout.groups.size(), false);
+	for(size_t i = 0; i < shapes.size(); ++i) {
+		uint32_t slot = layout.slots[i];
+		if(slot >= shapes.size() || taken[slot]) return false;
+		taken[slot] = true;
+		size_t g = 0;
+		while(slot >= layout.groups[g].firstSlot + layout.groups[g].count) ++ g;
+		if(layout.groups[g].shape != shapes[i]) return false;
+		if(anySlot[g] && slot <= lastSlot[g]) return false;
+		anySlot[g]  = true;
+		lastSlot[g] = slot;
+	}
+	return true;
+}
+
+
+bool testLayout() {
+	constexpr size_t sizes[] = { 0, 1, 2, 100, 10000 };
+	constexpr unsigned shapeCounts[] = { 1, 3, 64 };
+	auto rng = std::minstd_rand(1);
+	bool fail = false;
+
+	for(size_t size : sizes)
+	for(unsigned shapeCount : shapeCounts) {
+		std::vector<unsigned> shapes;
+		shapes.reserve(size);
+		for(size_t i = 0; i < size; ++i) shapes.push_back(rng() % shapeCount);
+		auto layout = Layout::build(shapes);
+		if(! checkLayout(shapes, layout)) {
+			fmt::print(stderr, "Bad layout for {} instances of {} shapes\n", size, shapeCount);
+			fail = true;
+		}
+		if(layout.groups.size() > shapeCount) fail = true;
+	}
+
+	// A single shape keeps the instances in their order
+	auto layout = Layout::build(std::vector<unsigned> { 7, 7, 7 });
+	if(layout.groups.size() != 1 || layout.slots != std::vector<uint32_t> { 0, 1, 2 }) fail = true;
+
+	// Interleaved shapes are grouped
+	layout = Layout::build(std::vector<unsigned> { 2, 1, 2, 1 });
+	if(layout.groups.size() != 2 || layout.groups[0].shape != 2 || layout.slots != std::vector<uint32_t> { 0, 2, 1, 3 }) fail = true;
+
+	fmt::print("Instance layout: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testLayout() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include <engine/resolution_scaler.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+
+
+using SKENGINE_NAME_NS::ResolutionScaler;
+using SKENGINE_NAME_NS::ResolutionScalerParams;
+
+constexpr auto test_params = ResolutionScalerParams {
+	.targetUtilization = 0.9,
+	.minScale          = 0.5,
+	.kp                = 0.2,
+	.ki                = 0.1,
+	.kd                = 0.0,
+	.tolerance         = 0.03 };
+
+constexpr double frame_interval = 1.0 / 60.0;
+
+
+
+// A GPU whose frame time is a fixed cost plus a cost proportional to the rendered area
+struct FakeGpu {
+	double fixedTime;
+	double fullAreaTime;
+
+	double frameTime(double scale) const { return fixedTime + (fullAreaTime * scale * scale); }
+};
+
+
+struct RunResult {
+	double finalScale;
+	double finalTime;
+	unsigned scaleChanges;
+	unsigned lateChanges; // Scale changes in the second half of the run
+};
+
+
+RunResult run(ResolutionScaler& scaler, const FakeGpu& gpu, unsigned frames) {
+	auto r = RunResult { };
+	for(unsigned i = 0; i < frames; ++i) {
+		if(scaler.update(gpu.frameTime(scaler.scale()))) {
+			++ r.scaleChanges;
+			if(i >= frames / 2) ++ r.lateChanges;
+		}
+	}
+	r.finalScale = scaler.scale();
+	r.finalTime  = gpu.frameTime(r.finalScale);
+	return r;
+}
+
+
+bool testConvergence() {
+	auto scaler = ResolutionScaler(test_params, frame_interval);
+	auto gpu    = FakeGpu { 0.002, 0.025 };
+	auto r      = run(scaler, gpu, 400);
+	bool fail   = false;
+
+	// The tolerance allows a small steady-state error
+	if(std::abs(r.finalTime - scaler.targetTime()) > scaler.targetTime() * 0.05) {
+		fmt::print(stderr, "GPU time {:.3f}ms did not converge to {:.3f}ms\n", r.finalTime * 1000.0, scaler.targetTime() * 1000.0);
+		fail = true;
+	}
+	if(r.lateChanges > 0) {
+		fmt::print(stderr, "The scale still changed {} times after settling\n", r.lateChanges);
+		fail = true;
+	}
+
+	fmt::print("Convergence: scale {:.3f}, {} changes, {}\n", r.finalScale, r.scaleChanges, fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testLimits() {
+	bool fail = false;
+
+	{ // A GPU that is always too slow saturates at the minimum scale
+		auto scaler = ResolutionScaler(test_params, frame_interval);
+		auto r = run(scaler, FakeGpu { 0.030, 0.030 }, 200);
+		if(r.finalScale != test_params.minScale) {
+			fmt::print(stderr, "Overloaded GPU: scale {:.3f} instead of {:.3f}\n", r.finalScale, test_params.minScale);
+			fail = true;
+		}
+	}
+
+	{ // A GPU that is always fast enough saturates at full scale, and recovers from a spike
+		auto scaler = ResolutionScaler(test_params, frame_interval);
+		run(scaler, FakeGpu { 0.020, 0.010 }, 50);
+		auto r = run(scaler, FakeGpu { 0.001, 0.004 }, 200);
+		if(r.finalScale != 1.0) {
+			fmt::print(stderr, "Idle GPU: scale {:.3f} instead of 1\n", r.finalScale);
+			fail = true;
+		}
+	}
+
+	fmt::print("Limits: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testDeterminism() {
+	auto gpu = FakeGpu { 0.003, 0.020 };
+	auto a = ResolutionScaler(test_params, frame_interval);
+	auto b = ResolutionScaler(test_params, frame_interval);
+	bool fail = false;
+	for(unsigned i = 0; i < 100; ++i) {
+		a.update(gpu.frameTime(a.scale()));
+		b.update(gpu.frameTime(b.scale()));
+		if(a.scale() != b.scale()) { fail = true; break; }
+	}
+	a.reset(frame_interval);
+	if(a.scale() != 1.0) fail = true;
+
+	fmt::print("Determinism: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testConvergence()  ? fail : true;
+		fail = testLimits()       ? fail : true;
+		fail = testDeterminism()  ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+#include <engine/draw-geometry/sdf.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::coverageToSdf;
+using SKENGINE_NAME_NS::sdfEdgeValue;
+
+// A glyph outline, in a unit square with the Y axis pointing down
+using Outline = std::function<bool (float x, float y)>;
+
+
+
+struct Bitmap {
+	unsigned width;
+	unsigned height;
+	std::vector<float> alpha;
+};
+
+
+// Rasterizes an outline like FreeType would, with 8x8 supersampled coverage
+Bitmap rasterize(const Outline& outline, unsigned side) {
+	constexpr unsigned ss = 8;
+	Bitmap r = { side, side, std::vector<float>(size_t(side) * side) };
+	float texel = 1.0f / float(side);
+	for(unsigned y = 0; y < side; ++y)
+	for(unsigned x = 0; x < side; ++x) {
+		unsigned hits = 0;
+		for(unsigned sy = 0; sy < ss; ++sy)
+		for(unsigned sx = 0; sx < ss; ++sx) {
+			float fx = (float(x) + ((float(sx) + 0.5f) / float(ss))) * texel;
+			float fy = (float(y) + ((float(sy) + 0.5f) / float(ss))) * texel;
+			hits += outline(fx, fy)? 1 : 0;
+		}
+		r.alpha[(size_t(y) * side) + x] = float(hits) / float(ss * ss);
+	}
+	return r;
+}
+
+
+std::vector<uint8_t> toBytes(const Bitmap& bmp) {
+	std::vector<uint8_t> r(bmp.alpha.size());
+	for(size_t i = 0; i < r.size(); ++i) r[i] = uint8_t(std::round(bmp.alpha[i] * 255.0f));
+	return r;
+}
+
+
+// Samples a byte image like a linear, clamp-to-border sampler does
+float sampleBilinear(const std::vector<uint8_t>& img, unsigned width, unsigned height, float u, float v) {
+	float x = (u * float(width))  - 0.5f;
+	float y = (v * float(height)) - 0.5f;
+	int x0 = int(std::floor(x));
+	int y0 = int(std::floor(y));
+	float tx = x - float(x0);
+	float ty = y - float(y0);
+	auto texel = [&](int tx, int ty) {
+		if(tx < 0 || ty < 0 || tx >= int(width) || ty >= int(height)) return 0.0f;
+		return float(img[(size_t(ty) * width) + size_t(tx)]) / 255.0f;
+	};
+	float top    = std::lerp(texel(x0, y0),   texel(x0+1, y0),   tx);
+	float bottom = std::lerp(texel(x0, y0+1), texel(x0+1, y0+1), tx);
+	return std::lerp(top, bottom, ty);
+}
+
+
+float smoothstep(float e0, float e1, float x) {
+	float t = std::clamp((x - e0) / (e1 - e0), 0.0f, 1.0f);
+	return t * t * (3.0f - (2.0f * t));
+}
+
+
+// Draws a glyph's distance field at `side` pixels, the way the SDF text fragment shader does
+Bitmap shadeSdf(const std::vector<uint8_t>& sdf, unsigned glyphSide, unsigned spread, unsigned side) {
+	unsigned sdfSide = glyphSide + (2 * spread);
+	Bitmap r = { side, side, std::vector<float>(size_t(side) * side) };
+	float edge = float(sdfEdgeValue) / 255.0f;
+	float fwidth = (float(sdfEdgeValue - 1) / float(spread) / 255.0f) * (float(glyphSide) / float(side)); // Per pixel, as the GPU would compute it
+	float w = 0.5f * fwidth;
+	for(unsigned y = 0; y < side; ++y)
+	for(unsigned x = 0; x < side; ++x) {
+		// Pixel centers, mapped to the unpadded part of the field
+		float u = (float(spread) + ((float(x) + 0.5f) / float(side) * float(glyphSide))) / float(sdfSide);
+		float v = (float(spread) + ((float(y) + 0.5f) / float(side) * float(glyphSide))) / float(sdfSide);
+		float d = sampleBilinear(sdf, sdfSide, sdfSide, u, v);
+		r.alpha[(size_t(y) * side) + x] = smoothstep(edge - w, edge + w, d);
+	}
+	return r;
+}
+
+
+// Draws a coverage bitmap at `side` pixels with a linear sampler, the way the plain text fragment shader does
+Bitmap shadeCoverage(const std::vector<uint8_t>& coverage, unsigned glyphSide, unsigned side) {
+	Bitmap r = { side, side, std::vector<float>(size_t(side) * side) };
+	for(unsigned y = 0; y < side; ++y)
+	for(unsigned x = 0; x < side; ++x) {
+		float u = (float(x) + 0.5f) / float(side);
+		float v = (float(y) + 0.5f) / float(side);
+		r.alpha[(size_t(y) * side) + x] = sampleBilinear(coverage, glyphSide, glyphSide, u, v);
+	}
+	return r;
+}
+
+
+struct Difference {
+	double meanError;     // Average absolute alpha difference
+	double mismatchRatio; // Fraction of pixels that are clearly on the other side of the outline
+};
+
+// `b` is the reference
+Difference compare(const Bitmap& a, const Bitmap& b) {
+	double errSum = 0.0;
+	size_t mismatches = 0;
+	for(size_t i = 0; i < a.alpha.size(); ++i) {
+		errSum += std::abs(a.alpha[i] - b.alpha[i]);
+		bool clear = std::abs(b.alpha[i] - 0.5f) >= 0.25f; // Pixels on the outline may go either way
+		if(clear && ((a.alpha[i] >= 0.5f) != (b.alpha[i] >= 0.5f))) ++ mismatches;
+	}
+	return { errSum / double(a.alpha.size()), double(mismatches) / double(a.alpha.size()) };
+}
+
+
+
+struct Glyph {
+	const char* name;
+	Outline outline;
+};
+
+const Glyph glyphs[] = {
+	{ "O", [](float x, float y) {
+		float r2 = ((x - 0.5f) * (x - 0.5f)) + ((y - 0.5f) * (y - 0.5f));
+		return r2 <= 0.40f * 0.40f && r2 >= 0.25f * 0.25f; } },
+	{ "L", [](float x, float y) {
+		return (x >= 0.2f && x <= 0.38f && y >= 0.1f && y <= 0.9f) || (x >= 0.2f && x <= 0.8f && y >= 0.72f && y <= 0.9f); } },
+	{ "V", [](float x, float y) { // Slanted strokes, meeting at an acute angle
+		float l = std::abs((x - 0.5f) + ((y - 0.9f) * 0.45f));
+		float r = std::abs((x - 0.5f) - ((y - 0.9f) * 0.45f));
+		return y >= 0.1f && y <= 0.9f && (l <= 0.08f || r <= 0.08f); } },
+	{ "dot", [](float x, float y) {
+		return ((x - 0.5f) * (x - 0.5f)) + ((y - 0.5f) * (y - 0.5f)) <= 0.12f * 0.12f; } } };
+
+
+
+bool testFieldValues() {
+	constexpr unsigned side   = 8;
+	constexpr unsigned spread = 4;
+	bool fail = false;
+
+	auto empty = std::vector<uint8_t>(side * side, 0);
+	auto sdf = coverageToSdf(empty.data(), side, side, side, spread);
+	if(sdf.size() != (side + 2*spread) * (side + 2*spread)) fail = true;
+	if(std::any_of(sdf.begin(), sdf.end(), [](uint8_t v) { return v != 0; })) {
+		fmt::print(stderr, "The field of an empty glyph is not entirely outside\n");
+		fail = true;
+	}
+
+	// A half-plane: the outline lies between the 4th and the 5th column, the padding is also outside
+	auto half = std::vector<uint8_t>(side * side, 0);
+	for(unsigned y = 0; y < side; ++y) for(unsigned x = 0; x < side / 2; ++x) half[(y * side) + x] = 0xff;
+	sdf = coverageToSdf(half.data(), side, side, side, spread);
+	unsigned sdfSide = side + (2 * spread);
+	unsigned row = sdfSide / 2;
+	for(unsigned x = spread + (side / 4); x + 1 < sdfSide; ++x) { // Starting from the middle of the inside
+		if(sdf[(row * sdfSide) + x] < sdf[(row * sdfSide) + x + 1]) {
+			fmt::print(stderr, "The field is not monotonic across a straight outline\n");
+			fail = true;
+			break;
+		}
+	}
+	int inner = sdf[(row * sdfSide) + spread + (side / 2) - 1];
+	int outer = sdf[(row * sdfSide) + spread + (side / 2)];
+	if(inner < sdfEdgeValue || outer >= sdfEdgeValue || std::abs((inner - sdfEdgeValue) - (sdfEdgeValue - outer)) > 1) {
+		fmt::print(stderr, "The outline is not centered between texels ({} and {})\n", inner, outer);
+		fail = true;
+	}
+
+	fmt::print("Field values: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+// Renders every glyph once at a base size, then draws its distance field at several
+// sizes, and compares the result with the glyph rasterized at the same size
+bool testScaledGlyphs() {
+	constexpr unsigned baseSide = 32;
+	constexpr unsigned spread   = 4;
+	constexpr unsigned sides[]  = { 16, 32, 64, 128, 256 };
+	constexpr double maxMeanError     = 0.02;
+	constexpr double maxMismatchRatio = 0.005; // The base bitmap cannot place the outline more precisely than that
+	bool fail = false;
+
+	for(auto& glyph : glyphs) {
+		auto base = toBytes(rasterize(glyph.outline, baseSide));
+		auto sdf  = coverageToSdf(base.data(), baseSide, baseSide, baseSide, spread);
+
+		for(unsigned side : sides) {
+			auto reference = rasterize(glyph.outline, side);
+			auto diffSdf   = compare(shadeSdf(sdf, baseSide, spread, side), reference);
+			auto diffPlain = compare(shadeCoverage(base, baseSide, side), reference);
+			bool glyphFail = false;
+			if(diffSdf.meanError > maxMeanError || diffSdf.mismatchRatio > maxMismatchRatio) glyphFail = true;
+			// Magnified distance fields must look sharper than magnified coverage
+			if(side > baseSide && diffSdf.meanError >= diffPlain.meanError) glyphFail = true;
+			fmt::print(
+				"Glyph \"{}\" at {:3}px: mean error {:.4f} (coverage {:.4f}), mismatches {:.4f} (coverage {:.4f}) {}\n",
+				glyph.name, side,
+				diffSdf.meanError, diffPlain.meanError,
+				diffSdf.mismatchRatio, diffPlain.mismatchRatio,
+				glyphFail? "FAIL" : "ok" );
+			fail = fail || glyphFail;
+		}
+	}
+
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testFieldValues()  ? fail : true;
+		fail = testScaledGlyphs() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
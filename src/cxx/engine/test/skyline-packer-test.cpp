@@ -0,0 +1,142 @@
+#include <engine/draw-geometry/skyline_packer.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::SkylinePacker;
+using Rect = SkylinePacker::Rect;
+
+
+
+// Glyph-like sizes, sorted by height like the text cache does
+std::vector<Rect> makeGlyphSizes(unsigned seed, size_t count) {
+	auto rng = std::minstd_rand(seed);
+	std::vector<Rect> r;
+	r.reserve(count);
+	for(size_t i = 0; i < count; ++i) {
+		auto h = SkylinePacker::coord_t(8 + (rng() % 17));
+		auto w = SkylinePacker::coord_t(2 + (rng() % h));
+		r.push_back({ 0, 0, w, h });
+	}
+	std::stable_sort(r.begin(), r.end(), [](const Rect& a, const Rect& b) { return a.height > b.height; });
+	return r;
+}
+
+
+// Checks that every rectangle is within the area, and that no two rectangles overlap
+bool checkPlacements(const SkylinePacker& packer, const std::vector<Rect>& placed) {
+	std::vector<bool> covered(size_t(packer.width()) * packer.height(), false);
+	uint64_t area = 0;
+	for(auto& rect : placed) {
+		if(rect.x + rect.width > packer.width() || rect.y + rect.height > packer.height()) {
+			fmt::print(stderr, "Rectangle {}x{} at ({}, {}) is out of bounds\n", rect.width, rect.height, rect.x, rect.y);
+			return false;
+		}
+		for(auto y = rect.y; y < rect.y + rect.height; ++y)
+		for(auto x = rect.x; x < rect.x + rect.width;  ++x) {
+			auto i = (size_t(y) * packer.width()) + x;
+			if(covered[i]) {
+				fmt::print(stderr, "Rectangle {}x{} at ({}, {}) overlaps another one\n", rect.width, rect.height, rect.x, rect.y);
+				return false;
+			}
+			covered[i] = true;
+		}
+		area += uint64_t(rect.width) * rect.height;
+	}
+	if(area != packer.usedArea()) {
+		fmt::print(stderr, "Used area is {} instead of {}\n", packer.usedArea(), area);
+		return false;
+	}
+	return true;
+}
+
+
+bool testOccupancy() {
+	auto packer = SkylinePacker(256, 256);
+	auto sizes  = makeGlyphSizes(1, 4096);
+	std::vector<Rect> placed;
+	for(auto& size : sizes) {
+		Rect r;
+		if(packer.insert(size.width, size.height, r)) placed.push_back(r);
+	}
+	bool fail = ! checkPlacements(packer, placed);
+
+	// Once full, a skyline packer of similarly sized rectangles wastes little more than a row
+	constexpr double minOccupancy = 0.85;
+	if(packer.occupancy() < minOccupancy) {
+		fmt::print(stderr, "Occupancy {:.3f} is lower than {:.3f}\n", packer.occupancy(), minOccupancy);
+		fail = true;
+	}
+
+	Rect unused;
+	if(packer.insert(0, 4, unused) || packer.insert(257, 1, unused) || packer.insert(1, 257, unused)) {
+		fmt::print(stderr, "Inserted an empty or oversized rectangle\n");
+		fail = true;
+	}
+
+	fmt::print("Occupancy: {} rectangles, {:.3f}, {}\n", placed.size(), packer.occupancy(), fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testGrowth() {
+	auto packer = SkylinePacker(64, 64);
+	auto sizes  = makeGlyphSizes(2, 512);
+	std::vector<Rect> placed;
+	unsigned growths = 0;
+	for(auto& size : sizes) {
+		Rect r;
+		while(! packer.insert(size.width, size.height, r)) {
+			// Alternate doubling the width and the height, as the text cache does
+			if(packer.width() <= packer.height()) packer.grow(packer.width() * 2, packer.height());
+			else                                  packer.grow(packer.width(), packer.height() * 2);
+			++ growths;
+		}
+		placed.push_back(r);
+	}
+	bool fail = ! checkPlacements(packer, placed);
+	fmt::print("Growth: {} rectangles in {}x{} after {} growths, {:.3f}, {}\n", placed.size(), packer.width(), packer.height(), growths, packer.occupancy(), fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testDeterminism() {
+	auto sizes = makeGlyphSizes(3, 1024);
+	auto a = SkylinePacker(128, 128);
+	auto b = SkylinePacker(128, 128);
+	bool fail = false;
+	for(auto& size : sizes) {
+		Rect ra = { }, rb = { };
+		bool ia = a.insert(size.width, size.height, ra);
+		bool ib = b.insert(size.width, size.height, rb);
+		if(ia != ib || ra.x != rb.x || ra.y != rb.y) { fail = true; break; }
+	}
+	b.reset(128, 128);
+	if(b.usedArea() != 0 || b.skyline().size() != 1) fail = true;
+
+	fmt::print("Determinism: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testOccupancy()   ? fail : true;
+		fail = testGrowth()      ? fail : true;
+		fail = testDeterminism() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
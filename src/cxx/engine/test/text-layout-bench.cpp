@@ -0,0 +1,178 @@
+// 1000 text lines, 1% of which change every frame: compares rebuilding every
+// line's vertices, rebuilding only the changed lines, and rebuilding only the
+// changed lines with shared layouts, shared glyph quads and persistent vertex
+// storage. Vulkan buffer allocations, which the persistent storage also
+// avoids, are not part of the measurements.
+
+#include <engine/draw-geometry/text_layout.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+using SKENGINE_NAME_NS::TextLayoutCache;
+using SKENGINE_NAME_NS::TextLayout;
+using SKENGINE_NAME_NS::CharDescriptor;
+using SKENGINE_NAME_NS::codepoint_t;
+
+constexpr size_t lineCount   = 1000;
+constexpr size_t changeCount = lineCount / 100;
+constexpr size_t frameCount  = 2000;
+constexpr size_t stringCount = 400; // Labels, counters and such: most strings reappear
+
+
+
+struct TextVertex {
+	float position[3];
+	float uv[2];
+};
+
+
+TextLayoutCache::CharMap makeChars() {
+	TextLayoutCache::CharMap r;
+	for(codepoint_t c = U' '; c <= U'~'; ++c) {
+		float u = float(c - U' ') / 96.0f;
+		float advance = 0.25f + (0.003f * float(c - U' '));
+		r[c] = CharDescriptor { { u, 0.0f }, { u + 0.01f, 0.1f }, { advance, 0.7f }, { 0.0f, 0.6f }, { advance, 0.0f } };
+	}
+	return r;
+}
+
+
+float kerning(codepoint_t l, codepoint_t r) {
+	// Stands in for FT_Get_Kerning, which looks up both glyph indices and a kerning table
+	return (((l * 31) ^ r) % 7 == 0)? -0.02f : 0.0f;
+}
+
+
+using GlyphQuad = std::shared_ptr<const std::vector<TextVertex>>;
+
+// The same quad that the GUI builds for each glyph, which is then translated by the pen position
+GlyphQuad makeGlyphQuad(const CharDescriptor& cd) {
+	float x1 = cd.size[0] * 2.0f;
+	float y1 = (cd.size[1] - cd.baseline[1]) + 2.0f;
+	float y0 = y1 - (cd.size[1] * 2.0f);
+	return std::make_shared<const std::vector<TextVertex>>(std::vector<TextVertex> {
+		{ { 0.0f, y0, 0.0f }, { cd.topLeftUv[0],     cd.topLeftUv[1]     } },
+		{ { 0.0f, y1, 0.0f }, { cd.topLeftUv[0],     cd.bottomRightUv[1] } },
+		{ { x1,   y1, 0.0f }, { cd.bottomRightUv[0], cd.bottomRightUv[1] } },
+		{ { x1,   y0, 0.0f }, { cd.bottomRightUv[0], cd.topLeftUv[1]     } } });
+}
+
+
+void emitQuad(std::vector<TextVertex>& dst, const std::vector<TextVertex>& quad, float penX) {
+	for(auto vtx : quad) {
+		vtx.position[0] += penX * 2.0f;
+		dst.push_back(vtx);
+	}
+}
+
+
+std::vector<std::u32string> makeStrings() {
+	std::vector<std::u32string> r;
+	r.reserve(stringCount);
+	const char* labels[] = { "Score: ", "Length ", "Speed x", "Level ", "FPS " };
+	for(size_t i = 0; i < stringCount; ++i) {
+		auto s = fmt::format("{}{}", labels[i % std::size(labels)], i * 7);
+		r.emplace_back(s.begin(), s.end());
+	}
+	return r;
+}
+
+
+// Which lines change on every frame, and into what; the same for every strategy
+std::vector<std::pair<size_t, size_t>> makeChanges(size_t seed) {
+	auto rng = std::minstd_rand(seed);
+	std::vector<std::pair<size_t, size_t>> r;
+	r.reserve(frameCount * changeCount);
+	for(size_t i = 0; i < frameCount * changeCount; ++i) r.push_back({ rng() % lineCount, rng() % stringCount });
+	return r;
+}
+
+
+struct Result {
+	double usPerFrame;
+	size_t checksum; // Keeps the work from being optimized away
+};
+
+
+enum class Strategy { eRebuildAll, eRebuildChanged, eCached };
+
+
+Result run(Strategy strategy, const TextLayoutCache::CharMap& chars, const std::vector<std::u32string>& strings, const std::vector<std::pair<size_t, size_t>>& changes) {
+	using clock = std::chrono::steady_clock;
+	int font;
+	TextLayoutCache layoutCache;
+	std::unordered_map<codepoint_t, GlyphQuad> glyphQuads;
+	std::vector<size_t> lineStrings(lineCount);
+	std::vector<TextLayoutCache::LayoutPtr> lineLayouts(lineCount);
+	std::vector<std::vector<TextVertex>> lineVertices(lineCount);
+	for(size_t i = 0; i < lineCount; ++i) lineStrings[i] = i % stringCount;
+	size_t checksum = 0;
+
+	auto uncachedLayout = [&](size_t line) {
+		bool complete;
+		return TextLayoutCache::computeLayout(strings[lineStrings[line]], chars, kerning, complete);
+	};
+
+	auto rebuild = [&](size_t line) {
+		switch(strategy) {
+			case Strategy::eRebuildAll: [[fallthrough]];
+			case Strategy::eRebuildChanged: {
+				// New quads and a new vertex buffer for every rebuilt line
+				auto layout = uncachedLayout(line);
+				auto vertices = std::vector<TextVertex>();
+				for(auto& glyph : layout.glyphs) emitQuad(vertices, *makeGlyphQuad(chars.find(glyph.codepoint)->second), glyph.penX);
+				lineVertices[line] = std::move(vertices);
+			} break;
+			case Strategy::eCached: {
+				lineLayouts[line] = layoutCache.get(&font, 16, strings[lineStrings[line]], chars, kerning);
+				lineVertices[line].clear(); // Rewritten in place
+				for(auto& glyph : lineLayouts[line]->glyphs) {
+					auto& quad = glyphQuads[glyph.codepoint];
+					if(! quad) quad = makeGlyphQuad(chars.find(glyph.codepoint)->second);
+					emitQuad(lineVertices[line], *quad, glyph.penX);
+				}
+			} break;
+		}
+		checksum += lineVertices[line].size();
+	};
+
+	for(size_t i = 0; i < lineCount; ++i) rebuild(i);
+
+	auto beg = clock::now();
+	for(size_t frame = 0; frame < frameCount; ++frame) {
+		for(size_t i = 0; i < changeCount; ++i) {
+			auto& change = changes[(frame * changeCount) + i];
+			lineStrings[change.first] = change.second;
+			if(strategy != Strategy::eRebuildAll) rebuild(change.first);
+		}
+		if(strategy == Strategy::eRebuildAll) for(size_t i = 0; i < lineCount; ++i) rebuild(i);
+		if(strategy == Strategy::eCached) layoutCache.trim();
+	}
+	auto end = clock::now();
+
+	return { std::chrono::duration<double, std::micro>(end - beg).count() / double(frameCount), checksum };
+}
+
+
+int main() {
+	auto chars   = makeChars();
+	auto strings = makeStrings();
+	auto changes = makeChanges(1);
+
+	fmt::print("{} lines, {} changes per frame, {} frames\n", lineCount, changeCount, frameCount);
+	fmt::print("{:>28} | {:>12}\n", "strategy", "us/frame");
+	auto print = [](const char* name, Result r) { fmt::print("{:>28} | {:>12.2f}   (checksum {})\n", name, r.usPerFrame, r.checksum); };
+	print("rebuild every line",        run(Strategy::eRebuildAll,     chars, strings, changes));
+	print("rebuild changed lines",     run(Strategy::eRebuildChanged, chars, strings, changes));
+	print("cached layouts, persistent", run(Strategy::eCached,        chars, strings, changes));
+}
@@ -0,0 +1,113 @@
+#include <engine/draw-geometry/text_layout.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <string>
+
+
+
+using SKENGINE_NAME_NS::TextLayoutCache;
+using SKENGINE_NAME_NS::CharDescriptor;
+using SKENGINE_NAME_NS::codepoint_t;
+
+
+
+TextLayoutCache::CharMap makeChars() {
+	TextLayoutCache::CharMap r;
+	for(codepoint_t c = U' '; c <= U'~'; ++c) {
+		float advance = 0.25f + (0.01f * float(c - U' '));
+		r[c] = CharDescriptor { { }, { }, { advance, 0.7f }, { 0.0f, 0.7f }, { advance, 0.0f } };
+	}
+	return r;
+}
+
+
+bool near(float a, float b) { return std::abs(a - b) < 0.0001f; }
+
+
+bool testSharing() {
+	auto chars = makeChars();
+	TextLayoutCache cache;
+	int fontA, fontB;
+	bool fail = false;
+
+	auto a0 = cache.get(&fontA, 16, U"Score: 100", chars);
+	auto a1 = cache.get(&fontA, 16, std::u32string(U"Score: 100"), chars);
+	auto b  = cache.get(&fontA, 16, U"Score: 101", chars);
+	auto c  = cache.get(&fontA, 24, U"Score: 100", chars);
+	auto d  = cache.get(&fontB, 16, U"Score: 100", chars);
+	if(a0 != a1) { fmt::print(stderr, "Identical lines do not share their layout\n"); fail = true; }
+	if(a0 == b || a0 == c || a0 == d) { fmt::print(stderr, "Different lines share their layout\n"); fail = true; }
+	if(cache.size() != 4 || cache.hits() != 1 || cache.misses() != 4) {
+		fmt::print(stderr, "{} layouts, {} hits, {} misses instead of 4, 1, 4\n", cache.size(), cache.hits(), cache.misses());
+		fail = true;
+	}
+
+	fmt::print("Sharing: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testPlacement() {
+	auto chars = makeChars();
+	TextLayoutCache cache;
+	int font;
+	bool fail = false;
+
+	auto kerning = [](codepoint_t l, codepoint_t r) { return (l == U'A' && r == U'V')? -0.1f : 0.0f; };
+	auto layout = cache.get(&font, 16, U"AVA", chars, kerning);
+	float advA = chars[U'A'].advance[0];
+	float advV = chars[U'V'].advance[0];
+	if(layout->glyphs.size() != 3) fail = true;
+	else {
+		if(! near(layout->glyphs[0].penX, 0.0f)) fail = true;
+		if(! near(layout->glyphs[1].penX, advA - 0.1f)) fail = true;
+		if(! near(layout->glyphs[2].penX, advA - 0.1f + advV)) fail = true;
+		if(layout->glyphs[1].codepoint != U'V') fail = true;
+	}
+	if(! near(layout->width, advA - 0.1f + advV + advA)) fail = true;
+
+	auto empty = cache.get(&font, 16, U"", chars);
+	if(! empty->glyphs.empty() || empty->width != 0.0f) fail = true;
+
+	fmt::print("Placement: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testTrim() {
+	auto chars = makeChars();
+	TextLayoutCache cache;
+	int font;
+	bool fail = false;
+
+	auto kept = cache.get(&font, 16, U"kept", chars);
+	for(unsigned i = 0; i < 100; ++i) {
+		auto str = std::u32string(U"dropped ") + char32_t(U'0' + (i % 10)) + char32_t(U'0' + (i / 10));
+		cache.get(&font, 16, str, chars);
+	}
+	cache.trim();
+	if(cache.size() != 1) { fmt::print(stderr, "{} layouts after trimming instead of 1\n", cache.size()); fail = true; }
+	if(cache.get(&font, 16, U"kept", chars) != kept) { fmt::print(stderr, "A referenced layout was trimmed\n"); fail = true; }
+
+	fmt::print("Trim: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testSharing()   ? fail : true;
+		fail = testPlacement() ? fail : true;
+		fail = testTrim()      ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
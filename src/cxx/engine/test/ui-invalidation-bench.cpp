@@ -0,0 +1,160 @@
+// A static UI of 10000 elements, one per lot, in 100 nested grids: compares
+// preparing and drawing every element on every frame, as the UI renderer used
+// to, with only preparing and drawing the modified lots and replaying the
+// cached draw jobs of the others, when nothing changes and when one element
+// changes every frame. Elements stand in for GUI elements: preparing them is
+// cheap, and drawing them computes their bounds and emits one draw job.
+
+#include <engine/ui-structure/ui.hpp>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+using namespace SKENGINE_NAME_NS::ui;
+
+constexpr size_t gridSide   = 10; // Each grid is gridSide x gridSide lots
+constexpr size_t frameCount = 200;
+
+
+
+struct Job {
+	ComputedBounds bounds;
+	const Element* element;
+};
+
+
+struct LotJobs : LotRenderData {
+	std::vector<Job> jobs;
+};
+
+
+class BenchElement : public Element {
+public:
+	ComputedBounds ui_elem_getBounds(const Lot& lot) const noexcept override { return lot.getBounds(); }
+
+	PrepareState ui_elem_prepareForDraw(LotId, Lot&, unsigned, DrawContext&) override {
+		++ prepared;
+		return PrepareState::eReady;
+	}
+
+	void ui_elem_draw(LotId, Lot& lot, DrawContext& ctx) override {
+		static_cast<std::vector<Job>*>(ctx.ptr)->push_back(Job { getBounds(lot), this });
+	}
+
+	unsigned prepared = 0;
+};
+
+
+struct Ui {
+	std::unique_ptr<Canvas> canvas;
+	std::vector<std::shared_ptr<BenchElement>> elements;
+};
+
+
+Ui makeUi() {
+	Ui r;
+	r.canvas = std::make_unique<Canvas>(ComputedBounds { 0.0f, 0.0f, 1.0f, 1.0f });
+	static_assert(gridSide == 10);
+	const auto tenths = init_list<float> { 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+	r.canvas->setRowSizes(tenths);
+	r.canvas->setColumnSizes(tenths);
+	r.elements.reserve(gridSide * gridSide * gridSide * gridSide);
+	for(grid_coord_t i = 0; i < grid_coord_t(gridSide); ++i)
+	for(grid_coord_t j = 0; j < grid_coord_t(gridSide); ++j) {
+		auto& outer = *r.canvas->createLot({ i, j }, { 1, 1 }).second;
+		auto  grid  = outer.setChildBasicGrid({ }, tenths, tenths);
+		for(grid_coord_t k = 0; k < grid_coord_t(gridSide); ++k)
+		for(grid_coord_t l = 0; l < grid_coord_t(gridSide); ++l) {
+			auto& inner = *grid->createLot({ k, l }, { 1, 1 }).second;
+			r.elements.push_back(std::make_shared<BenchElement>());
+			inner.createElement(r.elements.back());
+		}
+	}
+	return r;
+}
+
+
+enum class Strategy { eEverything, eModifiedStatic, eModifiedOneChange };
+
+
+struct Result {
+	double usPerFrame;
+	size_t prepared;
+	size_t jobs;
+};
+
+
+Result run(Strategy strategy) {
+	using clock = std::chrono::steady_clock;
+	auto ui = makeUi();
+	auto& canvas = *ui.canvas;
+	auto rng = std::minstd_rand(1);
+	std::vector<Job> frameJobs;
+	size_t jobCount = 0;
+
+	auto prepareLot = [&](LotId id, Lot& lot) {
+		DrawContext ctx = { nullptr };
+		for(auto& elem : lot.elements()) elem.second->ui_elem_prepareForDraw(id, lot, 0, ctx);
+	};
+
+	auto frame = [&]() {
+		if(strategy == Strategy::eEverything) {
+			// No caches: every bound is computed again, every element is drawn again
+			canvas.invalidateLayout();
+			visitLots(canvas, prepareLot);
+			frameJobs.clear();
+			DrawContext ctx = { &frameJobs };
+			visitLots(canvas, [&](LotId id, Lot& lot) { for(auto& elem : lot.elements()) elem.second->ui_elem_draw(id, lot, ctx); });
+			canvas.resetModified();
+		} else {
+			if(strategy == Strategy::eModifiedOneChange) ui.elements[rng() % ui.elements.size()]->setModified();
+			visitModifiedLots(canvas, prepareLot);
+			if(canvas.isModified()) {
+				frameJobs.clear();
+				visitLots(canvas, [&](LotId id, Lot& lot) {
+					auto* lotJobs = static_cast<LotJobs*>(lot.renderData());
+					if(lotJobs == nullptr) {
+						lot.renderData(std::make_unique<LotJobs>());
+						lotJobs = static_cast<LotJobs*>(lot.renderData());
+					}
+					if(lot.isModified()) {
+						lotJobs->jobs.clear();
+						DrawContext ctx = { &lotJobs->jobs };
+						for(auto& elem : lot.elements()) elem.second->ui_elem_draw(id, lot, ctx);
+					}
+					frameJobs.insert(frameJobs.end(), lotJobs->jobs.begin(), lotJobs->jobs.end());
+				});
+				canvas.resetModified();
+			}
+		}
+		jobCount += frameJobs.size();
+	};
+
+	frame(); // The first frame prepares and draws everything regardless
+	jobCount = 0;
+	for(auto& elem : ui.elements) elem->prepared = 0;
+
+	auto beg = clock::now();
+	for(size_t i = 0; i < frameCount; ++i) frame();
+	auto end = clock::now();
+
+	size_t prepared = 0;
+	for(auto& elem : ui.elements) prepared += elem->prepared;
+	return { std::chrono::duration<double, std::micro>(end - beg).count() / double(frameCount), prepared / frameCount, jobCount / frameCount };
+}
+
+
+int main() {
+	fmt::print("{} elements, {} frames\n", gridSide * gridSide * gridSide * gridSide, frameCount);
+	fmt::print("{:>32} | {:>10} | {:>16} | {:>10}\n", "strategy", "us/frame", "prepared/frame", "jobs/frame");
+	auto print = [](const char* name, Result r) { fmt::print("{:>32} | {:>10.2f} | {:>16} | {:>10}\n", name, r.usPerFrame, r.prepared, r.jobs); };
+	print("everything, every frame",         run(Strategy::eEverything));
+	print("modified lots, static UI",        run(Strategy::eModifiedStatic));
+	print("modified lots, 1 change/frame",   run(Strategy::eModifiedOneChange));
+}
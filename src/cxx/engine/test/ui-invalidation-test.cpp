@@ -0,0 +1,172 @@
+#include <engine/ui-structure/ui.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <set>
+
+
+
+using namespace SKENGINE_NAME_NS::ui;
+
+
+
+class CountingElement : public Element {
+public:
+	ComputedBounds ui_elem_getBounds(const Lot& lot) const noexcept override { ++ boundsCalls; return lot.getBounds(); }
+	PrepareState ui_elem_prepareForDraw(LotId, Lot&, unsigned, DrawContext&) override { return PrepareState::eReady; }
+	void ui_elem_draw(LotId, Lot&, DrawContext&) override { }
+
+	mutable unsigned boundsCalls = 0;
+};
+
+
+// canvas
+// |- lot A: (1, 1), with a child grid
+// |  '- lot B: (1, 0), with an element
+// '- lot C: (0, 0)
+struct Tree {
+	std::unique_ptr<Canvas> canvas;
+	Lot* a;
+	Lot* b;
+	Lot* c;
+	std::shared_ptr<BasicGrid> aGrid;
+	std::shared_ptr<CountingElement> elem;
+
+	Tree(ComputedBounds bounds, init_list<float> childRows):
+		canvas(std::make_unique<Canvas>(bounds, init_list<float> { 0.5f, 0.5f }, init_list<float> { 0.25f, 0.75f }))
+	{
+		a = canvas->createLot({ 1, 1 }, { 1, 1 }).second.get();
+		c = canvas->createLot({ 0, 0 }, { 1, 1 }).second.get();
+		aGrid = a->setChildBasicGrid({ }, childRows, { 1.0f });
+		b = aGrid->createLot({ 1, 0 }, { 1, 1 }).second.get();
+		elem = std::make_shared<CountingElement>();
+		b->createElement(elem);
+	}
+};
+
+
+bool near(const ComputedBounds& l, const ComputedBounds& r) {
+	constexpr float e = 0.0001f;
+	return
+		std::abs(l.viewportOffsetLeft - r.viewportOffsetLeft) < e &&
+		std::abs(l.viewportOffsetTop  - r.viewportOffsetTop ) < e &&
+		std::abs(l.viewportWidth      - r.viewportWidth     ) < e &&
+		std::abs(l.viewportHeight     - r.viewportHeight    ) < e;
+}
+
+
+std::set<const Lot*> modifiedLots(Canvas& canvas) {
+	std::set<const Lot*> r;
+	visitModifiedLots(canvas, [&](LotId, Lot& lot) { r.insert(&lot); });
+	return r;
+}
+
+
+
+bool testCachedBounds() {
+	constexpr ComputedBounds full  = { 0.0f, 0.0f, 1.0f, 1.0f };
+	constexpr ComputedBounds inset = { 0.1f, 0.2f, 0.8f, 0.6f };
+	bool fail = false;
+	auto check = [&](const char* what, const ComputedBounds& got, const ComputedBounds& expected) {
+		if(near(got, expected)) return;
+		fmt::print(stderr, "{}: got {{ {}, {}, {}, {} }}, expected {{ {}, {}, {}, {} }}\n", what,
+			got.viewportOffsetLeft, got.viewportOffsetTop, got.viewportWidth, got.viewportHeight,
+			expected.viewportOffsetLeft, expected.viewportOffsetTop, expected.viewportWidth, expected.viewportHeight );
+		fail = true;
+	};
+
+	Tree tree(full, { 0.5f, 0.5f });
+	check("Nested lot", tree.b->getBounds(), { 0.25f, 0.75f, 0.75f, 0.25f });
+	check("Element", tree.elem->getBounds(*tree.b), tree.b->getBounds());
+	tree.elem->getBounds(*tree.b);
+	if(tree.elem->boundsCalls != 1) { fmt::print(stderr, "The element's bounds were computed {} times\n", tree.elem->boundsCalls); fail = true; }
+
+	// Every change must give the same bounds as a tree built with the final values
+	tree.canvas->setBounds(inset);
+	check("Canvas bounds", tree.b->getBounds(), Tree(inset, { 0.5f, 0.5f }).b->getBounds());
+	check("Canvas bounds (element)", tree.elem->getBounds(*tree.b), tree.b->getBounds());
+	if(tree.elem->boundsCalls != 2) { fmt::print(stderr, "The element's bounds were not recomputed\n"); fail = true; }
+
+	tree.aGrid->setRowSizes({ 0.25f, 0.75f });
+	check("Child grid rows", tree.b->getBounds(), Tree(inset, { 0.25f, 0.75f }).b->getBounds());
+
+	tree.canvas->setColumnSizes({ 0.5f, 0.5f });
+	Tree expected(inset, { 0.25f, 0.75f });
+	expected.canvas->setColumnSizes({ 0.5f, 0.5f });
+	check("Canvas columns", tree.b->getBounds(), expected.b->getBounds());
+	check("Sibling", tree.c->getBounds(), expected.c->getBounds());
+
+	tree.b->setSize({ 2, 1 });
+	expected.b->setSize({ 2, 1 });
+	check("Lot size", tree.b->getBounds(), expected.b->getBounds());
+
+	fmt::print("Cached bounds: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testModifiedPropagation() {
+	Tree tree({ 0.0f, 0.0f, 1.0f, 1.0f }, { 0.5f, 0.5f });
+	bool fail = false;
+
+	if(! tree.canvas->isModified() || modifiedLots(*tree.canvas).size() != 3) { fmt::print(stderr, "A new tree is not entirely modified\n"); fail = true; }
+	tree.canvas->resetModified();
+	if(tree.canvas->isModified() || tree.aGrid->isModified() || ! modifiedLots(*tree.canvas).empty()) { fmt::print(stderr, "Resetting the canvas left modified lots\n"); fail = true; }
+
+	// Upwards: only the element's lot, but every grid above it
+	tree.elem->setModified();
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { tree.b }) { fmt::print(stderr, "A modified element did not modify exactly its lot\n"); fail = true; }
+	if(! tree.aGrid->isModified() || ! tree.canvas->isModified()) { fmt::print(stderr, "A modified element did not modify the grids above it\n"); fail = true; }
+	tree.canvas->resetModified();
+
+	// Downwards: everything in the grid, nothing outside of it
+	tree.aGrid->setRowSizes({ 0.3f, 0.7f });
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { tree.b }) { fmt::print(stderr, "Resizing a grid did not modify exactly its lots\n"); fail = true; }
+	tree.canvas->resetModified();
+
+	tree.a->padding(0.1f, 0.1f, 0.1f, 0.1f);
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { tree.a, tree.b }) { fmt::print(stderr, "Changing a lot's padding did not modify exactly its subtree\n"); fail = true; }
+	tree.canvas->resetModified();
+
+	tree.canvas->setBounds({ 0.0f, 0.0f, 0.5f, 0.5f });
+	if(modifiedLots(*tree.canvas).size() != 3) { fmt::print(stderr, "Changing the canvas bounds did not modify every lot\n"); fail = true; }
+	tree.canvas->resetModified();
+
+	// Adding and removing elements and lots
+	auto elem2 = std::make_shared<CountingElement>();
+	auto elem2Id = tree.c->createElement(elem2).first;
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { tree.c } || elem2->lot() != tree.c) { fmt::print(stderr, "Creating an element did not modify its lot\n"); fail = true; }
+	tree.canvas->resetModified();
+	tree.c->destroyElement(elem2Id);
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { tree.c } || elem2->lot() != nullptr) { fmt::print(stderr, "Destroying an element did not modify its lot\n"); fail = true; }
+	elem2->setModified(); // Detached, must not touch the tree
+	tree.canvas->resetModified();
+
+	auto lotD = tree.aGrid->createLot({ 0, 0 }, { 1, 1 });
+	if(modifiedLots(*tree.canvas) != std::set<const Lot*> { lotD.second.get() }) { fmt::print(stderr, "Creating a lot did not modify exactly the new lot\n"); fail = true; }
+	tree.canvas->resetModified();
+	tree.aGrid->destroyLot(lotD.first);
+	if(! tree.canvas->isModified() || ! tree.aGrid->isModified()) { fmt::print(stderr, "Destroying a lot did not modify its grid\n"); fail = true; }
+	tree.canvas->resetModified();
+
+	fmt::print("Modified propagation: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testCachedBounds()        ? fail : true;
+		fail = testModifiedPropagation() ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
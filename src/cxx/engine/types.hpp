@@ -7,6 +7,7 @@
 #include <vma/vk_mem_alloc.h>
 
 #include <sflog.hpp>
+#include <sflog_async.hpp>
 
 
 
@@ -28,7 +29,13 @@ namespace SKENGINE_NAME_NS {
 	#undef DECL_SCOPED_ENUM_
 
 
-	using Logger = sflog::Logger<std::shared_ptr<posixfio::OutputBuffer>>;
+	class CleanupQueue;
+
+
+	// Messages are formatted and written on a background thread, so that logging
+	// from a frame does not wait for the output
+	using LoggerSink = sflog::AsyncSink<posixfio::OutputBuffer>;
+	using Logger     = sflog::Logger<std::shared_ptr<LoggerSink>>;
 
 	template <typename Logger, typename... Pfx>
 	Logger cloneLogger(const Logger& cp, Pfx&&... pfx) { return Logger(cp.sink(), cp.getLevel(), cp.options(), std::forward<Pfx>(pfx)...); }
@@ -40,6 +47,7 @@ namespace SKENGINE_NAME_NS {
 		VkFence       cmdFence;
 		VkQueue       cmdQueue;
 		unsigned      cmdQueueFamily;
+		CleanupQueue* cleanupQueue;
 	};
 
 
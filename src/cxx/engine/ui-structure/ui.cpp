@@ -1,5 +1,7 @@
 #include "ui.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 
 
@@ -17,6 +19,22 @@
 namespace SKENGINE_NAME_NS {
 inline namespace ui {
 
+	ComputedBounds Element::getBounds(const Lot& lot) const noexcept {
+		assert(elem_lot == nullptr || elem_lot == &lot);
+		if(! elem_boundsValid) {
+			elem_bounds = ui_elem_getBounds(lot);
+			elem_boundsValid = true;
+		}
+		return elem_bounds;
+	}
+
+
+	void Element::setModified() noexcept {
+		elem_boundsValid = false;
+		if(elem_lot != nullptr) elem_lot->setModified();
+	}
+
+
 	Lot::Lot(Grid* parentGrid, GridPosition gridOffset, GridSize size):
 		lot_elements(),
 		lot_gridOffset(gridOffset),
@@ -25,7 +43,9 @@ inline namespace ui {
 		lot_transform(glm::mat3(1.0f)),
 		lot_parent(parentGrid),
 		lot_parentRegion(parentGrid),
-		lot_child(nullptr)
+		lot_child(nullptr),
+		lot_boundsValid(false),
+		lot_isModified(true)
 	{ }
 
 
@@ -38,6 +58,7 @@ inline namespace ui {
 
 	void Lot::setSize(GridSize size) noexcept {
 		lot_size = size;
+		invalidateLayout();
 	}
 
 
@@ -49,6 +70,10 @@ inline namespace ui {
 
 
 	ComputedBounds Lot::getBounds() const noexcept {
+		if(lot_boundsValid) return lot_bounds;
+
+		// The parent region's bounds are cached by its own lot, so this only
+		// walks up the tree until the first lot whose bounds are still valid
 		GridPosition br = lot_gridOffset;
 		br.row += lot_size.rows;
 		br.column += lot_size.columns;
@@ -59,28 +84,33 @@ inline namespace ui {
 		r.viewportOffsetTop  = parentBounds.viewportOffsetTop  + (relBounds.top  * parentBounds.viewportHeight);
 		r.viewportWidth  = relBounds.width  * parentBounds.viewportWidth;
 		r.viewportHeight = relBounds.height * parentBounds.viewportHeight;
+		lot_bounds = r;
+		lot_boundsValid = true;
 		return r;
 	}
 
 
 	std::pair<ElementId, std::shared_ptr<Element>&> Lot::createElement(std::shared_ptr<Element> elem) {
 		using Map = decltype(lot_elements);
+		assert(elem->elem_lot == nullptr && "An element can only belong to one lot");
+		elem->elem_lot = this;
+		elem->elem_boundsValid = false;
 		auto ins = lot_elements.insert(Map::value_type(
 			lot_parent->grid_elemIdGen->generate(),
 			std::move(elem) ));
+		setModified();
 		return std::pair<ElementId, std::shared_ptr<Element>&>(ins.first->first, ins.first->second);
 	}
 
 
 	void Lot::destroyElement(ElementId id) {
-		#ifndef NDEBUG
-			auto removed =
-		#endif
-		lot_elements.erase(id);
-		#ifndef NDEBUG
-			assert(removed == 1);
-		#endif
+		auto found = lot_elements.find(id);
+		assert(found != lot_elements.end());
+		if(found == lot_elements.end()) [[unlikely]] return;
+		found->second->elem_lot = nullptr;
+		lot_elements.erase(found);
 		lot_parent->grid_elemIdGen->recycle(id);
+		setModified();
 	}
 
 
@@ -93,6 +123,7 @@ inline namespace ui {
 		auto* rp = new BasicGrid(info, this, rowSizes, columnSizes); // `unique_ptr` would complain about the inaccessible constructor
 		auto  srp = std::shared_ptr<BasicGrid>(rp);
 		lot_child = srp;
+		lot_child->invalidateLayout();
 		return srp;
 	}
 
@@ -101,17 +132,41 @@ inline namespace ui {
 		auto* rp = new List(info, this, direction, elemSize, subelemSizes); // `unique_ptr` would complain about the inaccessible constructor
 		auto  srp = std::shared_ptr<List>(rp);
 		lot_child = srp;
+		lot_child->invalidateLayout();
 		return srp;
 	}
 
 
 	void Lot::setChildGrid(std::shared_ptr<Grid> container) {
 		lot_child = std::move(container);
+		if(lot_child) lot_child->invalidateLayout(); // The grid's lots may have cached bounds from elsewhere
+		else          lot_parent->setModified();
 	}
 
 
 	void Lot::removeChildGrid() {
 		lot_child = nullptr;
+		lot_parent->setModified();
+	}
+
+
+	void Lot::setModified() noexcept {
+		lot_isModified = true;
+		lot_parent->setModified();
+	}
+
+
+	void Lot::invalidateLayout() noexcept {
+		lot_invalidateSubtree();
+		lot_parent->setModified();
+	}
+
+
+	void Lot::lot_invalidateSubtree() noexcept {
+		lot_boundsValid = false;
+		lot_isModified  = true;
+		for(auto& elem : lot_elements) elem.second->elem_boundsValid = false;
+		if(lot_child) lot_child->grid_invalidateSubtree();
 	}
 
 
@@ -148,6 +203,29 @@ inline namespace ui {
 	}
 
 
+	void Grid::invalidateLayout() noexcept {
+		grid_invalidateSubtree();
+		setModified();
+	}
+
+
+	void Grid::grid_invalidateSubtree() noexcept {
+		grid_isModified = true;
+		for(auto& lot : grid_lots) lot.second->lot_invalidateSubtree();
+	}
+
+
+	void Grid::grid_resetModifiedSubtree() noexcept {
+		// Modifications propagate upwards, so unmodified grids only contain unmodified lots
+		if(! grid_isModified) return;
+		grid_isModified = false;
+		for(auto& lot : grid_lots) {
+			lot.second->lot_isModified = false;
+			if(lot.second->lot_child) lot.second->lot_child->grid_resetModifiedSubtree();
+		}
+	}
+
+
 	RelativeBounds Grid::grid_getRegionRelativeBounds(GridPosition tl, GridPosition br) const noexcept {
 		RelativeBounds r;
 
@@ -183,6 +261,7 @@ inline namespace ui {
 		basic_grid_rowSizes = std::make_unique_for_overwrite<float[]>(rows.size());
 		memcpy(basic_grid_rowSizes.get(), rows.begin(), rows.size() * sizeof(float));
 		basic_grid_size.rows = rows.size();
+		if(grid_parent != nullptr) invalidateLayout();
 	}
 
 
@@ -190,6 +269,7 @@ inline namespace ui {
 		basic_grid_colSizes = std::make_unique_for_overwrite<float[]>(cols.size());
 		memcpy(basic_grid_colSizes.get(), cols.begin(), cols.size() * sizeof(float));
 		basic_grid_size.columns = cols.size();
+		if(grid_parent != nullptr) invalidateLayout();
 	}
 
 
@@ -234,6 +314,8 @@ inline namespace ui {
 	void List::setSubelementSizes(init_list<float> sizes) {
 		list_subelemSizes = std::make_unique_for_overwrite<float[]>(sizes.size());
 		memcpy(list_subelemSizes.get(), sizes.begin(), sizes.size() * sizeof(float));
+		list_subelemCount = sizes.size();
+		invalidateLayout();
 	}
 
 
@@ -313,6 +395,19 @@ inline namespace ui {
 
 	void Canvas::setBounds(ComputedBounds bounds) noexcept {
 		canvas_bounds = bounds;
+		invalidateLayout();
+	}
+
+
+	void Canvas::invalidateLayout() noexcept {
+		canvas_lot->lot_boundsValid = false;
+		canvas_grid->invalidateLayout();
+	}
+
+
+	void Canvas::resetModified() noexcept {
+		canvas_lot->lot_isModified = false;
+		canvas_grid->grid_resetModifiedSubtree();
 	}
 
 }}
@@ -195,6 +195,8 @@ inline namespace ui {
 
 	class Element {
 	public:
+		friend Lot; // Lot tracks which elements it owns
+
 		// DOCUMENTATION HINT:
 		// if `ui_elem_prepareForDraw` returns `eDefer` for an element, the caller must ensure that it's called for the
 		// same element again, but only after calling the same function for all other (relevant) elements exactly once -
@@ -205,6 +207,34 @@ inline namespace ui {
 		virtual ComputedBounds ui_elem_getBounds(const Lot&) const noexcept = 0;
 		virtual PrepareState   ui_elem_prepareForDraw(LotId, Lot&, unsigned repeatCount, DrawContext&) = 0;
 		virtual void           ui_elem_draw(LotId, Lot&, DrawContext&) = 0;
+
+		/// \brief Returns the element's bounds, only calling `ui_elem_getBounds`
+		///        after the element or the layout of its lot changed.
+		///
+		ComputedBounds getBounds(const Lot&) const noexcept;
+
+		/// \brief Marks the element as modified: its lot is prepared and drawn
+		///        again, and the element's bounds are recomputed.
+		///
+		/// Elements are expected to call this function whenever they change
+		/// in a way that affects how they are drawn.
+		///
+		void setModified() noexcept;
+
+		Lot* lot() const noexcept { return elem_lot; }
+
+	private:
+		Lot* elem_lot = nullptr;
+		mutable ComputedBounds elem_bounds;
+		mutable bool           elem_boundsValid = false;
+	};
+
+
+	/// \brief Data that a renderer derives from a lot, and keeps for as long as the lot lives.
+	///
+	class LotRenderData {
+	public:
+		virtual ~LotRenderData() = default;
 	};
 
 
@@ -217,14 +247,15 @@ inline namespace ui {
 	class Lot {
 	public:
 		friend Canvas; // `Canvas` creates a special "loopback" lot
+		friend Grid; // Grids invalidate the layout of their lots
 
 		Lot(Grid* parentGrid, GridPosition gridOffset, GridSize size);
 
 		const LotPadding& padding() const noexcept { return lot_padding; }
-		void              padding(const LotPadding& v) noexcept { lot_padding = v; }
-		void              padding(float left, float top, float right, float bottom) noexcept { lot_padding = { left, top, right, bottom }; }
+		void              padding(const LotPadding& v) noexcept { lot_padding = v; invalidateLayout(); }
+		void              padding(float left, float top, float right, float bottom) noexcept { padding(LotPadding { left, top, right, bottom }); }
 		const glm::mat3& transform() const noexcept { return lot_transform; }
-		void             transform(const glm::mat3& v) noexcept { lot_transform = v; }
+		void             transform(const glm::mat3& v) noexcept { lot_transform = v; invalidateLayout(); }
 
 		void           setSize(GridSize) noexcept;
 		RelativeSize   getTileSize(GridPosition) const noexcept;
@@ -246,9 +277,26 @@ inline namespace ui {
 		bool     hasChildGrid() const noexcept { return bool(lot_child); }
 		void  removeChildGrid();
 
+		/// \brief Whether the lot's own elements changed since the last `Canvas::resetModified()` call.
+		///
+		/// Modifying a lot also marks its ancestor grids as modified.
+		///
+		bool isModified() const noexcept { return lot_isModified; }
+		void setModified() noexcept;
+
+		/// \brief Forgets the cached bounds of the lot and of everything it contains,
+		///        and marks all of it as modified.
+		///
+		void invalidateLayout() noexcept;
+
+		LotRenderData* renderData() const noexcept { return lot_renderData.get(); }
+		void           renderData(std::unique_ptr<LotRenderData> v) noexcept { lot_renderData = std::move(v); }
+
 	private:
 		Lot(Grid* parentGrid, Region* parentRegion, GridPosition gridOffset, GridSize size);
 
+		void lot_invalidateSubtree() noexcept;
+
 		using SptrElement = std::shared_ptr<Element>;
 		using SptrGrid = std::shared_ptr<Grid>;
 		std::unordered_map<ElementId, SptrElement> lot_elements;
@@ -259,6 +307,10 @@ inline namespace ui {
 		Grid*        lot_parent;
 		Region*      lot_parentRegion;
 		SptrGrid     lot_child;
+		std::unique_ptr<LotRenderData> lot_renderData;
+		mutable ComputedBounds lot_bounds;
+		mutable bool           lot_boundsValid;
+		bool                   lot_isModified;
 	};
 
 
@@ -288,10 +340,18 @@ inline namespace ui {
 		auto parentLot() const noexcept { return grid_parent; }
 		auto parentLot()       noexcept { return grid_parent; }
 
+		/// \brief Whether anything in the grid changed since the last `Canvas::resetModified()` call.
+		///
 		bool isModified() const noexcept { return grid_isModified; }
 		void setModified() noexcept;
 		void resetModified() noexcept { grid_isModified = false; }
 
+		/// \brief Forgets the cached bounds of every lot in the grid, and marks all of them as modified.
+		///
+		/// Called whenever the sizes of the grid's tiles change.
+		///
+		void invalidateLayout() noexcept;
+
 		virtual RelativeBounds grid_getRegionRelativeBounds(GridPosition, GridPosition) const noexcept;
 
 		virtual GridSize       grid_gridSize() const noexcept = 0;
@@ -308,6 +368,9 @@ inline namespace ui {
 		LotId grid_genId() noexcept { return grid_lotIdGen->generate(); }
 		LotId grid_recycleId() noexcept { return grid_lotIdGen->generate(); }
 
+		void grid_invalidateSubtree() noexcept;
+		void grid_resetModifiedSubtree() noexcept;
+
 		std::shared_ptr<idgen::IdGenerator<LotId>> grid_lotIdGen;
 		std::shared_ptr<idgen::IdGenerator<ElementId>> grid_elemIdGen;
 		std::unordered_map<LotId, std::shared_ptr<Lot>> grid_lots;
@@ -362,7 +425,7 @@ inline namespace ui {
 
 		List(List&&) = delete;
 
-		void setElementSize(float elemSize) noexcept { list_elemSize = elemSize; }
+		void setElementSize(float elemSize) noexcept { list_elemSize = elemSize; invalidateLayout(); }
 		void setSubelementSizes(init_list<float>);
 		auto getElementSize()     const noexcept { return list_elemSize; }
 		auto getSubelementSizes() const noexcept { return std::span<float, std::dynamic_extent>(list_subelemSizes.get(), list_subelemCount); }
@@ -390,6 +453,13 @@ inline namespace ui {
 
 		void setBounds(ComputedBounds) noexcept;
 
+		/// \brief Forgets every cached bound, and marks the whole UI as modified.
+		///
+		/// Needed when something that the elements depend on changes
+		/// outside of the UI, such as the size of the surface it is drawn on.
+		///
+		void invalidateLayout() noexcept;
+
 		auto lots() noexcept { return canvas_grid->lots(); }
 		auto createLot(GridPosition offset, GridSize size) { return canvas_grid->createLot(offset, size); }
 		void destroyLot(LotId id) { canvas_grid->destroyLot(id); }
@@ -397,10 +467,13 @@ inline namespace ui {
 
 		bool isModified() const noexcept { return canvas_grid->isModified(); }
 		void setModified() noexcept { canvas_grid->setModified(); }
-		void resetModified() noexcept { canvas_grid->resetModified(); }
 
-		void setRowSizes(init_list<float> s) { canvas_grid->setRowSizes(s); canvas_lot->lot_size.rows = s.size(); }
-		void setColumnSizes(init_list<float> s) { canvas_grid->setColumnSizes(s); canvas_lot->lot_size.columns = s.size(); }
+		/// \brief Marks every lot and grid as unmodified, after the UI was drawn.
+		///
+		void resetModified() noexcept;
+
+		void setRowSizes(init_list<float> s) { canvas_grid->setRowSizes(s); canvas_lot->lot_size.rows = s.size(); invalidateLayout(); }
+		void setColumnSizes(init_list<float> s) { canvas_grid->setColumnSizes(s); canvas_lot->lot_size.columns = s.size(); invalidateLayout(); }
 		auto getRowSizes()    const noexcept { return canvas_grid->getRowSizes(); }
 		auto getColumnSizes() const noexcept { return canvas_grid->getColumnSizes(); }
 
@@ -414,6 +487,37 @@ inline namespace ui {
 		ComputedBounds canvas_bounds;
 	};
 
+
+	namespace ui_impl {
+
+		template <bool onlyModified, typename Fn>
+		void visitLotTree(LotId id, Lot& lot, Fn& fn) {
+			if(! onlyModified || lot.isModified()) fn(id, lot);
+			if(! lot.hasChildGrid()) return;
+			auto& child = *lot.childGrid();
+			if(onlyModified && ! child.isModified()) return;
+			for(auto& sub : child.lots()) visitLotTree<onlyModified>(sub.first, *sub.second, fn);
+		}
+
+	}
+
+
+	/// \brief Visits every lot of the canvas, each lot before the ones it contains.
+	///
+	template <typename Fn>
+	void visitLots(Canvas& canvas, Fn&& fn) {
+		for(auto& lot : canvas.lots()) ui_impl::visitLotTree<false>(lot.first, *lot.second, fn);
+	}
+
+
+	/// \brief Visits the modified lots of the canvas, without descending into unmodified grids.
+	///
+	template <typename Fn>
+	void visitModifiedLots(Canvas& canvas, Fn&& fn) {
+		if(! canvas.isModified()) return;
+		for(auto& lot : canvas.lots()) ui_impl::visitLotTree<true>(lot.first, *lot.second, fn);
+	}
+
 }}
 
 
@@ -1,5 +1,8 @@
 #include "input.hpp"
 
+#include <SDL2/SDL_version.h>
+
+#include <algorithm>
 #include <cassert>
 
 
@@ -18,6 +21,96 @@ inline namespace input {
 				(c == '_');
 		}
 
+
+		// Events that may be merged into an earlier event of the same stream have a non-zero key
+		constexpr uint_fast64_t noEventStream = 0;
+		uint_fast64_t eventStream(const SDL_Event& ev) noexcept {
+			auto key = [&](uint32_t which, uint8_t axis) { return (uint_fast64_t(ev.type) << 40) | (uint_fast64_t(which) << 8) | axis; };
+			switch(ev.type) {
+				default: return noEventStream;
+				case SDL_EventType::SDL_MOUSEMOTION:          return key(ev.motion.which, 0);
+				case SDL_EventType::SDL_MOUSEWHEEL:           return key(ev.wheel.which, uint8_t(ev.wheel.direction));
+				case SDL_EventType::SDL_JOYAXISMOTION:        return key(uint32_t(ev.jaxis.which), ev.jaxis.axis);
+				case SDL_EventType::SDL_CONTROLLERAXISMOTION: return key(uint32_t(ev.caxis.which), ev.caxis.axis);
+			}
+		}
+
+
+		// Keeps the latest state of the stream, and accumulates relative values
+		void mergeEvent(SDL_Event& dst, const SDL_Event& src) noexcept {
+			assert(dst.type == src.type);
+			switch(src.type) {
+				default: assert(false && "`eventStream` should have filtered this out"); break;
+				case SDL_EventType::SDL_MOUSEMOTION: {
+					auto xrel = dst.motion.xrel + src.motion.xrel;
+					auto yrel = dst.motion.yrel + src.motion.yrel;
+					dst = src;
+					dst.motion.xrel = xrel;
+					dst.motion.yrel = yrel;
+				} break;
+				case SDL_EventType::SDL_MOUSEWHEEL: {
+					auto x = dst.wheel.x + src.wheel.x;
+					auto y = dst.wheel.y + src.wheel.y;
+					#if SDL_VERSION_ATLEAST(2, 0, 18)
+						auto preciseX = dst.wheel.preciseX + src.wheel.preciseX;
+						auto preciseY = dst.wheel.preciseY + src.wheel.preciseY;
+					#endif
+					dst = src;
+					dst.wheel.x = x;
+					dst.wheel.y = y;
+					#if SDL_VERSION_ATLEAST(2, 0, 18)
+						dst.wheel.preciseX = preciseX;
+						dst.wheel.preciseY = preciseY;
+					#endif
+				} break;
+				case SDL_EventType::SDL_JOYAXISMOTION:
+				case SDL_EventType::SDL_CONTROLLERAXISMOTION:
+					dst = src; break;
+			}
+		}
+
+	}
+
+
+	void InputEventBatch::push(const SDL_Event& ev) {
+		auto stream = eventStream(ev);
+		if(stream == noEventStream) {
+			mOpenStreams.clear();
+			mEvents.push_back(ev);
+			return;
+		}
+		for(auto& open : mOpenStreams) {
+			if(open.first == stream) {
+				mergeEvent(mEvents[open.second], ev);
+				++ mCoalescedCount;
+				return;
+			}
+		}
+		mOpenStreams.push_back({ stream, uint32_t(mEvents.size()) });
+		mEvents.push_back(ev);
+	}
+
+
+	size_t InputEventBatch::drainSdlEvents() {
+		constexpr int chunkSize = 64;
+		SDL_Event chunk[chunkSize];
+		size_t r = 0;
+		SDL_PumpEvents();
+		while(true) {
+			int count = SDL_PeepEvents(chunk, chunkSize, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+			if(count <= 0) break;
+			for(int i = 0; i < count; ++i) push(chunk[i]);
+			r += size_t(count);
+			if(count < chunkSize) break;
+		}
+		return r;
+	}
+
+
+	void InputEventBatch::clear() noexcept {
+		mEvents.clear();
+		mOpenStreams.clear();
+		mCoalescedCount = 0;
 	}
 
 
@@ -121,6 +214,7 @@ inline namespace input {
 		auto found = mCommands.find(id);
 		assert(found != mCommands.end());
 		mCommands.erase(found);
+		mFlatBindingsValid = false;
 	}
 
 
@@ -133,6 +227,7 @@ inline namespace input {
 			if(foundCmd == mCommands.end()) [[unlikely]] return;
 			auto& ins = mBindings[binding.key];
 			ins.insert_or_assign(std::move(binding.context), id);
+			mFlatBindingsValid = false;
 		}
 	}
 
@@ -159,23 +254,19 @@ inline namespace input {
 			constexpr auto nullTuple = R { nullptr, nullCmd, nullptr, false };
 			auto mapKeyWithChange    = InputMapKey { event.input.id, (event.input.state | InputState::eActive) | InputState::eDeactivated };
 			auto mapKeyWithoutChange = InputMapKey { event.input.id, (event.input.state | InputState::eActive) & (~InputState::eDeactivated) };
+			auto find = [&](const InputMapKey& key) -> const FlatBinding* {
+				auto found = std::lower_bound(mFlatBindings.begin(), mFlatBindings.end(), key, [](const FlatBinding& b, const InputMapKey& k) { return b.key < k; });
+				return (found != mFlatBindings.end() && found->key == key)? &*found : nullptr;
+			};
 			bool boundOnChange = true;
-			auto bindingFound = mBindings.find(mapKeyWithChange);
-			if(bindingFound == mBindings.end()) {
-				bindingFound = mBindings.find(mapKeyWithoutChange);
+			auto binding = find(mapKeyWithChange);
+			if(binding == nullptr) {
+				binding = find(mapKeyWithoutChange);
 				boundOnChange = false;
-				if(bindingFound == mBindings.end()) return nullTuple;
-			}
-			auto ctxFound = bindingFound->second.lower_bound(ctxStr);
-			if(ctxFound == bindingFound->second.end()) return nullTuple;
-			auto ctxCmp = Context::compareContexts(ctxStr, ctxFound->first.string());
-			if(ctxCmp == Context::Cmp::eSame || ctxCmp == Context::Cmp::eLeftIsSubcontext) {
-				auto cmdFound = mCommands.find(ctxFound->second);
-				assert(cmdFound != mCommands.end());
-				return R { &ctxFound->first, ctxFound->second, &cmdFound->second, boundOnChange };
-			} else {
-				return nullTuple;
+				if(binding == nullptr) return nullTuple;
 			}
+			if(binding->context == nullptr) return nullTuple;
+			return R { binding->context, binding->command, binding->callback, boundOnChange };
 		};
 		auto activateCmd = [&]() {
 			auto [ctx, cmdId, cmdPtrPtr, boundOnChange] = findCmd();
@@ -215,6 +306,8 @@ inline namespace input {
 				event.input.id = inputIdFromSdlMouse(sdlEv.button.button); break;
 		}
 
+		resolveBindings(ctxStr);
+
 		if(event.input.state != eAnalog) {
 			bool active = inputStateCurrentlyActive(event.input.state);
 			if(active) activateCmd();
@@ -223,6 +316,32 @@ inline namespace input {
 	}
 
 
+	void InputManager::feedSdlEvents(std::string_view ctxStr, std::span<const SDL_Event> events) {
+		for(auto& ev : events) feedSdlEvent(ctxStr, ev);
+	}
+
+
+	void InputManager::resolveBindings(std::string_view ctxStr) {
+		if(mFlatBindingsValid && mFlatContext == ctxStr) [[likely]] return;
+		mFlatBindings.clear();
+		mFlatBindings.reserve(mBindings.size());
+		for(auto& binding : mBindings) {
+			auto& flat = mFlatBindings.emplace_back(FlatBinding { binding.first, nullptr, idgen::invalidId<CommandId>(), nullptr });
+			auto ctxFound = binding.second.lower_bound(ctxStr);
+			if(ctxFound == binding.second.end()) continue;
+			auto ctxCmp = Context::compareContexts(ctxStr, ctxFound->first.string());
+			if(ctxCmp != Context::Cmp::eSame && ctxCmp != Context::Cmp::eLeftIsSubcontext) continue;
+			auto cmdFound = mCommands.find(ctxFound->second);
+			assert(cmdFound != mCommands.end());
+			if(cmdFound == mCommands.end()) [[unlikely]] continue;
+			flat = { binding.first, &ctxFound->first, ctxFound->second, &cmdFound->second };
+		}
+		std::sort(mFlatBindings.begin(), mFlatBindings.end(), [](const FlatBinding& l, const FlatBinding& r) { return l.key < r.key; });
+		mFlatContext = ctxStr;
+		mFlatBindingsValid = true;
+	}
+
+
 	bool InputManager::isCommandActive(CommandId id) noexcept {
 		assert(mCommands.contains(id));
 		return mActiveCommands.contains(id);
@@ -239,7 +358,8 @@ inline namespace input {
 
 	void InputManager::clear() noexcept {
 		mBindings.clear();
-		mBindingsCache.clear();
+		mFlatBindings.clear();
+		mFlatBindingsValid = false;
 		mCommands.clear();
 		mActiveCommands.clear();
 		mCommandIdGen = { };
@@ -11,6 +11,7 @@
 #include <memory>
 #include <deque>
 #include <ranges>
+#include <span>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -169,6 +170,41 @@ inline namespace input {
 	};
 
 
+	/// \brief A frame's worth of SDL events, in a contiguous buffer.
+	///
+	/// Motion and axis events are redundant when followed by another of
+	/// the same stream (mouse, wheel, or joystick/controller axis) before
+	/// any event that is not part of a stream: such events are merged into
+	/// the earlier one, which keeps the latest position or value and the
+	/// accumulated relative motion.
+	/// Streams are independent, so events of different streams do not end
+	/// each other and may be reordered among themselves (motion, wheel,
+	/// motion becomes motion, wheel); any other event ends every stream,
+	/// which keeps the order of stream events relative to every other event.
+	///
+	class InputEventBatch {
+	public:
+		/// \brief Appends an event, or merges it into a previous one.
+		///
+		void push(const SDL_Event&);
+
+		/// \brief Moves every pending SDL event into the batch.
+		/// \returns The number of events taken from SDL, before coalescing.
+		///
+		size_t drainSdlEvents();
+
+		std::span<const SDL_Event> events() const noexcept { return mEvents; }
+		size_t coalescedCount() const noexcept { return mCoalescedCount; }
+
+		void clear() noexcept;
+
+	private:
+		std::vector<SDL_Event> mEvents;
+		std::vector<std::pair<uint_fast64_t, uint32_t>> mOpenStreams; // Stream key, index of the stream's last event
+		size_t mCoalescedCount = 0;
+	};
+
+
 	class InputManager {
 	public:
 		CommandId addCommand    (CommandCallback::Ptr); /// \note The command shared pointer may be null, in which case nothing is done
@@ -178,6 +214,7 @@ inline namespace input {
 		CommandId bindNewCommand(Binding b, CommandCallback::Ptr cb);
 
 		void feedSdlEvent(std::string_view context, const SDL_Event&);
+		void feedSdlEvents(std::string_view context, std::span<const SDL_Event>);
 
 		bool isCommandActive(CommandId) noexcept;
 		void setCommandActive(CommandId, bool value) noexcept;
@@ -186,17 +223,35 @@ inline namespace input {
 		void clear() noexcept;
 
 	private:
+		/// \brief A binding, resolved for the context of the flat binding table.
+		///
+		/// The pointers refer to nodes of `mBindings` and `mCommands`,
+		/// and are null if the context has no command for the key.
+		///
+		struct FlatBinding {
+			InputMapKey           key;
+			const Context*        context;
+			CommandId             command;
+			CommandCallback::Ptr* callback;
+		};
+
 		#define UMAP_ std::unordered_map
 		#define MAP_  std::map
-		using ContextMap   = MAP_ <Context,          CommandId, std::less<>>;
-		using ContextCache = UMAP_<std::string_view, CommandId>;
-		UMAP_<InputMapKey, ContextMap,   InputMapHash> mBindings;
-		UMAP_<InputMapKey, ContextCache, InputMapHash> mBindingsCache;
-		UMAP_<CommandId,   CommandCallback::Ptr>       mCommands;
-		UMAP_<CommandId,   InputMapKey>                mActiveCommands;
+		using ContextMap = MAP_ <Context, CommandId, std::less<>>;
+		UMAP_<InputMapKey, ContextMap, InputMapHash> mBindings;
+		UMAP_<CommandId,   CommandCallback::Ptr>     mCommands;
+		UMAP_<CommandId,   InputMapKey>              mActiveCommands;
+		std::vector<FlatBinding> mFlatBindings; // Sorted by key, for `mFlatContext`
+		std::string              mFlatContext;
+		bool                     mFlatBindingsValid = false;
 		idgen::IdGenerator<CommandId> mCommandIdGen;
 		#undef MAP_
 		#undef UMAP_
+
+		/// \brief Rebuilds the flat binding table, unless it is already
+		///        up to date for the given context.
+		///
+		void resolveBindings(std::string_view context);
 	};
 
 }}
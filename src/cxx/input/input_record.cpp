@@ -0,0 +1,173 @@
+#include "input_record.hpp"
+
+#include <cassert>
+#include <charconv>
+#include <fstream>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace input {
+
+	namespace {
+
+		constexpr std::string_view recordingHeaderV1 = "skengine-input 1";
+		constexpr std::string_view recordingHeader   = "skengine-input 2";
+		constexpr std::string_view tickCountField    = "ticks";
+
+
+		bool isRecordedType(const SDL_Event& ev) noexcept {
+			switch(ev.type) {
+				default: return false;
+				case SDL_EventType::SDL_WINDOWEVENT: return ev.window.event == SDL_WINDOWEVENT_FOCUS_LOST;
+				case SDL_EventType::SDL_KEYDOWN:
+				case SDL_EventType::SDL_KEYUP:
+				case SDL_EventType::SDL_MOUSEBUTTONDOWN:
+				case SDL_EventType::SDL_MOUSEBUTTONUP: return true;
+			}
+		}
+
+
+		// Consumes a space-separated field
+		std::string_view nextField(std::string_view& line) noexcept {
+			auto end = line.find(' ');
+			auto r = line.substr(0, end);
+			line = (end == std::string_view::npos)? std::string_view() : line.substr(end + 1);
+			return r;
+		}
+
+
+		template <typename T>
+		bool parseField(std::string_view& line, T& dst) noexcept {
+			auto field = nextField(line);
+			auto res = std::from_chars(field.data(), field.data() + field.size(), dst);
+			return (! field.empty()) && (res.ec == std::errc()) && (res.ptr == field.data() + field.size());
+		}
+
+	}
+
+
+	SDL_Event RecordedInput::toSdlEvent() const noexcept {
+		SDL_Event r = { };
+		r.type = sdlType;
+		switch(sdlType) {
+			default: break;
+			case SDL_EventType::SDL_WINDOWEVENT:
+				r.window.event = uint8_t(code); break;
+			case SDL_EventType::SDL_KEYDOWN:
+			case SDL_EventType::SDL_KEYUP:
+				r.key.state = (sdlType == SDL_KEYDOWN)? SDL_PRESSED : SDL_RELEASED;
+				r.key.repeat = repeat;
+				r.key.keysym.sym = SDL_Keycode(code); break;
+			case SDL_EventType::SDL_MOUSEBUTTONDOWN:
+			case SDL_EventType::SDL_MOUSEBUTTONUP:
+				r.button.state = (sdlType == SDL_MOUSEBUTTONDOWN)? SDL_PRESSED : SDL_RELEASED;
+				r.button.button = uint8_t(code); break;
+		}
+		return r;
+	}
+
+
+	void InputRecorder::feedSdlEvent(InputManager& im, uint_fast64_t tick, std::string_view ctx, const SDL_Event& ev) {
+		record(tick, ctx, ev);
+		im.feedSdlEvent(ctx, ev);
+	}
+
+
+	void InputRecorder::record(uint_fast64_t tick, std::string_view ctx, const SDL_Event& ev) {
+		assert(isValidContextString(ctx));
+		assert(mEvents.empty() || mEvents.back().tick <= tick);
+		if(! isRecordedType(ev)) return;
+		auto& rec = mEvents.emplace_back(RecordedInput { tick, ev.type, 0, false, std::string(ctx) });
+		switch(ev.type) {
+			default: assert(false && "`isRecordedType` should have filtered this out"); break;
+			case SDL_EventType::SDL_WINDOWEVENT:     rec.code = ev.window.event; break;
+			case SDL_EventType::SDL_KEYDOWN:
+			case SDL_EventType::SDL_KEYUP:           rec.code = ev.key.keysym.sym; rec.repeat = ev.key.repeat != 0; break;
+			case SDL_EventType::SDL_MOUSEBUTTONDOWN:
+			case SDL_EventType::SDL_MOUSEBUTTONUP:   rec.code = ev.button.button; break;
+		}
+	}
+
+
+	uint_fast64_t InputRecorder::tickCount() const noexcept {
+		if(mEvents.empty()) return mTickCount;
+		return std::max(mTickCount, mEvents.back().tick + 1);
+	}
+
+
+	bool InputRecorder::save(const char* path) const {
+		auto out = std::ofstream(path, std::ios::out | std::ios::trunc);
+		if(! out) return false;
+		out << recordingHeader << '\n';
+		out << tickCountField << ' ' << tickCount() << '\n';
+		for(auto& ev : mEvents) {
+			out << ev.tick << ' ' << ev.sdlType << ' ' << ev.code << ' ' << (ev.repeat? 1 : 0) << ' ' << ev.context << '\n';
+		}
+		out.flush();
+		return bool(out);
+	}
+
+
+	InputReplay InputReplay::fromFile(const char* path) {
+		using enum BadInputRecording::Reason;
+		auto in = std::ifstream(path);
+		if(! in) throw BadInputRecording { eCannotOpen, 0 };
+
+		InputReplay r;
+		std::string lineStr;
+		size_t lineNo = 1;
+		if(! std::getline(in, lineStr)) throw BadInputRecording { eBadHeader, lineNo };
+		bool hasTickCount;
+		if     (lineStr == recordingHeader)   hasTickCount = true;
+		else if(lineStr == recordingHeaderV1) hasTickCount = false;
+		else throw BadInputRecording { eBadHeader, lineNo };
+
+		if(hasTickCount) {
+			++ lineNo;
+			if(! std::getline(in, lineStr)) throw BadInputRecording { eBadTickCount, lineNo };
+			auto line = std::string_view(lineStr);
+			bool ok =
+				(nextField(line) == tickCountField) &&
+				parseField(line, r.mTickCount) &&
+				line.empty();
+			if(! ok) throw BadInputRecording { eBadTickCount, lineNo };
+		}
+
+		while(std::getline(in, lineStr)) {
+			++ lineNo;
+			if(lineStr.empty()) continue;
+			auto line = std::string_view(lineStr);
+			RecordedInput ev;
+			unsigned repeat;
+			bool ok =
+				parseField(line, ev.tick) &&
+				parseField(line, ev.sdlType) &&
+				parseField(line, ev.code) &&
+				parseField(line, repeat) &&
+				(repeat <= 1);
+			if(! ok) throw BadInputRecording { eBadLine, lineNo };
+			ev.repeat = repeat != 0;
+			ev.context = std::string(nextField(line));
+			if(! line.empty() || ! isValidContextString(ev.context)) throw BadInputRecording { eBadContext, lineNo };
+			if(! r.mEvents.empty() && r.mEvents.back().tick > ev.tick) throw BadInputRecording { eTickOrder, lineNo };
+			r.mEvents.push_back(std::move(ev));
+		}
+
+		if(! r.mEvents.empty()) {
+			if(! hasTickCount) r.mTickCount = r.mEvents.back().tick + 1;
+			else if(r.mTickCount <= r.mEvents.back().tick) throw BadInputRecording { eBadTickCount, lineNo };
+		}
+		return r;
+	}
+
+
+	void InputReplay::feed(InputManager& im, uint_fast64_t tick) {
+		while(mCursor < mEvents.size() && mEvents[mCursor].tick <= tick) {
+			auto& ev = mEvents[mCursor];
+			im.feedSdlEvent(ev.context, ev.toSdlEvent());
+			++ mCursor;
+		}
+	}
+
+}}
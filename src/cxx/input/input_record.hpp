@@ -0,0 +1,131 @@
+#pragma once
+
+#include "input.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+
+
+
+/// \file
+///
+/// Recording and replay of the SDL events fed to an InputManager,
+/// for reproducing a session independently of wall-clock time.
+///
+/// Events are tagged with the index of the logic tick they were fed
+/// on; replaying them on the same ticks (see `EnginePreferences::fixed_timestep`)
+/// reproduces the same command activations.
+///
+/// Recordings are text files: a header line "skengine-input 2", a line
+/// `ticks <N>` with the number of ticks of the recorded session,
+/// followed by one line per event with the format
+/// `<tick> <SDL event type> <code> <repeat> <context>`, where the code
+/// is the key symbol, the mouse button or the window event ID.
+/// Version 1 recordings have no tick count, and are assumed to end
+/// with their last event.
+///
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace input {
+
+	struct RecordedInput {
+		uint_fast64_t tick;
+		uint32_t      sdlType;
+		int32_t       code;
+		bool          repeat;
+		std::string   context;
+
+		/// \brief Reconstructs the parts of the SDL event that InputManager reads.
+		///
+		SDL_Event toSdlEvent() const noexcept;
+	};
+
+
+	struct BadInputRecording {
+		enum class Reason : unsigned {
+			eCannotOpen   = 1,
+			eBadHeader    = 2,
+			eBadLine      = 3,
+			eBadContext   = 4,
+			eTickOrder    = 5,
+			eBadTickCount = 6
+		}; using enum Reason;
+		Reason reason;
+		size_t line;
+	};
+
+
+	class InputRecorder {
+	public:
+		InputRecorder(): mTickCount(0) { }
+
+		/// \brief Records the event if InputManager would use it, then feeds it.
+		///
+		void feedSdlEvent(InputManager&, uint_fast64_t tick, std::string_view context, const SDL_Event&);
+
+		/// \brief Records the event if InputManager would use it.
+		///
+		void record(uint_fast64_t tick, std::string_view context, const SDL_Event&);
+
+		/// \brief Records that the session lasted at least `count` ticks,
+		///        including the ones without any event.
+		///
+		void recordTicks(uint_fast64_t count) noexcept { mTickCount = std::max(mTickCount, count); }
+
+		/// \brief Writes the recording to a file.
+		///
+		/// \returns `false` if the file could not be written.
+		///
+		bool save(const char* path) const;
+
+		const auto& events() const noexcept { return mEvents; }
+
+		/// \returns The number of ticks of the session, which is at least one
+		///          more than the tick of the last event.
+		///
+		uint_fast64_t tickCount() const noexcept;
+
+		void clear() noexcept { mEvents.clear(); mTickCount = 0; }
+
+	private:
+		std::vector<RecordedInput> mEvents;
+		uint_fast64_t mTickCount;
+	};
+
+
+	class InputReplay {
+	public:
+		InputReplay(): mTickCount(0), mCursor(0) { }
+
+		/// \brief Loads a recording written by `InputRecorder::save`.
+		///
+		/// \throws BadInputRecording
+		///
+		static InputReplay fromFile(const char* path);
+
+		/// \brief Feeds every recorded event up to (and including) the given tick.
+		///
+		void feed(InputManager&, uint_fast64_t tick);
+
+		bool finished() const noexcept { return mCursor >= mEvents.size(); }
+		uint_fast64_t lastTick() const noexcept { return mEvents.empty()? 0 : mEvents.back().tick; }
+
+		/// \brief The number of ticks of the recorded session, including
+		///        the ones after the last event.
+		///
+		uint_fast64_t tickCount() const noexcept { return mTickCount; }
+
+		const auto& events() const noexcept { return mEvents; }
+
+	private:
+		std::vector<RecordedInput> mEvents;
+		uint_fast64_t mTickCount;
+		size_t mCursor;
+	};
+
+}}
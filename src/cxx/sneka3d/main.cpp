@@ -1,6 +1,9 @@
 #include <numbers>
 #include <random>
 #include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <algorithm>
 
 #include <engine/types.hpp>
 
@@ -10,16 +13,20 @@
 #include <engine-util/basic_asset_cache.hpp>
 #include <engine-util/basic_render_process.hpp>
 #include <engine-util/gui_manager.hpp>
-#include <engine-util/animation.inl.hpp>
+#include <engine-util/animation_tracks.hpp>
 
 #include <input/input.hpp>
+#include <input/input_record.hpp>
 
 #include <posixfio_tl.hpp>
 
 #include <vk-util/error.hpp>
 
+#include <zone-profiler/zone_profiler.hpp>
+
 extern "C" {
 	#include <sys/stat.h>
+	#include <sys/resource.h>
 }
 
 #include "worldgen.inl.hpp"
@@ -36,48 +43,6 @@ namespace sneka {
 
 
 
-	namespace anim::target {
-
-		template <typename T>
-		class Linear : public ske::Animation<T> {
-		public:
-			T beginning;
-			T dir;
-
-			Linear(ske::AnimationValue<T>& v, T beginning, T dir):
-				ske::Animation<T>(v),
-				beginning(beginning),
-				dir(dir)
-			{ }
-
-			void animation_setProgress(T& dst, ske::anim_x_t x) noexcept override {
-				dst = beginning + (dir * x);
-			}
-		};
-
-
-		template <typename T>
-		class EaseOut : public ske::Animation<T> {
-		public:
-			T beginning;
-			T dir;
-
-			EaseOut(ske::AnimationValue<T>& v, T beginning, T dir):
-				ske::Animation<T>(v),
-				beginning(beginning),
-				dir(dir)
-			{ }
-
-			void animation_setProgress(T& dst, ske::anim_x_t x) noexcept override {
-				constexpr auto f = [](ske::anim_x_t x) { auto x2 = x*x; return (ske::anim_x_t(2) * x) - x2; };
-				dst = beginning + (dir * float(f(x)));
-			}
-		};
-
-	}
-
-
-
 	template <std::integral T>
 	float discreteObjRotation(T x) {
 		constexpr auto quarter = std::numbers::pi_v<float> / 2.0f;
@@ -122,7 +87,7 @@ namespace sneka {
 
 	class Loop : public ske::LoopInterface {
 	public:
-		static constexpr const char* worldFilename = "world.wrd";
+		static constexpr const char* defaultWorldFilename = "world.wrd";
 		static constexpr float cameraDistance = 2.5f;
 		static constexpr float cameraPitch = 0.75f;
 		static constexpr float speedBaseDefault = 2.0f;
@@ -138,9 +103,12 @@ namespace sneka {
 
 		struct CallbackSharedState {
 			std::mutex animMutex;
-			ske::AnimationSet<glm::vec3> playerMovementAnim;
-			ske::AnimationValue<glm::vec3> playerHeadPos;
-			ske::AnimationValue<glm::vec3> camRotation;
+			ske::AnimTrack<glm::vec3> playerMovementAnim;
+			glm::vec3*    playerHeadPos; // The pending position of the player head object, written by the movement animation
+			glm::vec3*    playerHeadDir;
+			glm::vec3     detachedHeadPos; // Used when there is no player head object
+			glm::vec3     detachedHeadDir;
+			glm::vec3     camRotation;
 			ske::AnimId   cameraAnimId;
 			signed char   lastDir[2];
 			unsigned char enableCulling;
@@ -151,7 +119,10 @@ namespace sneka {
 			bool          requestMapRegen;
 			void init() {
 				playerMovementAnim = { };
-				playerHeadPos      = { };
+				detachedHeadPos    = { };
+				detachedHeadDir    = { };
+				playerHeadPos      = &detachedHeadPos;
+				playerHeadDir      = &detachedHeadDir;
 				camRotation        = { };
 				cameraAnimId       = idgen::invalidId<ske::AnimId>();
 				lastDir[0]         =  0;
@@ -197,6 +168,16 @@ namespace sneka {
 		float macrotickFrequency;
 		World world;
 		Vec2<int64_t> worldOffset;
+		std::string worldFilename;
+		std::unique_ptr<ske::InputRecorder> inputRecorder; // Only set when recording the session
+		std::unique_ptr<ske::InputReplay>   inputReplay;   // Only set when replaying a session
+		ske::InputEventBatch inputEvents;
+		std::vector<float> frameTimes; // In seconds, only collected when `collectFrameTimes` is set
+		std::chrono::steady_clock::time_point lastFrameTime;
+		uint_fast64_t tickIndex;
+		std::minstd_rand::result_type seedCounter;
+		bool deterministic; // Use fixed RNG seeds and never overwrite the world file, so that sessions can be replayed
+		bool collectFrameTimes;
 
 
 		auto gridToWorld(Vec2<int64_t> g, float height) {
@@ -210,6 +191,12 @@ namespace sneka {
 		}
 
 
+		auto rngSeed() {
+			if(deterministic) return ++ seedCounter;
+			return std::minstd_rand::result_type(std::chrono::steady_clock::now().time_since_epoch().count());
+		}
+
+
 		void createWorld(const char* worldFilename, Vec2<uint64_t> startPos = { UINT64_MAX, UINT64_MAX }) {
 			auto sideLengthEnvvar = sneka::getenv("SNEKA_NEWWORLD_SIDE");
 			auto* sideLengthEnvvarEnd = sideLengthEnvvar.data() + sideLengthEnvvar.size();
@@ -220,9 +207,7 @@ namespace sneka {
 			if(startPos.x == UINT64_MAX && startPos.y == UINT64_MAX) {
 				startPos.x = sideLength / uint64_t(2);
 				startPos.y = sideLength / uint64_t(2); }
-			#define NOW_ std::chrono::steady_clock::now().time_since_epoch().count()
-				generateWorld(logger, world, nullptr, startPos, std::minstd_rand(NOW_));
-			#undef NOW_
+			generateWorld(logger, world, nullptr, startPos, rngSeed());
 			world.entryPointX() = startPos.x;
 			world.entryPointY() = startPos.y;
 			world.setSceneryModel("world1-scenery.fma");
@@ -233,13 +218,12 @@ namespace sneka {
 			world.addObjObstacleModel("chair-bundle.fma");
 			world.addObjWallModel("crate-wall.fma");
 			world.addObjWallModel("prism-wall.fma");
-			world.toFile(worldFilename);
+			if(! deterministic) world.toFile(worldFilename); // A replayed session must start from the same world as the recorded one
 		}
 
 
 		void updateViewPosRot(tickreg::delta_t deltaAvg) {
 			auto& wr = * rproc->worldRenderer();
-			auto& plrOs = rproc->getObjectStorage(OBJSTG_PLAYER_IDX);
 
 			constexpr auto biasedAverage = [](float src, float target, float bias) -> float {
 				return (src + (target * bias)) / (1.0f + bias); };
@@ -250,9 +234,7 @@ namespace sneka {
 
 				auto& state = *sharedState;
 				auto inputLock = std::unique_lock(inputManMutex);
-				auto viewRot = state.camRotation.getValue();
-				const auto playerHeadPos = state.playerHeadPos.getValue();
-				const auto playerHeadDir = [&]() { auto r = plrOs.getObject(this->playerHead); return (r.has_value()? r.value()->direction_ypr : glm::vec3 { }); } ();
+				auto viewRot = state.camRotation;
 				auto deltaSupertick = deltaAvg * macrotickFrequency;
 
 				{
@@ -269,38 +251,40 @@ namespace sneka {
 					glm::mat4 viewRotTransf = glm::mat4(1.0f);
 					viewRotTransf = glm::rotate(viewRotTransf, +viewRot.x, { 0.0f, 1.0f, 0.0f });
 					viewRotTransf = glm::rotate(viewRotTransf, -viewRot.y, { 1.0f, 0.0f, 0.0f });
-					auto viewPos = playerHeadPos;
+					auto viewPos = *state.playerHeadPos;
 					auto viewPosOff4 = viewRotTransf * glm::vec4 { 0.0f, 0.0f, -cameraDistance, 1.0f };
 					viewPos -= glm::vec3(viewPosOff4);
 					wr.setViewPosition(viewPos);
 					wr.setViewRotation(viewRot);
 				}
 
-				if(this->playerHead != idgen::invalidId<ske::ObjectId>()) {
-					auto newHeadRot = playerHeadDir;
-					newHeadRot.x = biasedAverage(newHeadRot.x, state.headYawTarget, headRotBias * deltaAvg);
-					{ auto mod = plrOs.modifyObject(this->playerHead);
-						mod->position_xyz = playerHeadPos;
-						mod->direction_ypr = newHeadRot; }
+				{ // The player head is animated, its transform is written in place
+					auto& headDir = *state.playerHeadDir;
+					headDir.x = biasedAverage(headDir.x, state.headYawTarget, headRotBias * deltaAvg);
 				}
 			}
 		}
 
 
-		Loop(ske::Engine& e, ske::Logger loggerMv, decltype(assetCache) assetCache, decltype(rproc) rproc):
+		Loop(ske::Engine& e, ske::Logger loggerMv, decltype(assetCache) assetCache, decltype(rproc) rproc, std::string worldFilenameMv, bool deterministic):
 			engine(&e),
 			logger(std::move(loggerMv)),
 			assetCache(std::move(assetCache)),
 			rproc(std::move(rproc)),
 			sharedState(std::make_shared<CallbackSharedState>()),
-			macrotickFrequency(1.0f)
+			macrotickFrequency(1.0f),
+			worldFilename(std::move(worldFilenameMv)),
+			tickIndex(0),
+			seedCounter(0),
+			deterministic(deterministic),
+			collectFrameTimes(false)
 		{
 			using enum GridObjectClass;
 			const auto onError = [&]() {
-				createWorld(worldFilename);
+				createWorld(worldFilename.c_str());
 			};
 			try {
-				world = World::fromFile(worldFilename);
+				world = World::fromFile(worldFilename.c_str());
 			} catch(posixfio::Errcode& e) {
 				if(e.errcode == ENOENT) logger.error("World \"{}\" does not exist, creating a new one", worldFilename);
 				else                    logger.error("Failed to read world file \"{}\" (errno {}), creating a new one", worldFilename, e.errcode);
@@ -326,6 +310,7 @@ namespace sneka {
 			ske::WorldRenderer& wr = * rproc->worldRenderer();
 			sharedState->init();
 			pointObjects.clear();
+			lastFrameTime = { }; // The time between runs is not a frame time
 
 			{ // Input management
 				auto inputLock = std::unique_lock(inputManMutex);
@@ -360,7 +345,7 @@ namespace sneka {
 					CONSTEXPR_ auto pi2 = 2.0f * pi;
 					#undef CONSTEXPR_
 					signed char lastDir0 = state.lastDir[0];
-					auto cam = state.camRotation.getValue();
+					auto cam = state.camRotation;
 					state.lastDir[0] = -dir * state.lastDir[1];
 					state.lastDir[1] = +dir * lastDir0;
 					auto yawTarget = std::atan2f(state.lastDir[0], -state.lastDir[1]);
@@ -370,11 +355,11 @@ namespace sneka {
 					{
 						auto lock = std::unique_lock(state.animMutex);
 						state.playerMovementAnim.interrupt(state.cameraAnimId);
-						state.cameraAnimId = state.playerMovementAnim.start<anim::target::EaseOut<glm::vec3>>(
+						state.cameraAnimId = state.playerMovementAnim.start(
 							ske::AnimEndAction::eClampThenPause,
-							state.camRotation,
-							cam,
-							glm::vec3 { yawDiff, 0.0f, 0.0f } );
+							cam, cam + glm::vec3 { yawDiff, 0.0f, 0.0f },
+							1.0f, ske::AnimCurve::easeOut(),
+							&state.camRotation );
 					}
 				};
 				bindKeyPressCb(SDLK_a, "general", [sharedState](auto&, auto) { rotate(*sharedState, +1); });
@@ -435,7 +420,7 @@ namespace sneka {
 				float yGridCenter = - (float(world.height() - 1.0f) / 2.0f);
 				worldOffset = { int64_t(xGridCenter), int64_t(yGridCenter) };
 				auto& tc = engine->getTransferContext();
-				auto rng = std::minstd_rand(std::chrono::system_clock::now().time_since_epoch().count());
+				auto rng = std::minstd_rand(rngSeed());
 				auto newObject = ske::ObjectStorage::NewObject {
 					{ }, { }, { }, { 1.0f, 1.0f, 1.0f }, false };
 				auto tryCreate = [&](ske::ObjectStorage& os, ske::ModelId mdl) {
@@ -492,11 +477,15 @@ namespace sneka {
 				newObject.direction_ypr = { };
 				newObject.scale_xyz = { 1.0f, 1.0f, 1.0f };
 				playerHead = tryCreate(playerOs, mdlIds.playerHead);
+				if(auto head = playerOs.animateObject(playerHead)) {
+					sharedState->playerHeadPos = &head->position_xyz;
+					sharedState->playerHeadDir = &head->direction_ypr;
+				}
 				newObject.position_xyz = { };
 				newObject.direction_ypr = { };
 				newObject.scale_xyz = { 1.0f, 1.0f, 1.0f };
 				tryCreate(sceneryOs, mdlIds.scenery);
-				sharedState->camRotation.setValue({ 0.0f, cameraPitch, 0.0f });
+				sharedState->camRotation = { 0.0f, cameraPitch, 0.0f };
 				wr.setAmbientLight({ 0.1f, 0.1f, 0.1f });
 				light0 = wr.createPointLight(ske::WorldRenderer::NewPointLight {
 					.position = { },
@@ -523,6 +512,13 @@ namespace sneka {
 
 		void loop_end() noexcept override {
 			inputMan.clear();
+			{
+				auto lock = std::unique_lock(sharedState->animMutex);
+				sharedState->playerMovementAnim = { };
+				sharedState->playerHeadPos = &sharedState->detachedHeadPos;
+				sharedState->playerHeadDir = &sharedState->detachedHeadDir;
+			}
+			if(playerHead != idgen::invalidId<ske::ObjectId>()) rproc->getObjectStorage(OBJSTG_PLAYER_IDX).stopAnimatingObject(playerHead);
 		}
 
 
@@ -539,10 +535,19 @@ namespace sneka {
 				bool triggered;
 			} resizeEvent = { 0, 0, false };
 
-			SDL_Event ev;
-			while(1 == SDL_PollEvent(&ev)) {
+			if(inputReplay) {
 				auto inputLock = std::unique_lock(inputManMutex);
-				inputMan.feedSdlEvent("general", ev);
+				inputReplay->feed(inputMan, tickIndex);
+			}
+
+			inputEvents.clear();
+			inputEvents.drainSdlEvents();
+			{
+				auto inputLock = std::unique_lock(inputManMutex);
+				if(inputRecorder) for(auto& ev : inputEvents.events()) inputRecorder->feedSdlEvent(inputMan, tickIndex, "general", ev);
+				else if(! inputReplay) inputMan.feedSdlEvents("general", inputEvents.events()); // Live input would make a replay diverge
+			}
+			for(auto& ev : inputEvents.events()) {
 				if(ev.type == SDL_WINDOWEVENT) {
 					if(ev.window.event == SDL_WINDOWEVENT_RESIZED) {
 						resizeEvent = { ev.window.data1, ev.window.data2, true };
@@ -550,6 +555,9 @@ namespace sneka {
 				}
 			}
 
+			++ tickIndex;
+			if(inputRecorder) inputRecorder->recordTicks(tickIndex);
+
 			if(resizeEvent.triggered) ca->setPresentExtent(VkExtent2D { uint32_t(resizeEvent.width), uint32_t(resizeEvent.height) });
 
 			{
@@ -558,7 +566,7 @@ namespace sneka {
 				{ // This block is not macrotick-related, but it's a potential race condition nevertheless
 					if(shState.requestMapRegen) {
 						shState.requestMapRegen = false;
-						createWorld(worldFilename);
+						createWorld(worldFilename.c_str());
 						shState.quitReason = QuitReason::eGameEnd;
 					}
 				}
@@ -581,7 +589,7 @@ namespace sneka {
 					if     (shState.speedBoost > 0.0f) shState.speedBoost = std::max(0.0f, shState.speedBoost - speedBoostDecayDn);
 					else if(shState.speedBoost < 0.0f) shState.speedBoost = std::min(0.0f, shState.speedBoost + speedBoostDecayUp);
 
-					const auto worldPos = shState.playerHeadPos.getValue();
+					const auto worldPos = *shState.playerHeadPos;
 					const auto gridPos = worldToGrid(worldPos);
 					auto xApprox = std::floorf(worldPos.x + 0.5f);
 					auto zApprox = std::floorf(worldPos.z + 0.5f);
@@ -596,7 +604,7 @@ namespace sneka {
 							pointObjects.erase(obj);
 							if(pointObjects.empty()) {
 								logger.info("Conglaturations! Shine get!");
-								createWorld(worldFilename);
+								createWorld(worldFilename.c_str());
 								shState.quitReason = QuitReason::eGameEnd;
 							}
 						}
@@ -612,11 +620,11 @@ namespace sneka {
 						{
 							auto lock = std::unique_lock(shState.animMutex);
 							shState.playerMovementAnim.interrupt(playerHeadPosAnimId);
-							playerHeadPosAnimId = shState.playerMovementAnim.start<anim::target::Linear<glm::vec3>>(
+							playerHeadPosAnimId = shState.playerMovementAnim.start(
 								ske::AnimEndAction::ePause,
-								shState.playerHeadPos,
-								worldPos,
-								glm::vec3 { xDiff, 0.0f, zDiff } );
+								worldPos, worldPos + glm::vec3 { xDiff, 0.0f, zDiff },
+								1.0f, ske::AnimCurve::linear(),
+								shState.playerHeadPos );
 						}
 					}
 				}
@@ -650,11 +658,33 @@ namespace sneka {
 		virtual void loop_async_postRender(ske::ConcurrentAccess, tickreg::delta_t deltaAvg, tickreg::delta_t deltaCurrent) {
 			(void) deltaAvg;
 			(void) deltaCurrent;
-			;
+
+			if(collectFrameTimes) {
+				// Wall-clock time, since the deltas are constant with a fixed timestep
+				auto now = std::chrono::steady_clock::now();
+				if(lastFrameTime != decltype(lastFrameTime) { }) frameTimes.push_back(std::chrono::duration<float>(now - lastFrameTime).count());
+				lastFrameTime = now;
+			}
 		}
 
 	};
 
+
+	void logBenchReport(ske::Logger& logger, std::vector<float> frameTimes) {
+		if(frameTimes.empty()) { logger.warn("No frame times were collected"); return; }
+		std::sort(frameTimes.begin(), frameTimes.end());
+		auto percentile = [&](size_t p) { // Nearest-rank method
+			size_t rank = ((frameTimes.size() * p) + 99) / 100;
+			return 1000.0f * frameTimes[std::max<size_t>(rank, 1) - 1];
+		};
+		logger.info("Frame times over {} frames: p50 {:.3f}ms, p95 {:.3f}ms, p99 {:.3f}ms, max {:.3f}ms",
+			frameTimes.size(), percentile(50), percentile(95), percentile(99), 1000.0f * frameTimes.back() );
+
+		struct rusage usage;
+		if(0 == getrusage(RUSAGE_SELF, &usage)) logger.info("Peak resident memory: {} KiB", usage.ru_maxrss);
+		else                                    logger.warn("Failed to query the peak resident memory (errno {})", errno);
+	}
+
 }
 
 
@@ -662,11 +692,9 @@ namespace sneka {
 int main(int argn, char** argv) {
 	using namespace std::string_view_literals;
 	using namespace ske;
-	(void) argn;
-	(void) argv;
 
 	auto logger = Logger(
-		std::make_shared<posixfio::OutputBuffer>(STDOUT_FILENO, 512),
+		std::make_shared<LoggerSink>(sflog::OverflowPolicy::eDropCounted, LoggerSink::defaultRingCapacity, STDOUT_FILENO, 512),
 		sflog::Level::eInfo,
 		sflog::OptionBit::eUseAnsiSgr | sflog::OptionBit::eAutoFlush,
 		"["sv, SKENGINE_NAME_CSTR " Sneka : "sv, ""sv, "]  "sv );
@@ -675,7 +703,95 @@ int main(int argn, char** argv) {
 		logger.setLevel(sflog::Level::eDebug);
 	#endif
 
-	const auto enginePrefs = []() {
+	#ifdef SKENGINE_ZONE_PROFILING
+		auto traceWriter = TraceWriter("sneka3d-trace.json");
+		if(! traceWriter.isOpen()) logger.warn("Failed to open the zone profiler trace file");
+	#endif
+
+	#ifdef SNEKA3D_BENCH
+		constexpr bool benchBuild = true;
+		constexpr auto usage = "Usage: {} --replay FILE [--world FILE] [--headless FRAMES [--dump-frame N]...]";
+	#else
+		constexpr bool benchBuild = false;
+		constexpr auto usage = "Usage: {} [--world FILE] [--record FILE | --replay FILE] [--fixed-timestep] [--headless FRAMES [--dump-frame N]...]";
+	#endif
+
+	struct Options {
+		std::vector<uint_fast64_t> dumpFrames;
+		std::string worldFile;
+		std::string recordFile;
+		std::string replayFile;
+		uint_fast64_t frameLimit;
+		bool headless;
+		bool fixedTimestep;
+	} options = { { }, sneka::Loop::defaultWorldFilename, { }, { }, 0, false, benchBuild };
+
+	{ // Parse the command line: `--headless FRAMES` runs offscreen for a fixed number of frames, `--dump-frame N` writes frame N to a PNG file
+		auto parseNumber = [&](int& i, uint_fast64_t& dst) {
+			if(++ i >= argn) return false;
+			auto arg = std::string_view(argv[i]);
+			auto res = std::from_chars(arg.data(), arg.data() + arg.size(), dst);
+			return (res.ec == std::errc()) && (res.ptr == arg.data() + arg.size());
+		};
+		auto parseString = [&](int& i, std::string& dst) {
+			if(++ i >= argn) return false;
+			dst = argv[i];
+			return ! dst.empty();
+		};
+		for(int i = 1; i < argn; ++i) {
+			auto arg = std::string_view(argv[i]);
+			bool ok;
+			if(arg == "--headless"sv) {
+				options.headless = true;
+				ok = parseNumber(i, options.frameLimit);
+			} else if(arg == "--dump-frame"sv) {
+				ok = parseNumber(i, options.dumpFrames.emplace_back());
+			} else if(arg == "--world"sv) {
+				ok = parseString(i, options.worldFile);
+			} else if(arg == "--record"sv && ! benchBuild) {
+				ok = parseString(i, options.recordFile);
+			} else if(arg == "--replay"sv) {
+				ok = parseString(i, options.replayFile);
+			} else if(arg == "--fixed-timestep"sv && ! benchBuild) {
+				options.fixedTimestep = true;
+				ok = true;
+			} else {
+				ok = false;
+			}
+			if(! ok) {
+				logger.error(usage, argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+		bool badCombination =
+			(! options.recordFile.empty() && ! options.replayFile.empty()) ||
+			(benchBuild && options.replayFile.empty());
+		if(badCombination) {
+			logger.error(usage, argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::unique_ptr<InputReplay> inputReplay;
+	if(! options.replayFile.empty()) {
+		try {
+			inputReplay = std::make_unique<InputReplay>(InputReplay::fromFile(options.replayFile.c_str()));
+		} catch(BadInputRecording& e) {
+			logger.error("Failed to load input recording \"{}\" at line {}: reason {}", options.replayFile, e.line, unsigned(e.reason));
+			return EXIT_FAILURE;
+		}
+		logger.info("Replaying {} input events over {} ticks", inputReplay->events().size(), inputReplay->tickCount());
+		if(benchBuild && ! options.headless) {
+			options.headless   = true;
+			options.frameLimit = inputReplay->tickCount(); // With a fixed timestep, one frame per tick
+		}
+	}
+
+	// Replays are only reproducible if the recorded session also ran with a fixed timestep
+	bool deterministic = ! (options.recordFile.empty() && options.replayFile.empty());
+	options.fixedTimestep = options.fixedTimestep || deterministic;
+
+	const auto enginePrefs = [&]() {
 		auto prefs = EnginePreferences::default_prefs;
 		prefs.init_present_extent = { 700, 500 };
 		prefs.max_render_extent   = { 0, 0 };
@@ -684,6 +800,14 @@ int main(int argn, char** argv) {
 		prefs.target_tickrate     = 60.0f;
 		prefs.wait_for_gframe     = false;
 		prefs.framerate_samples   = 4;
+		if(options.headless) { // Benchmark runs should not be throttled by the frame rate
+			prefs.headless             = true;
+			prefs.headless_frame_limit = options.frameLimit;
+			prefs.headless_dump_frames = options.dumpFrames;
+			prefs.headless_dump_prefix = "sneka3d-frame-";
+			prefs.target_framerate     = 1000.0f;
+		}
+		prefs.fixed_timestep = options.fixedTimestep;
 		return prefs;
 	} ();
 
@@ -700,6 +824,7 @@ int main(int argn, char** argv) {
 
 	const auto uiRdrParams = []() {
 		auto params = UiRenderer::RdrParams::defaultParams;
+		params.fontSdfBaseSize = 48;
 		return params;
 	} ();
 
@@ -718,8 +843,11 @@ int main(int argn, char** argv) {
 			std::move(shader_cache),
 			logger );
 
-		auto loop = sneka::Loop(engine, logger, asset_cache, basic_rprocess);
+		auto loop = sneka::Loop(engine, logger, asset_cache, basic_rprocess, options.worldFile, deterministic);
 		sneka::Loop::QuitReason loopQuitReason;
+		loop.inputReplay = std::move(inputReplay);
+		loop.collectFrameTimes = benchBuild;
+		if(! options.recordFile.empty()) loop.inputRecorder = std::make_unique<InputRecorder>();
 
 		do {
 			engine.run(loop, basic_rprocess);
@@ -727,6 +855,12 @@ int main(int argn, char** argv) {
 			loop.reset();
 		} while(loopQuitReason == sneka::Loop::QuitReason::eGameEnd);
 
+		if(loop.inputRecorder) {
+			if(loop.inputRecorder->save(options.recordFile.c_str())) logger.info("Recorded {} input events over {} ticks to \"{}\"", loop.inputRecorder->events().size(), loop.inputRecorder->tickCount(), options.recordFile);
+			else                                                      logger.error("Failed to write the input recording to \"{}\"", options.recordFile);
+		}
+		if(loop.collectFrameTimes) sneka::logBenchReport(logger, std::move(loop.frameTimes));
+
 		BasicRenderProcess::destroy(*basic_rprocess, engine.getTransferContext());
 
 		logger.info("Successfully exiting the program.");
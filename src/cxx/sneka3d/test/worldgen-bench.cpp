@@ -0,0 +1,73 @@
+// Generates worlds of a few sizes on an increasing number of threads, and
+// reports how long each took; the world generated on N threads is the same
+// as the one generated on 1 thread, which is checked along the way.
+
+#include "../worldgen.inl.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+
+using sneka::World;
+using Pos = sneka::Vec2<uint64_t>;
+
+constexpr uint64_t sideLengths[] = { 53, 257, 1025, 2049 };
+constexpr unsigned repetitions   = 5;
+constexpr uint64_t seed          = 1;
+
+
+
+struct NullLogger {
+	template <typename... Args> void info (fmt::format_string<Args...>, Args&&...) { }
+	template <typename... Args> void error(fmt::format_string<Args...>, Args&&...) { }
+};
+
+
+bool sameTiles(const World& l, const World& r) {
+	for(uint64_t y = 0; y < l.height(); ++y)
+	for(uint64_t x = 0; x < l.width();  ++x) if(l.tile(x, y) != r.tile(x, y)) return false;
+	return true;
+}
+
+
+double msPerWorld(uint64_t side, unsigned threadCount, World& dst) {
+	using clock = std::chrono::steady_clock;
+	Pos startPos = { side / 2, side / 2 };
+	double best = 0.0;
+	for(unsigned i = 0; i < repetitions; ++i) {
+		dst = World::initEmpty(side, side);
+		auto beg = clock::now();
+		sneka::generateWorld(NullLogger(), dst, nullptr, startPos, seed, threadCount);
+		auto end = clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - beg).count();
+		if(i == 0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+
+int main() {
+	std::vector<unsigned> threadCounts = { 1 };
+	unsigned hwThreads = std::max(1u, std::thread::hardware_concurrency());
+	for(unsigned t = 2; t < hwThreads; t *= 2) threadCounts.push_back(t);
+	if(hwThreads > 1) threadCounts.push_back(hwThreads);
+
+	fmt::print("Best of {} generations\n", repetitions);
+	fmt::print("{:>10} | {:>8} | {:>10} | {:>8} | {:>9}\n", "size", "threads", "ms", "speedup", "identical");
+	for(auto side : sideLengths) {
+		World ref;
+		double refMs = msPerWorld(side, 1, ref);
+		for(auto threadCount : threadCounts) {
+			World cmp;
+			double ms = (threadCount == 1)? refMs : msPerWorld(side, threadCount, cmp);
+			bool identical = (threadCount == 1) || sameTiles(ref, cmp);
+			fmt::print(
+				"{:>10} | {:>8} | {:>10.2f} | {:>8.2f} | {:>9}\n",
+				fmt::format("{}x{}", side, side), threadCount, ms, refMs / ms, identical? "yes" : "NO" );
+		}
+	}
+}
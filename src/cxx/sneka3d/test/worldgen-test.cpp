@@ -0,0 +1,153 @@
+#include "../worldgen.inl.hpp"
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+
+
+using sneka::World;
+using sneka::GridObjectClass;
+using sneka::BasicUset;
+using Pos = sneka::Vec2<uint64_t>;
+
+constexpr unsigned threadCounts[] = { 2, 3, 8 };
+
+
+
+struct NullLogger {
+	template <typename... Args> void info (fmt::format_string<Args...>, Args&&...) { }
+	template <typename... Args> void error(fmt::format_string<Args...>, Args&&...) { }
+};
+
+
+struct Generated {
+	World world;
+	BasicUset<Pos> ptObjs;
+	Pos junction;
+};
+
+
+Generated generate(uint64_t w, uint64_t h, Pos startPos, uint64_t seed, unsigned threadCount) {
+	Generated r = { World::initEmpty(w, h), { }, { } };
+	r.junction = sneka::generateWorld(NullLogger(), r.world, &r.ptObjs, startPos, seed, threadCount);
+	return r;
+}
+
+
+bool sameTiles(const World& l, const World& r) {
+	if(l.width() != r.width() || l.height() != r.height()) return false;
+	for(uint64_t y = 0; y < l.height(); ++y)
+	for(uint64_t x = 0; x < l.width();  ++x) if(l.tile(x, y) != r.tile(x, y)) return false;
+	return true;
+}
+
+
+bool passable(GridObjectClass c) { return c != GridObjectClass::eWall && c != GridObjectClass::eObstacle; }
+
+
+std::vector<bool> reachableFrom(const World& world, Pos startPos) {
+	const auto w = world.width();
+	const auto h = world.height();
+	std::vector<bool> r(w * h, false);
+	std::deque<Pos> queue = { startPos };
+	r[(startPos.y * w) + startPos.x] = true;
+	auto visit = [&](uint64_t x, uint64_t y) {
+		if(x >= w || y >= h || r[(y * w) + x] || ! passable(world.tile(x, y))) return;
+		r[(y * w) + x] = true;
+		queue.push_back({ x, y });
+	};
+	while(! queue.empty()) {
+		auto p = queue.front();
+		queue.pop_front();
+		visit(p.x - 1, p.y); visit(p.x + 1, p.y);
+		visit(p.x, p.y - 1); visit(p.x, p.y + 1);
+	}
+	return r;
+}
+
+
+bool testThreadCounts() {
+	struct Case { uint64_t w, h; Pos startPos; uint64_t seed; };
+	constexpr Case cases[] = {
+		{  53,  53, {  26,  26 }, 1 },
+		{ 200, 130, {  10, 120 }, 2 },
+		{ 257, 257, { 128, 128 }, 3 },
+		{ 301,  64, { 300,   0 }, 4 } };
+	bool fail = false;
+
+	for(auto& c : cases) {
+		auto ref = generate(c.w, c.h, c.startPos, c.seed, 1);
+		for(unsigned threadCount : threadCounts) {
+			auto cmp = generate(c.w, c.h, c.startPos, c.seed, threadCount);
+			if(! sameTiles(ref.world, cmp.world) || ref.ptObjs != cmp.ptObjs || ref.junction != cmp.junction) {
+				fmt::print(stderr, "{}x{} world (seed {}) differs between 1 and {} threads\n", c.w, c.h, c.seed, threadCount);
+				fail = true;
+			}
+		}
+		auto other = generate(c.w, c.h, c.startPos, c.seed + 100, 1);
+		if(sameTiles(ref.world, other.world)) {
+			fmt::print(stderr, "{}x{} world is the same for seeds {} and {}\n", c.w, c.h, c.seed, c.seed + 100);
+			fail = true;
+		}
+	}
+
+	fmt::print("World generation across thread counts: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testConnectivity() {
+	using namespace sneka::worldgen_impl;
+	bool fail = false;
+
+	for(uint64_t seed = 1; seed <= 400; ++seed) {
+		uint64_t w = 100 + (((seed % 8) + 1) * 37);
+		uint64_t h = 90  + (((seed % 8) + 1) * 23);
+		Pos startPos = { (seed * 13) % w, (seed * 29) % h };
+		auto gen = generate(w, h, startPos, seed, 0);
+		auto reachable = reachableFrom(gen.world, startPos);
+		auto grid = ChunkGrid::of(gen.world);
+		if(grid.chunkCount() < 2) fail = true;
+
+		// Every chunk's seams, and every point object, can be reached from the start
+		for(uint64_t cy = 0; cy < grid.countY; ++cy)
+		for(uint64_t cx = 0; cx < grid.countX; ++cx)
+		for(auto& p : grid.seamTiles(seed, cx, cy)) {
+			if(! reachable[(p.y * w) + p.x]) {
+				fmt::print(stderr, "Seed {}: seam tile ({}, {}) of chunk ({}, {}) is unreachable\n", seed, p.x, p.y, cx, cy);
+				fail = true;
+			}
+		}
+		for(auto& p : gen.ptObjs) {
+			if(gen.world.tile(p.x, p.y) != GridObjectClass::ePoint || ! reachable[(p.y * w) + p.x]) {
+				fmt::print(stderr, "Seed {}: point object ({}, {}) is unreachable\n", seed, p.x, p.y);
+				fail = true;
+			}
+		}
+		if(! reachable[(gen.junction.y * w) + gen.junction.x]) {
+			fmt::print(stderr, "Seed {}: returned junction ({}, {}) is unreachable\n", seed, gen.junction.x, gen.junction.y);
+			fail = true;
+		}
+	}
+
+	fmt::print("World generation connectivity: {}\n", fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testThreadCounts()  ? fail : true;
+		fail = testConnectivity()  ? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <random>
 #include <bit>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 #include <concepts>
+#include <vector>
 
 #include <timer.tpp>
 
@@ -13,8 +20,25 @@
 
 
 
+/// \file
+///
+/// Worlds are generated in square chunks of `worldgenChunkSide` tiles,
+/// each from its own counter-based RNG stream, so that they can be generated
+/// in any order (and in parallel) with the same result.
+///
+/// Every chunk is connected to each of its neighbors through a seam: a pair
+/// of adjacent tiles, one on either side of the shared edge, whose position is
+/// a function of the world seed and the edge alone; both chunks carve a path
+/// to their own side of it.
+///
+
+
+
 namespace sneka {
 
+	constexpr uint64_t worldgenChunkSide = 64;
+
+
 	template <std::integral T, typename Rng, T minBits = std::numeric_limits<T>::digits>
 	inline auto random(Rng rng) {
 		constexpr T resBits = std::bit_width(Rng::max() - Rng::min());
@@ -28,161 +52,391 @@ namespace sneka {
 	}
 
 
-	template <typename Logger, typename Rng>
-	void generateWorldNoise(Logger&& logger, World& dst, Rng&& rng) {
-		util::SteadyTimer<> timer;
-		auto genFloat = [&](auto min, auto max) { return std::uniform_real_distribution<float>(min, max)(rng); };
-		auto genUint  = [&](auto min, auto max) { return std::uniform_int_distribution<unsigned>(min, max)(rng); };
-		auto w = dst.width();
-		auto h = dst.height();
-		assert(w * h > 0);
-		float objCountRel = genFloat(0.4f, 0.95f);
-		float wallToObstRatio = genFloat(0.5f, 2.0f);
-		unsigned objCount = float(w * h) * objCountRel;
-		const unsigned attemptLimitInit = objCount * (1.0f / (1.0f - objCountRel));
-		unsigned attemptLimit = attemptLimitInit;
-		for(unsigned i = 1; i <= objCount; ++ i) {
-			assert(i > 0 /* `--i` needs to be possible */);
-			auto xGen = genUint(0, w-1);
-			auto yGen = genUint(0, h-1);
-			auto& tile = dst.tile(xGen, yGen);
-			if(tile != GridObjectClass::eNoObject) {
-				-- attemptLimit;
-				-- i;
-				if(attemptLimit <= 0) {
-					logger.error(
-						"Generating world noise: giving up after {} placement failures",
-						attemptLimitInit );
-					return;
-				}
-			} else {
-				float typeRoll = genFloat(0.0f, 1.0f + wallToObstRatio);
-				if(typeRoll > 1.0f) tile = GridObjectClass::eWall;
-				else                tile = GridObjectClass::eObstacle;
-			}
-		}
-		logger.info(
-			"Generated world noise in {}+{} attempts [{}ms]",
-			objCount,
-			attemptLimitInit - attemptLimit,
-			float(timer.count<std::micro>()) / 1000.0f );
+	constexpr uint64_t splitmix64(uint64_t x) noexcept {
+		x += 0x9e3779b97f4a7c15;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		return x ^ (x >> 31);
 	}
 
+	template <std::same_as<uint64_t>... T>
+	constexpr uint64_t worldgenKey(uint64_t seed, T... values) noexcept {
+		((seed = splitmix64(seed ^ values)), ...);
+		return seed;
+	}
+
+
+	/// \brief A counter-based random bit generator: the N-th number of a
+	///        stream is a hash of the stream's key and N.
+	///
+	class WorldgenRng {
+	public:
+		using result_type = uint64_t;
+
+		explicit WorldgenRng(uint64_t key): rng_key(key), rng_counter(0) { }
+
+		static constexpr result_type min() noexcept { return 0; }
+		static constexpr result_type max() noexcept { return UINT64_MAX; }
+
+		result_type operator()() noexcept { return splitmix64(rng_key ^ splitmix64(rng_counter ++)); }
+
+	private:
+		uint64_t rng_key;
+		uint64_t rng_counter;
+	};
+
+
+	namespace worldgen_impl {
+
+		enum class Stream : uint64_t {
+			eWorldParams = 1,
+			eChunkNoise  = 2,
+			eChunkPaths  = 3,
+			eSeamH       = 4,
+			eSeamV       = 5
+		};
+
 
-	template <typename Logger, typename Rng>
-	auto generateWorld(Logger&& logger, World& dst, BasicUset<Vec2<uint64_t>>* dstPtObjs, Vec2<uint64_t> startPos, Rng&& rng) {
 		using ucomp_t = uint64_t;
 		using scomp_t = std::make_signed_t<ucomp_t>;
 		using fcomp_t = long double;
 		using Pos = Vec2<ucomp_t>;
-		const auto w = dst.width();
-		const auto h = dst.height();
-		if(w * h < 2) return Pos { };
-		auto genFloat = [&](auto min, auto max) { return std::uniform_real_distribution<decltype(auto(min))>(min, max)(rng); };
-		auto genInt   = [&](auto min, auto max) { return std::uniform_int_distribution<decltype(auto(min))>(min, max)(rng); };
-		auto rollProb = [&](auto prob) { return (prob > genFloat(decltype(auto(prob))(0.0), 1.0f)); };
-		auto junctionMap        = BasicUmap<ucomp_t, Pos>(16);
-		auto junctionSet        = BasicUset<Pos>(16);
-		auto pointObjCandidates = BasicUset<Pos>(16);
-		junctionMap.max_load_factor(4.0f);
-		junctionSet.max_load_factor(4.0f);
-		fcomp_t widthHeightAvg = fcomp_t(w) + fcomp_t(h) / fcomp_t(2.0);
-		fcomp_t widthHeightAvgSq = widthHeightAvg * widthHeightAvg;
-
-		ucomp_t minPathTiles = genInt(ucomp_t(4), std::min(w, h) / ucomp_t(2));
-		ucomp_t maxPathTiles = genInt(ucomp_t(widthHeightAvgSq / fcomp_t(8)), ucomp_t(widthHeightAvgSq / fcomp_t(3)));
-		fcomp_t tJunctionProb      = genFloat(fcomp_t(  0.3), fcomp_t(0.6)) / ((fcomp_t(minPathTiles) + widthHeightAvg) / fcomp_t(2.0));
-		fcomp_t xJunctionProb      = genFloat(fcomp_t(  0.4), fcomp_t(0.9));
-		fcomp_t targetJunctionProb = genFloat(fcomp_t( 0.05), fcomp_t(0.3));
-		fcomp_t deadEndProb        = genFloat(fcomp_t(0.005), fcomp_t(0.5));
-		fcomp_t diagonalCompBias   = genFloat(fcomp_t(  0.4), fcomp_t(0.6));
-		fcomp_t pointObjProb       = genFloat(fcomp_t( 0.05), fcomp_t(0.2));
-		fcomp_t maxDiagonalDist    = genFloat(glm::sqrt(std::min<fcomp_t>(w, h)), widthHeightAvg);
-
-		auto randomPos = [&]() {
-			return Pos { genInt(ucomp_t(0), w-1), genInt(ucomp_t(0), h-1) };
-		};
-		auto randomPosAround = [&](Vec2<ucomp_t> src, fcomp_t maxDistSq) {
-			auto rx = genFloat(-maxDistSq, +maxDistSq);
-			auto ry = genFloat(-maxDistSq, +maxDistSq);
-			fcomp_t ptLen = glm::sqrt((rx*rx) + (ry*ry));
-			fcomp_t rndDist = genFloat(fcomp_t(2.0), maxDistSq);
-			rndDist /= ptLen;
-			rx *= rndDist; ry *= rndDist;
-			ucomp_t rrx = std::clamp(scomp_t(src.x) + scomp_t(rx), scomp_t(0), scomp_t(w-1));
-			ucomp_t rry = std::clamp(scomp_t(src.y) + scomp_t(ry), scomp_t(0), scomp_t(h-1));
-			return Pos { rrx, rry };
+
+
+		struct Area {
+			Pos begin; // Inclusive
+			Pos end;   // Exclusive
+			ucomp_t width () const noexcept { return end.x - begin.x; }
+			ucomp_t height() const noexcept { return end.y - begin.y; }
+			bool contains(const Pos& p) const noexcept { return p.x >= begin.x && p.x < end.x && p.y >= begin.y && p.y < end.y; }
 		};
 
-		auto randomJunction = [&]() -> auto {
-			assert(! junctionMap.empty() /* Not *necessary*, but it likely results in unreachable path tiles */);
-			if(junctionMap.empty()) [[unlikely]] return randomPos();
-			auto rndIdx = genInt(ucomp_t(0), junctionMap.size() - 1);
-			assert(junctionMap.contains(rndIdx));
-			return junctionMap.find(rndIdx)->second;
+
+		/// \brief Parameters shared by every chunk of a world.
+		///
+		struct WorldParams {
+			float   objCountRel;
+			float   wallToObstRatio;
+			fcomp_t tJunctionProbBase;
+			fcomp_t xJunctionProb;
+			fcomp_t targetJunctionProb;
+			fcomp_t deadEndProb;
+			fcomp_t diagonalCompBias;
+			fcomp_t pointObjProb;
+
+			static WorldParams generate(uint64_t seed) {
+				auto rng = WorldgenRng(worldgenKey(seed, uint64_t(Stream::eWorldParams)));
+				auto genFloat = [&](auto min, auto max) { return std::uniform_real_distribution<decltype(auto(min))>(min, max)(rng); };
+				WorldParams r;
+				r.objCountRel        = genFloat(0.4f, 0.95f);
+				r.wallToObstRatio    = genFloat(0.5f, 2.0f);
+				r.tJunctionProbBase  = genFloat(fcomp_t(  0.3), fcomp_t(0.6));
+				r.xJunctionProb      = genFloat(fcomp_t(  0.4), fcomp_t(0.9));
+				r.targetJunctionProb = genFloat(fcomp_t( 0.05), fcomp_t(0.3));
+				r.deadEndProb        = genFloat(fcomp_t(0.005), fcomp_t(0.5));
+				r.diagonalCompBias   = genFloat(fcomp_t(  0.4), fcomp_t(0.6));
+				r.pointObjProb       = genFloat(fcomp_t( 0.05), fcomp_t(0.2));
+				return r;
+			}
 		};
 
-		auto addJunction = [&](const Pos& p) {
-			junctionMap.insert({ junctionSet.size(), p });
-			junctionSet.insert(p);
+
+		/// \brief How a world is split into chunks.
+		///
+		/// Chunks along an axis differ in size by at most one tile, rather than
+		/// the last one taking the remainder, so that none of them is too
+		/// small for a meaningful path.
+		///
+		struct ChunkGrid {
+			ucomp_t worldWidth;
+			ucomp_t worldHeight;
+			ucomp_t countX;
+			ucomp_t countY;
+
+			static ChunkGrid of(const World& world) noexcept {
+				auto count = [](ucomp_t side) { return std::max<ucomp_t>(1, side / worldgenChunkSide); };
+				return { world.width(), world.height(), count(world.width()), count(world.height()) };
+			}
+
+			ucomp_t chunkCount() const noexcept { return countX * countY; }
+
+			Area area(ucomp_t cx, ucomp_t cy) const noexcept {
+				return Area {
+					{ (cx * worldWidth) / countX,       (cy * worldHeight) / countY },
+					{ ((cx + 1) * worldWidth) / countX, ((cy + 1) * worldHeight) / countY } };
+			}
+
+			Pos chunkOf(const Pos& p) const noexcept {
+				ucomp_t cx = 0; while(cx + 1 < countX && p.x >= area(cx + 1, 0).begin.x) ++ cx;
+				ucomp_t cy = 0; while(cy + 1 < countY && p.y >= area(0, cy + 1).begin.y) ++ cy;
+				return { cx, cy };
+			}
+
+			/// \brief The row of the seam between chunk (cx, cy) and chunk (cx+1, cy).
+			///
+			ucomp_t seamRowH(uint64_t seed, ucomp_t cx, ucomp_t cy) const noexcept {
+				auto a = area(cx, cy);
+				return a.begin.y + (worldgenKey(seed, uint64_t(Stream::eSeamH), cx, cy) % a.height());
+			}
+
+			/// \brief The column of the seam between chunk (cx, cy) and chunk (cx, cy+1).
+			///
+			ucomp_t seamColumnV(uint64_t seed, ucomp_t cx, ucomp_t cy) const noexcept {
+				auto a = area(cx, cy);
+				return a.begin.x + (worldgenKey(seed, uint64_t(Stream::eSeamV), cx, cy) % a.width());
+			}
+
+			/// \brief The tiles of a chunk that its seams end on.
+			///
+			std::vector<Pos> seamTiles(uint64_t seed, ucomp_t cx, ucomp_t cy) const {
+				auto a = area(cx, cy);
+				std::vector<Pos> r;
+				r.reserve(4);
+				if(cx > 0)          r.push_back({ a.begin.x,   seamRowH(seed, cx - 1, cy) });
+				if(cx + 1 < countX) r.push_back({ a.end.x - 1, seamRowH(seed, cx,     cy) });
+				if(cy > 0)          r.push_back({ seamColumnV(seed, cx, cy - 1), a.begin.y   });
+				if(cy + 1 < countY) r.push_back({ seamColumnV(seed, cx, cy),     a.end.y - 1 });
+				return r;
+			}
 		};
 
-		auto carveAxisAligned = [&](Pos curPos, const Pos& endPos, bool vertical, GridObjectClass obj) {
-			// `endPos` is not the idiomatic "end": the interval is [curPos, endPos] instead of [curPos, endPos)
-			auto* curComp = vertical? (&curPos.y) : (&curPos.x);
-			auto* endComp = vertical? (&endPos.y) : (&endPos.x);
-			scomp_t step = (*curComp < *endComp)? +1 : -1;
-			constexpr auto setTile = [](World& dst, BasicUset<Vec2<uint64_t>>* dstPtObjs, uint64_t x, uint64_t y, GridObjectClass obj) {
+
+		inline void generateChunkNoise(World& dst, const Area& area, const WorldParams& params, WorldgenRng rng) {
+			auto genFloat = [&](auto min, auto max) { return std::uniform_real_distribution<float>(min, max)(rng); };
+			for(ucomp_t y = area.begin.y; y < area.end.y; ++y)
+			for(ucomp_t x = area.begin.x; x < area.end.x; ++x) {
+				if(genFloat(0.0f, 1.0f) >= params.objCountRel) continue;
+				float typeRoll = genFloat(0.0f, 1.0f + params.wallToObstRatio);
+				dst.tile(x, y) = (typeRoll > 1.0f)? GridObjectClass::eWall : GridObjectClass::eObstacle;
+			}
+		}
+
+
+		/// \brief Carves random paths through a chunk, starting from
+		///        and connecting all of the given tiles.
+		/// \returns A random junction of the chunk.
+		///
+		inline Pos generateChunkPaths(
+				World& dst, std::vector<Pos>* dstPtObjs,
+				const Area& area, const WorldParams& params, WorldgenRng rng,
+				const std::vector<Pos>& anchors
+		) {
+			assert(! anchors.empty());
+			const auto w = area.width();
+			const auto h = area.height();
+			auto genFloat = [&](auto min, auto max) { return std::uniform_real_distribution<decltype(auto(min))>(min, max)(rng); };
+			auto genInt   = [&](auto min, auto max) { return std::uniform_int_distribution<decltype(auto(min))>(min, max)(rng); };
+			auto rollProb = [&](auto prob) { return (prob > genFloat(decltype(auto(prob))(0.0), 1.0f)); };
+			auto junctionMap = BasicUmap<ucomp_t, Pos>(16);
+			auto junctionSet = BasicUset<Pos>(16);
+			junctionMap.max_load_factor(4.0f);
+			junctionSet.max_load_factor(4.0f);
+			fcomp_t widthHeightAvg = fcomp_t(w) + fcomp_t(h) / fcomp_t(2.0);
+			fcomp_t widthHeightAvgSq = widthHeightAvg * widthHeightAvg;
+
+			ucomp_t minPathTiles = genInt(ucomp_t(4), std::max(ucomp_t(4), std::min(w, h) / ucomp_t(2)));
+			ucomp_t maxPathTiles = genInt(ucomp_t(widthHeightAvgSq / fcomp_t(8)), ucomp_t(widthHeightAvgSq / fcomp_t(3)));
+			fcomp_t tJunctionProb   = params.tJunctionProbBase / ((fcomp_t(minPathTiles) + widthHeightAvg) / fcomp_t(2.0));
+			fcomp_t maxDiagonalDist = genFloat(std::sqrt(std::min<fcomp_t>(w, h)), widthHeightAvg);
+
+			auto randomPosAround = [&](Pos src, fcomp_t maxDistSq) {
+				auto rx = genFloat(-maxDistSq, +maxDistSq);
+				auto ry = genFloat(-maxDistSq, +maxDistSq);
+				fcomp_t ptLen = std::sqrt((rx*rx) + (ry*ry));
+				fcomp_t rndDist = genFloat(fcomp_t(2.0), maxDistSq);
+				rndDist /= ptLen;
+				rx *= rndDist; ry *= rndDist;
+				ucomp_t rrx = std::clamp(scomp_t(src.x) + scomp_t(rx), scomp_t(area.begin.x), scomp_t(area.end.x - 1));
+				ucomp_t rry = std::clamp(scomp_t(src.y) + scomp_t(ry), scomp_t(area.begin.y), scomp_t(area.end.y - 1));
+				return Pos { rrx, rry };
+			};
+
+			auto randomJunction = [&]() -> auto {
+				assert(! junctionMap.empty());
+				auto rndIdx = genInt(ucomp_t(0), junctionMap.size() - 1);
+				assert(junctionMap.contains(rndIdx));
+				return junctionMap.find(rndIdx)->second;
+			};
+
+			auto addJunction = [&](const Pos& p) {
+				if(junctionSet.insert(p).second) junctionMap.insert({ junctionMap.size(), p });
+			};
+
+			auto setTile = [&](ucomp_t x, ucomp_t y, GridObjectClass obj) {
+				assert(area.contains({ x, y }));
 				dst.tile(x, y) = obj;
-				if(dstPtObjs != nullptr && obj == GridObjectClass::ePoint) dstPtObjs->insert({ x, y });
+				if(dstPtObjs != nullptr && obj == GridObjectClass::ePoint) dstPtObjs->push_back({ x, y });
 			};
-			auto move = [&]() {
-				if(maxPathTiles > 0) [[likely]] {
-					assert(curPos.x < w);
-					assert(curPos.y < h);
-					setTile(dst, dstPtObjs, curPos.x, curPos.y, obj);
-					*curComp += step;
-					-- maxPathTiles;
+
+			// Paths that connect the anchors are carved regardless of the tile budget
+			ucomp_t unlimitedTiles = std::numeric_limits<ucomp_t>::max();
+
+			auto carveAxisAligned = [&](Pos curPos, const Pos& endPos, bool vertical, GridObjectClass obj, ucomp_t& tileBudget) {
+				// `endPos` is not the idiomatic "end": the interval is [curPos, endPos] instead of [curPos, endPos)
+				auto* curComp = vertical? (&curPos.y) : (&curPos.x);
+				auto* endComp = vertical? (&endPos.y) : (&endPos.x);
+				scomp_t step = (*curComp < *endComp)? +1 : -1;
+				auto move = [&]() {
+					if(tileBudget > 0) [[likely]] {
+						setTile(curPos.x, curPos.y, obj);
+						*curComp += step;
+						-- tileBudget;
+					}
+				};
+				auto cond = [&]() { return (*curComp != *endComp) && (tileBudget > 0); };
+				if(cond()) {
+					move();
 				}
+				while(cond()) {
+					if(rollProb(tJunctionProb)) addJunction(curPos);
+					move();
+				}
+				setTile(curPos.x, curPos.y, obj);
+				if(rollProb(params.xJunctionProb)) addJunction(curPos);
+				return curPos;
+			};
+
+			auto carveDiagonal = [&](Pos curPos, const Pos& endPos, GridObjectClass obj, ucomp_t& tileBudget) {
+				// See comment in `carveAxisAligned`
+				bool verticalFirst = ! rollProb(params.diagonalCompBias);
+				curPos = carveAxisAligned(curPos, endPos,   verticalFirst, obj, tileBudget);
+				curPos = carveAxisAligned(curPos, endPos, ! verticalFirst, obj, tileBudget);
+				return curPos;
 			};
-			auto cond = [&]() { return (*curComp != *endComp) && (maxPathTiles > 0); };
-			if(cond()) {
-				move();
+
+			auto startingPoint = anchors.front();
+			addJunction(startingPoint);
+			setTile(startingPoint.x, startingPoint.y, GridObjectClass::eNoObject);
+			for(size_t i = 1; i < anchors.size(); ++i) {
+				// The source must be picked before the anchor becomes a junction, or it may be the anchor itself
+				auto source = randomJunction();
+				carveDiagonal(source, anchors[i], GridObjectClass::eNoObject, unlimitedTiles);
+				addJunction(anchors[i]);
 			}
-			while(cond()) {
-				if(rollProb(tJunctionProb)) addJunction(curPos);
-				move();
+			while(minPathTiles < maxPathTiles) {
+				bool targetJunction = rollProb(params.targetJunctionProb);
+				bool createPointObjs = rollProb(params.pointObjProb);
+				bool deadEnd = rollProb(params.deadEndProb);
+				auto target = targetJunction? randomJunction() : randomPosAround(startingPoint, maxDiagonalDist);
+				auto obj = createPointObjs? GridObjectClass::ePoint : GridObjectClass::eNoObject;
+				startingPoint = carveDiagonal(startingPoint, target, obj, maxPathTiles);
+				if(deadEnd) startingPoint = randomJunction();
 			}
-			setTile(dst, dstPtObjs, curPos.x, curPos.y, obj);
-			if(rollProb(xJunctionProb)) addJunction(curPos);
-			return curPos;
-		};
+			return randomJunction();
+		}
 
-		auto carveDiagonal = [&](Pos curPos, const Pos& endPos, GridObjectClass obj) {
-			// See comment in `carveAxisAligned`
-			bool verticalFirst = ! rollProb(diagonalCompBias);
-			curPos = carveAxisAligned(curPos, endPos,   verticalFirst, obj);
-			curPos = carveAxisAligned(curPos, endPos, ! verticalFirst, obj);
-			return curPos;
-		};
 
-		generateWorldNoise(std::forward<Logger>(logger), dst, std::forward<Rng>(rng));
+		/// \brief Calls `fn(i)` for every `i` in `[0, count)` on up to
+		///        `threadCount` threads, including the calling one.
+		///
+		/// If any call throws, the remaining items are skipped and
+		/// the first exception is rethrown.
+		///
+		template <typename Fn>
+		void parallelFor(size_t count, unsigned threadCount, Fn&& fn) {
+			if(count == 0) return;
+			std::atomic_size_t nextItem = 0;
+			std::exception_ptr exception;
+			std::mutex exceptionMutex;
+			auto work = [&]() {
+				size_t i;
+				while((i = nextItem.fetch_add(1, std::memory_order_relaxed)) < count) {
+					try {
+						fn(i);
+					} catch(...) {
+						auto lock = std::unique_lock(exceptionMutex);
+						if(! exception) exception = std::current_exception();
+						nextItem.store(count, std::memory_order_relaxed);
+					}
+				}
+			};
+			threadCount = std::min<size_t>(std::max(threadCount, 1u), count);
+			{
+				std::vector<std::jthread> workers;
+				workers.reserve(threadCount - 1);
+				for(unsigned i = 1; i < threadCount; ++i) workers.emplace_back(work);
+				work();
+			}
+			if(exception) std::rethrow_exception(exception);
+		}
+
+	}
+
+
+	/// \brief Fills the world with random walls and obstacles.
+	///
+	/// \param threadCount The number of threads to generate chunks on;
+	///        0 means one per hardware thread.
+	///
+	template <typename Logger>
+	void generateWorldNoise(Logger&& logger, World& dst, uint64_t seed, unsigned threadCount = 0) {
+		using namespace worldgen_impl;
 		util::SteadyTimer<> timer;
-		auto startingPoint = startPos;
-		addJunction(startingPoint);
-		while(minPathTiles < maxPathTiles) {
-			bool targetJunction = rollProb(targetJunctionProb);
-			bool createPointObjs = rollProb(pointObjProb);
-			bool deadEnd = rollProb(deadEndProb);
-			auto target = targetJunction? randomJunction() : randomPosAround(startingPoint, maxDiagonalDist);
-			auto obj = createPointObjs? GridObjectClass::ePoint : GridObjectClass::eNoObject;
-			startingPoint = carveDiagonal(startingPoint, target, obj);
-			if(deadEnd) startingPoint = randomJunction();
+		assert(dst.width() * dst.height() > 0);
+		if(threadCount == 0) threadCount = std::thread::hardware_concurrency();
+		auto params = WorldParams::generate(seed);
+		auto grid   = ChunkGrid::of(dst);
+		parallelFor(grid.chunkCount(), threadCount, [&](size_t i) {
+			ucomp_t cx = i % grid.countX;
+			ucomp_t cy = i / grid.countX;
+			generateChunkNoise(dst, grid.area(cx, cy), params, WorldgenRng(worldgenKey(seed, uint64_t(Stream::eChunkNoise), cx, cy)));
+		});
+		logger.info(
+			"Generated world noise in {} chunks [{}ms]",
+			grid.chunkCount(),
+			float(timer.count<std::micro>()) / 1000.0f );
+	}
+
+
+	/// \brief Generates a random world, whose every path is reachable from `startPos`.
+	///
+	/// The result only depends on the seed and the size of the world,
+	/// not on the number of threads.
+	///
+	/// \param threadCount The number of threads to generate chunks on;
+	///        0 means one per hardware thread.
+	/// \returns A random junction of the chunk that contains `startPos`.
+	///
+	template <typename Logger>
+	auto generateWorld(Logger&& logger, World& dst, BasicUset<Vec2<uint64_t>>* dstPtObjs, Vec2<uint64_t> startPos, uint64_t seed, unsigned threadCount = 0) {
+		using namespace worldgen_impl;
+		const auto w = dst.width();
+		const auto h = dst.height();
+		if(w * h < 2) return Pos { };
+		assert(startPos.x < w && startPos.y < h);
+		util::SteadyTimer<> timer;
+		if(threadCount == 0) threadCount = std::thread::hardware_concurrency();
+		auto params     = WorldParams::generate(seed);
+		auto grid       = ChunkGrid::of(dst);
+		auto startChunk = grid.chunkOf(startPos);
+		auto chunkCount = grid.chunkCount();
+		std::vector<std::vector<Pos>> ptObjs(dstPtObjs == nullptr? 0 : chunkCount);
+		std::vector<Pos> junctions(chunkCount);
+
+		parallelFor(chunkCount, threadCount, [&](size_t i) {
+			ucomp_t cx = i % grid.countX;
+			ucomp_t cy = i / grid.countX;
+			auto area = grid.area(cx, cy);
+			generateChunkNoise(dst, area, params, WorldgenRng(worldgenKey(seed, uint64_t(Stream::eChunkNoise), cx, cy)));
+			auto anchors = grid.seamTiles(seed, cx, cy);
+			if(cx == startChunk.x && cy == startChunk.y) anchors.insert(anchors.begin(), startPos);
+			if(anchors.empty()) anchors.push_back({ area.begin.x + (area.width() / 2), area.begin.y + (area.height() / 2) });
+			junctions[i] = generateChunkPaths(
+				dst, dstPtObjs == nullptr? nullptr : &ptObjs[i],
+				area, params, WorldgenRng(worldgenKey(seed, uint64_t(Stream::eChunkPaths), cx, cy)),
+				anchors );
+		});
+
+		if(dstPtObjs != nullptr) {
+			for(auto& chunkPtObjs : ptObjs)
+			for(auto& p : chunkPtObjs) if(dst.tile(p.x, p.y) == GridObjectClass::ePoint) dstPtObjs->insert(p);
 		}
 		logger.info(
-			"Generated world paths [{}ms]",
+			"Generated world of {} chunks on {} threads [{}ms]",
+			chunkCount,
+			std::min<size_t>(threadCount, chunkCount),
 			float(timer.count<std::micro>()) / 1000.0f );
-		return randomJunction();
+		return junctions[(startChunk.y * grid.countX) + startChunk.x];
 	}
 
 }
@@ -0,0 +1,125 @@
+// Converts a procedurally generated OBJ scene with different job counts,
+// and reports how long each conversion takes.
+//
+// Usage: fmaconv-bench [grid side] [job count...]
+//
+// The scene is made of four shapes, each a (side x side) grid of
+// quads over a wavy height field, so the default side of 768
+// yields about 4.7 million triangles.
+
+#include "obj.inl.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+
+
+namespace {
+
+	constexpr unsigned shapeCount  = 4;
+	constexpr unsigned defaultSide = 768;
+
+	const char* const objName = "fmaconv-bench.obj";
+	const char* const fmaName = "fmaconv-bench.fma";
+
+
+	void generateObj(unsigned side) {
+		constexpr auto openFlags = posixfio::OpenFlags::eCreat | posixfio::OpenFlags::eRdwr;
+		auto file   = posixfio::File::open(objName, openFlags, 0660);
+		file.ftruncate(0);
+		auto outBuf = posixfio::OutputBuffer(file, 1 << 20);
+		auto line   = std::string();
+		auto flush  = [&]() { outBuf.writeAll(line.data(), line.size()); line.clear(); };
+
+		const unsigned rowLength  = side + 1;
+		const unsigned gridPoints = rowLength * rowLength;
+		auto height = [](float x, float y) { return 0.25f * std::sin(x * 0.37f) * std::cos(y * 0.23f); };
+
+		for(unsigned s = 0; s < shapeCount; ++s) {
+			float offset = float(s * side);
+			fmt::format_to(std::back_inserter(line), "o shape{}\n", s);
+			for(unsigned y = 0; y <= side; ++y)
+			for(unsigned x = 0; x <= side; ++x) {
+				float px = offset + float(x);
+				float py = float(y);
+				float dx = height(px + 0.5f, py) - height(px - 0.5f, py);
+				float dy = height(px, py + 0.5f) - height(px, py - 0.5f);
+				float nl = std::sqrt((dx * dx) + (dy * dy) + 1.0f);
+				fmt::format_to(std::back_inserter(line), "v {} {} {}\n", px, py, height(px, py));
+				fmt::format_to(std::back_inserter(line), "vt {} {}\n", float(x) / float(side), float(y) / float(side));
+				fmt::format_to(std::back_inserter(line), "vn {} {} {}\n", -dx / nl, -dy / nl, 1.0f / nl);
+				if(line.size() > (1 << 16)) flush();
+			}
+			// OBJ indices are 1-based and global
+			auto at = [&](unsigned x, unsigned y) { return (s * gridPoints) + (y * rowLength) + x + 1; };
+			for(unsigned y = 0; y < side; ++y)
+			for(unsigned x = 0; x < side; ++x) {
+				auto i0 = at(x, y);   auto i1 = at(x+1, y);
+				auto i2 = at(x+1, y+1); auto i3 = at(x, y+1);
+				fmt::format_to(std::back_inserter(line), "f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2} {3}/{3}/{3}\n", i0, i1, i2, i3);
+				if(line.size() > (1 << 16)) flush();
+			}
+		}
+		flush();
+		outBuf.flush();
+	}
+
+}
+
+
+
+int main(int argc, char** argv) {
+	using clock = std::chrono::steady_clock;
+
+	unsigned side = (argc >= 2)? std::strtoul(argv[1], nullptr, 10) : defaultSide;
+	if(side < 1) return EXIT_FAILURE;
+
+	std::vector<unsigned> jobCounts;
+	for(int i = 2; i < argc; ++i) jobCounts.push_back(std::strtoul(argv[i], nullptr, 10));
+	if(jobCounts.empty()) jobCounts = { 1, 0 };
+
+	auto genBeg = clock::now();
+	generateObj(side);
+	fmt::print(
+		"Generated {} triangles in {:.3f}s\n",
+		std::size_t(shapeCount) * side * side * 2,
+		std::chrono::duration<double>(clock::now() - genBeg).count() );
+
+	try {
+		for(auto jobs : jobCounts) {
+			fmamdl::conv::Options opt;
+			opt.srcName         = objName;
+			opt.dstName         = fmaName;
+			opt.mainBone        = "\033first";
+			opt.jobs            = jobs;
+			opt.lodLevels       = 0;
+			opt.noMaterials     = true;
+			opt.onlyMaterials   = false;
+			opt.compactVertices = false;
+			opt.noOptimization  = false;
+			opt.clusters        = false;
+
+			auto beg = clock::now();
+			fmamdl::conv::obj::convert(opt);
+			fmt::print(
+				"{} jobs: {:.3f}s\n",
+				(jobs == 0)? std::thread::hardware_concurrency() : jobs,
+				std::chrono::duration<double>(clock::now() - beg).count() );
+		}
+	} catch(std::exception& ex) {
+		fmt::print(stderr, "Error: {}\n", ex.what());
+		return EXIT_FAILURE;
+	} catch(posixfio::Errcode& er) {
+		fmt::print(stderr, "File error: errno {}\n", er.errcode);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
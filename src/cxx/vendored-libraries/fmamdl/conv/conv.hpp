@@ -23,8 +23,13 @@ namespace fmamdl::conv {
 		std::string_view dstName;
 		std::string_view mainBone;
 		std::string_view texturePrefix;
+		unsigned jobs; ///< Number of worker threads, 0 for one per hardware thread
+		unsigned lodLevels; ///< Number of simplified levels of detail to generate for each mesh
 		bool noMaterials   : 1;
 		bool onlyMaterials : 1;
+		bool compactVertices : 1;
+		bool noOptimization  : 1;
+		bool clusters        : 1; ///< Whether to partition each mesh into meshlets
 	};
 
 }
@@ -1,5 +1,6 @@
 #include "obj.inl.hpp"
 
+#include <charconv>
 #include <filesystem>
 #include <vector>
 #include <string_view>
@@ -20,7 +21,12 @@ namespace fmamdl::conv {
 		"<source> <destination> [options...]\n"
 		"\t-t <file>, --texture-prefix <file>\n"
 		"\t-M,        --no-material-output\n"
-		"\t-b <bone>, --main-bone <bone>\n";
+		"\t-b <bone>, --main-bone <bone>\n"
+		"\t-c,        --compact-vertices\n"
+		"\t-N,        --no-optimization\n"
+		"\t-j <n>,    --jobs <n>\n"
+		"\t-l <n>,    --lod-levels <n>\n"
+		"\t-C,        --clusters\n";
 
 
 	std::filesystem::path parseArg0(std::string_view arg0) {
@@ -42,6 +48,11 @@ namespace fmamdl::conv {
 		eNoMaterials,
 		eOnlyMaterials,
 		eMainBone,
+		eCompactVertices,
+		eNoOptimization,
+		eJobs,
+		eLodLevels,
+		eClusters,
 		eLiteral,
 		eDash
 	};
@@ -65,8 +76,13 @@ namespace fmamdl::conv {
 		if(*c == '-') { ++c; goto long_opt_beg; }
 		if(*c == nul) return { value, next, OptionType::eDash, false };
 		if(*c == 'b') { ++c; goto short_b; }
+		if(*c == 'c') { ++c; goto short_c; }
+		if(*c == 'C') { ++c; goto short_C; }
+		if(*c == 'j') { ++c; goto short_j; }
+		if(*c == 'l') { ++c; goto short_l; }
 		if(*c == 'm') { ++c; goto short_m; }
 		if(*c == 'M') { ++c; goto short_M; }
+		if(*c == 'N') { ++c; goto short_N; }
 		if(*c == 't') { ++c; goto short_t; }
 		goto error;
 
@@ -74,6 +90,22 @@ namespace fmamdl::conv {
 		if(*c == nul) return { "-b", next, OptionType::eMainBone, true };
 		return { "-b", std::string_view(value.data() + 2, value.size() - 2), OptionType::eMainBone, false };
 
+		short_c:
+		if(*c == nul) return { "-c", next, OptionType::eCompactVertices, false };
+		return { "-c", std::string_view(value.data() + 2, value.size() - 2), OptionType::eCompactVertices, false };
+
+		short_C:
+		if(*c == nul) return { "-C", next, OptionType::eClusters, false };
+		return { "-C", std::string_view(value.data() + 2, value.size() - 2), OptionType::eClusters, false };
+
+		short_j:
+		if(*c == nul) return { "-j", next, OptionType::eJobs, true };
+		return { "-j", std::string_view(value.data() + 2, value.size() - 2), OptionType::eJobs, false };
+
+		short_l:
+		if(*c == nul) return { "-l", next, OptionType::eLodLevels, true };
+		return { "-l", std::string_view(value.data() + 2, value.size() - 2), OptionType::eLodLevels, false };
+
 		short_m:
 		if(*c == nul) return { "-m", next, OptionType::eOnlyMaterials, false };
 		return { "-m", std::string_view(value.data() + 2, value.size() - 2), OptionType::eOnlyMaterials, false };
@@ -82,16 +114,73 @@ namespace fmamdl::conv {
 		if(*c == nul) return { "-M", next, OptionType::eNoMaterials, false };
 		return { "-M", std::string_view(value.data() + 2, value.size() - 2), OptionType::eNoMaterials, false };
 
+		short_N:
+		if(*c == nul) return { "-N", next, OptionType::eNoOptimization, false };
+		return { "-N", std::string_view(value.data() + 2, value.size() - 2), OptionType::eNoOptimization, false };
+
 		short_t:
 		if(*c == nul) return { "-t", next, OptionType::eTexturePrefix, true };
 		return { "-t", std::string_view(value.data() + 2, value.size() - 2), OptionType::eTexturePrefix, false };
 
 		long_opt_beg:
 		if(*c == nul) return { value, next, OptionType::eLiteral, false };
-		if(*c == 'm') goto long_m;
-		if(*c == 'n') goto long_n;
-		if(*c == 'o') goto long_o;
-		if(*c == 't') goto long_t;
+		if(*c == 'c') { ++c; goto long_c; }
+		if(*c == 'j') { ++c; goto long_j; }
+		if(*c == 'l') { ++c; goto long_l; }
+		if(*c == 'm') { ++c; goto long_m; }
+		if(*c == 'n') { ++c; goto long_n; }
+		if(*c == 'o') { ++c; goto long_o; }
+		if(*c == 't') { ++c; goto long_t; }
+		goto error;
+
+		long_c:                if(*c == 'o') { ++c; goto long_co; }
+		                       if(*c == 'l') { ++c; goto long_cl; }
+		long_co:               if(*c == 'm') { ++c; goto long_com; }
+		long_com:              if(*c == 'p') { ++c; goto long_comp; }
+		long_comp:             if(*c == 'a') { ++c; goto long_compa; }
+		long_compa:            if(*c == 'c') { ++c; goto long_compac; }
+		long_compac:           if(*c == 't') { ++c; goto long_compact; }
+		long_compact:          if(*c == '-') { ++c; goto long_compact_; }
+		long_compact_:         if(*c == 'v') { ++c; goto long_compact_v; }
+		long_compact_v:        if(*c == 'e') { ++c; goto long_compact_ve; }
+		long_compact_ve:       if(*c == 'r') { ++c; goto long_compact_ver; }
+		long_compact_ver:      if(*c == 't') { ++c; goto long_compact_vert; }
+		long_compact_vert:     if(*c == 'i') { ++c; goto long_compact_verti; }
+		long_compact_verti:    if(*c == 'c') { ++c; goto long_compact_vertic; }
+		long_compact_vertic:   if(*c == 'e') { ++c; goto long_compact_vertice; }
+		long_compact_vertice:  if(*c == 's') { ++c; goto long_compact_vertices; }
+		long_compact_vertices:
+		if(*c == nul) return { "-c", next, OptionType::eCompactVertices, false };
+		goto error;
+
+		long_cl:       if(*c == 'u') { ++c; goto long_clu; }
+		long_clu:      if(*c == 's') { ++c; goto long_clus; }
+		long_clus:     if(*c == 't') { ++c; goto long_clust; }
+		long_clust:    if(*c == 'e') { ++c; goto long_cluste; }
+		long_cluste:   if(*c == 'r') { ++c; goto long_cluster; }
+		long_cluster:  if(*c == 's') { ++c; goto long_clusters; }
+		long_clusters:
+		if(*c == nul) return { "-C", next, OptionType::eClusters, false };
+		goto error;
+
+		long_j:    if(*c == 'o') { ++c; goto long_jo; }
+		long_jo:   if(*c == 'b') { ++c; goto long_job; }
+		long_job:  if(*c == 's') { ++c; goto long_jobs; }
+		long_jobs:
+		if(*c == nul) return { "-j", next, OptionType::eJobs, true };
+		goto error;
+
+		long_l:           if(*c == 'o') { ++c; goto long_lo; }
+		long_lo:          if(*c == 'd') { ++c; goto long_lod; }
+		long_lod:         if(*c == '-') { ++c; goto long_lod_; }
+		long_lod_:        if(*c == 'l') { ++c; goto long_lod_l; }
+		long_lod_l:       if(*c == 'e') { ++c; goto long_lod_le; }
+		long_lod_le:      if(*c == 'v') { ++c; goto long_lod_lev; }
+		long_lod_lev:     if(*c == 'e') { ++c; goto long_lod_leve; }
+		long_lod_leve:    if(*c == 'l') { ++c; goto long_lod_level; }
+		long_lod_level:   if(*c == 's') { ++c; goto long_lod_levels; }
+		long_lod_levels:
+		if(*c == nul) return { "-l", next, OptionType::eLodLevels, true };
 		goto error;
 
 		long_m:        if(*c == 'a') { ++c; goto long_ma; }
@@ -108,7 +197,8 @@ namespace fmamdl::conv {
 
 		long_n:                  if(*c == 'o') { ++c; goto long_no; }
 		long_no:                 if(*c == '-') { ++c; goto long_no_; }
-		long_no_:                if(*c == 'm') { ++c; goto long_no_m; }
+		long_no_:                if(*c == 'o') { ++c; goto long_no_o; }
+		                         if(*c == 'm') { ++c; goto long_no_m; }
 		long_no_m:               if(*c == 'a') { ++c; goto long_no_ma; }
 		long_no_ma:              if(*c == 't') { ++c; goto long_no_mat; }
 		long_no_mat:             if(*c == 'e') { ++c; goto long_no_mate; }
@@ -121,6 +211,21 @@ namespace fmamdl::conv {
 		if(*c == nul) return { "-M", next, OptionType::eNoMaterials, false };
 		goto error;
 
+		long_no_o:               if(*c == 'p') { ++c; goto long_no_op; }
+		long_no_op:              if(*c == 't') { ++c; goto long_no_opt; }
+		long_no_opt:             if(*c == 'i') { ++c; goto long_no_opti; }
+		long_no_opti:            if(*c == 'm') { ++c; goto long_no_optim; }
+		long_no_optim:           if(*c == 'i') { ++c; goto long_no_optimi; }
+		long_no_optimi:          if(*c == 'z') { ++c; goto long_no_optimiz; }
+		long_no_optimiz:         if(*c == 'a') { ++c; goto long_no_optimiza; }
+		long_no_optimiza:        if(*c == 't') { ++c; goto long_no_optimizat; }
+		long_no_optimizat:       if(*c == 'i') { ++c; goto long_no_optimizati; }
+		long_no_optimizati:      if(*c == 'o') { ++c; goto long_no_optimizatio; }
+		long_no_optimizatio:     if(*c == 'n') { ++c; goto long_no_optimization; }
+		long_no_optimization:
+		if(*c == nul) return { "-N", next, OptionType::eNoOptimization, false };
+		goto error;
+
 		long_o:                    if(*c == 'n') { ++c; goto long_on; }
 		long_on:                   if(*c == 'l') { ++c; goto long_onl; }
 		long_onl:                  if(*c == 'y') { ++c; goto long_only; }
@@ -163,6 +268,13 @@ namespace fmamdl::conv {
 	Options parseOptions(const StringViews& args) {
 		Options r;
 		r.mainBone = std::string_view("\033first");
+		r.jobs     = 0;
+		r.lodLevels = 0;
+		r.noMaterials     = false;
+		r.onlyMaterials   = false;
+		r.compactVertices = false;
+		r.noOptimization  = false;
+		r.clusters        = false;
 		bool srcGiven = false;
 		bool dstGiven = false;
 		bool literal  = false;
@@ -209,6 +321,27 @@ namespace fmamdl::conv {
 				case OptionType::eMainBone:
 					r.mainBone = opt.next;
 					break;
+				case OptionType::eCompactVertices:
+					r.compactVertices = true;
+					break;
+				case OptionType::eNoOptimization:
+					r.noOptimization = true;
+					break;
+				case OptionType::eClusters:
+					r.clusters = true;
+					break;
+				case OptionType::eJobs: {
+					auto str = opt.next;
+					auto res = std::from_chars(str.data(), str.data() + str.size(), r.jobs);
+					if(res.ec != std::errc() || res.ptr != str.data() + str.size()) throw std::invalid_argument(
+						"Invalid job count \"" + std::string(str) + "\"" );
+				} break;
+				case OptionType::eLodLevels: {
+					auto str = opt.next;
+					auto res = std::from_chars(str.data(), str.data() + str.size(), r.lodLevels);
+					if(res.ec != std::errc() || res.ptr != str.data() + str.size()) throw std::invalid_argument(
+						"Invalid LOD level count \"" + std::string(str) + "\"" );
+				} break;
 			}
 			if(opt.consumeNext) {
 				if(! iter1eof) ++ iter1;
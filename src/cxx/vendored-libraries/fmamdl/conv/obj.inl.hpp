@@ -1,6 +1,7 @@
 #pragma once
 
 #include "util.inl.hpp"
+#include "parallel.inl.hpp"
 #include "conv.hpp"
 
 #include <memory>
@@ -14,6 +15,10 @@
 
 #include <fmamdl/fmamdl.hpp>
 #include <fmamdl/material.hpp>
+#include <fmamdl/quantize.hpp>
+#include <fmamdl/optimize.hpp>
+#include <fmamdl/simplify.hpp>
+#include <fmamdl/meshlet.hpp>
 
 
 
@@ -33,11 +38,11 @@ namespace fmamdl::conv::obj {
 
 
 
-	const auto vtxLayout  = Layout::fromCstring("f44444222222222");
-	const auto headerSize = HeaderView::requiredBytesFor(vtxLayout);
+	const auto vtxLayout        = Layout::fromCstring("f44444222222222");
+	const auto compactVtxLayout = Layout::fromCstring("u2222f22s2222");
 
 
-	auto allocHeader() {
+	auto allocHeader(std::size_t headerSize) {
 		auto r = std::make_unique_for_overwrite<std::byte[]>(headerSize);
 		memset(r.get(), 0xaa, headerSize);
 		return r;
@@ -81,31 +86,42 @@ namespace fmamdl::conv::obj {
 		StringStorage         strings;
 	};
 
-	void readObj(const Options& opt, ReadObjDst& dst) {
+	void readObj(const Options& opt, ThreadPool& pool, ReadObjDst& dst) {
 		rapidobj::Result result = rapidobj::ParseFile(opt.srcName, rapidobj::MaterialLibrary::Default());
 
-		using vim_t  = std::unordered_map<Vertex, u4_t, VertexHash>;
-		using ivm_t  = std::unordered_map<u4_t, const Vertex*>;
 		using mf_ec  = MaterialFlags;
 		using mf_e   = material_flags_e;
 		using StrOff = fmamdl::StringOffset;
 
-		vim_t vertexIndexMap;
-		ivm_t indexVertexMap;
-		u8_t  nullMaterialIdx = ~ u8_t(0);
-		std::vector<Vertex> faceVertexCache;
+		/// A contiguous run of faces of a single shape, processed by one thread.
+		struct FaceChunk {
+			const rapidobj::Mesh* objMesh;
+			u4_t meshIndex;
+			u4_t firstObjFace;
+			u4_t faceCount;
+			u8_t firstObjIndex;
+			u8_t firstFace;
+			u8_t firstIndex;
+		};
+
+		constexpr u4_t facesPerChunk = 0x4000;
 
+		ShardedVertexSet       vertexSet;
+		std::vector<FaceChunk> chunks;
+		u8_t nullMaterialIdx = ~ u8_t(0);
+
+		if(result.error) {
+			throw std::runtime_error(fmt::format("Failed to parse \"{}\": {}", opt.srcName, result.error.code.message())); }
 		if(result.attributes.normals.empty()) {
 			throw std::runtime_error("Model is missing normal data"); }
 		if(result.attributes.texcoords.empty()) {
 			throw std::runtime_error("Model is missing texture data"); }
 
-		auto putVertex = [&](const rapidobj::Index& objIndex) {
-			// When this function returns, tangents and bitangents are still yet to be calculated
+		auto makeVertex = [&](const rapidobj::Index& objIndex) {
+			// Tangents and bitangents are still yet to be calculated
 			assert(objIndex.normal_index   >= 0);
 			assert(objIndex.texcoord_index >= 0);
 			Vertex vtx;
-			u4_t   newIdx = dst.vertices.size();
 			vtx.position[0] = result.attributes.positions[(objIndex.position_index*3)+0];
 			vtx.position[1] = result.attributes.positions[(objIndex.position_index*3)+1];
 			vtx.position[2] = result.attributes.positions[(objIndex.position_index*3)+2];
@@ -114,40 +130,39 @@ namespace fmamdl::conv::obj {
 			vtx.normal[2]   = f2_t(result.attributes.normals[(objIndex.normal_index*3)+2]);
 			vtx.texture[0]  = +result.attributes.texcoords[(objIndex.texcoord_index*2)+0];
 			vtx.texture[1]  = -result.attributes.texcoords[(objIndex.texcoord_index*2)+1];
-			auto iter0 = vertexIndexMap.insert(std::pair<const Vertex, u4_t>(vtx, newIdx));
-			if(iter0.second /* Insertion happened */) {
-				indexVertexMap.insert(std::pair<const u4_t, const Vertex*>(newIdx, &iter0.first->first));
-				dst.vertices.push_back(vtx);
-				return newIdx;
-			} else {
-				return iter0.first->second;
-			}
+			return vtx;
 		};
 
-		auto addFace = [&](const rapidobj::Mesh& mesh, u8_t faceVtxOffset, u2_t faceSize, u4_t materialId) {
-			assert(faceSize >= 3);
-			Face face;
-			faceVertexCache.clear();
-			faceVertexCache.reserve(faceSize);
-			face.firstIndex = dst.indices.size();
-			for(size_t i = 0; i < faceSize; ++i) {
-				std::size_t meshIndexIndex = faceVtxOffset + i;
-				assert(faceVtxOffset + faceSize <= mesh.indices.size());
-				u4_t insIndex = putVertex(mesh.indices[meshIndexIndex]);
-				dst.indices.push_back(Index(insIndex));
-				faceVertexCache.push_back(dst.vertices[insIndex]);
-			}
-			computeTangents(faceVertexCache.data(), faceVertexCache.size());
-			face.indexCount    = faceSize;
-			face.materialIndex = materialId;
-			computeNormal(face.normal, faceVertexCache.data());
-			for(size_t i = 0; i < faceSize; ++i) {
-				std::size_t indexIndex = dst.indices.size() - faceSize + i;
-				std::size_t index      = std::size_t(dst.indices[indexIndex]);
-				memcpy(dst.vertices.data() + index, faceVertexCache.data() + i, sizeof(Vertex));
+		auto processChunk = [&](const FaceChunk& chunk) {
+			auto& objMesh = *chunk.objMesh;
+			// Compact vertices are quantized against their mesh's bounds, so meshes cannot share them
+			u4_t vertexGroup = opt.compactVertices? chunk.meshIndex : 0;
+			u8_t objIndex    = chunk.firstObjIndex;
+			u8_t index       = chunk.firstIndex;
+			std::vector<Vertex> faceVertexCache;
+			for(u4_t i = 0; i < chunk.faceCount; ++i) {
+				u4_t objFace  = chunk.firstObjFace + i;
+				u2_t faceSize = objMesh.num_face_vertices[objFace];
+				assert(faceSize >= 3);
+				assert(objIndex + faceSize <= objMesh.indices.size());
+				faceVertexCache.clear();
+				for(u2_t j = 0; j < faceSize; ++j) faceVertexCache.push_back(makeVertex(objMesh.indices[objIndex + j]));
+				computeTangents(faceVertexCache.data(), faceVertexCache.size());
+
+				Face face;
+				face.firstIndex    = index;
+				face.indexCount    = faceSize;
+				face.materialIndex = objMesh.material_ids.empty()? ~ u4_t(0) : u4_t(objMesh.material_ids[objFace]);
+				computeNormal(face.normal, faceVertexCache.data());
+				for(u2_t j = 0; j < faceSize; ++j) {
+					// A vertex takes the tangents of the last face (in file order) that uses it
+					dst.indices[index + j] = Index(vertexSet.insert(faceVertexCache[j], vertexGroup, index + j));
+				}
+				dst.indices[index + faceSize] = Index::ePrimitiveRestart;
+				dst.faces[chunk.firstFace + i] = face;
+				objIndex += faceSize;
+				index    += faceSize + 1;
 			}
-			dst.indices.push_back(Index::ePrimitiveRestart);
-			dst.faces.push_back(face);
 		};
 
 		auto addMaterial = [&](const rapidobj::Material& mat) {
@@ -197,9 +212,14 @@ namespace fmamdl::conv::obj {
 			return id;
 		};
 
+		// Materials, meshes and bones are cheap and order-dependent, so they are
+		// handled here; since every face adds its size plus one primitive restart
+		// to the index table, the position of every face can be computed upfront
+		// and the faces themselves can be processed in any order.
+		u8_t totalFaceCount  = 0;
+		u8_t totalIndexCount = 0;
 		auto addShape = [&](const rapidobj::Shape& shape) {
 			auto& objMesh = shape.mesh;
-			(void) shape.name;
 
 			u8_t matId;
 			if(shape.mesh.material_ids.empty() || result.materials.empty()) {
@@ -217,17 +237,27 @@ namespace fmamdl::conv::obj {
 
 			Mesh mesh          = { };
 			mesh.materialIndex = matId;
-			mesh.firstFace     = dst.faces.size();
+			mesh.firstFace     = totalFaceCount;
 			mesh.faceCount     = objMesh.num_face_vertices.size();
-			u8_t indexCountBeforeInsertion = dst.indices.size();
-			u8_t faceVtxOffset = 0;
-			for(size_t i = 0; i < objMesh.num_face_vertices.size(); ++i) {
-				u8_t faceSize = objMesh.num_face_vertices[i];
-				addFace(objMesh, faceVtxOffset, faceSize, objMesh.material_ids[i]);
-				faceVtxOffset += faceSize;
+			u8_t indexCountBeforeInsertion = totalIndexCount;
+			u8_t objIndex = 0;
+			for(u4_t i = 0; i < objMesh.num_face_vertices.size(); ++i) {
+				if(i % facesPerChunk == 0) {
+					chunks.push_back(FaceChunk {
+						.objMesh       = &objMesh,
+						.meshIndex     = u4_t(dst.meshes.size()),
+						.firstObjFace  = i,
+						.faceCount     = std::min<u4_t>(facesPerChunk, objMesh.num_face_vertices.size() - i),
+						.firstObjIndex = objIndex,
+						.firstFace     = totalFaceCount,
+						.firstIndex    = totalIndexCount });
+				}
+				objIndex        += objMesh.num_face_vertices[i];
+				totalIndexCount += objMesh.num_face_vertices[i] + 1;
+				++ totalFaceCount;
 			}
 
-			mesh.indexCount = dst.indices.size() - indexCountBeforeInsertion;
+			mesh.indexCount = totalIndexCount - indexCountBeforeInsertion;
 			dst.meshes.push_back(mesh);
 
 			Bone bone = { };
@@ -240,27 +270,195 @@ namespace fmamdl::conv::obj {
 			dst.bones.push_back(bone);
 		};
 
-		{
-			u8_t indexCount = 0;
-			for(auto& shape : result.shapes) indexCount += shape.mesh.indices.size() + shape.mesh.num_face_vertices.size();
-			dst.materials.reserve(std::log2(std::max<size_t>(result.shapes.size(), 2)));
-			dst.meshes.reserve(dst.materials.capacity());
-			dst.vertices.reserve(result.attributes.positions.size() / 3);
-			dst.faces.reserve(dst.vertices.capacity() / 2);
-			dst.indices.reserve(indexCount + dst.faces.capacity());
-			vertexIndexMap.reserve(dst.vertices.capacity());
-			indexVertexMap.reserve(dst.indices.capacity());
-		}
-
+		dst.materials.reserve(std::log2(std::max<size_t>(result.shapes.size(), 2)));
+		dst.meshes.reserve(result.shapes.size());
 		for(auto& shape : result.shapes) {
 			addShape(shape);
 		}
+
+		if(totalIndexCount >= u8_t(Index::ePrimitiveRestart)) {
+			throw std::length_error("Too many indices"); }
+		dst.faces.resize(totalFaceCount);
+		dst.indices.resize(totalIndexCount);
+		vertexSet.reserve(result.attributes.positions.size() / 3);
+		pool.forEach(chunks.size(), [&](std::size_t i) { processChunk(chunks[i]); });
+		dst.vertices = vertexSet.collect(dst.indices);
+	}
+
+
+	void optimizeMeshes(ThreadPool& pool, ReadObjDst& dst) {
+		auto printStats = [](std::string_view when, const VertexCacheStats& stats) {
+			fmt::print(
+				"{:<6} {} triangles, {} vertices: ACMR {:.3f}, ATVR {:.3f}\n",
+				when, stats.triangleCount, stats.vertexCount, stats.acmr(), stats.atvr() );
+		};
+
+		printStats("Before", computeVertexCacheStats(dst.indices));
+		// Meshes own disjoint face and index ranges, and only read the vertices
+		pool.forEach(dst.meshes.size(), [&](std::size_t i) {
+			auto& mesh  = dst.meshes[i];
+			auto  faces = std::span<Face>(dst.faces).subspan(mesh.firstFace, mesh.faceCount);
+			optimizeFaceOrder(faces, dst.indices, dst.vertices);
+		});
+		dst.vertices.resize(optimizeVertexFetch(dst.indices, dst.vertices));
+		printStats("After", computeVertexCacheStats(dst.indices));
+	}
+
+
+	/// Sets the center and radius of every mesh to a sphere that
+	/// contains all of its vertices.
+	///
+	void computeMeshSpheres(ThreadPool& pool, ReadObjDst& dst) {
+		pool.forEach(dst.meshes.size(), [&](std::size_t i) {
+			auto& mesh = dst.meshes[i];
+			mesh.center[0] = mesh.center[1] = mesh.center[2] = 0.0f;
+			mesh.radius    = 0.0f;
+			if(mesh.faceCount == 0) return;
+
+			auto  firstIndex = dst.faces[mesh.firstFace].firstIndex;
+			auto  indices    = std::span<const Index>(dst.indices).subspan(firstIndex, mesh.indexCount);
+			f4_t  min[3]     = { +INFINITY, +INFINITY, +INFINITY };
+			f4_t  max[3]     = { -INFINITY, -INFINITY, -INFINITY };
+			for(auto idx : indices) {
+				if(idx == Index::ePrimitiveRestart) continue;
+				auto& pos = dst.vertices[u4_t(idx)].position;
+				for(unsigned c = 0; c < 3; ++c) { min[c] = std::min(min[c], pos[c]); max[c] = std::max(max[c], pos[c]); }
+			}
+			for(unsigned c = 0; c < 3; ++c) mesh.center[c] = (min[c] + max[c]) * 0.5f;
+
+			f4_t radius2 = 0.0f;
+			for(auto idx : indices) {
+				if(idx == Index::ePrimitiveRestart) continue;
+				auto& pos = dst.vertices[u4_t(idx)].position;
+				f4_t  d[3] = { pos[0] - mesh.center[0], pos[1] - mesh.center[1], pos[2] - mesh.center[2] };
+				radius2 = std::max(radius2, (d[0] * d[0]) + (d[1] * d[1]) + (d[2] * d[2]));
+			}
+			mesh.radius = std::sqrt(radius2);
+		});
+	}
+
+
+	/// Simplifies every mesh into up to `levels` LODs, and appends their
+	/// indices to the Index Table.
+	///
+	/// \returns The LOD Table entries, grouped by mesh.
+	///
+	std::vector<Lod> buildLods(ThreadPool& pool, unsigned levels, ReadObjDst& dst) {
+		std::vector<std::vector<SimplifiedMesh>> chains = std::vector<std::vector<SimplifiedMesh>>(dst.meshes.size());
+		pool.forEach(dst.meshes.size(), [&](std::size_t i) {
+			auto& mesh = dst.meshes[i];
+			if(mesh.faceCount == 0) return;
+			auto firstIndex = dst.faces[mesh.firstFace].firstIndex;
+			auto triangles  = triangulateFans(std::span<const Index>(dst.indices).subspan(firstIndex, mesh.indexCount));
+			chains[i] = buildLodChain(triangles, dst.vertices, levels);
+		});
+
+		std::vector<Lod> r;
+		std::vector<u8_t> levelTriangles;
+		for(u4_t meshIdx = 0; meshIdx < chains.size(); ++meshIdx)
+		for(u4_t level = 0; level < chains[meshIdx].size(); ++level) {
+			auto& lod = chains[meshIdx][level];
+			auto  triangleCount = lod.triangles.size() / 3;
+			if(dst.indices.size() + (triangleCount * 4) >= u8_t(Index::ePrimitiveRestart)) {
+				throw std::length_error("Too many indices"); }
+			r.push_back(Lod {
+				.meshIndex  = meshIdx,
+				.indexCount = u4_t(triangleCount * 4),
+				.firstIndex = u4_t(dst.indices.size()),
+				.error      = lod.error });
+			for(std::size_t i = 0; i < lod.triangles.size(); i += 3) {
+				dst.indices.push_back(Index(lod.triangles[i+0]));
+				dst.indices.push_back(Index(lod.triangles[i+1]));
+				dst.indices.push_back(Index(lod.triangles[i+2]));
+				dst.indices.push_back(Index::ePrimitiveRestart);
+			}
+			if(levelTriangles.size() <= level) levelTriangles.resize(level + 1, 0);
+			levelTriangles[level] += triangleCount;
+			lod.triangles = { };
+		}
+
+		for(std::size_t level = 0; level < levelTriangles.size(); ++level) {
+			fmt::print("LOD {:<2} {} triangles\n", level + 1, levelTriangles[level]);
+		}
+		return r;
+	}
+
+
+	/// Partitions the faces of every mesh into meshlets.
+	///
+	/// \returns The contents of the Meshlet Table, grouped by mesh.
+	///
+	MeshletSet buildMeshletTable(ThreadPool& pool, const ReadObjDst& dst) {
+		std::vector<MeshletSet> meshSets = std::vector<MeshletSet>(dst.meshes.size());
+		pool.forEach(dst.meshes.size(), [&](std::size_t i) {
+			auto& mesh = dst.meshes[i];
+			if(mesh.faceCount == 0) return;
+			auto firstIndex = dst.faces[mesh.firstFace].firstIndex;
+			auto triangles  = triangulateFans(std::span<const Index>(dst.indices).subspan(firstIndex, mesh.indexCount));
+			buildMeshlets(meshSets[i], triangles, dst.vertices, u4_t(i));
+		});
+
+		MeshletSet r;
+		for(auto& set : meshSets) {
+			auto vertexOffset   = u4_t(r.vertices.size());
+			auto triangleOffset = u4_t(r.triangles.size() / 3);
+			for(auto& meshlet : set.meshlets) {
+				meshlet.firstVertex   += vertexOffset;
+				meshlet.firstTriangle += triangleOffset;
+			}
+			r.meshlets .insert(r.meshlets .end(), set.meshlets .begin(), set.meshlets .end());
+			r.vertices .insert(r.vertices .end(), set.vertices .begin(), set.vertices .end());
+			r.triangles.insert(r.triangles.end(), set.triangles.begin(), set.triangles.end());
+			set = { };
+		}
+
+		fmt::print("{} meshlets, {:.1f} triangles each\n", r.meshlets.size(), r.meshlets.empty()? 0.0 : double(r.triangles.size() / 3) / double(r.meshlets.size()));
+		return r;
+	}
+
+
+	void compressVertices(ThreadPool& pool, const ReadObjDst& src, std::vector<CompactVertex>& dstVertices, std::vector<VertexBounds>& dstBounds) {
+		constexpr u4_t noMesh = ~ u4_t(0);
+		std::vector<u4_t>   vertexMeshes = std::vector<u4_t>(src.vertices.size(), noMesh);
+		std::vector<Vertex> meshVertices;
+
+		dstBounds.reserve(src.meshes.size());
+		for(u4_t meshIdx = 0; auto& mesh : src.meshes) {
+			meshVertices.clear();
+			if(mesh.faceCount > 0) {
+				u4_t firstIndex = src.faces[mesh.firstFace].firstIndex;
+				for(u4_t i = firstIndex; i < firstIndex + mesh.indexCount; ++i) {
+					auto idx = src.indices[i];
+					if(idx == Index::ePrimitiveRestart) continue;
+					auto& owner = vertexMeshes[u4_t(idx)];
+					assert(owner == noMesh || owner == meshIdx);
+					if(owner == noMesh) {
+						owner = meshIdx;
+						meshVertices.push_back(src.vertices[u4_t(idx)]);
+					}
+				}
+			}
+			dstBounds.push_back(computeVertexBounds(meshVertices));
+			++ meshIdx;
+		}
+
+		constexpr std::size_t verticesPerChunk = 0x10000;
+		dstVertices.resize(src.vertices.size());
+		pool.forEach((src.vertices.size() + verticesPerChunk - 1) / verticesPerChunk, [&](std::size_t chunk) {
+			auto end = std::min((chunk + 1) * verticesPerChunk, src.vertices.size());
+			for(std::size_t i = chunk * verticesPerChunk; i < end; ++i) {
+				auto owner = vertexMeshes[i];
+				dstVertices[i] = compressVertex(src.vertices[i], (owner == noMesh)? VertexBounds { } : dstBounds[owner]);
+			}
+		});
 	}
 
 
 	void convert(const Options& opt) {
 		constexpr auto openFlags = posixfio::OpenFlags::eCreat | posixfio::OpenFlags::eRdwr;
-		auto       headerSpace = allocHeader();
+		const auto& layout      = opt.compactVertices? compactVtxLayout : vtxLayout;
+		const auto  headerSize  = HeaderView::requiredBytesFor(layout);
+		auto        headerSpace = allocHeader(headerSize);
 		HeaderView h = { headerSpace.get(), headerSize };
 		h.magicNumber() = fmamdl::currentMagicNumber;
 
@@ -284,12 +482,35 @@ namespace fmamdl::conv::obj {
 		auto& stringCount         = h.stringCount();
 		auto& stringsBytes        = h.stringStorageSize();
 		auto& stringStorageOffset = h.stringStorageOffset();
-		h.setVertexLayout(vtxLayout);
+		h.setVertexLayout(layout);
 
-		flags = reorderBit8(HeaderFlags::eTriangleFan);
+		{
+			auto flagBits = header_flags_e(HeaderFlags::eTriangleFan);
+			if(opt.compactVertices) flagBits |= header_flags_e(HeaderFlags::eCompactVertices);
+			if(opt.lodLevels > 0)   flagBits |= header_flags_e(HeaderFlags::eLodChains);
+			if(opt.clusters)        flagBits |= header_flags_e(HeaderFlags::eMeshlets);
+			flags = reorderBit8(HeaderFlags(flagBits));
+		}
 
+		ThreadPool pool = ThreadPool(opt.jobs);
 		ReadObjDst dst;
-		readObj(opt, dst);
+		readObj(opt, pool, dst);
+		if(! opt.noOptimization) optimizeMeshes(pool, dst);
+		computeMeshSpheres(pool, dst);
+
+		// LODs reuse the vertices of their mesh, so they are built after
+		// the vertex order is final and before the vertices are compressed
+		std::vector<Lod> lods;
+		if(opt.lodLevels > 0) lods = buildLods(pool, opt.lodLevels, dst);
+		MeshletSet meshlets;
+		if(opt.clusters) meshlets = buildMeshletTable(pool, dst);
+
+		std::vector<CompactVertex> compactVertices;
+		std::vector<VertexBounds>  vertexBounds;
+		if(opt.compactVertices) {
+			compressVertices(pool, dst, compactVertices, vertexBounds);
+			dst.vertices = { };
+		}
 		stringCount   = dst.strings.map.size();
 		stringsBytes  = dst.strings.bytes.size();
 		materialCount = dst.materials.size();
@@ -297,14 +518,19 @@ namespace fmamdl::conv::obj {
 		boneCount     = dst.bones.size();
 		faceCount     = dst.faces.size();
 		indexCount    = dst.indices.size();
-		vertexCount   = dst.vertices.size();
+		vertexCount   = opt.compactVertices? compactVertices.size() : dst.vertices.size();
 		size_t stringStorageSize = align<8>(stringsBytes);
 		size_t materialTableSize = align<8>(materialCount * sizeof(Material));
 		size_t meshTableSize     = align<8>(meshCount * sizeof(Mesh));
 		size_t boneTableSize     = align<8>(boneCount * sizeof(Bone));
 		size_t faceTableSize     = align<8>(faceCount * sizeof(Face));
 		size_t indexTableSize    = align<8>(indexCount * sizeof(Index));
-		size_t vertexTableSize   = align<8>(vertexCount * sizeof(Vertex));
+		size_t vertexTableSize   = align<8>(vertexCount * (opt.compactVertices? sizeof(CompactVertex) : sizeof(Vertex)));
+		size_t boundsTableSize   = align<8>(vertexBounds.size() * sizeof(VertexBounds));
+		size_t lodTableSize      = (opt.lodLevels > 0)? 8 + align<8>(lods.size() * sizeof(Lod)) : 0;
+		size_t meshletVtxOffset  = (3 * sizeof(u8_t)) + (meshlets.meshlets.size() * sizeof(Meshlet));
+		size_t meshletTriOffset  = meshletVtxOffset + align<8>(meshlets.vertices.size() * sizeof(u4_t));
+		size_t meshletTableSize  = opt.clusters? meshletTriOffset + align<8>(meshlets.triangles.size()) : 0;
 		stringStorageOffset = align<8>(headerSize);
 		materialTableOffset = stringStorageOffset + stringStorageSize;
 		meshTableOffset     = materialTableOffset + materialTableSize;
@@ -314,23 +540,53 @@ namespace fmamdl::conv::obj {
 		vertexTableOffset   = indexTableOffset + indexTableSize;
 
 		if(! opt.onlyMaterials) { // Write the model file
-			size_t fileSize = vertexTableOffset + vertexTableSize;
+			// Every offset is known by now, so the tables are streamed in file order
+			// and each one is released as soon as it has been written
+			constexpr std::byte zeroes[8] = { };
+			size_t lodTableOffset = vertexTableOffset + vertexTableSize + (opt.compactVertices? boundsTableSize : 0);
+			size_t meshletTableOffset = lodTableOffset + lodTableSize;
+			size_t fileSize       = meshletTableOffset + meshletTableSize;
 			auto   output   = posixfio::File::open(opt.dstName.data(), openFlags, 0660);
 			output.ftruncate(fileSize);
-			posixfio::MemMapping map = output.mmap(
-				fileSize,
-				posixfio::MemProtFlags::eWrite,
-				posixfio::MemMapFlags::eShared,
-				0 );
-			auto* pmap = map.get<std::byte>();
-			memcpy(pmap,                     h.data,                   headerSize);
-			memcpy(pmap+stringStorageOffset, dst.strings.bytes.data(), stringStorageSize);
-			memcpy(pmap+materialTableOffset, dst.materials.data(),     materialTableSize);
-			memcpy(pmap+meshTableOffset,     dst.meshes.data(),        meshTableSize);
-			memcpy(pmap+boneTableOffset,     dst.bones.data(),         boneTableSize);
-			memcpy(pmap+faceTableOffset,     dst.faces.data(),         faceTableSize);
-			memcpy(pmap+indexTableOffset,    dst.indices.data(),       indexTableSize);
-			memcpy(pmap+vertexTableOffset,   dst.vertices.data(),      vertexTableSize);
+			auto   outBuf   = posixfio::OutputBuffer(output, 1 << 20);
+			size_t cursor   = 0;
+			auto writeTable = [&]<typename T>(size_t offset, T& table) {
+				using value_t = typename T::value_type;
+				assert(offset >= cursor && offset - cursor < sizeof(zeroes));
+				outBuf.writeAll(zeroes, offset - cursor);
+				outBuf.writeAll(table.data(), table.size() * sizeof(value_t));
+				cursor = offset + (table.size() * sizeof(value_t));
+				table = { };
+			};
+			outBuf.writeAll(h.data, headerSize);
+			cursor = headerSize;
+			writeTable(stringStorageOffset, dst.strings.bytes);
+			writeTable(materialTableOffset, dst.materials);
+			writeTable(meshTableOffset,     dst.meshes);
+			writeTable(boneTableOffset,     dst.bones);
+			writeTable(faceTableOffset,     dst.faces);
+			writeTable(indexTableOffset,    dst.indices);
+			if(opt.compactVertices) {
+				// The Vertex Bounds Table immediately follows the (8-aligned) Vertex Table
+				writeTable(vertexTableOffset,                   compactVertices);
+				writeTable(vertexTableOffset + vertexTableSize, vertexBounds);
+			} else {
+				writeTable(vertexTableOffset, dst.vertices);
+			}
+			if(opt.lodLevels > 0) {
+				auto lodCount = std::vector<u8_t> { u8_t(lods.size()) };
+				writeTable(lodTableOffset,     lodCount);
+				writeTable(lodTableOffset + 8, lods);
+			}
+			if(opt.clusters) {
+				auto counts = std::vector<u8_t> { meshlets.meshlets.size(), meshlets.vertices.size(), meshlets.triangles.size() / 3 };
+				writeTable(meshletTableOffset,                    counts);
+				writeTable(meshletTableOffset + 3 * sizeof(u8_t), meshlets.meshlets);
+				writeTable(meshletTableOffset + meshletVtxOffset, meshlets.vertices);
+				writeTable(meshletTableOffset + meshletTriOffset, meshlets.triangles);
+			}
+			outBuf.writeAll(zeroes, fileSize - cursor);
+			outBuf.flush();
 		}
 
 		if(! opt.noMaterials)
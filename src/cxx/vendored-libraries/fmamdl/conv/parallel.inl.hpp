@@ -0,0 +1,246 @@
+#pragma once
+
+#include "util.inl.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fmamdl/fmamdl.hpp>
+
+
+
+namespace fmamdl::conv {
+
+	/// \brief A fixed set of worker threads, which cooperate with
+	///        the calling thread to run parallel loops.
+	///
+	class ThreadPool {
+	public:
+		/// \param threadCount The total number of threads that run a loop,
+		///        including the calling one; 0 means one per hardware thread.
+		///
+		explicit ThreadPool(unsigned threadCount) {
+			if(threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			pool_workers.reserve(threadCount - 1);
+			for(unsigned i = 1; i < threadCount; ++i) pool_workers.emplace_back([this]() { work(); });
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool() {
+			{
+				auto lock = std::unique_lock(pool_mutex);
+				pool_quit = true;
+			}
+			pool_wakeCv.notify_all();
+			for(auto& worker : pool_workers) worker.join();
+		}
+
+		unsigned threadCount() const noexcept { return pool_workers.size() + 1; }
+
+		/// \brief Calls `fn(i)` for every `i` in `[0, count)`, in no particular
+		///        order, and returns once all calls have returned.
+		///
+		/// If any call throws, the remaining items are skipped and
+		/// the first exception is rethrown by this function.
+		///
+		void forEach(std::size_t count, const std::function<void (std::size_t)>& fn) {
+			if(count == 0) return;
+			{
+				auto lock = std::unique_lock(pool_mutex);
+				pool_job         = &fn;
+				pool_jobCount    = count;
+				pool_busyWorkers = pool_workers.size();
+				pool_exception   = nullptr;
+				pool_nextItem.store(0, std::memory_order_relaxed);
+				++ pool_generation;
+			}
+			pool_wakeCv.notify_all();
+			runJob();
+			{
+				auto lock = std::unique_lock(pool_mutex);
+				pool_doneCv.wait(lock, [&]() { return pool_busyWorkers == 0; });
+				pool_job = nullptr;
+			}
+			if(pool_exception) std::rethrow_exception(std::exchange(pool_exception, nullptr));
+		}
+
+	private:
+		std::vector<std::thread> pool_workers;
+		std::mutex               pool_mutex;
+		std::condition_variable  pool_wakeCv;
+		std::condition_variable  pool_doneCv;
+		std::exception_ptr       pool_exception;
+		const std::function<void (std::size_t)>* pool_job = nullptr;
+		std::size_t              pool_jobCount    = 0;
+		std::atomic_size_t       pool_nextItem    = 0;
+		unsigned                 pool_generation  = 0;
+		unsigned                 pool_busyWorkers = 0;
+		bool                     pool_quit        = false;
+
+		void runJob() {
+			for(;;) {
+				auto i = pool_nextItem.fetch_add(1, std::memory_order_relaxed);
+				if(i >= pool_jobCount) return;
+				try {
+					(*pool_job)(i);
+				} catch(...) {
+					auto lock = std::unique_lock(pool_mutex);
+					if(! pool_exception) pool_exception = std::current_exception();
+					pool_nextItem.store(pool_jobCount, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void work() {
+			unsigned seenGeneration = 0;
+			for(;;) {
+				{
+					auto lock = std::unique_lock(pool_mutex);
+					pool_wakeCv.wait(lock, [&]() { return pool_quit || pool_generation != seenGeneration; });
+					if(pool_quit) return;
+					seenGeneration = pool_generation;
+				}
+				runJob();
+				{
+					auto lock = std::unique_lock(pool_mutex);
+					if(-- pool_busyWorkers == 0) pool_doneCv.notify_all();
+				}
+			}
+		}
+	};
+
+
+	/// \brief A vertex deduplication table that many threads can insert into.
+	///
+	/// Vertices are compared by position, texture coordinates and normal,
+	/// plus a group number that keeps vertices of different groups apart.
+	/// The table is split into shards, each with its own lock, chosen by
+	/// the vertex hash; insertions return a provisional index, which
+	/// `collect` later turns into a final one.
+	///
+	/// When a vertex is inserted more than once, it keeps the tangents
+	/// of the insertion with the highest *tangent source*, so that the
+	/// result does not depend on the order in which threads get there.
+	///
+	class ShardedVertexSet {
+	public:
+		static constexpr unsigned shardBits  = 6;
+		static constexpr unsigned shardCount = 1u << shardBits;
+		static constexpr u4_t     maxLocalIndex = (~ u4_t(0) >> shardBits) - 1;
+
+		ShardedVertexSet(): vs_shards(std::make_unique<Shard[]>(shardCount)) { }
+
+		void reserve(std::size_t vertexCount) {
+			auto perShard = (vertexCount / shardCount) + (vertexCount / (shardCount * 8));
+			for(unsigned i = 0; i < shardCount; ++i) {
+				vs_shards[i].entries.reserve(perShard);
+				vs_shards[i].set.reserve(perShard);
+			}
+		}
+
+		/// \returns The provisional index of the vertex.
+		///
+		u4_t insert(const Vertex& vtx, u4_t group, u8_t tangentSource) {
+			auto  hash  = EntryHash::hash(vtx, group);
+			auto  shard = unsigned((hash * 0x9e3779b97f4a7c15ull) >> (64 - shardBits));
+			auto& s     = vs_shards[shard];
+			auto  lock  = std::unique_lock(s.mutex);
+
+			u4_t local = s.entries.size();
+			s.entries.push_back(Entry { vtx, tangentSource, group });
+			auto ins = s.set.insert(local);
+			if(ins.second) {
+				if(local > maxLocalIndex) throw std::length_error("Too many vertices");
+			} else {
+				s.entries.pop_back();
+				local = *ins.first;
+				auto& existing = s.entries[local];
+				if(existing.tangentSource < tangentSource) {
+					memcpy(existing.vertex.tangent,   vtx.tangent,   sizeof(Vertex::tangent));
+					memcpy(existing.vertex.bitangent, vtx.bitangent, sizeof(Vertex::bitangent));
+					existing.tangentSource = tangentSource;
+				}
+			}
+			return (local << shardBits) | shard;
+		}
+
+		/// \brief Replaces provisional indices with final ones, assigned in order
+		///        of first use, and moves the vertices out of the set.
+		///
+		/// The numbering is the same that a sequential insertion
+		/// in index order would produce.
+		///
+		std::vector<Vertex> collect(std::span<Index> indices) {
+			constexpr u4_t unassigned = ~ u4_t(0);
+			std::size_t vertexCount = 0;
+			auto remap = std::make_unique<std::vector<u4_t>[]>(shardCount);
+			for(unsigned i = 0; i < shardCount; ++i) {
+				remap[i].resize(vs_shards[i].entries.size(), unassigned);
+				vertexCount += vs_shards[i].entries.size();
+			}
+
+			std::vector<Vertex> r;
+			r.reserve(vertexCount);
+			for(auto& idx : indices) {
+				if(idx == Index::ePrimitiveRestart) continue;
+				auto  provisional = u4_t(idx);
+				auto  shard       = provisional & (shardCount - 1);
+				auto  local       = provisional >> shardBits;
+				auto& finalIdx    = remap[shard][local];
+				if(finalIdx == unassigned) {
+					finalIdx = r.size();
+					r.push_back(vs_shards[shard].entries[local].vertex);
+				}
+				idx = Index(finalIdx);
+			}
+
+			vs_shards = std::make_unique<Shard[]>(shardCount);
+			return r;
+		}
+
+	private:
+		struct Entry {
+			Vertex vertex;
+			u8_t   tangentSource;
+			u4_t   group;
+		};
+
+		struct EntryHash {
+			const std::vector<Entry>* entries;
+			static std::size_t hash(const Vertex& vtx, u4_t group) noexcept { return VertexHash()(vtx) ^ std::rotr<std::size_t>(group, 13); }
+			std::size_t operator()(u4_t i) const noexcept { auto& e = (*entries)[i]; return hash(e.vertex, e.group); }
+		};
+
+		struct EntryEq {
+			const std::vector<Entry>* entries;
+			bool operator()(u4_t l, u4_t r) const noexcept {
+				auto& el = (*entries)[l];
+				auto& er = (*entries)[r];
+				return (el.group == er.group) && std::equal_to<Vertex>()(el.vertex, er.vertex);
+			}
+		};
+
+		struct Shard {
+			std::mutex         mutex;
+			std::vector<Entry> entries;
+			std::unordered_set<u4_t, EntryHash, EntryEq> set = std::unordered_set<u4_t, EntryHash, EntryEq>(0, EntryHash { &entries }, EntryEq { &entries });
+		};
+
+		std::unique_ptr<Shard[]> vs_shards;
+	};
+
+}
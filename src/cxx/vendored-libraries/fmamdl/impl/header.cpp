@@ -134,6 +134,73 @@ namespace fmamdl {
 	const u8_t&   HeaderView::vertexCount()       const { return accessPrimitive<u8_t>(data, length, mdl::OFF_VTX_COUNT); }
 	const Vertex* HeaderView::vertexPtr()         const { return reinterpret_cast<const Vertex*>(data + vertexTableOffset()); }
 
+	const CompactVertex* HeaderView::compactVertexPtr() const { return reinterpret_cast<const CompactVertex*>(data + vertexTableOffset()); }
+
+	const VertexBounds* HeaderView::vertexBoundsPtr() const {
+		auto tableEnd = vertexTableOffset() + (vertexCount() * sizeof(CompactVertex));
+		tableEnd += (8 - (tableEnd % 8)) % 8;
+		return reinterpret_cast<const VertexBounds*>(data + tableEnd);
+	}
+
+
+	bool HeaderView::hasCompactVertices() const {
+		// Flags are stored as big-endian bit sequences
+		auto flagBits = std::byteswap(header_flags_e(flags()));
+		return 0 != (flagBits & header_flags_e(HeaderFlags::eCompactVertices));
+	}
+
+
+	bool HeaderView::hasLodChains() const {
+		auto flagBits = std::byteswap(header_flags_e(flags()));
+		return 0 != (flagBits & header_flags_e(HeaderFlags::eLodChains));
+	}
+
+
+	std::size_t HeaderView::lodTableOffset() const {
+		auto tableEnd = vertexTableOffset() + (vertexCount() * vertexStride());
+		tableEnd += (8 - (tableEnd % 8)) % 8;
+		if(hasCompactVertices()) {
+			tableEnd += meshCount() * sizeof(VertexBounds);
+			tableEnd += (8 - (tableEnd % 8)) % 8;
+		}
+		return tableEnd;
+	}
+
+	const u8_t& HeaderView::lodCount() const { return accessPrimitive<u8_t>(data, length, lodTableOffset()); }
+	const Lod*  HeaderView::lodPtr()   const { return reinterpret_cast<const Lod*>(data + lodTableOffset() + sizeof(u8_t)); }
+
+
+	bool HeaderView::hasMeshlets() const {
+		auto flagBits = std::byteswap(header_flags_e(flags()));
+		return 0 != (flagBits & header_flags_e(HeaderFlags::eMeshlets));
+	}
+
+
+	std::size_t HeaderView::meshletTableOffset() const {
+		auto tableEnd = lodTableOffset();
+		if(hasLodChains()) {
+			tableEnd += sizeof(u8_t) + (lodCount() * sizeof(Lod));
+			tableEnd += (8 - (tableEnd % 8)) % 8;
+		}
+		return tableEnd;
+	}
+
+	const u8_t&    HeaderView::meshletCount()         const { return accessPrimitive<u8_t>(data, length, meshletTableOffset()); }
+	const u8_t&    HeaderView::meshletVertexCount()   const { return accessPrimitive<u8_t>(data, length, meshletTableOffset() + (1 * sizeof(u8_t))); }
+	const u8_t&    HeaderView::meshletTriangleCount() const { return accessPrimitive<u8_t>(data, length, meshletTableOffset() + (2 * sizeof(u8_t))); }
+	const Meshlet* HeaderView::meshletPtr()           const { return reinterpret_cast<const Meshlet*>(data + meshletTableOffset() + (3 * sizeof(u8_t))); }
+
+	const u4_t* HeaderView::meshletVertexPtr() const {
+		auto tableEnd = meshletTableOffset() + (3 * sizeof(u8_t)) + (meshletCount() * sizeof(Meshlet));
+		return reinterpret_cast<const u4_t*>(data + tableEnd);
+	}
+
+	const u1_t* HeaderView::meshletTrianglePtr() const {
+		auto tableEnd = meshletTableOffset() + (3 * sizeof(u8_t)) + (meshletCount() * sizeof(Meshlet)) + (meshletVertexCount() * sizeof(u4_t));
+		tableEnd += (8 - (tableEnd % 8)) % 8;
+		return reinterpret_cast<const u1_t*>(data + tableEnd);
+	}
+
 
 	std::size_t HeaderView::requiredBytesFor(const Layout& layout) noexcept {
 		return
@@ -0,0 +1,203 @@
+#include <fmamdl/meshlet.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+
+
+namespace fmamdl {
+
+	namespace mlt {
+
+		constexpr u4_t nullIndex = ~ u4_t(0);
+
+		/// Cones narrower than this (as the cosine of the angle between the
+		/// axis and the farthest triangle normal) are not worth testing.
+		///
+		constexpr double minConeDot = 0.1;
+
+
+		struct Vec3 {
+			double x, y, z;
+
+			Vec3 operator+(const Vec3& r) const noexcept { return { x + r.x, y + r.y, z + r.z }; }
+			Vec3 operator-(const Vec3& r) const noexcept { return { x - r.x, y - r.y, z - r.z }; }
+			Vec3 operator*(double s)      const noexcept { return { x * s, y * s, z * s }; }
+			double dot(const Vec3& r)     const noexcept { return (x * r.x) + (y * r.y) + (z * r.z); }
+			Vec3 cross(const Vec3& r)     const noexcept { return { (y * r.z) - (z * r.y), (z * r.x) - (x * r.z), (x * r.y) - (y * r.x) }; }
+			double length()               const noexcept { return std::sqrt(dot(*this)); }
+
+			static Vec3 of(const Vertex& v) noexcept { return { v.position[0], v.position[1], v.position[2] }; }
+		};
+
+
+		void computeBounds(Meshlet& meshlet, const MeshletSet& set, std::span<const Vertex> vertices) {
+			auto localPos = [&](unsigned i) { return Vec3::of(vertices[set.vertices[meshlet.firstVertex + i]]); };
+			auto corner   = [&](unsigned t, unsigned c) { return localPos(set.triangles[((meshlet.firstTriangle + t) * 3) + c]); };
+
+			// Bounding sphere: center of the AABB, farthest vertex
+			Vec3 min = localPos(0);
+			Vec3 max = min;
+			for(unsigned i = 1; i < meshlet.vertexCount; ++i) {
+				auto p = localPos(i);
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+			Vec3 center = (min + max) * 0.5;
+			center = { double(f4_t(center.x)), double(f4_t(center.y)), double(f4_t(center.z)) }; // As stored
+			double radius = 0.0;
+			for(unsigned i = 0; i < meshlet.vertexCount; ++i) radius = std::max(radius, (localPos(i) - center).length());
+
+			// Normal cone: area-weighted average normal, widest triangle normal
+			Vec3 axis = { 0.0, 0.0, 0.0 };
+			for(unsigned t = 0; t < meshlet.triangleCount; ++t) {
+				auto p0 = corner(t, 0);
+				axis = axis + (corner(t, 1) - p0).cross(corner(t, 2) - p0);
+			}
+			double axisLen = axis.length();
+			double minDot  = -1.0;
+			if(axisLen > 0.0) {
+				axis   = axis * (1.0 / axisLen);
+				minDot = 1.0;
+				for(unsigned t = 0; t < meshlet.triangleCount; ++t) {
+					auto p0 = corner(t, 0);
+					auto n  = (corner(t, 1) - p0).cross(corner(t, 2) - p0);
+					auto nLen = n.length();
+					if(! (nLen > 0.0)) continue; // Degenerate triangles are never rasterized
+					minDot = std::min(minDot, n.dot(axis) / nLen);
+				}
+			}
+
+			meshlet.center[0] = f4_t(center.x);
+			meshlet.center[1] = f4_t(center.y);
+			meshlet.center[2] = f4_t(center.z);
+			meshlet.radius    = std::nextafter(f4_t(radius), std::numeric_limits<f4_t>::infinity());
+			meshlet.coneAxis[0] = f4_t(axis.x);
+			meshlet.coneAxis[1] = f4_t(axis.y);
+			meshlet.coneAxis[2] = f4_t(axis.z);
+			if(minDot <= minConeDot) {
+				meshlet.coneCutoff = 1.0f;
+			} else {
+				// The axis is rounded to single precision, so the cone is slightly widened
+				meshlet.coneCutoff = std::min(1.0f, f4_t(std::sqrt(1.0 - (minDot * minDot))) + 1e-5f);
+			}
+		}
+
+	}
+
+
+	void buildMeshlets(
+			MeshletSet& dst,
+			std::span<const u4_t>   triangles,
+			std::span<const Vertex> vertices,
+			u4_t meshIndex
+	) {
+		using mlt::Vec3;
+		assert(triangles.size() % 3 == 0);
+		if(triangles.empty()) return;
+		auto triangleCount = triangles.size() / 3;
+
+		// Vertex -> triangle adjacency, as offsets into a flat list
+		std::vector<u4_t> adjOffsets(vertices.size() + 1, 0);
+		std::vector<u4_t> adjTriangles(triangles.size());
+		for(auto v : triangles) { assert(v < vertices.size()); ++ adjOffsets[v + 1]; }
+		for(std::size_t i = 1; i < adjOffsets.size(); ++i) adjOffsets[i] += adjOffsets[i - 1];
+		{
+			auto cursors = std::vector<u4_t>(adjOffsets.begin(), adjOffsets.end() - 1);
+			for(std::size_t t = 0; t < triangleCount; ++t)
+			for(unsigned c = 0; c < 3; ++c) adjTriangles[cursors[triangles[(t*3) + c]] ++] = u4_t(t);
+		}
+
+		// Maps vertex indices to local indices of the current meshlet
+		std::vector<u4_t> localIndices(vertices.size(), mlt::nullIndex);
+		std::vector<bool> emitted(triangleCount, false);
+		std::size_t       nextSeed = 0;
+
+		Meshlet current = { };
+		Vec3    positionSum = { 0.0, 0.0, 0.0 };
+		auto startMeshlet = [&]() {
+			current = { };
+			current.meshIndex     = meshIndex;
+			current.firstVertex   = u4_t(dst.vertices.size());
+			current.firstTriangle = u4_t(dst.triangles.size() / 3);
+			positionSum = { 0.0, 0.0, 0.0 };
+		};
+		auto flushMeshlet = [&]() {
+			if(current.triangleCount == 0) return;
+			mlt::computeBounds(current, dst, vertices);
+			for(u4_t i = 0; i < current.vertexCount; ++i) localIndices[dst.vertices[current.firstVertex + i]] = mlt::nullIndex;
+			dst.meshlets.push_back(current);
+			startMeshlet();
+		};
+		auto newVertexCount = [&](std::size_t t) {
+			unsigned r = 0;
+			for(unsigned c = 0; c < 3; ++c) r += (localIndices[triangles[(t*3) + c]] == mlt::nullIndex)? 1 : 0;
+			return r;
+		};
+		auto appendTriangle = [&](std::size_t t) {
+			for(unsigned c = 0; c < 3; ++c) {
+				auto  v     = triangles[(t*3) + c];
+				auto& local = localIndices[v];
+				if(local == mlt::nullIndex) {
+					local = current.vertexCount ++;
+					dst.vertices.push_back(v);
+					positionSum = positionSum + Vec3::of(vertices[v]);
+				}
+				dst.triangles.push_back(u1_t(local));
+			}
+			++ current.triangleCount;
+			emitted[t] = true;
+		};
+
+		// Meshlets grow through shared vertices, preferring the triangles that add
+		// the fewest new vertices and then the ones closest to the meshlet's centroid;
+		// when no neighbor fits, the next meshlet starts from the first triangle
+		// not yet emitted, so that the input order is roughly preserved
+		startMeshlet();
+		for(std::size_t emittedCount = 0; emittedCount < triangleCount; ++ emittedCount) {
+			std::size_t best = mlt::nullIndex;
+			if(current.triangleCount > 0 && current.triangleCount < maxMeshletTriangles) {
+				auto     centroid  = positionSum * (1.0 / double(current.vertexCount));
+				unsigned bestNew   = 4;
+				double   bestDist2 = 0.0;
+				for(u4_t i = 0; i < current.vertexCount; ++i) {
+					auto v = dst.vertices[current.firstVertex + i];
+					for(u4_t a = adjOffsets[v]; a < adjOffsets[v + 1]; ++a) {
+						auto t = adjTriangles[a];
+						if(emitted[t]) continue;
+						auto newVtx = newVertexCount(t);
+						if(current.vertexCount + newVtx > maxMeshletVertices || newVtx > bestNew) continue;
+						auto triCenter = (Vec3::of(vertices[triangles[t*3]]) + Vec3::of(vertices[triangles[(t*3)+1]]) + Vec3::of(vertices[triangles[(t*3)+2]])) * (1.0 / 3.0);
+						auto dist2 = (triCenter - centroid).dot(triCenter - centroid);
+						if(newVtx < bestNew || dist2 < bestDist2) {
+							best      = t;
+							bestNew   = newVtx;
+							bestDist2 = dist2;
+						}
+					}
+				}
+			}
+
+			if(best == mlt::nullIndex) {
+				flushMeshlet();
+				while(emitted[nextSeed]) ++ nextSeed;
+				best = nextSeed;
+			}
+			appendTriangle(best);
+		}
+		flushMeshlet();
+	}
+
+
+	bool isMeshletBackFacing(const Meshlet& meshlet, const f4_t (&viewPos)[3]) noexcept {
+		if(meshlet.coneCutoff >= 1.0f) return false;
+		f4_t d[3] = { meshlet.center[0] - viewPos[0], meshlet.center[1] - viewPos[1], meshlet.center[2] - viewPos[2] };
+		f4_t dist = std::sqrt((d[0] * d[0]) + (d[1] * d[1]) + (d[2] * d[2]));
+		f4_t dAxis = (d[0] * meshlet.coneAxis[0]) + (d[1] * meshlet.coneAxis[1]) + (d[2] * meshlet.coneAxis[2]);
+		return dAxis >= (meshlet.coneCutoff * dist) + meshlet.radius;
+	}
+
+}
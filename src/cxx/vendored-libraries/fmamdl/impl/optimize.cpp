@@ -0,0 +1,350 @@
+#include <fmamdl/optimize.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+
+
+namespace fmamdl {
+
+	namespace opt {
+
+		// Calls `fn(first, count)` for each fan, where `first` is the position of its first index
+		template <typename Fn>
+		void forEachFan(std::span<const Index> indices, Fn&& fn) {
+			std::size_t first = 0;
+			for(std::size_t i = 0; i <= indices.size(); ++i) {
+				if(i == indices.size() || indices[i] == Index::ePrimitiveRestart) {
+					if(i > first) fn(first, i - first);
+					first = i + 1;
+				}
+			}
+		}
+
+
+		/// FIFO cache simulation through timestamps: a vertex is cached
+		/// if it was inserted less than `size` insertions ago.
+		///
+		struct FifoCache {
+			std::vector<u8_t> stamps;
+			u8_t     time;
+			unsigned size;
+
+			FifoCache(std::size_t vertexCount, unsigned size):
+				stamps(vertexCount, 0),
+				time(size + 1),
+				size(size)
+			{ }
+
+			void reset() noexcept { time += size + 1; }
+
+			/// \returns Whether the vertex was a cache miss.
+			///
+			bool reference(u4_t vertex) noexcept {
+				if(time - stamps[vertex] <= size) return false;
+				stamps[vertex] = time ++;
+				return true;
+			}
+
+			/// \returns The number of cache misses of a fan's triangles.
+			///
+			template <typename IndexFn>
+			u8_t referenceFan(std::size_t count, IndexFn&& indexAt) noexcept {
+				u8_t misses = 0;
+				for(std::size_t i = 1; i + 1 < count; ++i) {
+					misses += reference(indexAt(0));
+					misses += reference(indexAt(i));
+					misses += reference(indexAt(i + 1));
+				}
+				return misses;
+			}
+		};
+
+
+		struct Vec3 {
+			double x, y, z;
+
+			Vec3 operator+(const Vec3& r) const noexcept { return { x + r.x, y + r.y, z + r.z }; }
+			Vec3 operator-(const Vec3& r) const noexcept { return { x - r.x, y - r.y, z - r.z }; }
+			Vec3 operator*(double s)      const noexcept { return { x * s, y * s, z * s }; }
+			double dot(const Vec3& r)     const noexcept { return (x * r.x) + (y * r.y) + (z * r.z); }
+			Vec3 cross(const Vec3& r)     const noexcept { return { (y * r.z) - (z * r.y), (z * r.x) - (x * r.z), (x * r.y) - (y * r.x) }; }
+			double length()               const noexcept { return std::sqrt(dot(*this)); }
+
+			static Vec3 of(const Vertex& v) noexcept { return { v.position[0], v.position[1], v.position[2] }; }
+		};
+
+
+		/// Area-weighted centroid and normal of a set of fans.
+		///
+		struct Surface {
+			Vec3   centroidSum = { };
+			Vec3   normalSum   = { };
+			double area        = 0.0;
+
+			void addFan(std::span<const Index> indices, std::span<const Vertex> vertices, std::size_t first, std::size_t count) noexcept {
+				auto p0 = Vec3::of(vertices[u4_t(indices[first])]);
+				for(std::size_t i = 1; i + 1 < count; ++i) {
+					auto p1 = Vec3::of(vertices[u4_t(indices[first + i])]);
+					auto p2 = Vec3::of(vertices[u4_t(indices[first + i + 1])]);
+					auto crs = (p1 - p0).cross(p2 - p0);
+					auto triArea = crs.length() * 0.5;
+					centroidSum = centroidSum + ((p0 + p1 + p2) * (triArea / 3.0));
+					normalSum   = normalSum + crs;
+					area       += triArea;
+				}
+			}
+
+			Vec3 centroid() const noexcept { return (area > 0.0)? centroidSum * (1.0 / area) : centroidSum; }
+
+			Vec3 normal() const noexcept {
+				auto len = normalSum.length();
+				return (len > 0.0)? normalSum * (1.0 / len) : normalSum;
+			}
+		};
+
+	}
+
+
+	VertexCacheStats computeVertexCacheStats(std::span<const Index> indices, unsigned cacheSize) {
+		VertexCacheStats r = { };
+
+		u4_t maxIndex = 0;
+		for(auto idx : indices) if(idx != Index::ePrimitiveRestart) maxIndex = std::max(maxIndex, u4_t(idx));
+		std::vector<bool> referenced = std::vector<bool>(std::size_t(maxIndex) + 1, false);
+		auto cache = opt::FifoCache(std::size_t(maxIndex) + 1, cacheSize);
+
+		opt::forEachFan(indices, [&](std::size_t first, std::size_t count) {
+			if(count >= 3) r.triangleCount += count - 2;
+			r.cacheMisses += cache.referenceFan(count, [&](std::size_t i) { return u4_t(indices[first + i]); });
+			for(std::size_t i = 0; i < count; ++i) {
+				auto v = u4_t(indices[first + i]);
+				if(! referenced[v]) { referenced[v] = true; ++ r.vertexCount; }
+			}
+		});
+
+		return r;
+	}
+
+
+	void optimizeFaceOrder(
+		std::span<Face>         faces,
+		std::span<Index>        indices,
+		std::span<const Vertex> vertices,
+		unsigned cacheSize,
+		f4_t overdrawThreshold
+	) {
+		if(faces.size() < 2) return;
+		const std::size_t faceCount = faces.size();
+
+		// Compact the mesh's vertices into a local range, since a mesh may only use a few of the model's
+		std::vector<u4_t> localVertices;
+		std::vector<u4_t> faceVertices;
+		std::vector<std::size_t> faceOffsets;
+		faceOffsets.reserve(faceCount + 1);
+		for(auto& face : faces) {
+			faceOffsets.push_back(faceVertices.size());
+			for(u4_t i = 0; i < face.indexCount; ++i) faceVertices.push_back(u4_t(indices[face.firstIndex + i]));
+		}
+		faceOffsets.push_back(faceVertices.size());
+		localVertices = faceVertices;
+		std::sort(localVertices.begin(), localVertices.end());
+		localVertices.erase(std::unique(localVertices.begin(), localVertices.end()), localVertices.end());
+		for(auto& v : faceVertices) v = u4_t(std::lower_bound(localVertices.begin(), localVertices.end(), v) - localVertices.begin());
+		const std::size_t vertexCount = localVertices.size();
+		auto faceSize = [&](std::size_t f) { return faceOffsets[f + 1] - faceOffsets[f]; };
+
+		// Vertex -> face adjacency, and the cost of each vertex's live faces (in cache insertions)
+		std::vector<std::size_t> adjOffsets = std::vector<std::size_t>(vertexCount + 1, 0);
+		std::vector<std::size_t> liveCosts  = std::vector<std::size_t>(vertexCount, 0);
+		for(std::size_t f = 0; f < faceCount; ++f)
+		for(std::size_t i = faceOffsets[f]; i < faceOffsets[f + 1]; ++i) {
+			++ adjOffsets[faceVertices[i] + 1];
+			liveCosts[faceVertices[i]] += faceSize(f) - 1;
+		}
+		for(std::size_t v = 0; v < vertexCount; ++v) adjOffsets[v + 1] += adjOffsets[v];
+		std::vector<u4_t> adjFaces = std::vector<u4_t>(adjOffsets.back());
+		{
+			auto cursors = std::vector<std::size_t>(adjOffsets.begin(), adjOffsets.end() - 1);
+			for(std::size_t f = 0; f < faceCount; ++f)
+			for(std::size_t i = faceOffsets[f]; i < faceOffsets[f + 1]; ++i) {
+				adjFaces[cursors[faceVertices[i]] ++] = f;
+			}
+		}
+
+		// Tipsify
+		std::vector<u4_t>        order;
+		std::vector<std::size_t> hardBoundaries;
+		{
+			std::vector<bool> emitted = std::vector<bool>(faceCount, false);
+			std::vector<u4_t> deadEnd;
+			std::vector<u4_t> candidates;
+			std::vector<u8_t> cacheTimes = std::vector<u8_t>(vertexCount, 0);
+			u8_t        time   = cacheSize + 1;
+			std::size_t cursor = 0;
+			long long   fanningVertex = faceVertices.front();
+			order.reserve(faceCount);
+			hardBoundaries.push_back(0);
+
+			while(fanningVertex >= 0) {
+				candidates.clear();
+				for(std::size_t a = adjOffsets[fanningVertex]; a < adjOffsets[fanningVertex + 1]; ++a) {
+					auto f = adjFaces[a];
+					if(emitted[f]) continue;
+					emitted[f] = true;
+					order.push_back(f);
+					for(std::size_t i = faceOffsets[f]; i < faceOffsets[f + 1]; ++i) {
+						auto v = faceVertices[i];
+						deadEnd.push_back(v);
+						candidates.push_back(v);
+						liveCosts[v] -= faceSize(f) - 1;
+						if(time - cacheTimes[v] > cacheSize) cacheTimes[v] = time ++;
+					}
+				}
+
+				// Prefer the vertex that stays in the cache after its remaining faces are emitted, and has been in it the longest
+				long long best         = -1;
+				long long bestPriority = -1;
+				for(auto v : candidates) {
+					if(liveCosts[v] == 0) continue;
+					long long priority = 0;
+					if(time - cacheTimes[v] + liveCosts[v] <= cacheSize) priority = time - cacheTimes[v];
+					if(priority > bestPriority) { best = v; bestPriority = priority; }
+				}
+
+				if(best < 0) {
+					while(! deadEnd.empty()) {
+						auto v = deadEnd.back();
+						deadEnd.pop_back();
+						if(liveCosts[v] > 0) { best = v; break; }
+					}
+					while(best < 0 && cursor < vertexCount) {
+						if(liveCosts[cursor] > 0) best = cursor;
+						else ++ cursor;
+					}
+					if(best >= 0) hardBoundaries.push_back(order.size());
+				}
+
+				fanningVertex = best;
+			}
+			assert(order.size() == faceCount);
+		}
+
+		auto fanOf = [&](u4_t f) { return [&, f](std::size_t i) { return faceVertices[faceOffsets[f] + i]; }; };
+
+		// Soft boundaries: split the hard clusters wherever doing so doesn't increase the ACMR too much
+		std::vector<std::size_t> boundaries;
+		{
+			auto cache = opt::FifoCache(vertexCount, cacheSize);
+			u8_t totalMisses    = 0;
+			u8_t totalTriangles = 0;
+			for(auto f : order) {
+				totalMisses    += cache.referenceFan(faceSize(f), fanOf(f));
+				totalTriangles += faceSize(f) - 2;
+			}
+			double threshold = double(overdrawThreshold) * double(totalMisses) / double(std::max<u8_t>(totalTriangles, 1));
+
+			hardBoundaries.push_back(order.size());
+			for(std::size_t c = 0; c + 1 < hardBoundaries.size(); ++c) {
+				auto end = hardBoundaries[c + 1];
+				u8_t misses    = 0;
+				u8_t triangles = 0;
+				cache.reset();
+				boundaries.push_back(hardBoundaries[c]);
+				for(auto i = hardBoundaries[c]; i < end; ++i) {
+					auto f = order[i];
+					misses    += cache.referenceFan(faceSize(f), fanOf(f));
+					triangles += faceSize(f) - 2;
+					if(i + 1 < end && triangles > 0 && double(misses) / double(triangles) <= threshold) {
+						boundaries.push_back(i + 1);
+						misses    = 0;
+						triangles = 0;
+						cache.reset();
+					}
+				}
+			}
+			boundaries.push_back(order.size());
+		}
+
+		// Sort the clusters by decreasing occlusion potential
+		{
+			struct Cluster {
+				std::size_t begin;
+				std::size_t end;
+				double      occlusion;
+			};
+
+			const auto constIndices = std::span<const Index>(indices);
+			opt::Surface meshSurface;
+			for(auto& face : faces) meshSurface.addFan(constIndices, vertices, face.firstIndex, face.indexCount);
+			auto meshCentroid = meshSurface.centroid();
+
+			std::vector<Cluster> clusters;
+			clusters.reserve(boundaries.size() - 1);
+			for(std::size_t c = 0; c + 1 < boundaries.size(); ++c) {
+				opt::Surface surface;
+				for(auto i = boundaries[c]; i < boundaries[c + 1]; ++i) {
+					auto& face = faces[order[i]];
+					surface.addFan(constIndices, vertices, face.firstIndex, face.indexCount);
+				}
+				clusters.push_back({ boundaries[c], boundaries[c + 1], (surface.centroid() - meshCentroid).dot(surface.normal()) });
+			}
+			std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& l, const Cluster& r) { return l.occlusion > r.occlusion; });
+
+			std::vector<u4_t> sortedOrder;
+			sortedOrder.reserve(faceCount);
+			for(auto& cluster : clusters) sortedOrder.insert(sortedOrder.end(), order.begin() + cluster.begin, order.begin() + cluster.end);
+			order = std::move(sortedOrder);
+		}
+
+		{ // Rewrite the faces and their indices
+			std::size_t firstIndex = faces.front().firstIndex;
+			std::size_t indexCount = 0;
+			for(auto& face : faces) {
+				firstIndex  = std::min<std::size_t>(firstIndex, face.firstIndex);
+				indexCount += face.indexCount + 1;
+			}
+			assert(firstIndex + indexCount <= indices.size());
+
+			std::vector<Face>  newFaces;
+			std::vector<Index> newIndices;
+			newFaces.reserve(faceCount);
+			newIndices.reserve(indexCount);
+			for(auto f : order) {
+				auto& face = newFaces.emplace_back(faces[f]);
+				face.firstIndex = firstIndex + newIndices.size();
+				for(std::size_t i = 0; i < faceSize(f); ++i) newIndices.push_back(Index(localVertices[faceVertices[faceOffsets[f] + i]]));
+				newIndices.push_back(Index::ePrimitiveRestart);
+			}
+			assert(newIndices.size() == indexCount);
+			std::copy(newFaces.begin(),   newFaces.end(),   faces.begin());
+			std::copy(newIndices.begin(), newIndices.end(), indices.begin() + firstIndex);
+		}
+	}
+
+
+	std::size_t optimizeVertexFetch(std::span<Index> indices, std::span<Vertex> vertices) {
+		constexpr u4_t unused = ~ u4_t(0);
+		std::vector<u4_t> remap = std::vector<u4_t>(vertices.size(), unused);
+		u4_t next = 0;
+
+		for(auto& idx : indices) {
+			if(idx == Index::ePrimitiveRestart) continue;
+			assert(u4_t(idx) < vertices.size());
+			auto& newIdx = remap[u4_t(idx)];
+			if(newIdx == unused) newIdx = next ++;
+			idx = Index(newIdx);
+		}
+
+		std::size_t r = next;
+		for(auto& newIdx : remap) if(newIdx == unused) newIdx = next ++;
+
+		std::vector<Vertex> reordered = std::vector<Vertex>(vertices.size());
+		for(std::size_t i = 0; i < vertices.size(); ++i) reordered[remap[i]] = vertices[i];
+		std::copy(reordered.begin(), reordered.end(), vertices.begin());
+		return r;
+	}
+
+}
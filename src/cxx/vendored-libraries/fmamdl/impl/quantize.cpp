@@ -0,0 +1,129 @@
+#include <fmamdl/quantize.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+
+namespace fmamdl {
+
+	namespace quant {
+		constexpr f4_t UNORM16_MAX = 65535.0f;
+		constexpr f4_t SNORM16_MAX = 32767.0f;
+
+		f4_t signNotZero(f4_t v) noexcept { return (v >= 0.0f)? 1.0f : -1.0f; }
+
+		void cross(f4_t dst[3], const f4_t l[3], const f4_t r[3]) noexcept {
+			dst[0] = (l[1] * r[2]) - (l[2] * r[1]);
+			dst[1] = (l[2] * r[0]) - (l[0] * r[2]);
+			dst[2] = (l[0] * r[1]) - (l[1] * r[0]);
+		}
+
+		f4_t dot(const f4_t l[3], const f4_t r[3]) noexcept {
+			return (l[0] * r[0]) + (l[1] * r[1]) + (l[2] * r[2]);
+		}
+
+		s2_t toSnorm16(f4_t v) noexcept {
+			return s2_t(std::lround(std::clamp(v, -1.0f, +1.0f) * SNORM16_MAX));
+		}
+
+		f4_t fromSnorm16(s2_t v) noexcept {
+			// Same as Vulkan's SNORM conversion, where both -32768 and -32767 map to -1
+			return std::max(f4_t(v) / SNORM16_MAX, -1.0f);
+		}
+	}
+
+
+	VertexBounds computeVertexBounds(std::span<const Vertex> vertices) noexcept {
+		VertexBounds r = { };
+		if(vertices.empty()) return r;
+
+		f4_t max[3];
+		for(unsigned i = 0; i < 3; ++i) {
+			r.min[i] = +std::numeric_limits<f4_t>::infinity();
+			max[i]   = -std::numeric_limits<f4_t>::infinity();
+		}
+		for(auto& vtx : vertices)
+		for(unsigned i = 0; i < 3; ++i) {
+			r.min[i] = std::min(r.min[i], vtx.position[i]);
+			max[i]   = std::max(max[i],   vtx.position[i]);
+		}
+		for(unsigned i = 0; i < 3; ++i) r.extent[i] = max[i] - r.min[i];
+		return r;
+	}
+
+
+	void octEncode(s2_t dst[2], const f4_t src[3]) noexcept {
+		using namespace quant;
+		f4_t l1 = std::abs(src[0]) + std::abs(src[1]) + std::abs(src[2]);
+		if(! (l1 > 0.0f)) { dst[0] = 0; dst[1] = 0; return; }
+		f4_t x = src[0] / l1;
+		f4_t y = src[1] / l1;
+		if(src[2] < 0.0f) {
+			f4_t wx = (1.0f - std::abs(y)) * signNotZero(x);
+			f4_t wy = (1.0f - std::abs(x)) * signNotZero(y);
+			x = wx;
+			y = wy;
+		}
+		dst[0] = toSnorm16(x);
+		dst[1] = toSnorm16(y);
+	}
+
+
+	void octDecode(f4_t dst[3], const s2_t src[2]) noexcept {
+		using namespace quant;
+		f4_t x = fromSnorm16(src[0]);
+		f4_t y = fromSnorm16(src[1]);
+		f4_t z = 1.0f - std::abs(x) - std::abs(y);
+		f4_t t = std::max(-z, 0.0f);
+		x += (x >= 0.0f)? -t : +t;
+		y += (y >= 0.0f)? -t : +t;
+		f4_t len = std::sqrt((x * x) + (y * y) + (z * z));
+		dst[0] = x / len;
+		dst[1] = y / len;
+		dst[2] = z / len;
+	}
+
+
+	CompactVertex compressVertex(const Vertex& src, const VertexBounds& bounds) noexcept {
+		using namespace quant;
+		CompactVertex r;
+
+		for(unsigned i = 0; i < 3; ++i) {
+			f4_t unorm = (bounds.extent[i] > 0.0f)? (src.position[i] - bounds.min[i]) / bounds.extent[i] : 0.0f;
+			r.position[i] = u2_t(std::lround(std::clamp(unorm, 0.0f, 1.0f) * UNORM16_MAX));
+		}
+
+		f4_t nxt[3];
+		cross(nxt, src.normal, src.tangent);
+		r.position[3] = (dot(nxt, src.bitangent) < 0.0f)? 0xffff : 0;
+
+		r.texture[0] = f2_t(src.texture[0]);
+		r.texture[1] = f2_t(src.texture[1]);
+		octEncode(r.normal,  src.normal);
+		octEncode(r.tangent, src.tangent);
+		return r;
+	}
+
+
+	Vertex decompressVertex(const CompactVertex& src, const VertexBounds& bounds) noexcept {
+		using namespace quant;
+		Vertex r;
+
+		for(unsigned i = 0; i < 3; ++i) {
+			r.position[i] = bounds.min[i] + (bounds.extent[i] * (f4_t(src.position[i]) / UNORM16_MAX));
+		}
+
+		r.texture[0] = f4_t(src.texture[0]);
+		r.texture[1] = f4_t(src.texture[1]);
+		octDecode(r.normal,  src.normal);
+		octDecode(r.tangent, src.tangent);
+
+		f4_t sign = (src.position[3] == 0)? +1.0f : -1.0f;
+		cross(r.bitangent, r.normal, r.tangent);
+		for(auto& c : r.bitangent) c *= sign;
+		return r;
+	}
+
+}
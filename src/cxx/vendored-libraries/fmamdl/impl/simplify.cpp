@@ -0,0 +1,403 @@
+#include <fmamdl/simplify.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace fmamdl {
+
+	namespace simp {
+
+		constexpr u4_t nullIndex = ~ u4_t(0);
+
+		/// Border planes are weighted more than surface planes, so
+		/// that borders are only eroded when there is no other choice.
+		///
+		constexpr double borderWeight = 8.0;
+
+
+		struct Vec3 {
+			double x, y, z;
+
+			Vec3 operator-(const Vec3& r) const noexcept { return { x - r.x, y - r.y, z - r.z }; }
+			Vec3 operator*(double s)      const noexcept { return { x * s, y * s, z * s }; }
+			double dot(const Vec3& r)     const noexcept { return (x * r.x) + (y * r.y) + (z * r.z); }
+			Vec3 cross(const Vec3& r)     const noexcept { return { (y * r.z) - (z * r.y), (z * r.x) - (x * r.z), (x * r.y) - (y * r.x) }; }
+			double length()               const noexcept { return std::sqrt(dot(*this)); }
+
+			static Vec3 of(const Vertex& v) noexcept { return { v.position[0], v.position[1], v.position[2] }; }
+		};
+
+
+		/// Symmetric 4x4 matrix that measures the sum of the squared
+		/// distances of a point from a set of weighted planes.
+		///
+		struct Quadric {
+			double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+			double weight;
+
+			static Quadric fromPlane(const Vec3& n, double d, double w) noexcept {
+				return {
+					w * n.x * n.x, w * n.x * n.y, w * n.x * n.z, w * n.x * d,
+					w * n.y * n.y, w * n.y * n.z, w * n.y * d,
+					w * n.z * n.z, w * n.z * d,
+					w * d * d,
+					w };
+			}
+
+			Quadric& operator+=(const Quadric& r) noexcept {
+				a2 += r.a2; ab += r.ab; ac += r.ac; ad += r.ad;
+				b2 += r.b2; bc += r.bc; bd += r.bd;
+				c2 += r.c2; cd += r.cd;
+				d2 += r.d2;
+				weight += r.weight;
+				return *this;
+			}
+
+			/// The weighted mean of the squared distances.
+			///
+			double eval(const Vec3& p) const noexcept {
+				if(! (weight > 0.0)) return 0.0;
+				double r =
+					(a2 * p.x * p.x) + (2.0 * ab * p.x * p.y) + (2.0 * ac * p.x * p.z) + (2.0 * ad * p.x) +
+					(b2 * p.y * p.y) + (2.0 * bc * p.y * p.z) + (2.0 * bd * p.y) +
+					(c2 * p.z * p.z) + (2.0 * cd * p.z) +
+					d2;
+				return std::max(r, 0.0) / weight;
+			}
+		};
+
+
+		struct Collapse {
+			double cost;
+			u4_t   from;
+			u4_t   to;
+			u4_t   fromVersion;
+			u4_t   toVersion;
+
+			bool operator>(const Collapse& r) const noexcept { return cost > r.cost; }
+		};
+
+
+		/// Simplification state; vertices are identified by their
+		/// position ("points"), so that texture seams do not look
+		/// like borders.
+		///
+		class Simplifier {
+		public:
+			Simplifier(std::span<const u4_t> triangles, std::span<const Vertex> vertices):
+				sp_vertices(vertices)
+			{
+				mapPoints(triangles);
+				findBorders();
+				computeQuadrics();
+			}
+
+			SimplifiedMesh run(std::size_t targetTriangleCount, f4_t maxError) {
+				double maxCost = double(maxError) * double(maxError);
+				double reachedCost = 0.0;
+
+				for(u4_t t = 0; t < sp_triPoints.size() / 3; ++t) {
+					if(! sp_triAlive[t]) continue;
+					for(unsigned c = 0; c < 3; ++c) {
+						pushCandidate(sp_triPoints[(t*3) + c], sp_triPoints[(t*3) + ((c+1) % 3)]);
+						pushCandidate(sp_triPoints[(t*3) + ((c+1) % 3)], sp_triPoints[(t*3) + c]);
+					}
+				}
+
+				while(sp_aliveTriangles > targetTriangleCount && ! sp_queue.empty()) {
+					auto col = sp_queue.top();
+					sp_queue.pop();
+					if(sp_pointVersions[col.from] != col.fromVersion || sp_pointVersions[col.to] != col.toVersion) continue;
+					if(col.cost > maxCost) break;
+					if(! tryCollapse(col.from, col.to)) continue;
+					reachedCost = std::max(reachedCost, col.cost);
+				}
+
+				SimplifiedMesh r;
+				r.error = f4_t(std::sqrt(reachedCost));
+				r.triangles.reserve(sp_aliveTriangles * 3);
+				for(u4_t t = 0; t < sp_triAlive.size(); ++t) {
+					if(! sp_triAlive[t]) continue;
+					r.triangles.insert(r.triangles.end(), sp_triVertices.begin() + (t*3), sp_triVertices.begin() + (t*3) + 3);
+				}
+				return r;
+			}
+
+		private:
+			std::span<const Vertex> sp_vertices;
+			std::vector<u4_t>    sp_triVertices;
+			std::vector<u4_t>    sp_triPoints;
+			std::vector<bool>    sp_triAlive;
+			std::vector<Vec3>    sp_points;
+			std::vector<u4_t>    sp_pointWedges;   // Number of distinct vertices at each point
+			std::vector<u4_t>    sp_pointVersions; // Incremented whenever a point changes or dies
+			std::vector<bool>    sp_pointBorder;
+			std::vector<bool>    sp_pointLocked;
+			std::vector<Quadric> sp_quadrics;
+			std::vector<std::vector<u4_t>> sp_pointTriangles;
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> sp_queue;
+			std::size_t sp_aliveTriangles = 0;
+
+			static constexpr u4_t deadVersion = ~ u4_t(0);
+
+			void mapPoints(std::span<const u4_t> triangles) {
+				using PosKey = std::array<u4_t, 3>;
+				struct PosHash {
+					std::size_t operator()(const PosKey& k) const noexcept {
+						return (std::size_t(k[0]) * 0x9e3779b97f4a7c15ull) ^ std::rotl<std::size_t>(k[1], 21) ^ std::rotl<std::size_t>(k[2], 42);
+					}
+				};
+
+				std::unordered_map<PosKey, u4_t, PosHash> pointMap;
+				std::vector<u4_t> vertexPoints = std::vector<u4_t>(sp_vertices.size(), nullIndex);
+				auto pointOf = [&](u4_t v) {
+					if(vertexPoints[v] != nullIndex) return vertexPoints[v];
+					auto& pos = sp_vertices[v].position;
+					auto  key = PosKey { std::bit_cast<u4_t>(pos[0]), std::bit_cast<u4_t>(pos[1]), std::bit_cast<u4_t>(pos[2]) };
+					auto  ins = pointMap.insert({ key, u4_t(sp_points.size()) });
+					if(ins.second) {
+						sp_points.push_back(Vec3::of(sp_vertices[v]));
+						sp_pointWedges.push_back(0);
+					}
+					++ sp_pointWedges[ins.first->second];
+					vertexPoints[v] = ins.first->second;
+					return ins.first->second;
+				};
+
+				sp_triVertices.reserve(triangles.size());
+				sp_triPoints.reserve(triangles.size());
+				for(std::size_t i = 0; i + 2 < triangles.size(); i += 3) {
+					u4_t p[3] = { pointOf(triangles[i]), pointOf(triangles[i+1]), pointOf(triangles[i+2]) };
+					if(p[0] == p[1] || p[1] == p[2] || p[2] == p[0]) continue; // Degenerate
+					for(unsigned c = 0; c < 3; ++c) {
+						sp_triVertices.push_back(triangles[i + c]);
+						sp_triPoints.push_back(p[c]);
+					}
+				}
+
+				sp_aliveTriangles = sp_triPoints.size() / 3;
+				sp_triAlive.assign(sp_aliveTriangles, true);
+				sp_pointVersions.assign(sp_points.size(), 0);
+				sp_pointTriangles.resize(sp_points.size());
+				for(u4_t t = 0; t < sp_aliveTriangles; ++t)
+				for(unsigned c = 0; c < 3; ++c) {
+					sp_pointTriangles[sp_triPoints[(t*3) + c]].push_back(t);
+				}
+			}
+
+			void findBorders() {
+				std::unordered_map<u8_t, u4_t> edgeUses;
+				auto edgeKey = [](u4_t a, u4_t b) { return (u8_t(std::min(a, b)) << 32) | u8_t(std::max(a, b)); };
+				edgeUses.reserve(sp_triPoints.size());
+				for(std::size_t t = 0; t < sp_triPoints.size(); t += 3)
+				for(unsigned c = 0; c < 3; ++c) {
+					++ edgeUses[edgeKey(sp_triPoints[t + c], sp_triPoints[t + ((c+1) % 3)])];
+				}
+
+				sp_pointBorder.assign(sp_points.size(), false);
+				sp_pointLocked.assign(sp_points.size(), false);
+				for(u4_t p = 0; p < sp_points.size(); ++p) sp_pointLocked[p] = sp_pointWedges[p] > 1;
+				for(auto& edge : edgeUses) {
+					u4_t a = u4_t(edge.first >> 32);
+					u4_t b = u4_t(edge.first);
+					if(edge.second == 1) {
+						sp_pointBorder[a] = true;
+						sp_pointBorder[b] = true;
+					} else if(edge.second > 2) {
+						// Non-manifold edges are left untouched
+						sp_pointLocked[a] = true;
+						sp_pointLocked[b] = true;
+					}
+				}
+			}
+
+			void computeQuadrics() {
+				sp_quadrics.assign(sp_points.size(), Quadric { });
+				for(std::size_t t = 0; t < sp_triPoints.size(); t += 3) {
+					const Vec3& p0 = sp_points[sp_triPoints[t+0]];
+					const Vec3& p1 = sp_points[sp_triPoints[t+1]];
+					const Vec3& p2 = sp_points[sp_triPoints[t+2]];
+					Vec3   n    = (p1 - p0).cross(p2 - p0);
+					double len  = n.length();
+					if(! (len > 0.0)) continue;
+					n = n * (1.0 / len);
+					double area = len * 0.5;
+					auto   q    = Quadric::fromPlane(n, -n.dot(p0), area);
+					for(unsigned c = 0; c < 3; ++c) sp_quadrics[sp_triPoints[t + c]] += q;
+
+					// Border edges also get a plane orthogonal to the face
+					for(unsigned c = 0; c < 3; ++c) {
+						u4_t a = sp_triPoints[t + c];
+						u4_t b = sp_triPoints[t + ((c+1) % 3)];
+						if(! (sp_pointBorder[a] && sp_pointBorder[b] && edgeTriangleCount(a, b) == 1)) continue;
+						Vec3   edge    = sp_points[b] - sp_points[a];
+						double edgeLen = edge.length();
+						Vec3   bn      = edge.cross(n);
+						double bnLen   = bn.length();
+						if(! (bnLen > 0.0)) continue;
+						bn = bn * (1.0 / bnLen);
+						auto bq = Quadric::fromPlane(bn, -bn.dot(sp_points[a]), borderWeight * edgeLen * edgeLen);
+						sp_quadrics[a] += bq;
+						sp_quadrics[b] += bq;
+					}
+				}
+			}
+
+			unsigned edgeTriangleCount(u4_t a, u4_t b) const {
+				unsigned r = 0;
+				for(auto t : sp_pointTriangles[a]) {
+					if(! sp_triAlive[t]) continue;
+					for(unsigned c = 0; c < 3; ++c) if(sp_triPoints[(t*3) + c] == b) { ++ r; break; }
+				}
+				return r;
+			}
+
+			bool canCollapse(u4_t from, u4_t to) const {
+				if(sp_pointLocked[from]) return false;
+				if(sp_pointBorder[from]) {
+					// Border points may only slide along the border
+					return sp_pointBorder[to] && edgeTriangleCount(from, to) == 1;
+				}
+				return true;
+			}
+
+			void pushCandidate(u4_t from, u4_t to) {
+				if(! canCollapse(from, to)) return;
+				auto q = sp_quadrics[from];
+				q += sp_quadrics[to];
+				sp_queue.push(Collapse {
+					.cost        = q.eval(sp_points[to]),
+					.from        = from,
+					.to          = to,
+					.fromVersion = sp_pointVersions[from],
+					.toVersion   = sp_pointVersions[to] });
+			}
+
+			bool tryCollapse(u4_t from, u4_t to) {
+				// Borders may have changed since the candidate was queued
+				if(! canCollapse(from, to)) return false;
+
+				// Find the vertex that replaces `from`'s, and reject collapses that flip triangles
+				u4_t toVertex = nullIndex;
+				for(auto t : sp_pointTriangles[from]) {
+					if(! sp_triAlive[t]) continue;
+					auto* pts = sp_triPoints.data() + (t*3);
+					auto* vtx = sp_triVertices.data() + (t*3);
+					unsigned fromCorner = 3;
+					bool     hasTo      = false;
+					for(unsigned c = 0; c < 3; ++c) {
+						if(pts[c] == from) fromCorner = c;
+						if(pts[c] == to) { hasTo = true; toVertex = vtx[c]; }
+					}
+					assert(fromCorner < 3);
+					if(hasTo) continue;
+					const Vec3& p1 = sp_points[pts[(fromCorner + 1) % 3]];
+					const Vec3& p2 = sp_points[pts[(fromCorner + 2) % 3]];
+					Vec3 nBefore = (p1 - sp_points[from]).cross(p2 - sp_points[from]);
+					Vec3 nAfter  = (p1 - sp_points[to]  ).cross(p2 - sp_points[to]  );
+					if(! (nBefore.dot(nAfter) > 0.0)) return false;
+				}
+				if(toVertex == nullIndex) return false;
+
+				for(auto t : sp_pointTriangles[from]) {
+					if(! sp_triAlive[t]) continue;
+					auto* pts = sp_triPoints.data() + (t*3);
+					auto* vtx = sp_triVertices.data() + (t*3);
+					if(pts[0] == to || pts[1] == to || pts[2] == to) {
+						sp_triAlive[t] = false;
+						-- sp_aliveTriangles;
+						continue;
+					}
+					for(unsigned c = 0; c < 3; ++c) {
+						if(pts[c] == from) { pts[c] = to; vtx[c] = toVertex; }
+					}
+					sp_pointTriangles[to].push_back(t);
+				}
+				sp_pointTriangles[from] = { };
+				sp_quadrics[to] += sp_quadrics[from];
+				sp_pointVersions[from] = deadVersion;
+				++ sp_pointVersions[to];
+
+				// Compact `to`'s triangle list, and requeue the edges around it
+				auto& toTriangles = sp_pointTriangles[to];
+				std::erase_if(toTriangles, [&](u4_t t) { return ! sp_triAlive[t]; });
+				for(auto t : toTriangles)
+				for(unsigned c = 0; c < 3; ++c) {
+					u4_t other = sp_triPoints[(t*3) + c];
+					if(other == to) continue;
+					pushCandidate(to, other);
+					pushCandidate(other, to);
+				}
+				return true;
+			}
+		};
+
+	}
+
+
+	std::vector<u4_t> triangulateFans(std::span<const Index> indices) {
+		std::vector<u4_t> r;
+		std::size_t first = 0;
+		for(std::size_t i = 0; i <= indices.size(); ++i) {
+			if(i == indices.size() || indices[i] == Index::ePrimitiveRestart) {
+				for(std::size_t j = first + 1; j + 1 < i; ++j) {
+					r.push_back(u4_t(indices[first]));
+					r.push_back(u4_t(indices[j]));
+					r.push_back(u4_t(indices[j + 1]));
+				}
+				first = i + 1;
+			}
+		}
+		return r;
+	}
+
+
+	SimplifiedMesh simplifyTriangles(
+			std::span<const u4_t>   triangles,
+			std::span<const Vertex> vertices,
+			std::size_t targetTriangleCount,
+			f4_t maxError
+	) {
+		auto simplifier = simp::Simplifier(triangles, vertices);
+		return simplifier.run(targetTriangleCount, maxError);
+	}
+
+
+	std::vector<SimplifiedMesh> buildLodChain(
+			std::span<const u4_t>   triangles,
+			std::span<const Vertex> vertices,
+			unsigned maxLevels,
+			f4_t ratio
+	) {
+		std::vector<SimplifiedMesh> r;
+		std::size_t prevCount = triangles.size() / 3;
+		f4_t        prevError = 0.0f;
+		double      target    = double(prevCount);
+
+		for(unsigned level = 0; level < maxLevels; ++level) {
+			target *= ratio;
+			if(target < 1.0) break;
+
+			// Every level starts from the original mesh, so errors do not accumulate
+			auto lod = simplifyTriangles(triangles, vertices, std::size_t(target));
+			auto lodCount = lod.triangles.size() / 3;
+			if(lodCount == 0 || double(lodCount) > 0.9 * double(prevCount)) break;
+
+			lod.error = std::max(lod.error, prevError);
+			prevCount = lodCount;
+			prevError = lod.error;
+			r.push_back(std::move(lod));
+		}
+
+		return r;
+	}
+
+}
@@ -94,6 +94,9 @@
 // Bit8  | Triangle List
 // Bit8  | External Model (the model tables do not share memory with the header)
 // Bit8  | External Strings (the string storage does not share memory with the header)
+// Bit8  | Compact Vertices (the Vertex Table holds CVX elements, and is followed by the Vertex Bounds Table)
+// Bit8  | LOD Chains (the model ends with the LOD Table)
+// Bit8  | Meshlets (the model ends with the Meshlet Table)
 //
 // String storage:
 // Nstr  | First String
@@ -175,6 +178,88 @@
 // F4    | Bi-Tangent (X)
 // F4    | Bi-Tangent (Y)
 // F4    | Bi-Tangent (Z)
+//
+// CVX:
+// U2    | Position (X, normalized against the mesh's bounds)
+// U2    | Position (Y, normalized against the mesh's bounds)
+// U2    | Position (Z, normalized against the mesh's bounds)
+// U2    | Bi-Tangent Sign (0 if the bi-tangent is N x T, 0xffff if it is T x N)
+// F2    | Texture Coordinate (U)
+// F2    | Texture Coordinate (V)
+// S2    | Normal (octahedral X)
+// S2    | Normal (octahedral Y)
+// S2    | Tangent (octahedral X)
+// S2    | Tangent (octahedral Y)
+//
+// Vertex Bounds Table (only with compact vertices; 8-aligned, right after the Vertex Table):
+// VBD   | First Mesh's Vertex Bounds
+// ...   | Remaining Meshes' Vertex Bounds
+//
+// VBD:
+// F4    | Minimum (X)
+// F4    | Minimum (Y)
+// F4    | Minimum (Z)
+// F4    | Extent (X)
+// F4    | Extent (Y)
+// F4    | Extent (Z)
+//
+// Compact vertices are referenced by exactly one mesh, so that each of
+// them can be dequantized with the bounds of the mesh it belongs to:
+// a position component is `minimum + (extent * (value / 65535))`.
+// Octahedral components are normalized as Vulkan SNORM values.
+//
+// LOD Table (only with LOD chains; 8-aligned, right after the Vertex Table
+// or, with compact vertices, the Vertex Bounds Table):
+// U8    | LOD count
+// LOD?  | First LOD
+// ...   | Remaining LODs
+//
+// LOD:
+// U4    | Mesh Index
+// U4    | Index Count
+// U4    | First Index index
+// F4    | Error (object space distance)
+//
+// A mesh's faces are its level of detail 0, which has no error;
+// the LODs of a mesh are simplified versions of it, over the same
+// vertices, and are grouped by mesh and sorted by increasing error.
+// The indices of each LOD are stored in the Index Table after every
+// face's indices, and do not belong to any face: each triangle is
+// a group of three indices followed by a primitive restart.
+//
+// Meshlet Table (only with meshlets; 8-aligned, right after the LOD Table
+// or, without LOD chains, where the LOD Table would be):
+// U8    | Meshlet count
+// U8    | Meshlet vertex count
+// U8    | Meshlet triangle count
+// MLT?  | First Meshlet
+// ...   | Remaining Meshlets
+// U4?   | Meshlet vertices (8-aligned; vertex indices)
+// U1?   | Meshlet triangles (8-aligned; three meshlet vertex indices each)
+//
+// MLT:
+// U4    | Mesh Index
+// U4    | First Vertex (meshlet vertex index)
+// U4    | First Triangle (meshlet triangle index)
+// U1    | Vertex Count (at most 64)
+// U1    | Triangle Count (at most 124)
+// U2    | Padding
+// F4    | Bounding Sphere Center (X)
+// F4    | Bounding Sphere Center (Y)
+// F4    | Bounding Sphere Center (Z)
+// F4    | Bounding Sphere Radius
+// F4    | Normal Cone Axis (X)
+// F4    | Normal Cone Axis (Y)
+// F4    | Normal Cone Axis (Z)
+// F4    | Normal Cone Cutoff
+//
+// Meshlets partition the faces of level of detail 0 of each mesh
+// into small clusters, grouped by mesh; a meshlet's triangles refer
+// to its own vertices, which in turn refer to the Vertex Table.
+// Every triangle of a meshlet is back-facing, as seen from a point `p`
+// in object space, if
+// `dot(center - p, coneAxis) >= (coneCutoff * length(center - p)) + radius`;
+// a cutoff of 1 or more means that the meshlet cannot be culled that way.
 
 
 
@@ -217,7 +302,10 @@ namespace fmamdl {
 		eTriangleFan     = 1 << 0,
 		eTriangleList    = 1 << 1,
 		eExternalModel   = 1 << 2,
-		eExternalStrings = 1 << 3
+		eExternalStrings = 1 << 3,
+		eCompactVertices = 1 << 4,
+		eLodChains       = 1 << 5,
+		eMeshlets        = 1 << 6
 	};
 
 	using string_offset_e = u8_t;
@@ -264,6 +352,41 @@ namespace fmamdl {
 		f4_t bitangent[3];
 	};
 
+	struct CompactVertex {
+		u2_t position[4];
+		f2_t texture[2];
+		s2_t normal[2];
+		s2_t tangent[2];
+	};
+
+	struct VertexBounds {
+		f4_t min[3];
+		f4_t extent[3];
+	};
+
+	struct Lod {
+		u4_t meshIndex;
+		u4_t indexCount;
+		u4_t firstIndex;
+		f4_t error;
+	};
+
+	struct Meshlet {
+		u4_t meshIndex;
+		u4_t firstVertex;
+		u4_t firstTriangle;
+		u1_t vertexCount;
+		u1_t triangleCount;
+		u2_t padding;
+		f4_t center[3];
+		f4_t radius;
+		f4_t coneAxis[3];
+		f4_t coneCutoff;
+	};
+
+	constexpr unsigned maxMeshletVertices  = 64;
+	constexpr unsigned maxMeshletTriangles = 124;
+
 
 
 	/// \brief An reference to a model, with utility functions to
@@ -309,6 +432,10 @@ namespace fmamdl {
 			GETTER_REF_(u8_t, vertexCount)
 			GETTER_REF_(u8_t, stringCount)
 			GETTER_REF_(u8_t, stringStorageSize)
+			GETTER_REF_(u8_t, lodCount)
+			GETTER_REF_(u8_t, meshletCount)
+			GETTER_REF_(u8_t, meshletVertexCount)
+			GETTER_REF_(u8_t, meshletTriangleCount)
 
 			GETTER_PTR_(Material,  materialPtr)
 			GETTER_PTR_(Mesh,      meshPtr)
@@ -316,6 +443,12 @@ namespace fmamdl {
 			GETTER_PTR_(Face,      facePtr)
 			GETTER_PTR_(Index,     indexPtr)
 			GETTER_PTR_(Vertex,    vertexPtr)
+			GETTER_PTR_(CompactVertex, compactVertexPtr)
+			GETTER_PTR_(VertexBounds,  vertexBoundsPtr)
+			GETTER_PTR_(Lod,           lodPtr)
+			GETTER_PTR_(Meshlet,       meshletPtr)
+			GETTER_PTR_(u4_t,          meshletVertexPtr)
+			GETTER_PTR_(u1_t,          meshletTrianglePtr)
 			GETTER_PTR_(std::byte, stringPtr)
 
 			GETTER_SPN_(Material,  materials,     materialPtr, materialCount)
@@ -324,6 +457,11 @@ namespace fmamdl {
 			GETTER_SPN_(Face,      faces,         facePtr,     faceCount)
 			GETTER_SPN_(Index,     indices,       indexPtr,    indexCount)
 			GETTER_SPN_(Vertex,    vertices,      vertexPtr,   vertexCount)
+			GETTER_SPN_(CompactVertex, compactVertices, compactVertexPtr, vertexCount)
+			GETTER_SPN_(VertexBounds,  vertexBounds,    vertexBoundsPtr,  meshCount)
+			GETTER_SPN_(Lod,           lods,            lodPtr,           lodCount)
+			GETTER_SPN_(Meshlet,       meshlets,         meshletPtr,         meshletCount)
+			GETTER_SPN_(u4_t,          meshletVertices,  meshletVertexPtr,   meshletVertexCount)
 			GETTER_SPN_(std::byte, stringStorage, stringPtr,   stringStorageSize)
 
 		#undef GETTER_SPN_
@@ -334,6 +472,44 @@ namespace fmamdl {
 		///
 		static std::size_t requiredBytesFor(const Layout& layout) noexcept;
 
+		/// \brief Whether the Vertex Table holds `CompactVertex`es
+		///        rather than `Vertex`es.
+		///
+		/// Compact models have a Vertex Bounds Table, accessed through
+		/// `vertexBounds`; the `vertices` span is meaningless for them.
+		///
+		bool hasCompactVertices() const;
+
+		/// \brief Whether the model ends with a LOD Table.
+		///
+		/// `lodCount`, `lodPtr` and `lods` may only be used
+		/// with models that have LOD chains.
+		///
+		bool hasLodChains() const;
+
+		/// \returns The offset in bytes of the LOD Table.
+		///
+		std::size_t lodTableOffset() const;
+
+		/// \brief Whether the model ends with a Meshlet Table.
+		///
+		/// The meshlet getters may only be used with models that have meshlets.
+		///
+		bool hasMeshlets() const;
+
+		/// \returns The offset in bytes of the Meshlet Table.
+		///
+		std::size_t meshletTableOffset() const;
+
+		/// \returns The local vertex indices of every meshlet triangle,
+		///          three per triangle.
+		///
+		std::span<const u1_t> meshletTriangles() const { return { meshletTrianglePtr(), size_t(meshletTriangleCount() * 3) }; }
+
+		/// \returns The size in bytes of each element of the Vertex Table.
+		///
+		std::size_t vertexStride() const { return hasCompactVertices()? sizeof(CompactVertex) : sizeof(Vertex); }
+
 		Layout getVertexLayout() const;
 
 		/// Setting the vertex layout requires a variable-length
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "fmamdl/fmamdl.hpp"
+
+
+
+namespace fmamdl {
+
+	/// \brief Owning counterpart of the Meshlet Table.
+	///
+	struct MeshletSet {
+		std::vector<Meshlet> meshlets;
+		std::vector<u4_t>    vertices;  ///< Indices of the Vertex Table
+		std::vector<u1_t>    triangles; ///< Three meshlet vertex indices per triangle
+	};
+
+
+	/// \brief Partitions a triangle list into meshlets, and appends them to a set.
+	///
+	/// Each meshlet grows from a seed triangle through shared vertices,
+	/// preferring triangles that add fewer vertices and lie closer to
+	/// its centroid, until no neighboring triangle fits; seeds are taken
+	/// in input order, so sorting the triangles for vertex locality
+	/// (as `optimizeFaceOrder` does) also helps the resulting meshlet order.
+	/// Each meshlet gets a bounding sphere and a normal cone,
+	/// as described by the Meshlet Table.
+	///
+	/// \param dst The set to append to; offsets of the new meshlets
+	///        refer to the whole set.
+	/// \param triangles Three vertex indices per triangle.
+	/// \param vertices The whole vertex table.
+	/// \param meshIndex The mesh the triangles belong to.
+	///
+	void buildMeshlets(
+		MeshletSet& dst,
+		std::span<const u4_t>   triangles,
+		std::span<const Vertex> vertices,
+		u4_t meshIndex );
+
+	/// \brief Whether a meshlet is entirely back-facing, as seen from a point.
+	///
+	/// \param viewPos The point of view, in the same space as the meshlet.
+	///
+	bool isMeshletBackFacing(const Meshlet&, const f4_t (&viewPos)[3]) noexcept;
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+
+#include "fmamdl/fmamdl.hpp"
+
+
+
+// The functions declared here operate on faces as the converter
+// emits them: each face is a triangle fan, whose indices are
+// followed by a single `Index::ePrimitiveRestart`.
+
+
+
+namespace fmamdl {
+
+	constexpr unsigned defaultVertexCacheSize = 16;
+
+
+	struct VertexCacheStats {
+		u8_t triangleCount;
+		u8_t vertexCount; ///< Number of distinct vertices referenced by the indices
+		u8_t cacheMisses;
+
+		/// \brief Average cache miss ratio: transformed vertices per triangle.
+		///
+		f4_t acmr() const noexcept { return (triangleCount == 0)? 0.0f : f4_t(cacheMisses) / f4_t(triangleCount); }
+
+		/// \brief Average transformed vertex ratio: transformed vertices per distinct vertex.
+		///
+		f4_t atvr() const noexcept { return (vertexCount == 0)? 0.0f : f4_t(cacheMisses) / f4_t(vertexCount); }
+	};
+
+
+	/// \brief Simulates a FIFO post-transform vertex cache over the
+	///        triangles of a sequence of triangle fans.
+	///
+	VertexCacheStats computeVertexCacheStats(std::span<const Index>, unsigned cacheSize = defaultVertexCacheSize);
+
+	/// \brief Reorders the faces of a mesh, and their indices, to
+	///        improve vertex cache locality and reduce overdraw.
+	///
+	/// Faces are first sorted with the Tipsify algorithm
+	/// (Sander, Nehab and Barczak, 2007), generalized to polygons;
+	/// the resulting sequence is then split into clusters
+	/// that do not significantly increase the ACMR, which are sorted
+	/// by decreasing occlusion potential, so that outward facing
+	/// geometry tends to be drawn first.
+	///
+	/// \param faces The faces of one mesh, whose indices must be contiguous.
+	/// \param indices The whole index table, since faces refer to it by absolute offsets.
+	/// \param vertices The whole vertex table.
+	/// \param overdrawThreshold How much the ACMR of a cluster may exceed
+	///        the ACMR of the Tipsify output; 1 disables soft cluster
+	///        boundaries, higher values give finer-grained overdraw sorting.
+	///
+	void optimizeFaceOrder(
+		std::span<Face>         faces,
+		std::span<Index>        indices,
+		std::span<const Vertex> vertices,
+		unsigned cacheSize = defaultVertexCacheSize,
+		f4_t overdrawThreshold = 1.05f );
+
+	/// \brief Reorders vertices by first use, rewriting the indices accordingly.
+	///
+	/// Vertices that are not referenced by any index are moved
+	/// to the end of the span, in their original order.
+	///
+	/// \returns The number of referenced vertices.
+	///
+	std::size_t optimizeVertexFetch(std::span<Index> indices, std::span<Vertex> vertices);
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <span>
+
+#include "fmamdl/fmamdl.hpp"
+
+
+
+namespace fmamdl {
+
+	/// \brief Computes the smallest bounds that contain all the given vertices.
+	///
+	/// An empty span yields null bounds at the origin.
+	///
+	VertexBounds computeVertexBounds(std::span<const Vertex>) noexcept;
+
+	/// \brief Encodes a unit vector as two SNORM16 octahedral coordinates.
+	///
+	/// Vectors are normalized before being encoded; null vectors
+	/// are encoded as (0, 0, 1).
+	///
+	void octEncode(s2_t dst[2], const f4_t src[3]) noexcept;
+
+	/// \brief Decodes two SNORM16 octahedral coordinates into a unit vector.
+	///
+	void octDecode(f4_t dst[3], const s2_t src[2]) noexcept;
+
+	/// \brief Quantizes a vertex against the bounds of its mesh.
+	///
+	/// The bi-tangent is only stored as the sign of its projection
+	/// on the cross product of the normal and the tangent.
+	///
+	CompactVertex compressVertex(const Vertex&, const VertexBounds&) noexcept;
+
+	/// \brief Reverses `compressVertex`.
+	///
+	/// The decoded bi-tangent is orthogonal to the decoded
+	/// normal and tangent, regardless of the original one.
+	///
+	Vertex decompressVertex(const CompactVertex&, const VertexBounds&) noexcept;
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "fmamdl/fmamdl.hpp"
+
+
+
+namespace fmamdl {
+
+	constexpr f4_t defaultLodRatio = 0.5f;
+
+
+	struct SimplifiedMesh {
+		std::vector<u4_t> triangles; ///< Three vertex indices per triangle
+		f4_t error; ///< Estimated distance from the original surface, in object space
+	};
+
+
+	/// \brief Expands a sequence of triangle fans, each terminated
+	///        by a primitive restart, into a triangle list.
+	///
+	std::vector<u4_t> triangulateFans(std::span<const Index>);
+
+	/// \brief Simplifies a triangle list with quadric error metric
+	///        edge collapses (Garland and Heckbert, 1997).
+	///
+	/// Edges are collapsed onto one of their vertices, so that the
+	/// result refers to a subset of the original vertices.
+	/// Vertices on an open border may only slide along it, and
+	/// positions shared by more than one vertex (such as texture
+	/// seams) are never removed.
+	///
+	/// \param triangles Three vertex indices per triangle.
+	/// \param targetTriangleCount The simplification stops as soon as
+	///        the triangle count is not greater than this.
+	/// \param maxError The simplification stops before exceeding this error.
+	///
+	SimplifiedMesh simplifyTriangles(
+		std::span<const u4_t>   triangles,
+		std::span<const Vertex> vertices,
+		std::size_t targetTriangleCount,
+		f4_t maxError = std::numeric_limits<f4_t>::infinity() );
+
+	/// \brief Builds a chain of simplified versions of a mesh.
+	///
+	/// Each level targets `ratio` times the triangles of the previous one;
+	/// the chain ends early when a level fails to remove at least a tenth
+	/// of the previous level's triangles.
+	/// Triangle counts strictly decrease and errors never decrease
+	/// along the chain.
+	///
+	/// \returns Up to `maxLevels` levels, not including the original mesh.
+	///
+	std::vector<SimplifiedMesh> buildLodChain(
+		std::span<const u4_t>   triangles,
+		std::span<const Vertex> vertices,
+		unsigned maxLevels,
+		f4_t ratio = defaultLodRatio );
+
+}
@@ -0,0 +1,170 @@
+#include <fmamdl/fmamdl.hpp>
+#include <fmamdl/meshlet.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <vector>
+
+
+
+namespace {
+
+	struct Shape {
+		std::vector<fmamdl::u4_t>   triangles;
+		std::vector<fmamdl::Vertex> vertices;
+	};
+
+
+	/// A closed UV sphere of radius 1, with outward facing
+	/// counterclockwise triangles.
+	///
+	Shape makeSphere(unsigned rings, unsigned sectors) {
+		Shape r;
+		for(unsigned y = 0; y <= rings; ++y)
+		for(unsigned x = 0; x <= sectors; ++x) {
+			float theta = std::numbers::pi_v<float> * float(y) / float(rings);
+			float phi   = 2.0f * std::numbers::pi_v<float> * float(x) / float(sectors);
+			fmamdl::Vertex vtx = { };
+			vtx.position[0] = std::sin(theta) * std::cos(phi);
+			vtx.position[1] = std::sin(theta) * std::sin(phi);
+			vtx.position[2] = std::cos(theta);
+			for(unsigned i = 0; i < 3; ++i) vtx.normal[i] = vtx.position[i];
+			r.vertices.push_back(vtx);
+		}
+
+		auto at = [&](unsigned x, unsigned y) { return fmamdl::u4_t((y * (sectors + 1)) + x); };
+		for(unsigned y = 0; y < rings; ++y)
+		for(unsigned x = 0; x < sectors; ++x) {
+			if(y > 0) r.triangles.insert(r.triangles.end(), { at(x, y), at(x, y+1), at(x+1, y) });
+			if(y + 1 < rings) r.triangles.insert(r.triangles.end(), { at(x+1, y), at(x, y+1), at(x+1, y+1) });
+		}
+		return r;
+	}
+
+
+	using Triangle = std::array<fmamdl::u4_t, 3>;
+
+	Triangle normalizedTriangle(fmamdl::u4_t a, fmamdl::u4_t b, fmamdl::u4_t c) {
+		// Rotate the smallest index first, without changing the winding
+		if(b < a && b < c) return { b, c, a };
+		if(c < a && c < b) return { c, a, b };
+		return { a, b, c };
+	}
+
+
+	bool checkMeshlets(const Shape& shape, const fmamdl::MeshletSet& set) {
+		std::vector<Triangle> expected;
+		std::vector<Triangle> got;
+		for(std::size_t i = 0; i < shape.triangles.size(); i += 3) {
+			expected.push_back(normalizedTriangle(shape.triangles[i], shape.triangles[i+1], shape.triangles[i+2]));
+		}
+
+		for(std::size_t m = 0; m < set.meshlets.size(); ++m) {
+			auto& meshlet = set.meshlets[m];
+			if(meshlet.vertexCount > fmamdl::maxMeshletVertices || meshlet.triangleCount > fmamdl::maxMeshletTriangles || meshlet.triangleCount == 0) {
+				spdlog::error("Meshlet {} has {} vertices and {} triangles", m, meshlet.vertexCount, meshlet.triangleCount);
+				return false;
+			}
+			if(meshlet.firstVertex + meshlet.vertexCount > set.vertices.size() || (meshlet.firstTriangle + meshlet.triangleCount) * 3 > set.triangles.size()) {
+				spdlog::error("Meshlet {} is out of bounds", m);
+				return false;
+			}
+
+			auto position = [&](fmamdl::u1_t local) { return shape.vertices[set.vertices[meshlet.firstVertex + local]].position; };
+			for(unsigned v = 0; v < meshlet.vertexCount; ++v) {
+				auto* p = position(v);
+				double d[3] = { double(p[0]) - meshlet.center[0], double(p[1]) - meshlet.center[1], double(p[2]) - meshlet.center[2] };
+				if(std::sqrt((d[0] * d[0]) + (d[1] * d[1]) + (d[2] * d[2])) > meshlet.radius) {
+					spdlog::error("Meshlet {}: vertex {} is outside of the bounding sphere", m, v);
+					return false;
+				}
+			}
+
+			for(unsigned t = 0; t < meshlet.triangleCount; ++t) {
+				auto* local = set.triangles.data() + ((meshlet.firstTriangle + t) * 3);
+				if(local[0] >= meshlet.vertexCount || local[1] >= meshlet.vertexCount || local[2] >= meshlet.vertexCount) {
+					spdlog::error("Meshlet {}: triangle {} has an invalid index", m, t);
+					return false;
+				}
+				got.push_back(normalizedTriangle(
+					set.vertices[meshlet.firstVertex + local[0]],
+					set.vertices[meshlet.firstVertex + local[1]],
+					set.vertices[meshlet.firstVertex + local[2]] ));
+			}
+		}
+
+		std::ranges::sort(expected);
+		std::ranges::sort(got);
+		if(expected != got) {
+			spdlog::error("The meshlets do not cover each of the {} triangles exactly once", expected.size());
+			return false;
+		}
+		return true;
+	}
+
+
+	/// Checks that whenever a meshlet is deemed back-facing,
+	/// all of its triangles actually are.
+	///
+	bool checkCones(const Shape& shape, const fmamdl::MeshletSet& set, unsigned viewCount, unsigned* culledCount) {
+		auto rng  = std::minstd_rand(1234);
+		auto dist = std::uniform_real_distribution<float>(-4.0f, 4.0f);
+		*culledCount = 0;
+		for(unsigned v = 0; v < viewCount; ++v) {
+			float view[3] = { dist(rng), dist(rng), dist(rng) };
+			for(std::size_t m = 0; m < set.meshlets.size(); ++m) {
+				auto& meshlet = set.meshlets[m];
+				if(! fmamdl::isMeshletBackFacing(meshlet, view)) continue;
+				++ *culledCount;
+				for(unsigned t = 0; t < meshlet.triangleCount; ++t) {
+					auto* local = set.triangles.data() + ((meshlet.firstTriangle + t) * 3);
+					auto& p0 = shape.vertices[set.vertices[meshlet.firstVertex + local[0]]].position;
+					auto& p1 = shape.vertices[set.vertices[meshlet.firstVertex + local[1]]].position;
+					auto& p2 = shape.vertices[set.vertices[meshlet.firstVertex + local[2]]].position;
+					double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+					double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+					double n[3]  = { (e1[1] * e2[2]) - (e1[2] * e2[1]), (e1[2] * e2[0]) - (e1[0] * e2[2]), (e1[0] * e2[1]) - (e1[1] * e2[0]) };
+					double toTri = (n[0] * (double(p0[0]) - view[0])) + (n[1] * (double(p0[1]) - view[1])) + (n[2] * (double(p0[2]) - view[2]));
+					if(toTri < 0.0) {
+						spdlog::error("Meshlet {}: triangle {} faces ({}, {}, {}), but the meshlet was culled", m, t, view[0], view[1], view[2]);
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+}
+
+
+
+int main(int argc, char** argv) {
+	if(argc > 2) return 1;
+	unsigned rings = (argc == 2)? std::strtoul(argv[1], nullptr, 10) : 32;
+	if(rings < 2) return 2;
+	bool ok = true;
+
+	auto shape = makeSphere(rings, rings * 2);
+	fmamdl::MeshletSet set;
+	fmamdl::buildMeshlets(set, shape.triangles, shape.vertices, 0);
+	spdlog::info("{} triangles -> {} meshlets", shape.triangles.size() / 3, set.meshlets.size());
+	ok = checkMeshlets(shape, set) && ok;
+
+	unsigned culled;
+	constexpr unsigned viewCount = 64;
+	ok = checkCones(shape, set, viewCount, &culled) && ok;
+	spdlog::info("{} of {} meshlet tests were back-facing", culled, set.meshlets.size() * viewCount);
+	if(set.meshlets.size() > 2 && culled == 0) {
+		spdlog::error("No meshlet was ever culled");
+		ok = false;
+	}
+
+	return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
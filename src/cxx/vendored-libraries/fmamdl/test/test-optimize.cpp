@@ -0,0 +1,186 @@
+#include <fmamdl/fmamdl.hpp>
+#include <fmamdl/optimize.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+
+
+namespace {
+
+	using Triangle = std::array<std::array<fmamdl::f4_t, 3>, 3>;
+
+
+	struct Model {
+		std::vector<fmamdl::Mesh>   meshes;
+		std::vector<fmamdl::Face>   faces;
+		std::vector<fmamdl::Index>  indices;
+		std::vector<fmamdl::Vertex> vertices;
+	};
+
+
+	/// Two meshes, each a bumpy grid of quads and triangles, with shuffled faces and vertices.
+	///
+	Model makeModel(unsigned side) {
+		auto rng = std::mt19937(side);
+		Model r;
+
+		for(unsigned m = 0; m < 2; ++m) {
+			auto firstVertex = r.vertices.size();
+			for(unsigned y = 0; y <= side; ++y)
+			for(unsigned x = 0; x <= side; ++x) {
+				fmamdl::Vertex vtx = { };
+				vtx.position[0] = float(x);
+				vtx.position[1] = float(y);
+				vtx.position[2] = float(m) + (0.25f * float((x * 7 + y * 3) % 5));
+				r.vertices.push_back(vtx);
+			}
+
+			std::vector<std::vector<fmamdl::u4_t>> polygons;
+			auto at = [&](unsigned x, unsigned y) { return fmamdl::u4_t(firstVertex + (y * (side + 1)) + x); };
+			for(unsigned y = 0; y < side; ++y)
+			for(unsigned x = 0; x < side; ++x) {
+				if((x + y) % 3 == 0) {
+					polygons.push_back({ at(x, y), at(x+1, y), at(x+1, y+1) });
+					polygons.push_back({ at(x, y), at(x+1, y+1), at(x, y+1) });
+				} else {
+					polygons.push_back({ at(x, y), at(x+1, y), at(x+1, y+1), at(x, y+1) });
+				}
+			}
+			std::shuffle(polygons.begin(), polygons.end(), rng);
+
+			fmamdl::Mesh mesh = { };
+			mesh.firstFace = r.faces.size();
+			mesh.faceCount = polygons.size();
+			auto firstIndex = r.indices.size();
+			for(auto& polygon : polygons) {
+				fmamdl::Face face = { };
+				face.firstIndex = r.indices.size();
+				face.indexCount = polygon.size();
+				for(auto v : polygon) r.indices.push_back(fmamdl::Index(v));
+				r.indices.push_back(fmamdl::Index::ePrimitiveRestart);
+				r.faces.push_back(face);
+			}
+			mesh.indexCount = r.indices.size() - firstIndex;
+			r.meshes.push_back(mesh);
+		}
+
+		// Shuffle the vertices, so that the fetch order is as bad as it gets
+		std::vector<fmamdl::u4_t> permutation = std::vector<fmamdl::u4_t>(r.vertices.size());
+		for(fmamdl::u4_t i = 0; i < permutation.size(); ++i) permutation[i] = i;
+		std::shuffle(permutation.begin(), permutation.end(), rng);
+		std::vector<fmamdl::Vertex> shuffled = std::vector<fmamdl::Vertex>(r.vertices.size());
+		for(std::size_t i = 0; i < permutation.size(); ++i) shuffled[permutation[i]] = r.vertices[i];
+		r.vertices = std::move(shuffled);
+		for(auto& idx : r.indices) if(idx != fmamdl::Index::ePrimitiveRestart) idx = fmamdl::Index(permutation[fmamdl::u4_t(idx)]);
+
+		return r;
+	}
+
+
+	/// Expands a mesh into its triangles, by vertex position and rotated to a
+	/// canonical first vertex, so that the winding order is preserved.
+	///
+	std::vector<Triangle> triangleSet(const Model& model, const fmamdl::Mesh& mesh) {
+		std::vector<Triangle> r;
+		auto pos = [&](fmamdl::Index idx) {
+			auto& vtx = model.vertices[fmamdl::u4_t(idx)];
+			return std::array<fmamdl::f4_t, 3> { vtx.position[0], vtx.position[1], vtx.position[2] };
+		};
+		for(std::size_t f = mesh.firstFace; f < mesh.firstFace + mesh.faceCount; ++f) {
+			auto& face = model.faces[f];
+			for(fmamdl::u4_t i = 1; i + 1 < face.indexCount; ++i) {
+				Triangle tri = {
+					pos(model.indices[face.firstIndex]),
+					pos(model.indices[face.firstIndex + i]),
+					pos(model.indices[face.firstIndex + i + 1]) };
+				std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+				r.push_back(tri);
+			}
+		}
+		std::sort(r.begin(), r.end());
+		return r;
+	}
+
+
+	bool checkFaceLayout(const Model& model) {
+		for(std::size_t f = 0; f < model.faces.size(); ++f) {
+			auto& face = model.faces[f];
+			auto  end  = face.firstIndex + face.indexCount;
+			if(end >= model.indices.size() || model.indices[end] != fmamdl::Index::ePrimitiveRestart) {
+				spdlog::error("Face {} is not terminated by a primitive restart", f);
+				return false;
+			}
+			for(auto i = face.firstIndex; i < end; ++i) {
+				if(model.indices[i] == fmamdl::Index::ePrimitiveRestart || fmamdl::u4_t(model.indices[i]) >= model.vertices.size()) {
+					spdlog::error("Face {} has an invalid index at {}", f, i);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+}
+
+
+
+int main(int argc, char** argv) {
+	if(argc > 2) return 1;
+	unsigned side = (argc == 2)? std::strtoul(argv[1], nullptr, 10) : 16;
+	if(side < 1) return 2;
+
+	auto model = makeModel(side);
+	std::vector<std::vector<Triangle>> trianglesBefore;
+	for(auto& mesh : model.meshes) trianglesBefore.push_back(triangleSet(model, mesh));
+	auto before = fmamdl::computeVertexCacheStats(model.indices);
+
+	for(auto& mesh : model.meshes) {
+		auto faces = std::span<fmamdl::Face>(model.faces).subspan(mesh.firstFace, mesh.faceCount);
+		fmamdl::optimizeFaceOrder(faces, model.indices, model.vertices);
+	}
+	auto usedVertices = fmamdl::optimizeVertexFetch(model.indices, model.vertices);
+	auto after = fmamdl::computeVertexCacheStats(model.indices);
+
+	spdlog::info("ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", before.acmr(), after.acmr(), before.atvr(), after.atvr());
+
+	bool ok = checkFaceLayout(model);
+	for(std::size_t m = 0; m < model.meshes.size(); ++m) {
+		if(triangleSet(model, model.meshes[m]) != trianglesBefore[m]) {
+			spdlog::error("Mesh {} does not have the same triangles after the optimization", m);
+			ok = false;
+		}
+	}
+
+	if(usedVertices != model.vertices.size()) {
+		spdlog::error("{} vertices are referenced, expected {}", usedVertices, model.vertices.size());
+		ok = false;
+	}
+
+	fmamdl::u4_t nextNewVertex = 0;
+	for(auto idx : model.indices) {
+		if(idx == fmamdl::Index::ePrimitiveRestart) continue;
+		if(fmamdl::u4_t(idx) > nextNewVertex) {
+			spdlog::error("Vertex {} is used before vertex {}", fmamdl::u4_t(idx), nextNewVertex);
+			ok = false;
+			break;
+		}
+		if(fmamdl::u4_t(idx) == nextNewVertex) ++ nextNewVertex;
+	}
+
+	if(after.triangleCount != before.triangleCount || after.vertexCount != before.vertexCount) {
+		spdlog::error("Triangle or vertex count changed");
+		ok = false;
+	}
+	if(after.acmr() > before.acmr()) {
+		spdlog::error("The optimized ACMR is worse than the original one");
+		ok = false;
+	}
+
+	return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
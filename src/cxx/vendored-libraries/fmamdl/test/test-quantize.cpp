@@ -0,0 +1,166 @@
+#include <fmamdl/fmamdl.hpp>
+#include <fmamdl/quantize.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+namespace {
+
+	constexpr std::size_t vertexCount = 4096;
+
+
+	void normalize(fmamdl::f4_t v[3]) {
+		auto len = std::sqrt((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2]));
+		for(unsigned i = 0; i < 3; ++i) v[i] /= len;
+	}
+
+
+	fmamdl::f4_t dot(const fmamdl::f4_t l[3], const fmamdl::f4_t r[3]) {
+		return (l[0] * r[0]) + (l[1] * r[1]) + (l[2] * r[2]);
+	}
+
+
+	std::vector<fmamdl::Vertex> randomVertices(float scale) {
+		auto rng  = std::mt19937(0x5eed);
+		auto pos  = std::uniform_real_distribution<float>(-scale, +scale);
+		auto tex  = std::uniform_real_distribution<float>(-4.0f, +4.0f);
+		auto unit = std::normal_distribution<float>(0.0f, 1.0f);
+		auto coin = std::bernoulli_distribution(0.5);
+
+		std::vector<fmamdl::Vertex> r;
+		r.resize(vertexCount);
+		for(auto& vtx : r) {
+			fmamdl::f4_t any[3];
+			for(unsigned i = 0; i < 3; ++i) {
+				vtx.position[i] = pos(rng);
+				vtx.normal[i]   = unit(rng);
+				any[i]          = unit(rng);
+			}
+			vtx.texture[0] = tex(rng);
+			vtx.texture[1] = tex(rng);
+			normalize(vtx.normal);
+
+			// Gram-Schmidt, then the bi-tangent is either N x T or T x N
+			auto proj = dot(any, vtx.normal);
+			for(unsigned i = 0; i < 3; ++i) vtx.tangent[i] = any[i] - (vtx.normal[i] * proj);
+			normalize(vtx.tangent);
+			float sign = coin(rng)? +1.0f : -1.0f;
+			vtx.bitangent[0] = sign * ((vtx.normal[1] * vtx.tangent[2]) - (vtx.normal[2] * vtx.tangent[1]));
+			vtx.bitangent[1] = sign * ((vtx.normal[2] * vtx.tangent[0]) - (vtx.normal[0] * vtx.tangent[2]));
+			vtx.bitangent[2] = sign * ((vtx.normal[0] * vtx.tangent[1]) - (vtx.normal[1] * vtx.tangent[0]));
+		}
+		return r;
+	}
+
+
+	bool testRoundTrip(float scale) {
+		auto vertices = randomVertices(scale);
+		auto bounds   = fmamdl::computeVertexBounds(vertices);
+		bool r = true;
+
+		float maxPosError = 0.0f;
+		float maxNrmError = 0.0f;
+		float maxTanError = 0.0f;
+		for(std::size_t v = 0; v < vertices.size(); ++v) {
+			auto& src = vertices[v];
+			auto  dst = fmamdl::decompressVertex(fmamdl::compressVertex(src, bounds), bounds);
+
+			for(unsigned i = 0; i < 3; ++i) {
+				// Half of a quantization step, plus the rounding error of the float arithmetic
+				auto tolerance = (bounds.extent[i] * (0.5f / 65535.0f)) + (std::abs(src.position[i]) * 1e-6f);
+				auto error     = std::abs(dst.position[i] - src.position[i]);
+				maxPosError = std::max(maxPosError, error);
+				if(error > tolerance) {
+					spdlog::error("Vertex {} position[{}]: {} != {} (tolerance {})", v, i, dst.position[i], src.position[i], tolerance);
+					r = false;
+				}
+			}
+
+			for(unsigned i = 0; i < 2; ++i) {
+				// Half-floats have 11 significant bits
+				auto tolerance = (std::abs(src.texture[i]) / 2048.0f) + 1e-6f;
+				if(std::abs(dst.texture[i] - src.texture[i]) > tolerance) {
+					spdlog::error("Vertex {} texture[{}]: {} != {}", v, i, dst.texture[i], src.texture[i]);
+					r = false;
+				}
+			}
+
+			auto nrmError = 1.0f - dot(src.normal,    dst.normal);
+			auto tanError = 1.0f - dot(src.tangent,   dst.tangent);
+			auto btnError = 1.0f - dot(src.bitangent, dst.bitangent);
+			maxNrmError = std::max(maxNrmError, nrmError);
+			maxTanError = std::max(maxTanError, std::max(tanError, btnError));
+			if(nrmError > 1e-6f) { spdlog::error("Vertex {} normal is off by {}",     v, nrmError); r = false; }
+			if(tanError > 1e-6f) { spdlog::error("Vertex {} tangent is off by {}",    v, tanError); r = false; }
+			if(btnError > 1e-5f) { spdlog::error("Vertex {} bi-tangent is off by {}", v, btnError); r = false; }
+		}
+
+		spdlog::info("Scale {}: max. position error {}, max. normal error {}, max. tangent error {}", scale, maxPosError, maxNrmError, maxTanError);
+		return r;
+	}
+
+
+	bool testOctahedralEdges() {
+		const fmamdl::f4_t vectors[][3] = {
+			{ +1.0f,  0.0f,  0.0f }, { -1.0f,  0.0f,  0.0f },
+			{  0.0f, +1.0f,  0.0f }, {  0.0f, -1.0f,  0.0f },
+			{  0.0f,  0.0f, +1.0f }, {  0.0f,  0.0f, -1.0f } };
+		bool r = true;
+		for(auto& vec : vectors) {
+			fmamdl::s2_t enc[2];
+			fmamdl::f4_t dec[3];
+			fmamdl::octEncode(enc, vec);
+			fmamdl::octDecode(dec, enc);
+			if(dot(vec, dec) < 1.0f - 1e-6f) {
+				spdlog::error("Axis ({}, {}, {}) decoded as ({}, {}, {})", vec[0], vec[1], vec[2], dec[0], dec[1], dec[2]);
+				r = false;
+			}
+		}
+		return r;
+	}
+
+
+	bool testHeaderAccess() {
+		constexpr std::size_t modelSize = 0x200;
+		auto modelMem = std::make_unique<std::byte[]>(modelSize);
+		fmamdl::HeaderView h = { modelMem.get(), modelSize };
+		h.flags()             = fmamdl::HeaderFlags(std::byteswap(fmamdl::header_flags_e(fmamdl::HeaderFlags::eCompactVertices)));
+		h.vertexTableOffset() = 0x100;
+		h.vertexCount()       = 3;
+		h.meshCount()         = 1;
+
+		if(! h.hasCompactVertices()) { spdlog::error("The compact vertex flag is not detected"); return false; }
+		if(h.vertexStride() != sizeof(fmamdl::CompactVertex)) { spdlog::error("Wrong compact vertex stride"); return false; }
+		auto boundsOffset = reinterpret_cast<const std::byte*>(h.vertexBoundsPtr()) - h.data;
+		if(boundsOffset != 0x140) {
+			spdlog::error("Vertex bounds table at {:#x}, expected 0x140", boundsOffset);
+			return false;
+		}
+		return true;
+	}
+
+}
+
+
+
+int main(int argc, char** argv) {
+	static_assert(sizeof(fmamdl::CompactVertex) == 20);
+	static_assert(sizeof(fmamdl::VertexBounds)  == 24);
+
+	if(argc > 2) return 1;
+	float scale = (argc == 2)? std::strtof(argv[1], nullptr) : 1.0f;
+	if(! (scale > 0.0f)) return 2;
+
+	bool ok = true;
+	ok = testHeaderAccess()    && ok;
+	ok = testOctahedralEdges() && ok;
+	ok = testRoundTrip(scale)  && ok;
+	return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+#include <fmamdl/fmamdl.hpp>
+#include <fmamdl/simplify.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+
+
+namespace {
+
+	struct Grid {
+		std::vector<fmamdl::Index>  indices;
+		std::vector<fmamdl::Vertex> vertices;
+	};
+
+
+	/// A (side x side) grid of quads, as fans with primitive restarts;
+	/// `bump` scales a wavy height field.
+	///
+	Grid makeGrid(unsigned side, float bump) {
+		Grid r;
+		for(unsigned y = 0; y <= side; ++y)
+		for(unsigned x = 0; x <= side; ++x) {
+			fmamdl::Vertex vtx = { };
+			vtx.position[0] = float(x);
+			vtx.position[1] = float(y);
+			vtx.position[2] = bump * std::sin(float(x) * 0.7f) * std::cos(float(y) * 0.4f);
+			vtx.normal[2]   = 1.0f;
+			r.vertices.push_back(vtx);
+		}
+
+		auto at = [&](unsigned x, unsigned y) { return fmamdl::Index((y * (side + 1)) + x); };
+		for(unsigned y = 0; y < side; ++y)
+		for(unsigned x = 0; x < side; ++x) {
+			r.indices.push_back(at(x, y));
+			r.indices.push_back(at(x+1, y));
+			r.indices.push_back(at(x+1, y+1));
+			r.indices.push_back(at(x, y+1));
+			r.indices.push_back(fmamdl::Index::ePrimitiveRestart);
+		}
+		return r;
+	}
+
+
+	bool checkTriangles(const std::vector<fmamdl::u4_t>& triangles, std::size_t vertexCount, const char* what) {
+		if(triangles.size() % 3 != 0) {
+			spdlog::error("{}: {} indices do not make whole triangles", what, triangles.size());
+			return false;
+		}
+		for(std::size_t i = 0; i < triangles.size(); i += 3) {
+			auto a = triangles[i];  auto b = triangles[i+1];  auto c = triangles[i+2];
+			if(a >= vertexCount || b >= vertexCount || c >= vertexCount) {
+				spdlog::error("{}: triangle {} has an invalid index", what, i / 3);
+				return false;
+			}
+			if(a == b || b == c || c == a) {
+				spdlog::error("{}: triangle {} is degenerate", what, i / 3);
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/// Twice the signed area of the triangles, projected on the XY plane.
+	///
+	double projectedArea(const std::vector<fmamdl::u4_t>& triangles, const std::vector<fmamdl::Vertex>& vertices) {
+		double r = 0.0;
+		for(std::size_t i = 0; i < triangles.size(); i += 3) {
+			auto& p0 = vertices[triangles[i]].position;
+			auto& p1 = vertices[triangles[i+1]].position;
+			auto& p2 = vertices[triangles[i+2]].position;
+			r += (double(p1[0] - p0[0]) * double(p2[1] - p0[1])) - (double(p1[1] - p0[1]) * double(p2[0] - p0[0]));
+		}
+		return r;
+	}
+
+}
+
+
+
+int main(int argc, char** argv) {
+	if(argc > 2) return 1;
+	unsigned side = (argc == 2)? std::strtoul(argv[1], nullptr, 10) : 24;
+	if(side < 2) return 2;
+	bool ok = true;
+
+	{ // A flat grid collapses with no error, and keeps its outline
+		auto grid      = makeGrid(side, 0.0f);
+		auto triangles = fmamdl::triangulateFans(grid.indices);
+		if(triangles.size() != std::size_t(side) * side * 6) {
+			spdlog::error("Triangulated {} indices, expected {}", triangles.size(), std::size_t(side) * side * 6);
+			ok = false;
+		}
+		auto simplified = fmamdl::simplifyTriangles(triangles, grid.vertices, 2);
+		spdlog::info("Flat grid: {} -> {} triangles, error {}", triangles.size() / 3, simplified.triangles.size() / 3, simplified.error);
+		ok = checkTriangles(simplified.triangles, grid.vertices.size(), "Flat grid") && ok;
+		if(simplified.error > 1e-4f) {
+			spdlog::error("Flat grid: error {} is not zero", simplified.error);
+			ok = false;
+		}
+		if(simplified.triangles.size() > 2 * 3) {
+			spdlog::error("Flat grid: {} triangles are left, expected 2", simplified.triangles.size() / 3);
+			ok = false;
+		}
+		auto areaBefore = projectedArea(triangles, grid.vertices);
+		auto areaAfter  = projectedArea(simplified.triangles, grid.vertices);
+		if(std::abs(areaBefore - areaAfter) > 1e-3 * areaBefore) {
+			spdlog::error("Flat grid: projected area changed from {} to {}", areaBefore / 2.0, areaAfter / 2.0);
+			ok = false;
+		}
+	}
+
+	{ // A bumpy grid yields a chain with fewer triangles and more error at each level
+		auto grid      = makeGrid(side, 1.0f);
+		auto triangles = fmamdl::triangulateFans(grid.indices);
+		auto chain     = fmamdl::buildLodChain(triangles, grid.vertices, 4);
+		if(chain.size() < 2) {
+			spdlog::error("Bumpy grid: only {} LOD levels were built", chain.size());
+			ok = false;
+		}
+		std::size_t prevCount = triangles.size() / 3;
+		fmamdl::f4_t prevError = 0.0f;
+		for(std::size_t l = 0; l < chain.size(); ++l) {
+			auto count = chain[l].triangles.size() / 3;
+			spdlog::info("Bumpy grid: LOD {} has {} triangles, error {}", l + 1, count, chain[l].error);
+			ok = checkTriangles(chain[l].triangles, grid.vertices.size(), "Bumpy grid") && ok;
+			if(count >= prevCount) {
+				spdlog::error("Bumpy grid: LOD {} has {} triangles, not fewer than {}", l + 1, count, prevCount);
+				ok = false;
+			}
+			if(chain[l].error < prevError) {
+				spdlog::error("Bumpy grid: LOD {} has a smaller error than the previous level", l + 1);
+				ok = false;
+			}
+			prevCount = count;
+			prevError = chain[l].error;
+		}
+	}
+
+	return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
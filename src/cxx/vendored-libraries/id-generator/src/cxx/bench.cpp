@@ -0,0 +1,56 @@
+#include "include/idgen_concurrent.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+using id_e = uint64_t; enum class Id : id_e { };
+
+
+struct MutexIdGenerator {
+	std::mutex mutex;
+	idgen::IdGenerator<Id> gen;
+
+	Id   generate() noexcept { auto lock = std::unique_lock(mutex); return gen.generate(); }
+	void recycle(Id id)      { auto lock = std::unique_lock(mutex); gen.recycle(id); }
+};
+
+
+// Every thread generates a few IDs, then recycles them in order of generation
+template <typename Generator>
+double measure(unsigned threadCount, size_t rounds) {
+	constexpr size_t window = 32;
+	using clock = std::chrono::steady_clock;
+	Generator generator;
+	std::vector<std::thread> threads;
+
+	auto beg = clock::now();
+	for(unsigned t = 0; t < threadCount; ++t) threads.emplace_back([&]() {
+		Id ids[window];
+		for(size_t r = 0; r < rounds; ++r) {
+			for(auto& id : ids) id = generator.generate();
+			for(auto& id : ids) generator.recycle(id);
+		}
+	});
+	for(auto& t : threads) t.join();
+	auto end = clock::now();
+
+	double ops = double(threadCount) * double(rounds) * double(window * 2);
+	return ops / std::chrono::duration<double>(end - beg).count() / 1'000'000.0;
+}
+
+
+int main() {
+	constexpr size_t rounds = 20'000;
+	fmt::print("{:>8} | {:>16} | {:>16}\n", "threads", "mutex Mops/s", "concurrent Mops/s");
+	for(unsigned threads : { 1u, 2u, 4u, 8u, 16u }) {
+		double m = measure<MutexIdGenerator>(threads, rounds);
+		double c = measure<idgen::ConcurrentIdGenerator<Id>>(threads, rounds);
+		fmt::print("{:>8} | {:>16.2f} | {:>16.2f}\n", threads, m, c);
+	}
+}
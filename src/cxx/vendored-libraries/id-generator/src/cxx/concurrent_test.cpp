@@ -0,0 +1,122 @@
+#include <cassert> // Must be included before `idgen.hpp`
+#include "include/idgen_concurrent.hpp"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+
+using id32u_e = uint32_t; enum class Id32u : id32u_e { };
+using id8u_e  = uint8_t;  enum class Id8u  : id8u_e  { };
+using id8s_e  = int8_t;   enum class Id8s  : id8s_e  { };
+
+
+
+// Every thread keeps a window of live IDs, and randomly generates or recycles them;
+// an ID that is generated while it is live is a duplicate.
+bool testNoLiveDuplicates(unsigned threadCount, size_t opsPerThread) {
+	constexpr size_t maxLivePerThread = 512;
+
+	idgen::ConcurrentIdGenerator<Id32u> generator;
+	size_t idCap = threadCount * opsPerThread + 1;
+	auto live = std::make_unique<std::atomic_bool[]>(idCap);
+	std::atomic_size_t duplicates = 0;
+	std::atomic_size_t maxId = 0;
+
+	auto work = [&](unsigned seed) {
+		auto rng = std::minstd_rand(seed);
+		std::vector<Id32u> owned;
+		owned.reserve(maxLivePerThread);
+		size_t localMax = 0;
+		for(size_t i = 0; i < opsPerThread; ++i) {
+			bool gen = owned.empty() || (owned.size() < maxLivePerThread && rng() % 2 == 0);
+			if(gen) {
+				auto id = generator.generate();
+				auto idv = size_t(id);
+				if(idv >= idCap || live[idv].exchange(true)) ++ duplicates;
+				else owned.push_back(id);
+				localMax = std::max(localMax, idv);
+			} else {
+				size_t idx = rng() % owned.size();
+				live[size_t(owned[idx])].store(false);
+				generator.recycle(owned[idx]);
+				owned[idx] = owned.back();
+				owned.pop_back();
+			}
+		}
+		for(auto id : owned) { live[size_t(id)].store(false); generator.recycle(id); }
+		size_t prevMax = maxId.load();
+		while(prevMax < localMax && ! maxId.compare_exchange_weak(prevMax, localMax));
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < threadCount; ++i) threads.emplace_back(work, i + 1);
+	for(auto& t : threads) t.join();
+
+	fmt::print("{} threads, {} operations each: {} duplicates, highest ID {}\n", threadCount, opsPerThread, duplicates.load(), maxId.load());
+	return duplicates == 0;
+}
+
+
+// Exhausts a small ID type from several threads: every possible ID
+// must be generated exactly once, then only invalid IDs.
+template <typename Id>
+bool testExhaustion(unsigned threadCount) {
+	using id_e = std::underlying_type_t<Id>;
+	constexpr size_t idCount = size_t(idgen::maxId<id_e>()) - size_t(idgen::baseId<id_e>()) + 1;
+
+	idgen::ConcurrentIdGenerator<Id> generator;
+	std::atomic_size_t seen[idCount] = { };
+	std::atomic_size_t invalid = 0;
+
+	auto work = [&]() {
+		for(size_t i = 0; i < idCount; ++i) {
+			auto id = generator.generate();
+			if(id == idgen::invalidId<Id>()) { ++ invalid; continue; }
+			++ seen[size_t(id) - size_t(idgen::baseId<id_e>())];
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < threadCount; ++i) threads.emplace_back(work);
+	for(auto& t : threads) t.join();
+
+	bool fail = false;
+	for(size_t i = 0; i < idCount; ++i) {
+		if(seen[i] != 1) {
+			fmt::print("ID {} was generated {} times\n", i + size_t(idgen::baseId<id_e>()), seen[i].load());
+			fail = true;
+		}
+	}
+	if(invalid != (threadCount - 1) * idCount) {
+		fmt::print("{} invalid IDs instead of {}\n", invalid.load(), (threadCount - 1) * idCount);
+		fail = true;
+	}
+	fmt::print("{} threads exhausted {} IDs\n", threadCount, idCount);
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	try {
+		fail = testNoLiveDuplicates(1, 200'000)? fail : true;
+		fail = testNoLiveDuplicates(8, 200'000)? fail : true;
+		fail = testNoLiveDuplicates(32, 50'000)? fail : true;
+		fail = testExhaustion<Id8u>(4)? fail : true;
+		fail = testExhaustion<Id8s>(4)? fail : true;
+	} catch(...) {
+		return EXIT_FAILURE;
+	}
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "idgen.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+
+#ifdef assert
+	#define try_assert_(W_) assert(W_)
+#else
+	#define try_assert_(W_) ((void) (W_))
+#endif
+
+
+
+namespace idgen {
+
+	/// A thread-safe counterpart of `IdGenerator`.
+	///
+	/// Every thread is assigned one of `shard_count` shards, each of which
+	/// caches a batch of never-generated IDs (reserved from a shared atomic
+	/// counter) and the IDs recycled by its threads.
+	/// As long as there are no more threads than shards, the mutex of a
+	/// shard is practically never contended.
+	///
+	/// Unlike `IdGenerator`, IDs are not generated in order, recycled IDs
+	/// are regenerated by the shard that recycled them, and recycling the
+	/// same ID twice is not detected.
+	///
+	template <ScopedEnum T, size_t shard_count = 16, size_t batch_size = 64>
+	class ConcurrentIdGenerator {
+	public:
+		static_assert(shard_count > 0);
+		static_assert(batch_size > 0);
+
+		using Ut = std::underlying_type_t<T>;
+
+		ConcurrentIdGenerator() = default;
+		ConcurrentIdGenerator(const ConcurrentIdGenerator&) = delete;
+
+		T generate() noexcept {
+			Ut r;
+			auto& shard = gen_shards[threadShardIndex()];
+			{
+				auto lock = std::unique_lock(shard.mutex);
+				if(shard.tryTake(r)) [[likely]] return T(r);
+				if(reserve(shard) && shard.tryTake(r)) return T(r);
+			}
+
+			// The counter is exhausted, the other shards may still have something
+			for(auto& other : gen_shards) {
+				auto lock = std::unique_lock(other.mutex);
+				if(other.tryTake(r)) return T(r);
+			}
+			return invalidId<T>();
+		}
+
+		void recycle(T id) {
+			Ut idv = Ut(id);
+
+			try_assert_(idv >= minId<Ut>());
+			try_assert_(idv <= maxId<Ut>());
+			if(idv < minId<Ut>()) [[unlikely]] return;
+			if(idv > maxId<Ut>()) [[unlikely]] return;
+
+			auto& shard = gen_shards[threadShardIndex()];
+			auto lock = std::unique_lock(shard.mutex);
+			shard.recycled.push_back(idv);
+		}
+
+	private:
+		// `std::hardware_destructive_interference_size` is not ABI-stable, hence a guess
+		static constexpr size_t cacheLineSize = 64;
+
+		struct alignas(cacheLineSize) Shard {
+			std::mutex      mutex;
+			Ut              reservedNext  = baseId<Ut>();
+			size_t          reservedCount = 0;
+			std::vector<Ut> recycled;
+
+			bool tryTake(Ut& dst) noexcept {
+				if(! recycled.empty()) {
+					dst = recycled.back();
+					recycled.pop_back();
+					return true;
+				}
+				if(reservedCount > 0) {
+					dst = reservedNext;
+					-- reservedCount;
+					if(reservedCount > 0) ++ reservedNext; // Never goes past the last reserved ID, which may be `maxId`
+					return true;
+				}
+				return false;
+			}
+		};
+
+		static size_t threadShardIndex() noexcept {
+			static std::atomic_size_t nextThreadIndex = 0;
+			thread_local size_t index = nextThreadIndex.fetch_add(1, std::memory_order_relaxed) % shard_count;
+			return index;
+		}
+
+		// Reserves up to `batch_size` IDs for a shard; the batches shrink
+		// as the counter approaches `maxId`, so that small ID types are not
+		// spread too thin across the shards.
+		bool reserve(Shard& shard) noexcept {
+			using UUt = std::make_unsigned_t<Ut>;
+			Ut last = gen_lastReserved.load(std::memory_order_relaxed);
+			size_t count;
+			do {
+				if(last == maxId<Ut>()) return false;
+				auto remaining = UUt(UUt(maxId<Ut>()) - UUt(last));
+				count = (remaining > batch_size * shard_count)? batch_size : 1;
+			} while(! gen_lastReserved.compare_exchange_weak(last, Ut(last + Ut(count)), std::memory_order_relaxed));
+			shard.reservedNext  = Ut(last + Ut(1));
+			shard.reservedCount = count;
+			return true;
+		}
+
+		std::atomic<Ut> gen_lastReserved = Ut(baseId<Ut>() - Ut(1));
+		std::array<Shard, shard_count> gen_shards;
+	};
+
+}
+
+
+
+#undef try_assert_
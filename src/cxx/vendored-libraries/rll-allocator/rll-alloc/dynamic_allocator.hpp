@@ -1,6 +1,7 @@
 #pragma once
 
 #include "static_allocator.hpp"
+#include "tlsf_allocator.hpp"
 
 #include <concepts>
 #include <vector>
@@ -10,12 +11,15 @@
 
 namespace rll_alloc {
 
-	template <typename T>
+	/// \brief A source of buckets for a DynAllocator, whose
+	///        pages are managed by `bucket_template` allocators.
+	///
+	template <typename T, template <typename, size_t> class bucket_template = StaticAllocator>
 	concept Preallocator = requires(
 		T t,
 		T&& t_rvalue,
 		size_t page_count,
-		const StaticAllocator<typename T::addr_t, T::pageSize>& bucket_ref
+		const bucket_template<typename T::addr_t, T::pageSize>& bucket_ref
 	) {
 		typename T::addr_t;
 		{ T::pageSize } -> std::convertible_to<size_t>;
@@ -29,7 +33,7 @@ namespace rll_alloc {
 
 	namespace _template_impl {
 
-		template <Preallocator iface_t, typename BucketVector>
+		template <typename iface_t, typename BucketVector>
 		size_t occupy_empty_page_seq_dyn(
 				iface_t& iface,
 				BucketVector& buckets,
@@ -68,7 +72,7 @@ namespace rll_alloc {
 		}
 
 
-		template <Preallocator preallocator_t, typename BucketVector>
+		template <typename preallocator_t, typename BucketVector>
 		void free_page_seq_dyn(
 				preallocator_t& preallocator,
 				BucketVector& buckets,
@@ -100,12 +104,22 @@ namespace rll_alloc {
 
 
 
-	template <Preallocator preallocator_t>
+	/// \brief An allocator that acquires fixed-size buckets of pages
+	///        as needed, from a Preallocator.
+	///
+	/// Each bucket is managed by a `bucket_template` allocator: either
+	/// StaticAllocator (the default) or TlsfAllocator, which trades some
+	/// memory for constant time allocations within a bucket.
+	///
+	template <
+		typename preallocator_t,
+		template <typename, size_t> class bucket_template = StaticAllocator >
+	requires Preallocator<preallocator_t, bucket_template>
 	class DynAllocator {
 	public:
 		using addr_t = preallocator_t::addr_t;
 		using alloc_t = Allocation<addr_t>;
-		using static_allocator_t = StaticAllocator<addr_t, preallocator_t::pageSize>;
+		using static_allocator_t = bucket_template<addr_t, preallocator_t::pageSize>;
 		static constexpr size_t pageSize = preallocator_t::pageSize;
 
 		DynAllocator() = default;
@@ -158,4 +172,9 @@ namespace rll_alloc {
 		size_t pagesPerBucket;
 	};
 
+
+
+	template <Preallocator<TlsfAllocator> preallocator_t>
+	using TlsfDynAllocator = DynAllocator<preallocator_t, TlsfAllocator>;
+
 }
@@ -243,38 +243,38 @@ namespace rll_alloc::_type_unaware_impl {
 			size_t new_size
 	) noexcept {
 		using _util_impl::bitmap_set;
+		using _util_impl::bitmap_get;
 		using _type_unaware_impl::bitmap_word_t;
-		size_t seq_length = 0;
-		size_t cursor = resize_offset;
 		auto* bitmap = state.allocBitmap;
 
-		bitmap_word_t page_status;
-		while((page_status = _util_impl::bitmap_get(bitmap, cursor++)) == _util_impl::bitmap_value_occupied) {
-			assert(cursor <= state.pageCount);
+		// The sequence ends with (and includes) its only `bitmap_value_last` page
+		size_t seq_length = 1;
+		while(bitmap_get(bitmap, resize_offset + seq_length - 1) == _util_impl::bitmap_value_occupied) {
+			assert(resize_offset + seq_length < state.pageCount);
 			++ seq_length;
 		}
+		assert(bitmap_get(bitmap, resize_offset + seq_length - 1) == _util_impl::bitmap_value_last);
 
-		assert(page_status == _util_impl::bitmap_value_last);
+		if(new_size < 1) return false;
 		if(resize_offset + new_size > state.pageCount) return false;
 
+		size_t end = resize_offset + new_size;
 		if(seq_length < new_size) {
-			// Grow the sequence
-			size_t i;
-			size_t beg = resize_offset + seq_length;
-			size_t end = beg + new_size - 1;
-			for(i = beg; i < end; ++i) {
+			// Grow the sequence, if the following pages are free
+			for(size_t i = resize_offset + seq_length; i < end; ++i) {
+				if(bitmap_get(bitmap, i) != 0b00) return false;
+			}
+			for(size_t i = resize_offset + seq_length - 1; i < end - 1; ++i) {
 				bitmap_set(bitmap, i, _util_impl::bitmap_value_occupied);
-				assert(i+1 <= state.pageCount);
 			}
-			bitmap_set(bitmap, i, _util_impl::bitmap_value_last);
-		} else {
+			bitmap_set(bitmap, end - 1, _util_impl::bitmap_value_last);
+		} else if(new_size < seq_length) {
 			// Shrink the sequence
-			size_t beg = resize_offset + new_size;
-			size_t end = beg + seq_length;
-			for(size_t i = beg; i < end; ++i) {
-				assert(i <= state.pageCount);
+			for(size_t i = end; i < resize_offset + seq_length; ++i) {
 				bitmap_set(bitmap, i, 0b00);
 			}
+			bitmap_set(bitmap, end - 1, _util_impl::bitmap_value_last);
+			state.lastFailStride = SIZE_MAX;
 		}
 
 		return true;
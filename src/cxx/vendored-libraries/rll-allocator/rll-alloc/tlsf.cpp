@@ -0,0 +1,294 @@
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+
+
+namespace rll_alloc::_util_impl {
+
+	using _type_unaware_impl::TlsfState;
+	using _type_unaware_impl::TlsfBlock;
+	using _type_unaware_impl::tlsf_sl_log2;
+	using _type_unaware_impl::tlsf_sl_count;
+	using _type_unaware_impl::tlsf_fl_count;
+	using _type_unaware_impl::tlsf_null_block;
+
+
+	struct TlsfClass {
+		unsigned fl;
+		unsigned sl;
+	};
+
+
+	// Sizes below `tlsf_sl_count` have one class each, the others
+	// are split into `tlsf_sl_count` linear classes per power of two.
+	TlsfClass tlsf_class_of(size_t page_count) noexcept {
+		assert(page_count > 0);
+		if(page_count < tlsf_sl_count) return { 0, unsigned(page_count) };
+		unsigned log2 = unsigned(std::bit_width(page_count)) - 1;
+		return {
+			log2 - tlsf_sl_log2 + 1,
+			unsigned(page_count >> (log2 - tlsf_sl_log2)) - tlsf_sl_count };
+	}
+
+	// The class of the smallest sequences that can certainly fit `page_count` pages.
+	TlsfClass tlsf_class_of_fit(size_t page_count) noexcept {
+		if(page_count >= tlsf_sl_count) {
+			unsigned log2 = unsigned(std::bit_width(page_count)) - 1;
+			size_t round = (size_t(1) << (log2 - tlsf_sl_log2)) - 1;
+			if(page_count > SIZE_MAX - round) return { tlsf_fl_count, 0 };
+			page_count += round;
+		}
+		return tlsf_class_of(page_count);
+	}
+
+
+	size_t& tlsf_free_head(TlsfState& state, TlsfClass cl) noexcept {
+		return state.freeHeads[(cl.fl * tlsf_sl_count) + cl.sl];
+	}
+
+
+	void tlsf_insert_free(TlsfState& state, size_t block_idx) noexcept {
+		auto& block = state.blocks[block_idx];
+		auto  cl    = tlsf_class_of(block.pageCount);
+		auto& head  = tlsf_free_head(state, cl);
+		block.isFree   = true;
+		block.prevFree = tlsf_null_block;
+		block.nextFree = head;
+		if(head != tlsf_null_block) state.blocks[head].prevFree = block_idx;
+		head = block_idx;
+		state.flBitmap          |= uint_fast64_t(1) << cl.fl;
+		state.slBitmaps[cl.fl]  |= uint_fast32_t(1) << cl.sl;
+	}
+
+
+	void tlsf_remove_free(TlsfState& state, size_t block_idx) noexcept {
+		auto& block = state.blocks[block_idx];
+		assert(block.isFree);
+		if(block.prevFree != tlsf_null_block) {
+			state.blocks[block.prevFree].nextFree = block.nextFree;
+		} else {
+			auto  cl   = tlsf_class_of(block.pageCount);
+			auto& head = tlsf_free_head(state, cl);
+			assert(head == block_idx);
+			head = block.nextFree;
+			if(head == tlsf_null_block) {
+				state.slBitmaps[cl.fl] &= ~ (uint_fast32_t(1) << cl.sl);
+				if(state.slBitmaps[cl.fl] == 0) state.flBitmap &= ~ (uint_fast64_t(1) << cl.fl);
+			}
+		}
+		if(block.nextFree != tlsf_null_block) state.blocks[block.nextFree].prevFree = block.prevFree;
+		block.isFree = false;
+	}
+
+
+	// Makes sure that the next `count` blocks can be created without allocating memory;
+	// `unusedBlocks` can always hold every block, so that merging them never does.
+	void tlsf_reserve_blocks(TlsfState& state, size_t count) {
+		size_t required = state.blocks.size() + count;
+		if(state.blocks.capacity() < required) {
+			required = std::max(required, state.blocks.capacity() * 2);
+			state.blocks.reserve(required);
+		}
+		state.unusedBlocks.reserve(state.blocks.capacity());
+	}
+
+
+	size_t tlsf_new_block(TlsfState& state) noexcept {
+		if(! state.unusedBlocks.empty()) {
+			size_t r = state.unusedBlocks.back();
+			state.unusedBlocks.pop_back();
+			return r;
+		}
+		assert(state.blocks.size() < state.blocks.capacity());
+		state.blocks.push_back({ });
+		return state.blocks.size() - 1;
+	}
+
+
+	// Merges the block `rm_idx` into its physical predecessor, which must be `block_idx`.
+	void tlsf_absorb_next(TlsfState& state, size_t block_idx, size_t rm_idx) noexcept {
+		auto& block = state.blocks[block_idx];
+		auto& rm    = state.blocks[rm_idx];
+		assert(block.nextPhys == rm_idx);
+		block.pageCount += rm.pageCount;
+		block.nextPhys   = rm.nextPhys;
+		if(rm.nextPhys != tlsf_null_block) state.blocks[rm.nextPhys].prevPhys = block_idx;
+		state.unusedBlocks.push_back(rm_idx);
+	}
+
+
+	// Splits the last pages of a block into a new free block,
+	// which is merged with the next one if possible.
+	void tlsf_split_tail(TlsfState& state, size_t block_idx, size_t keep_pages) noexcept {
+		size_t tail_idx = tlsf_new_block(state);
+		auto& block = state.blocks[block_idx];
+		auto& tail  = state.blocks[tail_idx];
+		assert(keep_pages < block.pageCount);
+		tail.offset    = block.offset + keep_pages;
+		tail.pageCount = block.pageCount - keep_pages;
+		tail.prevPhys  = block_idx;
+		tail.nextPhys  = block.nextPhys;
+		block.pageCount = keep_pages;
+		block.nextPhys  = tail_idx;
+		if(tail.nextPhys != tlsf_null_block) {
+			state.blocks[tail.nextPhys].prevPhys = tail_idx;
+			if(state.blocks[tail.nextPhys].isFree) {
+				tlsf_remove_free(state, tail.nextPhys);
+				tlsf_absorb_next(state, tail_idx, tail.nextPhys);
+			}
+		}
+		tlsf_insert_free(state, tail_idx);
+	}
+
+
+	size_t tlsf_find_free(TlsfState& state, size_t page_count) noexcept {
+		auto cl = tlsf_class_of_fit(page_count);
+
+		if(cl.fl < tlsf_fl_count) {
+			uint_fast32_t sl_map = state.slBitmaps[cl.fl] & (~ uint_fast32_t(0) << cl.sl);
+			if(sl_map == 0) {
+				uint_fast64_t fl_map = (cl.fl + 1 < tlsf_fl_count)? state.flBitmap & (~ uint_fast64_t(0) << (cl.fl + 1)) : 0;
+				if(fl_map != 0) {
+					cl.fl  = unsigned(std::countr_zero(fl_map));
+					sl_map = state.slBitmaps[cl.fl];
+				}
+			}
+			if(sl_map != 0) {
+				cl.sl = unsigned(std::countr_zero(sl_map));
+				return tlsf_free_head(state, cl);
+			}
+		}
+
+		// No class is certain to fit the sequence, but the
+		// one it belongs to may still have a large enough block
+		size_t candidate = tlsf_free_head(state, tlsf_class_of(page_count));
+		while(candidate != tlsf_null_block) {
+			if(state.blocks[candidate].pageCount >= page_count) return candidate;
+			candidate = state.blocks[candidate].nextFree;
+		}
+		return tlsf_null_block;
+	}
+
+}
+
+
+
+namespace rll_alloc::_type_unaware_impl {
+
+	TlsfState::TlsfState(TlsfState&&) noexcept = default;
+	TlsfState& TlsfState::operator=(TlsfState&&) noexcept = default;
+	TlsfState::~TlsfState() = default;
+
+
+	void new_tlsf_state(TlsfState& state, size_t page_count) {
+		state.blocks.clear();
+		state.unusedBlocks.clear();
+		state.allocations.clear();
+		state.freeHeads.fill(tlsf_null_block);
+		state.slBitmaps.fill(0);
+		state.flBitmap  = 0;
+		state.pageCount = page_count;
+		if(page_count > 0) {
+			_util_impl::tlsf_reserve_blocks(state, 1);
+			state.blocks.push_back({
+				.offset = 0, .pageCount = page_count,
+				.prevPhys = tlsf_null_block, .nextPhys = tlsf_null_block,
+				.prevFree = tlsf_null_block, .nextFree = tlsf_null_block,
+				.isFree = false });
+			_util_impl::tlsf_insert_free(state, 0);
+		}
+	}
+
+
+	size_t tlsf_occupy(TlsfState& state, size_t page_count, size_t min_alignment) noexcept {
+		using namespace _util_impl;
+		assert(page_count > 0);
+		if(min_alignment < 1) min_alignment = 1;
+		if(page_count > SIZE_MAX - (min_alignment - 1)) return SIZE_MAX;
+
+		size_t block_idx = tlsf_find_free(state, page_count + (min_alignment - 1));
+		if(block_idx == tlsf_null_block) return SIZE_MAX;
+		size_t gap    = (min_alignment - (state.blocks[block_idx].offset % min_alignment)) % min_alignment;
+		size_t offset = state.blocks[block_idx].offset + gap;
+
+		// Allocate everything that may be needed before touching the state
+		std::unordered_map<size_t, size_t>::iterator alloc_entry;
+		try {
+			tlsf_reserve_blocks(state, 2);
+			alloc_entry = state.allocations.insert({ offset, tlsf_null_block }).first;
+		} catch(std::bad_alloc&) {
+			return SIZE_MAX;
+		}
+
+		tlsf_remove_free(state, block_idx);
+		if(gap > 0) {
+			// Leave the unaligned pages to the free block, and use its tail instead
+			size_t lead_idx = block_idx;
+			tlsf_split_tail(state, lead_idx, gap);
+			block_idx = state.blocks[lead_idx].nextPhys;
+			tlsf_remove_free(state, block_idx);
+			tlsf_insert_free(state, lead_idx);
+		}
+		if(state.blocks[block_idx].pageCount > page_count) tlsf_split_tail(state, block_idx, page_count);
+
+		assert(state.blocks[block_idx].offset == offset);
+		alloc_entry->second = block_idx;
+		return offset;
+	}
+
+
+	void tlsf_free(TlsfState& state, size_t free_at_offset) noexcept {
+		using namespace _util_impl;
+		auto found = state.allocations.find(free_at_offset);
+		if(found == state.allocations.end()) return;
+		size_t block_idx = found->second;
+		state.allocations.erase(found);
+
+		auto& block = state.blocks[block_idx];
+		if(block.nextPhys != tlsf_null_block && state.blocks[block.nextPhys].isFree) {
+			tlsf_remove_free(state, block.nextPhys);
+			tlsf_absorb_next(state, block_idx, block.nextPhys);
+		}
+		if(block.prevPhys != tlsf_null_block && state.blocks[block.prevPhys].isFree) {
+			size_t prev_idx = block.prevPhys;
+			tlsf_remove_free(state, prev_idx);
+			tlsf_absorb_next(state, prev_idx, block_idx);
+			block_idx = prev_idx;
+		}
+		tlsf_insert_free(state, block_idx);
+	}
+
+
+	bool tlsf_try_resize(TlsfState& state, size_t resize_offset, size_t new_size) noexcept {
+		using namespace _util_impl;
+		auto found = state.allocations.find(resize_offset);
+		if(found == state.allocations.end()) return false;
+		size_t block_idx = found->second;
+		size_t cur_size  = state.blocks[block_idx].pageCount;
+
+		if(new_size < 1) return false;
+		if(new_size == cur_size) return true;
+		try {
+			tlsf_reserve_blocks(state, 1);
+		} catch(std::bad_alloc&) {
+			return false;
+		}
+
+		if(new_size < cur_size) {
+			tlsf_split_tail(state, block_idx, new_size);
+			return true;
+		}
+
+		size_t next_idx = state.blocks[block_idx].nextPhys;
+		if(next_idx == tlsf_null_block || ! state.blocks[next_idx].isFree) return false;
+		if(cur_size + state.blocks[next_idx].pageCount < new_size) return false;
+		tlsf_remove_free(state, next_idx);
+		tlsf_absorb_next(state, block_idx, next_idx);
+		if(state.blocks[block_idx].pageCount > new_size) tlsf_split_tail(state, block_idx, new_size);
+		return true;
+	}
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "static_allocator.hpp"
+
+#include <array>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace rll_alloc {
+
+	namespace _type_unaware_impl {
+
+		constexpr unsigned tlsf_sl_log2  = 4;
+		constexpr unsigned tlsf_sl_count = 1u << tlsf_sl_log2;
+		constexpr unsigned tlsf_fl_count = std::numeric_limits<size_t>::digits - tlsf_sl_log2 + 1;
+		constexpr size_t   tlsf_null_block = SIZE_MAX;
+
+		struct TlsfBlock {
+			size_t offset;
+			size_t pageCount;
+			size_t prevPhys;
+			size_t nextPhys;
+			size_t prevFree;
+			size_t nextFree;
+			bool   isFree;
+		};
+
+		struct TlsfState {
+			// The destructor and moves are defined in tlsf.cpp: inlining them
+			// everywhere an allocator dies only grows the code (see -Winline)
+			TlsfState() = default;
+			TlsfState(TlsfState&&) noexcept;
+			TlsfState& operator=(TlsfState&&) noexcept;
+			~TlsfState();
+
+			std::vector<TlsfBlock> blocks;
+			std::vector<size_t>    unusedBlocks;
+			std::unordered_map<size_t, size_t> allocations; // Page offset -> block
+			std::array<size_t, tlsf_fl_count * tlsf_sl_count> freeHeads;
+			std::array<uint_fast32_t, tlsf_fl_count> slBitmaps;
+			uint_fast64_t flBitmap  = 0;
+			size_t        pageCount = 0;
+		};
+
+		void new_tlsf_state(TlsfState& state, size_t page_count);
+
+		size_t tlsf_occupy(TlsfState& state, size_t page_count, size_t min_alignment) noexcept;
+		void tlsf_free(TlsfState& state, size_t free_at_offset) noexcept;
+		bool tlsf_try_resize(TlsfState& state, size_t resize_offset, size_t new_size) noexcept;
+
+	}
+
+
+	/// \brief A drop-in alternative to StaticAllocator, with constant time
+	///        allocations and deallocations.
+	///
+	/// Free page sequences are kept in segregated lists (two-level segregated fit),
+	/// indexed by bitmaps: an allocation takes the first sequence of a class
+	/// that is guaranteed to be big enough, and a deallocation merges the
+	/// sequence with its free neighbors.
+	/// Only when no such class has free sequences are the ones of the
+	/// requested size's own class searched, which may fit it anyway.
+	///
+	/// Unlike StaticAllocator, which only needs two bits per page,
+	/// bookkeeping is proportional to the number of allocations.
+	///
+	template <AddressType addr_type, size_t page_size = 1>
+	class TlsfAllocator {
+	public:
+		static_assert(page_size > 0);
+
+		using addr_t = addr_type;
+		using alloc_t = Allocation<addr_t>;
+		static constexpr size_t pageSize = page_size;
+
+		TlsfAllocator() = default;
+		TlsfAllocator(const TlsfAllocator&) = delete;
+		TlsfAllocator(TlsfAllocator&&) = default;
+		TlsfAllocator& operator=(TlsfAllocator&&) = default;
+
+		TlsfAllocator(addr_t base, size_t page_count):
+			addrBase(base),
+			state { }
+		{
+			_type_unaware_impl::new_tlsf_state(state, page_count);
+		}
+
+		alloc_t try_alloc(size_t required_page_count, size_t min_alignment_pages = 0) noexcept {
+			if(required_page_count < 1) return { 0, 0 };
+			size_t page_offset = _type_unaware_impl::tlsf_occupy(
+				state,
+				required_page_count,
+				min_alignment_pages );
+			if(page_offset == SIZE_MAX) return { 0, 0 };
+			return {
+				addrBase + (page_offset * pageSize),
+				required_page_count };
+		}
+
+		addr_t alloc(size_t required_page_count, size_t min_alignment_pages = 0) {
+			auto allocd = try_alloc(required_page_count, min_alignment_pages);
+			if(allocd.pageCount < 1) throw OutOfPagesException();
+			return allocd.base;
+		}
+
+		void dealloc(addr_t allocation_base) noexcept {
+			_type_unaware_impl::tlsf_free(
+				state,
+				(allocation_base - addrBase) / pageSize );
+		}
+
+		bool try_resize(addr_t allocation_base, size_t new_size) {
+			return _type_unaware_impl::tlsf_try_resize(
+				state,
+				(allocation_base - addrBase) / pageSize,
+				new_size );
+		}
+
+		size_t pageCount() const noexcept { return state.pageCount; }
+		addr_t base()      const noexcept { return addrBase; }
+
+	private:
+		addr_t addrBase;
+		_type_unaware_impl::TlsfState state;
+	};
+
+};
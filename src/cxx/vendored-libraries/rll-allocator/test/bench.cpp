@@ -0,0 +1,79 @@
+#include <rll-alloc/static_allocator.hpp>
+#include <rll-alloc/tlsf_allocator.hpp>
+
+#include <chrono>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+
+
+using namespace rll_alloc;
+
+
+struct Mix {
+	std::string_view name;
+	size_t pageCount;
+	size_t maxRequest;
+	unsigned allocPercent;
+};
+
+
+struct BenchResult {
+	double nsPerOp;
+	size_t failures;
+};
+
+
+// Runs the same sequence of requests on any allocator
+template <template <typename, size_t> class allocator_template>
+BenchResult run_mix(const Mix& mix, size_t ops) {
+	using clock = std::chrono::steady_clock;
+	auto alloc = allocator_template<size_t, 1>(0, mix.pageCount);
+	auto rng   = std::minstd_rand(mix.pageCount ^ ops);
+	std::vector<size_t> live;
+	live.reserve(mix.pageCount);
+	size_t failures = 0;
+
+	auto beg = clock::now();
+	for(size_t i = 0; i < ops; ++i) {
+		if(live.empty() || (rng() % 100) < mix.allocPercent) {
+			auto allocd = alloc.try_alloc(1 + (rng() % mix.maxRequest));
+			if(allocd.pageCount > 0) live.push_back(allocd.base);
+			else ++ failures;
+		} else {
+			size_t idx = rng() % live.size();
+			alloc.dealloc(live[idx]);
+			live[idx] = live.back();
+			live.pop_back();
+		}
+	}
+	auto end = clock::now();
+
+	for(auto addr : live) alloc.dealloc(addr);
+	return {
+		std::chrono::duration<double, std::nano>(end - beg).count() / double(ops),
+		failures };
+}
+
+
+int main() {
+	spdlog::set_pattern("%v");
+	constexpr size_t ops = 1'000'000;
+
+	const Mix mixes[] = {
+		{ "small, balanced",     1 << 16, 4,   50 },
+		{ "small, alloc-heavy",  1 << 16, 4,   60 },
+		{ "mixed, balanced",     1 << 16, 64,  50 },
+		{ "large, balanced",     1 << 20, 1024, 50 },
+		{ "mixed, nearly full",  1 << 14, 64,  70 } };
+
+	spdlog::info("{:<20} | {:>14} {:>9} | {:>14} {:>9}", "mix", "static ns/op", "failures", "tlsf ns/op", "failures");
+	for(const auto& mix : mixes) {
+		auto st = run_mix<StaticAllocator>(mix, ops);
+		auto tl = run_mix<TlsfAllocator>(mix, ops);
+		spdlog::info("{:<20} | {:>14.1f} {:>9} | {:>14.1f} {:>9}", mix.name, st.nsPerOp, st.failures, tl.nsPerOp, tl.failures);
+	}
+}
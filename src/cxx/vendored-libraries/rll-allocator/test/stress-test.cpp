@@ -0,0 +1,190 @@
+#include <rll-alloc/static_allocator.hpp>
+#include <rll-alloc/tlsf_allocator.hpp>
+#include <rll-alloc/dynamic_allocator.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+
+
+using namespace rll_alloc;
+
+
+// Mirrors the allocations of an allocator, page by page, to detect overlaps and leaks
+class OccupancyModel {
+public:
+	OccupancyModel(size_t page_count): pages(page_count, false) { }
+	~OccupancyModel(); // Out of line, so that -Winline does not complain about it
+
+	bool occupy(size_t base, size_t count) {
+		if(base + count > pages.size()) return false;
+		for(size_t i = base; i < base + count; ++i) if(pages[i]) return false;
+		for(size_t i = base; i < base + count; ++i) pages[i] = true;
+		allocs[base] = count;
+		return true;
+	}
+
+	void free(size_t base) {
+		auto found = allocs.find(base);
+		for(size_t i = base; i < base + found->second; ++i) pages[i] = false;
+		allocs.erase(found);
+	}
+
+	void resize(size_t base, size_t new_count) {
+		auto& count = allocs.at(base);
+		for(size_t i = base + new_count; i < base + count; ++i) pages[i] = false;
+		for(size_t i = base + count;     i < base + new_count; ++i) pages[i] = true;
+		count = new_count;
+	}
+
+	bool isFree(size_t base, size_t count) const {
+		for(size_t i = base; i < base + count; ++i) if(pages[i]) return false;
+		return true;
+	}
+
+	const std::map<size_t, size_t>& allocations() const { return allocs; }
+
+private:
+	std::vector<bool> pages;
+	std::map<size_t, size_t> allocs;
+};
+
+OccupancyModel::~OccupancyModel() = default;
+
+
+// StaticAllocator's search is not exhaustive: it treats the alignment as a hint,
+// and may miss free sequences behind its cursor; `exhaustive` checks both.
+template <template <typename, size_t> class allocator_template>
+bool stress(std::string_view name, unsigned seed, bool exhaustive) {
+	constexpr size_t page_count = 4096;
+	constexpr size_t base       = 1 << 20;
+	constexpr size_t iterations = 200'000;
+
+	auto alloc = allocator_template<size_t, 1>(base, page_count);
+	auto model = OccupancyModel(page_count);
+	auto rng   = std::minstd_rand(seed);
+	std::vector<size_t> live;
+	size_t failures = 0;
+
+	#define FAIL_(...) { spdlog::error("[{}] " __VA_ARGS__); return false; }
+
+	for(size_t i = 0; i < iterations; ++i) {
+		unsigned op = rng() % 16;
+		if(op < 8 || live.empty()) {
+			size_t count = (rng() % 8 == 0)? 1 + (rng() % 256) : 1 + (rng() % 12);
+			size_t align = (rng() % 4 == 0)? size_t(1) << (rng() % 6) : 0;
+			auto allocd = alloc.try_alloc(count, align);
+			if(allocd.pageCount == 0) { ++ failures; continue; }
+			size_t offset = allocd.base - base;
+			if(allocd.pageCount != count) FAIL_("Allocated {} pages instead of {}", name, allocd.pageCount, count)
+			if(exhaustive && align > 0 && offset % align != 0) FAIL_("Allocation at {} is not aligned to {}", name, offset, align)
+			if(! model.occupy(offset, count)) FAIL_("Allocation at {}+{} overlaps another one", name, offset, count)
+			live.push_back(allocd.base);
+		} else if(op < 15) {
+			size_t idx = rng() % live.size();
+			alloc.dealloc(live[idx]);
+			model.free(live[idx] - base);
+			live[idx] = live.back();
+			live.pop_back();
+		} else {
+			size_t idx    = rng() % live.size();
+			size_t offset = live[idx] - base;
+			size_t count  = model.allocations().at(offset);
+			size_t new_count = 1 + (rng() % (2 * count));
+			bool grows_into_free = (new_count <= count) || (
+				offset + new_count <= page_count &&
+				model.isFree(offset + count, new_count - count) );
+			if(alloc.try_resize(live[idx], new_count)) {
+				if(! grows_into_free) FAIL_("Resized allocation at {} into occupied pages", name, offset)
+				model.resize(offset, new_count);
+			} else if(new_count <= count) {
+				FAIL_("Could not shrink allocation at {}", name, offset)
+			}
+		}
+	}
+
+	// Freeing everything must restore a single sequence
+	for(auto addr : live) alloc.dealloc(addr);
+	if(exhaustive) {
+		auto whole = alloc.try_alloc(page_count);
+		if(whole.pageCount != page_count || whole.base != base) FAIL_("Free pages were not merged back together", name)
+		alloc.dealloc(whole.base);
+	}
+
+	#undef FAIL_
+
+	spdlog::info("[{}] {} operations, {} failed allocations", name, iterations, failures);
+	return true;
+}
+
+
+template <template <typename, size_t> class bucket_template>
+struct CountingPreallocator {
+	using addr_t = size_t;
+	static constexpr size_t pageSize = 16;
+
+	size_t nextBase = pageSize;
+	size_t* released = nullptr;
+
+	addr_t acquire_space(size_t page_count) { auto r = nextBase; nextBase += page_count * pageSize; return r; }
+	void release_space(const bucket_template<addr_t, pageSize>&) { if(released) ++ *released; }
+};
+
+
+template <template <typename, size_t> class bucket_template>
+bool stress_dyn(std::string_view name, unsigned seed) {
+	constexpr size_t pages_per_bucket = 256;
+	size_t released = 0;
+	size_t buckets  = 0;
+
+	{
+		CountingPreallocator<bucket_template> prealloc;
+		prealloc.released = &released;
+		auto alloc = DynAllocator<CountingPreallocator<bucket_template>, bucket_template>(std::move(prealloc), pages_per_bucket);
+		auto rng = std::minstd_rand(seed);
+		std::map<size_t, size_t> live;
+
+		for(size_t i = 0; i < 20'000; ++i) {
+			if(rng() % 3 != 0 || live.empty()) {
+				size_t count = 1 + (rng() % 32);
+				size_t addr = alloc.alloc(count);
+				size_t end  = addr + (count * 16);
+				auto next = live.lower_bound(addr);
+				if(next != live.end() && next->first < end) { spdlog::error("[{}] Overlapping allocations", name); return false; }
+				if(next != live.begin() && std::prev(next)->second > addr) { spdlog::error("[{}] Overlapping allocations", name); return false; }
+				live[addr] = end;
+			} else {
+				auto victim = live.begin();
+				std::advance(victim, rng() % live.size());
+				alloc.dealloc(victim->first);
+				live.erase(victim);
+			}
+		}
+		buckets = (alloc.preallocator().nextBase - 16) / (pages_per_bucket * 16);
+	}
+
+	if(released != buckets) {
+		spdlog::error("[{}] {} buckets were acquired, but {} were released", name, buckets, released);
+		return false;
+	}
+	spdlog::info("[{}] {} buckets", name, buckets);
+	return true;
+}
+
+
+int main(int argn, char** argv) {
+	unsigned seed = (argn > 1)? unsigned(std::strtoul(argv[1], nullptr, 10)) : 42;
+	spdlog::set_pattern("[%^%l%$] %v");
+
+	bool ok = true;
+	ok = stress<StaticAllocator>("static", seed, false) && ok;
+	ok = stress<TlsfAllocator>  ("tlsf",   seed, true) && ok;
+	ok = stress_dyn<StaticAllocator>("dynamic static", seed) && ok;
+	ok = stress_dyn<TlsfAllocator>  ("dynamic tlsf",   seed) && ok;
+	return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+// Logs bursts of debug messages from a simulated frame loop, to a file
+// stream that is flushed after every message, and measures how long every
+// logging call blocks the caller: with the stream as the sink, and with an
+// AsyncSink wrapping it under every overflow policy.
+
+#include <sflog_async.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+using sflog::Level;
+using sflog::OptionBit;
+using sflog::OverflowPolicy;
+
+constexpr size_t frameCount       = 200;
+constexpr size_t messagesPerFrame = 50;
+constexpr auto   frameInterval    = std::chrono::milliseconds(2);
+constexpr size_t ringCapacity     = 1 << 14;
+
+
+
+struct Result {
+	std::vector<double> latenciesNs;
+	uint64_t dropped;
+};
+
+
+template <typename Logger>
+void logFrames(Logger& logger, std::vector<double>& latencies) {
+	using clock = std::chrono::steady_clock;
+	using namespace std::string_view_literals;
+	auto objectName = std::string("ObjectStorage::objects[17]");
+	latencies.reserve(frameCount * messagesPerFrame);
+	for(size_t f = 0; f < frameCount; ++f) {
+		for(size_t m = 0; m < messagesPerFrame; ++m) {
+			auto beg = clock::now();
+			logger.debug("Frame {} draw batch {}: {} at ({:.3f}, {:.3f}), {} instances", f, m, objectName, float(m) * 0.5f, float(f) * 0.25f, m * 3);
+			auto end = clock::now();
+			latencies.push_back(std::chrono::duration<double, std::nano>(end - beg).count());
+		}
+		std::this_thread::sleep_for(frameInterval);
+	}
+}
+
+
+Result runSync(const char* path) {
+	using namespace std::string_view_literals;
+	auto file   = std::ofstream(path);
+	auto logger = sflog::Logger<std::ofstream*>(&file, Level::eDebug, OptionBit::eAutoFlush, "["sv, "Bench "sv, ""sv, "]  "sv);
+	Result r = { };
+	logFrames(logger, r.latenciesNs);
+	return r;
+}
+
+
+Result runAsync(const char* path, OverflowPolicy policy) {
+	using namespace std::string_view_literals;
+	using Sink = sflog::AsyncSink<std::ofstream>;
+	auto sink   = std::make_shared<Sink>(policy, ringCapacity, path);
+	auto logger = sflog::Logger<std::shared_ptr<Sink>>(sink, Level::eDebug, OptionBit::eAutoFlush, "["sv, "Bench "sv, ""sv, "]  "sv);
+	Result r = { };
+	logFrames(logger, r.latenciesNs);
+	logger.flush();
+	r.dropped = sink->droppedCount();
+	return r;
+}
+
+
+int main(int argn, char** argv) {
+	const char* path = argn > 1? argv[1] : "sflog-async-bench.log";
+	auto out = std::ofstream("/dev/stdout");
+	sflog::formatTo(out, "{} frames of {} messages, {}ms apart, to \"{}\"\n", frameCount, messagesPerFrame, frameInterval.count(), path);
+	sflog::formatTo(out, "{:>22} | {:>9} | {:>9} | {:>9} | {:>9} | {:>9}\n", "sink", "p50 ns", "p99 ns", "p99.9 ns", "max ns", "dropped");
+	auto print = [&](const char* name, Result r) {
+		auto& l = r.latenciesNs;
+		std::sort(l.begin(), l.end());
+		auto percentile = [&](double p) { return l[std::min(l.size() - 1, size_t(double(l.size()) * p / 100.0))]; };
+		sflog::formatTo(out, "{:>22} | {:>9.0f} | {:>9.0f} | {:>9.0f} | {:>9.0f} | {:>9}\n", name,
+			percentile(50), percentile(99), percentile(99.9), l.back(), r.dropped);
+	};
+	print("sync",                  runSync(path));
+	print("async, block",          runAsync(path, OverflowPolicy::eBlock));
+	print("async, drop newest",    runAsync(path, OverflowPolicy::eDropNewest));
+	print("async, drop counted",   runAsync(path, OverflowPolicy::eDropCounted));
+}
@@ -8,6 +8,7 @@
 #include <iterator>
 #include <concepts>
 #include <ranges>
+#include <tuple>
 
 #ifdef SFLOG_ENABLE_POSIXFIO
 	#ifdef SFLOG_NO_POSIXFIO
@@ -171,6 +172,23 @@ namespace sflog {
 	template <typename T>
 	concept SinkPtrType = requires(T t) { requires SinkType<decltype(*t)>; };
 
+	/// The four segments of a logger's prefix: before the level's color,
+	/// before the level, after the level and after the level's color.
+	using PrefixSegments = std::tuple<std::string_view, std::string_view, std::string_view, std::string_view>;
+
+	/// Sinks that take whole messages, rather than formatted text; the logger
+	/// leaves the prefix, the level and the options to them.
+	template <typename T>
+	concept MessageSinkType = SinkType<T> && requires(T t, const PrefixSegments& pfx, Options opt) {
+		t.template logMessage<Level::eInfo>(pfx, opt, "format_string {}", 1);
+	};
+
+
+	// Defined in sflog_async.hpp; `Logger::flush` needs to see the overload for it.
+	template <typename Sink> requires SinkType<Sink> class AsyncSink;
+	template <typename Sink> void flush(AsyncSink<Sink>&);
+
+
 	template <typename T, typename U>
 	concept StringLike =
 		std::ranges::sized_range<T> &&
@@ -294,7 +312,9 @@ namespace sflog {
 			// debugging is always marginally slower, but perfectly up-to-code
 			// release builds shouldn't print debugging logs to begin with.
 			#define LOG_ \
-				if(usingOption(OptionBit::eUseAnsiSgr)) \
+				if constexpr (MessageSinkType<std::remove_reference_t<decltype(*l_sink)>>) \
+				/**/ l_sink->template logMessage<level, Args...>(getPrefixSegments(), l_opt, fmtStr, std::forward<Args>(args)...); \
+				else if(usingOption(OptionBit::eUseAnsiSgr)) \
 				/**/ l_logFormatted<level, Args...>(fmtStr, std::forward<Args>(args)...); \
 				else l_logRaw      <level, Args...>(fmtStr, std::forward<Args>(args)...);
 			if      constexpr (level <= Level::eDebug   )  { if(level >= l_level) [[unlikely]] { LOG_ }; }
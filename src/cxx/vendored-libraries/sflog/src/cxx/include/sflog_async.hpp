@@ -0,0 +1,475 @@
+#pragma once
+
+#include "sflog.hpp"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace sflog {
+
+	using overflow_policy_e = unsigned;
+	enum class OverflowPolicy : overflow_policy_e {
+		eBlock,       // Wait for the background thread to make room
+		eDropNewest,  // Discard the message that does not fit
+		eDropCounted  // Discard the message that does not fit, and report how many were discarded
+	};
+
+
+	namespace async_impl {
+
+		constexpr size_t recordAlign   = alignof(std::max_align_t);
+		constexpr size_t cacheLineSize = 64;
+
+		constexpr size_t alignUp(size_t v, size_t a) noexcept { return (v + (a - 1)) & ~ (a - 1); }
+
+
+		/// Arguments are formatted after the call that logs them returns:
+		/// strings are copied next to the record and captured as views of the copy,
+		/// everything else is captured by value.
+		template <typename T>
+		constexpr bool isCapturedString = std::is_convertible_v<const T&, std::string_view>;
+
+		template <typename T>
+		using Captured = std::conditional_t<isCapturedString<std::decay_t<T>>, std::string_view, std::decay_t<T>>;
+
+		template <typename T>
+		size_t capturedStringBytes(const T& v) noexcept {
+			if constexpr (isCapturedString<T>) return std::string_view(v).size();
+			else return 0;
+		}
+
+		template <typename T>
+		Captured<T> capture(T&& v, char*& strings) noexcept(std::is_nothrow_constructible_v<Captured<T>, T&&>) {
+			if constexpr (isCapturedString<std::decay_t<T>>) {
+				auto view = std::string_view(v);
+				memcpy(strings, view.data(), view.size());
+				auto r = std::string_view(strings, view.size());
+				strings += view.size();
+				return r;
+			} else {
+				return Captured<T>(std::forward<T>(v));
+			}
+		}
+
+
+		struct RecordHeader;
+		using FormatRecordFn = void (*)(RecordHeader&, fmt::memory_buffer&) noexcept;
+
+		/// Records are laid out as [ header | arguments | strings | prefix ],
+		/// each of them a multiple of `recordAlign` bytes long.
+		/// A header whose size is 0 marks the end of the usable ring space,
+		/// and tells the reader to continue from its beginning.
+		///
+		struct RecordHeader {
+			uint32_t       size;
+			uint32_t       argsOffset;
+			uint32_t       prefixOffset;
+			uint16_t       prefixSizes[4];
+			bool           isMessage;
+			bool           useAnsiSgr;
+			bool           autoFlush;
+			FormatRecordFn format;
+			const char*    fmtData;
+			size_t         fmtSize;
+
+			std::byte* bytes() noexcept { return reinterpret_cast<std::byte*>(this); }
+		};
+
+		constexpr size_t headerBytes = alignUp(sizeof(RecordHeader), recordAlign);
+
+
+		/// A single-producer single-consumer ring of variable-size records.
+		///
+		class Ring {
+		public:
+			Ring(size_t capacity):
+				r_storage(std::make_unique<std::max_align_t[]>(capacity / sizeof(std::max_align_t))),
+				r_capacity(capacity)
+			{
+				assert(capacity == (size_t(1) << std::countr_zero(capacity)));
+				assert(capacity >= 2 * headerBytes);
+			}
+
+			/// \brief Returns space for a record of `bytes` bytes, or nullptr if it does not fit.
+			///
+			/// Producer only; the record is visible to the consumer after `commit`.
+			///
+			std::byte* reserve(size_t bytes) noexcept {
+				uint64_t head = r_head.load(std::memory_order_relaxed);
+				size_t   offset     = head & (r_capacity - 1);
+				size_t   contiguous = r_capacity - offset;
+				size_t   needed     = bytes <= contiguous? bytes : contiguous + bytes;
+				if(needed > r_capacity - (head - r_tailCache)) {
+					r_tailCache = r_tail.load(std::memory_order_acquire);
+					if(needed > r_capacity - (head - r_tailCache)) return nullptr;
+				}
+				if(bytes > contiguous) {
+					constexpr uint32_t wrapMarker = 0;
+					memcpy(data() + offset, &wrapMarker, sizeof(wrapMarker));
+					r_pendingHead = head + contiguous;
+					return data();
+				}
+				r_pendingHead = head;
+				return data() + offset;
+			}
+
+			void commit(size_t bytes) noexcept {
+				r_head.store(r_pendingHead + bytes, std::memory_order_release);
+			}
+
+			/// \brief Visits every committed record, then releases their space.
+			///
+			/// Consumer only.
+			///
+			template <typename Fn>
+			bool consume(Fn&& fn) {
+				uint64_t tail = r_tail.load(std::memory_order_relaxed);
+				uint64_t head = r_head.load(std::memory_order_acquire);
+				if(tail == head) return false;
+				while(tail != head) {
+					size_t   offset = tail & (r_capacity - 1);
+					uint32_t size;
+					memcpy(&size, data() + offset, sizeof(size));
+					if(size == 0) { tail += r_capacity - offset; continue; }
+					fn(header(offset));
+					tail += size;
+					r_tail.store(tail, std::memory_order_release);
+				}
+				r_tail.store(tail, std::memory_order_release);
+				return true;
+			}
+
+			size_t capacity() const noexcept { return r_capacity; }
+
+		private:
+			std::byte*    data() noexcept { return reinterpret_cast<std::byte*>(r_storage.get()); }
+			RecordHeader& header(size_t offset) noexcept { return *std::launder(reinterpret_cast<RecordHeader*>(data() + offset)); }
+
+			std::unique_ptr<std::max_align_t[]> r_storage;
+			size_t r_capacity;
+			alignas(cacheLineSize) std::atomic_uint64_t r_head = 0;
+			uint64_t r_pendingHead = 0;
+			uint64_t r_tailCache   = 0; // The consumer's position, as last seen by the producer
+			alignas(cacheLineSize) std::atomic_uint64_t r_tail = 0;
+		};
+
+
+		/// Formats a message, or the output of `format` if `pfx` is null.
+		///
+		template <Level level, typename... Args>
+		void formatMessage(fmt::memory_buffer& out, const std::string_view* pfx, bool useAnsiSgr, fmt::string_view fmtStr, Args&... args) noexcept {
+			auto ins = std::back_inserter(out);
+			try {
+				if(pfx != nullptr) {
+					if(useAnsiSgr) fmt::format_to(ins, "{}{}{}{}{}{}{}", pfx[0], levelAnsiSgrView<level>, pfx[1], levelStr<level>, pfx[2], ansiResetSgrView, pfx[3]);
+					else           fmt::format_to(ins, "{}{}{}", pfx[0], levelStr<level>, pfx[3]);
+				}
+				fmt::vformat_to(ins, fmtStr, fmt::make_format_args(args...));
+			} catch(...) {
+				fmt::format_to(ins, "(failed to format \"{}\")", std::string_view(fmtStr.data(), fmtStr.size()));
+			}
+			if(pfx != nullptr) out.push_back('\n');
+		}
+
+
+		template <Level level, typename Tuple>
+		void formatRecord(RecordHeader& h, fmt::memory_buffer& out) noexcept {
+			auto* bytes = h.bytes();
+			auto& args  = *std::launder(reinterpret_cast<Tuple*>(bytes + h.argsOffset));
+			std::string_view pfx[4];
+			if(h.isMessage) {
+				const char* p = reinterpret_cast<const char*>(bytes + h.prefixOffset);
+				for(unsigned i = 0; i < 4; ++i) { pfx[i] = std::string_view(p, h.prefixSizes[i]); p += h.prefixSizes[i]; }
+			}
+			std::apply([&](auto&... a) { formatMessage<level>(out, h.isMessage? pfx : nullptr, h.useAnsiSgr, fmt::string_view(h.fmtData, h.fmtSize), a...); }, args);
+			args.~Tuple();
+		}
+
+
+		inline std::atomic_uint64_t nextSinkId = 1;
+
+	}
+
+
+	/// \brief A sink that formats and writes messages on a background thread.
+	///
+	/// Every thread that logs to the sink gets its own ring buffer, where the
+	/// format string and the arguments of its messages are captured; the
+	/// background thread drains the rings, formats the messages and writes
+	/// them to the wrapped sink.
+	/// Messages of one thread keep their order, messages of different
+	/// threads may not.
+	///
+	/// Arguments are formatted after the logging call returns: strings are
+	/// copied, everything else is captured by value, so arguments that
+	/// refer to other objects (e.g. `fmt::join`) must outlive the sink.
+	/// Format strings are captured by reference, and must be literals.
+	///
+	/// Critical messages block until they are written and flushed, regardless
+	/// of the overflow policy; so does `flush`, and so does destroying the sink.
+	/// Messages that take more than half of a ring are never captured: they are
+	/// formatted and written on the calling thread when they are critical or the
+	/// policy is OverflowPolicy::eBlock, and dropped otherwise.
+	/// With OptionBit::eAutoFlush, the wrapped sink is flushed after every batch
+	/// of messages, instead of after every message.
+	///
+	template <typename Sink>
+	requires SinkType<Sink>
+	class AsyncSink {
+	public:
+		static constexpr size_t defaultRingCapacity = 1 << 16;
+
+		template <typename... SinkArgs>
+		AsyncSink(OverflowPolicy policy, size_t ringCapacity, SinkArgs&&... sinkArgs):
+			as_sink(std::forward<SinkArgs>(sinkArgs)...),
+			as_id(async_impl::nextSinkId.fetch_add(1, std::memory_order_relaxed)),
+			as_ringCapacity(ringCapacity),
+			as_policy(policy)
+		{
+			as_thread = std::thread([this]() { as_run(); });
+		}
+
+		AsyncSink(const AsyncSink&) = delete;
+		AsyncSink(AsyncSink&&)      = delete;
+
+		~AsyncSink() {
+			as_stopping.store(true, std::memory_order_seq_cst);
+			as_wake();
+			as_thread.join();
+		}
+
+
+		template <Level level, typename... Args>
+		void logMessage(const PrefixSegments& pfx, Options opt, fmt::format_string<Args...> fmtStr, Args&&... args) {
+			bool pushed = as_push<level, Args...>(&pfx, opt, fmtStr, std::forward<Args>(args)...);
+			if constexpr (level == Level::eCritical) flush();
+			else (void) pushed;
+		}
+
+		template <typename... Args>
+		void format(fmt::format_string<Args...> fmtStr, Args&&... args) {
+			as_push<Level::eInfo, Args...>(nullptr, Options(OptionBit::eNone), fmtStr, std::forward<Args>(args)...);
+		}
+
+		/// \brief Waits until every message logged so far is written, then flushes the wrapped sink.
+		///
+		void flush() {
+			uint64_t ticket = as_flushRequested.fetch_add(1, std::memory_order_seq_cst) + 1;
+			as_wake();
+			uint64_t done = as_flushDone.load(std::memory_order_acquire);
+			while(done < ticket) {
+				as_flushDone.wait(done, std::memory_order_acquire);
+				done = as_flushDone.load(std::memory_order_acquire);
+			}
+		}
+
+		/// The wrapped sink, which is written to by the background thread
+		/// (and by the threads that log oversized messages).
+		///
+		const Sink& sink() const noexcept { return as_sink; }
+
+		OverflowPolicy overflowPolicy() const noexcept { return as_policy; }
+		uint64_t droppedCount() const noexcept { return as_droppedTotal.load(std::memory_order_relaxed); }
+
+	private:
+		using Ring = async_impl::Ring;
+
+		template <Level level, typename... Args>
+		bool as_push(const PrefixSegments* pfx, Options opt, fmt::format_string<Args...> fmtStr, Args&&... args) {
+			using namespace async_impl;
+			using Tuple = std::tuple<Captured<Args>...>;
+			static_assert(alignof(Tuple) <= recordAlign);
+
+			size_t stringBytes = (size_t(0) + ... + capturedStringBytes(args));
+			size_t prefixBytes = 0;
+			if(pfx != nullptr) std::apply([&](auto&... seg) { prefixBytes = (size_t(0) + ... + seg.size()); }, *pfx);
+			size_t argsOffset   = headerBytes;
+			size_t stringOffset = argsOffset   + alignUp(sizeof(Tuple), recordAlign);
+			size_t prefixOffset = stringOffset + stringBytes;
+			size_t bytes        = alignUp(prefixOffset + prefixBytes, recordAlign);
+
+			auto& ring = as_threadRing();
+			if(bytes > ring.capacity() / 2) [[unlikely]] {
+				if(as_policy == OverflowPolicy::eBlock || level == Level::eCritical) {
+					as_writeSync<level, Args...>(pfx, opt, fmtStr, args...);
+					return true;
+				}
+				as_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+				if(as_policy == OverflowPolicy::eDropCounted) as_droppedUnreported.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			std::byte* dst = ring.reserve(bytes);
+			if(dst == nullptr) [[unlikely]] {
+				if(as_policy == OverflowPolicy::eBlock || level == Level::eCritical) {
+					while(dst == nullptr) {
+						as_wake();
+						std::this_thread::yield();
+						dst = ring.reserve(bytes);
+					}
+				} else {
+					as_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+					if(as_policy == OverflowPolicy::eDropCounted) as_droppedUnreported.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+
+			auto* h = new (dst) RecordHeader { };
+			h->size         = uint32_t(bytes);
+			h->argsOffset   = uint32_t(argsOffset);
+			h->prefixOffset = uint32_t(prefixOffset);
+			h->isMessage    = pfx != nullptr;
+			h->useAnsiSgr   = opt & OptionBit::eUseAnsiSgr;
+			h->autoFlush    = opt & OptionBit::eAutoFlush;
+			h->format       = &formatRecord<level, Tuple>;
+			h->fmtData      = fmt::string_view(fmtStr).data();
+			h->fmtSize      = fmt::string_view(fmtStr).size();
+
+			char* strings = reinterpret_cast<char*>(dst + stringOffset);
+			new (dst + argsOffset) Tuple(capture(std::forward<Args>(args), strings)...);
+
+			if(pfx != nullptr) {
+				char* p = reinterpret_cast<char*>(dst + prefixOffset);
+				unsigned i = 0;
+				std::apply([&](auto&... seg) { ((
+					h->prefixSizes[i ++] = uint16_t(seg.size()),
+					memcpy(p, seg.data(), seg.size()),
+					p += seg.size() ), ...); }, *pfx);
+			}
+
+			ring.commit(bytes);
+			as_wake();
+			return true;
+		}
+
+
+		template <Level level, typename... Args>
+		void as_writeSync(const PrefixSegments* pfx, Options opt, fmt::format_string<Args...> fmtStr, Args&... args) {
+			fmt::memory_buffer out;
+			std::string_view pfxViews[4];
+			if(pfx != nullptr) std::apply([&](auto&... seg) { unsigned i = 0; ((pfxViews[i ++] = seg), ...); }, *pfx);
+			async_impl::formatMessage<level>(out, pfx != nullptr? pfxViews : nullptr, opt & OptionBit::eUseAnsiSgr, fmtStr, args...);
+
+			flush(); // The messages that were captured before this one are written first
+			auto lock = std::unique_lock(as_sinkMutex);
+			formatTo(as_sink, "{}", std::string_view(out.data(), out.size()));
+			if(opt & OptionBit::eAutoFlush) sflog::flush(as_sink);
+		}
+
+
+		Ring& as_threadRing() {
+			// (sink ID, ring) pairs; IDs are never reused, so entries of destroyed sinks never match
+			thread_local std::vector<std::pair<uint64_t, Ring*>> rings;
+			for(auto& r : rings) if(r.first == as_id) [[likely]] return *r.second;
+			Ring* ring;
+			{
+				auto lock = std::unique_lock(as_ringsMutex);
+				as_rings.push_back(std::make_unique<Ring>(as_ringCapacity));
+				ring = as_rings.back().get();
+				as_ringCount.store(as_rings.size(), std::memory_order_release);
+			}
+			rings.push_back({ as_id, ring });
+			return *ring;
+		}
+
+
+		void as_wake() noexcept {
+			as_seq.fetch_add(1, std::memory_order_seq_cst);
+			if(as_consumerIdle.load(std::memory_order_seq_cst)) as_seq.notify_one();
+		}
+
+
+		void as_run() {
+			std::vector<Ring*> rings;
+			fmt::memory_buffer out;
+			bool autoFlush = false;
+			while(true) {
+				uint32_t seq      = as_seq.load(std::memory_order_seq_cst);
+				uint64_t flushReq = as_flushRequested.load(std::memory_order_seq_cst);
+				bool     stopping = as_stopping.load(std::memory_order_seq_cst);
+
+				if(rings.size() != as_ringCount.load(std::memory_order_acquire)) {
+					auto lock = std::unique_lock(as_ringsMutex);
+					rings.clear();
+					for(auto& ring : as_rings) rings.push_back(ring.get());
+				}
+
+				bool consumed = false;
+				for(auto* ring : rings) {
+					consumed = ring->consume([&](async_impl::RecordHeader& h) {
+						h.format(h, out);
+						autoFlush = autoFlush || h.autoFlush;
+					}) || consumed;
+					if(out.size() > 0) {
+						auto lock = std::unique_lock(as_sinkMutex);
+						formatTo(as_sink, "{}", std::string_view(out.data(), out.size()));
+						out.clear();
+					}
+				}
+				if(uint64_t dropped = as_droppedUnreported.exchange(0, std::memory_order_relaxed); dropped > 0) {
+					auto lock = std::unique_lock(as_sinkMutex);
+					formatTo(as_sink, "({} log message{} dropped)\n", dropped, dropped == 1? " was" : "s were");
+				}
+
+				if(flushReq > as_flushDone.load(std::memory_order_relaxed) || stopping || (autoFlush && ! consumed)) {
+					{ auto lock = std::unique_lock(as_sinkMutex); sflog::flush(as_sink); }
+					autoFlush = false;
+					as_flushDone.store(flushReq, std::memory_order_release);
+					as_flushDone.notify_all();
+				}
+
+				if(stopping) break;
+				if(! consumed) {
+					as_consumerIdle.store(true, std::memory_order_seq_cst);
+					as_seq.wait(seq, std::memory_order_seq_cst);
+					as_consumerIdle.store(false, std::memory_order_seq_cst);
+				}
+			}
+		}
+
+
+		Sink as_sink;
+		std::thread as_thread;
+		std::mutex  as_sinkMutex; // Only contended by messages that are written on the calling thread
+		std::mutex  as_ringsMutex;
+		std::vector<std::unique_ptr<Ring>> as_rings;
+		std::atomic_size_t   as_ringCount = 0;
+		std::atomic_uint32_t as_seq = 0;
+		std::atomic_bool     as_consumerIdle = false;
+		std::atomic_bool     as_stopping = false;
+		std::atomic_uint64_t as_flushRequested = 0;
+		std::atomic_uint64_t as_flushDone = 0;
+		std::atomic_uint64_t as_droppedTotal = 0;
+		std::atomic_uint64_t as_droppedUnreported = 0;
+		uint64_t       as_id;
+		size_t         as_ringCapacity;
+		OverflowPolicy as_policy;
+	};
+
+
+	template <typename Sink, typename... Args>
+	void formatTo(AsyncSink<Sink>& sink, fmt::format_string<Args...> fmtStr, Args&&... args) {
+		sink.format(fmtStr, std::forward<Args>(args)...);
+	}
+
+	template <typename Sink>
+	void flush(AsyncSink<Sink>& sink) { sink.flush(); }
+
+}
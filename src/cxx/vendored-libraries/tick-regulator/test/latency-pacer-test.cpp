@@ -0,0 +1,173 @@
+#include <tick-regulator.hpp>
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+
+
+using Seconds = std::chrono::duration<tickreg::delta_t, std::chrono::seconds::period>;
+
+
+// A clock that only moves when told to, so that the pacer can be tested deterministically
+struct SimulatedClock {
+	tickreg::TimePoint now = tickreg::TimePoint(std::chrono::seconds(1));
+
+	void advance(tickreg::delta_t s) { now += std::chrono::duration_cast<tickreg::Duration>(Seconds(s)); }
+	void advanceTo(tickreg::TimePoint tp) { if(tp > now) now = tp; }
+};
+
+
+// A FIFO presentation engine with a single image in flight, whose vsync slots are fixed in time
+struct SimulatedDisplay {
+	tickreg::delta_t   interval;
+	tickreg::TimePoint origin;
+
+	tickreg::TimePoint nextVsync(tickreg::TimePoint after) const {
+		auto since = std::chrono::duration_cast<Seconds>(after - origin).count();
+		auto slot  = std::ceil(since / interval);
+		return origin + std::chrono::duration_cast<tickreg::Duration>(Seconds(slot * interval));
+	}
+};
+
+
+struct SimulationResult {
+	tickreg::delta_t avgLatency;
+	tickreg::delta_t maxLatency;
+	tickreg::delta_t estInterval;
+	unsigned missedSlots;
+};
+
+
+SimulationResult simulate(
+		bool             use_pacer,
+		tickreg::delta_t display_interval,
+		tickreg::delta_t cpu_time,
+		tickreg::delta_t gpu_time,
+		unsigned         frame_count
+) {
+	constexpr unsigned warmup_frames = 32;
+	constexpr auto     jitter        = tickreg::delta_t(0.001);
+
+	auto clock   = SimulatedClock();
+	auto display = SimulatedDisplay { display_interval, clock.now + std::chrono::microseconds(3100) };
+	auto rng     = std::minstd_rand(0x5eed);
+	auto dist    = std::uniform_real_distribution<tickreg::delta_t>(0.0, jitter);
+	auto params  = tickreg::LatencyPacerParams { .safetyMargin = 0.001, .maxDelayFactor = 1.0, .estimateInterval = true };
+	auto pacer   = tickreg::LatencyPacer(8, 1.0 / 72.0 /* Deliberately wrong */, params);
+
+	auto r = SimulationResult { };
+	auto last_present = clock.now;
+	unsigned measured = 0;
+
+	for(unsigned i = 0; i < frame_count; ++i) {
+		if(use_pacer) clock.advanceTo(pacer.nextBegin(clock.now));
+		auto begin = clock.now;
+
+		auto frame_cpu = cpu_time + dist(rng);
+		auto frame_gpu = gpu_time + dist(rng);
+		clock.advance(frame_cpu);
+		clock.advance(frame_gpu);
+		auto present = display.nextVsync(clock.now);
+		clock.advanceTo(present); // The frame is waited upon, as with `vkWaitForPresentKHR`
+
+		pacer.reportFrame(frame_cpu, frame_gpu);
+		pacer.reportPresent(present);
+
+		if(i >= warmup_frames) {
+			auto latency  = std::chrono::duration_cast<Seconds>(present - begin).count();
+			auto interval = std::chrono::duration_cast<Seconds>(present - last_present).count();
+			r.avgLatency += latency;
+			r.maxLatency  = std::max(r.maxLatency, latency);
+			if(interval > display_interval * 1.5) ++ r.missedSlots;
+			++ measured;
+		}
+		last_present = present;
+	}
+
+	r.avgLatency /= tickreg::delta_t(measured);
+	r.estInterval = pacer.estPresentInterval();
+	return r;
+}
+
+
+bool testLatencyReduction() {
+	constexpr auto interval = tickreg::delta_t(1.0 / 60.0);
+	auto paced   = simulate(true,  interval, 0.003, 0.005, 600);
+	auto unpaced = simulate(false, interval, 0.003, 0.005, 600);
+	bool fail = false;
+
+	spdlog::info("Unpaced: latency avg {:.3f}ms max {:.3f}ms, {} missed slots", unpaced.avgLatency * 1000.0, unpaced.maxLatency * 1000.0, unpaced.missedSlots);
+	spdlog::info("Paced:   latency avg {:.3f}ms max {:.3f}ms, {} missed slots", paced.avgLatency   * 1000.0, paced.maxLatency   * 1000.0, paced.missedSlots);
+
+	if(paced.missedSlots > 0) {
+		spdlog::error("The pacer caused {} presentation slots to be missed", paced.missedSlots);
+		fail = true;
+	}
+	if(paced.avgLatency > unpaced.avgLatency * 0.8) {
+		spdlog::error("The pacer did not reduce the average latency enough");
+		fail = true;
+	}
+	if(paced.maxLatency > interval * 1.01) {
+		spdlog::error("The paced latency exceeded one presentation interval");
+		fail = true;
+	}
+	if(std::abs(paced.estInterval - interval) > interval * 0.01) {
+		spdlog::error("The estimated present interval ({:.3f}ms) did not converge to {:.3f}ms", paced.estInterval * 1000.0, interval * 1000.0);
+		fail = true;
+	}
+
+	return ! fail;
+}
+
+
+bool testCantKeepUp() {
+	// When a frame takes longer than an interval, the pacer must not delay anything
+	auto params = tickreg::LatencyPacerParams { .safetyMargin = 0.001, .maxDelayFactor = 1.0, .estimateInterval = true };
+	auto pacer  = tickreg::LatencyPacer(4, 1.0 / 60.0, params);
+	auto clock  = SimulatedClock();
+	for(unsigned i = 0; i < 8; ++i) {
+		pacer.reportFrame(0.012, 0.010);
+		clock.advance(1.0 / 30.0);
+		pacer.reportPresent(clock.now);
+	}
+	if(pacer.nextBegin(clock.now) != clock.now) {
+		spdlog::error("The pacer delayed a cycle that cannot keep up");
+		return false;
+	}
+	return true;
+}
+
+
+bool testMaxDelay() {
+	auto params = tickreg::LatencyPacerParams { .safetyMargin = 0.0, .maxDelayFactor = 0.25, .estimateInterval = false };
+	auto pacer  = tickreg::LatencyPacer(4, 0.02, params);
+	auto clock  = SimulatedClock();
+	for(unsigned i = 0; i < 8; ++i) {
+		pacer.reportFrame(0.001, 0.001);
+		clock.advance(0.02);
+		pacer.reportPresent(clock.now);
+	}
+	auto delay = std::chrono::duration_cast<Seconds>(pacer.nextBegin(clock.now) - clock.now).count();
+	if(delay > 0.02 * 0.25 + 1e-9) {
+		spdlog::error("The pacer delayed a cycle by {:.3f}ms, beyond the maximum", delay * 1000.0);
+		return false;
+	}
+	return true;
+}
+
+
+
+int main() {
+	spdlog::set_pattern("[%^%l%$] %v");
+
+	bool fail = false;
+	fail = testLatencyReduction() ? fail : true;
+	fail = testCantKeepUp()       ? fail : true;
+	fail = testMaxDelay()         ? fail : true;
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -3,6 +3,8 @@
 #include <utility>
 #include <thread>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 
 
@@ -238,6 +240,11 @@ namespace tickreg {
 	}
 
 
+	void Regulator::awaitUntil(TimePoint tp) {
+		m_currentStrategyFn(tp, m_avgMetrics.burst, 0.0);
+	}
+
+
 	void Regulator::endCycle() {
 		Timer::endCycle();
 
@@ -256,4 +263,90 @@ namespace tickreg {
 		}
 	}
 
+
+
+	LatencyPacer::LatencyPacer(unsigned lookback_size, delta_t default_interval, const LatencyPacerParams& params):
+			m_lookbackSize(lookback_size),
+			m_params(params),
+			m_avgInterval(default_interval),
+			m_lastPresent(),
+			m_presentCount(0),
+			m_currentFrameLine(0),
+			m_currentPresentLine(0)
+	{
+		assert(m_lookbackSize > 1);
+		assert(default_interval > 0.0);
+		assert(m_params.safetyMargin >= 0.0);
+		assert(m_params.maxDelayFactor >= 0.0 && m_params.maxDelayFactor <= 1.0);
+		m_lookback = std::make_unique<LookbackLine[]>(m_lookbackSize);
+		resetEstimates(default_interval);
+	}
+
+
+	void LatencyPacer::reportPresent(TimePoint tp) {
+		using Seconds = std::chrono::duration<delta_t, std::chrono::seconds::period>;
+
+		if(m_params.estimateInterval && (m_presentCount > 0)) [[likely]] {
+			auto& ln = m_lookback[m_currentPresentLine % m_lookbackSize];
+			auto interval = std::chrono::duration_cast<Seconds>(tp - m_lastPresent).count();
+
+			// A late frame skips one or more presentation slots: only the slot size is relevant
+			auto slots = std::max<delta_t>(delta_t(1.0), std::round(interval / m_avgInterval));
+			interval /= slots;
+
+			m_avgInterval = impl::reaverage(ln.delta, interval, m_avgInterval, m_lookbackSize);
+			ln.delta = interval;
+			++ m_currentPresentLine;
+		}
+
+		m_lastPresent = tp;
+		++ m_presentCount;
+	}
+
+
+	void LatencyPacer::reportFrame(delta_t cpu_time, delta_t gpu_time) {
+		auto& ln = m_lookback[m_currentFrameLine % m_lookbackSize];
+		ln.burst = cpu_time + gpu_time;
+		++ m_currentFrameLine;
+	}
+
+
+	void LatencyPacer::resetEstimates(delta_t default_interval) noexcept {
+		m_avgInterval  = default_interval;
+		m_presentCount = 0;
+		for(unsigned i = 0; i < m_lookbackSize; ++i) {
+			auto& ln = m_lookback[i];
+			ln.burst = default_interval; // Pessimistic, so that no cycle is delayed until there is data
+			ln.delta = default_interval;
+		}
+	}
+
+
+	delta_t LatencyPacer::estLatency() const noexcept {
+		// The worst latency in the lookback window is used, since missing a presentation costs a whole interval
+		delta_t r = 0.0;
+		for(unsigned i = 0; i < m_lookbackSize; ++i) r = std::max(r, m_lookback[i].burst);
+		return r + m_params.safetyMargin;
+	}
+
+
+	TimePoint LatencyPacer::nextBegin(TimePoint now) const noexcept {
+		using Seconds = std::chrono::duration<delta_t, std::chrono::seconds::period>;
+		using std::chrono::duration_cast;
+
+		if(m_presentCount == 0) [[unlikely]] return now;
+
+		auto latency  = estLatency();
+		auto interval = m_avgInterval;
+		auto max_delay = interval * m_params.maxDelayFactor;
+		if(latency >= interval) return now; // Can't keep up, pacing would only make things worse
+
+		// Find the first presentation slot that can still be met, then work backwards from it
+		auto since_last  = duration_cast<Seconds>(now - m_lastPresent).count();
+		auto next_slot   = std::max<delta_t>(delta_t(1.0), std::ceil((since_last + latency) / interval));
+		auto begin_delay = ((next_slot * interval) - latency) - since_last;
+		begin_delay = std::clamp<delta_t>(begin_delay, 0.0, max_delay);
+		return now + duration_cast<Duration>(Seconds(begin_delay));
+	}
+
 }
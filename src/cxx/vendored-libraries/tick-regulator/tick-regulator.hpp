@@ -169,6 +169,11 @@ namespace tickreg {
 
 		void awaitNextTick();
 
+		/** Waits until the given time point, using the current strategy;
+		* used when the next tick is scheduled externally, as with
+		* a `LatencyPacer`. */
+		void awaitUntil(TimePoint);
+
 		void endCycle();
 
 	private:
@@ -178,4 +183,80 @@ namespace tickreg {
 		delta_t                         m_desiredDelta;
 	};
 
+
+	struct LatencyPacerParams {
+		/** A number within the interval [0, +inf);
+		* the time, in seconds, that is added to the estimated
+		* frame latency to absorb the variance of the measures. */
+		delta_t safetyMargin;
+
+		/** A number within the interval [0, 1];
+		* how much the next cycle can be delayed, in proportion to
+		* the present interval, regardless of the estimated latency.
+		*
+		* A value of 0 disables pacing altogether, a value of 1
+		* allows the pacer to delay a cycle by a whole interval. */
+		delta_t maxDelayFactor;
+
+		/** Whether the present interval is estimated from the reported
+		* presentation time points;
+		* if false, the default interval is used as-is, and presentation
+		* time points only determine the phase of the next cycle.
+		*
+		* This should be false when the presentation time points are
+		* approximated, for instance with the completion time of a frame. */
+		bool estimateInterval;
+	};
+
+
+	/** Schedules cycles so that they begin as late as possible,
+	* while still finishing in time for the next presentation.
+	*
+	* The pacer does not measure time by itself, it is fed with
+	* the time points at which frames are presented and with the
+	* CPU and GPU times spent on each frame: this allows it to be
+	* driven by any clock, including simulated ones.
+	*
+	* |  cpu time  | gpu time |  margin  |
+	* |____________|__________|__________|
+	* ^ nextBegin()                      ^ expected presentation */
+	class LatencyPacer {
+	public:
+		LatencyPacer() = default;
+		LatencyPacer(unsigned lookback_size, delta_t default_interval, const LatencyPacerParams&);
+		LatencyPacer(LatencyPacer&&) = default;
+
+		LatencyPacer& operator=(LatencyPacer&&) = default;
+
+		/** Reports the time point at which a frame has been presented,
+		* or the best known approximation of it. */
+		void reportPresent(TimePoint);
+
+		/** Reports the time spent by the CPU to prepare and submit
+		* a frame, and the time between its submission and its completion. */
+		void reportFrame(delta_t cpu_time, delta_t gpu_time);
+
+		void resetEstimates(delta_t default_interval) noexcept;
+
+		delta_t   estPresentInterval() const noexcept { return m_avgInterval; }
+		delta_t   estLatency()         const noexcept;
+		TimePoint lastPresent()        const noexcept { return m_lastPresent; }
+		bool      hasPresented()       const noexcept { return m_presentCount > 0; }
+		const auto& params()           const noexcept { return m_params; }
+
+		/** Returns the time point at which the next cycle should begin,
+		* which is never earlier than `now`. */
+		TimePoint nextBegin(TimePoint now) const noexcept;
+
+	private:
+		std::unique_ptr<LookbackLine[]> m_lookback; // burst: CPU + GPU time, delta: present interval
+		unsigned                        m_lookbackSize;
+		LatencyPacerParams              m_params;
+		delta_t                         m_avgInterval;
+		TimePoint                       m_lastPresent;
+		uint_fast64_t                   m_presentCount;
+		uint_fast32_t                   m_currentFrameLine;
+		uint_fast32_t                   m_currentPresentLine;
+	};
+
 }
@@ -129,6 +129,7 @@ namespace vkutil {
 		features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
 		features13.synchronization2 = true;
 		features13.maintenance4 = true;
+		features13.pNext = info.pFeatureChain;
 		VkDeviceCreateInfo dInfo = { };
 		dInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		dInfo.pNext = &features13;
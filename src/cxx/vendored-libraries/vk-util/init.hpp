@@ -85,6 +85,7 @@ namespace vkutil {
 		std::vector<const char*>          extensions;
 		const VkPhysicalDeviceProperties* pPhysDevProps;
 		const VkPhysicalDeviceFeatures*   pRequiredFeatures;
+		void*                             pFeatureChain; // Appended to the `VkDeviceCreateInfo::pNext` chain, may be `nullptr`
 	};
 
 	struct CreateDeviceDst {
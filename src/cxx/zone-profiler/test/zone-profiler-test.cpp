@@ -0,0 +1,164 @@
+#include <zone-profiler/zone_profiler.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <thread>
+
+
+
+namespace zp = SKENGINE_NAME_NS;
+
+constexpr const char* trace_path = "zone-profiler-test-trace.json";
+
+
+
+std::string read_file(const char* path) {
+	std::ifstream in(path);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+
+size_t count_occurrences(const std::string& str, std::string_view what) {
+	size_t r = 0;
+	for(auto pos = str.find(what); pos != std::string::npos; pos = str.find(what, pos + what.size())) ++ r;
+	return r;
+}
+
+
+// Not a full JSON parser, but catches unbalanced brackets, unterminated strings and stray commas
+bool looks_like_json_array(const std::string& str) {
+	std::vector<char> stack;
+	bool in_string = false;
+	bool escaped   = false;
+	char last_significant = '\0';
+	for(char c : str) {
+		if(in_string) {
+			if(escaped) escaped = false;
+			else if(c == '\\') escaped = true;
+			else if(c == '"') in_string = false;
+			continue;
+		}
+		switch(c) {
+			case ' ': case '\n': case '\t': case '\r': continue;
+			case '"': in_string = true; break;
+			case '[': case '{': stack.push_back(c); break;
+			case ']': if(stack.empty() || stack.back() != '[' || last_significant == ',') return false; stack.pop_back(); break;
+			case '}': if(stack.empty() || stack.back() != '{' || last_significant == ',') return false; stack.pop_back(); break;
+			default: break;
+		}
+		last_significant = c;
+	}
+	return stack.empty() && ! in_string && str.find_first_not_of(" \n") == str.find('[');
+}
+
+
+void nested_work(unsigned depth) {
+	SKENGINE_ZONE("nested_work");
+	if(depth > 0) nested_work(depth - 1);
+}
+
+
+bool testTraceFormat() {
+	constexpr unsigned zones_per_thread = 100;
+	constexpr unsigned nesting = 3;
+	bool fail = false;
+
+	{
+		auto writer = zp::TraceWriter(trace_path, std::chrono::milliseconds(5));
+		if(! writer.isOpen()) { std::fprintf(stderr, "Failed to open %s\n", trace_path); return false; }
+
+		auto worker = [&](const char* name) {
+			SKENGINE_ZONE_THREAD_NAME(name);
+			for(unsigned i = 0; i < zones_per_thread; ++i) nested_work(nesting - 1);
+		};
+		auto t0 = std::thread(worker, "Worker \"A\"");
+		auto t1 = std::thread(worker, "Worker B");
+		t0.join();
+		t1.join();
+		writer.close();
+	}
+
+	auto trace = read_file(trace_path);
+	auto zones = count_occurrences(trace, R"("ph":"X")");
+	auto names = count_occurrences(trace, R"("name":"thread_name")");
+	auto expect_zones = 2 * zones_per_thread * nesting;
+
+	if(! looks_like_json_array(trace)) { std::fprintf(stderr, "The trace is not a well formed JSON array\n"); fail = true; }
+	if(zones != expect_zones) { std::fprintf(stderr, "The trace has %zu zones instead of %u\n", zones, expect_zones); fail = true; }
+	if(names != 2) { std::fprintf(stderr, "The trace has %zu thread names instead of 2\n", names); fail = true; }
+	if(trace.find(R"(Worker \"A\")") == std::string::npos) { std::fprintf(stderr, "A thread name was not escaped\n"); fail = true; }
+	for(auto key : { R"("ts":)", R"("dur":)", R"("tid":)", R"("pid":)" }) {
+		if(count_occurrences(trace, key) < zones) { std::fprintf(stderr, "Some zones lack the %s key\n", key); fail = true; }
+	}
+
+	std::printf("Trace format: %zu zones, %s\n", zones, fail? "FAIL" : "ok");
+	return ! fail;
+}
+
+
+bool testOverhead() {
+	constexpr unsigned batch = 8192; // Fits in a thread buffer, so that nothing is dropped
+	constexpr unsigned batches = 64;
+	constexpr unsigned attempts = 4;
+	[[maybe_unused]] constexpr double budget_ns = 50.0;
+	auto writer = zp::TraceWriter("/dev/null", std::chrono::milliseconds(1000));
+	auto dropped_before = zp::droppedZoneCount();
+	bool fail = false;
+
+	// The budget is checked against the fastest batch, which other processes are the
+	// least likely to have preempted; a busy machine gets a few more attempts, while
+	// an actual regression fails all of them. Unoptimized builds only report the overhead.
+	double best_ns = 0.0;
+	for(unsigned attempt = 0; attempt < attempts; ++attempt) {
+		auto total = zp::zone_time_t(0);
+		auto best  = ~ zp::zone_time_t(0);
+		for(unsigned b = 0; b < batches; ++b) {
+			auto begin = zp::zoneNow();
+			for(unsigned i = 0; i < batch; ++i) { SKENGINE_ZONE("overhead"); }
+			auto elapsed = zp::zoneNow() - begin;
+			total += elapsed;
+			best = std::min(best, elapsed);
+			writer.flush();
+		}
+		double tick_ns = zp::zoneTickPeriodNs();
+		double ns      = double(total) * tick_ns / double(batch * batches);
+		best_ns        = double(best)  * tick_ns / double(batch);
+		std::printf("Overhead: %.1fns per zone (%.1fns at best)\n", ns, best_ns);
+		#ifdef __OPTIMIZE__
+			if(best_ns < budget_ns) break;
+		#else
+			break;
+		#endif
+	}
+
+	auto dropped = zp::droppedZoneCount() - dropped_before;
+	if(dropped > 0) {
+		std::fprintf(stderr, "%llu zones were dropped\n", (unsigned long long) dropped);
+		fail = true;
+	}
+	#ifdef __OPTIMIZE__
+		if(best_ns >= budget_ns) {
+			std::fprintf(stderr, "The zone overhead exceeds the budget of %.0fns\n", budget_ns);
+			fail = true;
+		}
+	#endif
+	return ! fail;
+}
+
+
+
+int main() {
+	bool fail = false;
+
+	fail = testTraceFormat() ? fail : true;
+	fail = testOverhead()    ? fail : true;
+
+	return fail? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+#include "zone_profiler.hpp"
+
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <bit>
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace zprof {
+
+	namespace {
+
+		constexpr uint64_t buffer_capacity = uint64_t(1) << 14; // Events per thread, must be a power of 2
+		static_assert(std::has_single_bit(buffer_capacity));
+
+		// Trace timestamps are relative to the start of the process, to keep them short;
+		// the epoch is also the reference point for calibrating the tick period
+		const zone_time_t trace_epoch = zoneNow();
+		const auto trace_epoch_clock = ZoneClock::now();
+
+
+		struct ThreadBuffer {
+			std::unique_ptr<ZoneEvent[]> events;
+			std::atomic<uint64_t> head; // Only written by the owning thread
+			std::atomic<uint64_t> tail; // Only written by the TraceWriter
+			std::atomic<uint64_t> dropped;
+			std::mutex  nameMutex;
+			std::string name;
+			bool        nameDirty;
+			uint32_t    tid;
+		};
+
+
+		struct Registry {
+			std::mutex mutex;
+			std::vector<std::shared_ptr<ThreadBuffer>> buffers; // Buffers outlive their threads, so that their last events can be flushed
+			uint32_t nextTid = 1;
+		};
+
+
+		Registry& registry() {
+			static Registry r;
+			return r;
+		}
+
+
+		std::shared_ptr<ThreadBuffer> register_thread() {
+			auto& reg = registry();
+			auto  buf = std::make_shared<ThreadBuffer>();
+			buf->events = std::make_unique_for_overwrite<ZoneEvent[]>(buffer_capacity);
+			buf->head.store(0, std::memory_order_relaxed);
+			buf->tail.store(0, std::memory_order_relaxed);
+			buf->dropped.store(0, std::memory_order_relaxed);
+			buf->nameDirty = false;
+			auto lock = std::unique_lock(reg.mutex);
+			buf->tid = reg.nextTid ++;
+			reg.buffers.push_back(buf);
+			return buf;
+		}
+
+
+		// The registry owns the buffer, so a plain pointer avoids the guard of a non-trivial thread_local
+		constinit thread_local ThreadBuffer* tl_buffer = nullptr;
+
+		ThreadBuffer& thread_buffer() {
+			if(tl_buffer == nullptr) [[unlikely]] tl_buffer = register_thread().get();
+			return *tl_buffer;
+		}
+
+
+		void write_escaped(std::FILE* file, std::string_view str) {
+			for(char c : str) {
+				if(c == '"' || c == '\\') { std::fputc('\\', file); std::fputc(c, file); }
+				else if(uint8_t(c) < 0x20) std::fprintf(file, "\\u%04x", unsigned(uint8_t(c)));
+				else std::fputc(c, file);
+			}
+		}
+
+
+		double to_trace_us(zone_time_t t, double tick_ns) {
+			return double(int64_t(t - trace_epoch)) * tick_ns / 1000.0;
+		}
+
+	}
+
+
+	double zoneTickPeriodNs() noexcept {
+		#ifdef SKENGINE_ZONE_USE_TSC_
+			auto ticks = zoneNow() - trace_epoch;
+			auto ns    = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(ZoneClock::now() - trace_epoch_clock).count();
+			return (ticks > 0)? (ns / double(ticks)) : 1.0;
+		#else
+			return 1.0;
+		#endif
+	}
+
+
+	void recordZone(const char* name, zone_time_t begin, zone_time_t end) noexcept {
+		auto& buf = thread_buffer();
+		auto head = buf.head.load(std::memory_order_relaxed);
+		auto tail = buf.tail.load(std::memory_order_acquire);
+		if(head - tail >= buffer_capacity) [[unlikely]] {
+			buf.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		buf.events[head & (buffer_capacity - 1)] = ZoneEvent { name, begin, end };
+		buf.head.store(head + 1, std::memory_order_release);
+	}
+
+
+	void setThreadName(std::string name) {
+		auto& buf = thread_buffer();
+		auto lock = std::unique_lock(buf.nameMutex);
+		buf.name = std::move(name);
+		buf.nameDirty = true;
+	}
+
+
+	uint64_t droppedZoneCount() noexcept {
+		auto& reg = registry();
+		auto lock = std::unique_lock(reg.mutex);
+		uint64_t r = 0;
+		for(auto& buf : reg.buffers) r += buf->dropped.load(std::memory_order_relaxed);
+		return r;
+	}
+
+
+	TraceWriter::TraceWriter(const char* path, std::chrono::milliseconds flush_interval):
+		tw_file(std::fopen(path, "w")),
+		tw_firstEvent(true),
+		tw_stop(false)
+	{
+		if(tw_file == nullptr) return;
+		std::fputs("[", tw_file);
+
+		tw_flushThread = std::thread([this, flush_interval]() {
+			auto lock = std::unique_lock(tw_mutex);
+			while(! tw_stop) {
+				tw_stopCond.wait_for(lock, flush_interval);
+				flush_locked();
+			}
+		});
+	}
+
+
+	TraceWriter::~TraceWriter() {
+		close();
+	}
+
+
+	void TraceWriter::flush() {
+		auto lock = std::unique_lock(tw_mutex);
+		flush_locked();
+	}
+
+
+	void TraceWriter::close() {
+		{
+			auto lock = std::unique_lock(tw_mutex);
+			if(tw_file == nullptr) return;
+			tw_stop = true;
+		}
+		tw_stopCond.notify_all();
+		if(tw_flushThread.joinable()) tw_flushThread.join();
+
+		auto lock = std::unique_lock(tw_mutex);
+		flush_locked();
+		std::fputs("\n]\n", tw_file);
+		std::fclose(tw_file);
+		tw_file = nullptr;
+	}
+
+
+	void TraceWriter::flush_locked() {
+		if(tw_file == nullptr) return;
+
+		auto separator = [&]() {
+			std::fputs(tw_firstEvent? "\n" : ",\n", tw_file);
+			tw_firstEvent = false;
+		};
+
+		double tick_ns = zoneTickPeriodNs();
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			auto& reg = registry();
+			auto lock = std::unique_lock(reg.mutex);
+			buffers = reg.buffers;
+		}
+
+		for(auto& buf : buffers) {
+			{ // Thread name metadata
+				auto lock = std::unique_lock(buf->nameMutex);
+				if(buf->nameDirty) {
+					separator();
+					std::fprintf(tw_file, R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":")", unsigned(buf->tid));
+					write_escaped(tw_file, buf->name);
+					std::fputs("\"}}", tw_file);
+					buf->nameDirty = false;
+				}
+			}
+
+			auto head = buf->head.load(std::memory_order_acquire);
+			auto tail = buf->tail.load(std::memory_order_relaxed);
+			for(auto i = tail; i != head; ++i) {
+				auto& ev = buf->events[i & (buffer_capacity - 1)];
+				separator();
+				std::fputs(R"({"name":")", tw_file);
+				write_escaped(tw_file, ev.name);
+				std::fprintf(tw_file, R"(","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f})",
+					unsigned(buf->tid),
+					to_trace_us(ev.begin, tick_ns),
+					double(ev.end - ev.begin) * tick_ns / 1000.0 );
+			}
+			buf->tail.store(head, std::memory_order_release);
+		}
+
+		std::fflush(tw_file);
+	}
+
+}}
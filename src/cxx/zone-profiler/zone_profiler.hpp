@@ -0,0 +1,151 @@
+#pragma once
+
+#include <skengine_fwd.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define SKENGINE_ZONE_USE_TSC_
+#elif defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+	#define SKENGINE_ZONE_USE_TSC_
+#endif
+
+
+
+/// \file
+///
+/// A lightweight CPU instrumentation library.
+///
+/// Zones are recorded with the `SKENGINE_ZONE` macro, which expands to
+/// nothing unless the `SKENGINE_ZONE_PROFILING` macro is defined (see the
+/// `SKENGINE_ENABLE_ZONE_PROFILING` CMake option).
+///
+/// Each thread records its zones into its own single-producer
+/// single-consumer ring buffer, without locking; a TraceWriter drains
+/// every buffer and writes the events in the Chrome `trace_event` JSON
+/// format, which can be read by Perfetto and `chrome://tracing`.
+///
+
+
+
+namespace SKENGINE_NAME_NS {
+inline namespace zprof {
+
+	using zone_time_t = uint64_t; // Clock ticks from an arbitrary epoch, see `zoneTickPeriodNs`
+
+	using ZoneClock = std::chrono::steady_clock;
+
+
+	struct ZoneEvent {
+		const char* name; // Must have static storage duration
+		zone_time_t begin;
+		zone_time_t end;
+	};
+
+
+	/// \brief Reads the zone clock.
+	///
+	/// On x86 this is the time stamp counter, which is about twice as
+	/// cheap to read as `ZoneClock`; elsewhere it is `ZoneClock` itself.
+	///
+	inline zone_time_t zoneNow() noexcept {
+		#ifdef SKENGINE_ZONE_USE_TSC_
+			return zone_time_t(__rdtsc());
+		#else
+			return zone_time_t(std::chrono::duration_cast<std::chrono::nanoseconds>(ZoneClock::now().time_since_epoch()).count());
+		#endif
+	}
+
+	/// \brief The duration of a `zoneNow` tick in nanoseconds, measured
+	///        against `ZoneClock` since the first zone was recorded.
+	///
+	double zoneTickPeriodNs() noexcept;
+
+
+	/// \brief Records a complete zone on the calling thread's buffer.
+	///
+	/// When the buffer is full, the event is dropped and counted; this
+	/// never blocks.
+	///
+	void recordZone(const char* name, zone_time_t begin, zone_time_t end) noexcept;
+
+	/// \brief Sets the name that the calling thread is displayed with.
+	///
+	void setThreadName(std::string);
+
+	/// \brief The number of events that were dropped because a buffer was full.
+	///
+	uint64_t droppedZoneCount() noexcept;
+
+
+	class ZoneScope {
+	public:
+		explicit ZoneScope(const char* name) noexcept: zs_name(name), zs_begin(zoneNow()) { }
+		~ZoneScope() { recordZone(zs_name, zs_begin, zoneNow()); }
+
+		ZoneScope(const ZoneScope&) = delete;
+		ZoneScope& operator=(const ZoneScope&) = delete;
+
+	private:
+		const char* zs_name;
+		zone_time_t zs_begin;
+	};
+
+
+	/// \brief Drains every thread's zone buffer into a Chrome trace file.
+	///
+	/// Only one TraceWriter should exist at a time, since zone buffers
+	/// only support one consumer.
+	///
+	/// The file uses the JSON Array Format, whose closing bracket is
+	/// optional: a trace that was not closed (e.g. after a crash) can
+	/// still be loaded.
+	///
+	class TraceWriter {
+	public:
+		TraceWriter(): tw_file(nullptr), tw_firstEvent(true), tw_stop(false) { }
+		TraceWriter(const char* path, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(500));
+		TraceWriter(TraceWriter&&) = delete;
+		~TraceWriter();
+
+		/// \brief Writes every pending event to the file.
+		void flush();
+
+		/// \brief Flushes, stops the periodic flush and closes the file.
+		void close();
+
+		bool isOpen() const noexcept { return tw_file != nullptr; }
+
+	private:
+		std::mutex tw_mutex;
+		std::condition_variable tw_stopCond;
+		std::thread tw_flushThread;
+		std::FILE* tw_file;
+		bool tw_firstEvent;
+		bool tw_stop;
+
+		void flush_locked();
+	};
+
+}}
+
+
+
+#define SKENGINE_ZONE_CAT2_(A_, B_) A_##B_
+#define SKENGINE_ZONE_CAT_(A_, B_) SKENGINE_ZONE_CAT2_(A_, B_)
+
+#ifdef SKENGINE_ZONE_PROFILING
+	#define SKENGINE_ZONE(NAME_) ::SKENGINE_NAME_NS::ZoneScope SKENGINE_ZONE_CAT_(skengine_zone_, __LINE__) (NAME_)
+	#define SKENGINE_ZONE_THREAD_NAME(NAME_) ::SKENGINE_NAME_NS::setThreadName(NAME_)
+#else
+	#define SKENGINE_ZONE(NAME_) ((void) 0)
+	#define SKENGINE_ZONE_THREAD_NAME(NAME_) ((void) 0)
+#endif
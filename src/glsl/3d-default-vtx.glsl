@@ -22,7 +22,11 @@ layout(set = 0, binding = 0) uniform FrameUbo {
 
 
 
-layout(location = 0) in vec3  in_pos;
+// Compact vertices (see `fmamdl::CompactVertex`) have a normalized position,
+// with the bi-tangent sign as W, and octahedral normals and tangents
+layout(constant_id = 0) const bool COMPACT_VERTICES = false;
+
+layout(location = 0) in vec4  in_pos;
 layout(location = 1) in vec2  in_tex;
 layout(location = 2) in vec3  in_nrm;
 layout(location = 3) in vec3  in_tanu;
@@ -46,7 +50,11 @@ struct Object {
 	float rnd;
 	uint  draw_batch_idx;
 	bool  visible;
-	uint  unused1;
+	uint  lod_count;
+	vec4  vtx_dequant_offset;
+	vec4  vtx_dequant_scale;
+	vec4  lod_errors;
+	uint  cluster_slot;
 };
 
 layout(std140, set = 2, binding = 0) readonly buffer ObjectBuffer {
@@ -55,9 +63,33 @@ layout(std140, set = 2, binding = 0) readonly buffer ObjectBuffer {
 
 
 
+vec3 oct_decode(vec2 e) {
+	vec3  v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.x += (v.x >= 0.0)? -t : +t;
+	v.y += (v.y >= 0.0)? -t : +t;
+	return normalize(v);
+}
+
+
+
 void main() {
 	Object obj = obj_buffer.a[in_obj_idx];
-	vec4 worldspace_pos = obj.model_transf * vec4(in_pos, 1.0);
+
+	vec3 pos, nrm, tanu, tanv;
+	if(COMPACT_VERTICES) {
+		pos  = obj.vtx_dequant_offset.xyz + (obj.vtx_dequant_scale.xyz * in_pos.xyz);
+		nrm  = oct_decode(in_nrm.xy);
+		tanu = oct_decode(in_tanu.xy);
+		tanv = cross(nrm, tanu) * (1.0 - (2.0 * in_pos.w));
+	} else {
+		pos  = in_pos.xyz;
+		nrm  = in_nrm;
+		tanu = in_tanu;
+		tanv = in_tanv;
+	}
+
+	vec4 worldspace_pos = obj.model_transf * vec4(pos, 1.0);
 	vec4 viewspace_pos  = frame_ubo.view_transf4 * worldspace_pos;
 
 	gl_Position = frame_ubo.proj_transf4 * viewspace_pos;
@@ -71,9 +103,9 @@ void main() {
 	mat3 obj_transf3 = mat3(obj.model_transf);
 	frg_view3        = view3;
 
-	vec3 worldspace_tanu = normalize(obj_transf3 * -in_tanu);
-	vec3 worldspace_tanv = normalize(obj_transf3 * -in_tanv);
-	vec3 worldspace_tanw = normalize(obj_transf3 * +in_nrm);
+	vec3 worldspace_tanu = normalize(obj_transf3 * -tanu);
+	vec3 worldspace_tanv = normalize(obj_transf3 * -tanv);
+	vec3 worldspace_tanw = normalize(obj_transf3 * +nrm);
 
 	{ // Gram-Schmidt process
 		vec3 viewspace_u   = view3 * worldspace_tanu;
@@ -84,5 +116,5 @@ void main() {
 		frg_viewspace_tanw = viewspace_w;
 	}
 
-	frg_nrm = normalize(view3 * obj_transf3 * in_nrm);
+	frg_nrm = normalize(view3 * obj_transf3 * nrm);
 }